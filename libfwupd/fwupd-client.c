@@ -6,6 +6,11 @@
 
 #include "config.h"
 
+/* for memfd_create() and the file seals */
+#ifdef HAVE_MEMFD_CREATE
+#define _GNU_SOURCE
+#endif
+
 #include <glib-object.h>
 #include <gio/gio.h>
 #ifdef HAVE_GIO_UNIX
@@ -16,6 +21,12 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#ifdef HAVE_MEMFD_CREATE
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif
 
 #include "fwupd-client.h"
 #include "fwupd-common.h"
@@ -31,7 +42,8 @@
  * SECTION:fwupd-client
  * @short_description: a way of interfacing with the daemon
  *
- * An object that allows client code to call the daemon methods synchronously.
+ * An object that allows client code to call the daemon methods synchronously
+ * or asynchronously.
  *
  * See also: #FwupdDevice
  */
@@ -49,6 +61,8 @@ typedef struct {
 	gchar				*host_security_id;
 	GDBusConnection			*conn;
 	GDBusProxy			*proxy;
+	GHashTable			*devices_cache;	/* device-id:FwupdDevice */
+	guint64				 devices_generation;
 } FwupdClientPrivate;
 
 enum {
@@ -258,6 +272,52 @@ fwupd_client_signal_cb (GDBusProxy *proxy,
 	g_debug ("Unknown signal name '%s' from %s", signal_name, sender_name);
 }
 
+static void
+fwupd_client_set_proxy (FwupdClient *client, GDBusProxy *proxy)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GVariant) val = NULL;
+	g_autoptr(GVariant) val2 = NULL;
+
+	if (priv->conn == NULL)
+		priv->conn = g_object_ref (g_dbus_proxy_get_connection (proxy));
+	priv->proxy = g_object_ref (proxy);
+	g_signal_connect (priv->proxy, "g-properties-changed",
+			  G_CALLBACK (fwupd_client_properties_changed_cb), client);
+	g_signal_connect (priv->proxy, "g-signal",
+			  G_CALLBACK (fwupd_client_signal_cb), client);
+	val = g_dbus_proxy_get_cached_property (priv->proxy, "DaemonVersion");
+	if (val != NULL)
+		fwupd_client_set_daemon_version (client, g_variant_get_string (val, NULL));
+	val2 = g_dbus_proxy_get_cached_property (priv->proxy, "Tainted");
+	if (val2 != NULL)
+		priv->tainted = g_variant_get_boolean (val2);
+	val2 = g_dbus_proxy_get_cached_property (priv->proxy, "Interactive");
+	if (val2 != NULL)
+		priv->interactive = g_variant_get_boolean (val2);
+	val = g_dbus_proxy_get_cached_property (priv->proxy, "HostProduct");
+	if (val != NULL)
+		fwupd_client_set_host_product (client, g_variant_get_string (val, NULL));
+	val = g_dbus_proxy_get_cached_property (priv->proxy, "HostMachineId");
+	if (val != NULL)
+		fwupd_client_set_host_machine_id (client, g_variant_get_string (val, NULL));
+	val = g_dbus_proxy_get_cached_property (priv->proxy, "HostSecurityId");
+	if (val != NULL)
+		fwupd_client_set_host_security_id (client, g_variant_get_string (val, NULL));
+}
+
+/* a private socket avoids copying large replies and signals through the bus */
+static gchar *
+fwupd_client_get_socket_address (void)
+{
+	const gchar *path = g_getenv ("FWUPD_DBUS_SOCKET");
+	g_autofree gchar *path_escaped = NULL;
+	if (path == NULL || path[0] == '\0')
+		return NULL;
+	path_escaped = g_dbus_address_escape_value (path);
+	return g_strdup_printf ("unix:path=%s", path_escaped);
+}
+
 /**
  * fwupd_client_connect:
  * @client: A #FwupdClient
@@ -268,6 +328,9 @@ fwupd_client_signal_cb (GDBusProxy *proxy,
  * for you, and do you only need to call this if you are just watching
  * the client.
  *
+ * If `FWUPD_DBUS_SOCKET` is set in the environment then the client connects
+ * directly to the daemon at that path rather than using the system bus.
+ *
  * Returns: %TRUE for success
  *
  * Since: 0.7.1
@@ -276,8 +339,9 @@ gboolean
 fwupd_client_connect (FwupdClient *client, GCancellable *cancellable, GError **error)
 {
 	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(GVariant) val = NULL;
-	g_autoptr(GVariant) val2 = NULL;
+	g_autofree gchar *address = NULL;
+	g_autoptr(GDBusConnection) conn = NULL;
+	g_autoptr(GDBusProxy) proxy = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
@@ -288,45 +352,174 @@ fwupd_client_connect (FwupdClient *client, GCancellable *cancellable, GError **e
 		return TRUE;
 
 	/* connect to the daemon */
-	priv->conn = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, error);
-	if (priv->conn == NULL) {
-		g_prefix_error (error, "Failed to connect to system D-Bus: ");
+	address = fwupd_client_get_socket_address ();
+	if (address != NULL) {
+		conn = g_dbus_connection_new_for_address_sync (address,
+							       G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+							       NULL,
+							       cancellable,
+							       error);
+		if (conn == NULL) {
+			g_prefix_error (error, "Failed to connect to %s: ", address);
+			return FALSE;
+		}
+	} else {
+		conn = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, error);
+		if (conn == NULL) {
+			g_prefix_error (error, "Failed to connect to system D-Bus: ");
+			return FALSE;
+		}
+	}
+	proxy = g_dbus_proxy_new_sync (conn,
+				       G_DBUS_PROXY_FLAGS_NONE,
+				       NULL,
+				       address != NULL ? NULL : FWUPD_DBUS_SERVICE,
+				       FWUPD_DBUS_PATH,
+				       FWUPD_DBUS_INTERFACE,
+				       NULL,
+				       error);
+	if (proxy == NULL)
 		return FALSE;
+	fwupd_client_set_proxy (client, proxy);
+	return TRUE;
+}
+
+static void
+fwupd_client_connect_proxy_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	FwupdClient *client = g_task_get_source_object (task);
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GDBusProxy) proxy = NULL;
+	GError *error = NULL;
+
+	proxy = g_dbus_proxy_new_finish (res, &error);
+	if (proxy == NULL) {
+		g_task_return_error (task, error);
+		return;
 	}
-	priv->proxy = g_dbus_proxy_new_sync (priv->conn,
-					     G_DBUS_PROXY_FLAGS_NONE,
-					     NULL,
-					     FWUPD_DBUS_SERVICE,
-					     FWUPD_DBUS_PATH,
-					     FWUPD_DBUS_INTERFACE,
-					     NULL,
-					     error);
+
+	/* another request may have connected while this one was pending */
 	if (priv->proxy == NULL)
-		return FALSE;
-	g_signal_connect (priv->proxy, "g-properties-changed",
-			  G_CALLBACK (fwupd_client_properties_changed_cb), client);
-	g_signal_connect (priv->proxy, "g-signal",
-			  G_CALLBACK (fwupd_client_signal_cb), client);
-	val = g_dbus_proxy_get_cached_property (priv->proxy, "DaemonVersion");
-	if (val != NULL)
-		fwupd_client_set_daemon_version (client, g_variant_get_string (val, NULL));
-	val2 = g_dbus_proxy_get_cached_property (priv->proxy, "Tainted");
-	if (val2 != NULL)
-		priv->tainted = g_variant_get_boolean (val2);
-	val2 = g_dbus_proxy_get_cached_property (priv->proxy, "Interactive");
-	if (val2 != NULL)
-		priv->interactive = g_variant_get_boolean (val2);
-	val = g_dbus_proxy_get_cached_property (priv->proxy, "HostProduct");
-	if (val != NULL)
-		fwupd_client_set_host_product (client, g_variant_get_string (val, NULL));
-	val = g_dbus_proxy_get_cached_property (priv->proxy, "HostMachineId");
-	if (val != NULL)
-		fwupd_client_set_host_machine_id (client, g_variant_get_string (val, NULL));
-	val = g_dbus_proxy_get_cached_property (priv->proxy, "HostSecurityId");
-	if (val != NULL)
-		fwupd_client_set_host_security_id (client, g_variant_get_string (val, NULL));
+		fwupd_client_set_proxy (client, proxy);
+	g_task_return_boolean (task, TRUE);
+}
 
-	return TRUE;
+static void
+fwupd_client_connect_bus_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	g_autoptr(GDBusConnection) conn = NULL;
+	GError *error = NULL;
+
+	conn = g_bus_get_finish (res, &error);
+	if (conn == NULL) {
+		g_prefix_error (&error, "Failed to connect to system D-Bus: ");
+		g_task_return_error (task, error);
+		return;
+	}
+	g_dbus_proxy_new (conn,
+			  G_DBUS_PROXY_FLAGS_NONE,
+			  NULL,
+			  FWUPD_DBUS_SERVICE,
+			  FWUPD_DBUS_PATH,
+			  FWUPD_DBUS_INTERFACE,
+			  g_task_get_cancellable (task),
+			  fwupd_client_connect_proxy_cb,
+			  g_steal_pointer (&task));
+}
+
+static void
+fwupd_client_connect_socket_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	g_autoptr(GDBusConnection) conn = NULL;
+	GError *error = NULL;
+
+	conn = g_dbus_connection_new_for_address_finish (res, &error);
+	if (conn == NULL) {
+		g_prefix_error (&error, "Failed to connect to daemon socket: ");
+		g_task_return_error (task, error);
+		return;
+	}
+
+	/* there is no bus, so no bus name */
+	g_dbus_proxy_new (conn,
+			  G_DBUS_PROXY_FLAGS_NONE,
+			  NULL,
+			  NULL,
+			  FWUPD_DBUS_PATH,
+			  FWUPD_DBUS_INTERFACE,
+			  g_task_get_cancellable (task),
+			  fwupd_client_connect_proxy_cb,
+			  g_steal_pointer (&task));
+}
+
+/**
+ * fwupd_client_connect_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Sets up the client ready for use without blocking. All the other
+ * asynchronous methods call this for you.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_connect_async (FwupdClient *client,
+			    GCancellable *cancellable,
+			    GAsyncReadyCallback callback,
+			    gpointer user_data)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autofree gchar *address = NULL;
+	g_autoptr(GTask) task = NULL;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	/* nothing to do */
+	task = g_task_new (client, cancellable, callback, user_data);
+	if (priv->proxy != NULL) {
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+	address = fwupd_client_get_socket_address ();
+	if (address != NULL) {
+		g_dbus_connection_new_for_address (address,
+						   G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+						   NULL,
+						   cancellable,
+						   fwupd_client_connect_socket_cb,
+						   g_steal_pointer (&task));
+		return;
+	}
+	g_bus_get (G_BUS_TYPE_SYSTEM, cancellable,
+		   fwupd_client_connect_bus_cb,
+		   g_steal_pointer (&task));
+}
+
+/**
+ * fwupd_client_connect_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_connect_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fwupd_client_connect_finish (FwupdClient *client, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
 }
 
 static void
@@ -350,6 +543,11 @@ fwupd_client_fixup_dbus_error (GError *error)
 				    G_DBUS_ERROR_SERVICE_UNKNOWN)) {
 		error->domain = FWUPD_ERROR;
 		error->code = FWUPD_ERROR_NOT_SUPPORTED;
+	} else if (g_error_matches (error,
+				    G_DBUS_ERROR,
+				    G_DBUS_ERROR_UNKNOWN_METHOD)) {
+		error->domain = FWUPD_ERROR;
+		error->code = FWUPD_ERROR_NOT_SUPPORTED;
 	} else if (g_error_matches (error,
 				    G_IO_ERROR,
 				    G_IO_ERROR_DBUS_ERROR)) {
@@ -362,121 +560,1322 @@ fwupd_client_fixup_dbus_error (GError *error)
 	g_dbus_error_strip_remote_error (error);
 }
 
-/**
- * fwupd_client_get_host_security_attrs:
- * @client: A #FwupdClient
- * @cancellable: the #GCancellable, or %NULL
- * @error: the #GError, or %NULL
- *
- * Gets all the host security attributes from the daemon.
- *
- * Returns: (element-type FwupdSecurityAttr) (transfer container): attributes
- *
- * Since: 1.5.0
- **/
-GPtrArray *
-fwupd_client_get_host_security_attrs (FwupdClient *client, GCancellable *cancellable, GError **error)
-{
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(GVariant) val = NULL;
+typedef gpointer (*FwupdClientParseFunc)	(FwupdClient	*client,
+						 GVariant	*val,
+						 GError		**error);
 
-	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
-	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
-	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+typedef struct {
+	gchar			*method;
+	GVariant		*params;
+	GDBusMessage		*request;
+	gint			 timeout_msec;
+	FwupdClientParseFunc	 parse_func;
+	GDestroyNotify		 parse_destroy;
+} FwupdClientCall;
 
-	/* connect */
-	if (!fwupd_client_connect (client, cancellable, error))
-		return NULL;
+static void
+fwupd_client_call_free (FwupdClientCall *call)
+{
+	if (call->params != NULL)
+		g_variant_unref (call->params);
+	if (call->request != NULL)
+		g_object_unref (call->request);
+	g_free (call->method);
+	g_free (call);
+}
 
-	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "GetHostSecurityAttrs",
-				      NULL,
-				      G_DBUS_CALL_FLAGS_NONE,
-				      -1,
-				      cancellable,
-				      error);
-	if (val == NULL) {
-		if (error != NULL)
-			fwupd_client_fixup_dbus_error (*error);
-		return NULL;
+static void
+fwupd_client_call_return (GTask *task, GVariant *val)
+{
+	FwupdClient *client = g_task_get_source_object (task);
+	FwupdClientCall *call = g_task_get_task_data (task);
+	GError *error = NULL;
+	gpointer result;
+
+	/* nothing to parse */
+	if (call->parse_func == NULL) {
+		g_task_return_boolean (task, TRUE);
+		return;
 	}
-	return fwupd_security_attr_array_from_variant (val);
+	result = call->parse_func (client, val, &error);
+	if (result == NULL) {
+		g_task_return_error (task, error);
+		return;
+	}
+	g_task_return_pointer (task, result, call->parse_destroy);
 }
 
-/**
- * fwupd_client_get_devices:
- * @client: A #FwupdClient
- * @cancellable: the #GCancellable, or %NULL
- * @error: the #GError, or %NULL
- *
- * Gets all the devices registered with the daemon.
- *
- * Returns: (element-type FwupdDevice) (transfer container): results
- *
- * Since: 0.9.2
- **/
-GPtrArray *
-fwupd_client_get_devices (FwupdClient *client, GCancellable *cancellable, GError **error)
+static void
+fwupd_client_call_proxy_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GTask) task = G_TASK (user_data);
 	g_autoptr(GVariant) val = NULL;
+	GError *error = NULL;
 
-	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
-	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
-	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
-
-	/* connect */
-	if (!fwupd_client_connect (client, cancellable, error))
-		return NULL;
-
-	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "GetDevices",
-				      NULL,
-				      G_DBUS_CALL_FLAGS_NONE,
-				      -1,
-				      cancellable,
-				      error);
+	val = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), res, &error);
 	if (val == NULL) {
-		if (error != NULL)
-			fwupd_client_fixup_dbus_error (*error);
-		return NULL;
+		fwupd_client_fixup_dbus_error (error);
+		g_task_return_error (task, error);
+		return;
 	}
-	return fwupd_device_array_from_variant (val);
+	fwupd_client_call_return (task, val);
 }
 
-/**
- * fwupd_client_get_history:
- * @client: A #FwupdClient
- * @cancellable: the #GCancellable, or %NULL
- * @error: the #GError, or %NULL
- *
- * Gets all the history.
- *
- * Returns: (element-type FwupdDevice) (transfer container): results
- *
- * Since: 1.0.4
- **/
-GPtrArray *
-fwupd_client_get_history (FwupdClient *client, GCancellable *cancellable, GError **error)
+#ifdef HAVE_GIO_UNIX
+static void
+fwupd_client_call_message_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	g_autoptr(GDBusMessage) message = NULL;
+	GError *error = NULL;
+
+	message = g_dbus_connection_send_message_with_reply_finish (G_DBUS_CONNECTION (source),
+								    res, &error);
+	if (message == NULL || g_dbus_message_to_gerror (message, &error)) {
+		fwupd_client_fixup_dbus_error (error);
+		g_task_return_error (task, error);
+		return;
+	}
+	fwupd_client_call_return (task, g_dbus_message_get_body (message));
+}
+#endif
+
+static void
+fwupd_client_call_connect_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
+	g_autoptr(GTask) task = G_TASK (user_data);
+	FwupdClient *client = FWUPD_CLIENT (source);
 	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	g_autoptr(GVariant) val = NULL;
+	FwupdClientCall *call = g_task_get_task_data (task);
+	GCancellable *cancellable = g_task_get_cancellable (task);
+	GError *error = NULL;
 
-	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
-	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
-	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	if (!fwupd_client_connect_finish (client, res, &error)) {
+		g_task_return_error (task, error);
+		return;
+	}
 
-	/* connect */
-	if (!fwupd_client_connect (client, cancellable, error))
-		return NULL;
+	/* out of band file descriptors have to be sent as a raw message */
+#ifdef HAVE_GIO_UNIX
+	if (call->request != NULL) {
+		g_dbus_connection_send_message_with_reply (priv->conn,
+							   call->request,
+							   G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+							   call->timeout_msec,
+							   NULL,
+							   cancellable,
+							   fwupd_client_call_message_cb,
+							   g_steal_pointer (&task));
+		return;
+	}
+#endif
+	g_dbus_proxy_call (priv->proxy,
+			   call->method,
+			   call->params,
+			   G_DBUS_CALL_FLAGS_NONE,
+			   call->timeout_msec,
+			   cancellable,
+			   fwupd_client_call_proxy_cb,
+			   g_steal_pointer (&task));
+}
 
-	/* call into daemon */
-	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "GetHistory",
-				      NULL,
-				      G_DBUS_CALL_FLAGS_NONE,
+/* connects if required, calls the daemon method and then uses @parse_func to
+ * convert the reply, or returns a boolean if @parse_func is %NULL */
+static void
+fwupd_client_call_async (FwupdClient *client,
+			 const gchar *method,
+			 GVariant *params,
+			 gint timeout_msec,
+			 FwupdClientParseFunc parse_func,
+			 GDestroyNotify parse_destroy,
+			 GCancellable *cancellable,
+			 GAsyncReadyCallback callback,
+			 gpointer user_data)
+{
+	FwupdClientCall *call = g_new0 (FwupdClientCall, 1);
+	GTask *task = g_task_new (client, cancellable, callback, user_data);
+
+	call->method = g_strdup (method);
+	if (params != NULL)
+		call->params = g_variant_ref_sink (params);
+	call->timeout_msec = timeout_msec;
+	call->parse_func = parse_func;
+	call->parse_destroy = parse_destroy;
+	g_task_set_task_data (task, call, (GDestroyNotify) fwupd_client_call_free);
+	fwupd_client_connect_async (client, cancellable, fwupd_client_call_connect_cb, task);
+}
+
+#ifdef HAVE_GIO_UNIX
+static void
+fwupd_client_send_message_async (FwupdClient *client,
+				 GDBusMessage *request,
+				 gint timeout_msec,
+				 FwupdClientParseFunc parse_func,
+				 GDestroyNotify parse_destroy,
+				 GCancellable *cancellable,
+				 GAsyncReadyCallback callback,
+				 gpointer user_data)
+{
+	FwupdClientCall *call = g_new0 (FwupdClientCall, 1);
+	GTask *task = g_task_new (client, cancellable, callback, user_data);
+
+	call->request = g_object_ref (request);
+	call->timeout_msec = timeout_msec;
+	call->parse_func = parse_func;
+	call->parse_destroy = parse_destroy;
+	g_task_set_task_data (task, call, (GDestroyNotify) fwupd_client_call_free);
+	fwupd_client_connect_async (client, cancellable, fwupd_client_call_connect_cb, task);
+}
+#endif
+
+static gpointer
+fwupd_client_parse_devices (FwupdClient *client, GVariant *val, GError **error)
+{
+	return fwupd_device_array_from_variant (val);
+}
+
+static gpointer
+fwupd_client_parse_device (FwupdClient *client, GVariant *val, GError **error)
+{
+	FwupdDevice *dev = fwupd_device_from_variant (val);
+	if (dev == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "failed to parse device");
+		return NULL;
+	}
+	return dev;
+}
+
+static gpointer
+fwupd_client_parse_releases (FwupdClient *client, GVariant *val, GError **error)
+{
+	return fwupd_release_array_from_variant (val);
+}
+
+static gpointer
+fwupd_client_parse_remotes (FwupdClient *client, GVariant *val, GError **error)
+{
+	return fwupd_remote_array_from_variant (val);
+}
+
+static gpointer
+fwupd_client_parse_security_attrs (FwupdClient *client, GVariant *val, GError **error)
+{
+	return fwupd_security_attr_array_from_variant (val);
+}
+
+/* merges the devices that changed into the mirror */
+static gpointer
+fwupd_client_parse_devices_cached (FwupdClient *client, GVariant *val, GError **error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	GPtrArray *devices;
+	GHashTableIter iter;
+	gpointer value;
+	guint64 generation = 0;
+	g_autofree const gchar **removed = NULL;
+	g_autoptr(GPtrArray) devices_changed = NULL;
+
+	if (priv->devices_generation == 0)
+		g_hash_table_remove_all (priv->devices_cache);
+	g_variant_get (val, "(@aa{sv}^a&st)", NULL, &removed, &generation);
+	for (guint i = 0; removed[i] != NULL; i++)
+		g_hash_table_remove (priv->devices_cache, removed[i]);
+	devices_changed = fwupd_device_array_from_variant (val);
+	for (guint i = 0; i < devices_changed->len; i++) {
+		FwupdDevice *dev = g_ptr_array_index (devices_changed, i);
+		g_hash_table_insert (priv->devices_cache,
+				     g_strdup (fwupd_device_get_id (dev)),
+				     g_object_ref (dev));
+	}
+	priv->devices_generation = generation;
+
+	/* the parents may not have changed at the same time as the children */
+	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	g_hash_table_iter_init (&iter, priv->devices_cache);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		g_ptr_array_add (devices, g_object_ref (value));
+	fwupd_device_array_ensure_parents (devices);
+	if (devices->len == 0) {
+		g_ptr_array_unref (devices);
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOTHING_TO_DO,
+				     "No detected devices");
+		return NULL;
+	}
+	return devices;
+}
+
+static gpointer
+fwupd_client_parse_all_upgrades (FwupdClient *client, GVariant *val, GError **error)
+{
+	GHashTable *results;
+	gsize sz;
+	g_autoptr(GVariant) untuple = NULL;
+
+	results = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					 (GDestroyNotify) g_ptr_array_unref);
+	untuple = g_variant_get_child_value (val, 0);
+	sz = g_variant_n_children (untuple);
+	for (guint i = 0; i < sz; i++) {
+		const gchar *device_id = NULL;
+		GPtrArray *releases;
+		gsize sz_rels;
+		g_autoptr(GVariant) entry = g_variant_get_child_value (untuple, i);
+		g_autoptr(GVariant) rels = NULL;
+
+		g_variant_get_child (entry, 0, "&s", &device_id);
+		rels = g_variant_get_child_value (entry, 1);
+		releases = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+		sz_rels = g_variant_n_children (rels);
+		for (guint j = 0; j < sz_rels; j++) {
+			FwupdRelease *rel;
+			g_autoptr(GVariant) data = g_variant_get_child_value (rels, j);
+			rel = fwupd_release_from_variant (data);
+			if (rel == NULL)
+				continue;
+			g_ptr_array_add (releases, rel);
+		}
+		g_hash_table_insert (results, g_strdup (device_id), releases);
+	}
+	return results;
+}
+
+static gpointer
+fwupd_client_parse_statistics (FwupdClient *client, GVariant *val, GError **error)
+{
+	GHashTable *results;
+	const gchar *method_name;
+	GVariant *dict;
+	g_autoptr(GVariantIter) iter = NULL;
+
+	results = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					 (GDestroyNotify) g_variant_unref);
+	g_variant_get (val, "(a{s@a{sv}})", &iter);
+	while (g_variant_iter_next (iter, "{&s@a{sv}}", &method_name, &dict))
+		g_hash_table_insert (results, g_strdup (method_name), dict);
+	return results;
+}
+
+static gpointer
+fwupd_client_parse_verify_all (FwupdClient *client, GVariant *val, GError **error)
+{
+	GHashTable *results;
+	const gchar *device_id;
+	const gchar *message;
+	g_autoptr(GVariantIter) iter = NULL;
+
+	results = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	g_variant_get (val, "(a{ss})", &iter);
+	while (g_variant_iter_next (iter, "{&s&s}", &device_id, &message))
+		g_hash_table_insert (results, g_strdup (device_id), g_strdup (message));
+	return results;
+}
+
+static gpointer
+fwupd_client_parse_approved_firmware (FwupdClient *client, GVariant *val, GError **error)
+{
+	gchar **retval = NULL;
+	g_variant_get (val, "(^as)", &retval);
+	return retval;
+}
+
+static gpointer
+fwupd_client_parse_self_sign (FwupdClient *client, GVariant *val, GError **error)
+{
+	gchar *retval = NULL;
+	g_variant_get (val, "(s)", &retval);
+	return retval;
+}
+
+static GVariant *
+fwupd_client_build_history_filter (const gchar *device_id,
+				   FwupdUpdateState update_state,
+				   guint64 since,
+				   guint limit,
+				   guint offset)
+{
+	GVariantBuilder builder;
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	if (device_id != NULL) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "device-id", g_variant_new_string (device_id));
+	}
+	if (update_state != FWUPD_UPDATE_STATE_UNKNOWN) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "update-state", g_variant_new_uint32 (update_state));
+	}
+	if (since > 0) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "since", g_variant_new_uint64 (since));
+	}
+	if (limit > 0) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "limit", g_variant_new_uint32 (limit));
+	}
+	if (offset > 0) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "offset", g_variant_new_uint32 (offset));
+	}
+	return g_variant_new ("(a{sv})", &builder);
+}
+
+static GVariant *
+fwupd_client_build_self_sign_params (const gchar *value, FwupdSelfSignFlags flags)
+{
+	GVariantBuilder builder;
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	if (flags & FWUPD_SELF_SIGN_FLAG_ADD_TIMESTAMP) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "add-timestamp", g_variant_new_boolean (TRUE));
+	}
+	if (flags & FWUPD_SELF_SIGN_FLAG_ADD_CERT) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "add-cert", g_variant_new_boolean (TRUE));
+	}
+	return g_variant_new ("(sa{sv})", value, &builder);
+}
+
+#ifdef HAVE_GIO_UNIX
+#ifdef HAVE_MEMFD_CREATE
+/* the copy is done by the kernel, and the daemon can then map the sealed
+ * memfd rather than reading the file into memory */
+static gint
+fwupd_client_copy_to_sealed_memfd (gint fd)
+{
+	gint memfd;
+	off_t offset = 0;
+	struct stat st;
+
+	if (fstat (fd, &st) != 0 || !S_ISREG (st.st_mode) || st.st_size == 0)
+		return -1;
+	memfd = memfd_create ("fwupd-client", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (memfd < 0)
+		return -1;
+	while (offset < st.st_size) {
+		ssize_t wrote = sendfile (memfd, fd, &offset, st.st_size - offset);
+		if (wrote < 0 && errno == EINTR)
+			continue;
+		if (wrote <= 0) {
+			close (memfd);
+			return -1;
+		}
+	}
+
+	/* rewind for daemons that still read the fd */
+	if (lseek (memfd, 0, SEEK_SET) != 0 ||
+	    fcntl (memfd, F_ADD_SEALS,
+		   F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+		close (memfd);
+		return -1;
+	}
+	return memfd;
+}
+#endif
+
+static gint
+fwupd_client_open_file (const gchar *filename, GError **error)
+{
+	gint fd = open (filename, O_RDONLY);
+	if (fd < 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "failed to open %s",
+			     filename);
+		return -1;
+	}
+#ifdef HAVE_MEMFD_CREATE
+	{
+		gint memfd = fwupd_client_copy_to_sealed_memfd (fd);
+		if (memfd >= 0) {
+			close (fd);
+			return memfd;
+		}
+	}
+#endif
+	return fd;
+}
+
+static GDBusMessage *
+fwupd_client_build_install_request (const gchar *device_id,
+				    const gchar *filename,
+				    FwupdInstallFlags install_flags,
+				    GError **error)
+{
+	GVariantBuilder builder;
+	gint retval;
+	gint fd;
+	g_autoptr(GDBusMessage) request = NULL;
+	g_autoptr(GUnixFDList) fd_list = NULL;
+
+	/* open file */
+	fd = fwupd_client_open_file (filename, error);
+	if (fd < 0)
+		return NULL;
+
+	/* set options */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&builder, "{sv}",
+			       "reason", g_variant_new_string ("user-action"));
+	g_variant_builder_add (&builder, "{sv}",
+			       "filename", g_variant_new_string (filename));
+	if (install_flags & FWUPD_INSTALL_FLAG_OFFLINE) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "offline", g_variant_new_boolean (TRUE));
+	}
+	if (install_flags & FWUPD_INSTALL_FLAG_ALLOW_OLDER) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "allow-older", g_variant_new_boolean (TRUE));
+	}
+	if (install_flags & FWUPD_INSTALL_FLAG_ALLOW_REINSTALL) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "allow-reinstall", g_variant_new_boolean (TRUE));
+	}
+	if (install_flags & FWUPD_INSTALL_FLAG_FORCE) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "force", g_variant_new_boolean (TRUE));
+	}
+	if (install_flags & FWUPD_INSTALL_FLAG_NO_HISTORY) {
+		g_variant_builder_add (&builder, "{sv}",
+				       "no-history", g_variant_new_boolean (TRUE));
+	}
+
+	/* set out of band file descriptor */
+	fd_list = g_unix_fd_list_new ();
+	retval = g_unix_fd_list_append (fd_list, fd, NULL);
+	g_assert (retval != -1);
+	request = g_dbus_message_new_method_call (FWUPD_DBUS_SERVICE,
+						  FWUPD_DBUS_PATH,
+						  FWUPD_DBUS_INTERFACE,
+						  "Install");
+	g_dbus_message_set_unix_fd_list (request, fd_list);
+
+	/* g_unix_fd_list_append did a dup() already */
+	close (fd);
+	g_dbus_message_set_body (request, g_variant_new ("(sha{sv})", device_id, fd, &builder));
+	return g_steal_pointer (&request);
+}
+
+static GDBusMessage *
+fwupd_client_build_details_request (const gchar *filename, GError **error)
+{
+	gint fd;
+	gint retval;
+	g_autoptr(GDBusMessage) request = NULL;
+	g_autoptr(GUnixFDList) fd_list = NULL;
+
+	/* open file */
+	fd = fwupd_client_open_file (filename, error);
+	if (fd < 0)
+		return NULL;
+
+	/* set out of band file descriptor */
+	fd_list = g_unix_fd_list_new ();
+	retval = g_unix_fd_list_append (fd_list, fd, NULL);
+	g_assert (retval != -1);
+	request = g_dbus_message_new_method_call (FWUPD_DBUS_SERVICE,
+						  FWUPD_DBUS_PATH,
+						  FWUPD_DBUS_INTERFACE,
+						  "GetDetails");
+	g_dbus_message_set_unix_fd_list (request, fd_list);
+
+	/* g_unix_fd_list_append did a dup() already */
+	close (fd);
+	g_dbus_message_set_body (request, g_variant_new ("(h)", fd));
+	return g_steal_pointer (&request);
+}
+
+static GDBusMessage *
+fwupd_client_build_update_metadata_request (const gchar *remote_id,
+					    const gchar *metadata_fn,
+					    const gchar *signature_fn,
+					    GError **error)
+{
+	gint fd;
+	gint fd_sig;
+	g_autoptr(GDBusMessage) request = NULL;
+	g_autoptr(GUnixFDList) fd_list = NULL;
+
+	/* open file */
+	fd = open (metadata_fn, O_RDONLY);
+	if (fd < 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "failed to open %s",
+			     metadata_fn);
+		return NULL;
+	}
+	fd_sig = open (signature_fn, O_RDONLY);
+	if (fd_sig < 0) {
+		close (fd);
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "failed to open %s",
+			     signature_fn);
+		return NULL;
+	}
+
+	/* set out of band file descriptor */
+	fd_list = g_unix_fd_list_new ();
+	g_unix_fd_list_append (fd_list, fd, NULL);
+	g_unix_fd_list_append (fd_list, fd_sig, NULL);
+	request = g_dbus_message_new_method_call (FWUPD_DBUS_SERVICE,
+						  FWUPD_DBUS_PATH,
+						  FWUPD_DBUS_INTERFACE,
+						  "UpdateMetadata");
+	g_dbus_message_set_unix_fd_list (request, fd_list);
+
+	/* g_unix_fd_list_append did a dup() already */
+	close (fd);
+	close (fd_sig);
+	g_dbus_message_set_body (request, g_variant_new ("(shh)", remote_id, fd, fd_sig));
+	return g_steal_pointer (&request);
+}
+#endif
+
+static FwupdDevice *
+fwupd_client_find_device_by_id (GPtrArray *devices, const gchar *device_id, GError **error)
+{
+	for (guint i = 0; i < devices->len; i++) {
+		FwupdDevice *dev = g_ptr_array_index (devices, i);
+		if (g_strcmp0 (fwupd_device_get_id (dev), device_id) == 0)
+			return g_object_ref (dev);
+	}
+	g_set_error (error,
+		     FWUPD_ERROR,
+		     FWUPD_ERROR_NOT_FOUND,
+		     "failed to find %s", device_id);
+	return NULL;
+}
+
+static GPtrArray *
+fwupd_client_find_devices_by_guid (GPtrArray *devices_tmp, const gchar *guid, GError **error)
+{
+	g_autoptr(GPtrArray) devices = NULL;
+
+	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < devices_tmp->len; i++) {
+		FwupdDevice *dev_tmp = g_ptr_array_index (devices_tmp, i);
+		if (fwupd_device_has_guid (dev_tmp, guid))
+			g_ptr_array_add (devices, g_object_ref (dev_tmp));
+	}
+	if (devices->len == 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_FOUND,
+			     "failed to find any device providing %s", guid);
+		return NULL;
+	}
+	return g_steal_pointer (&devices);
+}
+
+static FwupdRemote *
+fwupd_client_find_remote_by_id (GPtrArray *remotes, const gchar *remote_id, GError **error)
+{
+	for (guint i = 0; i < remotes->len; i++) {
+		FwupdRemote *remote = g_ptr_array_index (remotes, i);
+		if (g_strcmp0 (remote_id, fwupd_remote_get_id (remote)) == 0)
+			return g_object_ref (remote);
+	}
+	g_set_error (error,
+		     FWUPD_ERROR,
+		     FWUPD_ERROR_NOT_FOUND,
+		     "No remote '%s' found in search paths",
+		     remote_id);
+	return NULL;
+}
+
+/**
+ * fwupd_client_get_host_security_attrs:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets all the host security attributes from the daemon.
+ *
+ * Returns: (element-type FwupdSecurityAttr) (transfer container): attributes
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_host_security_attrs (FwupdClient *client, GCancellable *cancellable, GError **error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon */
+	val = g_dbus_proxy_call_sync (priv->proxy,
+				      "GetHostSecurityAttrs",
+				      NULL,
+				      G_DBUS_CALL_FLAGS_NONE,
+				      -1,
+				      cancellable,
+				      error);
+	if (val == NULL) {
+		if (error != NULL)
+			fwupd_client_fixup_dbus_error (*error);
+		return NULL;
+	}
+	return fwupd_security_attr_array_from_variant (val);
+}
+
+/**
+ * fwupd_client_get_host_security_attrs_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets all the host security attributes from the daemon.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_host_security_attrs_async (FwupdClient *client,
+					    GCancellable *cancellable,
+					    GAsyncReadyCallback callback,
+					    gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "GetHostSecurityAttrs",
+				 NULL,
+				 -1,
+				 fwupd_client_parse_security_attrs,
+				 (GDestroyNotify) g_ptr_array_unref,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_get_host_security_attrs_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_host_security_attrs_async().
+ *
+ * Returns: (element-type FwupdSecurityAttr) (transfer container): attributes
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_host_security_attrs_finish (FwupdClient *client,
+					     GAsyncResult *res,
+					     GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * fwupd_client_get_statistics:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets how long the daemon has taken to reply to each D-Bus method. Each
+ * value is a dictionary with the keys `Count`, `InFlight`, `DurationTotal`,
+ * `DurationAuth`, `DurationMax` and `Histogram`, where durations are in µs.
+ *
+ * Returns: (transfer container) (element-type utf8 GVariant): the method
+ * name mapped to a `a{sv}` #GVariant
+ *
+ * Since: 1.5.0
+ **/
+GHashTable *
+fwupd_client_get_statistics (FwupdClient *client,
+			     GCancellable *cancellable,
+			     GError **error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon */
+	val = g_dbus_proxy_call_sync (priv->proxy,
+				      "GetStatistics",
+				      NULL,
+				      G_DBUS_CALL_FLAGS_NONE,
+				      -1,
+				      cancellable,
+				      error);
+	if (val == NULL) {
+		if (error != NULL)
+			fwupd_client_fixup_dbus_error (*error);
+		return NULL;
+	}
+	return fwupd_client_parse_statistics (client, val, error);
+}
+
+/**
+ * fwupd_client_get_statistics_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets how long the daemon has taken to reply to each D-Bus method.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_statistics_async (FwupdClient *client,
+				   GCancellable *cancellable,
+				   GAsyncReadyCallback callback,
+				   gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "GetStatistics",
+				 NULL,
+				 -1,
+				 fwupd_client_parse_statistics,
+				 (GDestroyNotify) g_hash_table_unref,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_get_statistics_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_statistics_async().
+ *
+ * Returns: (transfer container) (element-type utf8 GVariant): the method
+ * name mapped to a `a{sv}` #GVariant
+ *
+ * Since: 1.5.0
+ **/
+GHashTable *
+fwupd_client_get_statistics_finish (FwupdClient *client,
+				    GAsyncResult *res,
+				    GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * fwupd_client_get_devices:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets all the devices registered with the daemon.
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 0.9.2
+ **/
+GPtrArray *
+fwupd_client_get_devices (FwupdClient *client, GCancellable *cancellable, GError **error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon */
+	val = g_dbus_proxy_call_sync (priv->proxy,
+				      "GetDevices",
+				      NULL,
+				      G_DBUS_CALL_FLAGS_NONE,
+				      -1,
+				      cancellable,
+				      error);
+	if (val == NULL) {
+		if (error != NULL)
+			fwupd_client_fixup_dbus_error (*error);
+		return NULL;
+	}
+	return fwupd_device_array_from_variant (val);
+}
+
+/**
+ * fwupd_client_get_devices_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets all the devices registered with the daemon.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_devices_async (FwupdClient *client,
+				GCancellable *cancellable,
+				GAsyncReadyCallback callback,
+				gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "GetDevices",
+				 NULL,
+				 -1,
+				 fwupd_client_parse_devices,
+				 (GDestroyNotify) g_ptr_array_unref,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_get_devices_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_devices_async().
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_devices_finish (FwupdClient *client,
+				 GAsyncResult *res,
+				 GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * fwupd_client_get_devices_fd:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets all the devices registered with the daemon, which are written to a
+ * sealed memfd by the daemon rather than sent in the reply. The file is
+ * mapped by the client and the device descriptions are only copied when
+ * used, which is much cheaper than fwupd_client_get_devices() for very
+ * large numbers of devices.
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_devices_fd (FwupdClient *client, GCancellable *cancellable, GError **error)
+{
+#ifdef HAVE_GIO_UNIX
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	gint fd;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GMappedFile) mapped = NULL;
+	g_autoptr(GUnixFDList) fd_list = NULL;
+	g_autoptr(GVariant) snapshot = NULL;
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon */
+	val = g_dbus_proxy_call_with_unix_fd_list_sync (priv->proxy,
+							"GetDevicesFd",
+							NULL,
+							G_DBUS_CALL_FLAGS_NONE,
+							-1,
+							NULL,
+							&fd_list,
+							cancellable,
+							error);
+	if (val == NULL) {
+		if (error != NULL)
+			fwupd_client_fixup_dbus_error (*error);
+		return NULL;
+	}
+	if (fd_list == NULL || g_unix_fd_list_get_length (fd_list) != 1) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "invalid handle");
+		return NULL;
+	}
+	fd = g_unix_fd_list_get (fd_list, 0, error);
+	if (fd < 0)
+		return NULL;
+
+	/* the mapping stays valid after the fd is closed */
+	mapped = g_mapped_file_new_from_fd (fd, FALSE, error);
+	close (fd);
+	if (mapped == NULL)
+		return NULL;
+	blob = g_mapped_file_get_bytes (mapped);
+	snapshot = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE ("(aa{sv})"),
+								 blob, FALSE));
+	return fwupd_device_array_from_variant (snapshot);
+#else
+	g_set_error_literal (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "Not supported as <glib-unix.h> is unavailable");
+	return NULL;
+#endif
+}
+
+/**
+ * fwupd_client_get_devices_cached:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets all the devices registered with the daemon, only transferring the
+ * devices that have changed since the last call.
+ *
+ * The returned devices are shared between calls and should not be modified.
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_devices_cached (FwupdClient *client,
+				 GCancellable *cancellable,
+				 GError **error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon */
+	val = g_dbus_proxy_call_sync (priv->proxy,
+				      "GetDevicesSince",
+				      g_variant_new ("(t)", priv->devices_generation),
+				      G_DBUS_CALL_FLAGS_NONE,
+				      -1,
+				      cancellable,
+				      &error_local);
+	if (val == NULL) {
+		/* old daemon */
+		if (g_error_matches (error_local, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD))
+			return fwupd_client_get_devices (client, cancellable, error);
+		fwupd_client_fixup_dbus_error (error_local);
+
+		/* the daemon has forgotten some removals, so start again */
+		if (priv->devices_generation > 0 &&
+		    g_error_matches (error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND)) {
+			priv->devices_generation = 0;
+			return fwupd_client_get_devices_cached (client, cancellable, error);
+		}
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return NULL;
+	}
+
+	/* merge into the mirror */
+	return fwupd_client_parse_devices_cached (client, val, error);
+}
+
+static void
+fwupd_client_get_devices_cached_fallback_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	GError *error = NULL;
+	GPtrArray *devices = g_task_propagate_pointer (G_TASK (res), &error);
+	if (devices == NULL) {
+		g_task_return_error (task, error);
+		return;
+	}
+	g_task_return_pointer (task, devices, (GDestroyNotify) g_ptr_array_unref);
+}
+
+static void
+fwupd_client_get_devices_cached_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	FwupdClient *client = FWUPD_CLIENT (source);
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	GCancellable *cancellable = g_task_get_cancellable (task);
+	GPtrArray *devices;
+	g_autoptr(GError) error_local = NULL;
+
+	devices = g_task_propagate_pointer (G_TASK (res), &error_local);
+	if (devices != NULL) {
+		g_task_return_pointer (task, devices, (GDestroyNotify) g_ptr_array_unref);
+		return;
+	}
+
+	/* old daemon */
+	if (g_error_matches (error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
+		fwupd_client_get_devices_async (client, cancellable,
+						fwupd_client_get_devices_cached_fallback_cb,
+						g_steal_pointer (&task));
+		return;
+	}
+
+	/* the daemon has forgotten some removals, so start again */
+	if (priv->devices_generation > 0 &&
+	    g_error_matches (error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND)) {
+		priv->devices_generation = 0;
+		fwupd_client_get_devices_cached_async (client, cancellable,
+						       fwupd_client_get_devices_cached_fallback_cb,
+						       g_steal_pointer (&task));
+		return;
+	}
+	g_task_return_error (task, g_steal_pointer (&error_local));
+}
+
+/**
+ * fwupd_client_get_devices_cached_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets all the devices registered with the daemon, only transferring the
+ * devices that have changed since the last call.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_devices_cached_async (FwupdClient *client,
+				       GCancellable *cancellable,
+				       GAsyncReadyCallback callback,
+				       gpointer user_data)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (client, cancellable, callback, user_data);
+	fwupd_client_call_async (client,
+				 "GetDevicesSince",
+				 g_variant_new ("(t)", priv->devices_generation),
+				 -1,
+				 fwupd_client_parse_devices_cached,
+				 (GDestroyNotify) g_ptr_array_unref,
+				 cancellable,
+				 fwupd_client_get_devices_cached_cb,
+				 task);
+}
+
+/**
+ * fwupd_client_get_devices_cached_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_devices_cached_async().
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_devices_cached_finish (FwupdClient *client,
+					GAsyncResult *res,
+					GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * fwupd_client_get_history:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets all the history.
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 1.0.4
+ **/
+GPtrArray *
+fwupd_client_get_history (FwupdClient *client, GCancellable *cancellable, GError **error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon */
+	val = g_dbus_proxy_call_sync (priv->proxy,
+				      "GetHistory",
+				      NULL,
+				      G_DBUS_CALL_FLAGS_NONE,
+				      -1,
+				      cancellable,
+				      error);
+	if (val == NULL) {
+		if (error != NULL)
+			fwupd_client_fixup_dbus_error (*error);
+		return NULL;
+	}
+	return fwupd_device_array_from_variant (val);
+}
+
+/**
+ * fwupd_client_get_history_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets all the history.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_history_async (FwupdClient *client,
+				GCancellable *cancellable,
+				GAsyncReadyCallback callback,
+				gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "GetHistory",
+				 NULL,
+				 -1,
+				 fwupd_client_parse_devices,
+				 (GDestroyNotify) g_ptr_array_unref,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_get_history_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_history_async().
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_history_finish (FwupdClient *client,
+				 GAsyncResult *res,
+				 GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * fwupd_client_get_history_full:
+ * @client: A #FwupdClient
+ * @device_id: (nullable): the device ID, or %NULL for all devices
+ * @update_state: a #FwupdUpdateState, or %FWUPD_UPDATE_STATE_UNKNOWN for any
+ * @since: a UNIX timestamp the device was modified after, or 0
+ * @limit: the maximum number of devices to return, or 0 for no limit
+ * @offset: the number of devices to skip
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets a filtered page of the history, oldest first.
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_history_full (FwupdClient *client,
+			       const gchar *device_id,
+			       FwupdUpdateState update_state,
+			       guint64 since,
+			       guint limit,
+			       guint offset,
+			       GCancellable *cancellable,
+			       GError **error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon */
+	val = g_dbus_proxy_call_sync (priv->proxy,
+				      "GetHistoryFiltered",
+				      fwupd_client_build_history_filter (device_id,
+									 update_state,
+									 since,
+									 limit,
+									 offset),
+				      G_DBUS_CALL_FLAGS_NONE,
 				      -1,
 				      cancellable,
 				      error);
@@ -488,6 +1887,76 @@ fwupd_client_get_history (FwupdClient *client, GCancellable *cancellable, GError
 	return fwupd_device_array_from_variant (val);
 }
 
+/**
+ * fwupd_client_get_history_full_async:
+ * @client: A #FwupdClient
+ * @device_id: (nullable): the device ID, or %NULL for all devices
+ * @update_state: a #FwupdUpdateState, or %FWUPD_UPDATE_STATE_UNKNOWN for any
+ * @since: a UNIX timestamp the device was modified after, or 0
+ * @limit: the maximum number of devices to return, or 0 for no limit
+ * @offset: the number of devices to skip
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets a filtered page of the history, oldest first.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_history_full_async (FwupdClient *client,
+				     const gchar *device_id,
+				     FwupdUpdateState update_state,
+				     guint64 since,
+				     guint limit,
+				     guint offset,
+				     GCancellable *cancellable,
+				     GAsyncReadyCallback callback,
+				     gpointer user_data)
+{
+	GVariant *params;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	/* set options */
+	params = fwupd_client_build_history_filter (device_id, update_state,
+						    since, limit, offset);
+
+	fwupd_client_call_async (client,
+				 "GetHistoryFiltered",
+				 params,
+				 -1,
+				 fwupd_client_parse_devices,
+				 (GDestroyNotify) g_ptr_array_unref,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_get_history_full_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_history_full_async().
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_history_full_finish (FwupdClient *client,
+				      GAsyncResult *res,
+				      GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_get_device_by_id:
  * @client: A #FwupdClient
@@ -520,16 +1989,83 @@ fwupd_client_get_device_by_id (FwupdClient *client,
 		return NULL;
 
 	/* find the device by ID (client side) */
-	for (guint i = 0; i < devices->len; i++) {
-		FwupdDevice *dev = g_ptr_array_index (devices, i);
-		if (g_strcmp0 (fwupd_device_get_id (dev), device_id) == 0)
-			return g_object_ref (dev);
+	return fwupd_client_find_device_by_id (devices, device_id, error);
+}
+
+static void
+fwupd_client_get_device_by_id_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	const gchar *device_id = g_task_get_task_data (task);
+	FwupdDevice *dev;
+	GError *error = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	devices = fwupd_client_get_devices_finish (FWUPD_CLIENT (source), res, &error);
+	if (devices == NULL) {
+		g_task_return_error (task, error);
+		return;
 	}
-	g_set_error (error,
-		     FWUPD_ERROR,
-		     FWUPD_ERROR_NOT_FOUND,
-		     "failed to find %s", device_id);
-	return NULL;
+	dev = fwupd_client_find_device_by_id (devices, device_id, &error);
+	if (dev == NULL) {
+		g_task_return_error (task, error);
+		return;
+	}
+	g_task_return_pointer (task, dev, (GDestroyNotify) g_object_unref);
+}
+
+/**
+ * fwupd_client_get_device_by_id_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID, e.g. `usb:00:01:03:03`
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets a device by it's device ID.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_device_by_id_async (FwupdClient *client,
+				     const gchar *device_id,
+				     GCancellable *cancellable,
+				     GAsyncReadyCallback callback,
+				     gpointer user_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (client, cancellable, callback, user_data);
+	g_task_set_task_data (task, g_strdup (device_id), g_free);
+	fwupd_client_get_devices_async (client, cancellable,
+					fwupd_client_get_device_by_id_cb, task);
+}
+
+/**
+ * fwupd_client_get_device_by_id_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_device_by_id_async().
+ *
+ * Returns: (transfer full): a #FwupdDevice or %NULL
+ *
+ * Since: 1.5.0
+ **/
+FwupdDevice *
+fwupd_client_get_device_by_id_finish (FwupdClient *client,
+				      GAsyncResult *res,
+				      GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
 }
 
 /**
@@ -552,7 +2088,6 @@ fwupd_client_get_devices_by_guid (FwupdClient *client,
 				  GCancellable *cancellable,
 				  GError **error)
 {
-	g_autoptr(GPtrArray) devices = NULL;
 	g_autoptr(GPtrArray) devices_tmp = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
@@ -566,24 +2101,84 @@ fwupd_client_get_devices_by_guid (FwupdClient *client,
 		return NULL;
 
 	/* find the devices by GUID (client side) */
-	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	for (guint i = 0; i < devices_tmp->len; i++) {
-		FwupdDevice *dev_tmp = g_ptr_array_index (devices_tmp, i);
-		if (fwupd_device_has_guid (dev_tmp, guid))
-			g_ptr_array_add (devices, g_object_ref (dev_tmp));
-	}
+	return fwupd_client_find_devices_by_guid (devices_tmp, guid, error);
+}
 
-	/* nothing */
-	if (devices->len == 0) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_NOT_FOUND,
-			     "failed to find any device providing %s", guid);
-		return NULL;
+static void
+fwupd_client_get_devices_by_guid_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	const gchar *guid = g_task_get_task_data (task);
+	GPtrArray *devices;
+	GError *error = NULL;
+	g_autoptr(GPtrArray) devices_tmp = NULL;
+
+	devices_tmp = fwupd_client_get_devices_finish (FWUPD_CLIENT (source), res, &error);
+	if (devices_tmp == NULL) {
+		g_task_return_error (task, error);
+		return;
 	}
+	devices = fwupd_client_find_devices_by_guid (devices_tmp, guid, &error);
+	if (devices == NULL) {
+		g_task_return_error (task, error);
+		return;
+	}
+	g_task_return_pointer (task, devices, (GDestroyNotify) g_ptr_array_unref);
+}
 
-	/* success */
-	return g_steal_pointer (&devices);
+/**
+ * fwupd_client_get_devices_by_guid_async:
+ * @client: A #FwupdClient
+ * @guid: the GUID, e.g. `e22c4520-43dc-5bb3-8245-5787fead9b63`
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets any devices that provide a specific GUID. An error is returned if no
+ * devices contains this GUID.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_devices_by_guid_async (FwupdClient *client,
+					const gchar *guid,
+					GCancellable *cancellable,
+					GAsyncReadyCallback callback,
+					gpointer user_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (guid != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (client, cancellable, callback, user_data);
+	g_task_set_task_data (task, g_strdup (guid), g_free);
+	fwupd_client_get_devices_async (client, cancellable,
+					fwupd_client_get_devices_by_guid_cb, task);
+}
+
+/**
+ * fwupd_client_get_devices_by_guid_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_devices_by_guid_async().
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): devices or %NULL
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_devices_by_guid_finish (FwupdClient *client,
+					 GAsyncResult *res,
+					 GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
 }
 
 /**
@@ -631,6 +2226,63 @@ fwupd_client_get_releases (FwupdClient *client, const gchar *device_id,
 	return fwupd_release_array_from_variant (val);
 }
 
+/**
+ * fwupd_client_get_releases_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets all the releases for a specific device.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_releases_async (FwupdClient *client,
+				 const gchar *device_id,
+				 GCancellable *cancellable,
+				 GAsyncReadyCallback callback,
+				 gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "GetReleases",
+				 g_variant_new ("(s)", device_id),
+				 -1,
+				 fwupd_client_parse_releases,
+				 (GDestroyNotify) g_ptr_array_unref,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_get_releases_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_releases_async().
+ *
+ * Returns: (element-type FwupdRelease) (transfer container): results
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_releases_finish (FwupdClient *client,
+				  GAsyncResult *res,
+				  GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_get_downgrades:
  * @client: A #FwupdClient
@@ -677,27 +2329,187 @@ fwupd_client_get_downgrades (FwupdClient *client, const gchar *device_id,
 }
 
 /**
- * fwupd_client_get_upgrades:
+ * fwupd_client_get_downgrades_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets all the downgrades for a specific device.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_downgrades_async (FwupdClient *client,
+				   const gchar *device_id,
+				   GCancellable *cancellable,
+				   GAsyncReadyCallback callback,
+				   gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "GetDowngrades",
+				 g_variant_new ("(s)", device_id),
+				 -1,
+				 fwupd_client_parse_releases,
+				 (GDestroyNotify) g_ptr_array_unref,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_get_downgrades_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_downgrades_async().
+ *
+ * Returns: (element-type FwupdRelease) (transfer container): results
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_downgrades_finish (FwupdClient *client,
+				    GAsyncResult *res,
+				    GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * fwupd_client_get_upgrades:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets all the upgrades for a specific device.
+ *
+ * Returns: (element-type FwupdRelease) (transfer container): results
+ *
+ * Since: 0.9.8
+ **/
+GPtrArray *
+fwupd_client_get_upgrades (FwupdClient *client, const gchar *device_id,
+			   GCancellable *cancellable, GError **error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (device_id != NULL, NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon */
+	val = g_dbus_proxy_call_sync (priv->proxy,
+				      "GetUpgrades",
+				      g_variant_new ("(s)", device_id),
+				      G_DBUS_CALL_FLAGS_NONE,
+				      -1,
+				      cancellable,
+				      error);
+	if (val == NULL) {
+		if (error != NULL)
+			fwupd_client_fixup_dbus_error (*error);
+		return NULL;
+	}
+	return fwupd_release_array_from_variant (val);
+}
+
+/**
+ * fwupd_client_get_upgrades_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets all the upgrades for a specific device.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_upgrades_async (FwupdClient *client,
+				 const gchar *device_id,
+				 GCancellable *cancellable,
+				 GAsyncReadyCallback callback,
+				 gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "GetUpgrades",
+				 g_variant_new ("(s)", device_id),
+				 -1,
+				 fwupd_client_parse_releases,
+				 (GDestroyNotify) g_ptr_array_unref,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_get_upgrades_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_upgrades_async().
+ *
+ * Returns: (element-type FwupdRelease) (transfer container): results
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_upgrades_finish (FwupdClient *client,
+				  GAsyncResult *res,
+				  GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * fwupd_client_get_all_upgrades:
  * @client: A #FwupdClient
- * @device_id: the device ID
  * @cancellable: the #GCancellable, or %NULL
  * @error: the #GError, or %NULL
  *
- * Gets all the upgrades for a specific device.
+ * Gets all the upgrades for all the devices in one call. Devices without
+ * any upgrades are not included.
  *
- * Returns: (element-type FwupdRelease) (transfer container): results
+ * Returns: (transfer container) (element-type utf8 GPtrArray): the device
+ * ID mapped to an array of #FwupdRelease
  *
- * Since: 0.9.8
+ * Since: 1.5.0
  **/
-GPtrArray *
-fwupd_client_get_upgrades (FwupdClient *client, const gchar *device_id,
-			   GCancellable *cancellable, GError **error)
+GHashTable *
+fwupd_client_get_all_upgrades (FwupdClient *client,
+			       GCancellable *cancellable,
+			       GError **error)
 {
 	FwupdClientPrivate *priv = GET_PRIVATE (client);
 	g_autoptr(GVariant) val = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
-	g_return_val_if_fail (device_id != NULL, NULL);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
@@ -707,8 +2519,8 @@ fwupd_client_get_upgrades (FwupdClient *client, const gchar *device_id,
 
 	/* call into daemon */
 	val = g_dbus_proxy_call_sync (priv->proxy,
-				      "GetUpgrades",
-				      g_variant_new ("(s)", device_id),
+				      "GetAllUpgrades",
+				      NULL,
 				      G_DBUS_CALL_FLAGS_NONE,
 				      -1,
 				      cancellable,
@@ -718,7 +2530,63 @@ fwupd_client_get_upgrades (FwupdClient *client, const gchar *device_id,
 			fwupd_client_fixup_dbus_error (*error);
 		return NULL;
 	}
-	return fwupd_release_array_from_variant (val);
+	return fwupd_client_parse_all_upgrades (client, val, error);
+}
+
+/**
+ * fwupd_client_get_all_upgrades_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets all the upgrades for all the devices in one call. Devices without
+ * any upgrades are not included.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_all_upgrades_async (FwupdClient *client,
+				     GCancellable *cancellable,
+				     GAsyncReadyCallback callback,
+				     gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "GetAllUpgrades",
+				 NULL,
+				 -1,
+				 fwupd_client_parse_all_upgrades,
+				 (GDestroyNotify) g_hash_table_unref,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_get_all_upgrades_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_all_upgrades_async().
+ *
+ * Returns: (transfer container) (element-type utf8 GPtrArray): the device
+ * ID mapped to an array of #FwupdRelease
+ *
+ * Since: 1.5.0
+ **/
+GHashTable *
+fwupd_client_get_all_upgrades_finish (FwupdClient *client,
+				      GAsyncResult *res,
+				      GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
 }
 
 static void
@@ -783,6 +2651,67 @@ fwupd_client_modify_config (FwupdClient *client, const gchar *key, const gchar *
 	return TRUE;
 }
 
+/**
+ * fwupd_client_modify_config_async:
+ * @client: A #FwupdClient
+ * @key: key, e.g. `BlacklistPlugins`
+ * @value: value, e.g. `*`
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Modifies a daemon config option.
+ * The daemon will only respond to this request with proper permissions
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_modify_config_async (FwupdClient *client,
+				  const gchar *key,
+				  const gchar *value,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (key != NULL);
+	g_return_if_fail (value != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "ModifyConfig",
+				 g_variant_new ("(ss)", key, value),
+				 -1,
+				 NULL,
+				 NULL,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_modify_config_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_modify_config_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fwupd_client_modify_config_finish (FwupdClient *client,
+				   GAsyncResult *res,
+				   GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_activate:
  * @client: A #FwupdClient
@@ -832,6 +2761,64 @@ fwupd_client_activate (FwupdClient *client, GCancellable *cancellable,
 	return TRUE;
 }
 
+/**
+ * fwupd_client_activate_async:
+ * @client: A #FwupdClient
+ * @device_id: a device
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Activates up a device, which normally means the device switches to a new
+ * firmware version. This should only be called when data loss cannot occur.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_activate_async (FwupdClient *client,
+			     const gchar *device_id,
+			     GCancellable *cancellable,
+			     GAsyncReadyCallback callback,
+			     gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "Activate",
+				 g_variant_new ("(s)", device_id),
+				 -1,
+				 NULL,
+				 NULL,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_activate_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_activate_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fwupd_client_activate_finish (FwupdClient *client,
+			      GAsyncResult *res,
+			      GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_verify:
  * @client: A #FwupdClient
@@ -880,6 +2867,163 @@ fwupd_client_verify (FwupdClient *client, const gchar *device_id,
 	return TRUE;
 }
 
+/**
+ * fwupd_client_verify_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Verify a specific device.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_verify_async (FwupdClient *client,
+			   const gchar *device_id,
+			   GCancellable *cancellable,
+			   GAsyncReadyCallback callback,
+			   gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "Verify",
+				 g_variant_new ("(s)", device_id),
+				 -1,
+				 NULL,
+				 NULL,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_verify_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_verify_async().
+ *
+ * Returns: %TRUE for verification success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fwupd_client_verify_finish (FwupdClient *client,
+			    GAsyncResult *res,
+			    GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+/**
+ * fwupd_client_verify_all:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Verify all the devices that support it, reading back devices on different
+ * buses at the same time.
+ *
+ * Returns: (transfer container) (element-type utf8 utf8): the device ID
+ * mapped to an error message, where an empty string is success
+ *
+ * Since: 1.5.0
+ **/
+GHashTable *
+fwupd_client_verify_all (FwupdClient *client, GCancellable *cancellable, GError **error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	g_autoptr(GVariant) val = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (client, cancellable, error))
+		return NULL;
+
+	/* call into daemon, which may take a long time */
+	val = g_dbus_proxy_call_sync (priv->proxy,
+				      "VerifyAll",
+				      NULL,
+				      G_DBUS_CALL_FLAGS_NONE,
+				      G_MAXINT,
+				      cancellable,
+				      error);
+	if (val == NULL) {
+		if (error != NULL)
+			fwupd_client_fixup_dbus_error (*error);
+		return NULL;
+	}
+	return fwupd_client_parse_verify_all (client, val, error);
+}
+
+/**
+ * fwupd_client_verify_all_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Verify all the devices that support it, reading back devices on different
+ * buses at the same time.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_verify_all_async (FwupdClient *client,
+			       GCancellable *cancellable,
+			       GAsyncReadyCallback callback,
+			       gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "VerifyAll",
+				 NULL,
+				 G_MAXINT,
+				 fwupd_client_parse_verify_all,
+				 (GDestroyNotify) g_hash_table_unref,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_verify_all_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_verify_all_async().
+ *
+ * Returns: (transfer container) (element-type utf8 utf8): the device ID
+ * mapped to an error message, where an empty string is success
+ *
+ * Since: 1.5.0
+ **/
+GHashTable *
+fwupd_client_verify_all_finish (FwupdClient *client,
+				GAsyncResult *res,
+				GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_verify_update:
  * @client: A #FwupdClient
@@ -928,6 +3072,63 @@ fwupd_client_verify_update (FwupdClient *client, const gchar *device_id,
 	return TRUE;
 }
 
+/**
+ * fwupd_client_verify_update_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Update the verification record for a specific device.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_verify_update_async (FwupdClient *client,
+				  const gchar *device_id,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "VerifyUpdate",
+				 g_variant_new ("(s)", device_id),
+				 -1,
+				 NULL,
+				 NULL,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_verify_update_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_verify_update_async().
+ *
+ * Returns: %TRUE for verification success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fwupd_client_verify_update_finish (FwupdClient *client,
+				   GAsyncResult *res,
+				   GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_unlock:
  * @client: A #FwupdClient
@@ -976,6 +3177,63 @@ fwupd_client_unlock (FwupdClient *client, const gchar *device_id,
 	return TRUE;
 }
 
+/**
+ * fwupd_client_unlock_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Unlocks a specific device so firmware can be read or wrote.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_unlock_async (FwupdClient *client,
+			   const gchar *device_id,
+			   GCancellable *cancellable,
+			   GAsyncReadyCallback callback,
+			   gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "Unlock",
+				 g_variant_new ("(s)", device_id),
+				 -1,
+				 NULL,
+				 NULL,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_unlock_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_unlock_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fwupd_client_unlock_finish (FwupdClient *client,
+			    GAsyncResult *res,
+			    GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_clear_results:
  * @client: A #FwupdClient
@@ -1024,6 +3282,63 @@ fwupd_client_clear_results (FwupdClient *client, const gchar *device_id,
 	return TRUE;
 }
 
+/**
+ * fwupd_client_clear_results_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Clears the results for a specific device.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_clear_results_async (FwupdClient *client,
+				  const gchar *device_id,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "ClearResults",
+				 g_variant_new ("(s)", device_id),
+				 -1,
+				 NULL,
+				 NULL,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_clear_results_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_clear_results_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fwupd_client_clear_results_finish (FwupdClient *client,
+				   GAsyncResult *res,
+				   GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_get_results:
  * @client: A #FwupdClient
@@ -1072,6 +3387,63 @@ fwupd_client_get_results (FwupdClient *client, const gchar *device_id,
 	return fwupd_device_from_variant (helper->val);
 }
 
+/**
+ * fwupd_client_get_results_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets the results of a previous firmware update for a specific device.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_results_async (FwupdClient *client,
+				const gchar *device_id,
+				GCancellable *cancellable,
+				GAsyncReadyCallback callback,
+				gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "GetResults",
+				 g_variant_new ("(s)", device_id),
+				 -1,
+				 fwupd_client_parse_device,
+				 (GDestroyNotify) g_object_unref,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_get_results_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_results_async().
+ *
+ * Returns: (transfer full): a #FwupdDevice, or %NULL for failure
+ *
+ * Since: 1.5.0
+ **/
+FwupdDevice *
+fwupd_client_get_results_finish (FwupdClient *client,
+				 GAsyncResult *res,
+				 GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
 #ifdef HAVE_GIO_UNIX
 static void
 fwupd_client_send_message_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
@@ -1118,13 +3490,8 @@ fwupd_client_install (FwupdClient *client,
 {
 #ifdef HAVE_GIO_UNIX
 	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	GVariant *body;
-	GVariantBuilder builder;
-	gint retval;
-	gint fd;
 	g_autoptr(FwupdClientHelper) helper = NULL;
 	g_autoptr(GDBusMessage) request = NULL;
-	g_autoptr(GUnixFDList) fd_list = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
 	g_return_val_if_fail (device_id != NULL, FALSE);
@@ -1136,61 +3503,16 @@ fwupd_client_install (FwupdClient *client,
 	if (!fwupd_client_connect (client, cancellable, error))
 		return FALSE;
 
-	/* set options */
-	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
-	g_variant_builder_add (&builder, "{sv}",
-			       "reason", g_variant_new_string ("user-action"));
-	g_variant_builder_add (&builder, "{sv}",
-			       "filename", g_variant_new_string (filename));
-	if (install_flags & FWUPD_INSTALL_FLAG_OFFLINE) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "offline", g_variant_new_boolean (TRUE));
-	}
-	if (install_flags & FWUPD_INSTALL_FLAG_ALLOW_OLDER) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "allow-older", g_variant_new_boolean (TRUE));
-	}
-	if (install_flags & FWUPD_INSTALL_FLAG_ALLOW_REINSTALL) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "allow-reinstall", g_variant_new_boolean (TRUE));
-	}
-	if (install_flags & FWUPD_INSTALL_FLAG_FORCE) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "force", g_variant_new_boolean (TRUE));
-	}
-	if (install_flags & FWUPD_INSTALL_FLAG_NO_HISTORY) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "no-history", g_variant_new_boolean (TRUE));
-	}
-
-	/* open file */
-	fd = open (filename, O_RDONLY);
-	if (fd < 0) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INVALID_FILE,
-			     "failed to open %s",
-			     filename);
+	/* set options and out of band file descriptor */
+	request = fwupd_client_build_install_request (device_id,
+						      filename,
+						      install_flags,
+						      error);
+	if (request == NULL)
 		return FALSE;
-	}
-
-	/* set out of band file descriptor */
-	fd_list = g_unix_fd_list_new ();
-	retval = g_unix_fd_list_append (fd_list, fd, NULL);
-	g_assert (retval != -1);
-	request = g_dbus_message_new_method_call (FWUPD_DBUS_SERVICE,
-						  FWUPD_DBUS_PATH,
-						  FWUPD_DBUS_INTERFACE,
-						  "Install");
-	g_dbus_message_set_unix_fd_list (request, fd_list);
-
-	/* g_unix_fd_list_append did a dup() already */
-	close (fd);
 
 	/* call into daemon */
 	helper = fwupd_client_helper_new ();
-	body = g_variant_new ("(sha{sv})", device_id, fd, &builder);
-	g_dbus_message_set_body (request, body);
 	g_dbus_connection_send_message_with_reply (priv->conn,
 						   request,
 						   G_DBUS_SEND_MESSAGE_FLAGS_NONE,
@@ -1215,6 +3537,88 @@ fwupd_client_install (FwupdClient *client,
 #endif
 }
 
+/**
+ * fwupd_client_install_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @filename: the filename to install
+ * @install_flags: the #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_ALLOW_REINSTALL
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Install a file onto a specific device. Unlike fwupd_client_install() this
+ * does not run a nested main loop while the daemon is writing the firmware.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_install_async (FwupdClient *client,
+			    const gchar *device_id,
+			    const gchar *filename,
+			    FwupdInstallFlags install_flags,
+			    GCancellable *cancellable,
+			    GAsyncReadyCallback callback,
+			    gpointer user_data)
+{
+#ifdef HAVE_GIO_UNIX
+	g_autoptr(GDBusMessage) request = NULL;
+	GError *error = NULL;
+#endif
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (filename != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+#ifdef HAVE_GIO_UNIX
+	request = fwupd_client_build_install_request (device_id,
+						      filename,
+						      install_flags,
+						      &error);
+	if (request == NULL) {
+		g_task_report_error (client, callback, user_data, NULL, error);
+		return;
+	}
+	fwupd_client_send_message_async (client,
+					 request,
+					 G_MAXINT,
+					 NULL,
+					 NULL,
+					 cancellable,
+					 callback,
+					 user_data);
+#else
+	g_task_report_new_error (client, callback, user_data, NULL,
+				 FWUPD_ERROR,
+				 FWUPD_ERROR_NOT_SUPPORTED,
+				 "Not supported as <glib-unix.h> is unavailable");
+#endif
+}
+
+/**
+ * fwupd_client_install_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_install_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fwupd_client_install_finish (FwupdClient *client,
+			     GAsyncResult *res,
+			     GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_get_details:
  * @client: A #FwupdClient
@@ -1234,12 +3638,8 @@ fwupd_client_get_details (FwupdClient *client, const gchar *filename,
 {
 #ifdef HAVE_GIO_UNIX
 	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	GVariant *body;
-	gint fd;
-	gint retval;
 	g_autoptr(FwupdClientHelper) helper = NULL;
 	g_autoptr(GDBusMessage) request = NULL;
-	g_autoptr(GUnixFDList) fd_list = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
 	g_return_val_if_fail (filename != NULL, NULL);
@@ -1250,35 +3650,13 @@ fwupd_client_get_details (FwupdClient *client, const gchar *filename,
 	if (!fwupd_client_connect (client, cancellable, error))
 		return NULL;
 
-	/* open file */
-	fd = open (filename, O_RDONLY);
-	if (fd < 0) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INVALID_FILE,
-			     "failed to open %s",
-			     filename);
-		return NULL;
-	}
-
 	/* set out of band file descriptor */
-	fd_list = g_unix_fd_list_new ();
-	retval = g_unix_fd_list_append (fd_list, fd, NULL);
-	g_assert (retval != -1);
-	request = g_dbus_message_new_method_call (FWUPD_DBUS_SERVICE,
-						  FWUPD_DBUS_PATH,
-						  FWUPD_DBUS_INTERFACE,
-						  "GetDetails");
-	g_dbus_message_set_unix_fd_list (request, fd_list);
-
-	/* g_unix_fd_list_append did a dup() already */
-	close (fd);
+	request = fwupd_client_build_details_request (filename, error);
+	if (request == NULL)
+		return NULL;
 
 	/* call into daemon */
 	helper = fwupd_client_helper_new ();
-	body = g_variant_new ("(h)", fd);
-	g_dbus_message_set_body (request, body);
-
 	g_dbus_connection_send_message_with_reply (priv->conn,
 						   request,
 						   G_DBUS_SEND_MESSAGE_FLAGS_NONE,
@@ -1305,6 +3683,79 @@ fwupd_client_get_details (FwupdClient *client, const gchar *filename,
 #endif
 }
 
+/**
+ * fwupd_client_get_details_async:
+ * @client: A #FwupdClient
+ * @filename: the firmware filename, e.g. `firmware.cab`
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets details about a specific firmware file.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_details_async (FwupdClient *client,
+				const gchar *filename,
+				GCancellable *cancellable,
+				GAsyncReadyCallback callback,
+				gpointer user_data)
+{
+#ifdef HAVE_GIO_UNIX
+	g_autoptr(GDBusMessage) request = NULL;
+	GError *error = NULL;
+#endif
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (filename != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+#ifdef HAVE_GIO_UNIX
+	request = fwupd_client_build_details_request (filename, &error);
+	if (request == NULL) {
+		g_task_report_error (client, callback, user_data, NULL, error);
+		return;
+	}
+	fwupd_client_send_message_async (client,
+					 request,
+					 -1,
+					 fwupd_client_parse_devices,
+					 (GDestroyNotify) g_ptr_array_unref,
+					 cancellable,
+					 callback,
+					 user_data);
+#else
+	g_task_report_new_error (client, callback, user_data, NULL,
+				 FWUPD_ERROR,
+				 FWUPD_ERROR_NOT_SUPPORTED,
+				 "Not supported as <glib-unix.h> is unavailable");
+#endif
+}
+
+/**
+ * fwupd_client_get_details_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_details_async().
+ *
+ * Returns: (transfer container) (element-type FwupdDevice): an array of results
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_details_finish (FwupdClient *client,
+				 GAsyncResult *res,
+				 GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_get_percentage:
  * @client: A #FwupdClient
@@ -1480,12 +3931,8 @@ fwupd_client_update_metadata (FwupdClient *client,
 {
 #ifdef HAVE_GIO_UNIX
 	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	GVariant *body;
-	gint fd;
-	gint fd_sig;
 	g_autoptr(FwupdClientHelper) helper = NULL;
 	g_autoptr(GDBusMessage) request = NULL;
-	g_autoptr(GUnixFDList) fd_list = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
 	g_return_val_if_fail (remote_id != NULL, FALSE);
@@ -1498,44 +3945,15 @@ fwupd_client_update_metadata (FwupdClient *client,
 	if (!fwupd_client_connect (client, cancellable, error))
 		return FALSE;
 
-	/* open file */
-	fd = open (metadata_fn, O_RDONLY);
-	if (fd < 0) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INVALID_FILE,
-			     "failed to open %s",
-			     metadata_fn);
-		return FALSE;
-	}
-	fd_sig = open (signature_fn, O_RDONLY);
-	if (fd_sig < 0) {
-		close (fd);
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INVALID_FILE,
-			     "failed to open %s",
-			     signature_fn);
+	/* set out of band file descriptors */
+	request = fwupd_client_build_update_metadata_request (remote_id,
+							      metadata_fn,
+							      signature_fn,
+							      error);
+	if (request == NULL)
 		return FALSE;
-	}
-
-	/* set out of band file descriptor */
-	fd_list = g_unix_fd_list_new ();
-	g_unix_fd_list_append (fd_list, fd, NULL);
-	g_unix_fd_list_append (fd_list, fd_sig, NULL);
-	request = g_dbus_message_new_method_call (FWUPD_DBUS_SERVICE,
-						  FWUPD_DBUS_PATH,
-						  FWUPD_DBUS_INTERFACE,
-						  "UpdateMetadata");
-	g_dbus_message_set_unix_fd_list (request, fd_list);
-
-	/* g_unix_fd_list_append did a dup() already */
-	close (fd);
-	close (fd_sig);
 
 	/* call into daemon */
-	body = g_variant_new ("(shh)", remote_id, fd, fd_sig);
-	g_dbus_message_set_body (request, body);
 	helper = fwupd_client_helper_new ();
 	g_dbus_connection_send_message_with_reply (priv->conn,
 						   request,
@@ -1561,6 +3979,90 @@ fwupd_client_update_metadata (FwupdClient *client,
 #endif
 }
 
+/**
+ * fwupd_client_update_metadata_async:
+ * @client: A #FwupdClient
+ * @remote_id: the remote ID, e.g. `lvfs-testing`
+ * @metadata_fn: the XML metadata filename
+ * @signature_fn: the GPG signature file
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Updates the metadata. This allows a session process to download the metadata
+ * and metadata signing file to be passed into the daemon to be checked and
+ * parsed.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_update_metadata_async (FwupdClient *client,
+				    const gchar *remote_id,
+				    const gchar *metadata_fn,
+				    const gchar *signature_fn,
+				    GCancellable *cancellable,
+				    GAsyncReadyCallback callback,
+				    gpointer user_data)
+{
+#ifdef HAVE_GIO_UNIX
+	g_autoptr(GDBusMessage) request = NULL;
+	GError *error = NULL;
+#endif
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (remote_id != NULL);
+	g_return_if_fail (metadata_fn != NULL);
+	g_return_if_fail (signature_fn != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+#ifdef HAVE_GIO_UNIX
+	request = fwupd_client_build_update_metadata_request (remote_id,
+							      metadata_fn,
+							      signature_fn,
+							      &error);
+	if (request == NULL) {
+		g_task_report_error (client, callback, user_data, NULL, error);
+		return;
+	}
+	fwupd_client_send_message_async (client,
+					 request,
+					 -1,
+					 NULL,
+					 NULL,
+					 cancellable,
+					 callback,
+					 user_data);
+#else
+	g_task_report_new_error (client, callback, user_data, NULL,
+				 FWUPD_ERROR,
+				 FWUPD_ERROR_NOT_SUPPORTED,
+				 "Not supported as <glib-unix.h> is unavailable");
+#endif
+}
+
+/**
+ * fwupd_client_update_metadata_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_update_metadata_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fwupd_client_update_metadata_finish (FwupdClient *client,
+				     GAsyncResult *res,
+				     GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_get_remotes:
  * @client: A #FwupdClient
@@ -1603,6 +4105,60 @@ fwupd_client_get_remotes (FwupdClient *client, GCancellable *cancellable, GError
 	return fwupd_remote_array_from_variant (val);
 }
 
+/**
+ * fwupd_client_get_remotes_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets the list of remotes that have been configured for the system.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_remotes_async (FwupdClient *client,
+				GCancellable *cancellable,
+				GAsyncReadyCallback callback,
+				gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "GetRemotes",
+				 NULL,
+				 -1,
+				 fwupd_client_parse_remotes,
+				 (GDestroyNotify) g_ptr_array_unref,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_get_remotes_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_remotes_async().
+ *
+ * Returns: (element-type FwupdRemote) (transfer container): list of remotes, or %NULL
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fwupd_client_get_remotes_finish (FwupdClient *client,
+				 GAsyncResult *res,
+				 GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_get_approved_firmware:
  * @client: A #FwupdClient
@@ -1622,7 +4178,6 @@ fwupd_client_get_approved_firmware (FwupdClient *client,
 {
 	FwupdClientPrivate *priv = GET_PRIVATE (client);
 	g_autoptr(GVariant) val = NULL;
-	gchar **retval = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
@@ -1645,8 +4200,61 @@ fwupd_client_get_approved_firmware (FwupdClient *client,
 			fwupd_client_fixup_dbus_error (*error);
 		return NULL;
 	}
-	g_variant_get (val, "(^as)", &retval);
-	return retval;
+	return fwupd_client_parse_approved_firmware (client, val, error);
+}
+
+/**
+ * fwupd_client_get_approved_firmware_async:
+ * @client: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets the list of approved firmware.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_approved_firmware_async (FwupdClient *client,
+					  GCancellable *cancellable,
+					  GAsyncReadyCallback callback,
+					  gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "GetApprovedFirmware",
+				 NULL,
+				 -1,
+				 fwupd_client_parse_approved_firmware,
+				 (GDestroyNotify) g_strfreev,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_get_approved_firmware_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_approved_firmware_async().
+ *
+ * Returns: (transfer full): list of remotes, or %NULL
+ *
+ * Since: 1.5.0
+ **/
+gchar **
+fwupd_client_get_approved_firmware_finish (FwupdClient *client,
+					   GAsyncResult *res,
+					   GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
 }
 
 /**
@@ -1695,6 +4303,63 @@ fwupd_client_set_approved_firmware (FwupdClient *client,
 	return TRUE;
 }
 
+/**
+ * fwupd_client_set_approved_firmware_async:
+ * @client: A #FwupdClient
+ * @checksums: Array of checksums
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Sets the list of approved firmware.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_set_approved_firmware_async (FwupdClient *client,
+					  gchar **checksums,
+					  GCancellable *cancellable,
+					  GAsyncReadyCallback callback,
+					  gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (checksums != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "SetApprovedFirmware",
+				 g_variant_new ("(^as)", checksums),
+				 -1,
+				 NULL,
+				 NULL,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_set_approved_firmware_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_set_approved_firmware_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fwupd_client_set_approved_firmware_finish (FwupdClient *client,
+					   GAsyncResult *res,
+					   GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_self_sign:
  * @client: A #FwupdClient
@@ -1717,9 +4382,7 @@ fwupd_client_self_sign (FwupdClient *client,
 			GError **error)
 {
 	FwupdClientPrivate *priv = GET_PRIVATE (client);
-	GVariantBuilder builder;
 	g_autoptr(GVariant) val = NULL;
-	gchar *retval = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
@@ -1729,21 +4392,10 @@ fwupd_client_self_sign (FwupdClient *client,
 	if (!fwupd_client_connect (client, cancellable, error))
 		return NULL;
 
-	/* set options */
-	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
-	if (flags & FWUPD_SELF_SIGN_FLAG_ADD_TIMESTAMP) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "add-timestamp", g_variant_new_boolean (TRUE));
-	}
-	if (flags & FWUPD_SELF_SIGN_FLAG_ADD_CERT) {
-		g_variant_builder_add (&builder, "{sv}",
-				       "add-cert", g_variant_new_boolean (TRUE));
-	}
-
 	/* call into daemon */
 	val = g_dbus_proxy_call_sync (priv->proxy,
 				      "SelfSign",
-				      g_variant_new ("(sa{sv})", value, &builder),
+				      fwupd_client_build_self_sign_params (value, flags),
 				      G_DBUS_CALL_FLAGS_NONE,
 				      -1,
 				      cancellable,
@@ -1753,8 +4405,66 @@ fwupd_client_self_sign (FwupdClient *client,
 			fwupd_client_fixup_dbus_error (*error);
 		return NULL;
 	}
-	g_variant_get (val, "(s)", &retval);
-	return retval;
+	return fwupd_client_parse_self_sign (client, val, error);
+}
+
+/**
+ * fwupd_client_self_sign_async:
+ * @client: A #FwupdClient
+ * @value: A string to sign, typically a JSON blob
+ * @flags: #FwupdSelfSignFlags, e.g. %FWUPD_SELF_SIGN_FLAG_ADD_TIMESTAMP
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Signs the data using the client self-signed certificate.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_self_sign_async (FwupdClient *client,
+			      const gchar *value,
+			      FwupdSelfSignFlags flags,
+			      GCancellable *cancellable,
+			      GAsyncReadyCallback callback,
+			      gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (value != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "SelfSign",
+				 fwupd_client_build_self_sign_params (value, flags),
+				 -1,
+				 fwupd_client_parse_self_sign,
+				 g_free,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_self_sign_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_self_sign_async().
+ *
+ * Returns: (transfer full): the signature, or %NULL
+ *
+ * Since: 1.5.0
+ **/
+gchar *
+fwupd_client_self_sign_finish (FwupdClient *client,
+			       GAsyncResult *res,
+			       GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
 }
 
 /**
@@ -1812,6 +4522,71 @@ fwupd_client_modify_remote (FwupdClient *client,
 	return TRUE;
 }
 
+/**
+ * fwupd_client_modify_remote_async:
+ * @client: A #FwupdClient
+ * @remote_id: the remote ID, e.g. `lvfs-testing`
+ * @key: the key, e.g. `Enabled`
+ * @value: the key, e.g. `true`
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Modifies a system remote in a specific way.
+ *
+ * NOTE: User authentication may be required to complete this action.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_modify_remote_async (FwupdClient *client,
+				  const gchar *remote_id,
+				  const gchar *key,
+				  const gchar *value,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer user_data)
+{
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (remote_id != NULL);
+	g_return_if_fail (key != NULL);
+	g_return_if_fail (value != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "ModifyRemote",
+				 g_variant_new ("(sss)", remote_id, key, value),
+				 -1,
+				 NULL,
+				 NULL,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_modify_remote_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_modify_remote_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fwupd_client_modify_remote_finish (FwupdClient *client,
+				   GAsyncResult *res,
+				   GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 /**
  * fwupd_client_modify_device:
  * @client: A #FwupdClient
@@ -1868,15 +4643,70 @@ fwupd_client_modify_device (FwupdClient *client,
 	return TRUE;
 }
 
-static FwupdRemote *
-fwupd_client_get_remote_by_id_noref (GPtrArray *remotes, const gchar *remote_id)
+/**
+ * fwupd_client_modify_device_async:
+ * @client: A #FwupdClient
+ * @device_id: the device ID
+ * @key: the key, e.g. `Flags`
+ * @value: the key, e.g. `reported`
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Modifies a device in a specific way. Not all properties on the #FwupdDevice
+ * are settable by the client, and some may have other restrictions on @value.
+ *
+ * NOTE: User authentication may be required to complete this action.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_modify_device_async (FwupdClient *client,
+				  const gchar *device_id,
+				  const gchar *key,
+				  const gchar *value,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer user_data)
 {
-	for (guint i = 0; i < remotes->len; i++) {
-		FwupdRemote *remote = g_ptr_array_index (remotes, i);
-		if (g_strcmp0 (remote_id, fwupd_remote_get_id (remote)) == 0)
-			return remote;
-	}
-	return NULL;
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (key != NULL);
+	g_return_if_fail (value != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	fwupd_client_call_async (client,
+				 "ModifyDevice",
+				 g_variant_new ("(sss)", device_id, key, value),
+				 -1,
+				 NULL,
+				 NULL,
+				 cancellable,
+				 callback,
+				 user_data);
+}
+
+/**
+ * fwupd_client_modify_device_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_modify_device_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fwupd_client_modify_device_finish (FwupdClient *client,
+				   GAsyncResult *res,
+				   GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, client), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
 }
 
 /**
@@ -1898,7 +4728,6 @@ fwupd_client_get_remote_by_id (FwupdClient *client,
 			       GCancellable *cancellable,
 			       GError **error)
 {
-	FwupdRemote *remote;
 	g_autoptr(GPtrArray) remotes = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
@@ -1910,18 +4739,83 @@ fwupd_client_get_remote_by_id (FwupdClient *client,
 	remotes = fwupd_client_get_remotes (client, cancellable, error);
 	if (remotes == NULL)
 		return NULL;
-	remote = fwupd_client_get_remote_by_id_noref (remotes, remote_id);
+	return fwupd_client_find_remote_by_id (remotes, remote_id, error);
+}
+
+static void
+fwupd_client_get_remote_by_id_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	const gchar *remote_id = g_task_get_task_data (task);
+	FwupdRemote *remote;
+	GError *error = NULL;
+	g_autoptr(GPtrArray) remotes = NULL;
+
+	remotes = fwupd_client_get_remotes_finish (FWUPD_CLIENT (source), res, &error);
+	if (remotes == NULL) {
+		g_task_return_error (task, error);
+		return;
+	}
+	remote = fwupd_client_find_remote_by_id (remotes, remote_id, &error);
 	if (remote == NULL) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_NOT_FOUND,
-			     "No remote '%s' found in search paths",
-			     remote_id);
-		return NULL;
+		g_task_return_error (task, error);
+		return;
 	}
+	g_task_return_pointer (task, remote, (GDestroyNotify) g_object_unref);
+}
+
+/**
+ * fwupd_client_get_remote_by_id_async:
+ * @client: A #FwupdClient
+ * @remote_id: the remote ID, e.g. `lvfs-testing`
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Gets a specific remote that has been configured for the system.
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_get_remote_by_id_async (FwupdClient *client,
+				     const gchar *remote_id,
+				     GCancellable *cancellable,
+				     GAsyncReadyCallback callback,
+				     gpointer user_data)
+{
+	GTask *task;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (client));
+	g_return_if_fail (remote_id != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 
-	/* success */
-	return g_object_ref (remote);
+	task = g_task_new (client, cancellable, callback, user_data);
+	g_task_set_task_data (task, g_strdup (remote_id), g_free);
+	fwupd_client_get_remotes_async (client, cancellable,
+					fwupd_client_get_remote_by_id_cb, task);
+}
+
+/**
+ * fwupd_client_get_remote_by_id_finish:
+ * @client: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_remote_by_id_async().
+ *
+ * Returns: (transfer full): a #FwupdRemote, or %NULL if not found
+ *
+ * Since: 1.5.0
+ **/
+FwupdRemote *
+fwupd_client_get_remote_by_id_finish (FwupdClient *client,
+				      GAsyncResult *res,
+				      GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK (res), error);
 }
 
 static void
@@ -2169,6 +5063,9 @@ fwupd_client_class_init (FwupdClientClass *klass)
 static void
 fwupd_client_init (FwupdClient *client)
 {
+	FwupdClientPrivate *priv = GET_PRIVATE (client);
+	priv->devices_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+						     g_free, (GDestroyNotify) g_object_unref);
 }
 
 static void
@@ -2181,6 +5078,7 @@ fwupd_client_finalize (GObject *object)
 	g_free (priv->host_product);
 	g_free (priv->host_machine_id);
 	g_free (priv->host_security_id);
+	g_hash_table_unref (priv->devices_cache);
 	if (priv->conn != NULL)
 		g_object_unref (priv->conn);
 	if (priv->proxy != NULL)
@@ -44,92 +44,328 @@ FwupdClient	*fwupd_client_new			(void);
 gboolean	 fwupd_client_connect			(FwupdClient	*client,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_connect_async		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gboolean	 fwupd_client_connect_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 GPtrArray	*fwupd_client_get_devices		(FwupdClient	*client,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_get_devices_async		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GPtrArray	*fwupd_client_get_devices_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+GPtrArray	*fwupd_client_get_devices_fd		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GError		**error);
+GPtrArray	*fwupd_client_get_devices_cached	(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GError		**error);
+void		 fwupd_client_get_devices_cached_async	(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GPtrArray	*fwupd_client_get_devices_cached_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 GPtrArray	*fwupd_client_get_history		(FwupdClient	*client,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_get_history_async		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GPtrArray	*fwupd_client_get_history_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+GPtrArray	*fwupd_client_get_history_full		(FwupdClient	*client,
+							 const gchar	*device_id,
+							 FwupdUpdateState update_state,
+							 guint64	 since,
+							 guint		 limit,
+							 guint		 offset,
+							 GCancellable	*cancellable,
+							 GError		**error);
+void		 fwupd_client_get_history_full_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 FwupdUpdateState update_state,
+							 guint64	 since,
+							 guint		 limit,
+							 guint		 offset,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GPtrArray	*fwupd_client_get_history_full_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 GPtrArray	*fwupd_client_get_releases		(FwupdClient	*client,
 							 const gchar	*device_id,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_get_releases_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GPtrArray	*fwupd_client_get_releases_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 GPtrArray	*fwupd_client_get_downgrades		(FwupdClient	*client,
 							 const gchar	*device_id,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_get_downgrades_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GPtrArray	*fwupd_client_get_downgrades_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+GHashTable	*fwupd_client_get_all_upgrades		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GError		**error);
+void		 fwupd_client_get_all_upgrades_async	(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GHashTable	*fwupd_client_get_all_upgrades_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 GPtrArray	*fwupd_client_get_upgrades		(FwupdClient	*client,
 							 const gchar	*device_id,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_get_upgrades_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GPtrArray	*fwupd_client_get_upgrades_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 GPtrArray	*fwupd_client_get_details		(FwupdClient	*client,
 							 const gchar	*filename,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_get_details_async		(FwupdClient	*client,
+							 const gchar	*filename,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GPtrArray	*fwupd_client_get_details_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 gboolean	 fwupd_client_verify			(FwupdClient	*client,
 							 const gchar	*device_id,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_verify_async		(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gboolean	 fwupd_client_verify_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+GHashTable	*fwupd_client_verify_all		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GError		**error);
+void		 fwupd_client_verify_all_async		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GHashTable	*fwupd_client_verify_all_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 gboolean	 fwupd_client_verify_update		(FwupdClient	*client,
 							 const gchar	*device_id,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_verify_update_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gboolean	 fwupd_client_verify_update_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 gboolean	 fwupd_client_unlock			(FwupdClient	*client,
 							 const gchar	*device_id,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_unlock_async		(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gboolean	 fwupd_client_unlock_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 gboolean	 fwupd_client_modify_config		(FwupdClient	*client,
 							 const gchar	*key,
 							 const gchar	*value,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_modify_config_async	(FwupdClient	*client,
+							 const gchar	*key,
+							 const gchar	*value,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gboolean	 fwupd_client_modify_config_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 gboolean	 fwupd_client_activate			(FwupdClient	*client,
 							 GCancellable	*cancellable,
 							 const gchar	*device_id,
 							 GError		**error);
+void		 fwupd_client_activate_async		(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gboolean	 fwupd_client_activate_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 gboolean	 fwupd_client_clear_results		(FwupdClient	*client,
 							 const gchar	*device_id,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_clear_results_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gboolean	 fwupd_client_clear_results_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 FwupdDevice	*fwupd_client_get_results		(FwupdClient	*client,
 							 const gchar	*device_id,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_get_results_async		(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+FwupdDevice	*fwupd_client_get_results_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 GPtrArray	*fwupd_client_get_host_security_attrs	(FwupdClient	*client,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_get_host_security_attrs_async	(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GPtrArray	*fwupd_client_get_host_security_attrs_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
+GHashTable	*fwupd_client_get_statistics		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GError		**error);
+void		 fwupd_client_get_statistics_async	(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GHashTable	*fwupd_client_get_statistics_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 FwupdDevice	*fwupd_client_get_device_by_id		(FwupdClient	*client,
 							 const gchar	*device_id,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_get_device_by_id_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+FwupdDevice	*fwupd_client_get_device_by_id_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 GPtrArray	*fwupd_client_get_devices_by_guid	(FwupdClient	*client,
 							 const gchar	*guid,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_get_devices_by_guid_async	(FwupdClient	*client,
+							 const gchar	*guid,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GPtrArray	*fwupd_client_get_devices_by_guid_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 gboolean	 fwupd_client_install			(FwupdClient	*client,
 							 const gchar	*device_id,
 							 const gchar	*filename,
 							 FwupdInstallFlags install_flags,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_install_async		(FwupdClient	*client,
+							 const gchar	*device_id,
+							 const gchar	*filename,
+							 FwupdInstallFlags install_flags,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gboolean	 fwupd_client_install_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 gboolean	 fwupd_client_update_metadata		(FwupdClient	*client,
 							 const gchar	*remote_id,
 							 const gchar	*metadata_fn,
 							 const gchar	*signature_fn,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_update_metadata_async	(FwupdClient	*client,
+							 const gchar	*remote_id,
+							 const gchar	*metadata_fn,
+							 const gchar	*signature_fn,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gboolean	 fwupd_client_update_metadata_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 gboolean	 fwupd_client_modify_remote		(FwupdClient	*client,
 							 const gchar	*remote_id,
 							 const gchar	*key,
 							 const gchar	*value,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_modify_remote_async	(FwupdClient	*client,
+							 const gchar	*remote_id,
+							 const gchar	*key,
+							 const gchar	*value,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gboolean	 fwupd_client_modify_remote_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 gboolean	 fwupd_client_modify_device		(FwupdClient	*client,
 							 const gchar	*device_id,
 							 const gchar	*key,
 							 const gchar	*value,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_modify_device_async	(FwupdClient	*client,
+							 const gchar	*device_id,
+							 const gchar	*key,
+							 const gchar	*value,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gboolean	 fwupd_client_modify_device_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 FwupdStatus	 fwupd_client_get_status		(FwupdClient	*client);
 gboolean	 fwupd_client_get_tainted		(FwupdClient	*client);
 gboolean	 fwupd_client_get_daemon_interactive	(FwupdClient	*client);
@@ -142,22 +378,61 @@ const gchar	*fwupd_client_get_host_security_id	(FwupdClient	*client);
 GPtrArray	*fwupd_client_get_remotes		(FwupdClient	*client,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_get_remotes_async		(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+GPtrArray	*fwupd_client_get_remotes_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 FwupdRemote	*fwupd_client_get_remote_by_id		(FwupdClient	*client,
 							 const gchar	*remote_id,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_get_remote_by_id_async	(FwupdClient	*client,
+							 const gchar	*remote_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+FwupdRemote	*fwupd_client_get_remote_by_id_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 
 gchar		**fwupd_client_get_approved_firmware	(FwupdClient	*client,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_get_approved_firmware_async	(FwupdClient	*client,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gchar		**fwupd_client_get_approved_firmware_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 gboolean	 fwupd_client_set_approved_firmware	(FwupdClient	*client,
 							 gchar		**checksums,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_set_approved_firmware_async	(FwupdClient	*client,
+							 gchar		**checksums,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gboolean	 fwupd_client_set_approved_firmware_finish	(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 gchar		*fwupd_client_self_sign			(FwupdClient	*client,
 							 const gchar	*value,
 							 FwupdSelfSignFlags flags,
 							 GCancellable	*cancellable,
 							 GError		**error);
+void		 fwupd_client_self_sign_async		(FwupdClient	*client,
+							 const gchar	*value,
+							 FwupdSelfSignFlags flags,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 user_data);
+gchar		*fwupd_client_self_sign_finish		(FwupdClient	*client,
+							 GAsyncResult	*res,
+							 GError		**error);
 
 G_END_DECLS
@@ -565,8 +565,15 @@ fwupd_build_history_report_json (GPtrArray *devices, GError **error)
 	return data;
 }
 
-#define FWUPD_GUID_NAMESPACE_DEFAULT	"6ba7b810-9dad-11d1-80b4-00c04fd430c8"
-#define FWUPD_GUID_NAMESPACE_MICROSOFT	"70ffd812-4c7f-4c7d-0000-000000000000"
+/* 6ba7b810-9dad-11d1-80b4-00c04fd430c8 */
+static const guint8 fwupd_guid_namespace_default[16] = {
+	0x6b, 0xa7, 0xb8, 0x10, 0x9d, 0xad, 0x11, 0xd1,
+	0x80, 0xb4, 0x00, 0xc0, 0x4f, 0xd4, 0x30, 0xc8 };
+
+/* 70ffd812-4c7f-4c7d-0000-000000000000 */
+static const guint8 fwupd_guid_namespace_microsoft[16] = {
+	0x70, 0xff, 0xd8, 0x12, 0x4c, 0x7f, 0x4c, 0x7d,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
 
 typedef struct __attribute__((packed)) {
 	guint32		a;
@@ -783,28 +790,22 @@ fwupd_guid_from_string (const gchar *guidstr,
 gchar *
 fwupd_guid_hash_data (const guint8 *data, gsize datasz, FwupdGuidFlags flags)
 {
-	const gchar *namespace_id = FWUPD_GUID_NAMESPACE_DEFAULT;
+	const guint8 *uu_namespace = fwupd_guid_namespace_default;
 	gsize digestlen = 20;
 	guint8 hash[20];
-	fwupd_guid_t uu_namespace;
 	fwupd_guid_t uu_new;
 	g_autoptr(GChecksum) csum = NULL;
 
-	g_return_val_if_fail (namespace_id != NULL, NULL);
 	g_return_val_if_fail (data != NULL, NULL);
 	g_return_val_if_fail (datasz != 0, NULL);
 
-	/* old MS GUID */
+	/* old MS GUID; the namespace is always BE, not @flags */
 	if (flags & FWUPD_GUID_FLAG_NAMESPACE_MICROSOFT)
-		namespace_id = FWUPD_GUID_NAMESPACE_MICROSOFT;
-
-	/* convert the namespace to binary: hardcoded BE, not @flags */
-	if (!fwupd_guid_from_string (namespace_id, &uu_namespace, FWUPD_GUID_FLAG_NONE, NULL))
-		return NULL;
+		uu_namespace = fwupd_guid_namespace_microsoft;
 
 	/* hash the namespace and then the string */
 	csum = g_checksum_new (G_CHECKSUM_SHA1);
-	g_checksum_update (csum, (guchar *) &uu_namespace, sizeof(uu_namespace));
+	g_checksum_update (csum, uu_namespace, sizeof(fwupd_guid_t));
 	g_checksum_update (csum, (guchar *) data, (gssize) datasz);
 	g_checksum_get_digest (csum, hash, &digestlen);
 
@@ -27,6 +27,9 @@
 
 static void fwupd_device_finalize	 (GObject *object);
 
+/* devices with more than this many GUIDs or InstanceIDs use a hash set */
+#define FWUPD_DEVICE_STRV_SET_MIN		8
+
 typedef struct {
 	gchar				*id;
 	gchar				*parent_id;
@@ -34,17 +37,20 @@ typedef struct {
 	guint64				 modified;
 	guint64				 flags;
 	GPtrArray			*guids;
+	GHashTable			*guids_set;		/* nullable, keys owned by @guids */
 	GPtrArray			*instance_ids;
-	GPtrArray			*icons;
+	GHashTable			*instance_ids_set;	/* nullable, keys owned by @instance_ids */
+	GPtrArray			*icons;			/* interned */
 	gchar				*name;
 	gchar				*serial;
 	gchar				*summary;
 	gchar				*description;
-	gchar				*vendor;
-	gchar				*vendor_id;
+	GVariant			*description_variant;	/* decoded on first use */
+	const gchar			*vendor;		/* interned */
+	const gchar			*vendor_id;		/* interned */
 	gchar				*homepage;
-	gchar				*plugin;
-	gchar				*protocol;
+	const gchar			*plugin;		/* interned */
+	const gchar			*protocol;		/* interned */
 	gchar				*version;
 	gchar				*version_lowest;
 	gchar				*version_bootloader;
@@ -62,6 +68,8 @@ typedef struct {
 	FwupdStatus			 status;
 	GPtrArray			*releases;
 	FwupdDevice			*parent;
+	GVariant			*variant_cache;		/* untrusted */
+	GVariant			*variant_cache_trusted;
 } FwupdDevicePrivate;
 
 enum {
@@ -76,6 +84,26 @@ enum {
 G_DEFINE_TYPE_WITH_PRIVATE (FwupdDevice, fwupd_device, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (fwupd_device_get_instance_private (o))
 
+static void
+fwupd_device_invalidate_variant (FwupdDevice *device)
+{
+	FwupdDevicePrivate *priv = GET_PRIVATE (device);
+	g_clear_pointer (&priv->variant_cache, g_variant_unref);
+	g_clear_pointer (&priv->variant_cache_trusted, g_variant_unref);
+}
+
+/* the description can be long and is often never shown */
+static void
+fwupd_device_ensure_description (FwupdDevice *device)
+{
+	FwupdDevicePrivate *priv = GET_PRIVATE (device);
+	if (priv->description_variant == NULL)
+		return;
+	g_free (priv->description);
+	priv->description = g_variant_dup_string (priv->description_variant, NULL);
+	g_clear_pointer (&priv->description_variant, g_variant_unref);
+}
+
 /**
  * fwupd_device_get_checksums:
  * @device: A #FwupdDevice
@@ -109,6 +137,7 @@ fwupd_device_add_checksum (FwupdDevice *device, const gchar *checksum)
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
 	g_return_if_fail (checksum != NULL);
+	fwupd_device_invalidate_variant (device);
 	for (guint i = 0; i < priv->checksums->len; i++) {
 		const gchar *checksum_tmp = g_ptr_array_index (priv->checksums, i);
 		if (g_strcmp0 (checksum_tmp, checksum) == 0)
@@ -167,6 +196,7 @@ fwupd_device_set_summary (FwupdDevice *device, const gchar *summary)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	g_free (priv->summary);
 	priv->summary = g_strdup (summary);
 }
@@ -203,6 +233,7 @@ fwupd_device_set_serial (FwupdDevice *device, const gchar *serial)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	g_free (priv->serial);
 	priv->serial = g_strdup (serial);
 }
@@ -239,6 +270,7 @@ fwupd_device_set_id (FwupdDevice *device, const gchar *id)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	g_free (priv->id);
 	priv->id = g_strdup (id);
 }
@@ -275,6 +307,7 @@ fwupd_device_set_parent_id (FwupdDevice *device, const gchar *parent_id)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	g_free (priv->parent_id);
 	priv->parent_id = g_strdup (parent_id);
 }
@@ -316,6 +349,36 @@ fwupd_device_set_parent (FwupdDevice *device, FwupdDevice *parent)
 	g_ptr_array_add (priv_parent->children, g_object_ref (device));
 }
 
+/* a linear search is faster for only a few items */
+static gboolean
+fwupd_device_strv_contains (GPtrArray *array, GHashTable *set, const gchar *value)
+{
+	if (set != NULL)
+		return g_hash_table_contains (set, value);
+	for (guint i = 0; i < array->len; i++) {
+		const gchar *tmp = g_ptr_array_index (array, i);
+		if (g_strcmp0 (value, tmp) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+fwupd_device_strv_add (GPtrArray *array, GHashTable **set, const gchar *value)
+{
+	gchar *tmp = g_strdup (value);
+	g_ptr_array_add (array, tmp);
+	if (*set != NULL) {
+		g_hash_table_add (*set, tmp);
+		return;
+	}
+	if (array->len > FWUPD_DEVICE_STRV_SET_MIN) {
+		*set = g_hash_table_new (g_str_hash, g_str_equal);
+		for (guint i = 0; i < array->len; i++)
+			g_hash_table_add (*set, g_ptr_array_index (array, i));
+	}
+}
+
 /**
  * fwupd_device_get_guids:
  * @device: A #FwupdDevice
@@ -352,12 +415,9 @@ fwupd_device_has_guid (FwupdDevice *device, const gchar *guid)
 
 	g_return_val_if_fail (FWUPD_IS_DEVICE (device), FALSE);
 
-	for (guint i = 0; i < priv->guids->len; i++) {
-		const gchar *guid_tmp = g_ptr_array_index (priv->guids, i);
-		if (g_strcmp0 (guid, guid_tmp) == 0)
-			return TRUE;
-	}
-	return FALSE;
+	if (guid == NULL)
+		return FALSE;
+	return fwupd_device_strv_contains (priv->guids, priv->guids_set, guid);
 }
 
 /**
@@ -374,9 +434,10 @@ fwupd_device_add_guid (FwupdDevice *device, const gchar *guid)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	if (fwupd_device_has_guid (device, guid))
 		return;
-	g_ptr_array_add (priv->guids, g_strdup (guid));
+	fwupd_device_strv_add (priv->guids, &priv->guids_set, guid);
 }
 
 /**
@@ -435,12 +496,11 @@ fwupd_device_has_instance_id (FwupdDevice *device, const gchar *instance_id)
 
 	g_return_val_if_fail (FWUPD_IS_DEVICE (device), FALSE);
 
-	for (guint i = 0; i < priv->instance_ids->len; i++) {
-		const gchar *instance_id_tmp = g_ptr_array_index (priv->instance_ids, i);
-		if (g_strcmp0 (instance_id, instance_id_tmp) == 0)
-			return TRUE;
-	}
-	return FALSE;
+	if (instance_id == NULL)
+		return FALSE;
+	return fwupd_device_strv_contains (priv->instance_ids,
+					   priv->instance_ids_set,
+					   instance_id);
 }
 
 /**
@@ -457,9 +517,10 @@ fwupd_device_add_instance_id (FwupdDevice *device, const gchar *instance_id)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	if (fwupd_device_has_instance_id (device, instance_id))
 		return;
-	g_ptr_array_add (priv->instance_ids, g_strdup (instance_id));
+	fwupd_device_strv_add (priv->instance_ids, &priv->instance_ids_set, instance_id);
 }
 
 /**
@@ -509,9 +570,10 @@ fwupd_device_add_icon (FwupdDevice *device, const gchar *icon)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	if (fwupd_device_has_icon (device, icon))
 		return;
-	g_ptr_array_add (priv->icons, g_strdup (icon));
+	g_ptr_array_add (priv->icons, (gpointer) g_intern_string (icon));
 }
 
 /**
@@ -546,6 +608,7 @@ fwupd_device_set_name (FwupdDevice *device, const gchar *name)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	g_free (priv->name);
 	priv->name = g_strdup (name);
 }
@@ -582,8 +645,8 @@ fwupd_device_set_vendor (FwupdDevice *device, const gchar *vendor)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
-	g_free (priv->vendor);
-	priv->vendor = g_strdup (vendor);
+	fwupd_device_invalidate_variant (device);
+	priv->vendor = g_intern_string (vendor);
 }
 
 /**
@@ -618,8 +681,8 @@ fwupd_device_set_vendor_id (FwupdDevice *device, const gchar *vendor_id)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
-	g_free (priv->vendor_id);
-	priv->vendor_id = g_strdup (vendor_id);
+	fwupd_device_invalidate_variant (device);
+	priv->vendor_id = g_intern_string (vendor_id);
 }
 
 /**
@@ -637,6 +700,7 @@ fwupd_device_get_description (FwupdDevice *device)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_val_if_fail (FWUPD_IS_DEVICE (device), NULL);
+	fwupd_device_ensure_description (device);
 	return priv->description;
 }
 
@@ -654,6 +718,8 @@ fwupd_device_set_description (FwupdDevice *device, const gchar *description)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
+	g_clear_pointer (&priv->description_variant, g_variant_unref);
 	g_free (priv->description);
 	priv->description = g_strdup (description);
 }
@@ -690,6 +756,7 @@ fwupd_device_set_version (FwupdDevice *device, const gchar *version)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	g_free (priv->version);
 	priv->version = g_strdup (version);
 }
@@ -726,6 +793,7 @@ fwupd_device_set_version_lowest (FwupdDevice *device, const gchar *version_lowes
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	g_free (priv->version_lowest);
 	priv->version_lowest = g_strdup (version_lowest);
 }
@@ -762,6 +830,7 @@ fwupd_device_set_version_lowest_raw (FwupdDevice *device, guint64 version_lowest
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	priv->version_lowest_raw = version_lowest_raw;
 }
 
@@ -797,6 +866,7 @@ fwupd_device_set_version_bootloader (FwupdDevice *device, const gchar *version_b
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	g_free (priv->version_bootloader);
 	priv->version_bootloader = g_strdup (version_bootloader);
 }
@@ -833,6 +903,7 @@ fwupd_device_set_version_bootloader_raw (FwupdDevice *device, guint64 version_bo
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	priv->version_bootloader_raw = version_bootloader_raw;
 }
 
@@ -868,6 +939,7 @@ fwupd_device_set_flashes_left (FwupdDevice *device, guint32 flashes_left)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	priv->flashes_left = flashes_left;
 }
 
@@ -903,6 +975,7 @@ fwupd_device_set_install_duration (FwupdDevice *device, guint32 duration)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	priv->install_duration = duration;
 }
 
@@ -938,8 +1011,8 @@ fwupd_device_set_plugin (FwupdDevice *device, const gchar *plugin)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
-	g_free (priv->plugin);
-	priv->plugin = g_strdup (plugin);
+	fwupd_device_invalidate_variant (device);
+	priv->plugin = g_intern_string (plugin);
 }
 
 /**
@@ -974,8 +1047,8 @@ fwupd_device_set_protocol (FwupdDevice *device, const gchar *protocol)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
-	g_free (priv->protocol);
-	priv->protocol = g_strdup (protocol);
+	fwupd_device_invalidate_variant (device);
+	priv->protocol = g_intern_string (protocol);
 }
 
 /**
@@ -1010,6 +1083,7 @@ fwupd_device_set_flags (FwupdDevice *device, guint64 flags)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	if (priv->flags == flags)
 		return;
 	priv->flags = flags;
@@ -1030,6 +1104,7 @@ fwupd_device_add_flag (FwupdDevice *device, FwupdDeviceFlags flag)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	if (flag == 0)
 		return;
 	if ((priv->flags & flag) > 0)
@@ -1052,6 +1127,7 @@ fwupd_device_remove_flag (FwupdDevice *device, FwupdDeviceFlags flag)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	if (flag == 0)
 		return;
 	if ((priv->flags & flag) == 0)
@@ -1112,6 +1188,7 @@ fwupd_device_set_created (FwupdDevice *device, guint64 created)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	priv->created = created;
 }
 
@@ -1147,6 +1224,7 @@ fwupd_device_set_modified (FwupdDevice *device, guint64 modified)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	priv->modified = modified;
 }
 
@@ -1177,8 +1255,8 @@ fwupd_device_incorporate (FwupdDevice *self, FwupdDevice *donor)
 		fwupd_device_set_install_duration (self, priv_donor->install_duration);
 	if (priv->update_state == 0)
 		fwupd_device_set_update_state (self, priv_donor->update_state);
-	if (priv->description == NULL)
-		fwupd_device_set_description (self, priv_donor->description);
+	if (fwupd_device_get_description (self) == NULL)
+		fwupd_device_set_description (self, fwupd_device_get_description (donor));
 	if (priv->id == NULL)
 		fwupd_device_set_id (self, priv_donor->id);
 	if (priv->parent_id == NULL)
@@ -1256,6 +1334,7 @@ fwupd_device_to_variant_full (FwupdDevice *device, FwupdDeviceFlags flags)
 	GVariantBuilder builder;
 
 	g_return_val_if_fail (FWUPD_IS_DEVICE (device), NULL);
+	fwupd_device_ensure_description (device);
 
 	/* create an array with all the metadata in */
 	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
@@ -1429,17 +1508,51 @@ fwupd_device_to_variant_full (FwupdDevice *device, FwupdDeviceFlags flags)
 		children = g_new0 (GVariant *, priv->releases->len);
 		for (guint i = 0; i < priv->releases->len; i++) {
 			FwupdRelease *release = g_ptr_array_index (priv->releases, i);
-			children[i] = fwupd_release_to_variant (release);
+			children[i] = fwupd_release_to_variant_cached (release);
 		}
 		g_variant_builder_add (&builder, "{sv}",
 				       FWUPD_RESULT_KEY_RELEASE,
 				       g_variant_new_array (G_VARIANT_TYPE ("a{sv}"),
 							    children,
 							    priv->releases->len));
+		for (guint i = 0; i < priv->releases->len; i++)
+			g_variant_unref (children[i]);
 	}
 	return g_variant_new ("a{sv}", &builder);
 }
 
+/**
+ * fwupd_device_to_variant_cached:
+ * @device: A #FwupdDevice
+ * @flags: #FwupdDeviceFlags for the call
+ *
+ * Gets a GVariant from the device data, reusing the previous result if the
+ * device has not been modified since. The returned value is shared between
+ * callers and must not be modified.
+ *
+ * Returns: (transfer full): the GVariant, or %NULL for error
+ *
+ * Since: 1.5.0
+ **/
+GVariant *
+fwupd_device_to_variant_cached (FwupdDevice *device, FwupdDeviceFlags flags)
+{
+	FwupdDevicePrivate *priv = GET_PRIVATE (device);
+	GVariant **cache;
+
+	g_return_val_if_fail (FWUPD_IS_DEVICE (device), NULL);
+
+	/* releases can be modified without the device knowing */
+	if (priv->releases->len > 0)
+		return g_variant_ref_sink (fwupd_device_to_variant_full (device, flags));
+
+	cache = (flags & FWUPD_DEVICE_FLAG_TRUSTED) ? &priv->variant_cache_trusted :
+						      &priv->variant_cache;
+	if (*cache == NULL)
+		*cache = g_variant_ref_sink (fwupd_device_to_variant_full (device, flags));
+	return g_variant_ref (*cache);
+}
+
 /**
  * fwupd_device_to_variant:
  * @device: A #FwupdDevice
@@ -1459,6 +1572,7 @@ fwupd_device_to_variant (FwupdDevice *device)
 static void
 fwupd_device_from_key_value (FwupdDevice *device, const gchar *key, GVariant *value)
 {
+	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	if (g_strcmp0 (key, FWUPD_RESULT_KEY_RELEASE) == 0) {
 		GVariantIter iter;
 		GVariant *child;
@@ -1530,7 +1644,8 @@ fwupd_device_from_key_value (FwupdDevice *device, const gchar *key, GVariant *va
 		return;
 	}
 	if (g_strcmp0 (key, FWUPD_RESULT_KEY_DESCRIPTION) == 0) {
-		fwupd_device_set_description (device, g_variant_get_string (value, NULL));
+		fwupd_device_set_description (device, NULL);
+		priv->description_variant = g_variant_ref (value);
 		return;
 	}
 	if (g_strcmp0 (key, FWUPD_RESULT_KEY_CHECKSUM) == 0) {
@@ -1693,6 +1808,7 @@ fwupd_device_set_update_state (FwupdDevice *device, FwupdUpdateState update_stat
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	priv->update_state = update_state;
 }
 
@@ -1728,6 +1844,7 @@ fwupd_device_set_version_format (FwupdDevice *device, FwupdVersionFormat version
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	priv->version_format = version_format;
 }
 
@@ -1763,6 +1880,7 @@ fwupd_device_set_version_raw (FwupdDevice *device, guint64 version_raw)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	priv->version_raw = version_raw;
 }
 
@@ -1798,6 +1916,7 @@ fwupd_device_set_update_message (FwupdDevice *device, const gchar *update_messag
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	g_free (priv->update_message);
 	priv->update_message = g_strdup (update_message);
 }
@@ -1834,6 +1953,7 @@ fwupd_device_set_update_error (FwupdDevice *device, const gchar *update_error)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	g_free (priv->update_error);
 	priv->update_error = g_strdup (update_error);
 }
@@ -1890,6 +2010,7 @@ fwupd_device_add_release (FwupdDevice *device, FwupdRelease *release)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_invalidate_variant (device);
 	g_ptr_array_add (priv->releases, g_object_ref (release));
 }
 /**
@@ -1924,6 +2045,7 @@ fwupd_device_set_status (FwupdDevice *self, FwupdStatus status)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (self);
 	g_return_if_fail (FWUPD_IS_DEVICE (self));
+	fwupd_device_invalidate_variant (self);
 	if (priv->status == status)
 		return;
 	priv->status = status;
@@ -1972,6 +2094,7 @@ fwupd_device_to_json (FwupdDevice *device, JsonBuilder *builder)
 
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
 	g_return_if_fail (builder != NULL);
+	fwupd_device_ensure_description (device);
 
 	fwupd_device_json_add_string (builder, FWUPD_RESULT_KEY_NAME, priv->name);
 	fwupd_device_json_add_string (builder, FWUPD_RESULT_KEY_DEVICE_ID, priv->id);
@@ -2083,6 +2206,7 @@ fwupd_device_to_string (FwupdDevice *device)
 	GString *str;
 
 	g_return_val_if_fail (FWUPD_IS_DEVICE (device), NULL);
+	fwupd_device_ensure_description (device);
 
 	str = g_string_new ("");
 	if (priv->name != NULL)
@@ -2274,7 +2398,7 @@ fwupd_device_init (FwupdDevice *device)
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	priv->guids = g_ptr_array_new_with_free_func (g_free);
 	priv->instance_ids = g_ptr_array_new_with_free_func (g_free);
-	priv->icons = g_ptr_array_new_with_free_func (g_free);
+	priv->icons = g_ptr_array_new ();
 	priv->checksums = g_ptr_array_new_with_free_func (g_free);
 	priv->children = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->releases = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
@@ -2289,26 +2413,32 @@ fwupd_device_finalize (GObject *object)
 	if (priv->parent != NULL)
 		g_object_unref (priv->parent);
 	g_free (priv->description);
+	if (priv->description_variant != NULL)
+		g_variant_unref (priv->description_variant);
 	g_free (priv->id);
 	g_free (priv->parent_id);
 	g_free (priv->name);
 	g_free (priv->serial);
 	g_free (priv->summary);
-	g_free (priv->vendor);
-	g_free (priv->vendor_id);
-	g_free (priv->plugin);
-	g_free (priv->protocol);
 	g_free (priv->update_error);
 	g_free (priv->update_message);
 	g_free (priv->version);
 	g_free (priv->version_lowest);
 	g_free (priv->version_bootloader);
+	if (priv->guids_set != NULL)
+		g_hash_table_unref (priv->guids_set);
+	if (priv->instance_ids_set != NULL)
+		g_hash_table_unref (priv->instance_ids_set);
 	g_ptr_array_unref (priv->guids);
 	g_ptr_array_unref (priv->instance_ids);
 	g_ptr_array_unref (priv->icons);
 	g_ptr_array_unref (priv->checksums);
 	g_ptr_array_unref (priv->children);
 	g_ptr_array_unref (priv->releases);
+	if (priv->variant_cache != NULL)
+		g_variant_unref (priv->variant_cache);
+	if (priv->variant_cache_trusted != NULL)
+		g_variant_unref (priv->variant_cache_trusted);
 
 	G_OBJECT_CLASS (fwupd_device_parent_class)->finalize (object);
 }
@@ -197,6 +197,8 @@ fwupd_device_flag_to_string (FwupdDeviceFlags device_flag)
 		return "updatable-hidden";
 	if (device_flag == FWUPD_DEVICE_FLAG_SKIPS_RESTART)
 		return "skips-restart";
+	if (device_flag == FWUPD_DEVICE_FLAG_SETUP_ON_DEMAND)
+		return "setup-on-demand";
 	if (device_flag == FWUPD_DEVICE_FLAG_UNKNOWN)
 		return "unknown";
 	return NULL;
@@ -295,6 +297,8 @@ fwupd_device_flag_from_string (const gchar *device_flag)
 		return FWUPD_DEVICE_FLAG_UPDATABLE_HIDDEN;
 	if (g_strcmp0 (device_flag, "skips-restart") == 0)
 		return FWUPD_DEVICE_FLAG_SKIPS_RESTART;
+	if (g_strcmp0 (device_flag, "setup-on-demand") == 0)
+		return FWUPD_DEVICE_FLAG_SETUP_ON_DEMAND;
 	return FWUPD_DEVICE_FLAG_UNKNOWN;
 }
 
@@ -34,6 +34,7 @@ typedef struct {
 	GPtrArray			*issues;
 	GHashTable			*metadata;
 	gchar				*description;
+	GVariant			*description_variant;	/* decoded on first use */
 	gchar				*filename;
 	gchar				*protocol;
 	gchar				*homepage;
@@ -56,11 +57,31 @@ typedef struct {
 	FwupdReleaseFlags		 flags;
 	FwupdReleaseUrgency		 urgency;
 	gchar				*update_message;
+	GVariant			*variant_cache;
 } FwupdReleasePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (FwupdRelease, fwupd_release, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (fwupd_release_get_instance_private (o))
 
+static void
+fwupd_release_invalidate_variant (FwupdRelease *release)
+{
+	FwupdReleasePrivate *priv = GET_PRIVATE (release);
+	g_clear_pointer (&priv->variant_cache, g_variant_unref);
+}
+
+/* the description can be long and is often never shown */
+static void
+fwupd_release_ensure_description (FwupdRelease *release)
+{
+	FwupdReleasePrivate *priv = GET_PRIVATE (release);
+	if (priv->description_variant == NULL)
+		return;
+	g_free (priv->description);
+	priv->description = g_variant_dup_string (priv->description_variant, NULL);
+	g_clear_pointer (&priv->description_variant, g_variant_unref);
+}
+
 /* the deprecated fwupd_release_get_trust_flags() function should only
  * return the last two bits of the #FwupdReleaseFlags */
 #define FWUPD_RELEASE_TRUST_FLAGS_MASK		0x3
@@ -97,6 +118,7 @@ fwupd_release_set_remote_id (FwupdRelease *release, const gchar *remote_id)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->remote_id);
 	priv->remote_id = g_strdup (remote_id);
 }
@@ -133,6 +155,7 @@ fwupd_release_set_version (FwupdRelease *release, const gchar *version)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->version);
 	priv->version = g_strdup (version);
 }
@@ -169,6 +192,7 @@ fwupd_release_set_filename (FwupdRelease *release, const gchar *filename)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->filename);
 	priv->filename = g_strdup (filename);
 }
@@ -205,6 +229,7 @@ fwupd_release_set_update_message (FwupdRelease *release, const gchar *update_mes
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->update_message);
 	priv->update_message = g_strdup (update_message);
 }
@@ -241,6 +266,7 @@ fwupd_release_set_protocol (FwupdRelease *release, const gchar *protocol)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->protocol);
 	priv->protocol = g_strdup (protocol);
 }
@@ -278,6 +304,7 @@ fwupd_release_add_issue (FwupdRelease *release, const gchar *issue)
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
 	g_return_if_fail (issue != NULL);
+	fwupd_release_invalidate_variant (release);
 	for (guint i = 0; i < priv->issues->len; i++) {
 		const gchar *issue_tmp = g_ptr_array_index (priv->issues, i);
 		if (g_strcmp0 (issue_tmp, issue) == 0)
@@ -319,6 +346,7 @@ fwupd_release_add_category (FwupdRelease *release, const gchar *category)
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
 	g_return_if_fail (category != NULL);
+	fwupd_release_invalidate_variant (release);
 	for (guint i = 0; i < priv->categories->len; i++) {
 		const gchar *category_tmp = g_ptr_array_index (priv->categories, i);
 		if (g_strcmp0 (category_tmp, category) == 0)
@@ -385,6 +413,7 @@ fwupd_release_add_checksum (FwupdRelease *release, const gchar *checksum)
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
 	g_return_if_fail (checksum != NULL);
+	fwupd_release_invalidate_variant (release);
 	for (guint i = 0; i < priv->checksums->len; i++) {
 		const gchar *checksum_tmp = g_ptr_array_index (priv->checksums, i);
 		if (g_strcmp0 (checksum_tmp, checksum) == 0)
@@ -453,6 +482,7 @@ fwupd_release_add_metadata_item (FwupdRelease *release, const gchar *key, const
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
 	g_return_if_fail (key != NULL);
 	g_return_if_fail (value != NULL);
+	fwupd_release_invalidate_variant (release);
 	g_hash_table_insert (priv->metadata, g_strdup (key), g_strdup (value));
 }
 
@@ -469,6 +499,7 @@ void
 fwupd_release_add_metadata (FwupdRelease *release, GHashTable *hash)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
+	fwupd_release_invalidate_variant (release);
 	g_autoptr(GList) keys = NULL;
 
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
@@ -535,6 +566,7 @@ fwupd_release_set_uri (FwupdRelease *release, const gchar *uri)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->uri);
 	priv->uri = g_strdup (uri);
 }
@@ -571,6 +603,7 @@ fwupd_release_set_homepage (FwupdRelease *release, const gchar *homepage)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->homepage);
 	priv->homepage = g_strdup (homepage);
 }
@@ -607,6 +640,7 @@ fwupd_release_set_details_url (FwupdRelease *release, const gchar *details_url)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->details_url);
 	priv->details_url = g_strdup (details_url);
 }
@@ -643,6 +677,7 @@ fwupd_release_set_source_url (FwupdRelease *release, const gchar *source_url)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->source_url);
 	priv->source_url = g_strdup (source_url);
 }
@@ -662,6 +697,7 @@ fwupd_release_get_description (FwupdRelease *release)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_val_if_fail (FWUPD_IS_RELEASE (release), NULL);
+	fwupd_release_ensure_description (release);
 	return priv->description;
 }
 
@@ -679,6 +715,8 @@ fwupd_release_set_description (FwupdRelease *release, const gchar *description)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
+	g_clear_pointer (&priv->description_variant, g_variant_unref);
 	g_free (priv->description);
 	priv->description = g_strdup (description);
 }
@@ -715,6 +753,7 @@ fwupd_release_set_appstream_id (FwupdRelease *release, const gchar *appstream_id
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->appstream_id);
 	priv->appstream_id = g_strdup (appstream_id);
 }
@@ -751,6 +790,7 @@ fwupd_release_set_detach_caption (FwupdRelease *release, const gchar *detach_cap
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->detach_caption);
 	priv->detach_caption = g_strdup (detach_caption);
 }
@@ -787,6 +827,7 @@ fwupd_release_set_detach_image (FwupdRelease *release, const gchar *detach_image
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->detach_image);
 	priv->detach_image = g_strdup (detach_image);
 }
@@ -823,6 +864,7 @@ fwupd_release_set_size (FwupdRelease *release, guint64 size)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	priv->size = size;
 }
 
@@ -858,6 +900,7 @@ fwupd_release_set_created (FwupdRelease *release, guint64 created)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	priv->created = created;
 }
 
@@ -893,6 +936,7 @@ fwupd_release_set_summary (FwupdRelease *release, const gchar *summary)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->summary);
 	priv->summary = g_strdup (summary);
 }
@@ -929,6 +973,7 @@ fwupd_release_set_vendor (FwupdRelease *release, const gchar *vendor)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->vendor);
 	priv->vendor = g_strdup (vendor);
 }
@@ -965,6 +1010,7 @@ fwupd_release_set_license (FwupdRelease *release, const gchar *license)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->license);
 	priv->license = g_strdup (license);
 }
@@ -1001,6 +1047,7 @@ fwupd_release_set_name (FwupdRelease *release, const gchar *name)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->name);
 	priv->name = g_strdup (name);
 }
@@ -1037,6 +1084,7 @@ fwupd_release_set_name_variant_suffix (FwupdRelease *release, const gchar *name_
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	g_free (priv->name_variant_suffix);
 	priv->name_variant_suffix = g_strdup (name_variant_suffix);
 }
@@ -1073,6 +1121,7 @@ fwupd_release_set_trust_flags (FwupdRelease *release, FwupdTrustFlags trust_flag
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 
 	/* only overwrite the last two bits of the flags */
 	priv->flags &= ~FWUPD_RELEASE_TRUST_FLAGS_MASK;
@@ -1111,6 +1160,7 @@ fwupd_release_set_flags (FwupdRelease *release, FwupdReleaseFlags flags)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	priv->flags = flags;
 }
 
@@ -1128,6 +1178,7 @@ fwupd_release_add_flag (FwupdRelease *release, FwupdReleaseFlags flag)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	priv->flags |= flag;
 }
 
@@ -1145,6 +1196,7 @@ fwupd_release_remove_flag (FwupdRelease *release, FwupdReleaseFlags flag)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	priv->flags &= ~flag;
 }
 
@@ -1199,6 +1251,7 @@ fwupd_release_set_urgency (FwupdRelease *release, FwupdReleaseUrgency urgency)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	priv->urgency = urgency;
 }
 
@@ -1234,6 +1287,7 @@ fwupd_release_set_install_duration (FwupdRelease *release, guint32 duration)
 {
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
+	fwupd_release_invalidate_variant (release);
 	priv->install_duration = duration;
 }
 
@@ -1281,6 +1335,7 @@ fwupd_release_to_variant (FwupdRelease *release)
 	GVariantBuilder builder;
 
 	g_return_val_if_fail (FWUPD_IS_RELEASE (release), NULL);
+	fwupd_release_ensure_description (release);
 
 	/* create an array with all the metadata in */
 	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
@@ -1430,6 +1485,28 @@ fwupd_release_to_variant (FwupdRelease *release)
 	return g_variant_new ("a{sv}", &builder);
 }
 
+/**
+ * fwupd_release_to_variant_cached:
+ * @release: A #FwupdRelease
+ *
+ * Gets a GVariant from the release data, reusing the previous result if the
+ * release has not been modified since. The returned value is shared between
+ * callers and must not be modified.
+ *
+ * Returns: (transfer full): the GVariant, or %NULL for error
+ *
+ * Since: 1.5.0
+ **/
+GVariant *
+fwupd_release_to_variant_cached (FwupdRelease *release)
+{
+	FwupdReleasePrivate *priv = GET_PRIVATE (release);
+	g_return_val_if_fail (FWUPD_IS_RELEASE (release), NULL);
+	if (priv->variant_cache == NULL)
+		priv->variant_cache = g_variant_ref_sink (fwupd_release_to_variant (release));
+	return g_variant_ref (priv->variant_cache);
+}
+
 static void
 fwupd_release_from_key_value (FwupdRelease *release, const gchar *key, GVariant *value)
 {
@@ -1483,7 +1560,8 @@ fwupd_release_from_key_value (FwupdRelease *release, const gchar *key, GVariant
 		return;
 	}
 	if (g_strcmp0 (key, FWUPD_RESULT_KEY_DESCRIPTION) == 0) {
-		fwupd_release_set_description (release, g_variant_get_string (value, NULL));
+		fwupd_release_set_description (release, NULL);
+		priv->description_variant = g_variant_ref (value);
 		return;
 	}
 	if (g_strcmp0 (key, FWUPD_RESULT_KEY_CATEGORIES) == 0) {
@@ -1641,6 +1719,7 @@ fwupd_release_to_json (FwupdRelease *release, JsonBuilder *builder)
 
 	g_return_if_fail (FWUPD_IS_RELEASE (release));
 	g_return_if_fail (builder != NULL);
+	fwupd_release_ensure_description (release);
 
 	fwupd_release_json_add_string (builder, FWUPD_RESULT_KEY_APPSTREAM_ID, priv->appstream_id);
 	fwupd_release_json_add_string (builder, FWUPD_RESULT_KEY_REMOTE_ID, priv->remote_id);
@@ -1728,6 +1807,7 @@ fwupd_release_to_string (FwupdRelease *release)
 	g_autoptr(GList) keys = NULL;
 
 	g_return_val_if_fail (FWUPD_IS_RELEASE (release), NULL);
+	fwupd_release_ensure_description (release);
 
 	str = g_string_new ("");
 	fwupd_pad_kv_str (str, FWUPD_RESULT_KEY_APPSTREAM_ID, priv->appstream_id);
@@ -1803,6 +1883,8 @@ fwupd_release_finalize (GObject *object)
 	FwupdReleasePrivate *priv = GET_PRIVATE (release);
 
 	g_free (priv->description);
+	if (priv->description_variant != NULL)
+		g_variant_unref (priv->description_variant);
 	g_free (priv->filename);
 	g_free (priv->protocol);
 	g_free (priv->appstream_id);
@@ -1824,6 +1906,8 @@ fwupd_release_finalize (GObject *object)
 	g_ptr_array_unref (priv->issues);
 	g_ptr_array_unref (priv->checksums);
 	g_hash_table_unref (priv->metadata);
+	if (priv->variant_cache != NULL)
+		g_variant_unref (priv->variant_cache);
 
 	G_OBJECT_CLASS (fwupd_release_parent_class)->finalize (object);
 }
@@ -6,6 +6,7 @@
 
 #include "config.h"
 
+#include <string.h>
 #include <libsoup/soup.h>
 #include <jcat.h>
 
@@ -34,6 +35,8 @@ typedef struct {
 	gchar			*report_uri;
 	gchar			*metadata_uri;
 	gchar			*metadata_uri_sig;
+	gchar			*metadata_checksum;
+	GHashTable		*metadata_deltas;	/* base checksum:URI */
 	gchar			*username;
 	gchar			*password;
 	gchar			*title;
@@ -917,7 +920,10 @@ fwupd_remote_load_signature (FwupdRemote *self, const gchar *filename, GError **
 	g_autofree gchar *basename = NULL;
 	g_autofree gchar *baseuri = NULL;
 	g_autofree gchar *metadata_uri = NULL;
+	g_autofree gchar *delta_prefix = NULL;
 	g_autoptr(GFile) gfile = NULL;
+	g_autoptr(GPtrArray) blobs = NULL;
+	g_autoptr(GPtrArray) items = NULL;
 	g_autoptr(JcatFile) jcat_file = jcat_file_new ();
 	g_autoptr(JcatItem) jcat_item = NULL;
 
@@ -949,8 +955,37 @@ fwupd_remote_load_signature (FwupdRemote *self, const gchar *filename, GError **
 		return FALSE;
 	}
 
-	/* replace the URI if required */
+	/* the signed checksum of the metadata, used to verify a delta */
+	g_clear_pointer (&priv->metadata_checksum, g_free);
+	blobs = jcat_item_get_blobs_by_kind (jcat_item, JCAT_BLOB_KIND_SHA256);
+	if (blobs->len > 0) {
+		JcatBlob *blob = g_ptr_array_index (blobs, 0);
+		priv->metadata_checksum = jcat_blob_get_data_as_string (blob);
+	}
+
+	/* any deltas from older metadata are items named $ID.$CHECKSUM.delta */
 	baseuri = g_path_get_dirname (priv->metadata_uri);
+	g_hash_table_remove_all (priv->metadata_deltas);
+	delta_prefix = g_strdup_printf ("%s.", id);
+	items = jcat_file_get_items (jcat_file);
+	for (guint i = 0; i < items->len; i++) {
+		JcatItem *item = g_ptr_array_index (items, i);
+		const gchar *item_id = jcat_item_get_id (item);
+		g_autofree gchar *checksum = NULL;
+		if (item_id == NULL ||
+		    !g_str_has_prefix (item_id, delta_prefix) ||
+		    !g_str_has_suffix (item_id, ".delta"))
+			continue;
+		checksum = g_strndup (item_id + strlen (delta_prefix),
+				      strlen (item_id) - strlen (delta_prefix) - strlen (".delta"));
+		if (checksum[0] == '\0')
+			continue;
+		g_hash_table_insert (priv->metadata_deltas,
+				     g_steal_pointer (&checksum),
+				     g_build_filename (baseuri, item_id, NULL));
+	}
+
+	/* replace the URI if required */
 	metadata_uri = g_build_filename (baseuri, id, NULL);
 	if (g_strcmp0 (metadata_uri, priv->metadata_uri) != 0) {
 		g_debug ("changing metadata URI from %s to %s",
@@ -963,6 +998,47 @@ fwupd_remote_load_signature (FwupdRemote *self, const gchar *filename, GError **
 	return TRUE;
 }
 
+/**
+ * fwupd_remote_get_metadata_checksum:
+ * @self: A #FwupdRemote
+ *
+ * Gets the SHA256 checksum of the metadata from the signature, which is
+ * only set after fwupd_remote_load_signature() has been called.
+ *
+ * Returns: (transfer none): a checksum, or %NULL for unset.
+ *
+ * Since: 1.5.0
+ **/
+const gchar *
+fwupd_remote_get_metadata_checksum (FwupdRemote *self)
+{
+	FwupdRemotePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FWUPD_IS_REMOTE (self), NULL);
+	return priv->metadata_checksum;
+}
+
+/**
+ * fwupd_remote_get_metadata_delta_uri:
+ * @self: A #FwupdRemote
+ * @checksum: the SHA256 checksum of the metadata already downloaded
+ *
+ * Gets the URI of a delta that converts the older metadata into the metadata
+ * described by the signature, which is only set after
+ * fwupd_remote_load_signature() has been called.
+ *
+ * Returns: (transfer none): a URI, or %NULL if no delta is available.
+ *
+ * Since: 1.5.0
+ **/
+const gchar *
+fwupd_remote_get_metadata_delta_uri (FwupdRemote *self, const gchar *checksum)
+{
+	FwupdRemotePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FWUPD_IS_REMOTE (self), NULL);
+	g_return_val_if_fail (checksum != NULL, NULL);
+	return g_hash_table_lookup (priv->metadata_deltas, checksum);
+}
+
 /**
  * fwupd_remote_get_metadata_uri_sig:
  * @self: A #FwupdRemote
@@ -1331,6 +1407,9 @@ fwupd_remote_class_init (FwupdRemoteClass *klass)
 static void
 fwupd_remote_init (FwupdRemote *self)
 {
+	FwupdRemotePrivate *priv = GET_PRIVATE (self);
+	priv->metadata_deltas = g_hash_table_new_full (g_str_hash, g_str_equal,
+						       g_free, g_free);
 }
 
 static void
@@ -1342,6 +1421,8 @@ fwupd_remote_finalize (GObject *obj)
 	g_free (priv->id);
 	g_free (priv->metadata_uri);
 	g_free (priv->metadata_uri_sig);
+	g_free (priv->metadata_checksum);
+	g_hash_table_unref (priv->metadata_deltas);
 	g_free (priv->firmware_base_uri);
 	g_free (priv->report_uri);
 	g_free (priv->username);
@@ -62,6 +62,9 @@ const gchar	*fwupd_remote_get_firmware_base_uri	(FwupdRemote	*self);
 const gchar	*fwupd_remote_get_report_uri		(FwupdRemote	*self);
 const gchar	*fwupd_remote_get_metadata_uri		(FwupdRemote	*self);
 const gchar	*fwupd_remote_get_metadata_uri_sig	(FwupdRemote	*self);
+const gchar	*fwupd_remote_get_metadata_checksum	(FwupdRemote	*self);
+const gchar	*fwupd_remote_get_metadata_delta_uri	(FwupdRemote	*self,
+							 const gchar	*checksum);
 gboolean	 fwupd_remote_get_enabled		(FwupdRemote	*self);
 gboolean	 fwupd_remote_get_approval_required	(FwupdRemote	*self);
 gboolean	 fwupd_remote_get_automatic_reports	(FwupdRemote	*self);
@@ -298,10 +298,43 @@ fwupd_release_func (void)
 	release1 = fwupd_release_new ();
 	fwupd_release_add_metadata_item (release1, "foo", "bar");
 	fwupd_release_add_metadata_item (release1, "baz", "bam");
+	fwupd_release_set_description (release1, "<p>Fixes bugs</p>");
 	data = fwupd_release_to_variant (release1);
 	release2 = fwupd_release_from_variant (data);
 	g_assert_cmpstr (fwupd_release_get_metadata_item (release2, "foo"), ==, "bar");
 	g_assert_cmpstr (fwupd_release_get_metadata_item (release2, "baz"), ==, "bam");
+	g_assert_cmpstr (fwupd_release_get_description (release2), ==, "<p>Fixes bugs</p>");
+}
+
+static void
+fwupd_device_variant_cached_func (void)
+{
+	g_autoptr(FwupdDevice) dev = fwupd_device_new ();
+	g_autoptr(FwupdDevice) dev2 = NULL;
+	g_autoptr(GVariant) data1 = NULL;
+	g_autoptr(GVariant) data2 = NULL;
+	g_autoptr(GVariant) data3 = NULL;
+	g_autoptr(GVariant) data4 = NULL;
+
+	fwupd_device_set_id (dev, "USB:foo");
+	fwupd_device_set_serial (dev, "1234");
+
+	/* reused when unchanged */
+	data1 = fwupd_device_to_variant_cached (dev, FWUPD_DEVICE_FLAG_NONE);
+	data2 = fwupd_device_to_variant_cached (dev, FWUPD_DEVICE_FLAG_NONE);
+	g_assert (data1 == data2);
+
+	/* trusted callers get a different variant */
+	data3 = fwupd_device_to_variant_cached (dev, FWUPD_DEVICE_FLAG_TRUSTED);
+	g_assert (data3 != data1);
+
+	/* invalidated by a setter */
+	fwupd_device_set_name (dev, "ColorHug2");
+	data4 = fwupd_device_to_variant_cached (dev, FWUPD_DEVICE_FLAG_NONE);
+	g_assert (data4 != data1);
+	dev2 = fwupd_device_from_variant (data4);
+	g_assert_cmpstr (fwupd_device_get_name (dev2), ==, "ColorHug2");
+	g_assert_cmpstr (fwupd_device_get_serial (dev2), ==, NULL);
 }
 
 static void
@@ -665,6 +698,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/fwupd/common{guid}", fwupd_common_guid_func);
 	g_test_add_func ("/fwupd/release", fwupd_release_func);
 	g_test_add_func ("/fwupd/device", fwupd_device_func);
+	g_test_add_func ("/fwupd/device{variant-cached}", fwupd_device_variant_cached_func);
 	g_test_add_func ("/fwupd/remote{download}", fwupd_remote_download_func);
 	g_test_add_func ("/fwupd/remote{base-uri}", fwupd_remote_baseuri_func);
 	g_test_add_func ("/fwupd/remote{no-path}", fwupd_remote_nopath_func);
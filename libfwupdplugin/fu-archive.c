@@ -128,9 +128,14 @@ _archive_read_ctx_free (_archive_read_ctx *arch)
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(_archive_read_ctx, _archive_read_ctx_free)
 
 static gboolean
-fu_archive_load (FuArchive *self, GBytes *blob, FuArchiveFlags flags, GError **error)
+fu_archive_load (FuArchive *self,
+		 GBytes *blob,
+		 FuArchiveFlags flags,
+		 gchar **filenames,
+		 GError **error)
 {
 	int r;
+	guint filenames_remaining = filenames != NULL ? g_strv_length (filenames) : 0;
 	g_autoptr(_archive_read_ctx) arch = NULL;
 
 	/* decompress anything matching either glob */
@@ -179,6 +184,21 @@ fu_archive_load (FuArchive *self, GBytes *blob, FuArchiveFlags flags, GError **e
 		fn = archive_entry_pathname (entry);
 		if (fn == NULL)
 			continue;
+		if (flags & FU_ARCHIVE_FLAG_IGNORE_PATH) {
+			fn_key = g_path_get_basename (fn);
+		} else {
+			fn_key = g_strdup (fn);
+		}
+
+		/* skip without decompressing */
+		if (filenames != NULL) {
+			if (!g_strv_contains ((const gchar * const *) filenames, fn_key) ||
+			    g_hash_table_contains (self->entries, fn_key)) {
+				archive_read_data_skip (arch);
+				continue;
+			}
+			filenames_remaining--;
+		}
 		bufsz = archive_entry_size (entry);
 		if (bufsz > 1024 * 1024 * 1024) {
 			g_set_error_literal (error,
@@ -205,15 +225,14 @@ fu_archive_load (FuArchive *self, GBytes *blob, FuArchiveFlags flags, GError **e
 				     rc, bufsz);
 			return FALSE;
 		}
-		if (flags & FU_ARCHIVE_FLAG_IGNORE_PATH) {
-			fn_key = g_path_get_basename (fn);
-		} else {
-			fn_key = g_strdup (fn);
-		}
 		g_debug ("adding %s [%" G_GINT64_FORMAT "]", fn_key, bufsz);
 		g_hash_table_insert (self->entries,
 				     g_steal_pointer (&fn_key),
 				     g_bytes_new_take (g_steal_pointer (&buf), bufsz));
+
+		/* no need to read the rest of the archive */
+		if (filenames != NULL && filenames_remaining == 0)
+			break;
 	}
 
 	/* success */
@@ -238,7 +257,40 @@ fu_archive_new (GBytes *data, FuArchiveFlags flags, GError **error)
 	g_autoptr(FuArchive) self = g_object_new (FU_TYPE_ARCHIVE, NULL);
 	g_return_val_if_fail (data != NULL, NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
-	if (!fu_archive_load (self, data, flags, error))
+	if (!fu_archive_load (self, data, flags, NULL, error))
+		return NULL;
+	return g_steal_pointer (&self);
+}
+
+/**
+ * fu_archive_new_for_filenames:
+ * @data: A #GBytes
+ * @flags: A #FuArchiveFlags, e.g. %FU_ARCHIVE_FLAG_NONE
+ * @filenames: (array zero-terminated=1): the filenames to decompress
+ * @error: A #GError, or %NULL
+ *
+ * Parses @data as an archive and decompresses only the named files to memory
+ * blobs. The other entries are skipped without being decompressed, and the
+ * archive is not read any further once all the files have been found.
+ *
+ * Filenames not found in the archive are not an error, and instead
+ * fu_archive_lookup_by_fn() will fail.
+ *
+ * Returns: a #FuArchive, or %NULL if the archive was invalid in any way.
+ *
+ * Since: 1.5.0
+ **/
+FuArchive *
+fu_archive_new_for_filenames (GBytes *data,
+			      FuArchiveFlags flags,
+			      gchar **filenames,
+			      GError **error)
+{
+	g_autoptr(FuArchive) self = g_object_new (FU_TYPE_ARCHIVE, NULL);
+	g_return_val_if_fail (data != NULL, NULL);
+	g_return_val_if_fail (filenames != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	if (!fu_archive_load (self, data, flags, filenames, error))
 		return NULL;
 	return g_steal_pointer (&self);
 }
@@ -44,6 +44,10 @@ typedef gboolean (*FuArchiveIterateFunc)	(FuArchive		*self,
 FuArchive	*fu_archive_new			(GBytes		*data,
 						 FuArchiveFlags	 flags,
 						 GError		**error);
+FuArchive	*fu_archive_new_for_filenames	(GBytes		*data,
+						 FuArchiveFlags	 flags,
+						 gchar		**filenames,
+						 GError		**error);
 GBytes		*fu_archive_lookup_by_fn	(FuArchive	*self,
 						 const gchar	*fn,
 						 GError		**error);
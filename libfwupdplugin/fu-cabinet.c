@@ -13,19 +13,25 @@
 
 #include "fu-cabinet.h"
 #include "fu-common.h"
+#include "fu-timeline-private.h"
 
 #include "fwupd-enums.h"
 #include "fwupd-error.h"
 
+#define FU_CABINET_CHECKSUM_JOBS_MAX		8
+
 struct _FuCabinet {
 	GObject			 parent_instance;
 	guint64			 size_max;
 	GCabCabinet		*gcab_cabinet;
 	gchar			*container_checksum;
+	GHashTable		*payload_checksums;	/* basename:SHA1 */
 	XbBuilder		*builder;
 	XbSilo			*silo;
 	JcatContext		*jcat_context;
+	FuWorkerPool		*worker_pool;
 	JcatFile		*jcat_file;
+	gchar			*tmpdir;	/* only set when streaming */
 };
 
 G_DEFINE_TYPE (FuCabinet, fu_cabinet, G_TYPE_OBJECT)
@@ -34,13 +40,22 @@ static void
 fu_cabinet_finalize (GObject *obj)
 {
 	FuCabinet *self = FU_CABINET (obj);
+	if (self->tmpdir != NULL) {
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_common_rmtree (self->tmpdir, &error_local))
+			g_warning ("failed to remove %s: %s", self->tmpdir, error_local->message);
+		g_free (self->tmpdir);
+	}
 	if (self->silo != NULL)
 		g_object_unref (self->silo);
 	if (self->builder != NULL)
 		g_object_unref (self->builder);
 	g_free (self->container_checksum);
+	g_hash_table_unref (self->payload_checksums);
 	g_object_unref (self->gcab_cabinet);
 	g_object_unref (self->jcat_context);
+	if (self->worker_pool != NULL)
+		g_object_unref (self->worker_pool);
 	g_object_unref (self->jcat_file);
 	G_OBJECT_CLASS (fu_cabinet_parent_class)->finalize (obj);
 }
@@ -57,6 +72,8 @@ fu_cabinet_init (FuCabinet *self)
 {
 	self->size_max = 1024 * 1024 * 100;
 	self->gcab_cabinet = gcab_cabinet_new ();
+	self->payload_checksums = g_hash_table_new_full (g_str_hash, g_str_equal,
+							 g_free, g_free);
 	self->builder = xb_builder_new ();
 	self->jcat_file = jcat_file_new ();
 	self->jcat_context = jcat_context_new ();
@@ -96,6 +113,102 @@ fu_cabinet_set_jcat_context (FuCabinet *self, JcatContext *jcat_context)
 	g_set_object (&self->jcat_context, jcat_context);
 }
 
+/**
+ * fu_cabinet_set_worker_pool: (skip):
+ * @self: A #FuCabinet
+ * @worker_pool: (nullable): A #FuWorkerPool
+ *
+ * Sets the worker pool used for checksumming the payloads. If not set then
+ * a pool is created just for parsing the archive.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_cabinet_set_worker_pool (FuCabinet *self, FuWorkerPool *worker_pool)
+{
+	g_return_if_fail (FU_IS_CABINET (self));
+	g_return_if_fail (worker_pool == NULL || FU_IS_WORKER_POOL (worker_pool));
+	g_set_object (&self->worker_pool, worker_pool);
+}
+
+/**
+ * fu_cabinet_jcat_verify_item: (skip):
+ * @jcat_context: A #JcatContext
+ * @blob: A #GBytes
+ * @item: A #JcatItem
+ * @flags: A #JcatVerifyFlags, e.g. %JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE
+ * @error: A #GError, or %NULL
+ *
+ * Verifies @blob using the signatures in @item, in the same way as
+ * jcat_context_verify_item(). Successful results are cached on @jcat_context
+ * using the checksums of the data and the signatures, so verifying the same
+ * archive again does not repeat the GPG or PKCS#7 operations. The cache is
+ * freed with the context, so any change to the trusted keys invalidates it.
+ *
+ * Returns: (transfer container) (element-type JcatResult): results, or %NULL
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fu_cabinet_jcat_verify_item (JcatContext *jcat_context,
+			     GBytes *blob,
+			     JcatItem *item,
+			     JcatVerifyFlags flags,
+			     GError **error)
+{
+	GHashTable *cache;
+	GPtrArray *results;
+	gint64 start;
+	g_autofree gchar *key = NULL;
+	g_autoptr(GChecksum) csum_sig = g_checksum_new (G_CHECKSUM_SHA256);
+	g_autofree gchar *csum_blob = NULL;
+	g_autoptr(GPtrArray) blobs = NULL;
+
+	g_return_val_if_fail (JCAT_IS_CONTEXT (jcat_context), NULL);
+	g_return_val_if_fail (blob != NULL, NULL);
+	g_return_val_if_fail (JCAT_IS_ITEM (item), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* the key has to cover the signatures as well as the data */
+	csum_blob = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob);
+	blobs = jcat_item_get_blobs (item);
+	for (guint i = 0; i < blobs->len; i++) {
+		JcatBlob *jcat_blob = g_ptr_array_index (blobs, i);
+		GBytes *data = jcat_blob_get_data (jcat_blob);
+		JcatBlobKind kind = jcat_blob_get_kind (jcat_blob);
+		g_checksum_update (csum_sig, (const guchar *) &kind, sizeof(kind));
+		g_checksum_update (csum_sig,
+				   g_bytes_get_data (data, NULL),
+				   g_bytes_get_size (data));
+	}
+	key = g_strdup_printf ("%s:%s:%x", csum_blob,
+			       g_checksum_get_string (csum_sig),
+			       (guint) flags);
+
+	cache = g_object_get_data (G_OBJECT (jcat_context), "fwupd::JcatResultCache");
+	if (cache == NULL) {
+		cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+					       g_free, (GDestroyNotify) g_ptr_array_unref);
+		g_object_set_data_full (G_OBJECT (jcat_context),
+					"fwupd::JcatResultCache", cache,
+					(GDestroyNotify) g_hash_table_unref);
+	}
+	results = g_hash_table_lookup (cache, key);
+	if (results != NULL) {
+		g_debug ("using cached Jcat result for %s", csum_blob);
+		return g_ptr_array_ref (results);
+	}
+
+	/* only successful results are cached */
+	start = fu_timeline_begin ();
+	results = jcat_context_verify_item (jcat_context, blob, item, flags, error);
+	fu_timeline_add ("cabinet", "jcat-verify", jcat_item_get_id (item), start);
+	if (results == NULL)
+		return NULL;
+	g_hash_table_insert (cache, g_steal_pointer (&key), g_ptr_array_ref (results));
+	return results;
+}
+
 /**
  * fu_cabinet_get_silo: (skip):
  * @self: A #FuCabinet
@@ -129,14 +242,153 @@ fu_cabinet_get_file_by_name (FuCabinet *self, const gchar *basename)
 	return NULL;
 }
 
+/* gets the decompressed contents, either from memory or from the payload
+ * extracted into the temporary directory */
+static GBytes *
+fu_cabinet_get_file_bytes (FuCabinet *self, GCabFile *cabfile, GError **error)
+{
+	GBytes *blob = gcab_file_get_bytes (cabfile);
+	g_autofree gchar *fn = NULL;
+	g_autoptr(GMappedFile) mapped_file = NULL;
+
+	if (blob != NULL)
+		return g_bytes_ref (blob);
+	if (self->tmpdir == NULL) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "no GBytes from GCabFile %s",
+			     gcab_file_get_extract_name (cabfile));
+		return NULL;
+	}
+	fn = g_build_filename (self->tmpdir, gcab_file_get_extract_name (cabfile), NULL);
+	mapped_file = g_mapped_file_new (fn, FALSE, error);
+	if (mapped_file == NULL)
+		return NULL;
+	return g_mapped_file_get_bytes (mapped_file);
+}
+
+/* the firmware file referenced by the release */
+static gchar *
+fu_cabinet_get_release_basename (XbNode *release, XbNode **csum)
+{
+	const gchar *csum_filename = NULL;
+	g_autoptr(XbNode) csum_tmp = NULL;
+
+	/* ensure we always have a content checksum */
+	csum_tmp = xb_node_query_first (release, "checksum[@target='content']", NULL);
+	if (csum_tmp != NULL)
+		csum_filename = xb_node_get_attr (csum_tmp, "filename");
+
+	/* if this isn't true, a firmware needs to set in the metainfo.xml file
+	 * something like: <checksum target="content" filename="FLASH.ROM"/> */
+	if (csum_filename == NULL)
+		csum_filename = "firmware.bin";
+	if (csum != NULL)
+		*csum = g_steal_pointer (&csum_tmp);
+	return g_path_get_basename (csum_filename);
+}
+
+typedef struct {
+	gchar			*basename;
+	GBytes			*blob;
+	gchar			*checksum;	/* set by the pool */
+} FuCabinetChecksumJob;
+
+static void
+fu_cabinet_checksum_job_free (FuCabinetChecksumJob *job)
+{
+	g_free (job->basename);
+	g_bytes_unref (job->blob);
+	g_free (job->checksum);
+	g_free (job);
+}
+
+static void
+fu_cabinet_checksum_job_run (gpointer data, GCancellable *cancellable)
+{
+	FuCabinetChecksumJob *job = (FuCabinetChecksumJob *) data;
+	job->checksum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA1, job->blob);
+}
+
+/* the payloads are independent, so hash all the ones with a declared
+ * checksum at the same time rather than one by one for each release */
+static void
+fu_cabinet_compute_payload_checksums (FuCabinet *self, GPtrArray *components)
+{
+	g_autoptr(FuWorkerPool) pool_tmp = NULL;
+	g_autoptr(FuWorkerBatch) batch = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GHashTable) basenames = NULL;
+	g_autoptr(GPtrArray) jobs = NULL;
+
+	basenames = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	jobs = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_cabinet_checksum_job_free);
+	for (guint i = 0; i < components->len; i++) {
+		XbNode *component = g_ptr_array_index (components, i);
+		g_autoptr(GPtrArray) releases = NULL;
+		releases = xb_node_query (component, "releases/release", 0, NULL);
+		if (releases == NULL)
+			continue;
+		for (guint j = 0; j < releases->len; j++) {
+			XbNode *rel = g_ptr_array_index (releases, j);
+			FuCabinetChecksumJob *job;
+			GCabFile *cabfile;
+			g_autofree gchar *basename = NULL;
+			g_autoptr(GBytes) blob = NULL;
+			g_autoptr(XbNode) csum_tmp = NULL;
+
+			basename = fu_cabinet_get_release_basename (rel, &csum_tmp);
+			if (csum_tmp == NULL || xb_node_get_text (csum_tmp) == NULL)
+				continue;
+			if (g_hash_table_contains (basenames, basename))
+				continue;
+			cabfile = fu_cabinet_get_file_by_name (self, basename);
+			if (cabfile == NULL)
+				continue;
+			blob = fu_cabinet_get_file_bytes (self, cabfile, NULL);
+			if (blob == NULL)
+				continue;
+			job = g_new0 (FuCabinetChecksumJob, 1);
+			job->basename = g_strdup (basename);
+			job->blob = g_steal_pointer (&blob);
+			g_ptr_array_add (jobs, job);
+			g_hash_table_add (basenames, g_steal_pointer (&basename));
+		}
+	}
+	if (jobs->len == 0)
+		return;
+
+	/* not worth starting threads for one file */
+	if (self->worker_pool == NULL && jobs->len > 1) {
+		pool_tmp = fu_worker_pool_new (MIN (g_get_num_processors (),
+						    FU_CABINET_CHECKSUM_JOBS_MAX),
+					       &error_local);
+		if (pool_tmp == NULL)
+			g_debug ("computing checksums in serial: %s", error_local->message);
+	}
+	batch = fu_worker_batch_new (self->worker_pool != NULL ? self->worker_pool : pool_tmp,
+				     FU_WORKER_PRIORITY_INTERACTIVE, NULL);
+	for (guint i = 0; i < jobs->len; i++) {
+		FuCabinetChecksumJob *job = g_ptr_array_index (jobs, i);
+		fu_worker_batch_add (batch, fu_cabinet_checksum_job_run, job);
+	}
+	fu_worker_batch_wait (batch);
+	for (guint i = 0; i < jobs->len; i++) {
+		FuCabinetChecksumJob *job = g_ptr_array_index (jobs, i);
+		g_hash_table_insert (self->payload_checksums,
+				     g_steal_pointer (&job->basename),
+				     g_steal_pointer (&job->checksum));
+	}
+}
+
 /* sets the firmware and signature blobs on XbNode */
 static gboolean
 fu_cabinet_parse_release (FuCabinet *self, XbNode *release, GError **error)
 {
 	GCabFile *cabfile;
-	GBytes *blob;
-	const gchar *csum_filename = NULL;
 	g_autofree gchar *basename = NULL;
+	g_autoptr(GBytes) blob = NULL;
 	g_autoptr(XbNode) csum_tmp = NULL;
 	g_autoptr(XbNode) metadata_trust = NULL;
 	g_autoptr(XbNode) nsize = NULL;
@@ -149,18 +401,8 @@ fu_cabinet_parse_release (FuCabinet *self, XbNode *release, GError **error)
 	if (metadata_trust != NULL)
 		release_flags |= FWUPD_RELEASE_FLAG_TRUSTED_METADATA;
 
-	/* ensure we always have a content checksum */
-	csum_tmp = xb_node_query_first (release, "checksum[@target='content']", NULL);
-	if (csum_tmp != NULL)
-		csum_filename = xb_node_get_attr (csum_tmp, "filename");
-
-	/* if this isn't true, a firmware needs to set in the metainfo.xml file
-	 * something like: <checksum target="content" filename="FLASH.ROM"/> */
-	if (csum_filename == NULL)
-		csum_filename = "firmware.bin";
-
 	/* get the main firmware file */
-	basename = g_path_get_basename (csum_filename);
+	basename = fu_cabinet_get_release_basename (release, &csum_tmp);
 	cabfile = fu_cabinet_get_file_by_name (self, basename);
 	if (cabfile == NULL) {
 		g_set_error (error,
@@ -170,14 +412,9 @@ fu_cabinet_parse_release (FuCabinet *self, XbNode *release, GError **error)
 			     basename);
 		return FALSE;
 	}
-	blob = gcab_file_get_bytes (cabfile);
-	if (blob == NULL) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_FILE,
-				     "no GBytes from GCabFile firmware");
+	blob = fu_cabinet_get_file_bytes (self, cabfile, error);
+	if (blob == NULL)
 		return FALSE;
-	}
 
 	/* set the blob */
 	xb_node_set_data (release, "fwupd::FirmwareBlob", blob);
@@ -204,7 +441,9 @@ fu_cabinet_parse_release (FuCabinet *self, XbNode *release, GError **error)
 	/* set if unspecified, but error out if specified and incorrect */
 	if (csum_tmp != NULL && xb_node_get_text (csum_tmp) != NULL) {
 		g_autofree gchar *checksum = NULL;
-		checksum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA1, blob);
+		checksum = g_strdup (g_hash_table_lookup (self->payload_checksums, basename));
+		if (checksum == NULL)
+			checksum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA1, blob);
 		if (g_strcmp0 (checksum, xb_node_get_text (csum_tmp)) != 0) {
 			g_set_error (error,
 				     FWUPD_ERROR,
@@ -221,11 +460,11 @@ fu_cabinet_parse_release (FuCabinet *self, XbNode *release, GError **error)
 	if (item != NULL) {
 		g_autoptr(GError) error_local = NULL;
 		g_autoptr(GPtrArray) results = NULL;
-		results = jcat_context_verify_item (self->jcat_context,
-						    blob, item,
-						    JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM |
-						    JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE,
-						    &error_local);
+		results = fu_cabinet_jcat_verify_item (self->jcat_context,
+						       blob, item,
+						       JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM |
+						       JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE,
+						       &error_local);
 		if (results == NULL) {
 			g_debug ("failed to verify payload %s: %s",
 				 basename, error_local->message);
@@ -410,12 +649,12 @@ fu_cabinet_build_silo_metainfo (FuCabinet *self, GCabFile *cabfile, GError **err
 	} else {
 		g_autoptr(GError) error_local = NULL;
 		g_autoptr(GPtrArray) results = NULL;
-		results = jcat_context_verify_item (self->jcat_context,
-						    gcab_file_get_bytes (cabfile),
-						    item,
-						    JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM |
-						    JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE,
-						    &error_local);
+		results = fu_cabinet_jcat_verify_item (self->jcat_context,
+						       gcab_file_get_bytes (cabfile),
+						       item,
+						       JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM |
+						       JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE,
+						       &error_local);
 		if (results == NULL) {
 			g_debug ("failed to verify %s: %s",
 				 fn, error_local->message);
@@ -536,9 +775,19 @@ fu_cabinet_build_silo (FuCabinet *self, GBytes *data, GError **error)
 typedef struct {
 	FuCabinet	*self;
 	guint64		 size_total;
+	gboolean	 metadata_only;
 	GError		*error;
 } FuCabinetDecompressHelper;
 
+/* these are small and always needed to build the silo */
+static gboolean
+fu_cabinet_is_metadata_filename (const gchar *fn)
+{
+	return g_str_has_suffix (fn, ".metainfo.xml") ||
+	       g_str_has_suffix (fn, ".jcat") ||
+	       g_str_has_suffix (fn, ".asc");
+}
+
 static gboolean
 fu_cabinet_decompress_file_cb (GCabFile *file, gpointer user_data)
 {
@@ -584,15 +833,75 @@ fu_cabinet_decompress_file_cb (GCabFile *file, gpointer user_data)
 	/* ignore the dirname completely */
 	basename = g_path_get_basename (name);
 	gcab_file_set_extract_name (file, basename);
+
+	/* payloads are extracted later */
+	if (helper->metadata_only && !fu_cabinet_is_metadata_filename (basename))
+		return FALSE;
+	return TRUE;
+}
+
+static gboolean
+fu_cabinet_extract_payload_cb (GCabFile *file, gpointer user_data)
+{
+	GHashTable *basenames = (GHashTable *) user_data;
+	return g_hash_table_contains (basenames, gcab_file_get_extract_name (file));
+}
+
+/* extracts only the files referenced by a release into the temporary
+ * directory, so that they can be mapped rather than copied into memory */
+static gboolean
+fu_cabinet_extract_payloads (FuCabinet *self, GPtrArray *components, GError **error)
+{
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GHashTable) basenames = NULL;
+
+	basenames = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	for (guint i = 0; i < components->len; i++) {
+		XbNode *component = g_ptr_array_index (components, i);
+		g_autoptr(GPtrArray) releases = NULL;
+		releases = xb_node_query (component, "releases/release", 0, NULL);
+		if (releases == NULL)
+			continue;
+		for (guint j = 0; j < releases->len; j++) {
+			XbNode *rel = g_ptr_array_index (releases, j);
+			g_hash_table_add (basenames, fu_cabinet_get_release_basename (rel, NULL));
+		}
+	}
+	if (g_hash_table_size (basenames) == 0)
+		return TRUE;
+
+	/* decompress to disk */
+	if (self->tmpdir == NULL) {
+		self->tmpdir = g_dir_make_tmp ("fwupd-cab-XXXXXX", error);
+		if (self->tmpdir == NULL)
+			return FALSE;
+	}
+	file = g_file_new_for_path (self->tmpdir);
+	if (!gcab_cabinet_extract_simple (self->gcab_cabinet, file,
+					  fu_cabinet_extract_payload_cb, basenames,
+					  NULL, &error_local)) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     error_local->message);
+		return FALSE;
+	}
+
+	/* success */
 	return TRUE;
 }
 
 static gboolean
-fu_cabinet_decompress (FuCabinet *self, GBytes *data, GError **error)
+fu_cabinet_decompress (FuCabinet *self,
+		       GBytes *data,
+		       FuCabinetParseFlags flags,
+		       GError **error)
 {
 	FuCabinetDecompressHelper helper = {
 		.self		= self,
 		.size_total	= 0,
+		.metadata_only	= (flags & FU_CABINET_PARSE_FLAG_STREAM) > 0,
 		.error		= NULL,
 	};
 	g_autoptr(GError) error_local = NULL;
@@ -615,7 +924,7 @@ fu_cabinet_decompress (FuCabinet *self, GBytes *data, GError **error)
 		return FALSE;
 	}
 
-	/* decompress the file to memory */
+	/* decompress the file, or just the metadata, to memory */
 	if (!gcab_cabinet_extract_simple (self->gcab_cabinet, NULL,
 					  fu_cabinet_decompress_file_cb, &helper,
 					  NULL, &error_local)) {
@@ -645,6 +954,10 @@ fu_cabinet_decompress (FuCabinet *self, GBytes *data, GError **error)
  *
  * Parses the cabinet archive.
  *
+ * If %FU_CABINET_PARSE_FLAG_STREAM is set then only the metadata is
+ * decompressed into memory, and any referenced payloads are extracted into a
+ * temporary directory and mapped when required.
+ *
  * Returns: %TRUE for success
  *
  * Since: 1.4.0
@@ -655,6 +968,8 @@ fu_cabinet_parse (FuCabinet *self,
 		  FuCabinetParseFlags flags,
 		  GError **error)
 {
+	gint64 start = fu_timeline_begin ();
+	gboolean ret;
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GPtrArray) components = NULL;
 
@@ -664,12 +979,17 @@ fu_cabinet_parse (FuCabinet *self,
 	g_return_val_if_fail (self->silo == NULL, FALSE);
 
 	/* decompress */
-	if (!fu_cabinet_decompress (self, data, error))
+	ret = fu_cabinet_decompress (self, data, flags, error);
+	fu_timeline_add ("cabinet", "decompress", NULL, start);
+	if (!ret)
 		return FALSE;
 
 	/* build xmlb silo */
+	start = fu_timeline_begin ();
 	self->container_checksum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA1, data);
-	if (!fu_cabinet_build_silo (self, data, error))
+	ret = fu_cabinet_build_silo (self, data, error);
+	fu_timeline_add ("cabinet", "build-silo", NULL, start);
+	if (!ret)
 		return FALSE;
 
 	/* sanity check */
@@ -683,6 +1003,13 @@ fu_cabinet_parse (FuCabinet *self,
 		return FALSE;
 	}
 
+	/* only extract the payloads that are referenced */
+	if (flags & FU_CABINET_PARSE_FLAG_STREAM) {
+		if (!fu_cabinet_extract_payloads (self, components, error))
+			return FALSE;
+	}
+	fu_cabinet_compute_payload_checksums (self, components);
+
 	/* process each listed release */
 	for (guint i = 0; i < components->len; i++) {
 		XbNode *component = g_ptr_array_index (components, i);
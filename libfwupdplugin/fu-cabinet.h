@@ -10,6 +10,8 @@
 #include <xmlb.h>
 #include <jcat.h>
 
+#include "fu-worker-pool.h"
+
 #define FU_TYPE_CABINET (fu_cabinet_get_type ())
 
 G_DECLARE_FINAL_TYPE (FuCabinet, fu_cabinet, FU, CABINET, GObject)
@@ -17,11 +19,13 @@ G_DECLARE_FINAL_TYPE (FuCabinet, fu_cabinet, FU, CABINET, GObject)
 /**
  * FuCabinetParseFlags:
  * @FU_CABINET_PARSE_FLAG_NONE:		No flags set
+ * @FU_CABINET_PARSE_FLAG_STREAM:	Only decompress the metadata into memory
  *
  * The flags to use when loading the cabinet.
  **/
 typedef enum {
 	FU_CABINET_PARSE_FLAG_NONE		= 0,
+	FU_CABINET_PARSE_FLAG_STREAM		= 1 << 0,	/* Since: 1.5.0 */
 	/*< private >*/
 	FU_CABINET_PARSE_FLAG_LAST
 } FuCabinetParseFlags;
@@ -31,8 +35,15 @@ void		 fu_cabinet_set_size_max	(FuCabinet		*self,
 						 guint64		 size_max);
 void		 fu_cabinet_set_jcat_context	(FuCabinet		*self,
 						 JcatContext		*jcat_context);
+void		 fu_cabinet_set_worker_pool	(FuCabinet		*self,
+						 FuWorkerPool		*worker_pool);
 gboolean	 fu_cabinet_parse		(FuCabinet		*self,
 						 GBytes			*data,
 						 FuCabinetParseFlags	 flags,
 						 GError			**error);
 XbSilo		*fu_cabinet_get_silo		(FuCabinet		*self);
+GPtrArray	*fu_cabinet_jcat_verify_item	(JcatContext		*jcat_context,
+						 GBytes			*blob,
+						 JcatItem		*item,
+						 JcatVerifyFlags	 flags,
+						 GError			**error);
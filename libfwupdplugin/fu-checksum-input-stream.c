@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuChecksumInputStream"
+
+#include "config.h"
+
+#include <string.h>
+
+#include "fwupd-error.h"
+
+#include "fu-checksum-input-stream.h"
+
+/**
+ * SECTION:fu-checksum-input-stream
+ * @short_description: a stream that verifies data before returning it
+ *
+ * An input stream that reads the base stream one chunk at a time and only
+ * returns each chunk to the caller once it matches the expected checksum.
+ *
+ * This allows firmware to be written to the device as it is downloaded,
+ * with the list of checksums verified using a detached signature first.
+ *
+ * See also: #GFilterInputStream
+ */
+
+struct _FuChecksumInputStream {
+	GFilterInputStream	 parent_instance;
+	GChecksumType		 checksum_type;
+	gsize			 chunk_sz;
+	GPtrArray		*checksums;	/* (element-type utf-8) */
+	guint			 idx;		/* next chunk to verify */
+	guint8			*buf;		/* verified data not yet read */
+	gsize			 buf_len;
+	gsize			 buf_offset;
+	gboolean		 eos;
+};
+
+G_DEFINE_TYPE (FuChecksumInputStream, fu_checksum_input_stream, G_TYPE_FILTER_INPUT_STREAM)
+
+static gboolean
+fu_checksum_input_stream_fill (FuChecksumInputStream *self,
+			       GCancellable *cancellable,
+			       GError **error)
+{
+	GInputStream *base_stream = g_filter_input_stream_get_base_stream (G_FILTER_INPUT_STREAM (self));
+	const gchar *checksum_expected;
+	gsize bytes_read = 0;
+	g_autofree gchar *checksum = NULL;
+
+	if (!g_input_stream_read_all (base_stream, self->buf, self->chunk_sz,
+				      &bytes_read, cancellable, error))
+		return FALSE;
+	self->buf_len = bytes_read;
+	self->buf_offset = 0;
+
+	/* end of the stream, so check nothing was missing */
+	if (bytes_read == 0) {
+		if (self->idx != self->checksums->len) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "stream truncated after %u of %u chunks",
+				     self->idx, self->checksums->len);
+			return FALSE;
+		}
+		self->eos = TRUE;
+		return TRUE;
+	}
+
+	/* check it matches before it is returned */
+	if (self->idx >= self->checksums->len) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "stream has more than %u chunks",
+			     self->checksums->len);
+		return FALSE;
+	}
+	checksum_expected = g_ptr_array_index (self->checksums, self->idx);
+	checksum = g_compute_checksum_for_data (self->checksum_type,
+						self->buf, bytes_read);
+	if (g_ascii_strcasecmp (checksum, checksum_expected) != 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "chunk %u checksum invalid, got %s, expected %s",
+			     self->idx, checksum, checksum_expected);
+		return FALSE;
+	}
+	self->idx++;
+	return TRUE;
+}
+
+static gssize
+fu_checksum_input_stream_read (GInputStream *stream,
+			       void *buffer,
+			       gsize count,
+			       GCancellable *cancellable,
+			       GError **error)
+{
+	FuChecksumInputStream *self = FU_CHECKSUM_INPUT_STREAM (stream);
+	gsize sz;
+
+	if (self->buf_offset == self->buf_len && !self->eos) {
+		if (!fu_checksum_input_stream_fill (self, cancellable, error))
+			return -1;
+	}
+	if (self->eos)
+		return 0;
+	sz = MIN (count, self->buf_len - self->buf_offset);
+	memcpy (buffer, self->buf + self->buf_offset, sz);
+	self->buf_offset += sz;
+	return (gssize) sz;
+}
+
+static void
+fu_checksum_input_stream_init (FuChecksumInputStream *self)
+{
+}
+
+static void
+fu_checksum_input_stream_finalize (GObject *object)
+{
+	FuChecksumInputStream *self = FU_CHECKSUM_INPUT_STREAM (object);
+	g_ptr_array_unref (self->checksums);
+	g_free (self->buf);
+	G_OBJECT_CLASS (fu_checksum_input_stream_parent_class)->finalize (object);
+}
+
+static void
+fu_checksum_input_stream_class_init (FuChecksumInputStreamClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	GInputStreamClass *stream_class = G_INPUT_STREAM_CLASS (klass);
+	object_class->finalize = fu_checksum_input_stream_finalize;
+	stream_class->read_fn = fu_checksum_input_stream_read;
+}
+
+/**
+ * fu_checksum_input_stream_new:
+ * @base_stream: a #GInputStream, e.g. a download in progress
+ * @checksum_type: a #GChecksumType, e.g. %G_CHECKSUM_SHA256
+ * @chunk_sz: the number of bytes covered by each checksum
+ * @checksums: (element-type utf-8): the expected checksum of each chunk
+ *
+ * Creates a stream that only returns data from @base_stream once the chunk
+ * it belongs to has been verified. All chunks apart from the last must be
+ * exactly @chunk_sz bytes.
+ *
+ * Reading returns an error if a chunk does not match, if there is more data
+ * than checksums, or if the stream ends before all the checksums have been
+ * used. The caller is expected to have verified @checksums already, e.g.
+ * using a detached signature.
+ *
+ * Returns: (transfer full): a #GInputStream
+ *
+ * Since: 1.5.0
+ **/
+GInputStream *
+fu_checksum_input_stream_new (GInputStream *base_stream,
+			      GChecksumType checksum_type,
+			      gsize chunk_sz,
+			      GPtrArray *checksums)
+{
+	FuChecksumInputStream *self;
+
+	g_return_val_if_fail (G_IS_INPUT_STREAM (base_stream), NULL);
+	g_return_val_if_fail (chunk_sz > 0, NULL);
+	g_return_val_if_fail (checksums != NULL, NULL);
+
+	self = g_object_new (FU_TYPE_CHECKSUM_INPUT_STREAM,
+			     "base-stream", base_stream,
+			     NULL);
+	self->checksum_type = checksum_type;
+	self->chunk_sz = chunk_sz;
+	self->checksums = g_ptr_array_ref (checksums);
+	self->buf = g_malloc (chunk_sz);
+	return G_INPUT_STREAM (self);
+}
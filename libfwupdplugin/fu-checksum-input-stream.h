@@ -0,0 +1,18 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#define FU_TYPE_CHECKSUM_INPUT_STREAM (fu_checksum_input_stream_get_type ())
+
+G_DECLARE_FINAL_TYPE (FuChecksumInputStream, fu_checksum_input_stream, FU, CHECKSUM_INPUT_STREAM, GFilterInputStream)
+
+GInputStream	*fu_checksum_input_stream_new		(GInputStream	*base_stream,
+							 GChecksumType	 checksum_type,
+							 gsize		 chunk_sz,
+							 GPtrArray	*checksums);
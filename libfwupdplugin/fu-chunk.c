@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include "fu-chunk.h"
+#include "fu-common.h"
 
 /**
  * SECTION:fu-chunk
@@ -212,3 +213,227 @@ fu_chunk_array_new_from_bytes (GBytes *blob,
 	return fu_chunk_array_new (data, (guint32) sz,
 				   addr_start, page_sz, packet_sz);
 }
+
+/**
+ * fu_chunk_array_new_from_diff: (skip):
+ * @data_old: the current contents, typically read back from the device
+ * @data: the new contents
+ * @data_sz: size of @data_old and @data
+ * @addr_start: the hardware address offset, or 0
+ * @page_sz: the hardware page size, or 0
+ *
+ * Finds the parts of @data that are different to @data_old in one pass.
+ *
+ * If @page_sz is set then there is one chunk for each page that has changed,
+ * otherwise there is one chunk for each run of changed bytes. The chunks
+ * point into @data.
+ *
+ * Return value: (transfer container) (element-type FuChunk): array of packets
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fu_chunk_array_new_from_diff (const guint8 *data_old,
+			      const guint8 *data,
+			      guint32 data_sz,
+			      guint32 addr_start,
+			      guint32 page_sz)
+{
+	GPtrArray *chunks = NULL;
+	guint32 offset = 0;
+
+	g_return_val_if_fail (data_old != NULL, NULL);
+	g_return_val_if_fail (data != NULL, NULL);
+
+	chunks = g_ptr_array_new_with_free_func (g_free);
+	while (offset < data_sz) {
+		guint32 start;
+		guint32 end;
+		guint32 page = 0;
+		guint32 address;
+
+		start = offset + (guint32) fu_common_data_get_mismatch (data_old + offset,
+									data + offset,
+									data_sz - offset);
+		if (start == data_sz)
+			break;
+		if (page_sz > 0) {
+			/* the whole page, which may be partial at either end */
+			guint32 page_offset = (addr_start + start) % page_sz;
+			start = start >= page_offset ? start - page_offset : 0;
+			end = start + page_sz - ((addr_start + start) % page_sz);
+			end = MIN (end, data_sz);
+			page = (addr_start + start) / page_sz;
+			address = (addr_start + start) % page_sz;
+		} else {
+			end = start + 1;
+			while (end < data_sz && data_old[end] != data[end])
+				end++;
+			address = addr_start + start;
+		}
+		g_ptr_array_add (chunks,
+				 fu_chunk_new (chunks->len,
+					       page,
+					       address,
+					       data + start,
+					       end - start));
+		offset = end;
+	}
+	return chunks;
+}
+
+struct _FuChunkView {
+	GBytes		*blob;
+	guint32		 addr_start;
+	guint32		 page_sz;
+	guint32		 packet_sz;	/* never larger than page_sz */
+	guint32		 first_sz;	/* bytes in the first, possibly partial, page */
+	guint		 first_cnt;	/* chunks in the first page */
+	guint		 page_cnt;	/* chunks in each following page */
+	guint		 len;
+};
+
+static guint
+fu_chunk_view_count (guint32 sz, guint32 packet_sz)
+{
+	if (packet_sz == 0)
+		return sz > 0 ? 1 : 0;
+	return (sz + packet_sz - 1) / packet_sz;
+}
+
+/**
+ * fu_chunk_view_new: (skip):
+ * @blob: a #GBytes
+ * @addr_start: the hardware address offset, or 0
+ * @page_sz: the hardware page size, or 0
+ * @packet_sz: the transfer size, or 0
+ *
+ * Creates a view that splits @blob into packets using the same rules as
+ * fu_chunk_array_new_from_bytes(), but where each chunk is only computed when
+ * requested using fu_chunk_view_get_index().
+ *
+ * Return value: (transfer full): a #FuChunkView
+ *
+ * Since: 1.5.0
+ **/
+FuChunkView *
+fu_chunk_view_new (GBytes *blob,
+		   guint32 addr_start,
+		   guint32 page_sz,
+		   guint32 packet_sz)
+{
+	FuChunkView *self = g_new0 (FuChunkView, 1);
+	guint32 data_sz = (guint32) g_bytes_get_size (blob);
+
+	self->blob = g_bytes_ref (blob);
+	self->addr_start = addr_start;
+	self->page_sz = page_sz;
+	self->packet_sz = packet_sz;
+
+	/* no pages, so everything is in the first */
+	if (page_sz == 0) {
+		self->first_sz = data_sz;
+		self->first_cnt = fu_chunk_view_count (data_sz, packet_sz);
+		self->len = self->first_cnt;
+		return self;
+	}
+
+	/* a packet cannot cross a page boundary */
+	if (self->packet_sz == 0 || self->packet_sz > page_sz)
+		self->packet_sz = page_sz;
+	self->first_sz = MIN (page_sz - (addr_start % page_sz), data_sz);
+	self->first_cnt = fu_chunk_view_count (self->first_sz, self->packet_sz);
+	self->page_cnt = fu_chunk_view_count (page_sz, self->packet_sz);
+	self->len = self->first_cnt +
+		    ((data_sz - self->first_sz) / page_sz) * self->page_cnt +
+		    fu_chunk_view_count ((data_sz - self->first_sz) % page_sz, self->packet_sz);
+	return self;
+}
+
+/**
+ * fu_chunk_view_free:
+ * @self: a #FuChunkView
+ *
+ * Frees the view and drops the reference to the backing data.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_chunk_view_free (FuChunkView *self)
+{
+	g_bytes_unref (self->blob);
+	g_free (self);
+}
+
+/**
+ * fu_chunk_view_get_length:
+ * @self: a #FuChunkView
+ *
+ * Gets the number of chunks in the view.
+ *
+ * Return value: integer
+ *
+ * Since: 1.5.0
+ **/
+guint
+fu_chunk_view_get_length (FuChunkView *self)
+{
+	g_return_val_if_fail (self != NULL, 0);
+	return self->len;
+}
+
+/**
+ * fu_chunk_view_get_index:
+ * @self: a #FuChunkView
+ * @idx: the chunk index
+ * @chunk: (out caller-allocates): a #FuChunk
+ *
+ * Computes a chunk from the view. The chunk data is only valid for as long as
+ * the view exists.
+ *
+ * Return value: %TRUE if @idx was in range
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_chunk_view_get_index (FuChunkView *self, guint idx, FuChunk *chunk)
+{
+	gsize data_sz = 0;
+	const guint8 *data;
+	guint64 offset;
+	guint64 offset_page;
+	guint64 sz;
+
+	g_return_val_if_fail (self != NULL, FALSE);
+	g_return_val_if_fail (chunk != NULL, FALSE);
+
+	if (idx >= self->len)
+		return FALSE;
+	data = g_bytes_get_data (self->blob, &data_sz);
+
+	/* find the start of the page, and the offset within it */
+	if (idx < self->first_cnt) {
+		offset_page = 0;
+		offset = (guint64) idx * self->packet_sz;
+		sz = self->first_sz;
+	} else {
+		guint idx_page = (idx - self->first_cnt) / self->page_cnt;
+		offset_page = self->first_sz + (guint64) idx_page * self->page_sz;
+		offset = offset_page + (guint64) ((idx - self->first_cnt) % self->page_cnt) * self->packet_sz;
+		sz = MIN (self->page_sz, data_sz - offset_page);
+	}
+	if (self->packet_sz > 0)
+		sz = MIN (self->packet_sz, offset_page + sz - offset);
+
+	chunk->idx = idx;
+	chunk->data = data != NULL ? data + offset : NULL;
+	chunk->data_sz = (guint32) sz;
+	if (self->page_sz > 0) {
+		chunk->page = (self->addr_start + offset) / self->page_sz;
+		chunk->address = (self->addr_start + offset) % self->page_sz;
+	} else {
+		chunk->page = 0;
+		chunk->address = self->addr_start + offset;
+	}
+	return TRUE;
+}
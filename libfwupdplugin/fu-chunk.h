@@ -34,3 +34,22 @@ GPtrArray	*fu_chunk_array_new_from_bytes		(GBytes		*blob,
 							 guint32	 addr_start,
 							 guint32	 page_sz,
 							 guint32	 packet_sz);
+GPtrArray	*fu_chunk_array_new_from_diff		(const guint8	*data_old,
+							 const guint8	*data,
+							 guint32	 data_sz,
+							 guint32	 addr_start,
+							 guint32	 page_sz);
+
+typedef struct _FuChunkView FuChunkView;
+
+FuChunkView	*fu_chunk_view_new			(GBytes		*blob,
+							 guint32	 addr_start,
+							 guint32	 page_sz,
+							 guint32	 packet_sz);
+void		 fu_chunk_view_free			(FuChunkView	*self);
+guint		 fu_chunk_view_get_length		(FuChunkView	*self);
+gboolean	 fu_chunk_view_get_index		(FuChunkView	*self,
+							 guint		 idx,
+							 FuChunk	*chunk);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuChunkView, fu_chunk_view_free)
@@ -551,3 +551,146 @@ fu_common_vercmp (const gchar *version_a, const gchar *version_b)
 	/* we really shouldn't get here */
 	return 0;
 }
+
+struct _FuCommonVersionKey {
+	FwupdVersionFormat	 fmt;
+	gchar			*version;
+	gchar			**split;
+	gint64			*values;	/* integer part of each section */
+	const gchar		**suffixes;	/* remainder of each section */
+	guint			 len;
+};
+
+/**
+ * fu_common_version_key_new:
+ * @version: (nullable): the semver release version, e.g. 1.2.3
+ * @fmt: a #FwupdVersionFormat, e.g. %FWUPD_VERSION_FORMAT_PLAIN
+ *
+ * Parses a version number once so that it can be compared many times, for
+ * instance when sorting a large number of releases.
+ *
+ * Returns: (transfer full): a #FuCommonVersionKey
+ *
+ * Since: 1.5.0
+ **/
+FuCommonVersionKey *
+fu_common_version_key_new (const gchar *version, FwupdVersionFormat fmt)
+{
+	FuCommonVersionKey *key = g_new0 (FuCommonVersionKey, 1);
+
+	key->fmt = fmt;
+	key->version = g_strdup (version);
+	if (version == NULL || fmt == FWUPD_VERSION_FORMAT_PLAIN)
+		return key;
+
+	/* the same parsing as fu_common_vercmp() */
+	key->split = g_strsplit (version, ".", -1);
+	key->len = g_strv_length (key->split);
+	key->values = g_new0 (gint64, key->len);
+	key->suffixes = g_new0 (const gchar *, key->len);
+	for (guint i = 0; i < key->len; i++) {
+		gchar *endptr = NULL;
+		key->values[i] = g_ascii_strtoll (key->split[i], &endptr, 10);
+		key->suffixes[i] = endptr;
+	}
+	return key;
+}
+
+/**
+ * fu_common_version_key_free:
+ * @key: a #FuCommonVersionKey
+ *
+ * Frees a version key.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_common_version_key_free (FuCommonVersionKey *key)
+{
+	g_free (key->version);
+	g_strfreev (key->split);
+	g_free (key->values);
+	g_free (key->suffixes);
+	g_free (key);
+}
+
+/**
+ * fu_common_version_key_get_version:
+ * @key: a #FuCommonVersionKey
+ *
+ * Gets the version the key was created from.
+ *
+ * Returns: the version, or %NULL
+ *
+ * Since: 1.5.0
+ **/
+const gchar *
+fu_common_version_key_get_version (FuCommonVersionKey *key)
+{
+	g_return_val_if_fail (key != NULL, NULL);
+	return key->version;
+}
+
+/**
+ * fu_common_version_key_compare:
+ * @key_a: a #FuCommonVersionKey
+ * @key_b: a #FuCommonVersionKey
+ *
+ * Compares two parsed version numbers, giving the same result as
+ * fu_common_vercmp_full() using the format of @key_a.
+ *
+ * Returns: -1 if a < b, +1 if a > b, 0 if they are equal, and %G_MAXINT on error
+ *
+ * Since: 1.5.0
+ **/
+gint
+fu_common_version_key_compare (FuCommonVersionKey *key_a, FuCommonVersionKey *key_b)
+{
+	guint longest_split;
+
+	g_return_val_if_fail (key_a != NULL, G_MAXINT);
+	g_return_val_if_fail (key_b != NULL, G_MAXINT);
+
+	if (key_a->fmt == FWUPD_VERSION_FORMAT_PLAIN)
+		return g_strcmp0 (key_a->version, key_b->version);
+
+	/* sanity check */
+	if (key_a->version == NULL || key_b->version == NULL)
+		return G_MAXINT;
+
+	/* optimisation */
+	if (g_strcmp0 (key_a->version, key_b->version) == 0)
+		return 0;
+
+	/* parsed in the other format */
+	if (key_b->split == NULL)
+		return fu_common_vercmp (key_a->version, key_b->version);
+
+	longest_split = MAX (key_a->len, key_b->len);
+	for (guint i = 0; i < longest_split; i++) {
+
+		/* we lost or gained a dot */
+		if (i >= key_a->len)
+			return -1;
+		if (i >= key_b->len)
+			return 1;
+
+		/* compare integers */
+		if (key_a->values[i] < key_b->values[i])
+			return -1;
+		if (key_a->values[i] > key_b->values[i])
+			return 1;
+
+		/* compare strings */
+		if (key_a->suffixes[i][0] != '\0' || key_b->suffixes[i][0] != '\0') {
+			gint rc = fu_common_vercmp_chunk (key_a->suffixes[i], key_b->suffixes[i]);
+			if (rc < 0)
+				return -1;
+			if (rc > 0)
+				return 1;
+		}
+	}
+
+	/* we really shouldn't get here */
+	return 0;
+}
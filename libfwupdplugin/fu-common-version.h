@@ -9,6 +9,8 @@
 #include <gio/gio.h>
 #include <fwupd.h>
 
+typedef struct _FuCommonVersionKey FuCommonVersionKey;
+
 gint		 fu_common_vercmp		(const gchar	*version_a,
 						 const gchar	*version_b)
 G_DEPRECATED_FOR(fu_common_vercmp_full);
@@ -30,3 +32,11 @@ FwupdVersionFormat	 fu_common_version_guess_format	(const gchar	*version);
 gboolean	 fu_common_version_verify_format	(const gchar	*version,
 							 FwupdVersionFormat fmt,
 							 GError		**error);
+FuCommonVersionKey	*fu_common_version_key_new	(const gchar	*version,
+							 FwupdVersionFormat fmt);
+void		 fu_common_version_key_free		(FuCommonVersionKey *key);
+const gchar	*fu_common_version_key_get_version	(FuCommonVersionKey *key);
+gint		 fu_common_version_key_compare		(FuCommonVersionKey *key_a,
+							 FuCommonVersionKey *key_b);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuCommonVersionKey, fu_common_version_key_free)
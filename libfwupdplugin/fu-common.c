@@ -8,6 +8,11 @@
 
 #include <config.h>
 
+/* for the file seals */
+#ifdef HAVE_MEMFD_CREATE
+#define _GNU_SOURCE
+#endif
+
 #ifdef HAVE_GIO_UNIX
 #include <gio/gunixinputstream.h>
 #endif
@@ -27,6 +32,12 @@
 #include <limits.h>
 #include <string.h>
 #include <stdlib.h>
+#ifdef HAVE_MEMFD_CREATE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "fwupd-error.h"
 
@@ -220,13 +231,101 @@ fu_common_get_contents_bytes (const gchar *filename, GError **error)
 	return g_bytes_new_take (data, len);
 }
 
+/**
+ * fu_common_get_contents_mapped:
+ * @filename: A filename
+ * @error: A #GError, or %NULL
+ *
+ * Maps a file into memory rather than copying it onto the heap. The mapping
+ * is released when the last reference to the returned #GBytes is dropped.
+ *
+ * Files that cannot be mapped or that report a zero size, for instance
+ * those in sysfs or procfs, are read using fu_common_get_contents_bytes()
+ * instead.
+ *
+ * NOTE: The file must not be truncated while the #GBytes is in use.
+ *
+ * Returns: (transfer full): a #GBytes, or %NULL for failure
+ *
+ * Since: 1.5.0
+ **/
+GBytes *
+fu_common_get_contents_mapped (const gchar *filename, GError **error)
+{
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GMappedFile) mapped = NULL;
+
+	g_return_val_if_fail (filename != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	mapped = g_mapped_file_new (filename, FALSE, &error_local);
+	if (mapped == NULL) {
+		g_debug ("failed to map %s: %s", filename, error_local->message);
+		return fu_common_get_contents_bytes (filename, error);
+	}
+	if (g_mapped_file_get_length (mapped) == 0)
+		return fu_common_get_contents_bytes (filename, error);
+	g_debug ("mapping %s with %" G_GSIZE_FORMAT " bytes",
+		 filename, g_mapped_file_get_length (mapped));
+	return g_mapped_file_get_bytes (mapped);
+}
+
+#ifdef HAVE_MEMFD_CREATE
+typedef struct {
+	gpointer	 ptr;
+	gsize		 sz;
+} FuCommonMapping;
+
+static void
+fu_common_mapping_free (gpointer user_data)
+{
+	FuCommonMapping *mapping = (FuCommonMapping *) user_data;
+	munmap (mapping->ptr, mapping->sz);
+	g_free (mapping);
+}
+
+/* returns NULL without an error if the fd cannot be mapped safely */
+static GBytes *
+fu_common_get_contents_fd_sealed (gint fd, gsize count, GError **error)
+{
+	gint seals;
+	gpointer ptr;
+	struct stat st;
+	FuCommonMapping *mapping;
+
+	/* the contents must not change while mapped */
+	seals = fcntl (fd, F_GET_SEALS);
+	if (seals < 0 || (seals & (F_SEAL_WRITE | F_SEAL_SHRINK)) != (F_SEAL_WRITE | F_SEAL_SHRINK))
+		return NULL;
+	if (fstat (fd, &st) != 0 || st.st_size == 0)
+		return NULL;
+	if ((guint64) st.st_size > count) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "file size 0x%x is larger than the maximum of 0x%x",
+			     (guint) st.st_size, (guint) count);
+		return NULL;
+	}
+	ptr = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (ptr == MAP_FAILED)
+		return NULL;
+	g_debug ("mapping sealed fd with %" G_GSIZE_FORMAT " bytes", (gsize) st.st_size);
+	mapping = g_new0 (FuCommonMapping, 1);
+	mapping->ptr = ptr;
+	mapping->sz = st.st_size;
+	return g_bytes_new_with_free_func (ptr, mapping->sz, fu_common_mapping_free, mapping);
+}
+#endif
+
 /**
  * fu_common_get_contents_fd:
  * @fd: A file descriptor
  * @count: The maximum number of bytes to read
  * @error: A #GError, or %NULL
  *
- * Reads a blob from a specific file descriptor.
+ * Reads a blob from a specific file descriptor. If @fd is a memfd sealed
+ * against writing and shrinking then it is mapped rather than copied.
  *
  * Note: this will close the fd when done
  *
@@ -254,6 +353,19 @@ fu_common_get_contents_fd (gint fd, gsize count, GError **error)
 		return NULL;
 	}
 
+#ifdef HAVE_MEMFD_CREATE
+	/* the mapping stays valid after the fd is closed */
+	blob = fu_common_get_contents_fd_sealed (fd, count, &error_local);
+	if (blob != NULL || error_local != NULL) {
+		close (fd);
+		if (blob == NULL) {
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			return NULL;
+		}
+		return g_steal_pointer (&blob);
+	}
+#endif
+
 	/* read the entire fd to a data blob */
 	stream = g_unix_input_stream_new (fd, TRUE);
 	blob = g_input_stream_read_bytes (stream, count, NULL, &error_local);
@@ -437,6 +549,32 @@ fu_common_test_namespace_support (GError **error)
 	return TRUE;
 }
 
+/* the script can use anything in the builder directory, so include that too */
+static gchar *
+fu_common_firmware_builder_get_cache_key (GBytes *bytes,
+					  const gchar *script_fn,
+					  const gchar *output_fn,
+					  const gchar *builderdir)
+{
+	const gchar *fn;
+	g_autofree gchar *csum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, bytes);
+	g_autoptr(GDir) dir = g_dir_open (builderdir, 0, NULL);
+	GString *str = g_string_new (NULL);
+
+	g_string_append_printf (str, "%s;%s;%s", csum, script_fn, output_fn);
+	if (dir == NULL)
+		return g_string_free (str, FALSE);
+	while ((fn = g_dir_read_name (dir)) != NULL) {
+		GStatBuf st = { 0 };
+		g_autofree gchar *path = g_build_filename (builderdir, fn, NULL);
+		if (g_stat (path, &st) != 0)
+			continue;
+		g_string_append_printf (str, ";%s:%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT,
+					fn, (gint64) st.st_size, (gint64) st.st_mtime);
+	}
+	return g_string_free (str, FALSE);
+}
+
 /**
  * fu_common_firmware_builder:
  * @bytes: The data to use
@@ -453,6 +591,10 @@ fu_common_test_namespace_support (GError **error)
  * 4. The firmware.bin is extracted from the container
  * 5. The temporary location is deleted
  *
+ * The last generated firmware is kept, and is returned without running the
+ * script again if @bytes, @script_fn, @output_fn and the contents of the
+ * builder directory are all unchanged.
+ *
  * Returns: a new #GBytes, or %NULL for error
  *
  * Since: 0.9.7
@@ -463,8 +605,12 @@ fu_common_firmware_builder (GBytes *bytes,
 			    const gchar *output_fn,
 			    GError **error)
 {
+	static GMutex mutex;
+	static gchar *cache_key = NULL;
+	static GBytes *cache_blob = NULL;
 	gint rc = 0;
 	g_autofree gchar *argv_str = NULL;
+	g_autofree gchar *key = NULL;
 	g_autofree gchar *bwrap_fn = NULL;
 	g_autofree gchar *localstatebuilderdir = NULL;
 	g_autofree gchar *localstatedir = NULL;
@@ -480,6 +626,22 @@ fu_common_firmware_builder (GBytes *bytes,
 	g_return_val_if_fail (output_fn != NULL, NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+	/* this is shared with the plugins */
+	localstatedir = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
+	localstatebuilderdir = g_build_filename (localstatedir, "builder", NULL);
+
+	/* built for another device with the same firmware */
+	key = fu_common_firmware_builder_get_cache_key (bytes, script_fn, output_fn,
+							localstatebuilderdir);
+	g_mutex_lock (&mutex);
+	if (g_strcmp0 (key, cache_key) == 0) {
+		GBytes *blob = g_bytes_ref (cache_blob);
+		g_mutex_unlock (&mutex);
+		g_debug ("using cached output of %s", script_fn);
+		return blob;
+	}
+	g_mutex_unlock (&mutex);
+
 	/* find bwrap in the path */
 	bwrap_fn = fu_common_find_program_in_path ("bwrap", error);
 	if (bwrap_fn == NULL)
@@ -496,10 +658,6 @@ fu_common_firmware_builder (GBytes *bytes,
 	if (!fu_common_extract_archive (bytes, tmpdir, error))
 		return NULL;
 
-	/* this is shared with the plugins */
-	localstatedir = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
-	localstatebuilderdir = g_build_filename (localstatedir, "builder", NULL);
-
 	/* launch bubblewrap and generate firmware */
 	g_ptr_array_add (argv, g_steal_pointer (&bwrap_fn));
 	fu_common_add_argv (argv, "--die-with-parent");
@@ -556,6 +714,15 @@ fu_common_firmware_builder (GBytes *bytes,
 	if (!fu_common_rmtree (tmpdir, error))
 		return NULL;
 
+	/* only the last is kept, which covers re-installs and identical devices */
+	g_mutex_lock (&mutex);
+	g_free (cache_key);
+	if (cache_blob != NULL)
+		g_bytes_unref (cache_blob);
+	cache_key = g_steal_pointer (&key);
+	cache_blob = g_bytes_ref (firmware_blob);
+	g_mutex_unlock (&mutex);
+
 	/* success */
 	return g_steal_pointer (&firmware_blob);
 }
@@ -563,67 +730,74 @@ fu_common_firmware_builder (GBytes *bytes,
 typedef struct {
 	FuOutputHandler		 handler_cb;
 	gpointer		 handler_user_data;
+	GMainContext		*context;
 	GMainLoop		*loop;
 	GSource			*source;
+	GSource			*timeout_source;
 	GInputStream		*stream;
 	GCancellable		*cancellable;
-	guint			 timeout_id;
+	GString			*linebuf;	/* any partial line */
 } FuCommonSpawnHelper;
 
-static void fu_common_spawn_create_pollable_source (FuCommonSpawnHelper *helper);
+static void
+fu_common_spawn_emit_lines (FuCommonSpawnHelper *helper, gboolean flush)
+{
+	gsize offset = 0;
+
+	for (gsize i = 0; i < helper->linebuf->len; i++) {
+		if (helper->linebuf->str[i] != '\n')
+			continue;
+		helper->linebuf->str[i] = '\0';
+		if (i > offset)
+			helper->handler_cb (helper->linebuf->str + offset, helper->handler_user_data);
+		offset = i + 1;
+	}
+	g_string_erase (helper->linebuf, 0, offset);
+	if (flush && helper->linebuf->len > 0) {
+		helper->handler_cb (helper->linebuf->str, helper->handler_user_data);
+		g_string_truncate (helper->linebuf, 0);
+	}
+}
 
 static gboolean
 fu_common_spawn_source_pollable_cb (GObject *stream, gpointer user_data)
 {
 	FuCommonSpawnHelper *helper = (FuCommonSpawnHelper *) user_data;
-	gchar buffer[1024];
+	gchar buffer[4096];
 	gssize sz;
-	g_auto(GStrv) split = NULL;
 	g_autoptr(GError) error = NULL;
 
 	/* read from stream */
 	sz = g_pollable_input_stream_read_nonblocking (G_POLLABLE_INPUT_STREAM (stream),
 						       buffer,
-						       sizeof(buffer) - 1,
-						       NULL,
+						       sizeof(buffer),
+						       helper->cancellable,
 						       &error);
 	if (sz < 0) {
-		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+			return G_SOURCE_CONTINUE;
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
 			g_warning ("failed to get read from nonblocking fd: %s",
 				   error->message);
 		}
+		g_main_loop_quit (helper->loop);
 		return G_SOURCE_REMOVE;
 	}
 
-	/* no read possible */
-	if (sz == 0)
+	/* end of output, so emit any partial line */
+	if (sz == 0) {
+		if (helper->handler_cb != NULL)
+			fu_common_spawn_emit_lines (helper, TRUE);
 		g_main_loop_quit (helper->loop);
+		return G_SOURCE_REMOVE;
+	}
 
-	/* emit lines */
+	/* emit lines, which may be split over more than one read */
 	if (helper->handler_cb != NULL) {
-		buffer[sz] = '\0';
-		split = g_strsplit (buffer, "\n", -1);
-		for (guint i = 0; split[i] != NULL; i++) {
-			if (split[i][0] == '\0')
-				continue;
-			helper->handler_cb (split[i], helper->handler_user_data);
-		}
+		g_string_append_len (helper->linebuf, buffer, sz);
+		fu_common_spawn_emit_lines (helper, FALSE);
 	}
-
-	/* set up the source for the next read */
-	fu_common_spawn_create_pollable_source (helper);
-	return G_SOURCE_REMOVE;
-}
-
-static void
-fu_common_spawn_create_pollable_source (FuCommonSpawnHelper *helper)
-{
-	if (helper->source != NULL)
-		g_source_destroy (helper->source);
-	helper->source = g_pollable_input_stream_create_source (G_POLLABLE_INPUT_STREAM (helper->stream),
-								helper->cancellable);
-	g_source_attach (helper->source, NULL);
-	g_source_set_callback (helper->source, (GSourceFunc) fu_common_spawn_source_pollable_cb, helper, NULL);
+	return G_SOURCE_CONTINUE;
 }
 
 static void
@@ -632,12 +806,19 @@ fu_common_spawn_helper_free (FuCommonSpawnHelper *helper)
 	g_object_unref (helper->cancellable);
 	if (helper->stream != NULL)
 		g_object_unref (helper->stream);
-	if (helper->source != NULL)
+	if (helper->source != NULL) {
 		g_source_destroy (helper->source);
+		g_source_unref (helper->source);
+	}
+	if (helper->timeout_source != NULL) {
+		g_source_destroy (helper->timeout_source);
+		g_source_unref (helper->timeout_source);
+	}
 	if (helper->loop != NULL)
 		g_main_loop_unref (helper->loop);
-	if (helper->timeout_id != 0)
-		g_source_remove (helper->timeout_id);
+	if (helper->context != NULL)
+		g_main_context_unref (helper->context);
+	g_string_free (helper->linebuf, TRUE);
 	g_free (helper);
 }
 
@@ -652,7 +833,6 @@ fu_common_spawn_timeout_cb (gpointer user_data)
 	FuCommonSpawnHelper *helper = (FuCommonSpawnHelper *) user_data;
 	g_cancellable_cancel (helper->cancellable);
 	g_main_loop_quit (helper->loop);
-	helper->timeout_id = 0;
 	return G_SOURCE_REMOVE;
 }
 
@@ -675,6 +855,9 @@ fu_common_spawn_cancelled_cb (GCancellable *cancellable, FuCommonSpawnHelper *he
  * Runs a subprocess and waits for it to exit. Any output on standard out or
  * standard error will be forwarded to @handler_cb as whole lines.
  *
+ * The output is read using a private main context, so this is safe to call
+ * from a worker thread. The subprocess is killed on timeout or cancellation.
+ *
  * Returns: %TRUE for success
  *
  * Since: 0.9.7
@@ -703,8 +886,10 @@ fu_common_spawn_sync (const gchar * const * argv,
 	helper = g_new0 (FuCommonSpawnHelper, 1);
 	helper->handler_cb = handler_cb;
 	helper->handler_user_data = handler_user_data;
-	helper->loop = g_main_loop_new (NULL, FALSE);
-	helper->stream = g_subprocess_get_stdout_pipe (subprocess);
+	helper->context = g_main_context_new ();
+	helper->loop = g_main_loop_new (helper->context, FALSE);
+	helper->stream = g_object_ref (g_subprocess_get_stdout_pipe (subprocess));
+	helper->linebuf = g_string_new (NULL);
 
 	/* always create a cancellable, and connect up the parent */
 	helper->cancellable = g_cancellable_new ();
@@ -716,15 +901,28 @@ fu_common_spawn_sync (const gchar * const * argv,
 
 	/* allow timeout */
 	if (timeout_ms > 0) {
-		helper->timeout_id = g_timeout_add (timeout_ms,
-						    fu_common_spawn_timeout_cb,
-						    helper);
+		helper->timeout_source = g_timeout_source_new (timeout_ms);
+		g_source_set_callback (helper->timeout_source,
+				       fu_common_spawn_timeout_cb,
+				       helper, NULL);
+		g_source_attach (helper->timeout_source, helper->context);
 	}
-	fu_common_spawn_create_pollable_source (helper);
+
+	/* one source for all the output, woken on cancellation too */
+	helper->source = g_pollable_input_stream_create_source (G_POLLABLE_INPUT_STREAM (helper->stream),
+								helper->cancellable);
+	g_source_set_callback (helper->source,
+			       (GSourceFunc) fu_common_spawn_source_pollable_cb,
+			       helper, NULL);
+	g_source_attach (helper->source, helper->context);
 	g_main_loop_run (helper->loop);
 	g_cancellable_disconnect (cancellable, cancellable_id);
-	if (g_cancellable_set_error_if_cancelled (helper->cancellable, error))
+	if (g_cancellable_is_cancelled (helper->cancellable)) {
+		g_subprocess_force_exit (subprocess);
+		g_subprocess_wait (subprocess, NULL, NULL);
+		g_cancellable_set_error_if_cancelled (helper->cancellable, error);
 		return FALSE;
+	}
 	return g_subprocess_wait_check (subprocess, cancellable, error);
 }
 
@@ -1351,6 +1549,46 @@ fu_common_string_append_kb (GString *str, guint idt, const gchar *key, gboolean
 	fu_common_string_append_kv (str, idt, key, value ? "true" : "false");
 }
 
+/**
+ * fu_common_log_domain_enabled:
+ * @log_domain: log domain, typically %G_LOG_DOMAIN or %NULL
+ *
+ * Checks if debug messages for the log domain will be shown, which can be
+ * used to avoid building expensive debug strings that would just be ignored.
+ * The domains are set with the `FWUPD_VERBOSE` environment variable.
+ *
+ * Returns: %TRUE if debugging is enabled for the domain
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_common_log_domain_enabled (const gchar *log_domain)
+{
+	static GMutex mutex;
+	static gchar *domains_env = NULL;
+	static gchar **domains = NULL;
+	const gchar *tmp = g_getenv ("FWUPD_VERBOSE");
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	/* everything or nothing */
+	if (tmp == NULL)
+		return FALSE;
+	if (g_strcmp0 (tmp, "*") == 0)
+		return TRUE;
+	if (log_domain == NULL)
+		return FALSE;
+
+	/* only split again if the environment variable has changed */
+	locker = g_mutex_locker_new (&mutex);
+	if (g_strcmp0 (tmp, domains_env) != 0) {
+		g_free (domains_env);
+		g_strfreev (domains);
+		domains_env = g_strdup (tmp);
+		domains = g_strsplit (tmp, ",", -1);
+	}
+	return g_strv_contains ((const gchar * const *) domains, log_domain);
+}
+
 /**
  * fu_common_dump_full:
  * @log_domain: log domain, typically %G_LOG_DOMAIN or %NULL
@@ -1372,9 +1610,14 @@ fu_common_dump_full (const gchar *log_domain,
 		     guint columns,
 		     FuDumpFlags flags)
 {
-	g_autoptr(GString) str = g_string_new (NULL);
+	g_autoptr(GString) str = NULL;
+
+	/* the hexdump would just be ignored */
+	if (!fu_common_log_domain_enabled (log_domain))
+		return;
 
 	/* optional */
+	str = g_string_new (NULL);
 	if (title != NULL)
 		g_string_append_printf (str, "%s:", title);
 
@@ -1515,11 +1758,81 @@ fu_common_bytes_is_empty (GBytes *bytes)
 {
 	gsize sz = 0;
 	const guint8 *buf = g_bytes_get_data (bytes, &sz);
-	for (gsize i = 0; i < sz; i++) {
-		if (buf[i] != 0xff)
-			return FALSE;
+	return fu_common_data_is_empty (buf, sz);
+}
+
+/**
+ * fu_common_data_is_empty:
+ * @buf: a buffer
+ * @bufsz: sizeof @buf
+ *
+ * Checks if a buffer is just empty (0xff) bytes, e.g. a block of erased flash.
+ *
+ * The buffer is compared against itself offset by one byte, which lets the
+ * C library compare it a word at a time.
+ *
+ * Return value: %TRUE if @buf is empty
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_common_data_is_empty (const guint8 *buf, gsize bufsz)
+{
+	return fu_common_data_is_fill (buf, bufsz, 0xff);
+}
+
+/**
+ * fu_common_data_is_fill:
+ * @buf: a buffer
+ * @bufsz: sizeof @buf
+ * @value: the fill byte, e.g. 0x00
+ *
+ * Checks if a buffer is made up of just one repeated byte.
+ *
+ * Return value: %TRUE if every byte of @buf is @value
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_common_data_is_fill (const guint8 *buf, gsize bufsz, guint8 value)
+{
+	if (bufsz == 0)
+		return TRUE;
+	if (buf[0] != value)
+		return FALSE;
+	return memcmp (buf, buf + 1, bufsz - 1) == 0;
+}
+
+#define FU_COMMON_COMPARE_BLOCK_SIZE		0x100	/* bytes */
+
+/**
+ * fu_common_data_get_mismatch:
+ * @buf1: a buffer
+ * @buf2: another buffer
+ * @bufsz: sizeof @buf1 and @buf2
+ *
+ * Finds the first byte that is different in the two buffers. The buffers are
+ * compared a block at a time by the C library, and only the block that does
+ * not match is checked byte by byte.
+ *
+ * Return value: the offset of the first difference, or @bufsz if identical
+ *
+ * Since: 1.5.0
+ **/
+gsize
+fu_common_data_get_mismatch (const guint8 *buf1, const guint8 *buf2, gsize bufsz)
+{
+	gsize i = 0;
+
+	for (; i + FU_COMMON_COMPARE_BLOCK_SIZE <= bufsz; i += FU_COMMON_COMPARE_BLOCK_SIZE) {
+		if (memcmp (buf1 + i, buf2 + i, FU_COMMON_COMPARE_BLOCK_SIZE) != 0)
+			break;
 	}
-	return TRUE;
+	for (; i < bufsz; i++) {
+		if (buf1[i] != buf2[i])
+			break;
+	}
+	return i;
 }
 
 /**
@@ -1556,15 +1869,14 @@ fu_common_bytes_compare_raw (const guint8 *buf1, gsize bufsz1,
 	}
 
 	/* check matches */
-	for (guint i = 0x0; i < bufsz1; i++) {
-		if (buf1[i] != buf2[i]) {
-			g_set_error (error,
+	if (memcmp (buf1, buf2, bufsz1) != 0) {
+		gsize i = fu_common_data_get_mismatch (buf1, buf2, bufsz1);
+		g_set_error (error,
 			     G_IO_ERROR,
 			     G_IO_ERROR_INVALID_DATA,
 			     "got 0x%02x, expected 0x%02x @ 0x%04x",
-			     buf1[i], buf2[i], i);
-			return FALSE;
-		}
+			     buf1[i], buf2[i], (guint) i);
+		return FALSE;
 	}
 
 	/* success */
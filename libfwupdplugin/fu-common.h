@@ -113,6 +113,8 @@ gboolean	 fu_common_set_contents_bytes	(const gchar	*filename,
 						 GError		**error);
 GBytes		*fu_common_get_contents_bytes	(const gchar	*filename,
 						 GError		**error);
+GBytes		*fu_common_get_contents_mapped	(const gchar	*filename,
+						 GError		**error);
 GBytes		*fu_common_get_contents_fd	(gint		 fd,
 						 gsize		 count,
 						 GError		**error);
@@ -128,6 +130,7 @@ guint64		 fu_common_strtoull		(const gchar	*str);
 gchar		*fu_common_find_program_in_path	(const gchar	*basename,
 						 GError		**error);
 gchar		*fu_common_strstrip		(const gchar	*str);
+gboolean	 fu_common_log_domain_enabled	(const gchar	*log_domain);
 void		 fu_common_dump_raw		(const gchar	*log_domain,
 						 const gchar	*title,
 						 const guint8	*data,
@@ -145,6 +148,14 @@ GBytes		*fu_common_bytes_align		(GBytes		*bytes,
 						 gsize		 blksz,
 						 gchar		 padval);
 gboolean	 fu_common_bytes_is_empty	(GBytes		*bytes);
+gboolean	 fu_common_data_is_empty	(const guint8	*buf,
+						 gsize		 bufsz);
+gboolean	 fu_common_data_is_fill		(const guint8	*buf,
+						 gsize		 bufsz,
+						 guint8		 value);
+gsize		 fu_common_data_get_mismatch	(const guint8	*buf1,
+						 const guint8	*buf2,
+						 gsize		 bufsz);
 gboolean	 fu_common_bytes_compare	(GBytes		*bytes1,
 						 GBytes		*bytes2,
 						 GError		**error);
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuCrc"
+
+#include "config.h"
+
+#include "fu-crc.h"
+
+/**
+ * SECTION:fu-crc
+ * @short_description: Cyclic redundancy checks
+ *
+ * Helpers for the CRC variants used by device firmware.
+ *
+ * The 8 and 16 bit variants use a 16 entry table built for the requested
+ * polynomial, which processes a nibble at a time. The 32 bit variant uses
+ * a slice-by-8 table that is built once on first use.
+ */
+
+/**
+ * fu_crc8_full:
+ * @buf: memory buffer
+ * @bufsz: sizeof buf
+ * @crc: initial CRC value, typically 0x00
+ * @polynomial: the polynomial, without the implicit x^8 term, e.g. 0x07
+ *
+ * Returns the non-reflected CRC-8 checksum of the buffer, processing the
+ * most significant bit of each byte first. No final XOR is applied.
+ *
+ * Returns: CRC value
+ *
+ * Since: 1.5.0
+ **/
+guint8
+fu_crc8_full (const guint8 *buf, gsize bufsz, guint8 crc, guint8 polynomial)
+{
+	guint8 tbl[16];
+
+	/* the CRC of each high nibble */
+	for (guint i = 0; i < 16; i++) {
+		guint8 tmp = (guint8) (i << 4);
+		for (guint j = 0; j < 4; j++)
+			tmp = (tmp & 0x80) ? (guint8) ((tmp << 1) ^ polynomial) : (guint8) (tmp << 1);
+		tbl[i] = tmp;
+	}
+	for (gsize i = 0; i < bufsz; i++) {
+		crc ^= buf[i];
+		crc = (guint8) (crc << 4) ^ tbl[crc >> 4];
+		crc = (guint8) (crc << 4) ^ tbl[crc >> 4];
+	}
+	return crc;
+}
+
+/**
+ * fu_crc8:
+ * @buf: memory buffer
+ * @bufsz: sizeof buf
+ *
+ * Returns the CRC-8 checksum of the buffer using the polynomial 0x07 and an
+ * initial value of 0x00, as used by SMBus.
+ *
+ * Returns: CRC value
+ *
+ * Since: 1.5.0
+ **/
+guint8
+fu_crc8 (const guint8 *buf, gsize bufsz)
+{
+	return fu_crc8_full (buf, bufsz, 0x00, 0x07);
+}
+
+/**
+ * fu_crc16_full:
+ * @buf: memory buffer
+ * @bufsz: sizeof buf
+ * @crc: initial CRC value, typically 0x0000 or 0xffff
+ * @polynomial: the polynomial, without the implicit x^16 term, e.g. 0x8005
+ *
+ * Returns the non-reflected CRC-16 checksum of the buffer, processing the
+ * most significant bit of each byte first. No final XOR is applied.
+ *
+ * Returns: CRC value
+ *
+ * Since: 1.5.0
+ **/
+guint16
+fu_crc16_full (const guint8 *buf, gsize bufsz, guint16 crc, guint16 polynomial)
+{
+	guint16 tbl[16];
+
+	/* the CRC of each high nibble */
+	for (guint i = 0; i < 16; i++) {
+		guint16 tmp = (guint16) (i << 12);
+		for (guint j = 0; j < 4; j++)
+			tmp = (tmp & 0x8000) ? (guint16) ((tmp << 1) ^ polynomial) : (guint16) (tmp << 1);
+		tbl[i] = tmp;
+	}
+	for (gsize i = 0; i < bufsz; i++) {
+		crc ^= (guint16) buf[i] << 8;
+		crc = (guint16) (crc << 4) ^ tbl[crc >> 12];
+		crc = (guint16) (crc << 4) ^ tbl[crc >> 12];
+	}
+	return crc;
+}
+
+/**
+ * fu_crc16_reflected_full:
+ * @buf: memory buffer
+ * @bufsz: sizeof buf
+ * @crc: initial CRC value, typically 0x0000 or 0xffff
+ * @polynomial: the bit-reversed polynomial, e.g. 0xa001 for 0x8005
+ *
+ * Returns the reflected CRC-16 checksum of the buffer, processing the
+ * least significant bit of each byte first. No final XOR is applied.
+ *
+ * Returns: CRC value
+ *
+ * Since: 1.5.0
+ **/
+guint16
+fu_crc16_reflected_full (const guint8 *buf, gsize bufsz, guint16 crc, guint16 polynomial)
+{
+	guint16 tbl[16];
+
+	/* the CRC of each low nibble */
+	for (guint i = 0; i < 16; i++) {
+		guint16 tmp = (guint16) i;
+		for (guint j = 0; j < 4; j++)
+			tmp = (tmp & 0x1) ? (tmp >> 1) ^ polynomial : tmp >> 1;
+		tbl[i] = tmp;
+	}
+	for (gsize i = 0; i < bufsz; i++) {
+		crc ^= buf[i];
+		crc = (crc >> 4) ^ tbl[crc & 0xf];
+		crc = (crc >> 4) ^ tbl[crc & 0xf];
+	}
+	return crc;
+}
+
+/**
+ * fu_crc16:
+ * @buf: memory buffer
+ * @bufsz: sizeof buf
+ *
+ * Returns the non-reflected CRC-16 checksum of the buffer using the
+ * polynomial 0x8005 and an initial value of 0x0000.
+ *
+ * Returns: CRC value
+ *
+ * Since: 1.5.0
+ **/
+guint16
+fu_crc16 (const guint8 *buf, gsize bufsz)
+{
+	return fu_crc16_full (buf, bufsz, 0x0000, 0x8005);
+}
+
+static guint32 fu_crc32_tbl[8][256];
+
+static void
+fu_crc32_ensure_tbl (void)
+{
+	static gsize tbl_init = 0;
+	if (!g_once_init_enter (&tbl_init))
+		return;
+	for (guint i = 0; i < 256; i++) {
+		guint32 tmp = i;
+		for (guint j = 0; j < 8; j++)
+			tmp = (tmp & 0x1) ? (tmp >> 1) ^ 0xedb88320 : tmp >> 1;
+		fu_crc32_tbl[0][i] = tmp;
+	}
+	for (guint i = 0; i < 256; i++) {
+		for (guint k = 1; k < 8; k++) {
+			guint32 tmp = fu_crc32_tbl[k - 1][i];
+			fu_crc32_tbl[k][i] = (tmp >> 8) ^ fu_crc32_tbl[0][tmp & 0xff];
+		}
+	}
+	g_once_init_leave (&tbl_init, 1);
+}
+
+/**
+ * fu_crc32_full:
+ * @buf: memory buffer
+ * @bufsz: sizeof buf
+ * @crc: initial CRC value, typically 0xffffffff
+ *
+ * Returns the reflected CRC-32 of the buffer using the polynomial 0x04c11db7.
+ * No final XOR is applied, which allows the checksum to be calculated in
+ * multiple calls and matches the value stored in the DFU file suffix.
+ *
+ * Returns: CRC value
+ *
+ * Since: 1.5.0
+ **/
+guint32
+fu_crc32_full (const guint8 *buf, gsize bufsz, guint32 crc)
+{
+	gsize i = 0;
+
+	fu_crc32_ensure_tbl ();
+
+	/* eight bytes at a time */
+	for (; i + 8 <= bufsz; i += 8) {
+		guint32 one = crc ^ ((guint32) buf[i + 0] |
+				     (guint32) buf[i + 1] << 8 |
+				     (guint32) buf[i + 2] << 16 |
+				     (guint32) buf[i + 3] << 24);
+		crc = fu_crc32_tbl[7][one & 0xff] ^
+		      fu_crc32_tbl[6][(one >> 8) & 0xff] ^
+		      fu_crc32_tbl[5][(one >> 16) & 0xff] ^
+		      fu_crc32_tbl[4][one >> 24] ^
+		      fu_crc32_tbl[3][buf[i + 4]] ^
+		      fu_crc32_tbl[2][buf[i + 5]] ^
+		      fu_crc32_tbl[1][buf[i + 6]] ^
+		      fu_crc32_tbl[0][buf[i + 7]];
+	}
+
+	/* remainder */
+	for (; i < bufsz; i++)
+		crc = fu_crc32_tbl[0][(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+	return crc;
+}
+
+/**
+ * fu_crc32:
+ * @buf: memory buffer
+ * @bufsz: sizeof buf
+ *
+ * Returns the standard CRC-32 checksum of the buffer, as used by zlib and
+ * Ethernet.
+ *
+ * Returns: CRC value
+ *
+ * Since: 1.5.0
+ **/
+guint32
+fu_crc32 (const guint8 *buf, gsize bufsz)
+{
+	return ~fu_crc32_full (buf, bufsz, 0xffffffff);
+}
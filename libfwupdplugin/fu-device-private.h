@@ -11,6 +11,8 @@
 
 #define fu_device_set_plugin(d,v)		fwupd_device_set_plugin(FWUPD_DEVICE(d),v)
 
+typedef struct _FuDeviceFirmwareShare FuDeviceFirmwareShare;
+
 GPtrArray	*fu_device_get_parent_guids		(FuDevice	*self);
 gboolean	 fu_device_has_parent_guid		(FuDevice	*self,
 							 const gchar	*guid);
@@ -29,3 +31,20 @@ void		 fu_device_incorporate_from_component	(FuDevice	*device,
 void		 fu_device_convert_instance_ids		(FuDevice	*self);
 gchar		*fu_device_get_guids_as_str		(FuDevice	*self);
 GPtrArray	*fu_device_get_possible_plugins		(FuDevice	*self);
+void		 fu_device_set_setup_cache		(FuDevice	*self,
+							 GVariant	*setup_cache);
+gboolean	 fu_device_ensure_setup			(FuDevice	*self,
+							 GError		**error);
+gboolean	 fu_device_get_setup_deferred		(FuDevice	*self);
+void		 fu_device_defer_progress_notify	(FuDevice	*self);
+void		 fu_device_flush_progress_notify	(FuDevice	*self);
+FuDeviceFirmwareShare *fu_device_firmware_share_new	(void);
+void		 fu_device_firmware_share_free		(FuDeviceFirmwareShare *share);
+void		 fu_device_set_firmware_share		(FuDevice	*self,
+							 FuDeviceFirmwareShare *share);
+gboolean	 fu_device_preload_firmware		(FuDevice	*self,
+							 GBytes		*fw,
+							 FwupdInstallFlags flags,
+							 GError		**error);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuDeviceFirmwareShare, fu_device_firmware_share_free)
@@ -14,8 +14,11 @@
 
 #include "fu-common.h"
 #include "fu-common-version.h"
+#include "fu-device-locker.h"
 #include "fu-device-private.h"
 #include "fu-mutex.h"
+#include "fu-timeline-private.h"
+#include "fu-trace-private.h"
 
 #include "fwupd-common.h"
 #include "fwupd-device-private.h"
@@ -41,28 +44,39 @@ typedef struct {
 	FuDevice			*parent;	/* noref */
 	FuDevice			*proxy;		/* noref */
 	FuQuirks			*quirks;
-	GHashTable			*metadata;
+	GArray				*metadata;	/* of FuDeviceMetadataItem */
 	GRWLock				 metadata_mutex;
 	GPtrArray			*parent_guids;
 	GRWLock				 parent_guids_mutex;
 	GPtrArray			*children;
 	guint				 remove_delay;	/* ms */
-	guint				 progress;
+	guint				 progress;	/* atomic */
+	gint				 progress_deferred; /* atomic */
 	guint				 order;
 	guint				 priority;
 	guint				 poll_id;
 	gboolean			 done_probe;
 	gboolean			 done_setup;
+	gboolean			 setup_deferred;
+	GVariant			*setup_cache;
 	gboolean			 device_id_valid;
 	guint64				 size_min;
 	guint64				 size_max;
 	gint				 open_refcount;	/* atomic */
 	GType				 specialized_gtype;
-	GPtrArray			*possible_plugins;
+	GPtrArray			*possible_plugins;	/* interned */
 	GPtrArray			*retry_recs;	/* of FuDeviceRetryRecovery */
 	guint				 retry_delay;
+	FuDeviceFirmwareShare		*firmware_share;	/* noref, nullable */
 } FuDevicePrivate;
 
+struct _FuDeviceFirmwareShare {
+	GMutex				 mutex;
+	GBytes				*fw;
+	FwupdInstallFlags		 flags;
+	FuFirmware			*firmware;
+};
+
 typedef struct {
 	GQuark				 domain;
 	gint				 code;
@@ -91,7 +105,7 @@ fu_device_get_property (GObject *object, guint prop_id,
 	FuDevicePrivate *priv = GET_PRIVATE (self);
 	switch (prop_id) {
 	case PROP_PROGRESS:
-		g_value_set_uint (value, priv->progress);
+		g_value_set_uint (value, (guint) g_atomic_int_get (&priv->progress));
 		break;
 	case PROP_PHYSICAL_ID:
 		g_value_set_string (value, priv->physical_id);
@@ -175,7 +189,7 @@ static void
 fu_device_add_possible_plugin (FuDevice *self, const gchar *plugin)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
-	g_ptr_array_add (priv->possible_plugins, g_strdup (plugin));
+	g_ptr_array_add (priv->possible_plugins, (gpointer) g_intern_string (plugin));
 }
 
 /**
@@ -320,6 +334,112 @@ fu_device_retry (FuDevice *self,
 	return TRUE;
 }
 
+#define FU_DEVICE_WAIT_DELAY_MIN	50	/* us */
+#define FU_DEVICE_WAIT_DELAY_MAX	100000	/* us */
+
+/* learned completion times in us, keyed by the #FuDeviceWaitFunc; the
+ * function is private to the plugin so this is effectively per-device-type */
+static GHashTable *fu_device_wait_learned = NULL;
+G_LOCK_DEFINE_STATIC (fu_device_wait_learned);
+
+static gulong
+fu_device_wait_get_learned (FuDeviceWaitFunc func)
+{
+	gpointer value = NULL;
+	G_LOCK (fu_device_wait_learned);
+	if (fu_device_wait_learned != NULL)
+		value = g_hash_table_lookup (fu_device_wait_learned, func);
+	G_UNLOCK (fu_device_wait_learned);
+	return GPOINTER_TO_SIZE (value);
+}
+
+static void
+fu_device_wait_set_learned (FuDeviceWaitFunc func, gulong elapsed)
+{
+	gulong learned;
+	G_LOCK (fu_device_wait_learned);
+	if (fu_device_wait_learned == NULL)
+		fu_device_wait_learned = g_hash_table_new (g_direct_hash, g_direct_equal);
+	learned = GPOINTER_TO_SIZE (g_hash_table_lookup (fu_device_wait_learned, func));
+
+	/* moving average, so one slow completion does not dominate */
+	learned = learned == 0 ? elapsed : (learned * 3 + elapsed) / 4;
+	g_hash_table_insert (fu_device_wait_learned, func, GSIZE_TO_POINTER (learned));
+	G_UNLOCK (fu_device_wait_learned);
+}
+
+/**
+ * fu_device_wait_for:
+ * @self: A #FuDevice
+ * @func: (scope call): A function to check if the device is ready
+ * @timeout: timeout in ms
+ * @user_data: (nullable): a helper to pass to @func
+ * @error: A #GError
+ *
+ * Calls @func until it sets @done to %TRUE, returns %FALSE or @timeout is
+ * reached. Errors returned by @func are fatal and are not retried.
+ *
+ * The function is called straight away, and then with an exponentially
+ * increasing delay between calls. The time each @func takes to complete is
+ * remembered, and future waits using the same @func sleep for most of that
+ * time before checking again, which means fast devices are not made to wait
+ * for the worst-case delay and slow devices are not polled needlessly.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_device_wait_for (FuDevice *self,
+		    FuDeviceWaitFunc func,
+		    guint timeout,
+		    gpointer user_data,
+		    GError **error)
+{
+	gulong delay = FU_DEVICE_WAIT_DELAY_MIN;
+	gulong learned;
+	gulong timeout_us = (gulong) timeout * 1000;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
+	g_return_val_if_fail (func != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* skip most of the time we expect this to take */
+	learned = fu_device_wait_get_learned (func);
+	for (guint i = 0; ; i++) {
+		gboolean done = FALSE;
+		gulong elapsed;
+
+		if (!func (self, &done, user_data, error))
+			return FALSE;
+		elapsed = (gulong) (g_timer_elapsed (timer, NULL) * G_USEC_PER_SEC);
+		if (done) {
+			fu_device_wait_set_learned (func, elapsed);
+			break;
+		}
+		if (elapsed >= timeout_us) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_TIMED_OUT,
+				     "timed out after %ums and %u tries",
+				     timeout, i + 1);
+			return FALSE;
+		}
+
+		/* sleep, but never past the deadline */
+		if (i == 0 && learned > elapsed + delay) {
+			g_usleep (MIN ((learned - elapsed) * 3 / 4, timeout_us - elapsed));
+			continue;
+		}
+		g_usleep (MIN (delay, timeout_us - elapsed));
+		delay = MIN (delay * 2, FU_DEVICE_WAIT_DELAY_MAX);
+	}
+
+	/* success */
+	return TRUE;
+}
+
 /**
  * fu_device_poll:
  * @self: A #FuDevice
@@ -849,6 +969,68 @@ fu_device_has_parent_guid (FuDevice *self, const gchar *guid)
 	return FALSE;
 }
 
+#define FU_DEVICE_GUID_CACHE_MAX	1024	/* entries */
+
+typedef struct {
+	gchar		*instance_id;
+	gchar		*guid;
+} FuDeviceGuidCacheItem;
+
+/* the same instance IDs are hashed for every device, on every hotplug, so keep
+ * the most recently used; the queue is in order of use, newest first */
+static GHashTable *fu_device_guid_cache = NULL;	/* instance_id:GList */
+static GQueue fu_device_guid_cache_order = G_QUEUE_INIT;
+G_LOCK_DEFINE_STATIC (fu_device_guid_cache);
+
+static gchar *
+fu_device_guid_hash_string (const gchar *instance_id)
+{
+	FuDeviceGuidCacheItem *item;
+	GList *link;
+	gchar *guid;
+
+	G_LOCK (fu_device_guid_cache);
+	if (fu_device_guid_cache == NULL)
+		fu_device_guid_cache = g_hash_table_new (g_str_hash, g_str_equal);
+	link = g_hash_table_lookup (fu_device_guid_cache, instance_id);
+	if (link != NULL) {
+		item = link->data;
+		g_queue_unlink (&fu_device_guid_cache_order, link);
+		g_queue_push_head_link (&fu_device_guid_cache_order, link);
+		guid = g_strdup (item->guid);
+		G_UNLOCK (fu_device_guid_cache);
+		return guid;
+	}
+	G_UNLOCK (fu_device_guid_cache);
+
+	/* not holding the lock while hashing */
+	guid = fwupd_guid_hash_string (instance_id);
+	if (guid == NULL)
+		return NULL;
+
+	G_LOCK (fu_device_guid_cache);
+	if (!g_hash_table_contains (fu_device_guid_cache, instance_id)) {
+		item = g_new0 (FuDeviceGuidCacheItem, 1);
+		item->instance_id = g_strdup (instance_id);
+		item->guid = g_strdup (guid);
+		g_queue_push_head (&fu_device_guid_cache_order, item);
+		g_hash_table_insert (fu_device_guid_cache,
+				     item->instance_id,
+				     fu_device_guid_cache_order.head);
+	}
+
+	/* drop the least recently used */
+	if (fu_device_guid_cache_order.length > FU_DEVICE_GUID_CACHE_MAX) {
+		item = g_queue_pop_tail (&fu_device_guid_cache_order);
+		g_hash_table_remove (fu_device_guid_cache, item->instance_id);
+		g_free (item->instance_id);
+		g_free (item->guid);
+		g_free (item);
+	}
+	G_UNLOCK (fu_device_guid_cache);
+	return guid;
+}
+
 /**
  * fu_device_add_parent_guid:
  * @self: A #FuDevice
@@ -876,7 +1058,7 @@ fu_device_add_parent_guid (FuDevice *self, const gchar *guid)
 
 	/* make valid */
 	if (!fwupd_guid_is_valid (guid)) {
-		g_autofree gchar *tmp = fwupd_guid_hash_string (guid);
+		g_autofree gchar *tmp = fu_device_guid_hash_string (guid);
 		if (fu_device_has_parent_guid (self, tmp))
 			return;
 		g_debug ("using %s for %s", tmp, guid);
@@ -1228,17 +1410,20 @@ fu_device_add_guid_safe (FuDevice *self, const gchar *guid)
 gboolean
 fu_device_has_guid (FuDevice *self, const gchar *guid)
 {
+	g_autofree gchar *tmp = NULL;
+
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (guid != NULL, FALSE);
 
-	/* make valid */
-	if (!fwupd_guid_is_valid (guid)) {
-		g_autofree gchar *tmp = fwupd_guid_hash_string (guid);
-		return fwupd_device_has_guid (FWUPD_DEVICE (self), tmp);
-	}
+	/* already valid, and the common case */
+	if (fwupd_device_has_guid (FWUPD_DEVICE (self), guid))
+		return TRUE;
+	if (fwupd_guid_is_valid (guid))
+		return FALSE;
 
-	/* already valid */
-	return fwupd_device_has_guid (FWUPD_DEVICE (self), guid);
+	/* make valid */
+	tmp = fu_device_guid_hash_string (guid);
+	return fwupd_device_has_guid (FWUPD_DEVICE (self), tmp);
 }
 
 /**
@@ -1268,7 +1453,7 @@ fu_device_add_instance_id_full (FuDevice *self,
 	 * calling fu_device_add_guid_safe() -- but we want the quirks to match
 	 * so the plugin is set, but not the LVFS metadata to match firmware
 	 * until we're sure the device isn't using _NO_AUTO_INSTANCE_IDS */
-	guid = fwupd_guid_hash_string (instance_id);
+	guid = fu_device_guid_hash_string (instance_id);
 	fu_device_add_guid_quirks (self, guid);
 	if ((flags & FU_DEVICE_INSTANCE_FLAG_ONLY_QUIRKS) == 0)
 		fwupd_device_add_instance_id (FWUPD_DEVICE (self), instance_id);
@@ -1336,7 +1521,7 @@ fu_device_add_counterpart_guid (FuDevice *self, const gchar *guid)
 
 	/* make valid */
 	if (!fwupd_guid_is_valid (guid)) {
-		g_autofree gchar *tmp = fwupd_guid_hash_string (guid);
+		g_autofree gchar *tmp = fu_device_guid_hash_string (guid);
 		fwupd_device_add_guid (FWUPD_DEVICE (self), tmp);
 		return;
 	}
@@ -1371,6 +1556,67 @@ fu_device_get_guids_as_str (FuDevice *self)
 	return g_strjoinv (",", tmp);
 }
 
+/* the integer and boolean values are parsed when set, so reads are cheap */
+typedef struct {
+	const gchar	*key;		/* interned */
+	gchar		*value;
+	guint		 value_int;	/* G_MAXUINT if not an integer */
+	gboolean	 value_bool;
+} FuDeviceMetadataItem;
+
+static void
+fu_device_metadata_item_clear (FuDeviceMetadataItem *item)
+{
+	g_free (item->value);
+}
+
+/* devices only have a few items, so a linear search is fastest */
+static FuDeviceMetadataItem *
+fu_device_metadata_find (GArray *metadata, const gchar *key, guint *idx)
+{
+	for (guint i = 0; i < metadata->len; i++) {
+		FuDeviceMetadataItem *item = &g_array_index (metadata, FuDeviceMetadataItem, i);
+		if (item->key == key || g_strcmp0 (item->key, key) == 0) {
+			if (idx != NULL)
+				*idx = i;
+			return item;
+		}
+	}
+	return NULL;
+}
+
+/* takes ownership of @value */
+static void
+fu_device_metadata_insert (GArray *metadata,
+			   const gchar *key,
+			   gchar *value,
+			   guint value_int,
+			   gboolean value_bool)
+{
+	FuDeviceMetadataItem *item = fu_device_metadata_find (metadata, key, NULL);
+	if (item == NULL) {
+		FuDeviceMetadataItem item_new = { g_intern_string (key), NULL, 0, FALSE };
+		g_array_append_val (metadata, item_new);
+		item = &g_array_index (metadata, FuDeviceMetadataItem, metadata->len - 1);
+	}
+	g_free (item->value);
+	item->value = value;
+	item->value_int = value_int;
+	item->value_bool = value_bool;
+}
+
+static guint
+fu_device_metadata_parse_integer (const gchar *value)
+{
+	gchar *endptr = NULL;
+	guint64 val = g_ascii_strtoull (value, &endptr, 10);
+	if (endptr != NULL && endptr[0] != '\0')
+		return G_MAXUINT;
+	if (val > G_MAXUINT)
+		return G_MAXUINT;
+	return (guint) val;
+}
+
 /**
  * fu_device_get_metadata:
  * @self: A #FuDevice
@@ -1386,11 +1632,13 @@ const gchar *
 fu_device_get_metadata (FuDevice *self, const gchar *key)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
+	FuDeviceMetadataItem *item;
 	g_autoptr(GRWLockReaderLocker) locker = g_rw_lock_reader_locker_new (&priv->metadata_mutex);
 	g_return_val_if_fail (FU_IS_DEVICE (self), NULL);
 	g_return_val_if_fail (key != NULL, NULL);
 	g_return_val_if_fail (locker != NULL, NULL);
-	return g_hash_table_lookup (priv->metadata, key);
+	item = fu_device_metadata_find (priv->metadata, key, NULL);
+	return item != NULL ? item->value : NULL;
 }
 
 /**
@@ -1408,17 +1656,17 @@ gboolean
 fu_device_get_metadata_boolean (FuDevice *self, const gchar *key)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
-	const gchar *tmp;
+	FuDeviceMetadataItem *item;
 	g_autoptr(GRWLockReaderLocker) locker = g_rw_lock_reader_locker_new (&priv->metadata_mutex);
 
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (key != NULL, FALSE);
 	g_return_val_if_fail (locker != NULL, FALSE);
 
-	tmp = g_hash_table_lookup (priv->metadata, key);
-	if (tmp == NULL)
+	item = fu_device_metadata_find (priv->metadata, key, NULL);
+	if (item == NULL)
 		return FALSE;
-	return g_strcmp0 (tmp, "true") == 0;
+	return item->value_bool;
 }
 
 /**
@@ -1436,24 +1684,17 @@ guint
 fu_device_get_metadata_integer (FuDevice *self, const gchar *key)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
-	const gchar *tmp;
-	gchar *endptr = NULL;
-	guint64 val;
+	FuDeviceMetadataItem *item;
 	g_autoptr(GRWLockReaderLocker) locker = g_rw_lock_reader_locker_new (&priv->metadata_mutex);
 
 	g_return_val_if_fail (FU_IS_DEVICE (self), G_MAXUINT);
 	g_return_val_if_fail (key != NULL, G_MAXUINT);
 	g_return_val_if_fail (locker != NULL, G_MAXUINT);
 
-	tmp = g_hash_table_lookup (priv->metadata, key);
-	if (tmp == NULL)
-		return G_MAXUINT;
-	val = g_ascii_strtoull (tmp, &endptr, 10);
-	if (endptr != NULL && endptr[0] != '\0')
+	item = fu_device_metadata_find (priv->metadata, key, NULL);
+	if (item == NULL)
 		return G_MAXUINT;
-	if (val > G_MAXUINT)
-		return G_MAXUINT;
-	return (guint) val;
+	return item->value_int;
 }
 
 /**
@@ -1469,11 +1710,13 @@ void
 fu_device_remove_metadata (FuDevice *self, const gchar *key)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
+	guint idx = 0;
 	g_autoptr(GRWLockWriterLocker) locker = g_rw_lock_writer_locker_new (&priv->metadata_mutex);
 	g_return_if_fail (FU_IS_DEVICE (self));
 	g_return_if_fail (key != NULL);
 	g_return_if_fail (locker != NULL);
-	g_hash_table_remove (priv->metadata, key);
+	if (fu_device_metadata_find (priv->metadata, key, &idx) != NULL)
+		g_array_remove_index (priv->metadata, idx);
 }
 
 /**
@@ -1495,7 +1738,9 @@ fu_device_set_metadata (FuDevice *self, const gchar *key, const gchar *value)
 	g_return_if_fail (key != NULL);
 	g_return_if_fail (value != NULL);
 	g_return_if_fail (locker != NULL);
-	g_hash_table_insert (priv->metadata, g_strdup (key), g_strdup (value));
+	fu_device_metadata_insert (priv->metadata, key, g_strdup (value),
+				   fu_device_metadata_parse_integer (value),
+				   g_strcmp0 (value, "true") == 0);
 }
 
 /**
@@ -1512,10 +1757,16 @@ fu_device_set_metadata (FuDevice *self, const gchar *key, const gchar *value)
 void
 fu_device_set_metadata_boolean (FuDevice *self, const gchar *key, gboolean value)
 {
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GRWLockWriterLocker) locker = g_rw_lock_writer_locker_new (&priv->metadata_mutex);
+
 	g_return_if_fail (FU_IS_DEVICE (self));
 	g_return_if_fail (key != NULL);
+	g_return_if_fail (locker != NULL);
 
-	fu_device_set_metadata (self, key, value ? "true" : "false");
+	fu_device_metadata_insert (priv->metadata, key,
+				   g_strdup (value ? "true" : "false"),
+				   G_MAXUINT, value);
 }
 
 /**
@@ -1532,12 +1783,16 @@ fu_device_set_metadata_boolean (FuDevice *self, const gchar *key, gboolean value
 void
 fu_device_set_metadata_integer (FuDevice *self, const gchar *key, guint value)
 {
-	g_autofree gchar *tmp = g_strdup_printf ("%u", value);
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GRWLockWriterLocker) locker = g_rw_lock_writer_locker_new (&priv->metadata_mutex);
 
 	g_return_if_fail (FU_IS_DEVICE (self));
 	g_return_if_fail (key != NULL);
+	g_return_if_fail (locker != NULL);
 
-	fu_device_set_metadata (self, key, tmp);
+	fu_device_metadata_insert (priv->metadata, key,
+				   g_strdup_printf ("%u", value),
+				   value, FALSE);
 }
 
 /**
@@ -2188,7 +2443,7 @@ fu_device_get_progress (FuDevice *self)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
 	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
-	return priv->progress;
+	return (guint) g_atomic_int_get (&priv->progress);
 }
 
 /**
@@ -2205,9 +2460,50 @@ fu_device_set_progress (FuDevice *self, guint progress)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
 	g_return_if_fail (FU_IS_DEVICE (self));
-	if (priv->progress == progress)
+	if ((guint) g_atomic_int_get (&priv->progress) == progress)
+		return;
+	g_atomic_int_set (&priv->progress, progress);
+	if (g_atomic_int_get (&priv->progress_deferred))
+		return;
+	g_object_notify (G_OBJECT (self), "progress");
+}
+
+/**
+ * fu_device_defer_progress_notify:
+ * @self: A #FuDevice
+ *
+ * Stops fu_device_set_progress() emitting ::notify until
+ * fu_device_flush_progress_notify() is called. The value is still stored, so
+ * the owner can poll fu_device_get_progress() at its own rate rather than
+ * running every handler in the thread writing the firmware.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_device_defer_progress_notify (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_DEVICE (self));
+	g_atomic_int_set (&priv->progress_deferred, TRUE);
+}
+
+/**
+ * fu_device_flush_progress_notify:
+ * @self: A #FuDevice
+ *
+ * Emits ::notify for the progress once, and then stops deferring it.
+ *
+ * This must be called from the thread that owns the daemon main context.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_device_flush_progress_notify (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_DEVICE (self));
+	if (!g_atomic_int_compare_and_exchange (&priv->progress_deferred, TRUE, FALSE))
 		return;
-	priv->progress = progress;
 	g_object_notify (G_OBJECT (self), "progress");
 }
 
@@ -2238,7 +2534,6 @@ fu_device_add_string (FuDevice *self, guint idt, GString *str)
 	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
 	FuDevicePrivate *priv = GET_PRIVATE (self);
 	g_autofree gchar *tmp = NULL;
-	g_autoptr(GList) keys = NULL;
 	g_autoptr(GRWLockReaderLocker) locker = g_rw_lock_reader_locker_new (&priv->metadata_mutex);
 
 	g_return_if_fail (locker != NULL);
@@ -2273,11 +2568,9 @@ fu_device_add_string (FuDevice *self, guint idt, GString *str)
 		fu_common_string_append_ku (str, idt + 1, "Order", priv->order);
 	if (priv->priority > 0)
 		fu_common_string_append_ku (str, idt + 1, "Priority", priv->priority);
-	keys = g_hash_table_get_keys (priv->metadata);
-	for (GList *l = keys; l != NULL; l = l->next) {
-		const gchar *key = l->data;
-		const gchar *value = g_hash_table_lookup (priv->metadata, key);
-		fu_common_string_append_kv (str, idt + 1, key, value);
+	for (guint i = 0; i < priv->metadata->len; i++) {
+		FuDeviceMetadataItem *item = &g_array_index (priv->metadata, FuDeviceMetadataItem, i);
+		fu_common_string_append_kv (str, idt + 1, item->key, item->value);
 	}
 
 	/* subclassed */
@@ -2373,6 +2666,151 @@ fu_device_get_release_default (FuDevice *self)
 	return rel;
 }
 
+typedef struct {
+	gint64		 start;
+	gint64		 chunk_start;
+} FuDeviceTimelineHelper;
+
+static void
+fu_device_timeline_progress_cb (FuDevice *self, GParamSpec *pspec, gpointer user_data)
+{
+	FuDeviceTimelineHelper *helper = (FuDeviceTimelineHelper *) user_data;
+	g_autofree gchar *detail = g_strdup_printf ("%u%%", fu_device_get_progress (self));
+	fu_timeline_add ("device", "write-chunk", detail, helper->chunk_start);
+	helper->chunk_start = fu_timeline_begin ();
+}
+
+/**
+ * fu_device_firmware_share_new:
+ *
+ * Creates a place to store the firmware prepared for one device so that it
+ * can be reused by other identical devices being updated at the same time.
+ *
+ * Returns: (transfer full): a #FuDeviceFirmwareShare
+ *
+ * Since: 1.5.0
+ **/
+FuDeviceFirmwareShare *
+fu_device_firmware_share_new (void)
+{
+	FuDeviceFirmwareShare *share = g_new0 (FuDeviceFirmwareShare, 1);
+	g_mutex_init (&share->mutex);
+	return share;
+}
+
+/**
+ * fu_device_firmware_share_free:
+ * @share: A #FuDeviceFirmwareShare
+ *
+ * Frees the shared firmware. No device may still be using @share.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_device_firmware_share_free (FuDeviceFirmwareShare *share)
+{
+	if (share->fw != NULL)
+		g_bytes_unref (share->fw);
+	if (share->firmware != NULL)
+		g_object_unref (share->firmware);
+	g_mutex_clear (&share->mutex);
+	g_free (share);
+}
+
+/**
+ * fu_device_set_firmware_share:
+ * @self: A #FuDevice
+ * @share: (nullable): A #FuDeviceFirmwareShare
+ *
+ * Sets the place to store the prepared firmware. When fu_device_write_firmware()
+ * is called with the same blob and flags as a device sharing @share, the
+ * #FuFirmware from the first device is used rather than calling
+ * prepare_firmware() again.
+ *
+ * This should only be used for devices with the same type and GUIDs, and the
+ * caller must unset @share on each device before it is freed.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_device_set_firmware_share (FuDevice *self, FuDeviceFirmwareShare *share)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_DEVICE (self));
+	priv->firmware_share = share;
+}
+
+/* the first device prepares the firmware, and the others wait for it */
+static FuFirmware *
+fu_device_prepare_firmware_shared (FuDevice *self,
+				   GBytes *fw,
+				   FwupdInstallFlags flags,
+				   GError **error)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	FuDeviceFirmwareShare *share = priv->firmware_share;
+	g_autoptr(FuFirmware) firmware = NULL;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	if (share == NULL)
+		return fu_device_prepare_firmware (self, fw, flags, error);
+	locker = g_mutex_locker_new (&share->mutex);
+	if (share->firmware != NULL &&
+	    share->flags == flags &&
+	    g_bytes_equal (share->fw, fw)) {
+		g_debug ("using firmware prepared for an identical device");
+		return g_object_ref (share->firmware);
+	}
+	firmware = fu_device_prepare_firmware (self, fw, flags, error);
+	if (firmware == NULL)
+		return NULL;
+	g_clear_pointer (&share->fw, g_bytes_unref);
+	g_clear_object (&share->firmware);
+	share->fw = g_bytes_ref (fw);
+	share->flags = flags;
+	share->firmware = g_object_ref (firmware);
+	return g_steal_pointer (&firmware);
+}
+
+/**
+ * fu_device_preload_firmware:
+ * @self: A #FuDevice
+ * @fw: A #GBytes
+ * @flags: #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_FORCE
+ * @error: A #GError, or %NULL
+ *
+ * Prepares the firmware ahead of time, storing it in the share set using
+ * fu_device_set_firmware_share(). A later fu_device_write_firmware() with the
+ * same blob and flags then does not need to prepare it again.
+ *
+ * Returns: %TRUE on success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_device_preload_firmware (FuDevice *self,
+			    GBytes *fw,
+			    FwupdInstallFlags flags,
+			    GError **error)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_autoptr(FuFirmware) firmware = NULL;
+
+	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
+	g_return_val_if_fail (fw != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (priv->firmware_share == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "no firmware share set");
+		return FALSE;
+	}
+	firmware = fu_device_prepare_firmware_shared (self, fw, flags, error);
+	return firmware != NULL;
+}
+
 /**
  * fu_device_write_firmware:
  * @self: A #FuDevice
@@ -2393,12 +2831,19 @@ fu_device_write_firmware (FuDevice *self,
 			  GError **error)
 {
 	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
+	FuDeviceTimelineHelper helper = { 0 };
+	gboolean ret;
+	gulong progress_id = 0;
 	g_autoptr(FuFirmware) firmware = NULL;
 	g_autofree gchar *str = NULL;
 
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	/* restored from the cache */
+	if (!fu_device_ensure_setup (self, error))
+		return FALSE;
+
 	/* no plugin-specific method */
 	if (klass->write_firmware == NULL) {
 		g_set_error_literal (error,
@@ -2409,14 +2854,128 @@ fu_device_write_firmware (FuDevice *self,
 	}
 
 	/* prepare (e.g. decompress) firmware */
-	firmware = fu_device_prepare_firmware (self, fw, flags, error);
+	firmware = fu_device_prepare_firmware_shared (self, fw, flags, error);
 	if (firmware == NULL)
 		return FALSE;
 	str = fu_firmware_to_string (firmware);
 	g_debug ("installing onto %s:\n%s", fu_device_get_id (self), str);
 
+	/* each progress update is typically one chunk */
+	if (fu_timeline_get_enabled ()) {
+		helper.start = fu_timeline_begin ();
+		helper.chunk_start = helper.start;
+		progress_id = g_signal_connect (self, "notify::progress",
+						G_CALLBACK (fu_device_timeline_progress_cb),
+						&helper);
+	}
+
 	/* call vfunc */
-	return klass->write_firmware (self, firmware, flags, error);
+	FU_TRACE2 (device_write_firmware_begin, fu_device_get_id (self), g_bytes_get_size (fw));
+	ret = klass->write_firmware (self, firmware, flags, error);
+	FU_TRACE2 (device_write_firmware_end, fu_device_get_id (self), ret);
+	if (progress_id != 0) {
+		g_signal_handler_disconnect (self, progress_id);
+		fu_timeline_add ("device", "write", fu_device_get_id (self), helper.start);
+	}
+	return ret;
+}
+
+/**
+ * fu_device_write_firmware_stream:
+ * @self: A #FuDevice
+ * @stream: A #GInputStream, e.g. from fu_checksum_input_stream_new()
+ * @streamsz: The total number of bytes that will be read from @stream
+ * @flags: #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_FORCE
+ * @error: A #GError
+ *
+ * Writes firmware to the device as it is read from @stream, which allows the
+ * device write to overlap with a slow download.
+ *
+ * Devices that cannot consume the firmware incrementally read the entire
+ * stream and then use fu_device_write_firmware().
+ *
+ * The device must read until the end of the stream before activating the
+ * new firmware, as a verification error may only be returned at the end.
+ *
+ * Returns: %TRUE on success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_device_write_firmware_stream (FuDevice *self,
+				 GInputStream *stream,
+				 gsize streamsz,
+				 FwupdInstallFlags flags,
+				 GError **error)
+{
+	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	gsize bytes_read = 0;
+	guint8 tmp = 0x0;
+	gssize rc;
+	g_autofree guint8 *buf = NULL;
+	g_autoptr(GBytes) fw = NULL;
+
+	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
+	g_return_val_if_fail (G_IS_INPUT_STREAM (stream), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* restored from the cache */
+	if (!fu_device_ensure_setup (self, error))
+		return FALSE;
+
+	/* not possible to use prepare_firmware() */
+	if (klass->write_firmware_stream != NULL) {
+		if (priv->size_max > 0 && streamsz > priv->size_max) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "firmware is %04x bytes larger than the allowed "
+				     "maximum size of %04x bytes",
+				     (guint) (streamsz - priv->size_max),
+				     (guint) priv->size_max);
+			return FALSE;
+		}
+		if (priv->size_min > 0 && streamsz < priv->size_min) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "firmware is %04x bytes smaller than the allowed "
+				     "minimum size of %04x bytes",
+				     (guint) (priv->size_min - streamsz),
+				     (guint) priv->size_min);
+			return FALSE;
+		}
+		return klass->write_firmware_stream (self, stream, streamsz, flags, error);
+	}
+
+	/* fall back to reading it all */
+	buf = g_malloc (streamsz);
+	if (!g_input_stream_read_all (stream, buf, streamsz, &bytes_read, NULL, error))
+		return FALSE;
+	if (bytes_read != streamsz) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "stream truncated, got 0x%x of 0x%x bytes",
+			     (guint) bytes_read, (guint) streamsz);
+		return FALSE;
+	}
+
+	/* the stream may only report an error at the end */
+	rc = g_input_stream_read (stream, &tmp, sizeof(tmp), NULL, error);
+	if (rc < 0)
+		return FALSE;
+	if (rc > 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "stream larger than 0x%x bytes",
+			     (guint) streamsz);
+		return FALSE;
+	}
+	fw = g_bytes_new_take (g_steal_pointer (&buf), streamsz);
+	return fu_device_write_firmware (self, fw, flags, error);
 }
 
 /**
@@ -2511,6 +3070,9 @@ fu_device_read_firmware (FuDevice *self, GError **error)
 	g_return_val_if_fail (FU_IS_DEVICE (self), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+	/* restored from the cache */
+	if (!fu_device_ensure_setup (self, error))
+		return NULL;
 
 	/* no plugin-specific method or device doesn't support */
 	if (!fu_device_has_flag (self, FWUPD_DEVICE_FLAG_CAN_VERIFY_IMAGE) ||
@@ -2526,6 +3088,43 @@ fu_device_read_firmware (FuDevice *self, GError **error)
 	return klass->read_firmware (self, error);
 }
 
+/**
+ * fu_device_read_checksum:
+ * @self: A #FuDevice
+ * @error: A #GError
+ *
+ * Asks the device to compute a checksum of the firmware it has in flash,
+ * which is usually much faster than fu_device_read_firmware(). The format of
+ * the checksum is specific to the device and is only useful to know if the
+ * firmware has changed.
+ *
+ * The device must already be open.
+ *
+ * Returns: (transfer full): A checksum, or %NULL for error
+ *
+ * Since: 1.5.0
+ **/
+gchar *
+fu_device_read_checksum (FuDevice *self, GError **error)
+{
+	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
+
+	g_return_val_if_fail (FU_IS_DEVICE (self), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* no plugin-specific method */
+	if (klass->read_checksum == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "not supported");
+		return NULL;
+	}
+
+	/* call vfunc */
+	return klass->read_checksum (self, error);
+}
+
 /**
  * fu_device_detach:
  * @self: A #FuDevice
@@ -2545,6 +3144,10 @@ fu_device_detach (FuDevice *self, GError **error)
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	/* restored from the cache */
+	if (!fu_device_ensure_setup (self, error))
+		return FALSE;
+
 	/* no plugin-specific method */
 	if (klass->detach == NULL)
 		return TRUE;
@@ -2572,6 +3175,10 @@ fu_device_attach (FuDevice *self, GError **error)
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	/* restored from the cache */
+	if (!fu_device_ensure_setup (self, error))
+		return FALSE;
+
 	/* no plugin-specific method */
 	if (klass->attach == NULL)
 		return TRUE;
@@ -2599,6 +3206,10 @@ fu_device_reload (FuDevice *self, GError **error)
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	/* restored from the cache */
+	if (!fu_device_ensure_setup (self, error))
+		return FALSE;
+
 	/* no plugin-specific method */
 	if (klass->reload == NULL)
 		return TRUE;
@@ -2867,7 +3478,7 @@ fu_device_convert_instance_ids (FuDevice *self)
 		return;
 	for (guint i = 0; i < instance_ids->len; i++) {
 		const gchar *instance_id = g_ptr_array_index (instance_ids, i);
-		g_autofree gchar *guid = fwupd_guid_hash_string (instance_id);
+		g_autofree gchar *guid = fu_device_guid_hash_string (instance_id);
 		fwupd_device_add_guid (FWUPD_DEVICE (self), guid);
 	}
 
@@ -2878,6 +3489,49 @@ fu_device_convert_instance_ids (FuDevice *self)
 	}
 }
 
+/**
+ * fu_device_set_setup_cache:
+ * @self: A #FuDevice
+ * @setup_cache: (nullable): a #GVariant of type `a{sv}`, or %NULL
+ *
+ * Sets the device state saved after a previous fu_device_setup(), typically
+ * by the daemon when the physical device has not changed since it was last
+ * probed.
+ *
+ * If set, fu_device_setup() restores the saved state rather than running the
+ * subclassed setup, which is instead done when the device is first used.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_device_set_setup_cache (FuDevice *self, GVariant *setup_cache)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_DEVICE (self));
+	if (priv->setup_cache != NULL)
+		g_variant_unref (priv->setup_cache);
+	priv->setup_cache = setup_cache != NULL ? g_variant_ref (setup_cache) : NULL;
+}
+
+static void
+fu_device_restore_setup_cache (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	GPtrArray *guids;
+	g_autoptr(FwupdDevice) donor = fwupd_device_from_variant (priv->setup_cache);
+
+	if (donor == NULL)
+		return;
+	g_debug ("restoring %s from setup cache", fu_device_get_id (self));
+	fwupd_device_incorporate (FWUPD_DEVICE (self), donor);
+	fwupd_device_add_flag (FWUPD_DEVICE (self), fwupd_device_get_flags (donor));
+
+	/* quirks are not saved, so match them again */
+	guids = fwupd_device_get_guids (donor);
+	for (guint i = 0; i < guids->len; i++)
+		fu_device_add_guid_quirks (self, g_ptr_array_index (guids, i));
+}
+
 /**
  * fu_device_setup:
  * @self: A #FuDevice
@@ -2904,6 +3558,23 @@ fu_device_setup (FuDevice *self, GError **error)
 	if (priv->done_setup)
 		return TRUE;
 
+	/* restored from the cache, so the device I/O is done when needed */
+	if (priv->setup_cache != NULL) {
+		fu_device_restore_setup_cache (self);
+		g_clear_pointer (&priv->setup_cache, g_variant_unref);
+		priv->setup_deferred = TRUE;
+		priv->done_setup = TRUE;
+		return TRUE;
+	}
+
+	/* use the probed instance IDs until the details are required */
+	if (fu_device_has_flag (self, FWUPD_DEVICE_FLAG_SETUP_ON_DEMAND)) {
+		fu_device_convert_instance_ids (self);
+		priv->setup_deferred = TRUE;
+		priv->done_setup = TRUE;
+		return TRUE;
+	}
+
 	/* subclassed */
 	if (klass->setup != NULL) {
 		if (!klass->setup (self, error))
@@ -2917,6 +3588,66 @@ fu_device_setup (FuDevice *self, GError **error)
 	return TRUE;
 }
 
+/**
+ * fu_device_get_setup_deferred:
+ * @self: A #FuDevice
+ *
+ * Gets if the subclassed setup has not yet been run, either because the
+ * device was restored from the setup cache or because it has the
+ * %FWUPD_DEVICE_FLAG_SETUP_ON_DEMAND flag.
+ *
+ * Returns: %TRUE if fu_device_ensure_setup() has work to do
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_device_get_setup_deferred (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
+	return priv->setup_deferred;
+}
+
+/**
+ * fu_device_ensure_setup:
+ * @self: A #FuDevice
+ * @error: A #GError, or %NULL
+ *
+ * Runs the subclassed setup if it was skipped by restoring the device from
+ * the setup cache or by %FWUPD_DEVICE_FLAG_SETUP_ON_DEMAND, opening the
+ * device if required.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_device_ensure_setup (FuDevice *self, GError **error)
+{
+	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_autoptr(FuDeviceLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* not deferred */
+	if (!priv->setup_deferred)
+		return TRUE;
+	priv->setup_deferred = FALSE;
+	if (klass->setup == NULL)
+		return TRUE;
+
+	g_debug ("running deferred setup on %s", fu_device_get_id (self));
+	locker = fu_device_locker_new (self, error);
+	if (locker == NULL)
+		return FALSE;
+	if (!klass->setup (self, error))
+		return FALSE;
+	fu_device_convert_instance_ids (self);
+	return TRUE;
+}
+
 /**
  * fu_device_activate:
  * @self: A #FuDevice
@@ -2937,6 +3668,10 @@ fu_device_activate (FuDevice *self, GError **error)
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	/* restored from the cache */
+	if (!fu_device_ensure_setup (self, error))
+		return FALSE;
+
 	/* subclassed */
 	if (klass->activate != NULL) {
 		if (!klass->activate (self, error))
@@ -2966,6 +3701,8 @@ fu_device_probe_invalidate (FuDevice *self)
 	g_return_if_fail (FU_IS_DEVICE (self));
 	priv->done_probe = FALSE;
 	priv->done_setup = FALSE;
+	priv->setup_deferred = FALSE;
+	g_clear_pointer (&priv->setup_cache, g_variant_unref);
 }
 
 /**
@@ -2985,7 +3722,6 @@ fu_device_incorporate (FuDevice *self, FuDevice *donor)
 	FuDevicePrivate *priv_donor = GET_PRIVATE (donor);
 	GPtrArray *instance_ids = fu_device_get_instance_ids (donor);
 	GPtrArray *parent_guids = fu_device_get_parent_guids (donor);
-	g_autoptr(GList) metadata_keys = NULL;
 
 	g_return_if_fail (FU_IS_DEVICE (self));
 	g_return_if_fail (FU_IS_DEVICE (donor));
@@ -3005,19 +3741,25 @@ fu_device_incorporate (FuDevice *self, FuDevice *donor)
 		fu_device_set_proxy_guid (self, priv_donor->proxy_guid);
 	if (priv->quirks == NULL)
 		fu_device_set_quirks (self, fu_device_get_quirks (donor));
+	if (priv->setup_cache == NULL && priv_donor->setup_cache != NULL)
+		fu_device_set_setup_cache (self, priv_donor->setup_cache);
 	g_rw_lock_reader_lock (&priv_donor->parent_guids_mutex);
 	for (guint i = 0; i < parent_guids->len; i++)
 		fu_device_add_parent_guid (self, g_ptr_array_index (parent_guids, i));
 	g_rw_lock_reader_unlock (&priv_donor->parent_guids_mutex);
 	g_rw_lock_reader_lock (&priv_donor->metadata_mutex);
-	metadata_keys = g_hash_table_get_keys (priv_donor->metadata);
-	for (GList *l = metadata_keys; l != NULL; l = l->next) {
-		const gchar *key = l->data;
-		if (g_hash_table_lookup (priv->metadata, key) == NULL) {
-			const gchar *value = g_hash_table_lookup (priv_donor->metadata, key);
-			fu_device_set_metadata (self, key, value);
+	g_rw_lock_writer_lock (&priv->metadata_mutex);
+	for (guint i = 0; i < priv_donor->metadata->len; i++) {
+		FuDeviceMetadataItem *item = &g_array_index (priv_donor->metadata,
+							     FuDeviceMetadataItem, i);
+		if (fu_device_metadata_find (priv->metadata, item->key, NULL) == NULL) {
+			fu_device_metadata_insert (priv->metadata, item->key,
+						   g_strdup (item->value),
+						   item->value_int,
+						   item->value_bool);
 		}
 	}
+	g_rw_lock_writer_unlock (&priv->metadata_mutex);
 	g_rw_lock_reader_unlock (&priv_donor->metadata_mutex);
 
 	/* now the base class, where all the interesting bits are */
@@ -3034,7 +3776,7 @@ fu_device_incorporate (FuDevice *self, FuDevice *donor)
 	/* call the set_quirk_kv() vfunc for the superclassed object */
 	for (guint i = 0; i < instance_ids->len; i++) {
 		const gchar *instance_id = g_ptr_array_index (instance_ids, i);
-		g_autofree gchar *guid = fwupd_guid_hash_string (instance_id);
+		g_autofree gchar *guid = fu_device_guid_hash_string (instance_id);
 		fu_device_add_guid_quirks (self, guid);
 	}
 }
@@ -3133,11 +3875,11 @@ fu_device_init (FuDevice *self)
 	FuDevicePrivate *priv = GET_PRIVATE (self);
 	priv->children = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->parent_guids = g_ptr_array_new_with_free_func (g_free);
-	priv->possible_plugins = g_ptr_array_new_with_free_func (g_free);
+	priv->possible_plugins = g_ptr_array_new ();
 	priv->retry_recs = g_ptr_array_new_with_free_func (g_free);
 	g_rw_lock_init (&priv->parent_guids_mutex);
-	priv->metadata = g_hash_table_new_full (g_str_hash, g_str_equal,
-						g_free, g_free);
+	priv->metadata = g_array_new (FALSE, FALSE, sizeof (FuDeviceMetadataItem));
+	g_array_set_clear_func (priv->metadata, (GDestroyNotify) fu_device_metadata_item_clear);
 	g_rw_lock_init (&priv->metadata_mutex);
 }
 
@@ -3159,7 +3901,7 @@ fu_device_finalize (GObject *object)
 		g_source_remove (priv->poll_id);
 	g_rw_lock_clear (&priv->metadata_mutex);
 	g_rw_lock_clear (&priv->parent_guids_mutex);
-	g_hash_table_unref (priv->metadata);
+	g_array_unref (priv->metadata);
 	g_ptr_array_unref (priv->children);
 	g_ptr_array_unref (priv->parent_guids);
 	g_ptr_array_unref (priv->possible_plugins);
@@ -3169,6 +3911,8 @@ fu_device_finalize (GObject *object)
 	g_free (priv->physical_id);
 	g_free (priv->logical_id);
 	g_free (priv->proxy_guid);
+	if (priv->setup_cache != NULL)
+		g_variant_unref (priv->setup_cache);
 
 	G_OBJECT_CLASS (fu_device_parent_class)->finalize (object);
 }
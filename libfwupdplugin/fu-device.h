@@ -64,8 +64,15 @@ struct _FuDeviceClass
 	gboolean		 (*cleanup)		(FuDevice	*self,
 							 FwupdInstallFlags flags,
 							 GError		**error);
+	gboolean		 (*write_firmware_stream) (FuDevice	*self,
+							 GInputStream	*stream,
+							 gsize		 streamsz,
+							 FwupdInstallFlags flags,
+							 GError		**error);
+	gchar			*(*read_checksum)	(FuDevice	*self,
+							 GError		**error);
 	/*< private >*/
-	gpointer	padding[16];
+	gpointer	padding[14];
 };
 
 /**
@@ -103,6 +110,10 @@ typedef enum {
 typedef gboolean (*FuDeviceRetryFunc)			(FuDevice	*device,
 							 gpointer	 user_data,
 							 GError		**error);
+typedef gboolean (*FuDeviceWaitFunc)			(FuDevice	*device,
+							 gboolean	*done,
+							 gpointer	 user_data,
+							 GError		**error);
 
 FuDevice	*fu_device_new				(void);
 
@@ -266,12 +277,19 @@ gboolean	 fu_device_write_firmware		(FuDevice	*self,
 							 GBytes		*fw,
 							 FwupdInstallFlags flags,
 							 GError		**error);
+gboolean	 fu_device_write_firmware_stream	(FuDevice	*self,
+							 GInputStream	*stream,
+							 gsize		 streamsz,
+							 FwupdInstallFlags flags,
+							 GError		**error);
 FuFirmware	*fu_device_prepare_firmware		(FuDevice	*self,
 							 GBytes		*fw,
 							 FwupdInstallFlags flags,
 							 GError		**error);
 FuFirmware	*fu_device_read_firmware		(FuDevice	*self,
 							 GError		**error);
+gchar		*fu_device_read_checksum		(FuDevice	*self,
+							 GError		**error);
 gboolean	 fu_device_attach			(FuDevice	*self,
 							 GError		**error);
 gboolean	 fu_device_detach			(FuDevice	*self,
@@ -317,3 +335,8 @@ gboolean	 fu_device_retry			(FuDevice	*self,
 							 guint		 count,
 							 gpointer	 user_data,
 							 GError		**error);
+gboolean	 fu_device_wait_for			(FuDevice	*self,
+							 FuDeviceWaitFunc func,
+							 guint		 timeout,
+							 gpointer	 user_data,
+							 GError		**error);
@@ -13,6 +13,8 @@
 #ifndef _WIN32
 #include <linux/fs.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <gio/gunixinputstream.h>
 #include <gio/gunixoutputstream.h>
 #endif
@@ -22,6 +24,18 @@
 
 #include "fwupd-error.h"
 
+typedef struct {
+	guint32			 attr;
+	GBytes			*data;		/* NULL until read */
+} FuEfivarSnapshotItem;
+
+/* shared by all plugins in the process between fu_efivar_snapshot_begin()
+ * and fu_efivar_snapshot_end() */
+static GMutex		 fu_efivar_snapshot_mutex;
+static guint		 fu_efivar_snapshot_refcount = 0;
+static GHashTable	*fu_efivar_snapshot = NULL;	/* name-guid:FuEfivarSnapshotItem */
+static gint		 fu_efivar_snapshot_dirfd = -1;
+
 static gchar *
 fu_efivar_get_path (void)
 {
@@ -36,6 +50,246 @@ fu_efivar_get_filename (const gchar *guid, const gchar *name)
 	return g_strdup_printf ("%s/%s-%s", efivardir, name, guid);
 }
 
+static void
+fu_efivar_snapshot_item_free (FuEfivarSnapshotItem *item)
+{
+	if (item->data != NULL)
+		g_bytes_unref (item->data);
+	g_free (item);
+}
+
+/* with the mutex held; the variable is re-read when next required */
+static void
+fu_efivar_snapshot_invalidate (const gchar *guid, const gchar *name, gboolean exists)
+{
+	gchar *basename;
+	if (fu_efivar_snapshot == NULL)
+		return;
+	basename = g_strdup_printf ("%s-%s", name, guid);
+	if (exists) {
+		g_hash_table_insert (fu_efivar_snapshot, basename,
+				     g_new0 (FuEfivarSnapshotItem, 1));
+	} else {
+		g_hash_table_remove (fu_efivar_snapshot, basename);
+		g_free (basename);
+	}
+}
+
+/* with the mutex held */
+static gboolean
+fu_efivar_snapshot_get_data (const gchar *guid, const gchar *name, guint8 **data,
+			     gsize *data_sz, guint32 *attr, GError **error)
+{
+#ifndef _WIN32
+	FuEfivarSnapshotItem *item;
+	gint fd;
+	gsize bufsz = 0;
+	struct stat st = { 0 };
+	g_autofree gchar *basename = g_strdup_printf ("%s-%s", name, guid);
+	g_autofree guint8 *buf = NULL;
+
+	item = g_hash_table_lookup (fu_efivar_snapshot, basename);
+	if (item == NULL) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_FOUND,
+			     "efivar %s not found",
+			     basename);
+		return FALSE;
+	}
+
+	/* read the file relative to the directory opened for the snapshot */
+	if (item->data == NULL) {
+		fd = openat (fu_efivar_snapshot_dirfd, basename, O_RDONLY);
+		if (fd < 0) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     g_io_error_from_errno (errno),
+				     "failed to open %s: %s",
+				     basename, strerror (errno));
+			return FALSE;
+		}
+		if (fstat (fd, &st) < 0 || st.st_size < (goffset) sizeof(guint32)) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "efivars file too small: %" G_GINT64_FORMAT,
+				     (gint64) st.st_size);
+			close (fd);
+			return FALSE;
+		}
+		buf = g_malloc0 (st.st_size);
+		while (bufsz < (gsize) st.st_size) {
+			gssize rc = read (fd, buf + bufsz, st.st_size - bufsz);
+			if (rc < 0 && errno == EINTR)
+				continue;
+			if (rc <= 0) {
+				g_set_error (error,
+					     G_IO_ERROR,
+					     G_IO_ERROR_FAILED,
+					     "failed to read %s: %s",
+					     basename, strerror (errno));
+				close (fd);
+				return FALSE;
+			}
+			bufsz += rc;
+		}
+		close (fd);
+		memcpy (&item->attr, buf, sizeof(guint32));
+		item->data = g_bytes_new (buf + sizeof(guint32), bufsz - sizeof(guint32));
+	}
+
+	/* copy out */
+	if (attr != NULL)
+		*attr = item->attr;
+	if (data_sz != NULL)
+		*data_sz = g_bytes_get_size (item->data);
+	if (data != NULL) {
+		gsize sz = 0;
+		const guint8 *tmp = g_bytes_get_data (item->data, &sz);
+		*data = g_malloc0 (MAX (sz, 1));
+		if (sz > 0)
+			memcpy (*data, tmp, sz);
+	}
+	return TRUE;
+#else
+	g_set_error_literal (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "efivarfs not currently supported on Windows");
+	return FALSE;
+#endif
+}
+
+/**
+ * fu_efivar_snapshot_begin:
+ * @error: #GError
+ *
+ * Enumerates all the EFI variables once so that fu_efivar_exists(),
+ * fu_efivar_get_names() and fu_efivar_get_data() do not have to access the
+ * filesystem each time. The data of each variable is only read once, and is
+ * shared with every other caller in the process until the matching
+ * fu_efivar_snapshot_end().
+ *
+ * Variables changed using fu_efivar_set_data() or fu_efivar_delete() are
+ * updated in the snapshot, but changes made by other processes are not seen.
+ *
+ * Returns: %TRUE on success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_efivar_snapshot_begin (GError **error)
+{
+#ifndef _WIN32
+	const gchar *fn;
+	g_autofree gchar *efivardir = fu_efivar_get_path ();
+	g_autoptr(GDir) dir = NULL;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_efivar_snapshot_mutex);
+
+	/* already exists */
+	if (fu_efivar_snapshot_refcount > 0) {
+		fu_efivar_snapshot_refcount++;
+		return TRUE;
+	}
+
+	/* find all the variable names with a single directory scan */
+	dir = g_dir_open (efivardir, 0, error);
+	if (dir == NULL)
+		return FALSE;
+	fu_efivar_snapshot_dirfd = open (efivardir, O_RDONLY | O_DIRECTORY);
+	if (fu_efivar_snapshot_dirfd < 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_FAILED,
+			     "failed to open %s: %s",
+			     efivardir, strerror (errno));
+		return FALSE;
+	}
+	fu_efivar_snapshot = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						    (GDestroyNotify) fu_efivar_snapshot_item_free);
+	while ((fn = g_dir_read_name (dir)) != NULL) {
+		g_hash_table_insert (fu_efivar_snapshot, g_strdup (fn),
+				     g_new0 (FuEfivarSnapshotItem, 1));
+	}
+	g_debug ("snapshot of %u EFI variables", g_hash_table_size (fu_efivar_snapshot));
+	fu_efivar_snapshot_refcount = 1;
+	return TRUE;
+#else
+	g_set_error_literal (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "efivarfs not currently supported on Windows");
+	return FALSE;
+#endif
+}
+
+/**
+ * fu_efivar_snapshot_end:
+ *
+ * Drops the reference on the snapshot created by a successful
+ * fu_efivar_snapshot_begin(). When the last reference is dropped the
+ * variables are accessed from the filesystem again.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_efivar_snapshot_end (void)
+{
+#ifndef _WIN32
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_efivar_snapshot_mutex);
+	g_return_if_fail (fu_efivar_snapshot_refcount > 0);
+	if (--fu_efivar_snapshot_refcount > 0)
+		return;
+	g_clear_pointer (&fu_efivar_snapshot, g_hash_table_unref);
+	close (fu_efivar_snapshot_dirfd);
+	fu_efivar_snapshot_dirfd = -1;
+#endif
+}
+
+/**
+ * fu_efivar_get_names:
+ * @guid: Globally unique identifier
+ * @error: #GError
+ *
+ * Gets the names of all the variables with a specific GUID, using the
+ * snapshot if one exists.
+ *
+ * Returns: (transfer container) (element-type utf8): sorted names, e.g. `Boot0001`
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fu_efivar_get_names (const gchar *guid, GError **error)
+{
+	g_autofree gchar *suffix = g_strdup_printf ("-%s", guid);
+	g_autoptr(GPtrArray) names = g_ptr_array_new_with_free_func (g_free);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_efivar_snapshot_mutex);
+
+	if (fu_efivar_snapshot != NULL) {
+		GHashTableIter iter;
+		gpointer key;
+		g_hash_table_iter_init (&iter, fu_efivar_snapshot);
+		while (g_hash_table_iter_next (&iter, &key, NULL)) {
+			const gchar *fn = (const gchar *) key;
+			if (g_str_has_suffix (fn, suffix))
+				g_ptr_array_add (names, g_strndup (fn, strlen (fn) - strlen (suffix)));
+		}
+	} else {
+		const gchar *fn;
+		g_autofree gchar *efivardir = fu_efivar_get_path ();
+		g_autoptr(GDir) dir = g_dir_open (efivardir, 0, error);
+		if (dir == NULL)
+			return NULL;
+		while ((fn = g_dir_read_name (dir)) != NULL) {
+			if (g_str_has_suffix (fn, suffix))
+				g_ptr_array_add (names, g_strndup (fn, strlen (fn) - strlen (suffix)));
+		}
+	}
+	g_ptr_array_sort (names, (GCompareFunc) g_strcmp0);
+	return g_steal_pointer (&names);
+}
+
 /**
  * fu_efivar_supported:
  * @error: #GError
@@ -181,13 +435,17 @@ fu_efivar_delete (const gchar *guid, const gchar *name, GError **error)
 {
 	g_autofree gchar *fn = fu_efivar_get_filename (guid, name);
 	g_autoptr(GFile) file = g_file_new_for_path (fn);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_efivar_snapshot_mutex);
 	if (!g_file_query_exists (file, NULL))
 		return TRUE;
 	if (!fu_efivar_set_immutable (fn, FALSE, NULL, error)) {
 		g_prefix_error (error, "failed to set %s as mutable: ", fn);
 		return FALSE;
 	}
-	return g_file_delete (file, NULL, error);
+	if (!g_file_delete (file, NULL, error))
+		return FALSE;
+	fu_efivar_snapshot_invalidate (guid, name, FALSE);
+	return TRUE;
 }
 
 /**
@@ -205,24 +463,15 @@ fu_efivar_delete (const gchar *guid, const gchar *name, GError **error)
 gboolean
 fu_efivar_delete_with_glob (const gchar *guid, const gchar *name_glob, GError **error)
 {
-	const gchar *fn;
-	g_autofree gchar *nameguid_glob = NULL;
-	g_autofree gchar *efivardir = fu_efivar_get_path ();
-	g_autoptr(GDir) dir = g_dir_open (efivardir, 0, error);
-	if (dir == NULL)
+	g_autoptr(GPtrArray) names = fu_efivar_get_names (guid, error);
+	if (names == NULL)
 		return FALSE;
-	nameguid_glob = g_strdup_printf ("%s-%s", name_glob, guid);
-	while ((fn = g_dir_read_name (dir)) != NULL) {
-		if (fu_common_fnmatch (nameguid_glob, fn)) {
-			g_autofree gchar *keyfn = g_build_filename (efivardir, fn, NULL);
-			g_autoptr(GFile) file = g_file_new_for_path (keyfn);
-			if (!fu_efivar_set_immutable (keyfn, FALSE, NULL, error)) {
-				g_prefix_error (error, "failed to set %s as mutable: ", keyfn);
-				return FALSE;
-			}
-			if (!g_file_delete (file, NULL, error))
-				return FALSE;
-		}
+	for (guint i = 0; i < names->len; i++) {
+		const gchar *name = g_ptr_array_index (names, i);
+		if (!fu_common_fnmatch (name_glob, name))
+			continue;
+		if (!fu_efivar_delete (guid, name, error))
+			return FALSE;
 	}
 	return TRUE;
 }
@@ -241,7 +490,14 @@ fu_efivar_delete_with_glob (const gchar *guid, const gchar *name_glob, GError **
 gboolean
 fu_efivar_exists (const gchar *guid, const gchar *name)
 {
-	g_autofree gchar *fn = fu_efivar_get_filename (guid, name);
+	g_autofree gchar *fn = NULL;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_efivar_snapshot_mutex);
+
+	if (fu_efivar_snapshot != NULL) {
+		g_autofree gchar *basename = g_strdup_printf ("%s-%s", name, guid);
+		return g_hash_table_contains (fu_efivar_snapshot, basename);
+	}
+	fn = fu_efivar_get_filename (guid, name);
 	return g_file_test (fn, G_FILE_TEST_EXISTS);
 }
 
@@ -273,6 +529,11 @@ fu_efivar_get_data (const gchar *guid, const gchar *name, guint8 **data,
 	g_autoptr(GFile) file = g_file_new_for_path (fn);
 	g_autoptr(GFileInfo) info = NULL;
 	g_autoptr(GInputStream) istr = NULL;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_efivar_snapshot_mutex);
+
+	/* shared with the other callers */
+	if (fu_efivar_snapshot != NULL)
+		return fu_efivar_snapshot_get_data (guid, name, data, data_sz, attr, error);
 
 	/* open file as stream */
 	istr = G_INPUT_STREAM (g_file_read (file, NULL, error));
@@ -354,6 +615,7 @@ fu_efivar_set_data (const gchar *guid, const gchar *name, const guint8 *data,
 	g_autofree guint8 *buf = g_malloc0 (sizeof(guint32) + sz);
 	g_autoptr(GFile) file = g_file_new_for_path (fn);
 	g_autoptr(GOutputStream) ostr = NULL;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_efivar_snapshot_mutex);
 
 	/* create empty file so we can clear the immutable bit before writing */
 	if (!g_file_query_exists (file, NULL)) {
@@ -389,8 +651,10 @@ fu_efivar_set_data (const gchar *guid, const gchar *name, const guint8 *data,
 	memcpy (buf + sizeof(attr), data, sz);
 	if (g_output_stream_write (ostr, buf, sizeof(attr) + sz, NULL, error) < 0) {
 		g_prefix_error (error, "failed to write data to efivarfs: ");
+		fu_efivar_snapshot_invalidate (guid, name, TRUE);
 		return FALSE;
 	}
+	fu_efivar_snapshot_invalidate (guid, name, TRUE);
 
 	/* set as immutable again */
 	if (was_immutable && !fu_efivar_set_immutable (fn, TRUE, NULL, error)) {
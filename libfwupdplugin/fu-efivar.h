@@ -43,3 +43,7 @@ gboolean	 fu_efivar_delete_with_glob	(const gchar	*guid,
 						 const gchar	*name_glob,
 						 GError		**error);
 gboolean	 fu_efivar_secure_boot_enabled (void);
+GPtrArray	*fu_efivar_get_names		(const gchar	*guid,
+						 GError		**error);
+gboolean	 fu_efivar_snapshot_begin	(GError		**error);
+void		 fu_efivar_snapshot_end		(void);
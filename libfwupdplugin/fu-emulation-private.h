@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib.h>
+
+/**
+ * FuEmulationMode:
+ * @FU_EMULATION_MODE_NONE:		Talk to the hardware
+ * @FU_EMULATION_MODE_RECORD:		Talk to the hardware, recording each transfer
+ * @FU_EMULATION_MODE_REPLAY:		Return the recorded transfers without any hardware
+ *
+ * The emulation mode used for device transfers.
+ **/
+typedef enum {
+	FU_EMULATION_MODE_NONE,
+	FU_EMULATION_MODE_RECORD,
+	FU_EMULATION_MODE_REPLAY,
+	/*< private >*/
+	FU_EMULATION_MODE_LAST
+} FuEmulationMode;
+
+FuEmulationMode	 fu_emulation_get_mode			(void);
+void		 fu_emulation_record_start		(void);
+gboolean	 fu_emulation_save			(const gchar	*filename,
+							 GError		**error);
+gboolean	 fu_emulation_load			(const gchar	*filename,
+							 GError		**error);
+void		 fu_emulation_add_event			(const gchar	*kind,
+							 guint64	 request,
+							 const guint8	*buf_in,
+							 gsize		 buf_in_sz,
+							 const guint8	*buf_out,
+							 gsize		 buf_out_sz,
+							 gint64		 start,
+							 const GError	*error);
+gboolean	 fu_emulation_replay_event		(const gchar	*kind,
+							 guint64	 request,
+							 const guint8	*buf_in,
+							 gsize		 buf_in_sz,
+							 guint8		*buf_out,
+							 gsize		 buf_out_sz,
+							 gsize		*actual_len,
+							 GError		**error);
+guint		 fu_emulation_get_event_count		(void);
+gint64		 fu_emulation_get_device_duration	(void);
@@ -0,0 +1,434 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuEmulation"
+
+#include "config.h"
+
+#include <json-glib/json-glib.h>
+#include <string.h>
+
+#include "fwupd-error.h"
+
+#include "fu-emulation-private.h"
+
+/**
+ * SECTION:fu-emulation
+ * @short_description: record and replay device transfers
+ *
+ * Transfers done using #FuHidDevice, #FuUdevDevice and #FuIOChannel can be
+ * recorded with a timestamp and saved to a file. The file can then be loaded
+ * to return the same data without the hardware, sleeping for the time the
+ * device took to respond so that the protocol overhead can be measured.
+ *
+ * The events have to be replayed in exactly the same order they were
+ * recorded, and any difference in the data sent to the device is an error.
+ */
+
+typedef struct {
+	gchar			*kind;
+	guint64			 request;
+	GBytes			*data_in;
+	GBytes			*data_out;
+	gint64			 duration;	/* µs */
+	gchar			*error_msg;	/* nullable */
+} FuEmulationEvent;
+
+static FuEmulationMode emulation_mode = FU_EMULATION_MODE_NONE;
+static GPtrArray *emulation_events = NULL;	/* of FuEmulationEvent */
+static guint emulation_idx = 0;
+static gint64 emulation_duration = 0;		/* µs */
+G_LOCK_DEFINE_STATIC (emulation);
+
+static void
+fu_emulation_event_free (FuEmulationEvent *event)
+{
+	g_free (event->kind);
+	g_bytes_unref (event->data_in);
+	g_bytes_unref (event->data_out);
+	g_free (event->error_msg);
+	g_free (event);
+}
+
+static void
+fu_emulation_ensure_events (void)
+{
+	if (emulation_events != NULL)
+		g_ptr_array_set_size (emulation_events, 0);
+	else
+		emulation_events = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_emulation_event_free);
+	emulation_idx = 0;
+	emulation_duration = 0;
+}
+
+/**
+ * fu_emulation_get_mode: (skip)
+ *
+ * Gets the emulation mode for all device transfers.
+ *
+ * Returns: a #FuEmulationMode, e.g. %FU_EMULATION_MODE_REPLAY
+ *
+ * Since: 1.5.0
+ **/
+FuEmulationMode
+fu_emulation_get_mode (void)
+{
+	return emulation_mode;
+}
+
+/**
+ * fu_emulation_record_start: (skip)
+ *
+ * Starts recording all device transfers, discarding any existing events.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_emulation_record_start (void)
+{
+	G_LOCK (emulation);
+	fu_emulation_ensure_events ();
+	emulation_mode = FU_EMULATION_MODE_RECORD;
+	G_UNLOCK (emulation);
+}
+
+static void
+fu_emulation_builder_add_bytes (JsonBuilder *builder, const gchar *key, GBytes *blob)
+{
+	g_autofree gchar *str = NULL;
+	if (g_bytes_get_size (blob) == 0)
+		return;
+	str = g_base64_encode (g_bytes_get_data (blob, NULL), g_bytes_get_size (blob));
+	json_builder_set_member_name (builder, key);
+	json_builder_add_string_value (builder, str);
+}
+
+/**
+ * fu_emulation_save: (skip)
+ * @filename: a filename, e.g. `/tmp/emulation.json`
+ * @error: A #GError, or %NULL
+ *
+ * Saves the recorded device transfers to a file.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_emulation_save (const gchar *filename, GError **error)
+{
+	g_autofree gchar *data = NULL;
+	g_autoptr(JsonBuilder) builder = json_builder_new ();
+	g_autoptr(JsonGenerator) json_generator = NULL;
+	g_autoptr(JsonNode) json_root = NULL;
+
+	g_return_val_if_fail (filename != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	G_LOCK (emulation);
+	if (emulation_mode != FU_EMULATION_MODE_RECORD) {
+		G_UNLOCK (emulation);
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "not recording");
+		return FALSE;
+	}
+	json_builder_begin_object (builder);
+	json_builder_set_member_name (builder, "Events");
+	json_builder_begin_array (builder);
+	for (guint i = 0; i < emulation_events->len; i++) {
+		FuEmulationEvent *event = g_ptr_array_index (emulation_events, i);
+		json_builder_begin_object (builder);
+		json_builder_set_member_name (builder, "Kind");
+		json_builder_add_string_value (builder, event->kind);
+		json_builder_set_member_name (builder, "Request");
+		json_builder_add_int_value (builder, (gint64) event->request);
+		json_builder_set_member_name (builder, "Duration");
+		json_builder_add_int_value (builder, event->duration);
+		fu_emulation_builder_add_bytes (builder, "DataIn", event->data_in);
+		fu_emulation_builder_add_bytes (builder, "DataOut", event->data_out);
+		if (event->error_msg != NULL) {
+			json_builder_set_member_name (builder, "Error");
+			json_builder_add_string_value (builder, event->error_msg);
+		}
+		json_builder_end_object (builder);
+	}
+	json_builder_end_array (builder);
+	json_builder_end_object (builder);
+	G_UNLOCK (emulation);
+
+	/* export as a string */
+	json_root = json_builder_get_root (builder);
+	json_generator = json_generator_new ();
+	json_generator_set_pretty (json_generator, TRUE);
+	json_generator_set_root (json_generator, json_root);
+	data = json_generator_to_data (json_generator, NULL);
+	return g_file_set_contents (filename, data, -1, error);
+}
+
+static const gchar *
+fu_emulation_object_get_string (JsonObject *obj, const gchar *key)
+{
+	if (!json_object_has_member (obj, key))
+		return NULL;
+	return json_object_get_string_member (obj, key);
+}
+
+static gint64
+fu_emulation_object_get_int (JsonObject *obj, const gchar *key)
+{
+	if (!json_object_has_member (obj, key))
+		return 0;
+	return json_object_get_int_member (obj, key);
+}
+
+static GBytes *
+fu_emulation_object_get_bytes (JsonObject *obj, const gchar *key)
+{
+	const gchar *str = fu_emulation_object_get_string (obj, key);
+	gsize bufsz = 0;
+	guchar *buf;
+	if (str == NULL)
+		return g_bytes_new (NULL, 0);
+	buf = g_base64_decode (str, &bufsz);
+	return g_bytes_new_take (buf, bufsz);
+}
+
+/**
+ * fu_emulation_load: (skip)
+ * @filename: a filename, e.g. `/tmp/emulation.json`
+ * @error: A #GError, or %NULL
+ *
+ * Loads device transfers from a file, and returns them for all future
+ * transfers rather than using the hardware.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_emulation_load (const gchar *filename, GError **error)
+{
+	JsonArray *json_events;
+	JsonObject *json_obj;
+	JsonNode *json_root;
+	g_autoptr(JsonParser) parser = json_parser_new ();
+
+	g_return_val_if_fail (filename != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (!json_parser_load_from_file (parser, filename, error))
+		return FALSE;
+	json_root = json_parser_get_root (parser);
+	if (json_root == NULL || !JSON_NODE_HOLDS_OBJECT (json_root)) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "no root object");
+		return FALSE;
+	}
+	json_obj = json_node_get_object (json_root);
+	if (!json_object_has_member (json_obj, "Events")) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "no Events array");
+		return FALSE;
+	}
+	json_events = json_object_get_array_member (json_obj, "Events");
+
+	G_LOCK (emulation);
+	fu_emulation_ensure_events ();
+	for (guint i = 0; i < json_array_get_length (json_events); i++) {
+		JsonObject *obj = json_array_get_object_element (json_events, i);
+		FuEmulationEvent *event = g_new0 (FuEmulationEvent, 1);
+		event->kind = g_strdup (fu_emulation_object_get_string (obj, "Kind"));
+		event->request = fu_emulation_object_get_int (obj, "Request");
+		event->duration = fu_emulation_object_get_int (obj, "Duration");
+		event->data_in = fu_emulation_object_get_bytes (obj, "DataIn");
+		event->data_out = fu_emulation_object_get_bytes (obj, "DataOut");
+		event->error_msg = g_strdup (fu_emulation_object_get_string (obj, "Error"));
+		g_ptr_array_add (emulation_events, event);
+	}
+	emulation_mode = FU_EMULATION_MODE_REPLAY;
+	G_UNLOCK (emulation);
+	g_debug ("loaded %u events from %s", json_array_get_length (json_events), filename);
+	return TRUE;
+}
+
+/**
+ * fu_emulation_add_event: (skip)
+ * @kind: the transfer kind, e.g. `HidSetReport`
+ * @request: the transfer request, e.g. the ioctl number or report ID
+ * @buf_in: (nullable): the data sent to the device
+ * @buf_in_sz: size of @buf_in
+ * @buf_out: (nullable): the data received from the device
+ * @buf_out_sz: size of @buf_out
+ * @start: the monotonic time when the transfer started
+ * @error: (nullable): the error from the transfer, or %NULL for success
+ *
+ * Records a device transfer if currently recording.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_emulation_add_event (const gchar *kind,
+			guint64 request,
+			const guint8 *buf_in,
+			gsize buf_in_sz,
+			const guint8 *buf_out,
+			gsize buf_out_sz,
+			gint64 start,
+			const GError *error)
+{
+	FuEmulationEvent *event;
+
+	g_return_if_fail (kind != NULL);
+
+	if (emulation_mode != FU_EMULATION_MODE_RECORD)
+		return;
+	event = g_new0 (FuEmulationEvent, 1);
+	event->kind = g_strdup (kind);
+	event->request = request;
+	event->duration = g_get_monotonic_time () - start;
+	event->data_in = g_bytes_new (buf_in, buf_in != NULL ? buf_in_sz : 0);
+	event->data_out = g_bytes_new (buf_out, buf_out != NULL ? buf_out_sz : 0);
+	if (error != NULL)
+		event->error_msg = g_strdup (error->message);
+	G_LOCK (emulation);
+	emulation_duration += event->duration;
+	g_ptr_array_add (emulation_events, event);
+	G_UNLOCK (emulation);
+}
+
+/**
+ * fu_emulation_replay_event: (skip)
+ * @kind: the transfer kind, e.g. `HidSetReport`
+ * @request: the transfer request, e.g. the ioctl number or report ID
+ * @buf_in: (nullable): the data to send to the device
+ * @buf_in_sz: size of @buf_in
+ * @buf_out: (nullable): a buffer for the data received from the device
+ * @buf_out_sz: size of @buf_out
+ * @actual_len: (out) (optional): the number of bytes copied to @buf_out
+ * @error: A #GError, or %NULL
+ *
+ * Returns the next recorded transfer, which must have the same kind, request
+ * and data as when recorded. This sleeps for as long as the device took to
+ * respond when recorded.
+ *
+ * Returns: %TRUE for success, or %FALSE if the recorded transfer failed
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_emulation_replay_event (const gchar *kind,
+			   guint64 request,
+			   const guint8 *buf_in,
+			   gsize buf_in_sz,
+			   guint8 *buf_out,
+			   gsize buf_out_sz,
+			   gsize *actual_len,
+			   GError **error)
+{
+	FuEmulationEvent *event;
+	g_autoptr(GBytes) data_in = NULL;
+
+	g_return_val_if_fail (kind != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	G_LOCK (emulation);
+	if (emulation_mode != FU_EMULATION_MODE_REPLAY ||
+	    emulation_idx >= emulation_events->len) {
+		G_UNLOCK (emulation);
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_FOUND,
+			     "no recorded event for %s 0x%x",
+			     kind, (guint) request);
+		return FALSE;
+	}
+	event = g_ptr_array_index (emulation_events, emulation_idx);
+	data_in = g_bytes_new (buf_in, buf_in != NULL ? buf_in_sz : 0);
+	if (g_strcmp0 (event->kind, kind) != 0 ||
+	    event->request != request ||
+	    !g_bytes_equal (event->data_in, data_in)) {
+		G_UNLOCK (emulation);
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_DATA,
+			     "event %u is %s 0x%x, but got %s 0x%x",
+			     emulation_idx,
+			     event->kind, (guint) event->request,
+			     kind, (guint) request);
+		return FALSE;
+	}
+	emulation_idx++;
+	emulation_duration += event->duration;
+	G_UNLOCK (emulation);
+
+	/* as slow as the real hardware */
+	if (event->duration > 0)
+		g_usleep (event->duration);
+	if (event->error_msg != NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     event->error_msg);
+		return FALSE;
+	}
+	if (buf_out != NULL) {
+		gsize sz = MIN (buf_out_sz, g_bytes_get_size (event->data_out));
+		memcpy (buf_out, g_bytes_get_data (event->data_out, NULL), sz);
+		if (actual_len != NULL)
+			*actual_len = sz;
+	} else if (actual_len != NULL) {
+		*actual_len = buf_in_sz;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_emulation_get_event_count: (skip)
+ *
+ * Gets the number of transfers recorded or replayed.
+ *
+ * Returns: integer
+ *
+ * Since: 1.5.0
+ **/
+guint
+fu_emulation_get_event_count (void)
+{
+	guint cnt;
+	G_LOCK (emulation);
+	if (emulation_mode == FU_EMULATION_MODE_REPLAY)
+		cnt = emulation_idx;
+	else
+		cnt = emulation_events != NULL ? emulation_events->len : 0;
+	G_UNLOCK (emulation);
+	return cnt;
+}
+
+/**
+ * fu_emulation_get_device_duration: (skip)
+ *
+ * Gets the total time spent waiting for the device in the transfers that
+ * were recorded or replayed.
+ *
+ * Returns: the duration in µs
+ *
+ * Since: 1.5.0
+ **/
+gint64
+fu_emulation_get_device_duration (void)
+{
+	gint64 duration;
+	G_LOCK (emulation);
+	duration = emulation_duration;
+	G_UNLOCK (emulation);
+	return duration;
+}
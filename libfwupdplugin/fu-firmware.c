@@ -64,6 +64,40 @@ fu_firmware_set_version (FuFirmware *self, const gchar *version)
 	priv->version = g_strdup (version);
 }
 
+/**
+ * fu_firmware_check_magic:
+ * @self: A #FuFirmware
+ * @fw: A #GBytes
+ * @error: A #GError, or %NULL
+ *
+ * Checks the firmware for a signature or magic bytes that identify the format,
+ * without parsing the entire blob. This is used to find the firmware types
+ * that may be able to parse an unknown file.
+ *
+ * Returns: %TRUE if the format was identified
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_firmware_check_magic (FuFirmware *self, GBytes *fw, GError **error)
+{
+	FuFirmwareClass *klass = FU_FIRMWARE_GET_CLASS (self);
+
+	g_return_val_if_fail (FU_IS_FIRMWARE (self), FALSE);
+	g_return_val_if_fail (fw != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* not every format has a signature */
+	if (klass->check_magic == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "no magic to check");
+		return FALSE;
+	}
+	return klass->check_magic (self, fw, error);
+}
+
 /**
  * fu_firmware_tokenize:
  * @self: A #FuFirmware
@@ -175,12 +209,21 @@ fu_firmware_parse (FuFirmware *self, GBytes *fw, FwupdInstallFlags flags, GError
 gboolean
 fu_firmware_parse_file (FuFirmware *self, GFile *file, FwupdInstallFlags flags, GError **error)
 {
-	gchar *buf = NULL;
-	gsize bufsz = 0;
+	g_autofree gchar *fn = g_file_get_path (file);
 	g_autoptr(GBytes) fw = NULL;
-	if (!g_file_load_contents (file, NULL, &buf, &bufsz, NULL, error))
-		return FALSE;
-	fw = g_bytes_new_take (buf, bufsz);
+
+	/* avoid copying large local images onto the heap */
+	if (fn != NULL) {
+		fw = fu_common_get_contents_mapped (fn, error);
+		if (fw == NULL)
+			return FALSE;
+	} else {
+		gchar *buf = NULL;
+		gsize bufsz = 0;
+		if (!g_file_load_contents (file, NULL, &buf, &bufsz, NULL, error))
+			return FALSE;
+		fw = g_bytes_new_take (buf, bufsz);
+	}
 	return fu_firmware_parse (self, fw, flags, error);
 }
 
@@ -207,10 +250,64 @@ fu_firmware_write (FuFirmware *self, GError **error)
 	if (klass->write != NULL)
 		return klass->write (self, error);
 
+	/* join the segments only when a single blob is required */
+	if (klass->write_chunks != NULL) {
+		GByteArray *buf = g_byte_array_new ();
+		g_autoptr(GPtrArray) chunks = klass->write_chunks (self, error);
+		if (chunks == NULL) {
+			g_byte_array_unref (buf);
+			return NULL;
+		}
+		for (guint i = 0; i < chunks->len; i++) {
+			GBytes *chunk = g_ptr_array_index (chunks, i);
+			gsize chunksz = 0;
+			const guint8 *data = g_bytes_get_data (chunk, &chunksz);
+			g_byte_array_append (buf, data, chunksz);
+		}
+		return g_byte_array_free_to_bytes (buf);
+	}
+
 	/* just add default blob */
 	return fu_firmware_get_image_default_bytes (self, error);
 }
 
+/**
+ * fu_firmware_write_chunks:
+ * @self: A #FuFirmware
+ * @error: A #GError, or %NULL
+ *
+ * Writes a firmware as a list of segments that when concatenated form the
+ * same data as fu_firmware_write(). Segments typically reference the image
+ * data directly rather than copying it, which allows large composite images
+ * to be written by scatter-gather output.
+ *
+ * Returns: (transfer container) (element-type GBytes): segments, or %NULL
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fu_firmware_write_chunks (FuFirmware *self, GError **error)
+{
+	FuFirmwareClass *klass = FU_FIRMWARE_GET_CLASS (self);
+	GPtrArray *chunks;
+	GBytes *blob;
+
+	g_return_val_if_fail (FU_IS_FIRMWARE (self), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* subclassed */
+	if (klass->write_chunks != NULL)
+		return klass->write_chunks (self, error);
+
+	/* one segment */
+	blob = fu_firmware_write (self, error);
+	if (blob == NULL)
+		return NULL;
+	chunks = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+	g_ptr_array_add (chunks, blob);
+	return chunks;
+}
+
 /**
  * fu_firmware_write_file:
  * @self: A #FuFirmware
@@ -226,16 +323,26 @@ fu_firmware_write (FuFirmware *self, GError **error)
 gboolean
 fu_firmware_write_file (FuFirmware *self, GFile *file, GError **error)
 {
-	g_autoptr(GBytes) blob = NULL;
-	blob = fu_firmware_write (self, error);
-	if (blob == NULL)
+	g_autoptr(GFileOutputStream) ostream = NULL;
+	g_autoptr(GPtrArray) chunks = NULL;
+
+	chunks = fu_firmware_write_chunks (self, error);
+	if (chunks == NULL)
 		return FALSE;
-	return g_file_replace_contents (file,
-					g_bytes_get_data (blob, NULL),
-					g_bytes_get_size (blob),
-					NULL, FALSE,
-					G_FILE_CREATE_NONE,
-					NULL, NULL, error);
+
+	/* write each segment without joining them first */
+	ostream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error);
+	if (ostream == NULL)
+		return FALSE;
+	for (guint i = 0; i < chunks->len; i++) {
+		GBytes *chunk = g_ptr_array_index (chunks, i);
+		if (!g_output_stream_write_all (G_OUTPUT_STREAM (ostream),
+						g_bytes_get_data (chunk, NULL),
+						g_bytes_get_size (chunk),
+						NULL, NULL, error))
+			return FALSE;
+	}
+	return g_output_stream_close (G_OUTPUT_STREAM (ostream), NULL, error);
 }
 
 /**
@@ -32,8 +32,13 @@ struct _FuFirmwareClass
 							 GBytes		*fw,
 							 FwupdInstallFlags flags,
 							 GError		**error);
+	GPtrArray		*(*write_chunks)	(FuFirmware	*self,
+							 GError		**error);
+	gboolean		 (*check_magic)		(FuFirmware	*self,
+							 GBytes		*fw,
+							 GError		**error);
 	/*< private >*/
-	gpointer		 padding[28];
+	gpointer		 padding[26];
 };
 
 FuFirmware	*fu_firmware_new			(void);
@@ -43,6 +48,9 @@ const gchar	*fu_firmware_get_version		(FuFirmware	*self);
 void		 fu_firmware_set_version		(FuFirmware	*self,
 							 const gchar	*version);
 
+gboolean	 fu_firmware_check_magic		(FuFirmware	*self,
+							 GBytes		*fw,
+							 GError		**error);
 gboolean	 fu_firmware_tokenize			(FuFirmware	*self,
 							 GBytes		*fw,
 							 FwupdInstallFlags flags,
@@ -63,6 +71,8 @@ gboolean	 fu_firmware_parse_full			(FuFirmware	*self,
 							 GError		**error);
 GBytes		*fu_firmware_write			(FuFirmware	*self,
 							 GError		**error);
+GPtrArray	*fu_firmware_write_chunks		(FuFirmware	*self,
+							 GError		**error);
 gboolean	 fu_firmware_write_file			(FuFirmware	*self,
 							 GFile		*file,
 							 GError		**error);
@@ -8,6 +8,10 @@
 
 #include "config.h"
 
+#include "fwupd-error.h"
+
+#include "fu-common.h"
+#include "fu-emulation-private.h"
 #include "fu-hid-device.h"
 
 #define FU_HID_REPORT_GET				0x01
@@ -30,6 +34,8 @@ typedef struct
 {
 	FuUsbDevice		*usb_device;
 	guint8			 interface;
+	guint8			 ep_addr_in;	/* only for _USE_INTERRUPT_TRANSFER */
+	guint8			 ep_addr_out;	/* only for _USE_INTERRUPT_TRANSFER */
 	gboolean		 interface_autodetect;
 } FuHidDevicePrivate;
 
@@ -190,6 +196,55 @@ fu_hid_device_get_interface (FuHidDevice *self)
 	return priv->interface;
 }
 
+/**
+ * fu_hid_device_set_ep_addr_in:
+ * @self: A #FuHidDevice
+ * @ep_addr: An endpoint address, e.g. 0x81
+ *
+ * Sets the interrupt IN endpoint used when %FU_HID_DEVICE_FLAG_USE_INTERRUPT_TRANSFER
+ * is passed to fu_hid_device_get_report().
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_hid_device_set_ep_addr_in (FuHidDevice *self, guint8 ep_addr)
+{
+	FuHidDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_HID_DEVICE (self));
+	priv->ep_addr_in = ep_addr;
+}
+
+/**
+ * fu_hid_device_set_ep_addr_out:
+ * @self: A #FuHidDevice
+ * @ep_addr: An endpoint address, e.g. 0x01
+ *
+ * Sets the interrupt OUT endpoint used when %FU_HID_DEVICE_FLAG_USE_INTERRUPT_TRANSFER
+ * is passed to fu_hid_device_set_report() or fu_hid_device_set_reports().
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_hid_device_set_ep_addr_out (FuHidDevice *self, guint8 ep_addr)
+{
+	FuHidDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_HID_DEVICE (self));
+	priv->ep_addr_out = ep_addr;
+}
+
+static gboolean
+fu_hid_device_check_ep_addr (guint8 ep_addr, GError **error)
+{
+	if (ep_addr == 0x0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "no interrupt endpoint set");
+		return FALSE;
+	}
+	return TRUE;
+}
+
 /**
  * fu_hid_device_set_report:
  * @self: A #FuHidDevice
@@ -230,19 +285,45 @@ fu_hid_device_set_report (FuHidDevice *self,
 
 	if (g_getenv ("FU_HID_DEVICE_VERBOSE") != NULL)
 		fu_common_dump_raw (G_LOG_DOMAIN, "HID::SetReport", buf, bufsz);
-	usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
-	if (!g_usb_device_control_transfer (usb_device,
-					    G_USB_DEVICE_DIRECTION_HOST_TO_DEVICE,
-					    G_USB_DEVICE_REQUEST_TYPE_CLASS,
-					    G_USB_DEVICE_RECIPIENT_INTERFACE,
-					    FU_HID_REPORT_SET,
-					    wvalue, priv->interface,
-					    buf, bufsz,
-					    &actual_len,
-					    timeout,
-					    NULL, error)) {
-		g_prefix_error (error, "failed to SetReport: ");
-		return FALSE;
+	if (fu_emulation_get_mode () == FU_EMULATION_MODE_REPLAY) {
+		if (!fu_emulation_replay_event ("HidSetReport", wvalue, buf, bufsz,
+						NULL, 0, &actual_len, error)) {
+			g_prefix_error (error, "failed to SetReport: ");
+			return FALSE;
+		}
+	} else {
+		gint64 start = g_get_monotonic_time ();
+		g_autoptr(GError) error_local = NULL;
+		usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
+		if (flags & FU_HID_DEVICE_FLAG_USE_INTERRUPT_TRANSFER) {
+			if (!fu_hid_device_check_ep_addr (priv->ep_addr_out, error))
+				return FALSE;
+			g_usb_device_interrupt_transfer (usb_device,
+							 priv->ep_addr_out,
+							 buf, bufsz,
+							 &actual_len,
+							 timeout,
+							 NULL, &error_local);
+		} else {
+			g_usb_device_control_transfer (usb_device,
+						       G_USB_DEVICE_DIRECTION_HOST_TO_DEVICE,
+						       G_USB_DEVICE_REQUEST_TYPE_CLASS,
+						       G_USB_DEVICE_RECIPIENT_INTERFACE,
+						       FU_HID_REPORT_SET,
+						       wvalue, priv->interface,
+						       buf, bufsz,
+						       &actual_len,
+						       timeout,
+						       NULL, &error_local);
+		}
+		fu_emulation_add_event ("HidSetReport", wvalue, buf, bufsz,
+					NULL, 0, start, error_local);
+		if (error_local != NULL) {
+			g_propagate_prefixed_error (error,
+						    g_steal_pointer (&error_local),
+						    "failed to SetReport: ");
+			return FALSE;
+		}
 	}
 	if ((flags & FU_HID_DEVICE_FLAG_ALLOW_TRUNC) == 0 && actual_len != bufsz) {
 		g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
@@ -293,19 +374,45 @@ fu_hid_device_get_report (FuHidDevice *self,
 
 	if (g_getenv ("FU_HID_DEVICE_VERBOSE") != NULL)
 		fu_common_dump_raw (G_LOG_DOMAIN, "HID::GetReport", buf, actual_len);
-	usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
-	if (!g_usb_device_control_transfer (usb_device,
-					    G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST,
-					    G_USB_DEVICE_REQUEST_TYPE_CLASS,
-					    G_USB_DEVICE_RECIPIENT_INTERFACE,
-					    FU_HID_REPORT_GET,
-					    wvalue, priv->interface,
-					    buf, bufsz,
-					    &actual_len, /* actual length */
-					    timeout,
-					    NULL, error)) {
-		g_prefix_error (error, "failed to GetReport: ");
-		return FALSE;
+	if (fu_emulation_get_mode () == FU_EMULATION_MODE_REPLAY) {
+		if (!fu_emulation_replay_event ("HidGetReport", wvalue, NULL, 0,
+						buf, bufsz, &actual_len, error)) {
+			g_prefix_error (error, "failed to GetReport: ");
+			return FALSE;
+		}
+	} else {
+		gint64 start = g_get_monotonic_time ();
+		g_autoptr(GError) error_local = NULL;
+		usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
+		if (flags & FU_HID_DEVICE_FLAG_USE_INTERRUPT_TRANSFER) {
+			if (!fu_hid_device_check_ep_addr (priv->ep_addr_in, error))
+				return FALSE;
+			g_usb_device_interrupt_transfer (usb_device,
+							 priv->ep_addr_in,
+							 buf, bufsz,
+							 &actual_len,
+							 timeout,
+							 NULL, &error_local);
+		} else {
+			g_usb_device_control_transfer (usb_device,
+						       G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST,
+						       G_USB_DEVICE_REQUEST_TYPE_CLASS,
+						       G_USB_DEVICE_RECIPIENT_INTERFACE,
+						       FU_HID_REPORT_GET,
+						       wvalue, priv->interface,
+						       buf, bufsz,
+						       &actual_len, /* actual length */
+						       timeout,
+						       NULL, &error_local);
+		}
+		fu_emulation_add_event ("HidGetReport", wvalue, NULL, 0,
+					buf, actual_len, start, error_local);
+		if (error_local != NULL) {
+			g_propagate_prefixed_error (error,
+						    g_steal_pointer (&error_local),
+						    "failed to GetReport: ");
+			return FALSE;
+		}
 	}
 	if (g_getenv ("FU_HID_DEVICE_VERBOSE") != NULL)
 		fu_common_dump_raw (G_LOG_DOMAIN, "HID::GetReport", buf, actual_len);
@@ -318,6 +425,207 @@ fu_hid_device_get_report (FuHidDevice *self,
 	return TRUE;
 }
 
+typedef struct {
+	FuHidDevice		*self;
+	GMainLoop		*loop;
+	GCancellable		*cancellable;
+	GPtrArray		*reports;
+	GError			*error;		/* first failure */
+	FuHidDeviceFlags	 flags;
+	guint16			 wvalue;
+	guint			 timeout;
+	guint			 max_in_flight;
+	guint			 in_flight;
+	guint			 idx_submit;
+	guint			 idx_complete;
+} FuHidDeviceReportsHelper;
+
+typedef struct {
+	FuHidDeviceReportsHelper *helper;
+	guint			 idx;
+} FuHidDeviceReportsTransfer;
+
+static void fu_hid_device_set_reports_submit (FuHidDeviceReportsHelper *helper);
+
+static void
+fu_hid_device_set_reports_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuHidDeviceReportsTransfer *xfer = (FuHidDeviceReportsTransfer *) user_data;
+	FuHidDeviceReportsHelper *helper = xfer->helper;
+	GByteArray *buf = g_ptr_array_index (helper->reports, xfer->idx);
+	GError *error_local = NULL;
+	gssize actual_len;
+
+	helper->in_flight--;
+	if (helper->flags & FU_HID_DEVICE_FLAG_USE_INTERRUPT_TRANSFER) {
+		actual_len = g_usb_device_interrupt_transfer_finish (G_USB_DEVICE (source),
+								     res, &error_local);
+	} else {
+		actual_len = g_usb_device_control_transfer_finish (G_USB_DEVICE (source),
+								   res, &error_local);
+	}
+	if (actual_len < 0) {
+		g_prefix_error (&error_local, "failed to SetReport %u: ", xfer->idx);
+	} else if ((helper->flags & FU_HID_DEVICE_FLAG_ALLOW_TRUNC) == 0 &&
+		   (gsize) actual_len != buf->len) {
+		error_local = g_error_new (G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+					   "wrote %" G_GSSIZE_FORMAT ", requested %u bytes",
+					   actual_len, buf->len);
+	} else if (xfer->idx != helper->idx_complete) {
+		error_local = g_error_new (FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+					   "report %u completed before report %u",
+					   xfer->idx, helper->idx_complete);
+	} else {
+		helper->idx_complete++;
+		fu_device_set_progress_full (FU_DEVICE (helper->self),
+					     helper->idx_complete,
+					     helper->reports->len);
+	}
+	g_free (xfer);
+
+	/* keep the first error, the rest are likely cancellations */
+	if (error_local != NULL) {
+		if (helper->error == NULL) {
+			helper->error = error_local;
+			g_cancellable_cancel (helper->cancellable);
+		} else {
+			g_error_free (error_local);
+		}
+	}
+
+	/* queue more, or finish when everything has drained */
+	fu_hid_device_set_reports_submit (helper);
+	if (helper->in_flight == 0)
+		g_main_loop_quit (helper->loop);
+}
+
+static void
+fu_hid_device_set_reports_submit (FuHidDeviceReportsHelper *helper)
+{
+	FuHidDevicePrivate *priv = GET_PRIVATE (helper->self);
+	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (helper->self));
+
+	while (helper->error == NULL &&
+	       helper->in_flight < helper->max_in_flight &&
+	       helper->idx_submit < helper->reports->len) {
+		GByteArray *buf = g_ptr_array_index (helper->reports, helper->idx_submit);
+		FuHidDeviceReportsTransfer *xfer = g_new0 (FuHidDeviceReportsTransfer, 1);
+		xfer->helper = helper;
+		xfer->idx = helper->idx_submit++;
+		helper->in_flight++;
+		if (g_getenv ("FU_HID_DEVICE_VERBOSE") != NULL)
+			fu_common_dump_raw (G_LOG_DOMAIN, "HID::SetReport", buf->data, buf->len);
+		if (helper->flags & FU_HID_DEVICE_FLAG_USE_INTERRUPT_TRANSFER) {
+			g_usb_device_interrupt_transfer_async (usb_device,
+							       priv->ep_addr_out,
+							       buf->data, buf->len,
+							       helper->timeout,
+							       helper->cancellable,
+							       fu_hid_device_set_reports_cb,
+							       xfer);
+		} else {
+			g_usb_device_control_transfer_async (usb_device,
+							     G_USB_DEVICE_DIRECTION_HOST_TO_DEVICE,
+							     G_USB_DEVICE_REQUEST_TYPE_CLASS,
+							     G_USB_DEVICE_RECIPIENT_INTERFACE,
+							     FU_HID_REPORT_SET,
+							     helper->wvalue, priv->interface,
+							     buf->data, buf->len,
+							     helper->timeout,
+							     helper->cancellable,
+							     fu_hid_device_set_reports_cb,
+							     xfer);
+		}
+	}
+}
+
+/**
+ * fu_hid_device_set_reports:
+ * @self: A #FuHidDevice
+ * @value: low byte of wValue
+ * @reports: (element-type GByteArray): mutable buffers of data to send
+ * @max_in_flight: the maximum number of reports queued at once, e.g. 4
+ * @timeout: timeout for each report in ms
+ * @flags: #FuHidDeviceFlags e.g. %FU_HID_DEVICE_FLAG_USE_INTERRUPT_TRANSFER
+ * @error: a #GError or %NULL
+ *
+ * Calls SetReport on the hardware for each report in turn, keeping up to
+ * @max_in_flight requests queued so that the device is not idle while the
+ * host prepares the next transfer. This should only be used for reports that
+ * do not require a reply to be read before the next report is sent.
+ *
+ * The reports must complete in the order they were submitted. On the first
+ * failure no more reports are sent, the queued requests are cancelled and
+ * the error is returned once they have finished.
+ *
+ * The device progress is updated as each report completes.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_hid_device_set_reports (FuHidDevice *self,
+			   guint8 value,
+			   GPtrArray *reports,
+			   guint max_in_flight,
+			   guint timeout,
+			   FuHidDeviceFlags flags,
+			   GError **error)
+{
+	FuHidDevicePrivate *priv = GET_PRIVATE (self);
+	FuHidDeviceReportsHelper helper = {
+		.self		= self,
+		.reports	= reports,
+		.flags		= flags,
+		.wvalue		= (FU_HID_REPORT_TYPE_OUTPUT << 8) | value,
+		.timeout	= timeout,
+		.max_in_flight	= MAX (max_in_flight, 1),
+	};
+	g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+	g_autoptr(GMainContext) context = g_main_context_new ();
+	g_autoptr(GMainLoop) loop = g_main_loop_new (context, FALSE);
+
+	g_return_val_if_fail (FU_HID_DEVICE (self), FALSE);
+	g_return_val_if_fail (reports != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* special case */
+	if (flags & FU_HID_DEVICE_FLAG_IS_FEATURE)
+		helper.wvalue = (FU_HID_REPORT_TYPE_FEATURE << 8) | value;
+	if (flags & FU_HID_DEVICE_FLAG_USE_INTERRUPT_TRANSFER) {
+		if (!fu_hid_device_check_ep_addr (priv->ep_addr_out, error))
+			return FALSE;
+	}
+
+	/* each transfer is recorded or replayed in turn */
+	if (fu_emulation_get_mode () != FU_EMULATION_MODE_NONE) {
+		for (guint i = 0; i < reports->len; i++) {
+			GByteArray *buf = g_ptr_array_index (reports, i);
+			if (!fu_hid_device_set_report (self, value, buf->data, buf->len,
+						       timeout, flags, error))
+				return FALSE;
+			fu_device_set_progress_full (FU_DEVICE (self), i + 1, reports->len);
+		}
+		return TRUE;
+	}
+
+	/* completions are dispatched to our own context */
+	helper.loop = loop;
+	helper.cancellable = cancellable;
+	g_main_context_push_thread_default (context);
+	fu_hid_device_set_reports_submit (&helper);
+	if (helper.in_flight > 0)
+		g_main_loop_run (loop);
+	g_main_context_pop_thread_default (context);
+
+	if (helper.error != NULL) {
+		g_propagate_error (error, helper.error);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static void
 fu_hid_device_init (FuHidDevice *self)
 {
@@ -28,6 +28,7 @@ struct _FuHidDeviceClass
  * @FU_HID_DEVICE_FLAG_NONE:			No flags set
  * @FU_HID_DEVICE_FLAG_ALLOW_TRUNC:		Allow truncated reads and writes
  * @FU_HID_DEVICE_FLAG_IS_FEATURE:		Use %FU_HID_REPORT_TYPE_FEATURE for wValue
+ * @FU_HID_DEVICE_FLAG_USE_INTERRUPT_TRANSFER:	Use the interrupt endpoints rather than the control endpoint
  *
  * Flags used when calling fu_hid_device_get_report() and fu_hid_device_set_report().
  **/
@@ -35,6 +36,7 @@ typedef enum {
 	FU_HID_DEVICE_FLAG_NONE			= 0,
 	FU_HID_DEVICE_FLAG_ALLOW_TRUNC		= 1 << 0,
 	FU_HID_DEVICE_FLAG_IS_FEATURE		= 1 << 1,
+	FU_HID_DEVICE_FLAG_USE_INTERRUPT_TRANSFER = 1 << 2,
 	FU_HID_DEVICE_FLAG_LAST
 } FuHidDeviceFlags;
 
@@ -42,6 +44,10 @@ FuHidDevice	*fu_hid_device_new			(GUsbDevice	*usb_device);
 void		 fu_hid_device_set_interface		(FuHidDevice	*self,
 							 guint8		 interface);
 guint8		 fu_hid_device_get_interface		(FuHidDevice	*self);
+void		 fu_hid_device_set_ep_addr_in		(FuHidDevice	*self,
+							 guint8		 ep_addr);
+void		 fu_hid_device_set_ep_addr_out		(FuHidDevice	*self,
+							 guint8		 ep_addr);
 gboolean	 fu_hid_device_set_report		(FuHidDevice	*self,
 							 guint8		 value,
 							 guint8		*buf,
@@ -56,3 +62,10 @@ gboolean	 fu_hid_device_get_report		(FuHidDevice	*self,
 							 guint		 timeout,
 							 FuHidDeviceFlags flags,
 							 GError		**error);
+gboolean	 fu_hid_device_set_reports		(FuHidDevice	*self,
+							 guint8		 value,
+							 GPtrArray	*reports,
+							 guint		 max_in_flight,
+							 guint		 timeout,
+							 FuHidDeviceFlags flags,
+							 GError		**error);
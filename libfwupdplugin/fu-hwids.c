@@ -13,7 +13,7 @@
 #include <string.h>
 
 #include "fu-common.h"
-#include "fu-hwids.h"
+#include "fu-hwids-private.h"
 #include "fwupd-common.h"
 #include "fwupd-error.h"
 
@@ -22,6 +22,7 @@ struct _FuHwids {
 	GHashTable		*hash_dmi_hw;		/* BiosVersion->"1.2.3 " */
 	GHashTable		*hash_dmi_display;	/* BiosVersion->"1.2.3" */
 	GHashTable		*hash_guid;		/* a-c-b-d->1 */
+	GHashTable		*hash_keys_guid;	/* HardwareID-3->a-c-b-d */
 	GPtrArray		*array_guids;		/* a-c-b-d */
 };
 
@@ -251,10 +252,23 @@ fu_hwids_get_replace_values (FuHwids *self, const gchar *keys, GError **error)
 gchar *
 fu_hwids_get_guid (FuHwids *self, const gchar *keys, GError **error)
 {
-	g_autofree gchar *tmp = fu_hwids_get_replace_values (self, keys, error);
+	const gchar *guid_tmp;
+	gchar *guid;
+	g_autofree gchar *tmp = NULL;
+
+	/* already calculated */
+	guid_tmp = g_hash_table_lookup (self->hash_keys_guid, keys);
+	if (guid_tmp != NULL)
+		return g_strdup (guid_tmp);
+
+	tmp = fu_hwids_get_replace_values (self, keys, error);
 	if (tmp == NULL)
 		return NULL;
-	return fu_hwids_get_guid_for_str (tmp, error);
+	guid = fu_hwids_get_guid_for_str (tmp, error);
+	if (guid == NULL)
+		return NULL;
+	g_hash_table_insert (self->hash_keys_guid, g_strdup (keys), g_strdup (guid));
+	return guid;
 }
 
 typedef gchar	*(*FuHwidsConvertFunc)	(FuSmbios	*smbios,
@@ -368,6 +382,9 @@ fu_hwids_setup (FuHwids *self, FuSmbios *smbios, GError **error)
 	g_return_val_if_fail (FU_IS_HWIDS (self), FALSE);
 	g_return_val_if_fail (FU_IS_SMBIOS (smbios), FALSE);
 
+	/* the values are about to change */
+	g_hash_table_remove_all (self->hash_keys_guid);
+
 	/* get all DMI data */
 	for (guint i = 0; map[i].key != NULL; i++) {
 		const gchar *contents_hdr;
@@ -423,6 +440,110 @@ fu_hwids_setup (FuHwids *self, FuSmbios *smbios, GError **error)
 	return TRUE;
 }
 
+static GVariant *
+fu_hwids_hash_to_variant (GHashTable *hash)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	GVariantBuilder builder;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{ss}"));
+	g_hash_table_iter_init (&iter, hash);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		g_variant_builder_add (&builder, "{ss}", key, value);
+	return g_variant_builder_end (&builder);
+}
+
+static void
+fu_hwids_hash_from_variant (GHashTable *hash, GVariant *value)
+{
+	const gchar *key;
+	const gchar *tmp;
+	GVariantIter iter;
+
+	g_hash_table_remove_all (hash);
+	g_variant_iter_init (&iter, value);
+	while (g_variant_iter_next (&iter, "{&s&s}", &key, &tmp))
+		g_hash_table_insert (hash, g_strdup (key), g_strdup (tmp));
+}
+
+/**
+ * fu_hwids_to_variant:
+ * @self: A #FuHwids
+ *
+ * Serializes the values and GUIDs found by fu_hwids_setup() so that they can
+ * be restored without parsing the SMBIOS data again.
+ *
+ * Returns: (transfer floating): a #GVariant of type `a{sv}`
+ *
+ * Since: 1.5.0
+ **/
+GVariant *
+fu_hwids_to_variant (FuHwids *self)
+{
+	GVariantBuilder builder;
+
+	g_return_val_if_fail (FU_IS_HWIDS (self), NULL);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&builder, "{sv}", "Values",
+			       fu_hwids_hash_to_variant (self->hash_dmi_hw));
+	g_variant_builder_add (&builder, "{sv}", "DisplayValues",
+			       fu_hwids_hash_to_variant (self->hash_dmi_display));
+	g_variant_builder_add (&builder, "{sv}", "Guids",
+			       g_variant_new_strv ((const gchar * const *) self->array_guids->pdata,
+						   self->array_guids->len));
+	return g_variant_builder_end (&builder);
+}
+
+/**
+ * fu_hwids_setup_from_variant:
+ * @self: A #FuHwids
+ * @value: A #GVariant from fu_hwids_to_variant()
+ * @error: A #GError or %NULL
+ *
+ * Restores the values and GUIDs previously found by fu_hwids_setup().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_hwids_setup_from_variant (FuHwids *self, GVariant *value, GError **error)
+{
+	g_autofree const gchar **guids = NULL;
+	g_autoptr(GVariant) display = NULL;
+	g_autoptr(GVariant) values = NULL;
+	g_autoptr(GVariant) guids_value = NULL;
+
+	g_return_val_if_fail (FU_IS_HWIDS (self), FALSE);
+	g_return_val_if_fail (value != NULL, FALSE);
+
+	values = g_variant_lookup_value (value, "Values", G_VARIANT_TYPE ("a{ss}"));
+	display = g_variant_lookup_value (value, "DisplayValues", G_VARIANT_TYPE ("a{ss}"));
+	guids_value = g_variant_lookup_value (value, "Guids", G_VARIANT_TYPE_STRING_ARRAY);
+	if (values == NULL || display == NULL || guids_value == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "HWIDs data invalid");
+		return FALSE;
+	}
+	g_hash_table_remove_all (self->hash_keys_guid);
+	fu_hwids_hash_from_variant (self->hash_dmi_hw, values);
+	fu_hwids_hash_from_variant (self->hash_dmi_display, display);
+	g_hash_table_remove_all (self->hash_guid);
+	g_ptr_array_set_size (self->array_guids, 0);
+	guids = g_variant_get_strv (guids_value, NULL);
+	for (guint i = 0; guids[i] != NULL; i++) {
+		g_hash_table_insert (self->hash_guid,
+				     g_strdup (guids[i]),
+				     GUINT_TO_POINTER (1));
+		g_ptr_array_add (self->array_guids, g_strdup (guids[i]));
+	}
+	return TRUE;
+}
+
 static void
 fu_hwids_finalize (GObject *object)
 {
@@ -433,6 +554,7 @@ fu_hwids_finalize (GObject *object)
 	g_hash_table_unref (self->hash_dmi_hw);
 	g_hash_table_unref (self->hash_dmi_display);
 	g_hash_table_unref (self->hash_guid);
+	g_hash_table_unref (self->hash_keys_guid);
 	g_ptr_array_unref (self->array_guids);
 
 	G_OBJECT_CLASS (fu_hwids_parent_class)->finalize (object);
@@ -451,6 +573,7 @@ fu_hwids_init (FuHwids *self)
 	self->hash_dmi_hw = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	self->hash_dmi_display = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	self->hash_guid = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	self->hash_keys_guid = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	self->array_guids = g_ptr_array_new_with_free_func (g_free);
 }
 
@@ -26,6 +26,7 @@
 struct _FuIhexFirmware {
 	FuFirmware		 parent_instance;
 	GPtrArray		*records;
+	GBytes			*fw;
 };
 
 G_DEFINE_TYPE (FuIhexFirmware, fu_ihex_firmware, FU_TYPE_FIRMWARE)
@@ -38,6 +39,67 @@ G_DEFINE_TYPE (FuIhexFirmware, fu_ihex_firmware, FU_TYPE_FIRMWARE)
 #define	DFU_INHX32_RECORD_TYPE_START_LINEAR	0x05
 #define	DFU_INHX32_RECORD_TYPE_SIGNATURE	0xfd
 
+typedef gboolean (*FuIhexFirmwareLineFunc)	(guint		 ln,
+						 const gchar	*line,
+						 gsize		 linesz,
+						 gpointer	 user_data,
+						 GError		**error);
+
+/* splits a private copy of the data in-place, so that each line is NUL
+ * terminated without allocating anything per-line */
+static gboolean
+fu_ihex_firmware_foreach_line (GBytes *fw,
+			       FuIhexFirmwareLineFunc func,
+			       gpointer user_data,
+			       GError **error)
+{
+	gsize sz = 0;
+	const gchar *data = g_bytes_get_data (fw, &sz);
+	g_autofree gchar *buf = g_strndup (data, sz);
+	gchar *line = buf;
+
+	for (guint ln = 1; line != NULL; ln++) {
+		gchar *line_next = strchr (line, '\n');
+		gsize linesz;
+		if (line_next != NULL)
+			*line_next++ = '\0';
+		linesz = strcspn (line, "\r\x1a");
+		line[linesz] = '\0';
+		if (linesz > 0 && !func (ln, line, linesz, user_data, error))
+			return FALSE;
+		line = line_next;
+	}
+	return TRUE;
+}
+
+static void
+fu_ihex_firmware_record_free (FuIhexFirmwareRecord *rcd)
+{
+	g_string_free (rcd->buf, TRUE);
+	g_free (rcd);
+}
+
+static FuIhexFirmwareRecord *
+fu_ihex_firmware_record_new (guint ln, const gchar *buf)
+{
+	FuIhexFirmwareRecord *rcd = g_new0 (FuIhexFirmwareRecord, 1);
+	rcd->ln = ln;
+	rcd->buf = g_string_new (buf);
+	return rcd;
+}
+
+static gboolean
+fu_ihex_firmware_add_record_cb (guint ln,
+				const gchar *line,
+				gsize linesz,
+				gpointer user_data,
+				GError **error)
+{
+	GPtrArray *records = (GPtrArray *) user_data;
+	g_ptr_array_add (records, fu_ihex_firmware_record_new (ln, line));
+	return TRUE;
+}
+
 /**
  * fu_ihex_firmware_get_records:
  * @self: A #FuIhexFirmware
@@ -55,25 +117,14 @@ GPtrArray *
 fu_ihex_firmware_get_records (FuIhexFirmware *self)
 {
 	g_return_val_if_fail (FU_IS_IHEX_FIRMWARE (self), NULL);
-	return self->records;
-}
 
-static void
-fu_ihex_firmware_record_free (FuIhexFirmwareRecord *rcd)
-{
-	g_string_free (rcd->buf, TRUE);
-	g_free (rcd);
-}
-
-G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuIhexFirmwareRecord, fu_ihex_firmware_record_free)
-
-static FuIhexFirmwareRecord *
-fu_ihex_firmware_record_new (guint ln, const gchar *buf)
-{
-	FuIhexFirmwareRecord *rcd = g_new0 (FuIhexFirmwareRecord, 1);
-	rcd->ln = ln;
-	rcd->buf = g_string_new (buf);
-	return rcd;
+	/* most users only want the image, so only split the lines on demand */
+	if (self->records->len == 0 && self->fw != NULL) {
+		fu_ihex_firmware_foreach_line (self->fw,
+					       fu_ihex_firmware_add_record_cb,
+					       self->records, NULL);
+	}
+	return self->records;
 }
 
 static const gchar *
@@ -96,220 +147,259 @@ fu_ihex_firmware_record_type_to_string (guint8 record_type)
 	return NULL;
 }
 
+/* only the first record is checked, skipping any blank lines */
 static gboolean
-fu_ihex_firmware_tokenize (FuFirmware *firmware, GBytes *fw,
-			   FwupdInstallFlags flags, GError **error)
+fu_ihex_firmware_check_magic (FuFirmware *firmware, GBytes *fw, GError **error)
 {
-	FuIhexFirmware *self = FU_IHEX_FIRMWARE (firmware);
 	gsize sz = 0;
 	const gchar *data = g_bytes_get_data (fw, &sz);
-	g_auto(GStrv) lines = fu_common_strnsplit (data, sz, "\n", -1);
 
-	for (guint ln = 0; lines[ln] != NULL; ln++) {
-		g_autoptr(FuIhexFirmwareRecord) rcd = NULL;
-		g_strdelimit (lines[ln], "\r\x1a", '\0');
-		if (lines[ln][0] == '\0')
+	for (gsize i = 0; i < sz; i++) {
+		if (data[i] == '\r' || data[i] == '\n')
 			continue;
-		rcd = fu_ihex_firmware_record_new (ln + 1, lines[ln]);
-		g_ptr_array_add (self->records, g_steal_pointer (&rcd));
+		if (data[i] != ':' || i + 3 > sz || !g_ascii_isxdigit (data[i + 1]) || !g_ascii_isxdigit (data[i + 2]))
+			break;
+		return TRUE;
 	}
-	return TRUE;
+	g_set_error_literal (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "invalid starting token");
+	return FALSE;
 }
 
 static gboolean
-fu_ihex_firmware_parse (FuFirmware *firmware,
-			GBytes *fw,
-			guint64 addr_start,
-			guint64 addr_end,
-			FwupdInstallFlags flags,
-			GError **error)
+fu_ihex_firmware_tokenize (FuFirmware *firmware, GBytes *fw,
+			   FwupdInstallFlags flags, GError **error)
 {
 	FuIhexFirmware *self = FU_IHEX_FIRMWARE (firmware);
-	gboolean got_eof = FALSE;
-	guint32 abs_addr = 0x0;
-	guint32 addr_last = 0x0;
-	guint32 img_addr = G_MAXUINT32;
-	guint32 seg_addr = 0x0;
-	g_autoptr(FuFirmwareImage) img = fu_firmware_image_new (NULL);
-	g_autoptr(GBytes) img_bytes = NULL;
-	g_autoptr(GByteArray) buf = g_byte_array_new ();
-	g_autoptr(GByteArray) buf_signature = g_byte_array_new ();
 
-	/* parse records */
-	for (guint k = 0; k < self->records->len; k++) {
-		FuIhexFirmwareRecord *rcd = g_ptr_array_index (self->records, k);
-		const gchar *line = rcd->buf->str;
-		guint32 addr;
-		guint8 byte_cnt;
-		guint8 record_type;
-		guint line_end;
-
-		/* ignore comments */
-		if (g_str_has_prefix (line, ";"))
-			continue;
+	/* the records are built in fu_ihex_firmware_get_records() if required */
+	g_ptr_array_set_size (self->records, 0);
+	if (self->fw != NULL)
+		g_bytes_unref (self->fw);
+	self->fw = g_bytes_ref (fw);
+	return TRUE;
+}
 
-		/* ignore blank lines */
-		if (rcd->buf->len == 0)
-			continue;
+typedef struct {
+	FwupdInstallFlags	 flags;
+	gboolean		 got_eof;
+	guint32			 abs_addr;
+	guint32			 addr_last;
+	guint32			 img_addr;
+	guint32			 seg_addr;
+	GByteArray		*buf;
+	GByteArray		*buf_signature;
+} FuIhexFirmwareParseHelper;
 
-		/* check starting token */
-		if (line[0] != ':') {
-			g_set_error (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_FILE,
-				     "invalid starting token on line %u: %s",
-				     rcd->ln, line);
-			return FALSE;
-		}
+static gboolean
+fu_ihex_firmware_parse_line_cb (guint ln,
+				const gchar *line,
+				gsize linesz,
+				gpointer user_data,
+				GError **error)
+{
+	FuIhexFirmwareParseHelper *helper = (FuIhexFirmwareParseHelper *) user_data;
+	guint32 addr;
+	guint8 byte_cnt;
+	guint8 record_type;
+	guint line_end;
+	guint8 rec[5 + 0xff];	/* count, addr, type, data, checksum */
+
+	/* ignore comments */
+	if (line[0] == ';')
+		return TRUE;
+
+	/* check starting token */
+	if (line[0] != ':') {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "invalid starting token on line %u: %s",
+			     ln, line);
+		return FALSE;
+	}
 
-		/* check there's enough data for the smallest possible record */
-		if (rcd->buf->len < 11) {
+	/* check there's enough data for the smallest possible record */
+	if (linesz < 11) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "line %u is incomplete, length %u",
+			     ln, (guint) linesz);
+		return FALSE;
+	}
+
+	/* length, 16-bit address, type */
+	byte_cnt = fu_firmware_strparse_uint8 (line + 1);
+	addr = fu_firmware_strparse_uint16 (line + 3);
+	record_type = fu_firmware_strparse_uint8 (line + 7);
+	g_debug ("%s:", fu_ihex_firmware_record_type_to_string (record_type));
+	g_debug ("  addr_start:\t0x%04x", addr);
+	g_debug ("  length:\t0x%02x", byte_cnt);
+	addr += helper->seg_addr;
+	addr += helper->abs_addr;
+	g_debug ("  addr:\t0x%08x", addr);
+
+	/* position of checksum */
+	line_end = 9 + byte_cnt * 2;
+	if (line_end > (guint) linesz) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "line %u malformed, length: %u",
+			     ln, line_end);
+		return FALSE;
+	}
+
+	/* decode each byte just once */
+	for (guint i = 0; i < (guint) byte_cnt + 5; i++)
+		rec[i] = fu_firmware_strparse_uint8 (line + (i * 2) + 1);
+
+	/* verify checksum */
+	if ((helper->flags & FWUPD_INSTALL_FLAG_FORCE) == 0) {
+		guint8 checksum = 0;
+		for (guint i = 0; i < (guint) byte_cnt + 5; i++)
+			checksum += rec[i];
+		if (checksum != 0)  {
 			g_set_error (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_INVALID_FILE,
-				     "line %u is incomplete, length %u",
-				     rcd->ln, (guint) rcd->buf->len);
+				     "line %u has invalid checksum (0x%02x)",
+				     ln, checksum);
 			return FALSE;
 		}
+	}
 
-		/* length, 16-bit address, type */
-		byte_cnt = fu_firmware_strparse_uint8 (line + 1);
-		addr = fu_firmware_strparse_uint16 (line + 3);
-		record_type = fu_firmware_strparse_uint8 (line + 7);
-		g_debug ("%s:", fu_ihex_firmware_record_type_to_string (record_type));
-		g_debug ("  addr_start:\t0x%04x", addr);
-		g_debug ("  length:\t0x%02x", byte_cnt);
-		addr += seg_addr;
-		addr += abs_addr;
-		g_debug ("  addr:\t0x%08x", addr);
-
-		/* position of checksum */
-		line_end = 9 + byte_cnt * 2;
-		if (line_end > (guint) rcd->buf->len) {
+	/* process different record types */
+	switch (record_type) {
+	case DFU_INHX32_RECORD_TYPE_DATA:
+		/* base address for element */
+		if (helper->img_addr == G_MAXUINT32)
+			helper->img_addr = addr;
+
+		/* does not make sense */
+		if (addr < helper->addr_last) {
 			g_set_error (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_INVALID_FILE,
-				     "line %u malformed, length: %u",
-				     rcd->ln, line_end);
+				     "invalid address 0x%x, last was 0x%x on line %u",
+				     (guint) addr,
+				     (guint) helper->addr_last,
+				     ln);
 			return FALSE;
 		}
+		if (byte_cnt == 0)
+			break;
 
-		/* verify checksum */
-		if ((flags & FWUPD_INSTALL_FLAG_FORCE) == 0) {
-			guint8 checksum = 0;
-			for (guint i = 1; i < line_end + 2; i += 2) {
-				guint8 data_tmp = fu_firmware_strparse_uint8 (line + i);
-				checksum += data_tmp;
-			}
-			if (checksum != 0)  {
+		/* any holes in the hex record */
+		g_debug ("writing data 0x%08x", (guint32) addr);
+		if (helper->addr_last > 0) {
+			guint32 len_hole = addr - helper->addr_last;
+			if (len_hole > 0x100000) {
 				g_set_error (error,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_INVALID_FILE,
-					     "line %u has invalid checksum (0x%02x)",
-					     rcd->ln, checksum);
+					     "hole of 0x%x bytes too large to fill on line %u",
+					     (guint) len_hole, ln);
 				return FALSE;
 			}
+			if (len_hole > 1) {
+				guint buf_len = helper->buf->len;
+				g_debug ("filling address 0x%08x to 0x%08x on line %u",
+					 helper->addr_last + 1,
+					 helper->addr_last + len_hole - 1, ln);
+				/* although 0xff might be clearer,
+				 * we can't write 0xffff to pic14 */
+				g_byte_array_set_size (helper->buf, buf_len + len_hole - 1);
+				memset (helper->buf->data + buf_len, 0x00, len_hole - 1);
+			}
 		}
 
-		/* process different record types */
-		switch (record_type) {
-		case DFU_INHX32_RECORD_TYPE_DATA:
-			/* base address for element */
-			if (img_addr == G_MAXUINT32)
-				img_addr = addr;
-
-			/* does not make sense */
-			if (addr < addr_last) {
-				g_set_error (error,
+		/* write into buf */
+		g_byte_array_append (helper->buf, rec + 4, byte_cnt);
+		helper->addr_last = addr + byte_cnt - 1;
+		break;
+	case DFU_INHX32_RECORD_TYPE_EOF:
+		if (helper->got_eof) {
+			g_set_error_literal (error,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_INVALID_FILE,
-					     "invalid address 0x%x, last was 0x%x on line %u",
-					     (guint) addr,
-					     (guint) addr_last,
-					     rcd->ln);
-				return FALSE;
-			}
-
-			/* parse bytes from line */
-			g_debug ("writing data 0x%08x", (guint32) addr);
-			for (guint i = 9; i < line_end; i += 2) {
-				/* any holes in the hex record */
-				guint32 len_hole = addr - addr_last;
-				guint8 data_tmp;
-				if (addr_last > 0 && len_hole > 0x100000) {
-					g_set_error (error,
-						     FWUPD_ERROR,
-						     FWUPD_ERROR_INVALID_FILE,
-						     "hole of 0x%x bytes too large to fill on line %u",
-						     (guint) len_hole,
-						     rcd->ln);
-					return FALSE;
-				}
-				if (addr_last > 0x0 && len_hole > 1) {
-					g_debug ("filling address 0x%08x to 0x%08x on line %u",
-						 addr_last + 1, addr_last + len_hole - 1, rcd->ln);
-					for (guint j = 1; j < len_hole; j++) {
-						/* although 0xff might be clearer,
-						 * we can't write 0xffff to pic14 */
-						fu_byte_array_append_uint8 (buf, 0x00);
-					}
-				}
-				/* write into buf */
-				data_tmp = fu_firmware_strparse_uint8 (line + i);
-				fu_byte_array_append_uint8 (buf, (gchar) data_tmp);
-				addr_last = addr++;
-			}
-			break;
-		case DFU_INHX32_RECORD_TYPE_EOF:
-			if (got_eof) {
-				g_set_error_literal (error,
-						     FWUPD_ERROR,
-						     FWUPD_ERROR_INVALID_FILE,
-						     "duplicate EOF, perhaps "
-						     "corrupt file");
-				return FALSE;
-			}
-			got_eof = TRUE;
-			break;
-		case DFU_INHX32_RECORD_TYPE_EXTENDED_LINEAR:
-			abs_addr = fu_firmware_strparse_uint16 (line + 9) << 16;
-			g_debug ("  abs_addr:\t0x%02x on line %u", abs_addr, rcd->ln);
-			break;
-		case DFU_INHX32_RECORD_TYPE_START_LINEAR:
-			abs_addr = fu_firmware_strparse_uint32 (line + 9);
-			g_debug ("  abs_addr:\t0x%08x on line %u", abs_addr, rcd->ln);
-			break;
-		case DFU_INHX32_RECORD_TYPE_EXTENDED_SEGMENT:
-			/* segment base address, so ~1Mb addressable */
-			seg_addr = fu_firmware_strparse_uint16 (line + 9) * 16;
-			g_debug ("  seg_addr:\t0x%08x on line %u", seg_addr, rcd->ln);
-			break;
-		case DFU_INHX32_RECORD_TYPE_START_SEGMENT:
-			/* initial content of the CS:IP registers */
-			seg_addr = fu_firmware_strparse_uint32 (line + 9);
-			g_debug ("  seg_addr:\t0x%02x on line %u", seg_addr, rcd->ln);
-			break;
-		case DFU_INHX32_RECORD_TYPE_SIGNATURE:
-			for (guint i = 9; i < line_end; i += 2) {
-				guint8 tmp_c = fu_firmware_strparse_uint8 (line + i);
-				fu_byte_array_append_uint8 (buf_signature, tmp_c);
-			}
-			break;
-		default:
-			/* vendors sneak in nonstandard sections past the EOF */
-			if (got_eof)
-				break;
-			g_set_error (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_FILE,
-				     "invalid ihex record type %i on line %u",
-				     record_type, rcd->ln);
+					     "duplicate EOF, perhaps "
+					     "corrupt file");
 			return FALSE;
 		}
+		helper->got_eof = TRUE;
+		break;
+	case DFU_INHX32_RECORD_TYPE_EXTENDED_LINEAR:
+		helper->abs_addr = fu_firmware_strparse_uint16 (line + 9) << 16;
+		g_debug ("  abs_addr:\t0x%02x on line %u", helper->abs_addr, ln);
+		break;
+	case DFU_INHX32_RECORD_TYPE_START_LINEAR:
+		helper->abs_addr = fu_firmware_strparse_uint32 (line + 9);
+		g_debug ("  abs_addr:\t0x%08x on line %u", helper->abs_addr, ln);
+		break;
+	case DFU_INHX32_RECORD_TYPE_EXTENDED_SEGMENT:
+		/* segment base address, so ~1Mb addressable */
+		helper->seg_addr = fu_firmware_strparse_uint16 (line + 9) * 16;
+		g_debug ("  seg_addr:\t0x%08x on line %u", helper->seg_addr, ln);
+		break;
+	case DFU_INHX32_RECORD_TYPE_START_SEGMENT:
+		/* initial content of the CS:IP registers */
+		helper->seg_addr = fu_firmware_strparse_uint32 (line + 9);
+		g_debug ("  seg_addr:\t0x%02x on line %u", helper->seg_addr, ln);
+		break;
+	case DFU_INHX32_RECORD_TYPE_SIGNATURE:
+		g_byte_array_append (helper->buf_signature, rec + 4, byte_cnt);
+		break;
+	default:
+		/* vendors sneak in nonstandard sections past the EOF */
+		if (helper->got_eof)
+			break;
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "invalid ihex record type %i on line %u",
+			     record_type, ln);
+		return FALSE;
 	}
+	return TRUE;
+}
+
+static gboolean
+fu_ihex_firmware_parse (FuFirmware *firmware,
+			GBytes *fw,
+			guint64 addr_start,
+			guint64 addr_end,
+			FwupdInstallFlags flags,
+			GError **error)
+{
+	g_autoptr(FuFirmwareImage) img = fu_firmware_image_new (NULL);
+	g_autoptr(GBytes) img_bytes = NULL;
+	g_autoptr(GByteArray) buf = NULL;
+	g_autoptr(GByteArray) buf_signature = g_byte_array_new ();
+	FuIhexFirmwareParseHelper helper = {
+		.flags		= flags,
+		.got_eof	= FALSE,
+		.abs_addr	= 0x0,
+		.addr_last	= 0x0,
+		.img_addr	= G_MAXUINT32,
+		.seg_addr	= 0x0,
+	};
+
+	/* each data byte needs at least two characters */
+	buf = g_byte_array_sized_new (g_bytes_get_size (fw) / 2);
+	helper.buf = buf;
+	helper.buf_signature = buf_signature;
+
+	/* parse records */
+	if (!fu_ihex_firmware_foreach_line (fw, fu_ihex_firmware_parse_line_cb,
+					    &helper, error))
+		return FALSE;
 
 	/* no EOF */
-	if (!got_eof) {
+	if (!helper.got_eof) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_INVALID_FILE,
@@ -318,10 +408,10 @@ fu_ihex_firmware_parse (FuFirmware *firmware,
 	}
 
 	/* add single image */
-	img_bytes = g_bytes_new (buf->data, buf->len);
+	img_bytes = g_byte_array_free_to_bytes (g_steal_pointer (&buf));
 	fu_firmware_image_set_bytes (img, img_bytes);
-	if (img_addr != G_MAXUINT32)
-		fu_firmware_image_set_addr (img, img_addr);
+	if (helper.img_addr != G_MAXUINT32)
+		fu_firmware_image_set_addr (img, helper.img_addr);
 	fu_firmware_add_image (firmware, img);
 
 	/* add optional signature */
@@ -425,6 +515,8 @@ fu_ihex_firmware_finalize (GObject *object)
 {
 	FuIhexFirmware *self = FU_IHEX_FIRMWARE (object);
 	g_ptr_array_unref (self->records);
+	if (self->fw != NULL)
+		g_bytes_unref (self->fw);
 	G_OBJECT_CLASS (fu_ihex_firmware_parent_class)->finalize (object);
 }
 
@@ -440,6 +532,7 @@ fu_ihex_firmware_class_init (FuIhexFirmwareClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	FuFirmwareClass *klass_firmware = FU_FIRMWARE_CLASS (klass);
 	object_class->finalize = fu_ihex_firmware_finalize;
+	klass_firmware->check_magic = fu_ihex_firmware_check_magic;
 	klass_firmware->parse = fu_ihex_firmware_parse;
 	klass_firmware->tokenize = fu_ihex_firmware_tokenize;
 	klass_firmware->write = fu_ihex_firmware_write;
@@ -17,14 +17,23 @@
 #endif
 #include <string.h>
 #include <sys/stat.h>
+#ifdef HAVE_UIO_H
+#include <sys/uio.h>
+#endif
 
 #include "fwupd-error.h"
 #include "fu-common.h"
+#include "fu-emulation-private.h"
 #include "fu-io-channel.h"
+#include "fu-trace-private.h"
 
 struct _FuIOChannel {
 	GObject			 parent_instance;
 	gint			 fd;
+	guint8			*rbuf;		/* ring buffer, or NULL */
+	gsize			 rbuf_sz;
+	gsize			 rbuf_head;
+	gsize			 rbuf_len;
 };
 
 G_DEFINE_TYPE (FuIOChannel, fu_io_channel, G_TYPE_OBJECT)
@@ -46,6 +55,67 @@ fu_io_channel_unix_get_fd (FuIOChannel *self)
 	return self->fd;
 }
 
+/**
+ * fu_io_channel_set_read_buffer_size:
+ * @self: a #FuIOChannel
+ * @bufsz: size of the read-ahead buffer, or 0 to disable
+ *
+ * Enables a buffered read mode, where nonblocking reads fetch as much data
+ * as is available into a ring buffer and requests are satisfied from that.
+ * Data that exceeds the maximum size of a request is kept for the next read
+ * rather than being returned to the caller.
+ *
+ * Any data already in the buffer is discarded.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_io_channel_set_read_buffer_size (FuIOChannel *self, gsize bufsz)
+{
+	g_return_if_fail (FU_IS_IO_CHANNEL (self));
+	g_clear_pointer (&self->rbuf, g_free);
+	self->rbuf_sz = bufsz;
+	self->rbuf_head = 0;
+	self->rbuf_len = 0;
+	if (bufsz > 0)
+		self->rbuf = g_malloc (bufsz);
+}
+
+/* fill the free space at the end of the ring buffer from the fd */
+static gssize
+fu_io_channel_ring_read (FuIOChannel *self)
+{
+	gsize tail;
+	gsize contig;
+	gssize len;
+
+	/* keep the free space contiguous when possible */
+	if (self->rbuf_len == 0)
+		self->rbuf_head = 0;
+	tail = (self->rbuf_head + self->rbuf_len) % self->rbuf_sz;
+	if (tail >= self->rbuf_head)
+		contig = self->rbuf_sz - tail;
+	else
+		contig = self->rbuf_head - tail;
+	len = read (self->fd, self->rbuf + tail, contig);
+	if (len > 0)
+		self->rbuf_len += len;
+	return len;
+}
+
+/* move up to @max_size bytes from the ring buffer into @buf */
+static void
+fu_io_channel_ring_pop (FuIOChannel *self, GByteArray *buf, gsize max_size)
+{
+	gsize sz = MIN (self->rbuf_len, max_size);
+	gsize sz_first = MIN (sz, self->rbuf_sz - self->rbuf_head);
+	g_byte_array_append (buf, self->rbuf + self->rbuf_head, sz_first);
+	if (sz > sz_first)
+		g_byte_array_append (buf, self->rbuf, sz - sz_first);
+	self->rbuf_head = (self->rbuf_head + sz) % self->rbuf_sz;
+	self->rbuf_len -= sz;
+}
+
 /**
  * fu_io_channel_shutdown:
  * @self: a #FuIOChannel
@@ -74,6 +144,8 @@ fu_io_channel_flush_input (FuIOChannel *self, GError **error)
 		.fd = self->fd,
 		.events = G_IO_IN | G_IO_ERR,
 	};
+	self->rbuf_head = 0;
+	self->rbuf_len = 0;
 	while (g_poll (&poll, 1, 0) > 0) {
 		gchar c;
 		gint r = read (self->fd, &c, 1);
@@ -133,6 +205,89 @@ fu_io_channel_write_byte_array (FuIOChannel *self,
 	return fu_io_channel_write_raw (self, buf->data, buf->len, timeout_ms, flags, error);
 }
 
+/* only called once a write would block, returning 0 on timeout */
+static gint
+fu_io_channel_wait_for_write (FuIOChannel *self, guint timeout_ms, GError **error)
+{
+	gint rc;
+	GPollFD fds = {
+		.fd = self->fd,
+		.events = G_IO_OUT | G_IO_ERR,
+	};
+
+	rc = g_poll (&fds, 1, (gint) timeout_ms);
+	if (rc < 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_READ,
+			     "failed to poll %i",
+			     self->fd);
+		return -1;
+	}
+	return rc;
+}
+
+static gboolean
+fu_io_channel_write_raw_internal (FuIOChannel *self,
+				  const guint8 *data,
+				  gsize datasz,
+				  guint timeout_ms,
+				  FuIOChannelFlags flags,
+				  GError **error)
+{
+	gsize idx = 0;
+
+	/* flush pending reads */
+	if (flags & FU_IO_CHANNEL_FLAG_FLUSH_INPUT) {
+		if (!fu_io_channel_flush_input (self, error))
+			return FALSE;
+	}
+
+	/* blocking IO */
+	if (flags & FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO) {
+		gssize wrote = write (self->fd, data, datasz);
+		if (wrote != (gssize) datasz) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_FAILED,
+				     "failed to write: "
+				     "wrote %" G_GSSIZE_FORMAT " of %" G_GSIZE_FORMAT,
+				     wrote, datasz);
+			return FALSE;
+		}
+		return TRUE;
+	}
+
+	/* nonblocking IO */
+	while (idx < datasz) {
+		gssize len = write (self->fd, data + idx, datasz - idx);
+		if (len < 0) {
+			if (errno == EAGAIN) {
+				gint rc = fu_io_channel_wait_for_write (self, timeout_ms, error);
+				if (rc < 0)
+					return FALSE;
+				if (rc == 0)
+					break;
+				continue;
+			}
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_WRITE,
+				     "failed to write %" G_GSIZE_FORMAT
+				     " bytes to %i: %s" ,
+				     datasz,
+				     self->fd,
+				     strerror (errno));
+			return FALSE;
+		}
+		if (flags & FU_IO_CHANNEL_FLAG_SINGLE_SHOT)
+			break;
+		idx += len;
+	}
+
+	return TRUE;
+}
+
 /**
  * fu_io_channel_write_raw:
  * @self: a #FuIOChannel
@@ -156,9 +311,86 @@ fu_io_channel_write_raw (FuIOChannel *self,
 			 FuIOChannelFlags flags,
 			 GError **error)
 {
+	gboolean ret;
+	gint64 start;
+	g_autoptr(GError) error_local = NULL;
+
+	g_return_val_if_fail (FU_IS_IO_CHANNEL (self), FALSE);
+
+	/* emulated */
+	if (fu_emulation_get_mode () == FU_EMULATION_MODE_REPLAY) {
+		return fu_emulation_replay_event ("IoChannelWrite", 0x0,
+						  data, datasz, NULL, 0,
+						  NULL, error);
+	}
+
+	start = g_get_monotonic_time ();
+	FU_TRACE2 (io_channel_write_begin, self->fd, datasz);
+	ret = fu_io_channel_write_raw_internal (self, data, datasz, timeout_ms, flags, &error_local);
+	FU_TRACE2 (io_channel_write_end, self->fd, ret);
+	if (fu_emulation_get_mode () == FU_EMULATION_MODE_RECORD) {
+		fu_emulation_add_event ("IoChannelWrite", 0x0, data, datasz,
+					NULL, 0, start, error_local);
+	}
+	if (!ret) {
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_io_channel_write_iov:
+ * @self: a #FuIOChannel
+ * @vectors: (array length=n_vectors): buffers to write
+ * @n_vectors: the number of @vectors
+ * @timeout_ms: timeout in ms
+ * @flags: some #FuIOChannelFlags, e.g. %FU_IO_CHANNEL_FLAG_SINGLE_SHOT
+ * @error: a #GError, or %NULL
+ *
+ * Writes several buffers to the TTY using one system call where possible,
+ * that will fail if exceeding @timeout_ms. This is useful when a protocol
+ * sends a small header before each payload.
+ *
+ * NOTE: Do not use this for hidraw devices, where each write must contain
+ * exactly one report.
+ *
+ * Returns: %TRUE if all the bytes was written
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_io_channel_write_iov (FuIOChannel *self,
+			 const GOutputVector *vectors,
+			 gsize n_vectors,
+			 guint timeout_ms,
+			 FuIOChannelFlags flags,
+			 GError **error)
+{
+#ifdef HAVE_UIO_H
+	gsize datasz = 0;
 	gsize idx = 0;
+	g_autofree struct iovec *iov = g_new0 (struct iovec, n_vectors);
+	struct iovec *iov_left = iov;
+	gsize iov_left_n = n_vectors;
 
 	g_return_val_if_fail (FU_IS_IO_CHANNEL (self), FALSE);
+	g_return_val_if_fail (vectors != NULL || n_vectors == 0, FALSE);
+
+	/* emulated transfers are recorded as one write */
+	if (fu_emulation_get_mode () != FU_EMULATION_MODE_NONE) {
+		g_autoptr(GByteArray) buf = g_byte_array_new ();
+		for (gsize i = 0; i < n_vectors; i++)
+			g_byte_array_append (buf, vectors[i].buffer, vectors[i].size);
+		return fu_io_channel_write_raw (self, buf->data, buf->len,
+						timeout_ms, flags, error);
+	}
+
+	for (gsize i = 0; i < n_vectors; i++) {
+		iov[i].iov_base = (gpointer) vectors[i].buffer;
+		iov[i].iov_len = vectors[i].size;
+		datasz += vectors[i].size;
+	}
 
 	/* flush pending reads */
 	if (flags & FU_IO_CHANNEL_FLAG_FLUSH_INPUT) {
@@ -168,7 +400,7 @@ fu_io_channel_write_raw (FuIOChannel *self,
 
 	/* blocking IO */
 	if (flags & FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO) {
-		gssize wrote = write (self->fd, data, datasz);
+		gssize wrote = writev (self->fd, iov, (gint) n_vectors);
 		if (wrote != (gssize) datasz) {
 			g_set_error (error,
 				     G_IO_ERROR,
@@ -183,53 +415,58 @@ fu_io_channel_write_raw (FuIOChannel *self,
 
 	/* nonblocking IO */
 	while (idx < datasz) {
-		gint rc;
-		GPollFD fds = {
-			.fd = self->fd,
-			.events = G_IO_OUT | G_IO_ERR,
-		};
-
-		/* wait for data to be allowed to write without blocking */
-		rc = g_poll (&fds, 1, (gint) timeout_ms);
-		if (rc == 0)
-			break;
-		if (rc < 0) {
+		gssize len = writev (self->fd, iov_left, (gint) iov_left_n);
+		if (len < 0) {
+			if (errno == EAGAIN) {
+				gint rc = fu_io_channel_wait_for_write (self, timeout_ms, error);
+				if (rc < 0)
+					return FALSE;
+				if (rc == 0)
+					break;
+				continue;
+			}
 			g_set_error (error,
 				     FWUPD_ERROR,
-				     FWUPD_ERROR_READ,
-				     "failed to poll %i",
-				     self->fd);
+				     FWUPD_ERROR_WRITE,
+				     "failed to write %" G_GSIZE_FORMAT
+				     " bytes to %i: %s" ,
+				     datasz,
+				     self->fd,
+				     strerror (errno));
 			return FALSE;
 		}
+		if (flags & FU_IO_CHANNEL_FLAG_SINGLE_SHOT)
+			break;
+		idx += len;
 
-		/* we can write data */
-		if (fds.revents & G_IO_OUT) {
-			gssize len = write (self->fd, data + idx, datasz - idx);
-			if (len < 0) {
-				if (errno == EAGAIN) {
-					g_debug ("got EAGAIN, trying harder");
-					continue;
-				}
-				g_set_error (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_WRITE,
-					     "failed to write %" G_GSIZE_FORMAT
-					     " bytes to %i: %s" ,
-					     datasz,
-					     self->fd,
-					     strerror (errno));
-				return FALSE;
-			}
-			if (flags & FU_IO_CHANNEL_FLAG_SINGLE_SHOT)
-				break;
-			idx += len;
+		/* skip over what was written for a short write */
+		while (iov_left_n > 0 && (gsize) len >= iov_left->iov_len) {
+			len -= iov_left->iov_len;
+			iov_left++;
+			iov_left_n--;
+		}
+		if (iov_left_n > 0) {
+			iov_left->iov_base = (guint8 *) iov_left->iov_base + len;
+			iov_left->iov_len -= len;
 		}
 	}
 
 	return TRUE;
+#else
+	/* write each buffer in turn */
+	for (gsize i = 0; i < n_vectors; i++) {
+		if (!fu_io_channel_write_raw (self,
+					      vectors[i].buffer,
+					      vectors[i].size,
+					      timeout_ms,
+					      i == 0 ? flags : flags & ~FU_IO_CHANNEL_FLAG_FLUSH_INPUT,
+					      error))
+			return FALSE;
+	}
+	return TRUE;
+#endif
 }
 
-
 /**
  * fu_io_channel_read_bytes:
  * @self: a #FuIOChannel
@@ -261,26 +498,12 @@ fu_io_channel_read_bytes (FuIOChannel *self,
 	return g_byte_array_free_to_bytes (buf);
 }
 
-/**
- * fu_io_channel_read_byte_array:
- * @self: a #FuIOChannel
- * @max_size: maximum size of the returned blob, or -1 for no limit
- * @timeout_ms: timeout in ms
- * @flags: some #FuIOChannelFlags, e.g. %FU_IO_CHANNEL_FLAG_SINGLE_SHOT
- * @error: a #GError, or %NULL
- *
- * Reads bytes from the TTY, that will fail if exceeding @timeout_ms.
- *
- * Returns: (transfer full): a #GByteArray, or %NULL for error
- *
- * Since: 1.3.2
- **/
-GByteArray *
-fu_io_channel_read_byte_array (FuIOChannel *self,
-			       gssize max_size,
-			       guint timeout_ms,
-			       FuIOChannelFlags flags,
-			       GError **error)
+static GByteArray *
+fu_io_channel_read_byte_array_internal (FuIOChannel *self,
+					gssize max_size,
+					guint timeout_ms,
+					FuIOChannelFlags flags,
+					GError **error)
 {
 	GPollFD fds = {
 		.fd = self->fd,
@@ -288,8 +511,6 @@ fu_io_channel_read_byte_array (FuIOChannel *self,
 	};
 	g_autoptr(GByteArray) buf2 = g_byte_array_new ();
 
-	g_return_val_if_fail (FU_IS_IO_CHANNEL (self), NULL);
-
 	/* blocking IO */
 	if (flags & FU_IO_CHANNEL_FLAG_USE_BLOCKING_IO) {
 		guint8 buf[1024];
@@ -307,6 +528,15 @@ fu_io_channel_read_byte_array (FuIOChannel *self,
 		return g_steal_pointer (&buf2);
 	}
 
+	/* use any data read ahead by a previous request */
+	if (self->rbuf != NULL && self->rbuf_len > 0) {
+		fu_io_channel_ring_pop (self, buf2, max_size > 0 ? (gsize) max_size : G_MAXSIZE);
+		if (max_size > 0 && buf2->len >= (guint) max_size)
+			return g_steal_pointer (&buf2);
+		if (flags & FU_IO_CHANNEL_FLAG_SINGLE_SHOT)
+			return g_steal_pointer (&buf2);
+	}
+
 	/* nonblocking IO */
 	while (TRUE) {
 		/* wait for data to appear */
@@ -331,7 +561,11 @@ fu_io_channel_read_byte_array (FuIOChannel *self,
 		/* we have data to read */
 		if (fds.revents & G_IO_IN) {
 			guint8 buf[1024];
-			gssize len = read (self->fd, buf, sizeof (buf));
+			gssize len;
+			if (self->rbuf != NULL)
+				len = fu_io_channel_ring_read (self);
+			else
+				len = read (self->fd, buf, sizeof (buf));
 			if (len < 0) {
 				if (errno == EINTR)
 					continue;
@@ -344,8 +578,14 @@ fu_io_channel_read_byte_array (FuIOChannel *self,
 					     strerror (errno));
 				return NULL;
 			}
-			if (len > 0)
+			if (self->rbuf != NULL) {
+				gsize max_left = G_MAXSIZE;
+				if (max_size > 0)
+					max_left = (gsize) max_size - buf2->len;
+				fu_io_channel_ring_pop (self, buf2, max_left);
+			} else if (len > 0) {
 				g_byte_array_append (buf2, buf, len);
+			}
 
 			/* check maximum size */
 			if (max_size > 0 && buf2->len >= (guint) max_size)
@@ -391,6 +631,66 @@ fu_io_channel_read_byte_array (FuIOChannel *self,
 	return g_steal_pointer (&buf2);
 }
 
+/**
+ * fu_io_channel_read_byte_array:
+ * @self: a #FuIOChannel
+ * @max_size: maximum size of the returned blob, or -1 for no limit
+ * @timeout_ms: timeout in ms
+ * @flags: some #FuIOChannelFlags, e.g. %FU_IO_CHANNEL_FLAG_SINGLE_SHOT
+ * @error: a #GError, or %NULL
+ *
+ * Reads bytes from the TTY, that will fail if exceeding @timeout_ms.
+ *
+ * If a read buffer has been set using fu_io_channel_set_read_buffer_size()
+ * then no more than @max_size bytes are returned and any data remaining is
+ * used for the next request.
+ *
+ * Returns: (transfer full): a #GByteArray, or %NULL for error
+ *
+ * Since: 1.3.2
+ **/
+GByteArray *
+fu_io_channel_read_byte_array (FuIOChannel *self,
+			       gssize max_size,
+			       guint timeout_ms,
+			       FuIOChannelFlags flags,
+			       GError **error)
+{
+	gint64 start;
+	g_autoptr(GByteArray) buf = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	g_return_val_if_fail (FU_IS_IO_CHANNEL (self), NULL);
+
+	/* emulated, where the request is the maximum size */
+	if (fu_emulation_get_mode () == FU_EMULATION_MODE_REPLAY) {
+		gsize actual_len = 0;
+		buf = g_byte_array_new ();
+		g_byte_array_set_size (buf, max_size > 0 ? (gsize) max_size : 0x10000);
+		if (!fu_emulation_replay_event ("IoChannelRead", (guint64) max_size,
+						NULL, 0, buf->data, buf->len,
+						&actual_len, error))
+			return NULL;
+		g_byte_array_set_size (buf, actual_len);
+		return g_steal_pointer (&buf);
+	}
+
+	start = g_get_monotonic_time ();
+	buf = fu_io_channel_read_byte_array_internal (self, max_size, timeout_ms,
+						      flags, &error_local);
+	if (fu_emulation_get_mode () == FU_EMULATION_MODE_RECORD) {
+		fu_emulation_add_event ("IoChannelRead", (guint64) max_size, NULL, 0,
+					buf != NULL ? buf->data : NULL,
+					buf != NULL ? buf->len : 0,
+					start, error_local);
+	}
+	if (buf == NULL) {
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return NULL;
+	}
+	return g_steal_pointer (&buf);
+}
+
 /**
  * fu_io_channel_read_raw:
  * @self: a #FuIOChannel
@@ -422,7 +722,9 @@ fu_io_channel_read_raw (FuIOChannel *self,
 
 	g_return_val_if_fail (FU_IS_IO_CHANNEL (self), FALSE);
 
+	FU_TRACE2 (io_channel_read_begin, self->fd, bufsz);
 	tmp = fu_io_channel_read_bytes (self, bufsz, timeout_ms, flags, error);
+	FU_TRACE2 (io_channel_read_end, self->fd, tmp != NULL ? g_bytes_get_size (tmp) : 0);
 	if (tmp == NULL)
 		return FALSE;
 	tmpbuf = g_bytes_get_data (tmp, &bytes_read_tmp);
@@ -439,6 +741,7 @@ fu_io_channel_finalize (GObject *object)
 	FuIOChannel *self = FU_IO_CHANNEL (object);
 	if (self->fd != -1)
 		g_close (self->fd, NULL);
+	g_free (self->rbuf);
 	G_OBJECT_CLASS (fu_io_channel_parent_class)->finalize (object);
 }
 
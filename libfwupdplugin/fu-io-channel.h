@@ -6,7 +6,7 @@
 
 #pragma once
 
-#include <glib-object.h>
+#include <gio/gio.h>
 
 #define FU_TYPE_IO_CHANNEL (fu_io_channel_get_type ())
 
@@ -35,6 +35,8 @@ FuIOChannel	*fu_io_channel_new_file		(const gchar	*filename,
 						 GError		**error);
 
 gint		 fu_io_channel_unix_get_fd	(FuIOChannel	*self);
+void		 fu_io_channel_set_read_buffer_size (FuIOChannel *self,
+						 gsize		 bufsz);
 gboolean	 fu_io_channel_shutdown		(FuIOChannel	*self,
 						 GError		**error);
 gboolean	 fu_io_channel_write_raw	(FuIOChannel	*self,
@@ -50,6 +52,12 @@ gboolean	 fu_io_channel_read_raw		(FuIOChannel	*self,
 						 guint		 timeout_ms,
 						 FuIOChannelFlags flags,
 						 GError		**error);
+gboolean	 fu_io_channel_write_iov	(FuIOChannel	*self,
+						 const GOutputVector *vectors,
+						 gsize		 n_vectors,
+						 guint		 timeout_ms,
+						 FuIOChannelFlags flags,
+						 GError		**error);
 gboolean	 fu_io_channel_write_bytes	(FuIOChannel	*self,
 						 GBytes		*bytes,
 						 guint		 timeout_ms,
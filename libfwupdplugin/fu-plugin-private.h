@@ -11,6 +11,11 @@
 #include "fu-security-attrs.h"
 #include "fu-smbios.h"
 
+typedef struct {
+	guint			 count;
+	gint64			 total;		/* µs */
+} FuPluginRunnerDuration;
+
 FuPlugin	*fu_plugin_new				(void);
 gboolean	 fu_plugin_is_open			(FuPlugin	*self);
 void		 fu_plugin_set_usb_context		(FuPlugin	*self,
@@ -19,6 +24,8 @@ void		 fu_plugin_set_hwids			(FuPlugin	*self,
 							 FuHwids	*hwids);
 void		 fu_plugin_set_udev_subsystems		(FuPlugin	*self,
 							 GPtrArray	*udev_subsystems);
+gboolean	 fu_plugin_has_udev_subsystem		(FuPlugin	*self,
+							 const gchar	*subsystem);
 void		 fu_plugin_set_quirks			(FuPlugin	*self,
 							 FuQuirks	*quirks);
 void		 fu_plugin_set_runtime_versions		(FuPlugin	*self,
@@ -49,6 +56,12 @@ gboolean	 fu_plugin_runner_startup		(FuPlugin	*self,
 							 GError		**error);
 gboolean	 fu_plugin_runner_coldplug		(FuPlugin	*self,
 							 GError		**error);
+void		 fu_plugin_defer_device_signals		(FuPlugin	*self);
+void		 fu_plugin_flush_device_signals		(FuPlugin	*self);
+void		 fu_plugin_set_worker_pool		(FuPlugin	*self,
+							 FuWorkerPool	*pool);
+GHashTable	*fu_plugin_get_runner_durations		(FuPlugin	*self);
+void		 fu_plugin_check_watched_files		(FuPlugin	*self);
 gboolean	 fu_plugin_runner_coldplug_prepare	(FuPlugin	*self,
 							 GError		**error);
 gboolean	 fu_plugin_runner_coldplug_cleanup	(FuPlugin	*self,
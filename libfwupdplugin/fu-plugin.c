@@ -20,6 +20,7 @@
 #include "fu-device-private.h"
 #include "fu-plugin-private.h"
 #include "fu-mutex.h"
+#include "fu-trace-private.h"
 
 /**
  * SECTION:fu-plugin
@@ -38,6 +39,7 @@ typedef struct {
 	GModule			*module;
 	GUsbContext		*usb_ctx;
 	gboolean		 enabled;
+	FuPluginFlags		 flags;
 	guint			 order;
 	guint			 priority;
 	GPtrArray		*rules[FU_PLUGIN_RULE_LAST];
@@ -48,11 +50,19 @@ typedef struct {
 	GHashTable		*runtime_versions;
 	GHashTable		*compile_versions;
 	GPtrArray		*udev_subsystems;
+	GPtrArray		*udev_subsystems_plugin;	/* only those added by this plugin */
+	GHashTable		*watched_files;	/* filename:contents */
 	FuSmbios		*smbios;
 	GType			 device_gtype;
 	GHashTable		*devices;	/* platform_id:GObject */
 	GRWLock			 devices_mutex;
 	GHashTable		*report_metadata;	/* key:value */
+	GPtrArray		*deferred_signals;	/* of FuPluginDeferredSignal */
+	FuWorkerPool		*worker_pool;		/* shared by the daemon */
+	FuWorkerBatch		*device_jobs_batch;
+	GPtrArray		*device_jobs;		/* of FuPluginDeviceJob */
+	GHashTable		*runner_durations;	/* vfunc:FuPluginRunnerDuration */
+	GMutex			 runner_durations_mutex;
 	FuPluginData		*data;
 } FuPluginPrivate;
 
@@ -66,11 +76,22 @@ enum {
 	SIGNAL_CHECK_SUPPORTED,
 	SIGNAL_ADD_FIRMWARE_GTYPE,
 	SIGNAL_SECURITY_CHANGED,
+	SIGNAL_RESCAN,
 	SIGNAL_LAST
 };
 
 static guint signals[SIGNAL_LAST] = { 0 };
 
+typedef struct {
+	guint			 signal_id;
+	FuDevice		*device;
+} FuPluginDeferredSignal;
+
+typedef struct {
+	FuDevice		*device;
+	GError			*error;
+} FuPluginDeviceJob;
+
 G_DEFINE_TYPE_WITH_PRIVATE (FuPlugin, fu_plugin, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (fu_plugin_get_instance_private (o))
 
@@ -399,6 +420,71 @@ fu_plugin_guess_name_from_fn (const gchar *filename)
 	return name;
 }
 
+/* accumulates the time spent in each plugin vfunc so the daemon can show
+ * where the startup time went -- this can be called from a coldplug thread */
+/* returns the start time to pass to fu_plugin_runner_record() */
+static gint64
+fu_plugin_runner_begin (FuPlugin *self, const gchar *symbol_name)
+{
+	if (g_str_has_prefix (symbol_name, "fu_plugin_"))
+		symbol_name += 10;
+	FU_TRACE2 (plugin_runner_begin, fu_plugin_get_name (self), symbol_name);
+	return g_get_monotonic_time ();
+}
+
+static void
+fu_plugin_runner_record (FuPlugin *self, const gchar *symbol_name, gint64 start)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	FuPluginRunnerDuration *duration;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->runner_durations_mutex);
+
+	if (g_str_has_prefix (symbol_name, "fu_plugin_"))
+		symbol_name += 10;
+	FU_TRACE3 (plugin_runner_end, priv->name, symbol_name,
+		   g_get_monotonic_time () - start);
+	duration = g_hash_table_lookup (priv->runner_durations, symbol_name);
+	if (duration == NULL) {
+		duration = g_new0 (FuPluginRunnerDuration, 1);
+		g_hash_table_insert (priv->runner_durations,
+				     g_strdup (symbol_name), duration);
+	}
+	duration->count++;
+	duration->total += g_get_monotonic_time () - start;
+}
+
+/**
+ * fu_plugin_get_runner_durations:
+ * @self: A #FuPlugin
+ *
+ * Gets the accumulated time spent in each plugin vfunc, e.g. `coldplug`.
+ *
+ * Returns: (transfer container) (element-type utf8 FuPluginRunnerDuration):
+ * a new hash table of durations
+ *
+ * Since: 1.5.0
+ **/
+GHashTable *
+fu_plugin_get_runner_durations (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	GHashTable *copy;
+	GHashTableIter iter;
+	gpointer key, value;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_PLUGIN (self), NULL);
+
+	copy = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	locker = g_mutex_locker_new (&priv->runner_durations_mutex);
+	g_hash_table_iter_init (&iter, priv->runner_durations);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		g_hash_table_insert (copy, g_strdup (key),
+				     g_memdup (value, sizeof(FuPluginRunnerDuration)));
+	}
+	return copy;
+}
+
 /**
  * fu_plugin_open:
  * @self: A #FuPlugin
@@ -416,8 +502,10 @@ fu_plugin_open (FuPlugin *self, const gchar *filename, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginInitFunc func = NULL;
+	gint64 start = fu_plugin_runner_begin (self, "fu_plugin_open");
 
 	priv->module = g_module_open (filename, 0);
+	fu_plugin_runner_record (self, "fu_plugin_open", start);
 	if (priv->module == NULL) {
 		g_set_error (error,
 			     G_IO_ERROR,
@@ -435,12 +523,233 @@ fu_plugin_open (FuPlugin *self, const gchar *filename, GError **error)
 	g_module_symbol (priv->module, "fu_plugin_init", (gpointer *) &func);
 	if (func != NULL) {
 		g_debug ("performing init() on %s", filename);
+		start = fu_plugin_runner_begin (self, "fu_plugin_init");
 		func (self);
+		fu_plugin_runner_record (self, "fu_plugin_init", start);
 	}
 
 	return TRUE;
 }
 
+static void
+fu_plugin_deferred_signal_free (FuPluginDeferredSignal *helper)
+{
+	g_object_unref (helper->device);
+	g_free (helper);
+}
+
+/* if the coldplug is running in a worker thread the signal is queued so that
+ * the daemon only ever sees devices added from the main thread */
+static void
+fu_plugin_emit_device_signal (FuPlugin *self, guint signal_id, FuDevice *device)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	FuPluginDeferredSignal *helper;
+
+	if (priv->deferred_signals == NULL) {
+		g_signal_emit (self, signals[signal_id], 0, device);
+		return;
+	}
+	helper = g_new0 (FuPluginDeferredSignal, 1);
+	helper->signal_id = signal_id;
+	helper->device = g_object_ref (device);
+	g_ptr_array_add (priv->deferred_signals, helper);
+}
+
+/**
+ * fu_plugin_defer_device_signals:
+ * @self: A #FuPlugin
+ *
+ * Queues the ::device-added, ::device-register and ::device-removed signals
+ * until fu_plugin_flush_device_signals() is called.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_plugin_defer_device_signals (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_PLUGIN (self));
+	if (priv->deferred_signals != NULL)
+		return;
+	priv->deferred_signals = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_plugin_deferred_signal_free);
+}
+
+/**
+ * fu_plugin_flush_device_signals:
+ * @self: A #FuPlugin
+ *
+ * Emits any queued device signals in the order they were added, and then
+ * stops deferring signals.
+ *
+ * This must be called from the thread that owns the daemon main context.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_plugin_flush_device_signals (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GPtrArray) deferred_signals = NULL;
+
+	g_return_if_fail (FU_IS_PLUGIN (self));
+
+	deferred_signals = g_steal_pointer (&priv->deferred_signals);
+	if (deferred_signals == NULL)
+		return;
+	for (guint i = 0; i < deferred_signals->len; i++) {
+		FuPluginDeferredSignal *helper = g_ptr_array_index (deferred_signals, i);
+		g_signal_emit (self, signals[helper->signal_id], 0, helper->device);
+	}
+}
+
+static void
+fu_plugin_device_job_free (FuPluginDeviceJob *job)
+{
+	g_object_unref (job->device);
+	if (job->error != NULL)
+		g_error_free (job->error);
+	g_free (job);
+}
+
+static gboolean
+fu_plugin_device_job_open (FuDevice *device, GError **error)
+{
+	if (!fu_device_open (device, error)) {
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_device_close (device, &error_local))
+			g_debug ("failed to close: %s", error_local->message);
+		return FALSE;
+	}
+	return fu_device_close (device, error);
+}
+
+/* opening the device probes and sets it up */
+static void
+fu_plugin_device_job_run (gpointer data, GCancellable *cancellable)
+{
+	FuPluginDeviceJob *job = (FuPluginDeviceJob *) data;
+	fu_plugin_device_job_open (job->device, &job->error);
+}
+
+/**
+ * fu_plugin_set_worker_pool: (skip):
+ * @self: A #FuPlugin
+ * @pool: (nullable): A #FuWorkerPool
+ *
+ * Sets the worker pool shared by all the plugins and the engine.
+ **/
+void
+fu_plugin_set_worker_pool (FuPlugin *self, FuWorkerPool *pool)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_PLUGIN (self));
+	g_set_object (&priv->worker_pool, pool);
+}
+
+/**
+ * fu_plugin_get_worker_pool:
+ * @self: A #FuPlugin
+ *
+ * Gets the worker pool owned by the daemon, which should be used with
+ * fu_worker_batch_new() rather than the plugin creating threads of its own.
+ *
+ * Returns: (transfer none) (nullable): a #FuWorkerPool, or %NULL if not
+ * running in the daemon, in which case the jobs are run straight away
+ *
+ * Since: 1.5.0
+ **/
+FuWorkerPool *
+fu_plugin_get_worker_pool (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_PLUGIN (self), NULL);
+	return priv->worker_pool;
+}
+
+/**
+ * fu_plugin_add_device_job:
+ * @self: A #FuPlugin
+ * @device: A #FuDevice
+ *
+ * Opens the device in a worker thread so that several slow devices can be
+ * probed and set up at the same time, typically from fu_plugin_coldplug().
+ * The device is closed once setup is complete and is added using
+ * fu_plugin_device_add() when fu_plugin_flush_device_jobs() is called.
+ *
+ * Only use this when the probe, open and setup vfuncs of @device do not share
+ * any state with other devices, e.g. a bus or a global I/O port. If the
+ * daemon has no worker pool the device is opened straight away.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_plugin_add_device_job (FuPlugin *self, FuDevice *device)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	FuPluginDeviceJob *job;
+
+	g_return_if_fail (FU_IS_PLUGIN (self));
+	g_return_if_fail (FU_IS_DEVICE (device));
+
+	if (priv->device_jobs_batch == NULL) {
+		priv->device_jobs_batch = fu_worker_batch_new (priv->worker_pool,
+							       FU_WORKER_PRIORITY_BACKGROUND,
+							       NULL);
+		priv->device_jobs = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_plugin_device_job_free);
+	}
+	job = g_new0 (FuPluginDeviceJob, 1);
+	job->device = g_object_ref (device);
+	g_ptr_array_add (priv->device_jobs, job);
+	fu_worker_batch_add (priv->device_jobs_batch, fu_plugin_device_job_run, job);
+}
+
+/**
+ * fu_plugin_flush_device_jobs:
+ * @self: A #FuPlugin
+ * @error: A #GError, or %NULL
+ *
+ * Waits for all the devices submitted using fu_plugin_add_device_job() and
+ * adds the ones that were set up successfully, in the order they were
+ * submitted.
+ *
+ * Returns: %FALSE if any device failed to open, with the first error set
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_plugin_flush_device_jobs (FuPlugin *self, GError **error)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(FuWorkerBatch) batch = NULL;
+	g_autoptr(GPtrArray) jobs = NULL;
+
+	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* wait for everything to complete */
+	if (priv->device_jobs_batch == NULL)
+		return TRUE;
+	batch = g_steal_pointer (&priv->device_jobs_batch);
+	jobs = g_steal_pointer (&priv->device_jobs);
+	fu_worker_batch_wait (batch);
+
+	/* add devices from this thread */
+	for (guint i = 0; i < jobs->len; i++) {
+		FuPluginDeviceJob *job = g_ptr_array_index (jobs, i);
+		if (job->error != NULL) {
+			g_debug ("failed to set up %s: %s",
+				 fu_device_get_name (job->device),
+				 job->error->message);
+			if (error != NULL && *error == NULL)
+				*error = g_error_copy (job->error);
+			continue;
+		}
+		fu_plugin_device_add (self, job->device);
+	}
+	return error == NULL || *error == NULL;
+}
+
 /**
  * fu_plugin_device_add:
  * @self: A #FuPlugin
@@ -476,7 +785,7 @@ fu_plugin_device_add (FuPlugin *self, FuDevice *device)
 		 fu_device_get_id (device));
 	fu_device_set_created (device, (guint64) g_get_real_time () / G_USEC_PER_SEC);
 	fu_device_set_plugin (device, fu_plugin_get_name (self));
-	g_signal_emit (self, signals[SIGNAL_DEVICE_ADDED], 0, device);
+	fu_plugin_emit_device_signal (self, SIGNAL_DEVICE_ADDED, device);
 
 	/* add children if they have not already been added */
 	children = fu_device_get_children (device);
@@ -518,7 +827,7 @@ fu_plugin_device_register (FuPlugin *self, FuDevice *device)
 	g_debug ("emit device-register from %s: %s",
 		 fu_plugin_get_name (self),
 		 fu_device_get_id (device));
-	g_signal_emit (self, signals[SIGNAL_DEVICE_REGISTER], 0, device);
+	fu_plugin_emit_device_signal (self, SIGNAL_DEVICE_REGISTER, device);
 }
 
 /**
@@ -539,7 +848,7 @@ fu_plugin_device_remove (FuPlugin *self, FuDevice *device)
 	g_debug ("emit removed from %s: %s",
 		 fu_plugin_get_name (self),
 		 fu_device_get_id (device));
-	g_signal_emit (self, signals[SIGNAL_DEVICE_REMOVED], 0, device);
+	fu_plugin_emit_device_signal (self, SIGNAL_DEVICE_REMOVED, device);
 }
 
 /**
@@ -558,6 +867,25 @@ fu_plugin_request_recoldplug (FuPlugin *self)
 	g_signal_emit (self, signals[SIGNAL_RECOLDPLUG], 0);
 }
 
+/**
+ * fu_plugin_request_rescan:
+ * @self: A #FuPlugin
+ * @physical_id: a physical ID, e.g. `PCI_SLOT_NAME=0000:3e:00.0`
+ *
+ * Ask the daemon to rescan just the devices added by this plugin with the
+ * physical ID, for instance after a dock changes state. This is much cheaper
+ * than fu_plugin_request_recoldplug() as the other devices are left alone.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_plugin_request_rescan (FuPlugin *self, const gchar *physical_id)
+{
+	g_return_if_fail (FU_IS_PLUGIN (self));
+	g_return_if_fail (physical_id != NULL);
+	g_signal_emit (self, signals[SIGNAL_RESCAN], 0, physical_id);
+}
+
 /**
  * fu_plugin_security_changed:
  * @self: A #FuPlugin
@@ -573,6 +901,80 @@ fu_plugin_security_changed (FuPlugin *self)
 	g_signal_emit (self, signals[SIGNAL_SECURITY_CHANGED], 0);
 }
 
+static gchar *
+fu_plugin_watched_file_get_contents (const gchar *filename)
+{
+	gchar *buf = NULL;
+	g_autoptr(GError) error_local = NULL;
+	if (!g_file_get_contents (filename, &buf, NULL, &error_local)) {
+		g_debug ("failed to read watched file: %s", error_local->message);
+		return g_strdup ("");
+	}
+	return buf;
+}
+
+/**
+ * fu_plugin_add_watched_file:
+ * @self: A #FuPlugin
+ * @filename: A filename, e.g. `/proc/swaps`
+ *
+ * Asks the daemon to call fu_plugin_security_changed() when the contents of
+ * the file change. This should be used instead of a #GFileMonitor for procfs
+ * and sysfs files, which do not emit inotify events.
+ *
+ * The daemon re-reads all the watched files from every plugin on a single
+ * timer, so the file should be small.
+ *
+ * Plugins can use this method only in fu_plugin_init() or fu_plugin_startup()
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_plugin_add_watched_file (FuPlugin *self, const gchar *filename)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_PLUGIN (self));
+	g_return_if_fail (filename != NULL);
+	g_debug ("added file watch of %s", filename);
+	g_hash_table_insert (priv->watched_files,
+			     g_strdup (filename),
+			     fu_plugin_watched_file_get_contents (filename));
+}
+
+/**
+ * fu_plugin_check_watched_files: (skip):
+ * @self: A #FuPlugin
+ *
+ * Re-reads the files added with fu_plugin_add_watched_file(), and emits
+ * ::security-changed once if any of them are different.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_plugin_check_watched_files (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	GHashTableIter iter;
+	gpointer key, value;
+	gboolean changed = FALSE;
+
+	g_return_if_fail (FU_IS_PLUGIN (self));
+
+	g_hash_table_iter_init (&iter, priv->watched_files);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		gchar *buf = fu_plugin_watched_file_get_contents (key);
+		if (g_strcmp0 (buf, value) == 0) {
+			g_free (buf);
+			continue;
+		}
+		g_debug ("%s changed", (const gchar *) key);
+		g_hash_table_iter_replace (&iter, buf);
+		changed = TRUE;
+	}
+	if (changed)
+		fu_plugin_security_changed (self);
+}
+
 /**
  * fu_plugin_check_hwid:
  * @self: A #FuPlugin
@@ -762,6 +1164,26 @@ fu_plugin_get_smbios_data (FuPlugin *self, guint8 structure_type)
 	return fu_smbios_get_data (priv->smbios, structure_type, NULL);
 }
 
+/**
+ * fu_plugin_get_smbios_data_all:
+ * @self: A #FuPlugin
+ * @structure_type: A SMBIOS structure type, e.g. %FU_SMBIOS_STRUCTURE_TYPE_BIOS
+ *
+ * Gets all the hardware SMBIOS data of a specific type.
+ *
+ * Returns: (transfer container) (element-type GBytes): data, or %NULL
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fu_plugin_get_smbios_data_all (FuPlugin *self, guint8 structure_type)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	if (priv->smbios == NULL)
+		return NULL;
+	return fu_smbios_get_data_all (priv->smbios, structure_type, NULL);
+}
+
 /**
  * fu_plugin_set_hwids:
  * @self: A #FuPlugin
@@ -1101,6 +1523,8 @@ fu_plugin_runner_startup (FuPlugin *self, GError **error)
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -1115,7 +1539,10 @@ fu_plugin_runner_startup (FuPlugin *self, GError **error)
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing startup() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	start = fu_plugin_runner_begin (self, "fu_plugin_startup");
+	ret = func (self, &error_local);
+	fu_plugin_runner_record (self, "fu_plugin_startup", start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for startup()",
 				    priv->name);
@@ -1141,6 +1568,8 @@ fu_plugin_runner_device_generic (FuPlugin *self, FuDevice *device,
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -1161,7 +1590,10 @@ fu_plugin_runner_device_generic (FuPlugin *self, FuDevice *device,
 		return TRUE;
 	}
 	g_debug ("performing %s() on %s", symbol_name + 10, priv->name);
-	if (!func (self, device, &error_local)) {
+	start = fu_plugin_runner_begin (self, symbol_name);
+	ret = func (self, device, &error_local);
+	fu_plugin_runner_record (self, symbol_name, start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for %s()",
 				    priv->name, symbol_name + 10);
@@ -1186,6 +1618,8 @@ fu_plugin_runner_flagged_device_generic (FuPlugin *self, FwupdInstallFlags flags
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginFlaggedDeviceFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -1200,7 +1634,10 @@ fu_plugin_runner_flagged_device_generic (FuPlugin *self, FwupdInstallFlags flags
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing %s() on %s", symbol_name + 10, priv->name);
-	if (!func (self, flags, device, &error_local)) {
+	start = fu_plugin_runner_begin (self, symbol_name);
+	ret = func (self, flags, device, &error_local);
+	fu_plugin_runner_record (self, symbol_name, start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for %s()",
 				    priv->name, symbol_name + 10);
@@ -1225,6 +1662,8 @@ fu_plugin_runner_device_array_generic (FuPlugin *self, GPtrArray *devices,
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceArrayFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -1239,7 +1678,10 @@ fu_plugin_runner_device_array_generic (FuPlugin *self, GPtrArray *devices,
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing %s() on %s", symbol_name + 10, priv->name);
-	if (!func (self, devices, &error_local)) {
+	start = fu_plugin_runner_begin (self, symbol_name);
+	ret = func (self, devices, &error_local);
+	fu_plugin_runner_record (self, symbol_name, start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for %s()",
 				    priv->name, symbol_name + 10);
@@ -1273,6 +1715,8 @@ fu_plugin_runner_coldplug (FuPlugin *self, GError **error)
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -1287,7 +1731,10 @@ fu_plugin_runner_coldplug (FuPlugin *self, GError **error)
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing coldplug() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	start = fu_plugin_runner_begin (self, "fu_plugin_coldplug");
+	ret = func (self, &error_local);
+	fu_plugin_runner_record (self, "fu_plugin_coldplug", start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for coldplug()",
 				    priv->name);
@@ -1320,6 +1767,8 @@ fu_plugin_runner_recoldplug (FuPlugin *self, GError **error)
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -1334,7 +1783,10 @@ fu_plugin_runner_recoldplug (FuPlugin *self, GError **error)
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing recoldplug() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	start = fu_plugin_runner_begin (self, "fu_plugin_recoldplug");
+	ret = func (self, &error_local);
+	fu_plugin_runner_record (self, "fu_plugin_recoldplug", start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for recoldplug()",
 				    priv->name);
@@ -1368,6 +1820,8 @@ fu_plugin_runner_coldplug_prepare (FuPlugin *self, GError **error)
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -1382,7 +1836,10 @@ fu_plugin_runner_coldplug_prepare (FuPlugin *self, GError **error)
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing coldplug_prepare() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	start = fu_plugin_runner_begin (self, "fu_plugin_coldplug_prepare");
+	ret = func (self, &error_local);
+	fu_plugin_runner_record (self, "fu_plugin_coldplug_prepare", start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for coldplug_prepare()",
 				    priv->name);
@@ -1416,6 +1873,8 @@ fu_plugin_runner_coldplug_cleanup (FuPlugin *self, GError **error)
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -1430,7 +1889,10 @@ fu_plugin_runner_coldplug_cleanup (FuPlugin *self, GError **error)
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing coldplug_cleanup() on %s", priv->name);
-	if (!func (self, &error_local)) {
+	start = fu_plugin_runner_begin (self, "fu_plugin_coldplug_cleanup");
+	ret = func (self, &error_local);
+	fu_plugin_runner_record (self, "fu_plugin_coldplug_cleanup", start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for coldplug_cleanup()",
 				    priv->name);
@@ -1542,6 +2004,10 @@ fu_plugin_runner_update_cleanup (FuPlugin *self, FwupdInstallFlags flags, FuDevi
 gboolean
 fu_plugin_runner_update_attach (FuPlugin *self, FuDevice *device, GError **error)
 {
+	/* restored from the cache */
+	if (!fu_device_ensure_setup (device, error))
+		return FALSE;
+
 	return fu_plugin_runner_device_generic (self, device,
 						"fu_plugin_update_attach",
 						fu_plugin_device_attach,
@@ -1563,6 +2029,10 @@ fu_plugin_runner_update_attach (FuPlugin *self, FuDevice *device, GError **error
 gboolean
 fu_plugin_runner_update_detach (FuPlugin *self, FuDevice *device, GError **error)
 {
+	/* restored from the cache */
+	if (!fu_device_ensure_setup (device, error))
+		return FALSE;
+
 	return fu_plugin_runner_device_generic (self, device,
 						"fu_plugin_update_detach",
 						fu_plugin_device_detach,
@@ -1612,6 +2082,7 @@ fu_plugin_runner_add_security_attrs (FuPlugin *self, FuSecurityAttrs *attrs)
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginSecurityAttrsFunc func = NULL;
 	const gchar *symbol_name = "fu_plugin_add_security_attrs";
+	gint64 start;
 
 	/* no object loaded */
 	if (priv->module == NULL)
@@ -1622,7 +2093,9 @@ fu_plugin_runner_add_security_attrs (FuPlugin *self, FuSecurityAttrs *attrs)
 	if (func == NULL)
 		return;
 	g_debug ("performing %s() on %s", symbol_name + 10, priv->name);
+	start = fu_plugin_runner_begin (self, symbol_name);
 	func (self, attrs);
+	fu_plugin_runner_record (self, symbol_name, start);
 }
 
 /**
@@ -1640,6 +2113,8 @@ void
 fu_plugin_add_udev_subsystem (FuPlugin *self, const gchar *subsystem)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	if (!fu_plugin_has_udev_subsystem (self, subsystem))
+		g_ptr_array_add (priv->udev_subsystems_plugin, g_strdup (subsystem));
 	for (guint i = 0; i < priv->udev_subsystems->len; i++) {
 		const gchar *subsystem_tmp = g_ptr_array_index (priv->udev_subsystems, i);
 		if (g_strcmp0 (subsystem_tmp, subsystem) == 0)
@@ -1649,6 +2124,31 @@ fu_plugin_add_udev_subsystem (FuPlugin *self, const gchar *subsystem)
 	g_ptr_array_add (priv->udev_subsystems, g_strdup (subsystem));
 }
 
+/**
+ * fu_plugin_has_udev_subsystem:
+ * @self: a #FuPlugin
+ * @subsystem: a subsystem name, e.g. `pciport`
+ *
+ * Finds out if this plugin registered the udev subsystem using
+ * fu_plugin_add_udev_subsystem().
+ *
+ * Returns: %TRUE if the subsystem was added by this plugin
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_plugin_has_udev_subsystem (FuPlugin *self, const gchar *subsystem)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
+	for (guint i = 0; i < priv->udev_subsystems_plugin->len; i++) {
+		const gchar *subsystem_tmp = g_ptr_array_index (priv->udev_subsystems_plugin, i);
+		if (g_strcmp0 (subsystem_tmp, subsystem) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
 /**
  * fu_plugin_set_device_gtype:
  * @self: a #FuPlugin
@@ -1811,6 +2311,8 @@ fu_plugin_runner_usb_device_added (FuPlugin *self, FuUsbDevice *device, GError *
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginUsbDeviceAddedFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -1830,8 +2332,13 @@ fu_plugin_runner_usb_device_added (FuPlugin *self, FuUsbDevice *device, GError *
 		}
 		return TRUE;
 	}
+	/* the plugin creates the device, so the cache cannot be trusted */
+	fu_device_set_setup_cache (FU_DEVICE (device), NULL);
 	g_debug ("performing usb_device_added() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	start = fu_plugin_runner_begin (self, "fu_plugin_usb_device_added");
+	ret = func (self, device, &error_local);
+	fu_plugin_runner_record (self, "fu_plugin_usb_device_added", start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for usb_device_added()",
 				    priv->name);
@@ -1866,6 +2373,8 @@ fu_plugin_runner_udev_device_added (FuPlugin *self, FuUdevDevice *device, GError
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginUdevDeviceAddedFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -1885,8 +2394,13 @@ fu_plugin_runner_udev_device_added (FuPlugin *self, FuUdevDevice *device, GError
 		}
 		return TRUE;
 	}
+	/* the plugin creates the device, so the cache cannot be trusted */
+	fu_device_set_setup_cache (FU_DEVICE (device), NULL);
 	g_debug ("performing udev_device_added() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	start = fu_plugin_runner_begin (self, "fu_plugin_udev_device_added");
+	ret = func (self, device, &error_local);
+	fu_plugin_runner_record (self, "fu_plugin_udev_device_added", start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for udev_device_added()",
 				    priv->name);
@@ -1921,6 +2435,8 @@ fu_plugin_runner_udev_device_changed (FuPlugin *self, FuUdevDevice *device, GErr
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginUdevDeviceAddedFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -1941,7 +2457,10 @@ fu_plugin_runner_udev_device_changed (FuPlugin *self, FuUdevDevice *device, GErr
 		return TRUE;
 	}
 	g_debug ("performing udev_device_changed() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	start = fu_plugin_runner_begin (self, "fu_plugin_udev_device_changed");
+	ret = func (self, device, &error_local);
+	fu_plugin_runner_record (self, "fu_plugin_udev_device_changed", start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for udev_device_changed()",
 				    priv->name);
@@ -1972,6 +2491,7 @@ fu_plugin_runner_device_added (FuPlugin *self, FuDevice *device)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceRegisterFunc func = NULL;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -1984,7 +2504,9 @@ fu_plugin_runner_device_added (FuPlugin *self, FuDevice *device)
 	if (func == NULL)
 		return;
 	g_debug ("performing fu_plugin_device_added() on %s", priv->name);
+	start = fu_plugin_runner_begin (self, "fu_plugin_device_added");
 	func (self, device);
+	fu_plugin_runner_record (self, "fu_plugin_device_added", start);
 }
 
 /**
@@ -2022,6 +2544,7 @@ fu_plugin_runner_device_register (FuPlugin *self, FuDevice *device)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceRegisterFunc func = NULL;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -2037,7 +2560,9 @@ fu_plugin_runner_device_register (FuPlugin *self, FuDevice *device)
 	g_module_symbol (priv->module, "fu_plugin_device_registered", (gpointer *) &func);
 	if (func != NULL) {
 		g_debug ("performing fu_plugin_device_registered() on %s", priv->name);
+		start = fu_plugin_runner_begin (self, "fu_plugin_device_registered");
 		func (self, device);
+		fu_plugin_runner_record (self, "fu_plugin_device_registered", start);
 	}
 }
 
@@ -2096,6 +2621,8 @@ fu_plugin_runner_verify (FuPlugin *self,
 	FuPluginVerifyFunc func = NULL;
 	GPtrArray *checksums;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -2104,6 +2631,9 @@ fu_plugin_runner_verify (FuPlugin *self,
 	/* no object loaded */
 	if (priv->module == NULL)
 		return TRUE;
+	/* restored from the cache */
+	if (!fu_device_ensure_setup (device, error))
+		return FALSE;
 
 	/* optional */
 	g_module_symbol (priv->module, "fu_plugin_verify", (gpointer *) &func);
@@ -2124,7 +2654,10 @@ fu_plugin_runner_verify (FuPlugin *self,
 
 	/* run vfunc */
 	g_debug ("performing verify() on %s", priv->name);
-	if (!func (self, device, flags, &error_local)) {
+	start = fu_plugin_runner_begin (self, "fu_plugin_verify");
+	ret = func (self, device, flags, &error_local);
+	fu_plugin_runner_record (self, "fu_plugin_verify", start);
+	if (!ret) {
 		g_autoptr(GError) error_attach = NULL;
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for verify()",
@@ -2187,6 +2720,10 @@ fu_plugin_runner_activate (FuPlugin *self, FuDevice *device, GError **error)
 		return FALSE;
 	}
 
+	/* restored from the cache */
+	if (!fu_device_ensure_setup (device, error))
+		return FALSE;
+
 	/* run vfunc */
 	if (!fu_plugin_runner_device_generic (self, device,
 					      "fu_plugin_activate",
@@ -2228,6 +2765,10 @@ fu_plugin_runner_unlock (FuPlugin *self, FuDevice *device, GError **error)
 		return FALSE;
 	}
 
+	/* restored from the cache */
+	if (!fu_device_ensure_setup (device, error))
+		return FALSE;
+
 	/* run vfunc */
 	if (!fu_plugin_runner_device_generic (self, device,
 					      "fu_plugin_unlock",
@@ -2266,6 +2807,8 @@ fu_plugin_runner_update (FuPlugin *self,
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginUpdateFunc update_func;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled) {
@@ -2279,6 +2822,10 @@ fu_plugin_runner_update (FuPlugin *self,
 		return TRUE;
 	}
 
+	/* restored from the cache */
+	if (!fu_device_ensure_setup (device, error))
+		return FALSE;
+
 	/* optional */
 	g_module_symbol (priv->module, "fu_plugin_update", (gpointer *) &update_func);
 	if (update_func == NULL) {
@@ -2287,7 +2834,10 @@ fu_plugin_runner_update (FuPlugin *self,
 	}
 
 	/* online */
-	if (!update_func (self, device, blob_fw, flags, &error_local)) {
+	start = fu_plugin_runner_begin (self, "fu_plugin_update");
+	ret = update_func (self, device, blob_fw, flags, &error_local);
+	fu_plugin_runner_record (self, "fu_plugin_update", start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for update()",
 				    priv->name);
@@ -2331,6 +2881,8 @@ fu_plugin_runner_clear_results (FuPlugin *self, FuDevice *device, GError **error
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -2345,7 +2897,10 @@ fu_plugin_runner_clear_results (FuPlugin *self, FuDevice *device, GError **error
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing clear_result() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	start = fu_plugin_runner_begin (self, "fu_plugin_clear_results");
+	ret = func (self, device, &error_local);
+	fu_plugin_runner_record (self, "fu_plugin_clear_results", start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for clear_result()",
 				    priv->name);
@@ -2380,6 +2935,8 @@ fu_plugin_runner_get_results (FuPlugin *self, FuDevice *device, GError **error)
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceFunc func = NULL;
 	g_autoptr(GError) error_local = NULL;
+	gboolean ret;
+	gint64 start;
 
 	/* not enabled */
 	if (!priv->enabled)
@@ -2394,7 +2951,10 @@ fu_plugin_runner_get_results (FuPlugin *self, FuDevice *device, GError **error)
 	if (func == NULL)
 		return TRUE;
 	g_debug ("performing get_results() on %s", priv->name);
-	if (!func (self, device, &error_local)) {
+	start = fu_plugin_runner_begin (self, "fu_plugin_get_results");
+	ret = func (self, device, &error_local);
+	fu_plugin_runner_record (self, "fu_plugin_get_results", start);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset error in plugin %s for get_results()",
 				    priv->name);
@@ -2502,6 +3062,42 @@ fu_plugin_add_rule (FuPlugin *self, FuPluginRule rule, const gchar *name)
 	g_signal_emit (self, signals[SIGNAL_RULES_CHANGED], 0);
 }
 
+/**
+ * fu_plugin_add_flag:
+ * @self: a #FuPlugin
+ * @flag: a #FuPluginFlags, e.g. %FU_PLUGIN_FLAG_THREADED_COLDPLUG
+ *
+ * Sets a flag that describes how the plugin can be run by the daemon.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_plugin_add_flag (FuPlugin *self, FuPluginFlags flag)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_PLUGIN (self));
+	priv->flags |= flag;
+}
+
+/**
+ * fu_plugin_has_flag:
+ * @self: a #FuPlugin
+ * @flag: a #FuPluginFlags, e.g. %FU_PLUGIN_FLAG_THREADED_COLDPLUG
+ *
+ * Finds if the plugin has a specific flag set.
+ *
+ * Returns: %TRUE if the flag is set
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_plugin_has_flag (FuPlugin *self, FuPluginFlags flag)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
+	return (priv->flags & flag) > 0;
+}
+
 /**
  * fu_plugin_get_rules:
  * @self: a #FuPlugin
@@ -2711,6 +3307,12 @@ fu_plugin_class_init (FuPluginClass *klass)
 			      G_STRUCT_OFFSET (FuPluginClass, security_changed),
 			      NULL, NULL, g_cclosure_marshal_VOID__VOID,
 			      G_TYPE_NONE, 0);
+	signals[SIGNAL_RESCAN] =
+		g_signal_new ("rescan",
+			      G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+			      G_STRUCT_OFFSET (FuPluginClass, rescan),
+			      NULL, NULL, g_cclosure_marshal_VOID__STRING,
+			      G_TYPE_NONE, 1, G_TYPE_STRING);
 	signals[SIGNAL_SET_COLDPLUG_DELAY] =
 		g_signal_new ("set-coldplug-delay",
 			      G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
@@ -2743,9 +3345,13 @@ fu_plugin_init (FuPlugin *self)
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	priv->enabled = TRUE;
 	priv->udev_subsystems = g_ptr_array_new_with_free_func (g_free);
+	priv->udev_subsystems_plugin = g_ptr_array_new_with_free_func (g_free);
+	priv->watched_files = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	priv->devices = g_hash_table_new_full (g_str_hash, g_str_equal,
 					       g_free, (GDestroyNotify) g_object_unref);
 	g_rw_lock_init (&priv->devices_mutex);
+	g_mutex_init (&priv->runner_durations_mutex);
+	priv->runner_durations = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	priv->report_metadata = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	for (guint i = 0; i < FU_PLUGIN_RULE_LAST; i++)
 		priv->rules[i] = g_ptr_array_new_with_free_func (g_free);
@@ -2778,15 +3384,28 @@ fu_plugin_finalize (GObject *object)
 		g_object_unref (priv->quirks);
 	if (priv->udev_subsystems != NULL)
 		g_ptr_array_unref (priv->udev_subsystems);
+	g_ptr_array_unref (priv->udev_subsystems_plugin);
+	g_hash_table_unref (priv->watched_files);
 	if (priv->smbios != NULL)
 		g_object_unref (priv->smbios);
 	if (priv->runtime_versions != NULL)
 		g_hash_table_unref (priv->runtime_versions);
 	if (priv->compile_versions != NULL)
 		g_hash_table_unref (priv->compile_versions);
+	if (priv->deferred_signals != NULL)
+		g_ptr_array_unref (priv->deferred_signals);
+	if (priv->device_jobs_batch != NULL) {
+		fu_worker_batch_wait (priv->device_jobs_batch);
+		g_object_unref (priv->device_jobs_batch);
+		g_ptr_array_unref (priv->device_jobs);
+	}
+	if (priv->worker_pool != NULL)
+		g_object_unref (priv->worker_pool);
 	g_hash_table_unref (priv->devices);
 	g_hash_table_unref (priv->report_metadata);
+	g_hash_table_unref (priv->runner_durations);
 	g_rw_lock_clear (&priv->devices_mutex);
+	g_mutex_clear (&priv->runner_durations_mutex);
 	g_free (priv->build_hash);
 	g_free (priv->name);
 	g_free (priv->data);
@@ -17,6 +17,7 @@
 #include "fu-quirks.h"
 #include "fu-hwids.h"
 #include "fu-usb-device.h"
+#include "fu-worker-pool.h"
 //#include "fu-hid-device.h"
 #ifdef HAVE_GUDEV
 #include "fu-udev-device.h"
@@ -50,6 +51,8 @@ struct _FuPluginClass
 							 const gchar	*id,
 							 GType		 gtype);
 	void		 (* security_changed)		(FuPlugin	*self);
+	void		 (* rescan)			(FuPlugin	*self,
+							 const gchar	*physical_id);
 	/*< private >*/
 	gpointer	padding[20];
 };
@@ -89,6 +92,21 @@ typedef enum {
 	FU_PLUGIN_RULE_LAST
 } FuPluginRule;
 
+/**
+ * FuPluginFlags:
+ * @FU_PLUGIN_FLAG_NONE:		No flags set
+ * @FU_PLUGIN_FLAG_THREADED_COLDPLUG:	The coldplug vfunc is safe to run in a worker thread
+ *
+ * The flags that describe how the plugin can be run.
+ * Plugins are expected to add flags in fu_plugin_init().
+ **/
+typedef enum {
+	FU_PLUGIN_FLAG_NONE			= 0,
+	FU_PLUGIN_FLAG_THREADED_COLDPLUG	= 1 << 0,	/* Since: 1.5.0 */
+	/*< private >*/
+	FU_PLUGIN_FLAG_LAST
+} FuPluginFlags;
+
 typedef struct	FuPluginData	FuPluginData;
 
 /* for plugins to use */
@@ -108,7 +126,14 @@ void		 fu_plugin_device_remove		(FuPlugin	*self,
 							 FuDevice	*device);
 void		 fu_plugin_device_register		(FuPlugin	*self,
 							 FuDevice	*device);
+void		 fu_plugin_add_device_job		(FuPlugin	*self,
+							 FuDevice	*device);
+gboolean	 fu_plugin_flush_device_jobs		(FuPlugin	*self,
+							 GError		**error);
+FuWorkerPool	*fu_plugin_get_worker_pool		(FuPlugin	*self);
 void		 fu_plugin_request_recoldplug		(FuPlugin	*self);
+void		 fu_plugin_request_rescan		(FuPlugin	*self,
+							 const gchar	*physical_id);
 void		 fu_plugin_security_changed		(FuPlugin	*self);
 void		 fu_plugin_set_coldplug_delay		(FuPlugin	*self,
 							 guint		 duration);
@@ -137,11 +162,19 @@ const gchar	*fu_plugin_get_smbios_string		(FuPlugin	*self,
 							 guint8		 offset);
 GBytes		*fu_plugin_get_smbios_data		(FuPlugin	*self,
 							 guint8		 structure_type);
+GPtrArray	*fu_plugin_get_smbios_data_all		(FuPlugin	*self,
+							 guint8		 structure_type);
 void		 fu_plugin_add_rule			(FuPlugin	*self,
 							 FuPluginRule	 rule,
 							 const gchar	*name);
+void		 fu_plugin_add_flag			(FuPlugin	*self,
+							 FuPluginFlags	 flag);
+gboolean	 fu_plugin_has_flag			(FuPlugin	*self,
+							 FuPluginFlags	 flag);
 void		 fu_plugin_add_udev_subsystem		(FuPlugin	*self,
 							 const gchar	*subsystem);
+void		 fu_plugin_add_watched_file		(FuPlugin	*self,
+							 const gchar	*filename);
 FuQuirks	*fu_plugin_get_quirks			(FuPlugin	*self);
 const gchar	*fu_plugin_lookup_quirk_by_id		(FuPlugin	*self,
 							 const gchar	*group,
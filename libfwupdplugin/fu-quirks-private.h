@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "fu-quirks.h"
+
+gboolean	 fu_quirks_compile			(const gchar	*path,
+							 GFile		*file,
+							 GError		**error);
+guint		 fu_quirks_get_lookup_count		(FuQuirks	*self,
+							 guint		*cached);
+gsize		 fu_quirks_get_silo_size		(FuQuirks	*self,
+							 guint		*cache_entries);
+void		 fu_quirks_trim				(FuQuirks	*self);
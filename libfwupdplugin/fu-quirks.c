@@ -10,12 +10,13 @@
 
 #include <glib-object.h>
 #include <gio/gio.h>
+#include <glib/gstdio.h>
 #include <string.h>
 #include <xmlb.h>
 
 #include "fu-common.h"
 #include "fu-mutex.h"
-#include "fu-quirks.h"
+#include "fu-quirks-private.h"
 
 #include "fwupd-common.h"
 #include "fwupd-error.h"
@@ -53,6 +54,13 @@ struct _FuQuirks
 	GObject			 parent_instance;
 	FuQuirksLoadFlags	 load_flags;
 	XbSilo			*silo;
+	XbQuery			*query;		/* for all values of a group */
+	XbSilo			*silo_prebuilt;	/* from the package, or NULL */
+	XbQuery			*query_prebuilt;
+	GHashTable		*cache;		/* group-key : GPtrArray of XbNode */
+	GMutex			 silo_mutex;
+	guint			 lookup_cnt;
+	guint			 lookup_cached_cnt;
 };
 
 G_DEFINE_TYPE (FuQuirks, fu_quirks, G_TYPE_OBJECT)
@@ -199,6 +207,56 @@ fu_quirks_add_quirks_for_path (FuQuirks *self, XbBuilder *builder,
 	return TRUE;
 }
 
+/* the prebuilt silo is only used if it is newer than every quirk file it
+ * was built from, so that a partially upgraded package parses the files */
+static gboolean
+fu_quirks_prebuilt_is_valid (const gchar *path, const gchar *xmlbfn)
+{
+	const gchar *tmp;
+	GStatBuf st_xmlb = { 0 };
+	g_autofree gchar *path_hw = g_build_filename (path, "quirks.d", NULL);
+	g_autoptr(GDir) dir = NULL;
+
+	if (g_stat (xmlbfn, &st_xmlb) != 0)
+		return FALSE;
+	dir = g_dir_open (path_hw, 0, NULL);
+	if (dir == NULL)
+		return TRUE;
+	while ((tmp = g_dir_read_name (dir)) != NULL) {
+		GStatBuf st = { 0 };
+		g_autofree gchar *fn = g_build_filename (path_hw, tmp, NULL);
+		if (!g_str_has_suffix (tmp, ".quirk"))
+			continue;
+		if (g_stat (fn, &st) != 0)
+			continue;
+		if (st.st_mtime > st_xmlb.st_mtime) {
+			g_debug ("%s is newer than %s, ignoring", fn, xmlbfn);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static void
+fu_quirks_load_prebuilt (FuQuirks *self, const gchar *datadir)
+{
+	g_autofree gchar *xmlbfn = g_build_filename (datadir, "quirks.xmlb", NULL);
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(XbSilo) silo = xb_silo_new ();
+
+	if (!fu_quirks_prebuilt_is_valid (datadir, xmlbfn))
+		return;
+	file = g_file_new_for_path (xmlbfn);
+	if (!xb_silo_load_from_file (silo, file,
+				     XB_SILO_LOAD_FLAG_WATCH_BLOB,
+				     NULL, &error_local)) {
+		g_debug ("failed to load prebuilt %s: %s", xmlbfn, error_local->message);
+		return;
+	}
+	self->silo_prebuilt = g_steal_pointer (&silo);
+}
+
 static gboolean
 fu_quirks_check_silo (FuQuirks *self, GError **error)
 {
@@ -211,14 +269,20 @@ fu_quirks_check_silo (FuQuirks *self, GError **error)
 	g_autoptr(XbBuilder) builder = NULL;
 
 	/* everything is okay */
-	if (self->silo != NULL && xb_silo_is_valid (self->silo))
+	if (self->silo != NULL && xb_silo_is_valid (self->silo) &&
+	    (self->silo_prebuilt == NULL || xb_silo_is_valid (self->silo_prebuilt)))
 		return TRUE;
 
-	/* system datadir */
+	/* system datadir, using the silo compiled when installed if possible */
+	g_clear_object (&self->query_prebuilt);
+	g_clear_object (&self->silo_prebuilt);
 	builder = xb_builder_new ();
 	datadir = fu_common_get_path (FU_PATH_KIND_DATADIR_PKG);
-	if (!fu_quirks_add_quirks_for_path (self, builder, datadir, error))
-		return FALSE;
+	fu_quirks_load_prebuilt (self, datadir);
+	if (self->silo_prebuilt == NULL) {
+		if (!fu_quirks_add_quirks_for_path (self, builder, datadir, error))
+			return FALSE;
+	}
 
 	/* something we can write when using Ostree */
 	localstatedir = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
@@ -236,10 +300,106 @@ fu_quirks_check_silo (FuQuirks *self, GError **error)
 	}
 	if (self->load_flags & FU_QUIRKS_LOAD_FLAG_READONLY_FS)
 		compile_flags |= XB_BUILDER_COMPILE_FLAG_IGNORE_GUID;
+
+	/* anything cached refers to the old silo */
+	g_clear_object (&self->query);
+	g_hash_table_remove_all (self->cache);
+	g_clear_object (&self->silo);
 	self->silo = xb_builder_ensure (builder, file, compile_flags, NULL, error);
 	return self->silo != NULL;
 }
 
+/* returns (transfer container) all the value nodes for the group, which may
+ * be an empty array if the group does not exist */
+/* appends all the value nodes for the group in @silo to @results */
+static gboolean
+fu_quirks_lookup_group_silo (XbSilo *silo, XbQuery **query,
+			     const gchar *group_key, GPtrArray *results,
+			     GError **error)
+{
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) nodes = NULL;
+
+	/* prepare the query once for each silo */
+	if (*query == NULL) {
+		*query = xb_query_new_full (silo,
+					    "quirk/device[@id=?]/value",
+					    XB_QUERY_FLAG_NONE,
+					    &error_local);
+		if (*query == NULL) {
+			if (!g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) &&
+			    !g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
+				g_propagate_prefixed_error (error,
+							    g_steal_pointer (&error_local),
+							    "failed to build query: ");
+				return FALSE;
+			}
+			return TRUE;
+		}
+	}
+
+	/* query */
+	if (!xb_query_bind_str (*query, 0, group_key, error)) {
+		g_prefix_error (error, "failed to bind 0: ");
+		return FALSE;
+	}
+	nodes = xb_silo_query_full (silo, *query, &error_local);
+	if (nodes == NULL) {
+		if (!g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) &&
+		    !g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
+			g_propagate_prefixed_error (error,
+						    g_steal_pointer (&error_local),
+						    "failed to query: ");
+			return FALSE;
+		}
+		return TRUE;
+	}
+	for (guint i = 0; i < nodes->len; i++)
+		g_ptr_array_add (results, g_object_ref (g_ptr_array_index (nodes, i)));
+	return TRUE;
+}
+
+static GPtrArray *
+fu_quirks_lookup_group (FuQuirks *self, const gchar *group, GError **error)
+{
+	GPtrArray *results;
+	g_autofree gchar *group_key = NULL;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->silo_mutex);
+
+	/* ensure up to date */
+	if (!fu_quirks_check_silo (self, error)) {
+		g_prefix_error (error, "failed to build silo: ");
+		return NULL;
+	}
+
+	/* most devices have no quirks set, so cache misses too */
+	self->lookup_cnt++;
+	group_key = fu_quirks_build_group_key (group);
+	results = g_hash_table_lookup (self->cache, group_key);
+	if (results != NULL) {
+		self->lookup_cached_cnt++;
+		return g_ptr_array_ref (results);
+	}
+
+	/* local overrides are returned before the values from the package */
+	results = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	if (!fu_quirks_lookup_group_silo (self->silo, &self->query,
+					  group_key, results, error)) {
+		g_ptr_array_unref (results);
+		return NULL;
+	}
+	if (self->silo_prebuilt != NULL &&
+	    !fu_quirks_lookup_group_silo (self->silo_prebuilt, &self->query_prebuilt,
+					  group_key, results, error)) {
+		g_ptr_array_unref (results);
+		return NULL;
+	}
+	g_hash_table_insert (self->cache,
+			     g_steal_pointer (&group_key),
+			     g_ptr_array_ref (results));
+	return results;
+}
+
 /**
  * fu_quirks_lookup_by_id:
  * @self: A #FuPlugin
@@ -255,53 +415,24 @@ fu_quirks_check_silo (FuQuirks *self, GError **error)
 const gchar *
 fu_quirks_lookup_by_id (FuQuirks *self, const gchar *group, const gchar *key)
 {
-	g_autofree gchar *group_key = NULL;
 	g_autoptr(GError) error = NULL;
-	g_autoptr(XbNode) n = NULL;
-	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(GPtrArray) results = NULL;
 
 	g_return_val_if_fail (FU_IS_QUIRKS (self), NULL);
 	g_return_val_if_fail (group != NULL, NULL);
 	g_return_val_if_fail (key != NULL, NULL);
 
-	/* ensure up to date */
-	if (!fu_quirks_check_silo (self, &error)) {
-		g_warning ("failed to build silo: %s", error->message);
-		return NULL;
-	}
-
-	/* query */
-	group_key = fu_quirks_build_group_key (group);
-	query = xb_query_new_full (self->silo,
-				   "quirk/device[@id=?]/value[@key=?]",
-				   XB_QUERY_FLAG_NONE,
-				   &error);
-	if (query == NULL) {
-		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
-			return NULL;
-		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
-			return NULL;
-		g_warning ("failed to build query: %s", error->message);
-		return NULL;
-	}
-	if (!xb_query_bind_str (query, 0, group_key, &error)) {
-		g_warning ("failed to bind 0: %s", error->message);
-		return NULL;
-	}
-	if (!xb_query_bind_str (query, 1, key, &error)) {
-		g_warning ("failed to bind 1: %s", error->message);
+	results = fu_quirks_lookup_group (self, group, &error);
+	if (results == NULL) {
+		g_warning ("%s", error->message);
 		return NULL;
 	}
-	n = xb_silo_query_first_full (self->silo, query, &error);
-	if (n == NULL) {
-		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
-			return NULL;
-		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
-			return NULL;
-		g_warning ("failed to query: %s", error->message);
-		return NULL;
+	for (guint i = 0; i < results->len; i++) {
+		XbNode *n = g_ptr_array_index (results, i);
+		if (g_strcmp0 (xb_node_get_attr (n, "key"), key) == 0)
+			return xb_node_get_text (n);
 	}
-	return xb_node_get_text (n);
+	return NULL;
 }
 
 /**
@@ -321,48 +452,21 @@ gboolean
 fu_quirks_lookup_by_id_iter (FuQuirks *self, const gchar *group,
 			     FuQuirksIter iter_cb, gpointer user_data)
 {
-	g_autofree gchar *group_key = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GPtrArray) results = NULL;
-	g_autoptr(XbQuery) query = NULL;
 
 	g_return_val_if_fail (FU_IS_QUIRKS (self), FALSE);
 	g_return_val_if_fail (group != NULL, FALSE);
 	g_return_val_if_fail (iter_cb != NULL, FALSE);
 
-	/* ensure up to date */
-	if (!fu_quirks_check_silo (self, &error)) {
-		g_warning ("failed to build silo: %s", error->message);
-		return FALSE;
-	}
-
-	/* query */
-	group_key = fu_quirks_build_group_key (group);
-	query = xb_query_new_full (self->silo,
-				   "quirk/device[@id=?]/value",
-				   XB_QUERY_FLAG_NONE,
-				   &error);
-	if (query == NULL) {
-		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
-			return FALSE;
-		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
-			return FALSE;
-		g_warning ("failed to build query: %s", error->message);
-		return FALSE;
-	}
-	if (!xb_query_bind_str (query, 0, group_key, &error)) {
-		g_warning ("failed to bind 0: %s", error->message);
-		return FALSE;
-	}
-	results = xb_silo_query_full (self->silo, query, &error);
+	/* the callback is allowed to do more lookups */
+	results = fu_quirks_lookup_group (self, group, &error);
 	if (results == NULL) {
-		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
-			return FALSE;
-		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
-			return FALSE;
-		g_warning ("failed to query: %s", error->message);
+		g_warning ("%s", error->message);
 		return FALSE;
 	}
+	if (results->len == 0)
+		return FALSE;
 	for (guint i = 0; i < results->len; i++) {
 		XbNode *n = g_ptr_array_index (results, i);
 		iter_cb (self,
@@ -388,11 +492,115 @@ fu_quirks_lookup_by_id_iter (FuQuirks *self, const gchar *group,
 gboolean
 fu_quirks_load (FuQuirks *self, FuQuirksLoadFlags load_flags, GError **error)
 {
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->silo_mutex);
 	g_return_val_if_fail (FU_IS_QUIRKS (self), FALSE);
 	self->load_flags = load_flags;
 	return fu_quirks_check_silo (self, error);
 }
 
+/**
+ * fu_quirks_compile: (skip)
+ * @path: A directory containing `quirks.d`, e.g. `/usr/share/fwupd`
+ * @file: A #GFile to save the compiled silo to, e.g. `/usr/share/fwupd/quirks.xmlb`
+ * @error: A #GError, or %NULL
+ *
+ * Compiles all the quirk files in a directory, which is done when fwupd is
+ * installed so that the daemon does not have to parse them on first start.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_quirks_compile (const gchar *path, GFile *file, GError **error)
+{
+	g_autoptr(FuQuirks) self = fu_quirks_new ();
+	g_autoptr(XbBuilder) builder = xb_builder_new ();
+	g_autoptr(XbSilo) silo = NULL;
+
+	g_return_val_if_fail (path != NULL, FALSE);
+	g_return_val_if_fail (G_IS_FILE (file), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (!fu_quirks_add_quirks_for_path (self, builder, path, error))
+		return FALSE;
+	silo = xb_builder_compile (builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, error);
+	if (silo == NULL)
+		return FALSE;
+	return xb_silo_save_to_file (silo, file, NULL, error);
+}
+
+/**
+ * fu_quirks_get_lookup_count: (skip)
+ * @self: A #FuQuirks
+ * @cached: (out) (optional): the number of lookups returned from the cache
+ *
+ * Gets the number of group lookups done since the quirks were created.
+ *
+ * Returns: the number of lookups
+ *
+ * Since: 1.5.0
+ **/
+guint
+fu_quirks_get_lookup_count (FuQuirks *self, guint *cached)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->silo_mutex);
+	g_return_val_if_fail (FU_IS_QUIRKS (self), 0);
+	if (cached != NULL)
+		*cached = self->lookup_cached_cnt;
+	return self->lookup_cnt;
+}
+
+/**
+ * fu_quirks_get_silo_size: (skip)
+ * @self: A #FuQuirks
+ * @cache_entries: (out) (optional): the number of cached group lookups
+ *
+ * Gets the size of the loaded quirk silos.
+ *
+ * Returns: the size in bytes
+ *
+ * Since: 1.5.0
+ **/
+gsize
+fu_quirks_get_silo_size (FuQuirks *self, guint *cache_entries)
+{
+	gsize sz = 0;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->silo_mutex);
+
+	g_return_val_if_fail (FU_IS_QUIRKS (self), 0);
+
+	if (self->silo != NULL) {
+		g_autoptr(GBytes) blob = xb_silo_get_bytes (self->silo);
+		if (blob != NULL)
+			sz += g_bytes_get_size (blob);
+	}
+	if (self->silo_prebuilt != NULL) {
+		g_autoptr(GBytes) blob = xb_silo_get_bytes (self->silo_prebuilt);
+		if (blob != NULL)
+			sz += g_bytes_get_size (blob);
+	}
+	if (cache_entries != NULL)
+		*cache_entries = g_hash_table_size (self->cache);
+	return sz;
+}
+
+/**
+ * fu_quirks_trim: (skip)
+ * @self: A #FuQuirks
+ *
+ * Drops the cached group lookups, which are rebuilt as required.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_quirks_trim (FuQuirks *self)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->silo_mutex);
+	g_return_if_fail (FU_IS_QUIRKS (self));
+	g_hash_table_remove_all (self->cache);
+}
+
 static void
 fu_quirks_class_init (FuQuirksClass *klass)
 {
@@ -403,14 +611,25 @@ fu_quirks_class_init (FuQuirksClass *klass)
 static void
 fu_quirks_init (FuQuirks *self)
 {
+	self->cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+					     g_free, (GDestroyNotify) g_ptr_array_unref);
+	g_mutex_init (&self->silo_mutex);
 }
 
 static void
 fu_quirks_finalize (GObject *obj)
 {
 	FuQuirks *self = FU_QUIRKS (obj);
+	if (self->query != NULL)
+		g_object_unref (self->query);
 	if (self->silo != NULL)
 		g_object_unref (self->silo);
+	if (self->query_prebuilt != NULL)
+		g_object_unref (self->query_prebuilt);
+	if (self->silo_prebuilt != NULL)
+		g_object_unref (self->silo_prebuilt);
+	g_hash_table_unref (self->cache);
+	g_mutex_clear (&self->silo_mutex);
 	G_OBJECT_CLASS (fu_quirks_parent_class)->finalize (obj);
 }
 
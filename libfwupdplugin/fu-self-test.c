@@ -11,9 +11,17 @@
 #include <fwupdplugin.h>
 #include <libgcab.h>
 #include <glib/gstdio.h>
+#include <string.h>
+#ifdef HAVE_GIO_UNIX
+#include <fcntl.h>
+#include <glib-unix.h>
+#endif
 
+#include "fu-cabinet.h"
 #include "fu-device-private.h"
+#include "fu-hwids-private.h"
 #include "fu-plugin-private.h"
+#include "fu-quirks-private.h"
 #include "fu-security-attrs-private.h"
 #include "fu-smbios-private.h"
 
@@ -80,6 +88,7 @@ fu_archive_cab_func (void)
 	g_autoptr(GBytes) data = NULL;
 	g_autoptr(GError) error = NULL;
 	GBytes *data_tmp;
+	const gchar *filenames[] = { "firmware.bin", NULL };
 
 	filename = g_build_filename (TESTDATADIR_DST, "colorhug", "colorhug-als-3.0.2.cab", NULL);
 	data = fu_common_get_contents_bytes (filename, &error);
@@ -105,6 +114,20 @@ fu_archive_cab_func (void)
 	data_tmp = fu_archive_lookup_by_fn (archive, "NOTGOINGTOEXIST.xml", &error);
 	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
 	g_assert_null (data_tmp);
+	g_clear_error (&error);
+	g_clear_object (&archive);
+
+	/* only the named files */
+	archive = fu_archive_new_for_filenames (data, FU_ARCHIVE_FLAG_NONE,
+						(gchar **) filenames, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (archive);
+	data_tmp = fu_archive_lookup_by_fn (archive, "firmware.bin", &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (data_tmp);
+	data_tmp = fu_archive_lookup_by_fn (archive, "firmware.metainfo.xml", &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null (data_tmp);
 }
 
 static void
@@ -214,6 +237,7 @@ fu_smbios_func (void)
 	g_autofree gchar *dump = NULL;
 	g_autoptr(FuSmbios) smbios = NULL;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) blobs = NULL;
 
 	smbios = fu_smbios_new ();
 	ret = fu_smbios_setup (smbios, &error);
@@ -239,6 +263,12 @@ fu_smbios_func (void)
 	str = fu_smbios_get_string (smbios, FU_SMBIOS_STRUCTURE_TYPE_BIOS, 0x04, &error);
 	g_assert_no_error (error);
 	g_assert_cmpstr (str, ==, "LENOVO");
+
+	/* get all instances */
+	blobs = fu_smbios_get_data_all (smbios, FU_SMBIOS_STRUCTURE_TYPE_BIOS, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blobs);
+	g_assert_cmpint (blobs->len, ==, 1);
 }
 
 static void
@@ -270,8 +300,10 @@ static void
 fu_hwids_func (void)
 {
 	g_autoptr(FuHwids) hwids = NULL;
+	g_autoptr(FuHwids) hwids_cached = fu_hwids_new ();
 	g_autoptr(FuSmbios) smbios = NULL;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) value = NULL;
 	gboolean ret;
 
 	struct {
@@ -330,6 +362,23 @@ fu_hwids_func (void)
 	}
 	for (guint i = 0; guids[i].key != NULL; i++)
 		g_assert (fu_hwids_has_guid (hwids, guids[i].value));
+
+	/* restore without the SMBIOS data */
+	g_assert_nonnull (fu_smbios_get_checksum (smbios));
+	value = g_variant_ref_sink (fu_hwids_to_variant (hwids));
+	ret = fu_hwids_setup_from_variant (hwids_cached, value, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpstr (fu_hwids_get_value (hwids_cached, FU_HWIDS_KEY_BIOS_VERSION), ==,
+			 "GJET75WW (2.25 )");
+	g_assert_cmpint (fu_hwids_get_guids (hwids_cached)->len, ==,
+			 fu_hwids_get_guids (hwids)->len);
+	for (guint i = 0; guids[i].key != NULL; i++) {
+		g_autofree gchar *guid = fu_hwids_get_guid (hwids_cached, guids[i].key, &error);
+		g_assert_no_error (error);
+		g_assert_cmpstr (guid, ==, guids[i].value);
+		g_assert (fu_hwids_has_guid (hwids_cached, guids[i].value));
+	}
 }
 
 static void
@@ -368,6 +417,64 @@ fu_plugin_delay_func (void)
 	g_assert (device_tmp != NULL);
 	g_assert_cmpstr (fu_device_get_id (device_tmp), ==, "b7eccd0059d6d7dc2ef76c35d6de0048cc8c029d");
 	g_clear_object (&device_tmp);
+
+	/* add device when deferred, as used for threaded coldplug */
+	fu_plugin_defer_device_signals (plugin);
+	fu_plugin_device_add (plugin, device);
+	g_assert (device_tmp == NULL);
+	fu_plugin_flush_device_signals (plugin);
+	g_assert (device_tmp != NULL);
+	g_assert_cmpstr (fu_device_get_id (device_tmp), ==, "b7eccd0059d6d7dc2ef76c35d6de0048cc8c029d");
+	g_clear_object (&device_tmp);
+}
+
+static void
+_plugin_device_job_added_cb (FuPlugin *plugin, FuDevice *device, gpointer user_data)
+{
+	GPtrArray *devices = (GPtrArray *) user_data;
+	g_ptr_array_add (devices, g_object_ref (device));
+}
+
+static void
+fu_plugin_device_jobs_func (void)
+{
+	gboolean ret;
+	g_autoptr(FuPlugin) plugin = fu_plugin_new ();
+	g_autoptr(FuWorkerPool) pool = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+
+	pool = fu_worker_pool_new (4, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (pool);
+	fu_plugin_set_worker_pool (plugin, pool);
+	g_signal_connect (plugin, "device-added",
+			  G_CALLBACK (_plugin_device_job_added_cb),
+			  devices);
+
+	/* devices are added in the order they were submitted */
+	for (guint i = 0; i < 10; i++) {
+		g_autoptr(FuDevice) device = fu_device_new ();
+		g_autofree gchar *id = g_strdup_printf ("dev%u", i);
+		fu_device_set_id (device, id);
+		fu_device_set_name (device, id);
+		fu_plugin_add_device_job (plugin, device);
+	}
+	ret = fu_plugin_flush_device_jobs (plugin, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (devices->len, ==, 10);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		g_autofree gchar *id = g_strdup_printf ("dev%u", i);
+		g_assert_cmpstr (fu_device_get_name (device), ==, id);
+	}
+
+	/* nothing pending */
+	ret = fu_plugin_flush_device_jobs (plugin, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (devices->len, ==, 10);
 }
 
 static void
@@ -401,6 +508,35 @@ fu_plugin_quirks_func (void)
 	g_assert_cmpstr (tmp, ==, "clever");
 }
 
+static void
+fu_plugin_quirks_prebuilt_func (void)
+{
+	const gchar *tmp;
+	gboolean ret;
+	g_autoptr(FuQuirks) quirks = fu_quirks_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file = g_file_new_for_path ("/tmp/fwupd-self-test/prebuilt/quirks.xmlb");
+
+	/* compile the test quirks as if installing */
+	ret = fu_common_mkdir_parent ("/tmp/fwupd-self-test/prebuilt/quirks.xmlb", &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = fu_quirks_compile (TESTDATADIR_SRC, file, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* use the prebuilt silo rather than the quirk files */
+	g_setenv ("FWUPD_DATADIR", "/tmp/fwupd-self-test/prebuilt", TRUE);
+	ret = fu_quirks_load (quirks, FU_QUIRKS_LOAD_FLAG_NONE, &error);
+	g_setenv ("FWUPD_DATADIR", TESTDATADIR_SRC, TRUE);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	tmp = fu_quirks_lookup_by_id (quirks, "ACME Inc.=True", "Test");
+	g_assert_cmpstr (tmp, ==, "awesome");
+	tmp = fu_quirks_lookup_by_id (quirks, "baz", "Unfound");
+	g_assert_cmpstr (tmp, ==, NULL);
+}
+
 static void
 fu_plugin_quirks_performance_func (void)
 {
@@ -625,6 +761,95 @@ fu_common_spawn_timeout_func (void)
 	g_assert_cmpint (lines, ==, 1);
 }
 
+static void
+fu_io_channel_iov_func (void)
+{
+#ifdef HAVE_GIO_UNIX
+	gboolean ret;
+	gint fds[2] = { -1, -1 };
+	const GOutputVector vectors[] = {
+		{ "hdr:", 4 },
+		{ "payload", 7 },
+		{ "\n", 1 },
+	};
+	g_autoptr(FuIOChannel) io_rd = NULL;
+	g_autoptr(FuIOChannel) io_wr = NULL;
+	g_autoptr(GByteArray) buf1 = NULL;
+	g_autoptr(GByteArray) buf2 = NULL;
+	g_autoptr(GByteArray) buf3 = NULL;
+	g_autoptr(GError) error = NULL;
+
+	ret = g_unix_open_pipe (fds, FD_CLOEXEC, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	io_rd = fu_io_channel_unix_new (fds[0]);
+	io_wr = fu_io_channel_unix_new (fds[1]);
+	fu_io_channel_set_read_buffer_size (io_rd, 64);
+
+	/* several buffers in one write */
+	ret = fu_io_channel_write_iov (io_wr, vectors, G_N_ELEMENTS (vectors),
+				       500, FU_IO_CHANNEL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* the first read fetches everything, but only returns the header */
+	buf1 = fu_io_channel_read_byte_array (io_rd, 4, 500,
+					      FU_IO_CHANNEL_FLAG_SINGLE_SHOT, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (buf1);
+	g_assert_cmpint (buf1->len, ==, 4);
+	g_assert_cmpint (memcmp (buf1->data, "hdr:", 4), ==, 0);
+
+	/* satisfied from the ring buffer */
+	buf2 = fu_io_channel_read_byte_array (io_rd, 7, 0,
+					      FU_IO_CHANNEL_FLAG_SINGLE_SHOT, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (buf2);
+	g_assert_cmpint (buf2->len, ==, 7);
+	g_assert_cmpint (memcmp (buf2->data, "payload", 7), ==, 0);
+	buf3 = fu_io_channel_read_byte_array (io_rd, -1, 0,
+					      FU_IO_CHANNEL_FLAG_SINGLE_SHOT, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (buf3);
+	g_assert_cmpint (buf3->len, ==, 1);
+	g_assert_cmpint (buf3->data[0], ==, '\n');
+#else
+	g_test_skip ("no pipe support, skipping io-channel test");
+#endif
+}
+
+static void
+fu_common_get_contents_mapped_func (void)
+{
+	g_autofree gchar *filename = NULL;
+	g_autoptr(GBytes) blob1 = NULL;
+	g_autoptr(GBytes) blob2 = NULL;
+	g_autoptr(GBytes) blob3 = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* same contents as the copied version */
+	filename = g_build_filename (TESTDATADIR_SRC, "metadata.xml", NULL);
+	blob1 = fu_common_get_contents_bytes (filename, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob1);
+	blob2 = fu_common_get_contents_mapped (filename, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob2);
+	g_assert_true (g_bytes_equal (blob1, blob2));
+
+	/* files that cannot be mapped are read instead */
+	blob3 = fu_common_get_contents_mapped ("/proc/self/cmdline", &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob3);
+	g_assert_cmpint (g_bytes_get_size (blob3), >, 0);
+
+	/* missing file */
+	g_clear_pointer (&blob3, g_bytes_unref);
+	blob3 = fu_common_get_contents_mapped ("/this/does/not/exist", &error);
+	g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_NOENT);
+	g_assert_null (blob3);
+}
+
 static void
 fu_common_endian_func (void)
 {
@@ -641,6 +866,43 @@ fu_common_endian_func (void)
 	g_assert_cmpint (fu_common_read_uint16 (buf, G_BIG_ENDIAN), ==, 0x1234);
 }
 
+static void
+fu_common_data_is_empty_func (void)
+{
+	guint8 buf[64];
+
+	memset (buf, 0xff, sizeof(buf));
+	g_assert_true (fu_common_data_is_empty (buf, 0));
+	g_assert_true (fu_common_data_is_empty (buf, 1));
+	g_assert_true (fu_common_data_is_empty (buf, sizeof(buf)));
+	buf[0] = 0x00;
+	g_assert_false (fu_common_data_is_empty (buf, sizeof(buf)));
+	buf[0] = 0xff;
+	buf[sizeof(buf) - 1] = 0xfe;
+	g_assert_false (fu_common_data_is_empty (buf, sizeof(buf)));
+	g_assert_true (fu_common_data_is_empty (buf, sizeof(buf) - 1));
+	memset (buf, 0x00, sizeof(buf));
+	g_assert_true (fu_common_data_is_fill (buf, sizeof(buf), 0x00));
+	g_assert_false (fu_common_data_is_fill (buf, sizeof(buf), 0xff));
+}
+
+static void
+fu_common_data_get_mismatch_func (void)
+{
+	guint8 buf1[0x300];
+	guint8 buf2[0x300];
+
+	memset (buf1, 0xaa, sizeof(buf1));
+	memset (buf2, 0xaa, sizeof(buf2));
+	g_assert_cmpint (fu_common_data_get_mismatch (buf1, buf2, sizeof(buf1)), ==, sizeof(buf1));
+	buf2[0x2ff] = 0x00;
+	g_assert_cmpint (fu_common_data_get_mismatch (buf1, buf2, sizeof(buf1)), ==, 0x2ff);
+	buf2[0x123] = 0x00;
+	g_assert_cmpint (fu_common_data_get_mismatch (buf1, buf2, sizeof(buf1)), ==, 0x123);
+	buf2[0x0] = 0x00;
+	g_assert_cmpint (fu_common_data_get_mismatch (buf1, buf2, sizeof(buf1)), ==, 0x0);
+}
+
 static GBytes *
 _build_cab (GCabCompression compression, ...)
 {
@@ -794,6 +1056,46 @@ fu_common_store_cab_unsigned_func (void)
 	g_assert_nonnull (blob_tmp);
 }
 
+static void
+fu_common_store_cab_stream_func (void)
+{
+	GBytes *blob_tmp;
+	gboolean ret;
+	g_autoptr(FuCabinet) cabinet = fu_cabinet_new ();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbNode) rel = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+
+	/* the unreferenced file is never extracted */
+	blob = _build_cab (GCAB_COMPRESSION_NONE,
+			   "acme.metainfo.xml",
+	"<component type=\"firmware\">\n"
+	"  <id>com.acme.example.firmware</id>\n"
+	"  <releases>\n"
+	"    <release version=\"1.2.3\"/>\n"
+	"  </releases>\n"
+	"</component>",
+			   "firmware.bin", "world",
+			   "README.txt", "unused",
+			   NULL);
+	fu_cabinet_set_size_max (cabinet, 10240);
+	ret = fu_cabinet_parse (cabinet, blob, FU_CABINET_PARSE_FLAG_STREAM, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	silo = fu_cabinet_get_silo (cabinet);
+	g_assert_nonnull (silo);
+
+	/* verify the payload was mapped */
+	rel = xb_silo_query_first (silo, "components/component/releases/release", &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (rel);
+	blob_tmp = xb_node_get_data (rel, "fwupd::FirmwareBlob");
+	g_assert_nonnull (blob_tmp);
+	g_assert_cmpint (g_bytes_get_size (blob_tmp), ==, 5);
+	g_assert_cmpint (memcmp (g_bytes_get_data (blob_tmp, NULL), "world", 5), ==, 0);
+}
+
 static void
 fu_common_store_cab_folder_func (void)
 {
@@ -1065,6 +1367,185 @@ fu_device_incorporate_func (void)
 	g_assert_cmpint (fu_device_get_icons(device)->len, ==, 1);
 }
 
+static void
+fu_crc_func (void)
+{
+	const guint8 buf[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+	guint8 big[1000];
+	guint32 crc;
+
+	/* standard check values */
+	g_assert_cmpint (fu_crc8 (buf, sizeof(buf)), ==, 0xf4);
+	g_assert_cmpint (fu_crc8_full (buf, sizeof(buf), 0x00, 0xd5), ==, 0xbc);
+	g_assert_cmpint (fu_crc16 (buf, sizeof(buf)), ==, 0xfee8);
+	g_assert_cmpint ((guint16) ~fu_crc16_reflected_full (buf, sizeof(buf), 0xffff, 0xa001), ==, 0xb4c8);
+	g_assert_cmpint (fu_crc32 (buf, sizeof(buf)), ==, 0xcbf43926);
+	g_assert_cmpint (fu_crc32 (buf, 0), ==, 0x0);
+
+	/* slice-by-8 matches when split at unaligned offsets */
+	for (guint i = 0; i < sizeof(big); i++)
+		big[i] = (guint8) (i * 7);
+	crc = fu_crc32_full (big, 13, 0xffffffff);
+	crc = fu_crc32_full (big + 13, sizeof(big) - 13, crc);
+	g_assert_cmpint (crc, ==, fu_crc32_full (big, sizeof(big), 0xffffffff));
+}
+
+static GPtrArray *
+fu_checksum_input_stream_build (const guint8 *buf, gsize bufsz, gsize chunk_sz)
+{
+	GPtrArray *checksums = g_ptr_array_new_with_free_func (g_free);
+	for (gsize i = 0; i < bufsz; i += chunk_sz) {
+		g_ptr_array_add (checksums,
+				 g_compute_checksum_for_data (G_CHECKSUM_SHA256, buf + i,
+							      MIN (chunk_sz, bufsz - i)));
+	}
+	return checksums;
+}
+
+static GBytes *
+fu_checksum_input_stream_read_all (GInputStream *stream, GError **error)
+{
+	g_autoptr(GOutputStream) ostream = g_memory_output_stream_new_resizable ();
+	if (g_output_stream_splice (ostream, stream,
+				    G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+				    NULL, error) < 0)
+		return NULL;
+	return g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (ostream));
+}
+
+static void
+fu_checksum_input_stream_func (void)
+{
+	guint8 buf[1000];
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GBytes) blob_out = NULL;
+	g_autoptr(GBytes) blob_bad = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GError) error_bad = NULL;
+	g_autoptr(GError) error_short = NULL;
+	g_autoptr(GInputStream) base = NULL;
+	g_autoptr(GInputStream) base_bad = NULL;
+	g_autoptr(GInputStream) base_short = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GInputStream) stream_bad = NULL;
+	g_autoptr(GInputStream) stream_short = NULL;
+	g_autoptr(GPtrArray) checksums = NULL;
+
+	for (guint i = 0; i < sizeof(buf); i++)
+		buf[i] = (guint8) i;
+	blob = g_bytes_new_static (buf, sizeof(buf));
+	checksums = fu_checksum_input_stream_build (buf, sizeof(buf), 64);
+	g_assert_cmpint (checksums->len, ==, 16);
+
+	/* all chunks valid, including the short one at the end */
+	base = g_memory_input_stream_new_from_bytes (blob);
+	stream = fu_checksum_input_stream_new (base, G_CHECKSUM_SHA256, 64, checksums);
+	blob_out = fu_checksum_input_stream_read_all (stream, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob_out);
+	g_assert_true (g_bytes_equal (blob, blob_out));
+
+	/* one byte changed in the last chunk */
+	buf[sizeof(buf) - 1] ^= 0xff;
+	base_bad = g_memory_input_stream_new_from_data (g_memdup (buf, sizeof(buf)),
+							sizeof(buf), g_free);
+	buf[sizeof(buf) - 1] ^= 0xff;
+	stream_bad = fu_checksum_input_stream_new (base_bad, G_CHECKSUM_SHA256, 64, checksums);
+	blob_bad = fu_checksum_input_stream_read_all (stream_bad, &error_bad);
+	g_assert_error (error_bad, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
+	g_assert_null (blob_bad);
+
+	/* stream ends at a chunk boundary before the last checksum */
+	base_short = g_memory_input_stream_new_from_data (buf, 640, NULL);
+	stream_short = fu_checksum_input_stream_new (base_short, G_CHECKSUM_SHA256, 64, checksums);
+	g_assert_null (fu_checksum_input_stream_read_all (stream_short, &error_short));
+	g_assert_error (error_short, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
+}
+
+static void
+fu_chunk_view_func (void)
+{
+	struct {
+		guint32 addr_start;
+		guint32 page_sz;
+		guint32 packet_sz;
+	} geometries[] = {
+		{ 0x0,	0,	0 },
+		{ 0x0,	0,	4 },
+		{ 0x0,	3,	3 },
+		{ 0x4,	4,	4 },
+		{ 0x0,	10,	4 },
+		{ 0x0,	6,	4 },
+		{ 0x3,	6,	0 },
+		{ 0x5,	8,	3 },
+	};
+	g_autoptr(GBytes) blob = g_bytes_new_static ("XXXXXXYYYYYYZZZZZZ", 18);
+
+	/* this has to match the eagerly allocated array */
+	for (guint i = 0; i < G_N_ELEMENTS (geometries); i++) {
+		g_autoptr(FuChunkView) view = NULL;
+		g_autoptr(GPtrArray) chunks = NULL;
+		FuChunk chk = { 0 };
+
+		chunks = fu_chunk_array_new_from_bytes (blob,
+							geometries[i].addr_start,
+							geometries[i].page_sz,
+							geometries[i].packet_sz);
+		view = fu_chunk_view_new (blob,
+					  geometries[i].addr_start,
+					  geometries[i].page_sz,
+					  geometries[i].packet_sz);
+		g_assert_cmpint (fu_chunk_view_get_length (view), ==, chunks->len);
+		for (guint j = 0; j < chunks->len; j++) {
+			FuChunk *chk_array = g_ptr_array_index (chunks, j);
+			g_assert_true (fu_chunk_view_get_index (view, j, &chk));
+			g_assert_cmpint (chk.idx, ==, chk_array->idx);
+			g_assert_cmpint (chk.page, ==, chk_array->page);
+			g_assert_cmpint (chk.address, ==, chk_array->address);
+			g_assert_cmpint (chk.data_sz, ==, chk_array->data_sz);
+			g_assert (chk.data == chk_array->data);
+		}
+		g_assert_false (fu_chunk_view_get_index (view, chunks->len, &chk));
+	}
+}
+
+static void
+fu_chunk_diff_func (void)
+{
+	const guint8 *data_old = (const guint8 *) "AAAAAAAAAAAAAAAA";
+	const guint8 *data = (const guint8 *) "ABBAAAAAACAAAAAA";
+	FuChunk *chk;
+	g_autoptr(GPtrArray) chunks = NULL;
+	g_autoptr(GPtrArray) pages = NULL;
+
+	/* runs of changed bytes */
+	chunks = fu_chunk_array_new_from_diff (data_old, data, 16, 0x100, 0);
+	g_assert_cmpint (chunks->len, ==, 2);
+	chk = g_ptr_array_index (chunks, 0);
+	g_assert_cmpint (chk->address, ==, 0x101);
+	g_assert_cmpint (chk->data_sz, ==, 2);
+	g_assert (chk->data == data + 1);
+	chk = g_ptr_array_index (chunks, 1);
+	g_assert_cmpint (chk->address, ==, 0x109);
+	g_assert_cmpint (chk->data_sz, ==, 1);
+
+	/* changed pages, with a partial first page */
+	pages = fu_chunk_array_new_from_diff (data_old, data, 16, 0x2, 4);
+	g_assert_cmpint (pages->len, ==, 3);
+	chk = g_ptr_array_index (pages, 0);
+	g_assert_cmpint (chk->page, ==, 0);
+	g_assert_cmpint (chk->address, ==, 2);
+	g_assert_cmpint (chk->data_sz, ==, 2);
+	chk = g_ptr_array_index (pages, 1);
+	g_assert_cmpint (chk->page, ==, 1);
+	g_assert_cmpint (chk->address, ==, 0);
+	g_assert_cmpint (chk->data_sz, ==, 4);
+	chk = g_ptr_array_index (pages, 2);
+	g_assert_cmpint (chk->page, ==, 2);
+	g_assert_cmpint (chk->address, ==, 0);
+	g_assert (chk->data == data + 6);
+}
+
 static void
 fu_chunk_func (void)
 {
@@ -1283,6 +1764,43 @@ fu_common_vercmp_func (void)
 	g_assert_cmpint (fu_common_vercmp (NULL, NULL), ==, G_MAXINT);
 }
 
+static void
+fu_common_version_key_func (void)
+{
+	const gchar *versions[] = {
+		"1.2.3", "001.002.003", "1.2.4", "1.2.3.1", "1.2.3a", "1.2.3b",
+		"alpha", "beta", "1.2a.3", "1.2.3~rc1", "1.2.3~rc2", "0x10203",
+		NULL };
+	g_autoptr(FuCommonVersionKey) key_one = NULL;
+	g_autoptr(FuCommonVersionKey) key_null = NULL;
+
+	/* the parsed keys must agree with fu_common_vercmp_full() */
+	for (guint i = 0; versions[i] != NULL; i++) {
+		for (guint j = 0; versions[j] != NULL; j++) {
+			g_autoptr(FuCommonVersionKey) key_a = NULL;
+			g_autoptr(FuCommonVersionKey) key_b = NULL;
+			key_a = fu_common_version_key_new (versions[i], FWUPD_VERSION_FORMAT_TRIPLET);
+			key_b = fu_common_version_key_new (versions[j], FWUPD_VERSION_FORMAT_TRIPLET);
+			g_assert_cmpint (fu_common_version_key_compare (key_a, key_b), ==,
+					 fu_common_vercmp_full (versions[i], versions[j],
+								FWUPD_VERSION_FORMAT_TRIPLET));
+			g_clear_pointer (&key_a, fu_common_version_key_free);
+			g_clear_pointer (&key_b, fu_common_version_key_free);
+			key_a = fu_common_version_key_new (versions[i], FWUPD_VERSION_FORMAT_PLAIN);
+			key_b = fu_common_version_key_new (versions[j], FWUPD_VERSION_FORMAT_PLAIN);
+			g_assert_cmpint (fu_common_version_key_compare (key_a, key_b), ==,
+					 fu_common_vercmp_full (versions[i], versions[j],
+								FWUPD_VERSION_FORMAT_PLAIN));
+		}
+	}
+
+	/* invalid */
+	key_one = fu_common_version_key_new ("1", FWUPD_VERSION_FORMAT_TRIPLET);
+	key_null = fu_common_version_key_new (NULL, FWUPD_VERSION_FORMAT_TRIPLET);
+	g_assert_cmpint (fu_common_version_key_compare (key_one, key_null), ==, G_MAXINT);
+	g_assert_cmpstr (fu_common_version_key_get_version (key_one), ==, "1");
+}
+
 static void
 fu_firmware_ihex_func (void)
 {
@@ -1385,6 +1903,52 @@ fu_firmware_ihex_signed_func (void)
 	g_assert_cmpint (memcmp (data, "deadbeef", 8), ==, 0);
 }
 
+static void
+fu_firmware_ihex_records_func (void)
+{
+	FuIhexFirmwareRecord *rcd;
+	GPtrArray *records;
+	const guint8 *data;
+	gboolean ret;
+	gsize len = 0;
+	g_autoptr(FuFirmware) firmware = fu_ihex_firmware_new ();
+	g_autoptr(FuFirmware) firmware_bad = fu_ihex_firmware_new ();
+	g_autoptr(GBytes) data_bad = NULL;
+	g_autoptr(GBytes) data_bin = NULL;
+	g_autoptr(GBytes) data_hex = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* lowercase digits, CRLF, a blank line and a hole */
+	data_hex = g_bytes_new_static (":01000000aa55\r\n"
+				       "\n"
+				       ":01000400BB40\n"
+				       ":00000001FF\n", 42);
+	ret = fu_firmware_parse (firmware, data_hex, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	data_bin = fu_firmware_get_image_default_bytes (firmware, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (data_bin);
+	data = g_bytes_get_data (data_bin, &len);
+	g_assert_cmpint (len, ==, 5);
+	g_assert_cmpint (data[0], ==, 0xaa);
+	g_assert_cmpint (data[3], ==, 0x00);
+	g_assert_cmpint (data[4], ==, 0xbb);
+
+	/* the raw records are still available */
+	records = fu_ihex_firmware_get_records (FU_IHEX_FIRMWARE (firmware));
+	g_assert_cmpint (records->len, ==, 3);
+	rcd = g_ptr_array_index (records, 1);
+	g_assert_cmpint (rcd->ln, ==, 3);
+	g_assert_cmpstr (rcd->buf->str, ==, ":01000400BB40");
+
+	/* invalid checksum */
+	data_bad = g_bytes_new_static (":01000000AA56\n:00000001FF\n", 26);
+	ret = fu_firmware_parse (firmware_bad, data_bad, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
+	g_assert_false (ret);
+}
+
 static void
 fu_firmware_ihex_offset_func (void)
 {
@@ -1541,6 +2105,62 @@ fu_firmware_dfu_func (void)
 	g_assert_true (ret);
 }
 
+static void
+fu_firmware_dfu_write_chunks_func (void)
+{
+	gboolean ret;
+	g_autofree gchar *filename_dfu = NULL;
+	g_autofree gchar *filename_tmp = NULL;
+	g_autoptr(FuFirmware) firmware = fu_dfu_firmware_new ();
+	g_autoptr(GBytes) data_bin = NULL;
+	g_autoptr(GBytes) data_dfu = NULL;
+	g_autoptr(GBytes) data_tmp = NULL;
+	g_autoptr(GBytes) data_write = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file_tmp = NULL;
+	g_autoptr(GPtrArray) chunks = NULL;
+
+	filename_dfu = g_build_filename (TESTDATADIR_SRC, "firmware.dfu", NULL);
+	data_dfu = fu_common_get_contents_bytes (filename_dfu, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (data_dfu);
+	ret = fu_firmware_parse (firmware, data_dfu, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* payload is referenced, not copied */
+	data_bin = fu_firmware_get_image_default_bytes (firmware, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (data_bin);
+	chunks = fu_firmware_write_chunks (firmware, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (chunks);
+	g_assert_cmpint (chunks->len, ==, 2);
+	g_assert_true (g_bytes_get_data (g_ptr_array_index (chunks, 0), NULL) ==
+		       g_bytes_get_data (data_bin, NULL));
+
+	/* joined and streamed output both match the original file */
+	data_write = fu_firmware_write (firmware, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (data_write);
+	ret = fu_common_bytes_compare (data_write, data_dfu, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	filename_tmp = g_build_filename ("/tmp/fwupd-self-test", "firmware.dfu", NULL);
+	file_tmp = g_file_new_for_path (filename_tmp);
+	g_mkdir_with_parents ("/tmp/fwupd-self-test", 0700);
+	ret = fu_firmware_write_file (firmware, file_tmp, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	data_tmp = fu_common_get_contents_bytes (filename_tmp, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (data_tmp);
+	ret = fu_common_bytes_compare (data_tmp, data_dfu, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_unlink (filename_tmp);
+}
+
 static void
 fu_firmware_func (void)
 {
@@ -1655,6 +2275,45 @@ fu_efivar_func (void)
 	g_assert_false (ret);
 }
 
+static void
+fu_efivar_snapshot_func (void)
+{
+	gboolean ret;
+	gsize sz = 0;
+	g_autofree guint8 *data = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) names = NULL;
+
+	/* enumerate once */
+	ret = fu_efivar_snapshot_begin (&error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	names = fu_efivar_get_names (FU_EFIVAR_GUID_EFI_GLOBAL, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (names);
+	g_assert_cmpint (names->len, >, 0);
+	g_assert_true (fu_efivar_exists (FU_EFIVAR_GUID_EFI_GLOBAL, "SecureBoot"));
+	g_assert_false (fu_efivar_exists (FU_EFIVAR_GUID_EFI_GLOBAL, "NotGoingToExist"));
+
+	/* changes are visible in the snapshot */
+	ret = fu_efivar_set_data (FU_EFIVAR_GUID_EFI_GLOBAL, "Test", (guint8 *) "2", 1, 0, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = fu_efivar_get_data (FU_EFIVAR_GUID_EFI_GLOBAL, "Test", &data, &sz, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (sz, ==, 1);
+	g_assert_cmpint (data[0], ==, '2');
+	ret = fu_efivar_delete (FU_EFIVAR_GUID_EFI_GLOBAL, "Test", &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_false (fu_efivar_exists (FU_EFIVAR_GUID_EFI_GLOBAL, "Test"));
+	ret = fu_efivar_get_data (FU_EFIVAR_GUID_EFI_GLOBAL, "Test", NULL, NULL, NULL, &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_false (ret);
+	fu_efivar_snapshot_end ();
+}
+
 typedef struct {
 	guint cnt_success;
 	guint cnt_failed;
@@ -1726,6 +2385,59 @@ fu_device_retry_failed_func (void)
 	g_assert_cmpint (helper.cnt_failed, ==, 3);
 }
 
+static gboolean
+fu_device_wait_for_cb (FuDevice *device, gboolean *done, gpointer user_data, GError **error)
+{
+	guint *cnt = (guint *) user_data;
+	if (*cnt == G_MAXUINT) {
+		g_set_error_literal (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL, "failed");
+		return FALSE;
+	}
+	*done = ++(*cnt) >= 5;
+	return TRUE;
+}
+
+static gboolean
+fu_device_wait_for_never_cb (FuDevice *device, gboolean *done, gpointer user_data, GError **error)
+{
+	return TRUE;
+}
+
+static void
+fu_device_wait_for_func (void)
+{
+	gboolean ret;
+	guint cnt = 0;
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GError) error_timeout = NULL;
+	g_autoptr(GError) error_fatal = NULL;
+
+	/* ready on the 5th check */
+	ret = fu_device_wait_for (device, fu_device_wait_for_cb, 1000, &cnt, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (cnt, ==, 5);
+
+	/* again, sleeping for the learned delay first */
+	cnt = 0;
+	ret = fu_device_wait_for (device, fu_device_wait_for_cb, 1000, &cnt, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (cnt, ==, 5);
+
+	/* never ready */
+	ret = fu_device_wait_for (device, fu_device_wait_for_never_cb, 10, NULL, &error_timeout);
+	g_assert_error (error_timeout, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+	g_assert_false (ret);
+
+	/* errors are not retried */
+	cnt = G_MAXUINT;
+	ret = fu_device_wait_for (device, fu_device_wait_for_cb, 1000, &cnt, &error_fatal);
+	g_assert_error (error_fatal, FWUPD_ERROR, FWUPD_ERROR_INTERNAL);
+	g_assert_false (ret);
+}
+
 static void
 fu_device_retry_hardware_func (void)
 {
@@ -1834,19 +2546,31 @@ main (int argc, char **argv)
 
 	g_test_add_func ("/fwupd/security-attrs{hsi}", fu_security_attrs_hsi_func);
 	g_test_add_func ("/fwupd/plugin{delay}", fu_plugin_delay_func);
+	g_test_add_func ("/fwupd/plugin{device-jobs}", fu_plugin_device_jobs_func);
 	g_test_add_func ("/fwupd/plugin{quirks}", fu_plugin_quirks_func);
+	g_test_add_func ("/fwupd/plugin{quirks-prebuilt}", fu_plugin_quirks_prebuilt_func);
 	g_test_add_func ("/fwupd/plugin{quirks-performance}", fu_plugin_quirks_performance_func);
 	g_test_add_func ("/fwupd/plugin{quirks-device}", fu_plugin_quirks_device_func);
 	g_test_add_func ("/fwupd/chunk", fu_chunk_func);
+	g_test_add_func ("/fwupd/chunk{view}", fu_chunk_view_func);
+	g_test_add_func ("/fwupd/chunk{diff}", fu_chunk_diff_func);
+	g_test_add_func ("/fwupd/crc", fu_crc_func);
+	g_test_add_func ("/fwupd/checksum-input-stream", fu_checksum_input_stream_func);
 	g_test_add_func ("/fwupd/common{string-append-kv}", fu_common_string_append_kv_func);
 	g_test_add_func ("/fwupd/common{version-guess-format}", fu_common_version_guess_format_func);
 	g_test_add_func ("/fwupd/common{version}", fu_common_version_func);
 	g_test_add_func ("/fwupd/common{vercmp}", fu_common_vercmp_func);
+	g_test_add_func ("/fwupd/common{version-key}", fu_common_version_key_func);
 	g_test_add_func ("/fwupd/common{strstrip}", fu_common_strstrip_func);
 	g_test_add_func ("/fwupd/common{endian}", fu_common_endian_func);
+	g_test_add_func ("/fwupd/common{data-is-empty}", fu_common_data_is_empty_func);
+	g_test_add_func ("/fwupd/common{data-get-mismatch}", fu_common_data_get_mismatch_func);
+	g_test_add_func ("/fwupd/common{get-contents-mapped}", fu_common_get_contents_mapped_func);
+	g_test_add_func ("/fwupd/io-channel{iov}", fu_io_channel_iov_func);
 	g_test_add_func ("/fwupd/common{cab-success}", fu_common_store_cab_func);
 	g_test_add_func ("/fwupd/common{cab-success-unsigned}", fu_common_store_cab_unsigned_func);
 	g_test_add_func ("/fwupd/common{cab-success-folder}", fu_common_store_cab_folder_func);
+	g_test_add_func ("/fwupd/common{cab-success-stream}", fu_common_store_cab_stream_func);
 	g_test_add_func ("/fwupd/common{cab-error-no-metadata}", fu_common_store_cab_error_no_metadata_func);
 	g_test_add_func ("/fwupd/common{cab-error-wrong-size}", fu_common_store_cab_error_wrong_size_func);
 	g_test_add_func ("/fwupd/common{cab-error-wrong-checksum}", fu_common_store_cab_error_wrong_checksum_func);
@@ -1857,16 +2581,19 @@ main (int argc, char **argv)
 	g_test_add_func ("/fwupd/common{firmware-builder}", fu_common_firmware_builder_func);
 	g_test_add_func ("/fwupd/common{kernel-lockdown}", fu_common_kernel_lockdown_func);
 	g_test_add_func ("/fwupd/efivar", fu_efivar_func);
+	g_test_add_func ("/fwupd/efivar{snapshot}", fu_efivar_snapshot_func);
 	g_test_add_func ("/fwupd/hwids", fu_hwids_func);
 	g_test_add_func ("/fwupd/smbios", fu_smbios_func);
 	g_test_add_func ("/fwupd/smbios3", fu_smbios3_func);
 	g_test_add_func ("/fwupd/firmware", fu_firmware_func);
 	g_test_add_func ("/fwupd/firmware{ihex}", fu_firmware_ihex_func);
 	g_test_add_func ("/fwupd/firmware{ihex-offset}", fu_firmware_ihex_offset_func);
+	g_test_add_func ("/fwupd/firmware{ihex-records}", fu_firmware_ihex_records_func);
 	g_test_add_func ("/fwupd/firmware{ihex-signed}", fu_firmware_ihex_signed_func);
 	g_test_add_func ("/fwupd/firmware{srec-tokenization}", fu_firmware_srec_tokenization_func);
 	g_test_add_func ("/fwupd/firmware{srec}", fu_firmware_srec_func);
 	g_test_add_func ("/fwupd/firmware{dfu}", fu_firmware_dfu_func);
+	g_test_add_func ("/fwupd/firmware{dfu-write-chunks}", fu_firmware_dfu_write_chunks_func);
 	g_test_add_func ("/fwupd/archive{invalid}", fu_archive_invalid_func);
 	g_test_add_func ("/fwupd/archive{cab}", fu_archive_cab_func);
 	g_test_add_func ("/fwupd/device{flags}", fu_device_flags_func);
@@ -1882,5 +2609,6 @@ main (int argc, char **argv)
 	g_test_add_func ("/fwupd/device{retry-success}", fu_device_retry_success_func);
 	g_test_add_func ("/fwupd/device{retry-failed}", fu_device_retry_failed_func);
 	g_test_add_func ("/fwupd/device{retry-hardware}", fu_device_retry_hardware_func);
+	g_test_add_func ("/fwupd/device{wait-for}", fu_device_wait_for_func);
 	return g_test_run ();
 }
@@ -18,8 +18,10 @@
 struct _FuSmbios {
 	GObject			 parent_instance;
 	gchar			*smbios_ver;
+	gchar			*checksum;		/* of the raw tables */
 	guint32			 structure_table_len;
 	GPtrArray		*items;
+	GPtrArray		*items_by_type[G_MAXUINT8 + 1];	/* of FuSmbiosItem, noref */
 };
 
 /* little endian */
@@ -96,6 +98,9 @@ fu_smbios_setup_from_data (FuSmbios *self, const guint8 *buf, gsize sz, GError *
 		item->data = g_bytes_new (buf + i, str->len);
 		item->strings = g_ptr_array_new_with_free_func (g_free);
 		g_ptr_array_add (self->items, item);
+		if (self->items_by_type[item->type] == NULL)
+			self->items_by_type[item->type] = g_ptr_array_new ();
+		g_ptr_array_add (self->items_by_type[item->type], item);
 
 		/* jump to the end of the struct */
 		i += str->len;
@@ -245,10 +250,12 @@ gboolean
 fu_smbios_setup_from_path (FuSmbios *self, const gchar *path, GError **error)
 {
 	gsize sz = 0;
+	gsize ep_sz;
 	g_autofree gchar *dmi_fn = NULL;
 	g_autofree gchar *dmi_raw = NULL;
 	g_autofree gchar *ep_fn = NULL;
 	g_autofree gchar *ep_raw = NULL;
+	g_autoptr(GChecksum) checksum = NULL;
 
 	g_return_val_if_fail (FU_IS_SMBIOS (self), FALSE);
 
@@ -287,6 +294,7 @@ fu_smbios_setup_from_path (FuSmbios *self, const gchar *path, GError **error)
 	}
 
 	/* get the DMI data */
+	ep_sz = sz;
 	dmi_fn = g_build_filename (path, "DMI", NULL);
 	if (!g_file_get_contents (dmi_fn, &dmi_raw, &sz, error))
 		return FALSE;
@@ -300,10 +308,35 @@ fu_smbios_setup_from_path (FuSmbios *self, const gchar *path, GError **error)
 		return FALSE;
 	}
 
+	/* used to find out if the tables changed */
+	checksum = g_checksum_new (G_CHECKSUM_SHA1);
+	g_checksum_update (checksum, (const guchar *) ep_raw, ep_sz);
+	g_checksum_update (checksum, (const guchar *) dmi_raw, sz);
+	g_free (self->checksum);
+	self->checksum = g_strdup (g_checksum_get_string (checksum));
+
 	/* parse blob */
 	return fu_smbios_setup_from_data (self, (guint8 *) dmi_raw, sz, error);
 }
 
+/**
+ * fu_smbios_get_checksum:
+ * @self: A #FuSmbios
+ *
+ * Gets the checksum of the SMBIOS entry point and DMI tables, which can be
+ * used to find out if the values have changed.
+ *
+ * Returns: a SHA1 hash, or %NULL if not loaded using fu_smbios_setup()
+ *
+ * Since: 1.5.0
+ **/
+const gchar *
+fu_smbios_get_checksum (FuSmbios *self)
+{
+	g_return_val_if_fail (FU_IS_SMBIOS (self), NULL);
+	return self->checksum;
+}
+
 /**
  * fu_smbios_setup:
  * @self: A #FuSmbios
@@ -362,12 +395,10 @@ fu_smbios_to_string (FuSmbios *self)
 static FuSmbiosItem *
 fu_smbios_get_item_for_type (FuSmbios *self, guint8 type)
 {
-	for (guint i = 0; i < self->items->len; i++) {
-		FuSmbiosItem *item = g_ptr_array_index (self->items, i);
-		if (item->type == type)
-			return item;
-	}
-	return NULL;
+	GPtrArray *items = self->items_by_type[type];
+	if (items == NULL)
+		return NULL;
+	return g_ptr_array_index (items, 0);
 }
 
 /**
@@ -398,6 +429,44 @@ fu_smbios_get_data (FuSmbios *self, guint8 type, GError **error)
 	return g_bytes_ref (item->data);
 }
 
+/**
+ * fu_smbios_get_data_all:
+ * @self: A #FuSmbios
+ * @type: A structure type, e.g. %FU_SMBIOS_STRUCTURE_TYPE_BIOS
+ * @error: A #GError or %NULL
+ *
+ * Reads all the SMBIOS data blobs of a specific type, which each include the
+ * SMBIOS section header. This is useful for tables that can appear more than
+ * once, for instance one for each network interface.
+ *
+ * Returns: (transfer container) (element-type GBytes): data, or %NULL if not found
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fu_smbios_get_data_all (FuSmbios *self, guint8 type, GError **error)
+{
+	GPtrArray *items;
+	GPtrArray *array;
+
+	g_return_val_if_fail (FU_IS_SMBIOS (self), NULL);
+
+	items = self->items_by_type[type];
+	if (items == NULL) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "no structure with type %02x", type);
+		return NULL;
+	}
+	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+	for (guint i = 0; i < items->len; i++) {
+		FuSmbiosItem *item = g_ptr_array_index (items, i);
+		g_ptr_array_add (array, g_bytes_ref (item->data));
+	}
+	return array;
+}
+
 /**
  * fu_smbios_get_string:
  * @self: A #FuSmbios
@@ -475,7 +544,12 @@ fu_smbios_finalize (GObject *object)
 {
 	FuSmbios *self = FU_SMBIOS (object);
 	g_free (self->smbios_ver);
+	g_free (self->checksum);
 	g_ptr_array_unref (self->items);
+	for (guint i = 0; i < G_N_ELEMENTS (self->items_by_type); i++) {
+		if (self->items_by_type[i] != NULL)
+			g_ptr_array_unref (self->items_by_type[i]);
+	}
 	G_OBJECT_CLASS (fu_smbios_parent_class)->finalize (object);
 }
 
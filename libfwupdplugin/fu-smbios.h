@@ -28,3 +28,6 @@ const gchar	*fu_smbios_get_string		(FuSmbios	*self,
 GBytes		*fu_smbios_get_data		(FuSmbios	*self,
 						 guint8		 type,
 						 GError		**error);
+GPtrArray	*fu_smbios_get_data_all		(FuSmbios	*self,
+						 guint8		 type,
+						 GError		**error);
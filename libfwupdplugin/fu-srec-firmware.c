@@ -80,6 +80,27 @@ fu_srec_firmware_record_new (guint ln, FuFirmareSrecRecordKind kind, guint32 add
 	return rcd;
 }
 
+/* only the first record is checked, skipping any blank lines */
+static gboolean
+fu_srec_firmware_check_magic (FuFirmware *firmware, GBytes *fw, GError **error)
+{
+	gsize sz = 0;
+	const gchar *data = g_bytes_get_data (fw, &sz);
+
+	for (gsize i = 0; i < sz; i++) {
+		if (data[i] == '\r' || data[i] == '\n')
+			continue;
+		if (data[i] != 'S' || i + 2 > sz || !g_ascii_isdigit (data[i + 1]))
+			break;
+		return TRUE;
+	}
+	g_set_error_literal (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "invalid starting token");
+	return FALSE;
+}
+
 static gboolean
 fu_srec_firmware_tokenize (FuFirmware *firmware, GBytes *fw,
 			   FwupdInstallFlags flags, GError **error)
@@ -88,23 +109,29 @@ fu_srec_firmware_tokenize (FuFirmware *firmware, GBytes *fw,
 	const gchar *data;
 	gboolean got_eof = FALSE;
 	gsize sz = 0;
-	g_auto(GStrv) lines = NULL;
+	gchar *line_next;
+	g_autofree gchar *buf = NULL;
 
-	/* parse records */
+	/* parse records, splitting the lines in-place */
 	data = g_bytes_get_data (fw, &sz);
-	lines = fu_common_strnsplit (data, sz, "\n", -1);
-	for (guint ln = 0; lines[ln] != NULL; ln++) {
+	buf = g_strndup (data, sz);
+	line_next = buf;
+	for (guint ln = 0; line_next != NULL; ln++) {
 		FuSrecFirmwareRecord *rcd;
-		const gchar *line = lines[ln];
+		gchar *line = line_next;
 		gsize linesz;
 		guint32 rec_addr32;
 		guint8 addrsz = 0;		/* bytes */
 		guint8 rec_count;		/* words */
 		guint8 rec_kind;
+		guint8 rec[0xff + 1];		/* count, address, data, checksum */
 
 		/* ignore blank lines */
-		g_strdelimit (lines[ln], "\r", '\0');
-		linesz = strlen (line);
+		line_next = strchr (line, '\n');
+		if (line_next != NULL)
+			*line_next++ = '\0';
+		linesz = strcspn (line, "\r");
+		line[linesz] = '\0';
 		if (linesz == 0)
 			continue;
 
@@ -141,14 +168,18 @@ fu_srec_firmware_tokenize (FuFirmware *firmware, GBytes *fw,
 			return FALSE;
 		}
 
+		/* decode each byte just once */
+		for (guint i = 0; i <= rec_count; i++)
+			rec[i] = fu_firmware_strparse_uint8 (line + (i * 2) + 2);
+
 		/* checksum check */
 		if ((flags & FWUPD_INSTALL_FLAG_FORCE) == 0) {
 			guint8 rec_csum = 0;
 			guint8 rec_csum_expected;
 			for (guint8 i = 0; i < rec_count; i++)
-				rec_csum += fu_firmware_strparse_uint8 (line + (i * 2) + 2);
+				rec_csum += rec[i];
 			rec_csum ^= 0xff;
-			rec_csum_expected = fu_firmware_strparse_uint8 (line + (rec_count * 2) + 2);
+			rec_csum_expected = rec[rec_count];
 			if (rec_csum != rec_csum_expected) {
 				g_set_error (error,
 					     FWUPD_ERROR,
@@ -223,11 +254,10 @@ fu_srec_firmware_tokenize (FuFirmware *firmware, GBytes *fw,
 
 		/* data */
 		rcd = fu_srec_firmware_record_new (ln + 1, rec_kind, rec_addr32);
-		if (rec_kind == 1 || rec_kind == 2 || rec_kind == 3) {
-			for (guint8 i = 4 + (addrsz * 2); i <= rec_count * 2; i += 2) {
-				guint8 tmp = fu_firmware_strparse_uint8 (line + i);
-				fu_byte_array_append_uint8 (rcd->buf, tmp);
-			}
+		if ((rec_kind == 1 || rec_kind == 2 || rec_kind == 3) &&
+		    rec_count > addrsz + 1) {
+			g_byte_array_append (rcd->buf, rec + 1 + addrsz,
+					     rec_count - addrsz - 1);
 		}
 		g_ptr_array_add (self->records, rcd);
 	}
@@ -345,10 +375,11 @@ fu_srec_firmware_parse (FuFirmware *firmware,
 					return FALSE;
 				}
 				if (addr32_last > 0x0 && len_hole > 1) {
+					guint outbuf_len = outbuf->len;
 					g_debug ("filling address 0x%08x to 0x%08x at line %u",
 						 addr32_last + 1, addr32_last + len_hole - 1, rcd->ln);
-					for (guint i = 0; i < len_hole; i++)
-						fu_byte_array_append_uint8 (outbuf, 0xff);
+					g_byte_array_set_size (outbuf, outbuf_len + len_hole);
+					memset (outbuf->data + outbuf_len, 0xff, len_hole);
 				}
 
 				/* add data */
@@ -362,7 +393,7 @@ fu_srec_firmware_parse (FuFirmware *firmware,
 	}
 
 	/* add single image */
-	img_bytes = g_bytes_new (outbuf->data, outbuf->len);
+	img_bytes = g_byte_array_free_to_bytes (g_steal_pointer (&outbuf));
 	fu_firmware_image_set_bytes (img, img_bytes);
 	fu_firmware_image_set_addr (img, img_address);
 	fu_firmware_add_image (firmware, img);
@@ -389,6 +420,7 @@ fu_srec_firmware_class_init (FuSrecFirmwareClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	FuFirmwareClass *klass_firmware = FU_FIRMWARE_CLASS (klass);
 	object_class->finalize = fu_srec_firmware_finalize;
+	klass_firmware->check_magic = fu_srec_firmware_check_magic;
 	klass_firmware->parse = fu_srec_firmware_parse;
 	klass_firmware->tokenize = fu_srec_firmware_tokenize;
 }
@@ -0,0 +1,19 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib.h>
+
+void		 fu_timeline_start			(void);
+gboolean	 fu_timeline_get_enabled		(void);
+gint64		 fu_timeline_begin			(void);
+void		 fu_timeline_add			(const gchar	*category,
+							 const gchar	*name,
+							 const gchar	*detail,
+							 gint64		 start);
+gboolean	 fu_timeline_save			(const gchar	*filename,
+							 GError		**error);
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuTimeline"
+
+#include "config.h"
+
+#include <json-glib/json-glib.h>
+
+#include "fwupd-error.h"
+
+#include "fu-timeline-private.h"
+
+/**
+ * SECTION:fu-timeline
+ * @short_description: a timeline of the install
+ *
+ * When started, each phase of the install is recorded with the start time and
+ * duration, and can be saved as a Chrome trace file to be loaded into
+ * `chrome://tracing` or https://ui.perfetto.dev/
+ *
+ * Each call is a no-op when the timeline has not been started.
+ */
+
+typedef struct {
+	const gchar		*category;	/* static */
+	gchar			*name;
+	gchar			*detail;	/* nullable */
+	gint64			 start;		/* µs */
+	gint64			 duration;	/* µs */
+	guint			 tid;
+} FuTimelineEvent;
+
+static gboolean timeline_enabled = FALSE;
+static gint64 timeline_start = 0;		/* µs */
+static GPtrArray *timeline_events = NULL;	/* of FuTimelineEvent */
+static GHashTable *timeline_threads = NULL;	/* GThread:guint */
+G_LOCK_DEFINE_STATIC (timeline);
+
+static void
+fu_timeline_event_free (FuTimelineEvent *event)
+{
+	g_free (event->name);
+	g_free (event->detail);
+	g_free (event);
+}
+
+/**
+ * fu_timeline_start: (skip)
+ *
+ * Starts recording the timeline, discarding any existing events.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_timeline_start (void)
+{
+	G_LOCK (timeline);
+	if (timeline_events != NULL) {
+		g_ptr_array_set_size (timeline_events, 0);
+		g_hash_table_remove_all (timeline_threads);
+	} else {
+		timeline_events = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_timeline_event_free);
+		timeline_threads = g_hash_table_new (g_direct_hash, g_direct_equal);
+	}
+	timeline_start = g_get_monotonic_time ();
+	timeline_enabled = TRUE;
+	G_UNLOCK (timeline);
+}
+
+/**
+ * fu_timeline_get_enabled: (skip)
+ *
+ * Gets if the timeline is being recorded.
+ *
+ * Returns: %TRUE if started
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_timeline_get_enabled (void)
+{
+	return timeline_enabled;
+}
+
+/**
+ * fu_timeline_begin: (skip)
+ *
+ * Gets the start time to use for fu_timeline_add().
+ *
+ * Returns: the monotonic time in µs, or 0 if the timeline is not enabled
+ *
+ * Since: 1.5.0
+ **/
+gint64
+fu_timeline_begin (void)
+{
+	if (!timeline_enabled)
+		return 0;
+	return g_get_monotonic_time ();
+}
+
+/**
+ * fu_timeline_add: (skip)
+ * @category: a static string, e.g. `engine`
+ * @name: the phase, e.g. `detach`
+ * @detail: (nullable): optional detail, typically the device ID
+ * @start: the value returned from fu_timeline_begin()
+ *
+ * Adds a phase to the timeline that ends now.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_timeline_add (const gchar *category,
+		 const gchar *name,
+		 const gchar *detail,
+		 gint64 start)
+{
+	FuTimelineEvent *event;
+	gpointer tid;
+
+	if (!timeline_enabled || start == 0)
+		return;
+
+	event = g_new0 (FuTimelineEvent, 1);
+	event->category = category;
+	event->name = g_strdup (name);
+	event->detail = g_strdup (detail);
+	event->start = start;
+	event->duration = g_get_monotonic_time () - start;
+
+	/* make the threads easier to follow than a pointer */
+	G_LOCK (timeline);
+	tid = g_hash_table_lookup (timeline_threads, g_thread_self ());
+	if (tid == NULL) {
+		tid = GUINT_TO_POINTER (g_hash_table_size (timeline_threads) + 1);
+		g_hash_table_insert (timeline_threads, g_thread_self (), tid);
+	}
+	event->tid = GPOINTER_TO_UINT (tid);
+	g_ptr_array_add (timeline_events, event);
+	G_UNLOCK (timeline);
+}
+
+/**
+ * fu_timeline_save: (skip)
+ * @filename: a filename, e.g. `/tmp/profile.json`
+ * @error: A #GError, or %NULL
+ *
+ * Saves the timeline in the Chrome trace event format.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_timeline_save (const gchar *filename, GError **error)
+{
+	g_autofree gchar *data = NULL;
+	g_autoptr(JsonBuilder) builder = json_builder_new ();
+	g_autoptr(JsonGenerator) json_generator = NULL;
+	g_autoptr(JsonNode) json_root = NULL;
+
+	g_return_val_if_fail (filename != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	G_LOCK (timeline);
+	if (!timeline_enabled) {
+		G_UNLOCK (timeline);
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "not recording");
+		return FALSE;
+	}
+	json_builder_begin_object (builder);
+	json_builder_set_member_name (builder, "displayTimeUnit");
+	json_builder_add_string_value (builder, "ms");
+	json_builder_set_member_name (builder, "traceEvents");
+	json_builder_begin_array (builder);
+	for (guint i = 0; i < timeline_events->len; i++) {
+		FuTimelineEvent *event = g_ptr_array_index (timeline_events, i);
+		json_builder_begin_object (builder);
+		json_builder_set_member_name (builder, "name");
+		json_builder_add_string_value (builder, event->name);
+		json_builder_set_member_name (builder, "cat");
+		json_builder_add_string_value (builder, event->category);
+		json_builder_set_member_name (builder, "ph");
+		json_builder_add_string_value (builder, "X");
+		json_builder_set_member_name (builder, "ts");
+		json_builder_add_int_value (builder, event->start - timeline_start);
+		json_builder_set_member_name (builder, "dur");
+		json_builder_add_int_value (builder, event->duration);
+		json_builder_set_member_name (builder, "pid");
+		json_builder_add_int_value (builder, 1);
+		json_builder_set_member_name (builder, "tid");
+		json_builder_add_int_value (builder, event->tid);
+		if (event->detail != NULL) {
+			json_builder_set_member_name (builder, "args");
+			json_builder_begin_object (builder);
+			json_builder_set_member_name (builder, "detail");
+			json_builder_add_string_value (builder, event->detail);
+			json_builder_end_object (builder);
+		}
+		json_builder_end_object (builder);
+	}
+	json_builder_end_array (builder);
+	json_builder_end_object (builder);
+	G_UNLOCK (timeline);
+
+	/* export as a string */
+	json_root = json_builder_get_root (builder);
+	json_generator = json_generator_new ();
+	json_generator_set_root (json_generator, json_root);
+	data = json_generator_to_data (json_generator, NULL);
+	return g_file_set_contents (filename, data, -1, error);
+}
@@ -0,0 +1,23 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include "config.h"
+
+/* static probes in the fwupd provider, which are a single nop when nothing
+ * is attached, e.g. `bpftrace -l 'usdt:/usr/libexec/fwupd/fwupd:fwupd:*'` --
+ * the arguments are only evaluated when <sys/sdt.h> is available */
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define FU_TRACE1(name,a)		DTRACE_PROBE1(fwupd, name, a)
+#define FU_TRACE2(name,a,b)		DTRACE_PROBE2(fwupd, name, a, b)
+#define FU_TRACE3(name,a,b,c)		DTRACE_PROBE3(fwupd, name, a, b, c)
+#else
+#define FU_TRACE1(name,a)		do { } while (0)
+#define FU_TRACE2(name,a,b)		do { } while (0)
+#define FU_TRACE3(name,a,b,c)		do { } while (0)
+#endif
@@ -23,7 +23,9 @@
 #include <glib/gstdio.h>
 
 #include "fu-device-private.h"
+#include "fu-emulation-private.h"
 #include "fu-udev-device-private.h"
+#include "fu-trace-private.h"
 
 /**
  * SECTION:fu-udev-device
@@ -44,6 +46,7 @@ typedef struct
 	gchar			*device_file;
 	gint			 fd;
 	FuUdevDeviceFlags	 flags;
+	GHashTable		*sysfs_attrs;	/* attr:value, cached */
 } FuUdevDevicePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (FuUdevDevice, fu_udev_device, FU_TYPE_DEVICE)
@@ -76,8 +79,10 @@ static guint signals[SIGNAL_LAST] = { 0 };
 void
 fu_udev_device_emit_changed (FuUdevDevice *self)
 {
+	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
 	g_return_if_fail (FU_IS_UDEV_DEVICE (self));
 	g_debug ("FuUdevDevice emit changed");
+	g_hash_table_remove_all (priv->sysfs_attrs);
 	g_signal_emit (self, signals[SIGNAL_CHANGED], 0);
 }
 
@@ -358,6 +363,7 @@ fu_udev_device_set_dev (FuUdevDevice *self, GUdevDevice *udev_device)
 
 	/* set new device */
 	g_set_object (&priv->udev_device, udev_device);
+	g_hash_table_remove_all (priv->sysfs_attrs);
 	if (priv->udev_device == NULL)
 		return;
 #ifdef HAVE_GUDEV
@@ -866,14 +872,48 @@ fu_udev_device_ioctl (FuUdevDevice *self,
 {
 #ifdef HAVE_IOCTL_H
 	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
+	FuEmulationMode mode = fu_emulation_get_mode ();
 	gint rc_tmp;
+	gint64 start = 0;
+	g_autofree guint8 *buf_in = NULL;
+#ifdef _IOC_SIZE
+	gsize bufsz = _IOC_SIZE (request);
+#else
+	gsize bufsz = 0;
+#endif
 
 	g_return_val_if_fail (FU_IS_UDEV_DEVICE (self), FALSE);
 	g_return_val_if_fail (request != 0x0, FALSE);
 	g_return_val_if_fail (buf != NULL, FALSE);
+
+	/* emulated, where the size is encoded in the request */
+	if (mode == FU_EMULATION_MODE_REPLAY) {
+		if (!fu_emulation_replay_event ("UdevIoctl", request, buf, bufsz,
+						buf, bufsz, NULL, error))
+			return FALSE;
+		if (rc != NULL)
+			*rc = 0;
+		return TRUE;
+	}
 	g_return_val_if_fail (priv->fd > 0, FALSE);
 
+	/* the buffer is modified by the ioctl, and only timed when recording */
+	if (mode == FU_EMULATION_MODE_RECORD) {
+		buf_in = g_memdup (buf, bufsz);
+		start = g_get_monotonic_time ();
+	}
+	FU_TRACE2 (udev_device_ioctl_begin, priv->fd, request);
 	rc_tmp = ioctl (priv->fd, request, buf);
+	FU_TRACE3 (udev_device_ioctl_end, priv->fd, request, rc_tmp);
+	if (mode == FU_EMULATION_MODE_RECORD) {
+		g_autoptr(GError) error_rc = NULL;
+		if (rc_tmp < 0) {
+			error_rc = g_error_new (FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+						"ioctl failed: %i", rc_tmp);
+		}
+		fu_emulation_add_event ("UdevIoctl", request, buf_in, bufsz,
+					buf, bufsz, start, error_rc);
+	}
 	if (rc != NULL)
 		*rc = rc_tmp;
 	if (rc_tmp < 0) {
@@ -1020,6 +1060,105 @@ fu_udev_device_get_sysfs_attr (FuUdevDevice *self, const gchar *attr,
 
 }
 
+/**
+ * fu_udev_device_get_sysfs_attrs:
+ * @self: A #FuUdevDevice
+ * @attrs: (array zero-terminated=1): names of the attributes to get
+ * @flags: #FuUdevDeviceAttrFlags, e.g. %FU_UDEV_DEVICE_ATTR_FLAG_CACHE
+ * @error: A #GError, or %NULL
+ *
+ * Reads several sysfs attributes, opening the sysfs directory only once.
+ * Attributes that do not exist or cannot be read are not included in the
+ * results, and trailing whitespace is removed from the values.
+ *
+ * If %FU_UDEV_DEVICE_ATTR_FLAG_CACHE is set then the values are remembered
+ * and are not read again until the device emits ::changed.
+ *
+ * Returns: (transfer container) (element-type utf8 utf8): attr:value, or %NULL
+ *
+ * Since: 1.5.0
+ **/
+GHashTable *
+fu_udev_device_get_sysfs_attrs (FuUdevDevice *self,
+				const gchar **attrs,
+				FuUdevDeviceAttrFlags flags,
+				GError **error)
+{
+	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
+	const gchar *sysfs_path;
+	gint dirfd = -1;
+	g_autoptr(GHashTable) results = NULL;
+
+	g_return_val_if_fail (FU_IS_UDEV_DEVICE (self), NULL);
+	g_return_val_if_fail (attrs != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	sysfs_path = fu_udev_device_get_sysfs_path (self);
+	if (sysfs_path == NULL) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_FOUND,
+				     "not yet initialized");
+		return NULL;
+	}
+
+	results = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	for (guint i = 0; attrs[i] != NULL; i++) {
+		gchar buf[4096] = { '\0' };	/* sysfs limits attributes to one page */
+		gint fd;
+		gssize len;
+		const gchar *tmp;
+
+		/* already read */
+		if (flags & FU_UDEV_DEVICE_ATTR_FLAG_CACHE) {
+			tmp = g_hash_table_lookup (priv->sysfs_attrs, attrs[i]);
+			if (tmp != NULL) {
+				g_hash_table_insert (results,
+						     g_strdup (attrs[i]),
+						     g_strdup (tmp));
+				continue;
+			}
+		}
+
+		/* only open the directory when required */
+		if (dirfd < 0) {
+			dirfd = g_open (sysfs_path, O_RDONLY | O_DIRECTORY, 0);
+			if (dirfd < 0) {
+				g_set_error (error,
+					     G_IO_ERROR,
+					     g_io_error_from_errno (errno),
+					     "failed to open %s: %s",
+					     sysfs_path, strerror (errno));
+				return NULL;
+			}
+		}
+		fd = openat (dirfd, attrs[i], O_RDONLY);
+		if (fd < 0) {
+			g_debug ("failed to open %s/%s: %s",
+				 sysfs_path, attrs[i], strerror (errno));
+			continue;
+		}
+		len = read (fd, buf, sizeof(buf) - 1);
+		g_close (fd, NULL);
+		if (len < 0) {
+			g_debug ("failed to read %s/%s: %s",
+				 sysfs_path, attrs[i], strerror (errno));
+			continue;
+		}
+		buf[len] = '\0';
+		g_strchomp (buf);
+		g_hash_table_insert (results, g_strdup (attrs[i]), g_strdup (buf));
+		if (flags & FU_UDEV_DEVICE_ATTR_FLAG_CACHE) {
+			g_hash_table_insert (priv->sysfs_attrs,
+					     g_strdup (attrs[i]),
+					     g_strdup (buf));
+		}
+	}
+	if (dirfd >= 0)
+		g_close (dirfd, NULL);
+	return g_steal_pointer (&results);
+}
+
 /**
  * fu_udev_device_pread:
  * @self: A #FuUdevDevice
@@ -1115,6 +1254,7 @@ fu_udev_device_finalize (GObject *object)
 
 	g_free (priv->subsystem);
 	g_free (priv->device_file);
+	g_hash_table_unref (priv->sysfs_attrs);
 	if (priv->udev_device != NULL)
 		g_object_unref (priv->udev_device);
 	if (priv->fd > 0)
@@ -1129,6 +1269,7 @@ fu_udev_device_init (FuUdevDevice *self)
 	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
 	priv->flags = FU_UDEV_DEVICE_FLAG_OPEN_READ |
 		      FU_UDEV_DEVICE_FLAG_OPEN_WRITE;
+	priv->sysfs_attrs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 }
 
 static void
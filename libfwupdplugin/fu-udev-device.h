@@ -50,6 +50,20 @@ typedef enum {
 	FU_UDEV_DEVICE_FLAG_LAST
 } FuUdevDeviceFlags;
 
+/**
+ * FuUdevDeviceAttrFlags:
+ * @FU_UDEV_DEVICE_ATTR_FLAG_NONE:		No flags set
+ * @FU_UDEV_DEVICE_ATTR_FLAG_CACHE:		The attributes do not change
+ *
+ * Flags used when reading attributes using fu_udev_device_get_sysfs_attrs().
+ **/
+typedef enum {
+	FU_UDEV_DEVICE_ATTR_FLAG_NONE		= 0,
+	FU_UDEV_DEVICE_ATTR_FLAG_CACHE		= 1 << 0,
+	/*< private >*/
+	FU_UDEV_DEVICE_ATTR_FLAG_LAST
+} FuUdevDeviceAttrFlags;
+
 FuUdevDevice	*fu_udev_device_new			(GUdevDevice	*udev_device);
 GUdevDevice	*fu_udev_device_get_dev			(FuUdevDevice	*self);
 const gchar	*fu_udev_device_get_device_file		(FuUdevDevice	*self);
@@ -88,4 +102,8 @@ gboolean	 fu_udev_device_pread			(FuUdevDevice	*self,
 const gchar	*fu_udev_device_get_sysfs_attr		 (FuUdevDevice	*self,
 							  const gchar	*attr,
 							  GError	**error);
+GHashTable	*fu_udev_device_get_sysfs_attrs		(FuUdevDevice	*self,
+							 const gchar	**attrs,
+							 FuUdevDeviceAttrFlags flags,
+							 GError		**error);
 gchar		*fu_udev_device_get_parent_name		(FuUdevDevice	*self);
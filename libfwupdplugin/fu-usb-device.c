@@ -8,8 +8,12 @@
 
 #include "config.h"
 
+#include "fwupd-error.h"
+
+#include "fu-chunk.h"
 #include "fu-device-private.h"
 #include "fu-usb-device-private.h"
+#include "fu-trace-private.h"
 
 /**
  * SECTION:fu-usb-device
@@ -155,7 +159,7 @@ fu_usb_device_query_hub (FuUsbDevice *self, GError **error)
 }
 
 static gboolean
-fu_usb_device_open (FuDevice *device, GError **error)
+fu_usb_device_open_internal (FuDevice *device, GError **error)
 {
 	FuUsbDevice *self = FU_USB_DEVICE (device);
 	FuUsbDevicePrivate *priv = GET_PRIVATE (self);
@@ -270,6 +274,16 @@ fu_usb_device_open (FuDevice *device, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_usb_device_open (FuDevice *device, GError **error)
+{
+	gboolean ret;
+	FU_TRACE1 (usb_device_open_begin, fu_device_get_id (device));
+	ret = fu_usb_device_open_internal (device, error);
+	FU_TRACE2 (usb_device_open_end, fu_device_get_id (device), ret);
+	return ret;
+}
+
 static gboolean
 fu_usb_device_close (FuDevice *device, GError **error)
 {
@@ -561,6 +575,175 @@ fu_usb_device_get_dev (FuUsbDevice *device)
 	return priv->usb_device;
 }
 
+typedef struct {
+	FuUsbDevice		*self;
+	GMainLoop		*loop;
+	GCancellable		*cancellable;
+	GPtrArray		*chunks;
+	GError			*error;		/* first failure */
+	guint8			 endpoint;
+	guint			 timeout_ms;
+	guint			 max_in_flight;
+	guint			 in_flight;
+	guint			 idx_submit;
+	guint			 idx_complete;
+} FuUsbDeviceBulkHelper;
+
+typedef struct {
+	FuUsbDeviceBulkHelper	*helper;
+	guint			 idx;
+} FuUsbDeviceBulkTransfer;
+
+static void fu_usb_device_bulk_submit (FuUsbDeviceBulkHelper *helper);
+
+static void
+fu_usb_device_bulk_set_error (FuUsbDeviceBulkHelper *helper, GError *error)
+{
+	/* keep the first error, the rest are likely cancellations */
+	if (helper->error != NULL) {
+		g_error_free (error);
+		return;
+	}
+	helper->error = error;
+	g_cancellable_cancel (helper->cancellable);
+}
+
+static void
+fu_usb_device_bulk_write_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuUsbDeviceBulkTransfer *xfer = (FuUsbDeviceBulkTransfer *) user_data;
+	FuUsbDeviceBulkHelper *helper = xfer->helper;
+	FuChunk *chk = g_ptr_array_index (helper->chunks, xfer->idx);
+	GError *error_local = NULL;
+	gssize actual_len;
+
+	helper->in_flight--;
+	actual_len = g_usb_device_bulk_transfer_finish (G_USB_DEVICE (source), res, &error_local);
+	if (actual_len < 0) {
+		g_prefix_error (&error_local, "failed to write chunk %u: ", xfer->idx);
+		fu_usb_device_bulk_set_error (helper, error_local);
+	} else if ((gsize) actual_len != chk->data_sz) {
+		fu_usb_device_bulk_set_error (helper,
+					      g_error_new (FWUPD_ERROR,
+							   FWUPD_ERROR_WRITE,
+							   "only wrote 0x%x of 0x%x bytes for chunk %u",
+							   (guint) actual_len,
+							   chk->data_sz,
+							   xfer->idx));
+	} else if (xfer->idx != helper->idx_complete) {
+		fu_usb_device_bulk_set_error (helper,
+					      g_error_new (FWUPD_ERROR,
+							   FWUPD_ERROR_INTERNAL,
+							   "chunk %u completed before chunk %u",
+							   xfer->idx,
+							   helper->idx_complete));
+	} else {
+		helper->idx_complete++;
+		fu_device_set_progress_full (FU_DEVICE (helper->self),
+					     helper->idx_complete,
+					     helper->chunks->len);
+	}
+	g_free (xfer);
+
+	/* queue more, or finish when everything has drained */
+	fu_usb_device_bulk_submit (helper);
+	if (helper->in_flight == 0)
+		g_main_loop_quit (helper->loop);
+}
+
+static void
+fu_usb_device_bulk_submit (FuUsbDeviceBulkHelper *helper)
+{
+	GUsbDevice *usb_device = fu_usb_device_get_dev (helper->self);
+	while (helper->error == NULL &&
+	       helper->in_flight < helper->max_in_flight &&
+	       helper->idx_submit < helper->chunks->len) {
+		FuChunk *chk = g_ptr_array_index (helper->chunks, helper->idx_submit);
+		FuUsbDeviceBulkTransfer *xfer = g_new0 (FuUsbDeviceBulkTransfer, 1);
+		xfer->helper = helper;
+		xfer->idx = helper->idx_submit++;
+		helper->in_flight++;
+		g_usb_device_bulk_transfer_async (usb_device,
+						  helper->endpoint,
+						  (guint8 *) chk->data,
+						  chk->data_sz,
+						  helper->timeout_ms,
+						  helper->cancellable,
+						  fu_usb_device_bulk_write_cb,
+						  xfer);
+	}
+}
+
+/**
+ * fu_usb_device_bulk_write_chunks:
+ * @device: A #FuUsbDevice
+ * @endpoint: the OUT endpoint address, e.g. 0x01
+ * @chunks: (element-type FuChunk): data to write
+ * @max_in_flight: the maximum number of transfers queued at once, e.g. 4
+ * @timeout_ms: timeout for each transfer in ms
+ * @error: A #GError, or %NULL
+ *
+ * Writes each chunk to a bulk endpoint, keeping up to @max_in_flight
+ * transfers queued so that the device never waits for the host between
+ * packets. The chunks must complete in the order they were submitted.
+ *
+ * On the first failure no more chunks are submitted, the transfers already
+ * queued are cancelled, and the error is returned once they have finished.
+ *
+ * The device progress is updated as each chunk completes.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_usb_device_bulk_write_chunks (FuUsbDevice *device,
+				 guint8 endpoint,
+				 GPtrArray *chunks,
+				 guint max_in_flight,
+				 guint timeout_ms,
+				 GError **error)
+{
+	FuUsbDevicePrivate *priv = GET_PRIVATE (device);
+	FuUsbDeviceBulkHelper helper = {
+		.self		= device,
+		.chunks		= chunks,
+		.endpoint	= endpoint,
+		.timeout_ms	= timeout_ms,
+		.max_in_flight	= MAX (max_in_flight, 1),
+	};
+	g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+	g_autoptr(GMainContext) context = g_main_context_new ();
+	g_autoptr(GMainLoop) loop = g_main_loop_new (context, FALSE);
+
+	g_return_val_if_fail (FU_IS_USB_DEVICE (device), FALSE);
+	g_return_val_if_fail (chunks != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (priv->usb_device == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "no GUsbDevice");
+		return FALSE;
+	}
+
+	/* completions are dispatched to our own context */
+	helper.loop = loop;
+	helper.cancellable = cancellable;
+	g_main_context_push_thread_default (context);
+	fu_usb_device_bulk_submit (&helper);
+	if (helper.in_flight > 0)
+		g_main_loop_run (loop);
+	g_main_context_pop_thread_default (context);
+
+	if (helper.error != NULL) {
+		g_propagate_error (error, helper.error);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static void
 fu_usb_device_incorporate (FuDevice *self, FuDevice *donor)
 {
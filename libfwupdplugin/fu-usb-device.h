@@ -37,3 +37,9 @@ void		 fu_usb_device_set_dev			(FuUsbDevice	*device,
 gboolean	 fu_usb_device_is_open			(FuUsbDevice	*device);
 GUdevDevice	*fu_usb_device_find_udev_device		(FuUsbDevice	*device,
 							 GError		**error);
+gboolean	 fu_usb_device_bulk_write_chunks	(FuUsbDevice	*device,
+							 guint8		 endpoint,
+							 GPtrArray	*chunks,
+							 guint		 max_in_flight,
+							 guint		 timeout_ms,
+							 GError		**error);
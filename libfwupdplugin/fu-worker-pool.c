@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuWorkerPool"
+
+#include "config.h"
+
+#include "fu-worker-pool.h"
+
+/**
+ * SECTION:fu-worker-pool
+ * @short_description: a shared pool of worker threads
+ *
+ * A pool of threads owned by the daemon and shared by all the plugins and
+ * the engine, rather than each creating threads of its own.
+ *
+ * Jobs are added to a #FuWorkerBatch, and the thread that waits for the batch
+ * runs any jobs not yet started by the pool itself. This means a job can wait
+ * for a nested batch without using up all the worker threads.
+ */
+
+struct _FuWorkerPool {
+	GObject			 parent_instance;
+	GThreadPool		*pool;
+	gint			 seq;		/* order added, atomic */
+};
+
+struct _FuWorkerBatch {
+	GObject			 parent_instance;
+	FuWorkerPool		*pool;		/* noref, nullable */
+	FuWorkerPriority	 priority;
+	GCancellable		*cancellable;
+	GPtrArray		*jobs;		/* of FuWorkerJob */
+	GMutex			 mutex;
+	GCond			 cond;
+	guint			 pending;
+};
+
+typedef struct {
+	FuWorkerBatch		*batch;		/* noref */
+	FuWorkerFunc		 func;
+	gpointer		 data;
+	guint			 seq;
+	gint			 claimed;	/* atomic */
+} FuWorkerJob;
+
+G_DEFINE_TYPE (FuWorkerPool, fu_worker_pool, G_TYPE_OBJECT)
+G_DEFINE_TYPE (FuWorkerBatch, fu_worker_batch, G_TYPE_OBJECT)
+
+/* runs in whichever thread claims the job first */
+static void
+fu_worker_job_run (FuWorkerJob *job)
+{
+	FuWorkerBatch *batch = job->batch;
+
+	if (!g_atomic_int_compare_and_exchange (&job->claimed, FALSE, TRUE))
+		return;
+	if (!g_cancellable_is_cancelled (batch->cancellable))
+		job->func (job->data, batch->cancellable);
+	g_mutex_lock (&batch->mutex);
+	if (--batch->pending == 0)
+		g_cond_broadcast (&batch->cond);
+	g_mutex_unlock (&batch->mutex);
+}
+
+static void
+fu_worker_pool_thread_cb (gpointer data, gpointer user_data)
+{
+	FuWorkerJob *job = (FuWorkerJob *) data;
+	FuWorkerBatch *batch = job->batch;
+	fu_worker_job_run (job);
+	g_object_unref (batch);
+}
+
+/* higher priority first, and then in the order added */
+static gint
+fu_worker_pool_sort_cb (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	const FuWorkerJob *job1 = a;
+	const FuWorkerJob *job2 = b;
+	if (job1->batch->priority != job2->batch->priority)
+		return job1->batch->priority < job2->batch->priority ? -1 : 1;
+	if (job1->seq != job2->seq)
+		return job1->seq < job2->seq ? -1 : 1;
+	return 0;
+}
+
+static void
+fu_worker_pool_finalize (GObject *obj)
+{
+	FuWorkerPool *self = FU_WORKER_POOL (obj);
+	if (self->pool != NULL)
+		g_thread_pool_free (self->pool, FALSE, TRUE);
+	G_OBJECT_CLASS (fu_worker_pool_parent_class)->finalize (obj);
+}
+
+static void
+fu_worker_pool_class_init (FuWorkerPoolClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_worker_pool_finalize;
+}
+
+static void
+fu_worker_pool_init (FuWorkerPool *self)
+{
+}
+
+/**
+ * fu_worker_pool_new:
+ * @max_threads: the maximum number of threads, which are started on demand
+ * @error: A #GError, or %NULL
+ *
+ * Creates a new worker pool.
+ *
+ * Returns: (transfer full): a #FuWorkerPool, or %NULL on error
+ *
+ * Since: 1.5.0
+ **/
+FuWorkerPool *
+fu_worker_pool_new (guint max_threads, GError **error)
+{
+	g_autoptr(FuWorkerPool) self = g_object_new (FU_TYPE_WORKER_POOL, NULL);
+
+	g_return_val_if_fail (max_threads > 0, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	self->pool = g_thread_pool_new (fu_worker_pool_thread_cb, NULL,
+					(gint) max_threads, FALSE, error);
+	if (self->pool == NULL)
+		return NULL;
+	g_thread_pool_set_sort_function (self->pool, fu_worker_pool_sort_cb, NULL);
+	return g_steal_pointer (&self);
+}
+
+static void
+fu_worker_batch_finalize (GObject *obj)
+{
+	FuWorkerBatch *self = FU_WORKER_BATCH (obj);
+
+	if (self->cancellable != NULL)
+		g_object_unref (self->cancellable);
+	g_ptr_array_unref (self->jobs);
+	g_mutex_clear (&self->mutex);
+	g_cond_clear (&self->cond);
+
+	G_OBJECT_CLASS (fu_worker_batch_parent_class)->finalize (obj);
+}
+
+static void
+fu_worker_batch_class_init (FuWorkerBatchClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_worker_batch_finalize;
+}
+
+static void
+fu_worker_batch_init (FuWorkerBatch *self)
+{
+	self->jobs = g_ptr_array_new_with_free_func (g_free);
+	g_mutex_init (&self->mutex);
+	g_cond_init (&self->cond);
+}
+
+/**
+ * fu_worker_batch_new:
+ * @pool: (nullable): A #FuWorkerPool
+ * @priority: A #FuWorkerPriority, e.g. %FU_WORKER_PRIORITY_BACKGROUND
+ * @cancellable: (nullable): A #GCancellable
+ *
+ * Creates a new batch of jobs. If @pool is %NULL then each job is run as
+ * soon as it is added. The pool must not be destroyed before the batch.
+ *
+ * Jobs not yet started when @cancellable is cancelled are skipped, and jobs
+ * already running are expected to check it.
+ *
+ * Returns: (transfer full): a #FuWorkerBatch
+ *
+ * Since: 1.5.0
+ **/
+FuWorkerBatch *
+fu_worker_batch_new (FuWorkerPool *pool, FuWorkerPriority priority, GCancellable *cancellable)
+{
+	FuWorkerBatch *self;
+
+	g_return_val_if_fail (pool == NULL || FU_IS_WORKER_POOL (pool), NULL);
+	g_return_val_if_fail (priority < FU_WORKER_PRIORITY_LAST, NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+
+	self = g_object_new (FU_TYPE_WORKER_BATCH, NULL);
+	self->pool = pool;
+	self->priority = priority;
+	if (cancellable != NULL)
+		self->cancellable = g_object_ref (cancellable);
+	return self;
+}
+
+/**
+ * fu_worker_batch_add:
+ * @self: A #FuWorkerBatch
+ * @func: (scope call): A #FuWorkerFunc
+ * @data: the data for @func, which must stay valid until the batch is done
+ *
+ * Adds a job to the batch. Jobs must only be added from the thread that
+ * will call fu_worker_batch_wait().
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_worker_batch_add (FuWorkerBatch *self, FuWorkerFunc func, gpointer data)
+{
+	FuWorkerJob *job;
+	g_autoptr(GError) error = NULL;
+
+	g_return_if_fail (FU_IS_WORKER_BATCH (self));
+	g_return_if_fail (func != NULL);
+
+	job = g_new0 (FuWorkerJob, 1);
+	job->batch = self;
+	job->func = func;
+	job->data = data;
+	g_ptr_array_add (self->jobs, job);
+	g_mutex_lock (&self->mutex);
+	self->pending++;
+	g_mutex_unlock (&self->mutex);
+
+	/* no pool, so run it now */
+	if (self->pool == NULL) {
+		fu_worker_job_run (job);
+		return;
+	}
+
+	/* the pool thread drops the ref when done */
+	job->seq = (guint) g_atomic_int_add (&self->pool->seq, 1);
+	g_object_ref (self);
+	if (!g_thread_pool_push (self->pool->pool, job, &error)) {
+		g_debug ("failed to push job, running now: %s", error->message);
+		g_object_unref (self);
+		fu_worker_job_run (job);
+	}
+}
+
+/**
+ * fu_worker_batch_wait:
+ * @self: A #FuWorkerBatch
+ *
+ * Waits for all the jobs in the batch to complete. Jobs that the pool has not
+ * started yet are run in this thread, taking them from the end of the batch
+ * so the workers can carry on from the start.
+ *
+ * Since: 1.5.0
+ **/
+void
+fu_worker_batch_wait (FuWorkerBatch *self)
+{
+	g_return_if_fail (FU_IS_WORKER_BATCH (self));
+
+	for (guint i = self->jobs->len; i > 0; i--)
+		fu_worker_job_run (g_ptr_array_index (self->jobs, i - 1));
+	g_mutex_lock (&self->mutex);
+	while (self->pending > 0)
+		g_cond_wait (&self->cond, &self->mutex);
+	g_mutex_unlock (&self->mutex);
+}
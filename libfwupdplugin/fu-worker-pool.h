@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#define FU_TYPE_WORKER_POOL (fu_worker_pool_get_type ())
+G_DECLARE_FINAL_TYPE (FuWorkerPool, fu_worker_pool, FU, WORKER_POOL, GObject)
+
+#define FU_TYPE_WORKER_BATCH (fu_worker_batch_get_type ())
+G_DECLARE_FINAL_TYPE (FuWorkerBatch, fu_worker_batch, FU, WORKER_BATCH, GObject)
+
+/**
+ * FuWorkerPriority:
+ * @FU_WORKER_PRIORITY_INTERACTIVE:	A client is waiting for the result
+ * @FU_WORKER_PRIORITY_INSTALL:		Part of a firmware update
+ * @FU_WORKER_PRIORITY_BACKGROUND:	Probing or verifying devices
+ *
+ * The priority of the jobs in a #FuWorkerBatch.
+ **/
+typedef enum {
+	FU_WORKER_PRIORITY_INTERACTIVE,
+	FU_WORKER_PRIORITY_INSTALL,
+	FU_WORKER_PRIORITY_BACKGROUND,
+	/*< private >*/
+	FU_WORKER_PRIORITY_LAST
+} FuWorkerPriority;
+
+/**
+ * FuWorkerFunc:
+ * @data: the data passed to fu_worker_batch_add()
+ * @cancellable: (nullable): the #GCancellable of the batch
+ *
+ * A job run in a worker thread.
+ **/
+typedef void (*FuWorkerFunc)			(gpointer		 data,
+						 GCancellable		*cancellable);
+
+FuWorkerPool	*fu_worker_pool_new		(guint			 max_threads,
+						 GError			**error);
+FuWorkerBatch	*fu_worker_batch_new		(FuWorkerPool		*pool,
+						 FuWorkerPriority	 priority,
+						 GCancellable		*cancellable);
+void		 fu_worker_batch_add		(FuWorkerBatch		*self,
+						 FuWorkerFunc		 func,
+						 gpointer		 data);
+void		 fu_worker_batch_wait		(FuWorkerBatch		*self);
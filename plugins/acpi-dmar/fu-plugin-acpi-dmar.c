@@ -10,22 +10,62 @@
 #include "fu-hash.h"
 #include "fu-acpi-dmar.h"
 
+struct FuPluginData {
+	gboolean		 loaded;
+	FuAcpiDmar		*dmar;		/* nullable */
+	const gchar		*result;	/* set if dmar is NULL */
+};
+
 void
 fu_plugin_init (FuPlugin *plugin)
 {
+	fu_plugin_alloc_data (plugin, sizeof (FuPluginData));
 	fu_plugin_set_build_hash (plugin, FU_BUILD_HASH);
 }
 
 void
-fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
+fu_plugin_destroy (FuPlugin *plugin)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	if (data->dmar != NULL)
+		g_object_unref (data->dmar);
+}
+
+/* the table does not change at runtime, so only load and parse it once */
+static void
+fu_plugin_acpi_dmar_ensure_table (FuPlugin *plugin)
 {
+	FuPluginData *data = fu_plugin_get_data (plugin);
 	g_autofree gchar *fn = NULL;
 	g_autofree gchar *path = NULL;
-	g_autoptr(FuAcpiDmar) dmar = NULL;
-	g_autoptr(FwupdSecurityAttr) attr = NULL;
 	g_autoptr(GBytes) blob = NULL;
 	g_autoptr(GError) error_local = NULL;
 
+	if (data->loaded)
+		return;
+	data->loaded = TRUE;
+
+	path = fu_common_get_path (FU_PATH_KIND_ACPI_TABLES);
+	fn = g_build_filename (path, "DMAR", NULL);
+	blob = fu_common_get_contents_bytes (fn, &error_local);
+	if (blob == NULL) {
+		g_warning ("failed to load %s: %s", fn, error_local->message);
+		data->result = "Could not load DMAR";
+		return;
+	}
+	data->dmar = fu_acpi_dmar_new (blob, &error_local);
+	if (data->dmar == NULL) {
+		g_warning ("failed to parse %s: %s", fn, error_local->message);
+		data->result = "Could not parse DMAR";
+	}
+}
+
+void
+fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	g_autoptr(FwupdSecurityAttr) attr = NULL;
+
 	/* only Intel */
 	if (!fu_common_is_cpu_intel ())
 		return;
@@ -37,21 +77,12 @@ fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
 	fu_security_attrs_append (attrs, attr);
 
 	/* load DMAR table */
-	path = fu_common_get_path (FU_PATH_KIND_ACPI_TABLES);
-	fn = g_build_filename (path, "DMAR", NULL);
-	blob = fu_common_get_contents_bytes (fn, &error_local);
-	if (blob == NULL) {
-		g_warning ("failed to load %s: %s", fn, error_local->message);
-		fwupd_security_attr_set_result (attr, "Could not load DMAR");
-		return;
-	}
-	dmar = fu_acpi_dmar_new (blob, &error_local);
-	if (dmar == NULL) {
-		g_warning ("failed to parse %s: %s", fn, error_local->message);
-		fwupd_security_attr_set_result (attr, "Could not parse DMAR");
+	fu_plugin_acpi_dmar_ensure_table (plugin);
+	if (data->dmar == NULL) {
+		fwupd_security_attr_set_result (attr, data->result);
 		return;
 	}
-	if (!fu_acpi_dmar_get_opt_in (dmar)) {
+	if (!fu_acpi_dmar_get_opt_in (data->dmar)) {
 		fwupd_security_attr_set_result (attr, "Unavailable");
 		return;
 	}
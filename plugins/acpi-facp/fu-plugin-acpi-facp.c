@@ -10,44 +10,75 @@
 #include "fu-hash.h"
 #include "fu-acpi-facp.h"
 
+struct FuPluginData {
+	gboolean		 loaded;
+	FuAcpiFacp		*facp;		/* nullable */
+	const gchar		*result;	/* set if facp is NULL */
+};
+
 void
 fu_plugin_init (FuPlugin *plugin)
 {
+	fu_plugin_alloc_data (plugin, sizeof (FuPluginData));
 	fu_plugin_set_build_hash (plugin, FU_BUILD_HASH);
 }
 
 void
-fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
+fu_plugin_destroy (FuPlugin *plugin)
 {
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	if (data->facp != NULL)
+		g_object_unref (data->facp);
+}
+
+/* the table does not change at runtime, so only load and parse it once */
+static void
+fu_plugin_acpi_facp_ensure_table (FuPlugin *plugin)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
 	g_autofree gchar *fn = NULL;
 	g_autofree gchar *path = NULL;
-	g_autoptr(FuAcpiFacp) facp = NULL;
-	g_autoptr(FwupdSecurityAttr) attr = NULL;
 	g_autoptr(GBytes) blob = NULL;
 	g_autoptr(GError) error_local = NULL;
 
-	/* create attr */
-	attr = fwupd_security_attr_new ("org.uefi.ACPI.Facp");
-	fwupd_security_attr_set_level (attr, FWUPD_SECURITY_ATTR_LEVEL_THEORETICAL);
-	fwupd_security_attr_set_name (attr, "Suspend To Idle");
-	fu_security_attrs_append (attrs, attr);
+	if (data->loaded)
+		return;
+	data->loaded = TRUE;
 
-	/* load FACP table */
 	path = fu_common_get_path (FU_PATH_KIND_ACPI_TABLES);
 	fn = g_build_filename (path, "FACP", NULL);
 	blob = fu_common_get_contents_bytes (fn, &error_local);
 	if (blob == NULL) {
 		g_warning ("failed to load %s: %s", fn, error_local->message);
-		fwupd_security_attr_set_result (attr, "Could not load FACP");
+		data->result = "Could not load FACP";
 		return;
 	}
-	facp = fu_acpi_facp_new (blob, &error_local);
-	if (facp == NULL) {
+	data->facp = fu_acpi_facp_new (blob, &error_local);
+	if (data->facp == NULL) {
 		g_warning ("failed to parse %s: %s", fn, error_local->message);
-		fwupd_security_attr_set_result (attr, "Could not parse FACP");
+		data->result = "Could not parse FACP";
+	}
+}
+
+void
+fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	g_autoptr(FwupdSecurityAttr) attr = NULL;
+
+	/* create attr */
+	attr = fwupd_security_attr_new ("org.uefi.ACPI.Facp");
+	fwupd_security_attr_set_level (attr, FWUPD_SECURITY_ATTR_LEVEL_THEORETICAL);
+	fwupd_security_attr_set_name (attr, "Suspend To Idle");
+	fu_security_attrs_append (attrs, attr);
+
+	/* load FACP table */
+	fu_plugin_acpi_facp_ensure_table (plugin);
+	if (data->facp == NULL) {
+		fwupd_security_attr_set_result (attr, data->result);
 		return;
 	}
-	if (!fu_acpi_facp_get_s2i (facp)) {
+	if (!fu_acpi_facp_get_s2i (data->facp)) {
 		fwupd_security_attr_set_result (attr, "Default set as suspend-to-ram (S3)");
 		return;
 	}
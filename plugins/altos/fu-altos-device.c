@@ -215,12 +215,12 @@ fu_altos_device_write_page (FuAltosDevice *self,
 			    guint data_len,
 			    GError **error)
 {
-	g_autofree gchar *cmd = g_strdup_printf ("W %x\n", address);
-	if (!fu_altos_device_tty_write (self, cmd, -1, error))
-		return FALSE;
-	if (!fu_altos_device_tty_write (self, (const gchar *) data, data_len, error))
-		return FALSE;
-	return TRUE;
+	g_autoptr(GString) cmd = g_string_sized_new (16 + data_len);
+
+	/* send the command and the page in one write */
+	g_string_append_printf (cmd, "W %x\n", address);
+	g_string_append_len (cmd, (const gchar *) data, data_len);
+	return fu_altos_device_tty_write (self, cmd->str, (gssize) cmd->len, error);
 }
 
 static FuFirmware *
@@ -248,7 +248,6 @@ fu_altos_device_write_firmware (FuDevice *device,
 	g_autoptr(FuDeviceLocker) locker  = NULL;
 	g_autoptr(FuFirmwareImage) img = NULL;
 	g_autoptr(GBytes) fw = NULL;
-	g_autoptr(GString) buf = g_string_new (NULL);
 
 	/* check kind */
 	if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_IS_BOOTLOADER)) {
@@ -322,7 +321,7 @@ fu_altos_device_write_firmware (FuDevice *device,
 		guint8 buf_tmp[0x100];
 
 		/* copy remaining data into buf if required */
-		memset (buf_tmp, 0xff, sizeof (buf));
+		memset (buf_tmp, 0xff, sizeof (buf_tmp));
 		if (i < data_len) {
 			gsize chunk_len = 0x100;
 			if (i + 0x100 > data_len)
@@ -367,7 +366,6 @@ fu_altos_device_write_firmware (FuDevice *device,
 
 		/* progress */
 		fu_device_set_progress_full (device, i, flash_len);
-		g_string_append_len (buf, str->str, str->len);
 	}
 
 	/* go to application mode */
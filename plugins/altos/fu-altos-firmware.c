@@ -8,6 +8,7 @@
 
 #include <gelf.h>
 #include <libelf.h>
+#include <string.h>
 
 #include "fu-altos-firmware.h"
 
@@ -22,6 +23,22 @@ G_DEFINE_TYPE (FuAltosFirmware, fu_altos_firmware, FU_TYPE_FIRMWARE)
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(Elf, elf_end);
 #pragma clang diagnostic pop
 
+static gboolean
+fu_altos_firmware_check_magic (FuFirmware *firmware, GBytes *fw, GError **error)
+{
+	gsize len = 0;
+	const guint8 *data = g_bytes_get_data (fw, &len);
+
+	if (len < SELFMAG || memcmp (data, ELFMAG, SELFMAG) != 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "not an ELF file");
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_altos_firmware_parse (FuFirmware *firmware,
 			 GBytes *blob,
@@ -109,6 +126,7 @@ static void
 fu_altos_firmware_class_init (FuAltosFirmwareClass *klass)
 {
 	FuFirmwareClass *klass_firmware = FU_FIRMWARE_CLASS (klass);
+	klass_firmware->check_magic = fu_altos_firmware_check_magic;
 	klass_firmware->parse = fu_altos_firmware_parse;
 }
 
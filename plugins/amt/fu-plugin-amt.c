@@ -91,11 +91,49 @@ mei_context_new (mei_context *ctx,
 	return TRUE;
 }
 
+/* the ME can be slow or busy, so never block forever */
+static gboolean
+mei_wait_for_response (mei_context *ctx, unsigned long timeout, GError **error)
+{
+	struct timeval tv;
+	gssize rc;
+	fd_set set;
+
+	tv.tv_sec = timeout / 1000;
+	tv.tv_usec = (timeout % 1000) * 1000;
+
+	FD_ZERO(&set);
+	FD_SET(ctx->fd, &set);
+	rc = select (ctx->fd + 1 , &set, NULL, NULL, &tv);
+	if (rc > 0 && FD_ISSET(ctx->fd, &set))
+		return TRUE;
+
+	/* timed out */
+	if (rc == 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_READ,
+			     "no response after %lums", timeout);
+		return FALSE;
+	}
+
+	/* rc < 0 */
+	g_set_error (error,
+		     FWUPD_ERROR,
+		     FWUPD_ERROR_READ,
+		     "failed on select with status %zd", rc);
+	return FALSE;
+}
+
 static gboolean
 mei_recv_msg (mei_context *ctx, guchar *buffer,
 	      gssize len, guint32 *readsz, unsigned long timeout, GError **error)
 {
 	gssize rc;
+	if (!mei_wait_for_response (ctx, timeout, error)) {
+		g_prefix_error (error, "read failed: ");
+		return FALSE;
+	}
 	rc = read (ctx->fd, buffer, len);
 	if (rc < 0) {
 		g_set_error (error,
@@ -114,13 +152,7 @@ static gboolean
 mei_send_msg (mei_context *ctx, const guchar *buffer,
 	      gssize len, unsigned long timeout, GError **error)
 {
-	struct timeval tv;
 	gssize written;
-	gssize rc;
-	fd_set set;
-
-	tv.tv_sec = timeout / 1000;
-	tv.tv_usec = (timeout % 1000) * 1000000;
 
 	written = write (ctx->fd, buffer, len);
 	if (written < 0) {
@@ -139,28 +171,11 @@ mei_send_msg (mei_context *ctx, const guchar *buffer,
 			     written, len);
 		return FALSE;
 	}
-
-	FD_ZERO(&set);
-	FD_SET(ctx->fd, &set);
-	rc = select (ctx->fd + 1 , &set, NULL, NULL, &tv);
-	if (rc > 0 && FD_ISSET(ctx->fd, &set))
-		return TRUE;
-
-	/* timed out */
-	if (rc == 0) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_WRITE,
-			     "write failed on timeout with status");
+	if (!mei_wait_for_response (ctx, timeout, error)) {
+		g_prefix_error (error, "write failed: ");
 		return FALSE;
 	}
-
-	/* rc < 0 */
-	g_set_error (error,
-		     FWUPD_ERROR,
-		     FWUPD_ERROR_WRITE,
-		     "write failed on select with status %zd", rc);
-	return FALSE;
+	return TRUE;
 }
 
 /***************************************************************************
@@ -556,6 +571,7 @@ fu_plugin_init (FuPlugin *plugin)
 {
 	fu_plugin_set_build_hash (plugin, FU_BUILD_HASH);
 	fu_plugin_alloc_data (plugin, sizeof (FuPluginData));
+	fu_plugin_add_flag (plugin, FU_PLUGIN_FLAG_THREADED_COLDPLUG);
 }
 
 gboolean
@@ -70,7 +70,9 @@ struct _FuAtaDevice {
 	guint			 pci_depth;
 	guint			 usb_depth;
 	guint16			 transfer_blocks;
+	guint16			 transfer_blocks_max;
 	guint8			 transfer_mode;
+	gboolean		 batch_mode;
 	guint32			 oui;
 	gboolean		 unknown_oui_report;
 };
@@ -89,6 +91,12 @@ fu_ata_device_get_transfer_blocks (FuAtaDevice *self)
 	return self->transfer_blocks;
 }
 
+guint16
+fu_ata_device_get_transfer_blocks_max (FuAtaDevice *self)
+{
+	return self->transfer_blocks_max;
+}
+
 void
 fu_ata_device_set_unknown_oui_report (FuAtaDevice *self, gboolean enabled)
 {
@@ -119,6 +127,8 @@ fu_ata_device_to_string (FuDevice *device, guint idt, GString *str)
 	FuAtaDevice *self = FU_ATA_DEVICE (device);
 	fu_common_string_append_kx (str, idt, "TransferMode", self->transfer_mode);
 	fu_common_string_append_kx (str, idt, "TransferBlocks", self->transfer_blocks);
+	fu_common_string_append_kx (str, idt, "TransferBlocksMax", self->transfer_blocks_max);
+	fu_common_string_append_kb (str, idt, "BatchMode", self->batch_mode);
 	if (self->oui != 0x0)
 		fu_common_string_append_kx (str, idt, "OUI", self->oui);
 	fu_common_string_append_ku (str, idt, "PciDepth", self->pci_depth);
@@ -370,6 +380,7 @@ fu_ata_device_parse_id (FuAtaDevice *self, const guint8 *buf, gsize sz, GError *
 		self->transfer_blocks = xfer_min;
 	else if (self->transfer_blocks == 0xffff)
 		self->transfer_blocks = xfer_max;
+	self->transfer_blocks_max = xfer_max;
 
 	/* get values in case the kernel didn't */
 	if (fu_device_get_serial (device) == NULL) {
@@ -719,6 +730,24 @@ fu_ata_device_fw_download (FuAtaDevice *self,
 	return FALSE;
 }
 
+/* the kernel splits nothing for SG_IO, so each command has to fit */
+static guint16
+fu_ata_device_get_transfer_blocks_batch (FuAtaDevice *self)
+{
+	const gchar *tmp;
+	guint64 max_kb;
+	guint16 blocks = self->transfer_blocks_max;
+
+	tmp = fu_udev_device_get_sysfs_attr (FU_UDEV_DEVICE (self),
+					     "queue/max_hw_sectors_kb", NULL);
+	if (tmp == NULL)
+		return MAX (self->transfer_blocks, 1);
+	max_kb = fu_common_strtoull (tmp);
+	if (max_kb * 1024 / FU_ATA_BLOCK_SIZE < blocks)
+		blocks = (guint16) (max_kb * 1024 / FU_ATA_BLOCK_SIZE);
+	return MAX (MAX (blocks, self->transfer_blocks), 1);
+}
+
 static gboolean
 fu_ata_device_write_firmware (FuDevice *device,
 			      FuFirmware *firmware,
@@ -726,8 +755,10 @@ fu_ata_device_write_firmware (FuDevice *device,
 			      GError **error)
 {
 	FuAtaDevice *self = FU_ATA_DEVICE (device);
+	guint8 transfer_mode_old = self->transfer_mode;
 	guint32 chunksz = (guint32) self->transfer_blocks * FU_ATA_BLOCK_SIZE;
 	guint max_size = 0xffff * FU_ATA_BLOCK_SIZE;
+	gboolean ret = TRUE;
 	g_autoptr(GBytes) fw = NULL;
 	g_autoptr(GPtrArray) chunks = NULL;
 
@@ -758,6 +789,17 @@ fu_ata_device_write_firmware (FuDevice *device,
 		return FALSE;
 	}
 
+	/* when updating a set of drives use the largest segment the drive
+	 * allows and never activate straight away, so that the whole set can
+	 * switch to the new firmware at the same time */
+	if (self->batch_mode &&
+	    self->transfer_mode != ATA_SUBCMD_MICROCODE_DOWNLOAD_CHUNK) {
+		self->transfer_mode = ATA_SUBCMD_MICROCODE_DOWNLOAD_CHUNKS;
+		chunksz = (guint32) fu_ata_device_get_transfer_blocks_batch (self) * FU_ATA_BLOCK_SIZE;
+		g_debug ("batch mode, using 0x%x blocks per command",
+			 chunksz / FU_ATA_BLOCK_SIZE);
+	}
+
 	/* write each block */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	chunks = fu_chunk_array_new_from_bytes (fw, 0x00, 0x00, chunksz);
@@ -770,10 +812,14 @@ fu_ata_device_write_firmware (FuDevice *device,
 						chk->data_sz,
 						error)) {
 			g_prefix_error (error, "failed to write chunk %u: ", i);
-			return FALSE;
+			ret = FALSE;
+			break;
 		}
 		fu_device_set_progress_full (device, (gsize) i, (gsize) chunks->len + 1);
 	}
+	self->transfer_mode = transfer_mode_old;
+	if (!ret)
+		return FALSE;
 
 	/* success! */
 	fu_device_add_flag (device, FWUPD_DEVICE_FLAG_NEEDS_ACTIVATION);
@@ -781,6 +827,21 @@ fu_ata_device_write_firmware (FuDevice *device,
 	return TRUE;
 }
 
+/**
+ * fu_ata_device_set_batch_mode:
+ * @self: a #FuAtaDevice
+ * @batch_mode: if the drive is being updated as part of a set
+ *
+ * Sets if the firmware should be downloaded using the maximum number of
+ * blocks for each command, with the activation deferred.
+ **/
+void
+fu_ata_device_set_batch_mode (FuAtaDevice *self, gboolean batch_mode)
+{
+	g_return_if_fail (FU_IS_ATA_DEVICE (self));
+	self->batch_mode = batch_mode;
+}
+
 static gboolean
 fu_ata_device_set_quirk_kv (FuDevice *device,
 			    const gchar *key,
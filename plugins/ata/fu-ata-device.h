@@ -14,9 +14,12 @@ G_DECLARE_FINAL_TYPE (FuAtaDevice, fu_ata_device, FU, ATA_DEVICE, FuUdevDevice)
 FuAtaDevice	*fu_ata_device_new_from_blob		(const guint8	*buf,
 							 gsize		 sz,
 							 GError		**error);
+void		 fu_ata_device_set_batch_mode		(FuAtaDevice	*self,
+							 gboolean	 batch_mode);
 
 /* for self tests */
 guint8		 fu_ata_device_get_transfer_mode	(FuAtaDevice	*self);
 guint16		 fu_ata_device_get_transfer_blocks	(FuAtaDevice	*self);
+guint16		 fu_ata_device_get_transfer_blocks_max	(FuAtaDevice	*self);
 void		 fu_ata_device_set_unknown_oui_report	(FuAtaDevice	*self,
 							 gboolean	 enabled);
@@ -26,3 +26,38 @@ fu_plugin_device_created (FuPlugin *plugin, FuDevice *dev, GError **error)
 	fu_ata_device_set_unknown_oui_report (FU_ATA_DEVICE (dev), tmp);
 	return TRUE;
 }
+
+gboolean
+fu_plugin_composite_prepare (FuPlugin *plugin,
+			     GPtrArray *devices,
+			     GError **error)
+{
+	g_autoptr(GPtrArray) devices_ata = g_ptr_array_new ();
+
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *dev = g_ptr_array_index (devices, i);
+		if (FU_IS_ATA_DEVICE (dev))
+			g_ptr_array_add (devices_ata, dev);
+	}
+	if (devices_ata->len < 2)
+		return TRUE;
+	g_debug ("using batch mode for %u drives", devices_ata->len);
+	for (guint i = 0; i < devices_ata->len; i++) {
+		FuAtaDevice *dev = g_ptr_array_index (devices_ata, i);
+		fu_ata_device_set_batch_mode (dev, TRUE);
+	}
+	return TRUE;
+}
+
+gboolean
+fu_plugin_composite_cleanup (FuPlugin *plugin,
+			     GPtrArray *devices,
+			     GError **error)
+{
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *dev = g_ptr_array_index (devices, i);
+		if (FU_IS_ATA_DEVICE (dev))
+			fu_ata_device_set_batch_mode (FU_ATA_DEVICE (dev), FALSE);
+	}
+	return TRUE;
+}
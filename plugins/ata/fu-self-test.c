@@ -59,6 +59,7 @@ fu_ata_oui_func (void)
 	g_debug ("%s", str);
 	g_assert_cmpint (fu_ata_device_get_transfer_mode (dev), ==, 0xe);
 	g_assert_cmpint (fu_ata_device_get_transfer_blocks (dev), ==, 0x1);
+	g_assert_cmpint (fu_ata_device_get_transfer_blocks_max (dev), ==, 0x800);
 	g_assert_cmpstr (fu_device_get_serial (FU_DEVICE (dev)), ==, "S3Z1NB0K862928X");
 	g_assert_cmpstr (fu_device_get_name (FU_DEVICE (dev)), ==, "SSD 860 EVO 500GB");
 	g_assert_cmpstr (fu_device_get_version (FU_DEVICE (dev)), ==, "RVT01B6Q");
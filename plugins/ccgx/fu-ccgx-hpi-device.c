@@ -44,6 +44,7 @@ G_DEFINE_TYPE (FuCcgxHpiDevice, fu_ccgx_hpi_device, FU_TYPE_USB_DEVICE)
 #define HPI_CMD_COMMAND_CLEAR_EVENT_TIME_MS	30
 #define HPI_CMD_RESET_COMPLETE_DELAY_US		150000
 #define HPI_CMD_RETRY_DELAY			30 /* ms */
+#define HPI_CMD_EVENT_POLL_DELAY_MAX_US		16000
 #define HPI_CMD_RESET_RETRY_CNT			3
 
 static void
@@ -285,8 +286,7 @@ fu_ccgx_hpi_device_i2c_read (FuCcgxHpiDevice *self,
 		return FALSE;
 	}
 
-	/* 10 msec delay */
-	g_usleep (I2C_READ_WRITE_DELAY_US);
+	/* the bridge notifies when the transaction has completed */
 	if (!fu_ccgx_hpi_device_wait_for_notify (self, NULL, error)) {
 		g_prefix_error (error, "i2c read error: ");
 		return FALSE;
@@ -329,8 +329,7 @@ fu_ccgx_hpi_device_i2c_write (FuCcgxHpiDevice *self,
 		return FALSE;
 	}
 
-	/* 10 msec delay */
-	g_usleep (I2C_READ_WRITE_DELAY_US);
+	/* the bridge notifies when the transaction has completed */
 	if (!fu_ccgx_hpi_device_wait_for_notify (self, NULL, error)) {
 		g_prefix_error (error, "i2c wait for notification error: ");
 		return FALSE;
@@ -396,7 +395,6 @@ fu_ccgx_hpi_device_reg_read_cb (FuDevice *device, gpointer user_data, GError **e
 		g_prefix_error (error, "read error: ");
 		return FALSE;
 	}
-	g_usleep (HPI_CMD_REG_READ_WRITE_DELAY_US);
 	return TRUE;
 }
 
@@ -624,6 +622,7 @@ fu_ccgx_hpi_device_wait_for_event (FuCcgxHpiDevice *self,
 				   GError **error)
 {
 	guint8 event_count = 0;
+	gulong delay_us = 1000;
 	g_autoptr(GTimer) start_time = g_timer_new ();
 	do {
 		if (!fu_ccgx_hpi_device_app_read_intr_reg (self,
@@ -634,6 +633,10 @@ fu_ccgx_hpi_device_wait_for_event (FuCcgxHpiDevice *self,
 			return FALSE;
 		if (event_count > 0)
 			return TRUE;
+
+		/* most commands complete quickly, so back off gradually */
+		g_usleep (delay_us);
+		delay_us = MIN (delay_us * 2, HPI_CMD_EVENT_POLL_DELAY_MAX_US);
 	} while (g_timer_elapsed (start_time, NULL) * 1000.f <= timeout_ms);
 
 	/* timed out */
@@ -825,9 +828,9 @@ fu_ccgx_hpi_write_flash (FuCcgxHpiDevice *self,
 		addr >> 8,
 	};
 
-	if (!fu_ccgx_hpi_device_clear_all_events (self,
-						  HPI_CMD_COMMAND_CLEAR_EVENT_TIME_MS,
-						  error))
+	/* the event for the previous row has already been read, so only
+	 * clear anything that is pending rather than waiting on each port */
+	if (!fu_ccgx_hpi_device_clear_all_events (self, 0, error))
 		return FALSE;
 
 	/* write data to memory */
@@ -880,9 +883,7 @@ fu_ccgx_hpi_read_flash (FuCcgxHpiDevice *self,
 	};
 
 	/* set address */
-	if (!fu_ccgx_hpi_device_clear_all_events (self,
-						  HPI_CMD_COMMAND_CLEAR_EVENT_TIME_MS,
-						  error))
+	if (!fu_ccgx_hpi_device_clear_all_events (self, 0, error))
 		return FALSE;
 	if (!fu_ccgx_hpi_device_reg_write (self, CY_PD_REG_FLASH_READ_WRITE_ADDR,
 					   bufhw, sizeof(bufhw), error)) {
@@ -951,7 +952,7 @@ fu_ccgx_hpi_device_detach (FuDevice *device, GError **error)
 }
 
 static gboolean
-fu_ccgx_hpi_device_attach (FuDevice *device, GError **error)
+fu_ccgx_hpi_device_activate (FuDevice *device, GError **error)
 {
 	FuCcgxHpiDevice *self = FU_CCGX_HPI_DEVICE (device);
 	guint8 buf[] = {
@@ -974,6 +975,22 @@ fu_ccgx_hpi_device_attach (FuDevice *device, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_ccgx_hpi_device_attach (FuDevice *device, GError **error)
+{
+	FuCcgxHpiDevice *self = FU_CCGX_HPI_DEVICE (device);
+
+	/* the running image is still fully functional, so only switch to the
+	 * new image when the update is activated */
+	if (self->fw_image_type == FW_IMAGE_TYPE_DUAL_SYMMETRIC &&
+	    fu_device_has_flag (device, FWUPD_DEVICE_FLAG_SKIPS_RESTART)) {
+		g_debug ("skipping reset per quirk request");
+		fu_device_add_flag (device, FWUPD_DEVICE_FLAG_NEEDS_ACTIVATION);
+		return TRUE;
+	}
+	return fu_ccgx_hpi_device_activate (device, error);
+}
+
 static FuFirmware *
 fu_ccgx_hpi_device_prepare_firmware (FuDevice *device,
 				     GBytes *fw,
@@ -1353,6 +1370,10 @@ fu_ccgx_hpi_device_setup (FuDevice *device, GError **error)
 		}
 	}
 
+	/* the other image is written while this one keeps running */
+	if (self->fw_image_type == FW_IMAGE_TYPE_DUAL_SYMMETRIC)
+		fu_device_add_flag (device, FWUPD_DEVICE_FLAG_USABLE_DURING_UPDATE);
+
 	/* not supported in boot mode */
 	if (self->fw_mode == FW_MODE_BOOT) {
 		fu_device_remove_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_UPDATABLE);
@@ -1526,6 +1547,7 @@ fu_ccgx_hpi_device_class_init (FuCcgxHpiDeviceClass *klass)
 	klass_device->prepare_firmware = fu_ccgx_hpi_device_prepare_firmware;
 	klass_device->detach = fu_ccgx_hpi_device_detach;
 	klass_device->attach = fu_ccgx_hpi_device_attach;
+	klass_device->activate = fu_ccgx_hpi_device_activate;
 	klass_device->setup = fu_ccgx_hpi_device_setup;
 	klass_device->set_quirk_kv = fu_ccgx_hpi_device_set_quirk_kv;
 	klass_usb_device->open = fu_ccgx_hpi_device_open;
@@ -358,6 +358,17 @@ ch_colorhug_device_calculate_checksum (const guint8 *data, guint32 len)
 	return checksum;
 }
 
+/* the erase sets every byte to 0xff */
+static gboolean
+fu_colorhug_device_chunk_is_erased (FuChunk *chk)
+{
+	for (guint32 i = 0; i < chk->data_sz; i++) {
+		if (chk->data[i] != 0xff)
+			return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_colorhug_device_write_firmware (FuDevice *device,
 				   FuFirmware *firmware,
@@ -388,12 +399,17 @@ fu_colorhug_device_write_firmware (FuDevice *device,
 	if (!fu_colorhug_device_erase (self, self->start_addr, g_bytes_get_size (fw), error))
 		return FALSE;
 
-	/* write each block */
+	/* write each block, skipping the ones left as erased */
 	for (guint i = 0; i < chunks->len; i++) {
 		FuChunk *chk = g_ptr_array_index (chunks, i);
 		guint8 buf[CH_FLASH_TRANSFER_BLOCK_SIZE+4];
 		g_autoptr(GError) error_local = NULL;
 
+		if (fu_colorhug_device_chunk_is_erased (chk)) {
+			fu_device_set_progress_full (device, (gsize) i, (gsize) chunks->len * 2);
+			continue;
+		}
+
 		/* set address, length, checksum, data */
 		fu_common_write_uint16 (buf + 0, chk->address, G_LITTLE_ENDIAN);
 		buf[2] = chk->data_sz;
@@ -94,7 +94,7 @@ fu_plugin_coldplug (FuPlugin *plugin, GError **error)
 	fu_device_set_vendor_id (dev, "DMI:coreboot");
 
 	for (guint i = 0; i < G_N_ELEMENTS (hwids); i++) {
-		char *str;
+		g_autofree gchar *str = NULL;
 		str = fu_plugin_get_hwid_replace_value (plugin, hwids[i], NULL);
 		if (str != NULL)
 			fu_device_add_instance_id (dev, str);
@@ -103,14 +103,14 @@ fu_plugin_coldplug (FuPlugin *plugin, GError **error)
 	bios_table = fu_plugin_get_smbios_data (plugin, FU_SMBIOS_STRUCTURE_TYPE_BIOS);
 	if (bios_table != NULL) {
 		guint32 bios_characteristics;
-		gsize len;
+		gsize len = 0;
 		const guint8 *value = g_bytes_get_data (bios_table, &len);
-		if (len >= 0x9) {
+		if (len > 0x9) {
 			gint firmware_size = (value[0x9] + 1) * 64 * 1024;
 			fu_device_set_firmware_size_max (dev, firmware_size);
 		}
 		if (len >= (0xa + sizeof(guint32))) {
-			memcpy (&bios_characteristics, &value[0xa], sizeof (guint32));
+			bios_characteristics = fu_common_read_uint32 (value + 0xa, G_LITTLE_ENDIAN);
 			/* Read the "BIOS is upgradeable (Flash)" flag */
 			if (!(bios_characteristics & (1 << 11)))
 				updatable = FALSE;
@@ -28,6 +28,8 @@ fu_plugin_coldplug (FuPlugin *plugin, GError **error)
 	gsize length;
 	g_autofree gchar *buf = NULL;
 	g_auto(GStrv) lines = NULL;
+	g_autoptr(GHashTable) packages = g_hash_table_new_full (g_str_hash, g_str_equal,
+								 g_free, NULL);
 
 	if (!g_file_get_contents ("/proc/cpuinfo", &buf, &length, error))
 		return FALSE;
@@ -38,6 +40,14 @@ fu_plugin_coldplug (FuPlugin *plugin, GError **error)
 		if (strlen (lines[i]) == 0)
 			continue;
 		dev = fu_cpu_device_new (lines[i]);
+
+		/* there is a section for every thread, but one device per package */
+		if (fu_device_get_physical_id (FU_DEVICE (dev)) != NULL) {
+			const gchar *physical_id = fu_device_get_physical_id (FU_DEVICE (dev));
+			if (g_hash_table_contains (packages, physical_id))
+				continue;
+			g_hash_table_add (packages, g_strdup (physical_id));
+		}
 		if (!fu_device_setup (FU_DEVICE (dev), error))
 			return FALSE;
 		if (fu_cpu_device_has_shstk (dev) &&
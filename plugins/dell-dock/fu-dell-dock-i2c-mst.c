@@ -53,6 +53,10 @@
 #define EEPROM_BANK_OFFSET		0x20000
 #define EEPROM_ESM_OFFSET		0x40000
 
+/* erasing normally completes well before this */
+#define MST_ERASE_SETTLE_POLL		500000	/* us */
+#define MST_ERASE_SETTLE_MAX		10
+
 /* Flash offsets */
 #define MST_BOARDID_OFFSET		0x10e
 
@@ -424,6 +428,32 @@ fu_d19_mst_check_fw (FuDevice *proxy, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_dell_dock_mst_get_bank_sum (FuDevice *proxy,
+			       const MSTBankAttributes *attribs,
+			       guint32 *bank_sum,
+			       GError **error)
+{
+	const guint8 *data;
+	g_autoptr(GBytes) csum_bytes = NULL;
+
+	if (!fu_dell_dock_mst_rc_command (proxy,
+					  MST_CMD_CHECKSUM,
+					  attribs->length, attribs->start,
+					  NULL,
+					  error))
+		return FALSE;
+	/* read result from data register */
+	if (!fu_dell_dock_mst_read_register (proxy,
+					     MST_RC_DATA_ADDR,
+					     4, &csum_bytes, error))
+		return FALSE;
+	data = g_bytes_get_data (csum_bytes, NULL);
+	*bank_sum = GUINT32_FROM_LE (data[0] | data[1] << 8 | data[2] << 16 |
+				     data[3] << 24);
+	return TRUE;
+}
+
 static gboolean
 fu_dell_dock_mst_checksum_bank (FuDevice *proxy,
 				GBytes *blob_fw,
@@ -431,7 +461,6 @@ fu_dell_dock_mst_checksum_bank (FuDevice *proxy,
 				gboolean *checksum,
 				GError **error)
 {
-	g_autoptr(GBytes) csum_bytes = NULL;
 	const MSTBankAttributes *attribs = NULL;
 	gsize length = 0;
 	const guint8 *data = g_bytes_get_data (blob_fw, &length);
@@ -460,22 +489,10 @@ fu_dell_dock_mst_checksum_bank (FuDevice *proxy,
 	g_debug ("MST: Payload checksum: 0x%x", payload_sum);
 
 	/* checksum the bank */
-	if (!fu_dell_dock_mst_rc_command (proxy,
-					  MST_CMD_CHECKSUM,
-					  attribs->length, attribs->start,
-					  NULL,
-					  error)) {
+	if (!fu_dell_dock_mst_get_bank_sum (proxy, attribs, &bank_sum, error)) {
 		g_prefix_error (error, "Failed to checksum bank %u: ", bank);
 		return FALSE;
 	}
-	/* read result from data register */
-	if (!fu_dell_dock_mst_read_register (proxy,
-					     MST_RC_DATA_ADDR,
-					     4, &csum_bytes, error))
-		return FALSE;
-	data = g_bytes_get_data (csum_bytes, NULL);
-	bank_sum = GUINT32_FROM_LE (data[0] | data[1] << 8 | data[2] << 16 |
-				    data[3] << 24);
 	g_debug ("MST: Bank %u checksum: 0x%x", bank, bank_sum);
 
 	*checksum = (bank_sum == payload_sum);
@@ -506,8 +523,24 @@ fu_dell_dock_mst_erase_bank (FuDevice *proxy, MSTBank bank, GError **error)
 			return FALSE;
 		}
 	}
+
+	/* an erased bank is all 0xff, so poll the checksum rather than
+	 * always waiting for the worst case */
 	g_debug ("MST: Waiting for flash clear to settle");
-	g_usleep (5000000);
+	for (guint i = 0; i < MST_ERASE_SETTLE_MAX; i++) {
+		guint32 bank_sum = 0;
+		g_usleep (MST_ERASE_SETTLE_POLL);
+		if (!fu_dell_dock_mst_get_bank_sum (proxy, attribs, &bank_sum, error)) {
+			g_prefix_error (error, "Failed to checksum bank %u: ", bank);
+			return FALSE;
+		}
+		if (bank_sum == (guint32) (attribs->length * 0xff)) {
+			g_debug ("MST: Flash clear after %ums",
+				 (i + 1) * MST_ERASE_SETTLE_POLL / 1000);
+			return TRUE;
+		}
+	}
+	g_debug ("MST: Flash clear did not settle, continuing anyway");
 
 	return TRUE;
 }
@@ -687,7 +687,7 @@ fu_plugin_dell_detect_tpm (FuPlugin *plugin, GError **error)
 		return FALSE;
 	}
 
-	system_id = fu_dell_get_system_id (plugin);
+	system_id = data->system_id;
 	if (data->smi_obj->fake_smbios)
 		can_switch_modes = data->can_switch_modes;
 	else if (system_id == 0)
@@ -792,6 +792,8 @@ fu_plugin_dell_detect_tpm (FuPlugin *plugin, GError **error)
 void
 fu_plugin_device_registered (FuPlugin *plugin, FuDevice *device)
 {
+	FuPluginData *data = fu_plugin_get_data (plugin);
+
 	/* thunderbolt plugin */
 	if (g_strcmp0 (fu_device_get_plugin (device), "thunderbolt") == 0 &&
 	    fu_device_has_flag (device, FWUPD_DEVICE_FLAG_INTERNAL)) {
@@ -799,15 +801,13 @@ fu_plugin_device_registered (FuPlugin *plugin, FuDevice *device)
 		if (fu_device_get_metadata_boolean (device, FU_DEVICE_METADATA_TBT_IS_SAFE_MODE)) {
 			g_autofree gchar *vendor_id = NULL;
 			g_autofree gchar *device_id = NULL;
-			guint16 system_id = 0;
 
 			vendor_id = g_strdup ("TBT:0x00D4");
-			system_id = fu_dell_get_system_id (plugin);
-			if (system_id == 0)
+			if (data->system_id == 0)
 				return;
 			/* the kernel returns lowercase in sysfs, need to match it */
 			device_id = g_strdup_printf ("TBT-%04x%04x", 0x00d4u,
-						     (unsigned) system_id);
+						     (unsigned) data->system_id);
 			fu_device_set_vendor_id (device, vendor_id);
 			fu_device_add_instance_id (device, device_id);
 			fu_device_add_flag (device, FWUPD_DEVICE_FLAG_UPDATABLE);
@@ -885,6 +885,9 @@ fu_plugin_startup (FuPlugin *plugin, GError **error)
 		return FALSE;
 	}
 
+	/* this may need a SMI, so only look it up once */
+	data->system_id = fu_dell_get_system_id (plugin);
+
 	/* If ESRT is not turned on, fwupd will have already created an
 	 * unlock device.
 	 *
@@ -13,6 +13,7 @@ struct FuPluginData {
 	FuDellSmiObj		*smi_obj;
 	guint16			fake_vid;
 	guint16			fake_pid;
+	guint16			system_id;
 	gboolean		can_switch_modes;
 	gboolean		capsule_supported;
 };
@@ -33,6 +33,7 @@
  * * `attach-upload-download`:	An upload or download is required for attach
  * * `force-dfu-mode`:		Force DFU mode
  * * `ignore-polltimeout`:	Ignore the device download timeout
+ * * `adaptive-polltimeout`:	Poll using the measured latency, not the download timeout
  * * `ignore-runtime`:		Device has broken DFU runtime support
  * * `ignore-upload`:		Uploading from the device is broken
  * * `no-dfu-runtime`:		No DFU runtime interface is provided
@@ -44,6 +45,7 @@
  * * `legacy-protocol`:		Use a legacy protocol version
  * * `detach-for-attach`:	Requires a DFU_REQUEST_DETACH to attach
  * * `absent-sector-size`:	In absence of sector size, assume byte
+ * * `skip-unchanged`:		Read back and only write the DfuSe sectors that differ
  *
  * Default value: `none`
  *
@@ -97,6 +99,7 @@ typedef struct {
 	guint16			 transfer_size;
 	guint8			 iface_number;
 	guint			 dnload_timeout;
+	guint			 poll_latency;	/* ms */
 	guint			 timeout_ms;
 } DfuDevicePrivate;
 
@@ -124,6 +127,8 @@ dfu_device_to_string (FuDevice *device, guint idt, GString *str)
 	fu_common_string_append_kx (str, idt, "TransferSize", priv->transfer_size);
 	fu_common_string_append_kx (str, idt, "IfaceNumber", priv->iface_number);
 	fu_common_string_append_kx (str, idt, "DnloadTimeout", priv->dnload_timeout);
+	if (priv->poll_latency > 0)
+		fu_common_string_append_kx (str, idt, "PollLatency", priv->poll_latency);
 	fu_common_string_append_kx (str, idt, "TimeoutMs", priv->timeout_ms);
 }
 
@@ -175,6 +180,38 @@ dfu_device_get_download_timeout (DfuDevice *device)
 	return priv->dnload_timeout;
 }
 
+/**
+ * dfu_device_get_poll_latency:
+ * @device: a #DfuDevice
+ *
+ * Gets the time the device has been measured to take to finish a download
+ * block, which may be much less than the download timeout it reports.
+ *
+ * Return value: latency in ms, or 0 for unknown
+ **/
+guint
+dfu_device_get_poll_latency (DfuDevice *device)
+{
+	DfuDevicePrivate *priv = GET_PRIVATE (device);
+	g_return_val_if_fail (DFU_IS_DEVICE (device), 0);
+	return priv->poll_latency;
+}
+
+/**
+ * dfu_device_set_poll_latency:
+ * @device: a #DfuDevice
+ * @poll_latency: latency in ms
+ *
+ * Sets the time the device takes to finish a download block.
+ **/
+void
+dfu_device_set_poll_latency (DfuDevice *device, guint poll_latency)
+{
+	DfuDevicePrivate *priv = GET_PRIVATE (device);
+	g_return_if_fail (DFU_IS_DEVICE (device));
+	priv->poll_latency = poll_latency;
+}
+
 /**
  * dfu_device_set_transfer_size:
  * @device: a #GUsbDevice
@@ -1611,6 +1648,8 @@ dfu_device_download (DfuDevice *device,
 		/* download onto target */
 		if (flags & DFU_TARGET_TRANSFER_FLAG_VERIFY)
 			flags_local = DFU_TARGET_TRANSFER_FLAG_VERIFY;
+		if (flags & DFU_TARGET_TRANSFER_FLAG_SKIP_UNCHANGED)
+			flags_local |= DFU_TARGET_TRANSFER_FLAG_SKIP_UNCHANGED;
 		if (dfu_firmware_get_format (firmware) == DFU_FIRMWARE_FORMAT_RAW)
 			flags_local |= DFU_TARGET_TRANSFER_FLAG_ADDR_HEURISTIC;
 		id1 = g_signal_connect (target_tmp, "percentage-changed",
@@ -1718,6 +1757,8 @@ dfu_device_write_firmware (FuDevice *device,
 		transfer_flags |= DFU_TARGET_TRANSFER_FLAG_WILDCARD_VID;
 		transfer_flags |= DFU_TARGET_TRANSFER_FLAG_WILDCARD_PID;
 	}
+	if (fu_device_has_custom_flag (device, "skip-unchanged"))
+		transfer_flags |= DFU_TARGET_TRANSFER_FLAG_SKIP_UNCHANGED;
 
 	/* hit hardware */
 	dfu_firmware = dfu_firmware_new ();
@@ -1759,6 +1800,18 @@ dfu_device_set_quirk_kv (FuDevice *device,
 				     "invalid DFU timeout");
 		return FALSE;
 	}
+	if (g_strcmp0 (key, "DfuPollLatency") == 0) {
+		guint64 tmp = fu_common_strtoull (value);
+		if (tmp < G_MAXUINT) {
+			priv->poll_latency = tmp;
+			return TRUE;
+		}
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "invalid DFU poll latency");
+		return FALSE;
+	}
 
 	/* failed */
 	g_set_error_literal (error,
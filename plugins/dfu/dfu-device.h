@@ -96,6 +96,9 @@ void		 dfu_device_set_timeout			(DfuDevice	*device,
 void		 dfu_device_error_fixup			(DfuDevice	*device,
 							 GError		**error);
 guint		 dfu_device_get_download_timeout	(DfuDevice	*device);
+guint		 dfu_device_get_poll_latency		(DfuDevice	*device);
+void		 dfu_device_set_poll_latency		(DfuDevice	*device,
+							 guint		 poll_latency);
 gchar		*dfu_device_get_attributes_as_string	(DfuDevice	*device);
 gboolean	 dfu_device_ensure_interface		(DfuDevice	*device,
 							 GError		**error);
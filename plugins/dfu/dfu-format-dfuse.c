@@ -24,22 +24,26 @@ typedef struct __attribute__((packed)) {
 
 /**
  * dfu_element_from_dfuse: (skip)
- * @data: data buffer
+ * @bytes: the DfuSe file
+ * @offset: offset into @bytes of the element
  * @length: length of @data we can access
  * @consumed: (out): the number of bytes we consued
  * @error: a #GError, or %NULL
  *
- * Unpacks an element from DfuSe data.
+ * Unpacks an element from DfuSe data. The element contents reference
+ * @bytes rather than copying the payload.
  *
  * Returns: a #DfuElement, or %NULL for error
  **/
 static DfuElement *
-dfu_element_from_dfuse (const guint8 *data,
+dfu_element_from_dfuse (GBytes *bytes,
+			guint32 offset,
 			guint32 length,
 			guint32 *consumed,
 			GError **error)
 {
 	DfuElement *element = NULL;
+	const guint8 *data = (const guint8 *) g_bytes_get_data (bytes, NULL) + offset;
 	DfuSeElementPrefix *el = (DfuSeElementPrefix *) data;
 	guint32 size;
 	g_autoptr(GBytes) contents = NULL;
@@ -71,7 +75,7 @@ dfu_element_from_dfuse (const guint8 *data,
 	/* create new element */
 	element = dfu_element_new ();
 	dfu_element_set_address (element, GUINT32_FROM_LE (el->address));
-	contents = g_bytes_new (data + sizeof(DfuSeElementPrefix), size);
+	contents = g_bytes_new_from_bytes (bytes, offset + sizeof(DfuSeElementPrefix), size);
 	dfu_element_set_contents (element, contents);
 
 	/* return size */
@@ -119,7 +123,8 @@ typedef struct __attribute__((packed)) {
 
 /**
  * dfu_image_from_dfuse: (skip)
- * @data: data buffer
+ * @bytes: the DfuSe file
+ * @offset_image: offset into @bytes of the image
  * @length: length of @data we can access
  * @consumed: (out): the number of bytes we consued
  * @error: a #GError, or %NULL
@@ -129,11 +134,13 @@ typedef struct __attribute__((packed)) {
  * Returns: a #DfuImage, or %NULL for error
  **/
 static DfuImage *
-dfu_image_from_dfuse (const guint8 *data,
+dfu_image_from_dfuse (GBytes *bytes,
+		      guint32 offset_image,
 		      guint32 length,
 		      guint32 *consumed,
 		      GError **error)
 {
+	const guint8 *data = (const guint8 *) g_bytes_get_data (bytes, NULL) + offset_image;
 	DfuSeImagePrefix *im;
 	guint32 elements;
 	guint32 offset = sizeof(DfuSeImagePrefix);
@@ -173,7 +180,7 @@ dfu_image_from_dfuse (const guint8 *data,
 	for (guint j = 0; j < elements; j++) {
 		guint32 consumed_local;
 		g_autoptr(DfuElement) element = NULL;
-		element = dfu_element_from_dfuse (data + offset, length,
+		element = dfu_element_from_dfuse (bytes, offset_image + offset, length,
 						  &consumed_local, error);
 		if (element == NULL)
 			return NULL;
@@ -316,7 +323,8 @@ dfu_firmware_to_dfuse (DfuFirmware *firmware, GError **error)
 	}
 
 	/* return blob */
-	return g_bytes_new (buf, sizeof (DfuSePrefix) + image_size_total);
+	return g_bytes_new_take (g_steal_pointer (&buf),
+				 sizeof (DfuSePrefix) + image_size_total);
 }
 
 /**
@@ -380,7 +388,7 @@ dfu_firmware_from_dfuse (DfuFirmware *firmware,
 	for (guint i = 0; i < prefix->targets; i++) {
 		guint consumed;
 		g_autoptr(DfuImage) image = NULL;
-		image = dfu_image_from_dfuse (data + offset, (guint32) len,
+		image = dfu_image_from_dfuse (bytes, offset, (guint32) len,
 					      &consumed, error);
 		if (image == NULL)
 			return FALSE;
@@ -234,6 +234,48 @@ dfu_target_stm_erase_address (DfuTarget *target, guint32 address, GError **error
 	return dfu_target_check_status (target, error);
 }
 
+/* reads back the part of the sector covered by the element and compares it
+ * with the new contents */
+static gboolean
+dfu_target_stm_sector_is_unchanged (DfuTarget *target,
+				    DfuSector *sector,
+				    DfuElement *element,
+				    gboolean *unchanged,
+				    GError **error)
+{
+	GBytes *bytes = dfu_element_get_contents (element);
+	GBytes *bytes_dev;
+	guint32 addr_start;
+	guint32 addr_end;
+	g_autoptr(DfuElement) element_dev = NULL;
+	g_autoptr(GBytes) bytes_new = NULL;
+
+	*unchanged = FALSE;
+	if (!dfu_sector_has_cap (sector, DFU_SECTOR_CAP_READABLE))
+		return TRUE;
+	addr_start = MAX (dfu_sector_get_address (sector),
+			  dfu_element_get_address (element));
+	addr_end = MIN (dfu_sector_get_address (sector) + dfu_sector_get_size (sector),
+			dfu_element_get_address (element) + g_bytes_get_size (bytes));
+	if (addr_end <= addr_start)
+		return TRUE;
+	element_dev = dfu_target_stm_upload_element (target, addr_start,
+						     addr_end - addr_start,
+						     addr_end - addr_start,
+						     error);
+	if (element_dev == NULL) {
+		g_prefix_error (error, "failed to read back sector 0x%04x: ",
+				dfu_sector_get_address (sector));
+		return FALSE;
+	}
+	bytes_dev = dfu_element_get_contents (element_dev);
+	bytes_new = g_bytes_new_from_bytes (bytes,
+					    addr_start - dfu_element_get_address (element),
+					    addr_end - addr_start);
+	*unchanged = g_bytes_equal (bytes_dev, bytes_new);
+	return TRUE;
+}
+
 static gboolean
 dfu_target_stm_download_element (DfuTarget *target,
 				 DfuElement *element,
@@ -248,6 +290,7 @@ dfu_target_stm_download_element (DfuTarget *target,
 	guint16 transfer_size = dfu_device_get_transfer_size (device);
 	g_autoptr(GPtrArray) sectors_array = NULL;
 	g_autoptr(GHashTable) sectors_hash = NULL;
+	g_autoptr(GHashTable) sectors_unchanged = NULL;
 
 	/* round up as we have to transfer incomplete blocks */
 	bytes = dfu_element_get_contents (element);
@@ -301,10 +344,50 @@ dfu_target_stm_download_element (DfuTarget *target,
 		}
 	}
 
+	/* optional: find the sectors that already have the new contents; this
+	 * only works if no chunk is written across a sector boundary */
+	sectors_unchanged = g_hash_table_new (g_direct_hash, g_direct_equal);
+	if (flags & DFU_TARGET_TRANSFER_FLAG_SKIP_UNCHANGED) {
+		for (guint i = 0; i < nr_chunks; i++) {
+			guint32 offset = i * transfer_size;
+			guint32 offset_dev = dfu_element_get_address (element) + offset;
+			gsize length = MIN (g_bytes_get_size (bytes) - offset, transfer_size);
+			if (dfu_target_get_sector_for_addr (target, offset_dev) !=
+			    dfu_target_get_sector_for_addr (target, offset_dev + length - 1)) {
+				g_debug ("chunk at 0x%04x spans sectors, writing all",
+					 (guint) offset_dev);
+				flags &= ~DFU_TARGET_TRANSFER_FLAG_SKIP_UNCHANGED;
+				break;
+			}
+		}
+	}
+	if (flags & DFU_TARGET_TRANSFER_FLAG_SKIP_UNCHANGED) {
+		g_autoptr(GHashTable) sectors_checked = NULL;
+		sectors_checked = g_hash_table_new (g_direct_hash, g_direct_equal);
+		for (guint i = 0; i < nr_chunks; i++) {
+			guint32 offset_dev = dfu_element_get_address (element) + (i * transfer_size);
+			gboolean unchanged = FALSE;
+			sector = dfu_target_get_sector_for_addr (target, offset_dev);
+			if (g_hash_table_contains (sectors_checked, sector))
+				continue;
+			g_hash_table_add (sectors_checked, sector);
+			if (!dfu_target_stm_sector_is_unchanged (target, sector, element,
+								 &unchanged, error))
+				return FALSE;
+			if (unchanged) {
+				g_debug ("sector 0x%04x is unchanged, skipping",
+					 dfu_sector_get_address (sector));
+				g_hash_table_add (sectors_unchanged, sector);
+			}
+		}
+	}
+
 	/* 2nd pass: actually erase sectors */
 	dfu_target_set_action (target, FWUPD_STATUS_DEVICE_ERASE);
 	for (guint i = 0; i < sectors_array->len; i++) {
 		sector = g_ptr_array_index (sectors_array, i);
+		if (g_hash_table_contains (sectors_unchanged, sector))
+			continue;
 		g_debug ("erasing sector at 0x%04x",
 			 dfu_sector_get_address (sector));
 		if (!dfu_target_stm_erase_address (target,
@@ -332,6 +415,12 @@ dfu_target_stm_download_element (DfuTarget *target,
 		sector = dfu_target_get_sector_for_addr (target, offset_dev);
 		g_assert (sector != NULL);
 
+		/* the block number sets the address, so just leave a gap */
+		if (g_hash_table_contains (sectors_unchanged, sector)) {
+			dfu_target_set_percentage (target, offset, g_bytes_get_size (bytes));
+			continue;
+		}
+
 		/* manually set the sector address */
 		if (dfu_sector_get_zone (sector) != zone_last) {
 			g_debug ("setting address to 0x%04x",
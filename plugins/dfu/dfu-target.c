@@ -28,6 +28,8 @@
 #include "dfu-sector.h"
 #include "dfu-target-private.h"
 
+#include "fu-common.h"
+
 #include "fwupd-error.h"
 
 static void dfu_target_finalize			 (GObject *object);
@@ -55,6 +57,8 @@ static guint signals [SIGNAL_LAST] = { 0 };
 G_DEFINE_TYPE_WITH_PRIVATE (DfuTarget, dfu_target, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (dfu_target_get_instance_private (o))
 
+#define DFU_TARGET_POLL_STEPS	8
+
 static void
 dfu_target_class_init (DfuTargetClass *klass)
 {
@@ -673,6 +677,50 @@ dfu_target_mass_erase (DfuTarget *target, GError **error)
 	return klass->mass_erase (target, error);
 }
 
+/* poll the status from the latency measured on earlier blocks rather than
+ * sleeping for the worst-case bwPollTimeout, which some bootloaders set to
+ * many times the real write time */
+static gboolean
+dfu_target_download_chunk_wait (DfuTarget *target, GError **error)
+{
+	DfuTargetPrivate *priv = GET_PRIVATE (target);
+	guint budget = dfu_device_get_download_timeout (priv->device);
+	guint latency = dfu_device_get_poll_latency (priv->device);
+	guint step = MAX (budget / DFU_TARGET_POLL_STEPS, 1);
+	guint elapsed;
+	gboolean busy = FALSE;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* nothing measured yet, so start with a fraction of the timeout */
+	if (latency == 0)
+		latency = step;
+	g_usleep (MIN (latency, budget) * 1000);
+	if (!dfu_device_refresh (priv->device, error))
+		return FALSE;
+
+	/* still writing, so poll more often until the timeout has passed */
+	while (dfu_device_get_state (priv->device) == DFU_STATE_DFU_DNBUSY) {
+		if (g_timer_elapsed (timer, NULL) * 1000.f >= budget)
+			break;
+		g_usleep (step * 1000);
+		if (!dfu_device_refresh (priv->device, error))
+			return FALSE;
+		busy = TRUE;
+	}
+
+	/* smooth the measurement so one slow erase does not slow every block,
+	 * and if the block was already done then try a little shorter next time */
+	elapsed = (guint) (g_timer_elapsed (timer, NULL) * 1000.f);
+	if (busy)
+		latency = (latency * 3 + elapsed) / 4;
+	else
+		latency -= latency / DFU_TARGET_POLL_STEPS;
+	dfu_device_set_poll_latency (priv->device, MAX (latency, 1));
+	g_debug ("block written in %ums, poll latency now %ums of %ums",
+		 elapsed, dfu_device_get_poll_latency (priv->device), budget);
+	return TRUE;
+}
+
 gboolean
 dfu_target_download_chunk (DfuTarget *target, guint16 index, GBytes *bytes, GError **error)
 {
@@ -724,15 +772,21 @@ dfu_target_download_chunk (DfuTarget *target, guint16 index, GBytes *bytes, GErr
 		dfu_target_set_action (target, FWUPD_STATUS_IDLE);
 		dfu_target_set_action (target, FWUPD_STATUS_DEVICE_BUSY);
 	}
-	if (dfu_device_get_download_timeout (priv->device) > 0) {
-		g_debug ("sleeping for %ums…",
-			 dfu_device_get_download_timeout (priv->device));
-		g_usleep (dfu_device_get_download_timeout (priv->device) * 1000);
-	}
+	if (fu_device_has_custom_flag (FU_DEVICE (priv->device), "adaptive-polltimeout") &&
+	    dfu_device_get_download_timeout (priv->device) > 0) {
+		if (!dfu_target_download_chunk_wait (target, error))
+			return FALSE;
+	} else {
+		if (dfu_device_get_download_timeout (priv->device) > 0) {
+			g_debug ("sleeping for %ums…",
+				 dfu_device_get_download_timeout (priv->device));
+			g_usleep (dfu_device_get_download_timeout (priv->device) * 1000);
+		}
 
-	/* find out if the write was successful */
-	if (!dfu_device_refresh (priv->device, error))
-		return FALSE;
+		/* find out if the write was successful */
+		if (!dfu_device_refresh (priv->device, error))
+			return FALSE;
+	}
 
 	g_assert (actual_length == g_bytes_get_size (bytes));
 	return TRUE;
@@ -1070,34 +1124,6 @@ dfu_target_upload (DfuTarget *target,
 	return g_object_ref (image);
 }
 
-static gchar *
-_g_bytes_compare_verbose (GBytes *bytes1, GBytes *bytes2)
-{
-	const guint8 *data1;
-	const guint8 *data2;
-	gsize length1;
-	gsize length2;
-
-	data1 = g_bytes_get_data (bytes1, &length1);
-	data2 = g_bytes_get_data (bytes2, &length2);
-
-	/* not the same length */
-	if (length1 != length2) {
-		return g_strdup_printf ("got %" G_GSIZE_FORMAT " bytes, "
-					"expected %" G_GSIZE_FORMAT,
-					length1, length2);
-	}
-
-	/* return 00 01 02 03 */
-	for (guint i = 0; i < length1; i++) {
-		if (data1[i] != data2[i]) {
-			return g_strdup_printf ("got 0x%02x, expected 0x%02x @ 0x%04x",
-						data1[i], data2[i], i);
-		}
-	}
-	return NULL;
-}
-
 static gboolean
 dfu_target_download_element_dfu (DfuTarget *target,
 				 DfuElement *element,
@@ -1182,6 +1208,7 @@ dfu_target_download_element (DfuTarget *target,
 		GBytes *bytes;
 		GBytes *bytes_tmp;
 		g_autoptr(DfuElement) element_tmp = NULL;
+		g_autoptr(GError) error_local = NULL;
 		dfu_target_set_action (target, FWUPD_STATUS_DEVICE_VERIFY);
 		bytes = dfu_element_get_contents (element);
 		element_tmp = dfu_target_upload_element (target,
@@ -1192,14 +1219,12 @@ dfu_target_download_element (DfuTarget *target,
 		if (element_tmp == NULL)
 			return FALSE;
 		bytes_tmp = dfu_element_get_contents (element_tmp);
-		if (g_bytes_compare (bytes_tmp, bytes) != 0) {
-			g_autofree gchar *bytes_cmp_str = NULL;
-			bytes_cmp_str = _g_bytes_compare_verbose (bytes_tmp, bytes);
+		if (!fu_common_bytes_compare (bytes_tmp, bytes, &error_local)) {
 			g_set_error (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_READ,
 				     "verify failed: %s",
-				     bytes_cmp_str);
+				     error_local->message);
 			return FALSE;
 		}
 		dfu_target_set_action (target, FWUPD_STATUS_IDLE);
@@ -1208,6 +1233,93 @@ dfu_target_download_element (DfuTarget *target,
 	return TRUE;
 }
 
+static gint
+dfu_target_element_sort_cb (gconstpointer a, gconstpointer b)
+{
+	DfuElement *element1 = *((DfuElement **) a);
+	DfuElement *element2 = *((DfuElement **) b);
+	guint32 addr1 = dfu_element_get_address (element1);
+	guint32 addr2 = dfu_element_get_address (element2);
+	if (addr1 < addr2)
+		return -1;
+	if (addr1 > addr2)
+		return 1;
+	return 0;
+}
+
+/* the gap is only filled if it is in a sector that is going to be erased */
+static gboolean
+dfu_target_can_coalesce (DfuTarget *target, guint32 addr_end, guint32 addr)
+{
+	DfuSector *sector;
+	if (addr == addr_end)
+		return TRUE;
+	if (addr < addr_end || addr_end == 0)
+		return FALSE;
+	sector = dfu_target_get_sector_for_addr (target, addr_end - 1);
+	if (sector == NULL || !dfu_sector_has_cap (sector, DFU_SECTOR_CAP_ERASEABLE))
+		return FALSE;
+	return sector == dfu_target_get_sector_for_addr (target, addr - 1);
+}
+
+static DfuElement *
+dfu_target_element_new_run (guint32 addr, GByteArray *buf)
+{
+	DfuElement *element = dfu_element_new ();
+	g_autoptr(GBytes) blob = g_bytes_new (buf->data, buf->len);
+	dfu_element_set_address (element, addr);
+	dfu_element_set_contents (element, blob);
+	return element;
+}
+
+/* merge elements that are next to each other, or only have a gap inside one
+ * sector, so that each sector is erased once and the writes can use the
+ * full transfer size across the element boundaries */
+static GPtrArray *
+dfu_target_coalesce_elements (DfuTarget *target, GPtrArray *elements)
+{
+	guint32 addr_run = 0;
+	GPtrArray *runs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	g_autoptr(GByteArray) buf = NULL;
+	g_autoptr(GPtrArray) sorted = g_ptr_array_new ();
+
+	for (guint i = 0; i < elements->len; i++)
+		g_ptr_array_add (sorted, g_ptr_array_index (elements, i));
+	g_ptr_array_sort (sorted, dfu_target_element_sort_cb);
+	for (guint i = 0; i < sorted->len; i++) {
+		DfuElement *element = g_ptr_array_index (sorted, i);
+		GBytes *blob = dfu_element_get_contents (element);
+		guint32 addr = dfu_element_get_address (element);
+		gsize sz = 0;
+		const guint8 *data = g_bytes_get_data (blob, &sz);
+
+		if (buf != NULL &&
+		    !dfu_target_can_coalesce (target, addr_run + buf->len, addr)) {
+			g_ptr_array_add (runs, dfu_target_element_new_run (addr_run, buf));
+			g_clear_pointer (&buf, g_byte_array_unref);
+		}
+		if (buf == NULL) {
+			buf = g_byte_array_new ();
+			addr_run = addr;
+		}
+
+		/* the sector is erased anyway */
+		if (addr > addr_run + buf->len) {
+			guint len_old = buf->len;
+			g_byte_array_set_size (buf, addr - addr_run);
+			memset (buf->data + len_old, 0xff, buf->len - len_old);
+		}
+		g_byte_array_append (buf, data, sz);
+	}
+	if (buf != NULL)
+		g_ptr_array_add (runs, dfu_target_element_new_run (addr_run, buf));
+	if (runs->len != elements->len) {
+		g_debug ("coalesced %u elements into %u runs",
+			 elements->len, runs->len);
+	}
+	return runs;
+}
+
 /**
  * dfu_target_download:
  * @target: a #DfuTarget
@@ -1227,6 +1339,7 @@ dfu_target_download (DfuTarget *target, DfuImage *image,
 	DfuTargetPrivate *priv = GET_PRIVATE (target);
 	GPtrArray *elements;
 	gboolean ret;
+	g_autoptr(GPtrArray) runs = NULL;
 
 	g_return_val_if_fail (DFU_IS_TARGET (target), FALSE);
 	g_return_val_if_fail (DFU_IS_IMAGE (image), FALSE);
@@ -1258,8 +1371,14 @@ dfu_target_download (DfuTarget *target, DfuImage *image,
 				     "no image elements");
 		return FALSE;
 	}
+
+	/* DfuSe targets have a sector map, so use as few runs as possible */
+	if (elements->len > 1 && priv->sectors->len > 0) {
+		runs = dfu_target_coalesce_elements (target, elements);
+		elements = runs;
+	}
 	for (guint i = 0; i < elements->len; i++) {
-		DfuElement *element = dfu_image_get_element (image, (guint8) i);
+		DfuElement *element = g_ptr_array_index (elements, i);
 		g_debug ("downloading element at 0x%04x",
 			 dfu_element_get_address (element));
 
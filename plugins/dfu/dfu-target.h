@@ -26,6 +26,7 @@ G_DECLARE_DERIVABLE_TYPE (DfuTarget, dfu_target, DFU, TARGET, GUsbDevice)
  * @DFU_TARGET_TRANSFER_FLAG_WILDCARD_VID:	Allow downloading images with wildcard VIDs
  * @DFU_TARGET_TRANSFER_FLAG_WILDCARD_PID:	Allow downloading images with wildcard PIDs
  * @DFU_TARGET_TRANSFER_FLAG_ADDR_HEURISTIC:	Automatically detect the address to use
+ * @DFU_TARGET_TRANSFER_FLAG_SKIP_UNCHANGED:	Do not erase or write sectors that already match
  *
  * The optional flags used for transferring firmware.
  **/
@@ -35,6 +36,7 @@ typedef enum {
 	DFU_TARGET_TRANSFER_FLAG_WILDCARD_VID	= (1 << 4),
 	DFU_TARGET_TRANSFER_FLAG_WILDCARD_PID	= (1 << 5),
 	DFU_TARGET_TRANSFER_FLAG_ADDR_HEURISTIC	= (1 << 7),
+	DFU_TARGET_TRANSFER_FLAG_SKIP_UNCHANGED	= (1 << 8),
 	/*< private >*/
 	DFU_TARGET_TRANSFER_FLAG_LAST
 } DfuTargetTransferFlags;
@@ -25,6 +25,7 @@ typedef struct {
 	GCancellable		*cancellable;
 	GPtrArray		*cmd_array;
 	gboolean		 force;
+	gboolean		 all;
 	gchar			*device_vid_pid;
 	guint16			 transfer_size;
 	FuQuirks		*quirks;
@@ -178,6 +179,41 @@ dfu_tool_run (DfuToolPrivate *priv,
 	return FALSE;
 }
 
+static gboolean
+dfu_tool_parse_vid_pid (DfuToolPrivate *priv, guint16 *vid, guint16 *pid, GError **error)
+{
+	gchar *tmp;
+	guint64 pid_tmp;
+	guint64 vid_tmp;
+
+	vid_tmp = g_ascii_strtoull (priv->device_vid_pid, &tmp, 16);
+	if (vid_tmp == 0 || vid_tmp > G_MAXUINT16) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "Invalid format of VID:PID");
+		return FALSE;
+	}
+	if (tmp[0] != ':') {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "Invalid format of VID:PID");
+		return FALSE;
+	}
+	pid_tmp = g_ascii_strtoull (tmp + 1, NULL, 16);
+	if (pid_tmp == 0 || pid_tmp > G_MAXUINT16) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "Invalid format of VID:PID");
+		return FALSE;
+	}
+	*vid = (guint16) vid_tmp;
+	*pid = (guint16) pid_tmp;
+	return TRUE;
+}
+
 static DfuDevice *
 dfu_tool_get_default_device (DfuToolPrivate *priv, GError **error)
 {
@@ -192,42 +228,17 @@ dfu_tool_get_default_device (DfuToolPrivate *priv, GError **error)
 
 	/* we specified it manually */
 	if (priv->device_vid_pid != NULL) {
-		gchar *tmp;
-		guint64 pid;
-		guint64 vid;
+		guint16 pid = 0;
+		guint16 vid = 0;
 		g_autoptr(DfuDevice) device = NULL;
 		g_autoptr(GUsbDevice) usb_device = NULL;
 
 		/* parse */
-		vid = g_ascii_strtoull (priv->device_vid_pid, &tmp, 16);
-		if (vid == 0 || vid > G_MAXUINT16) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_INTERNAL,
-					     "Invalid format of VID:PID");
+		if (!dfu_tool_parse_vid_pid (priv, &vid, &pid, error))
 			return NULL;
-		}
-		if (tmp[0] != ':') {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_INTERNAL,
-					     "Invalid format of VID:PID");
-			return NULL;
-		}
-		pid = g_ascii_strtoull (tmp + 1, NULL, 16);
-		if (pid == 0 || pid > G_MAXUINT16) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_INTERNAL,
-					     "Invalid format of VID:PID");
-			return NULL;
-		}
 
 		/* find device */
-		usb_device = g_usb_context_find_by_vid_pid (usb_context,
-							    (guint16) vid,
-							    (guint16) pid,
-							    error);
+		usb_device = g_usb_context_find_by_vid_pid (usb_context, vid, pid, error);
 		if (usb_device == NULL) {
 			g_set_error (error,
 				     FWUPD_ERROR,
@@ -259,6 +270,47 @@ dfu_tool_get_default_device (DfuToolPrivate *priv, GError **error)
 	return NULL;
 }
 
+/* all the DFU devices, or all the ones matching the VID:PID */
+static GPtrArray *
+dfu_tool_get_devices (DfuToolPrivate *priv, GError **error)
+{
+	guint16 pid = 0;
+	guint16 vid = 0;
+	g_autoptr(GUsbContext) usb_context = NULL;
+	g_autoptr(GPtrArray) devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	g_autoptr(GPtrArray) usb_devices = NULL;
+
+	if (priv->device_vid_pid != NULL) {
+		if (!dfu_tool_parse_vid_pid (priv, &vid, &pid, error))
+			return NULL;
+	}
+	usb_context = g_usb_context_new (error);
+	if (usb_context == NULL)
+		return NULL;
+	g_usb_context_enumerate (usb_context);
+	usb_devices = g_usb_context_get_devices (usb_context);
+	for (guint i = 0; i < usb_devices->len; i++) {
+		GUsbDevice *usb_device = g_ptr_array_index (usb_devices, i);
+		g_autoptr(DfuDevice) device = NULL;
+		if (priv->device_vid_pid != NULL &&
+		    (g_usb_device_get_vid (usb_device) != vid ||
+		     g_usb_device_get_pid (usb_device) != pid))
+			continue;
+		device = dfu_device_new (usb_device);
+		fu_device_set_quirks (FU_DEVICE (device), priv->quirks);
+		if (fu_device_probe (FU_DEVICE (device), NULL))
+			g_ptr_array_add (devices, g_steal_pointer (&device));
+	}
+	if (devices->len == 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_FOUND,
+				     "no DFU devices found");
+		return NULL;
+	}
+	return g_steal_pointer (&devices);
+}
+
 static gboolean
 dfu_device_wait_for_replug (DfuToolPrivate *priv, DfuDevice *device, guint timeout, GError **error)
 {
@@ -880,32 +932,80 @@ dfu_tool_write_alt (DfuToolPrivate *priv, gchar **values, GError **error)
 	return TRUE;
 }
 
+typedef struct {
+	DfuToolPrivate		*priv;
+	DfuDevice		*device;
+	GBytes			*fw;
+	GError			*error;
+	GTimer			*timer;
+	FwupdStatus		 status;	/* FWUPD_STATUS_LAST when not timing */
+	gdouble			 status_start;	/* s */
+	gdouble			 durations[FWUPD_STATUS_LAST];	/* s */
+	gdouble			 detach;	/* s */
+	gdouble			 manifest;	/* s */
+} DfuToolWriteHelper;
+
+static DfuToolWriteHelper *
+dfu_tool_write_helper_new (DfuToolPrivate *priv, DfuDevice *device, GBytes *fw)
+{
+	DfuToolWriteHelper *helper = g_new0 (DfuToolWriteHelper, 1);
+	helper->priv = priv;
+	helper->device = g_object_ref (device);
+	helper->fw = g_bytes_ref (fw);
+	helper->timer = g_timer_new ();
+	helper->status = FWUPD_STATUS_LAST;
+	return helper;
+}
+
+static void
+dfu_tool_write_helper_free (DfuToolWriteHelper *helper)
+{
+	g_signal_handlers_disconnect_by_data (helper->device, helper);
+	g_object_unref (helper->device);
+	g_bytes_unref (helper->fw);
+	g_timer_destroy (helper->timer);
+	if (helper->error != NULL)
+		g_error_free (helper->error);
+	g_free (helper);
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-function"
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(DfuToolWriteHelper, dfu_tool_write_helper_free)
+#pragma clang diagnostic pop
+
+/* adds the time spent in the previous status, e.g. erase or download */
+static void
+dfu_tool_write_helper_set_status (DfuToolWriteHelper *helper, FwupdStatus status)
+{
+	gdouble now = g_timer_elapsed (helper->timer, NULL);
+	if (status == helper->status)
+		return;
+	if (helper->status < FWUPD_STATUS_LAST)
+		helper->durations[helper->status] += now - helper->status_start;
+	helper->status = status;
+	helper->status_start = now;
+}
+
+static void
+dfu_tool_write_status_cb (FuDevice *device, GParamSpec *pspec, DfuToolWriteHelper *helper)
+{
+	if (helper->status == FWUPD_STATUS_LAST)
+		return;
+	dfu_tool_write_helper_set_status (helper, fu_device_get_status (device));
+}
+
 static gboolean
-dfu_tool_write (DfuToolPrivate *priv, gchar **values, GError **error)
+dfu_tool_write_device (DfuToolWriteHelper *helper, GError **error)
 {
+	DfuToolPrivate *priv = helper->priv;
+	DfuDevice *device = helper->device;
 	FwupdInstallFlags flags = FWUPD_INSTALL_FLAG_NONE;
-	g_autoptr(DfuDevice) device = NULL;
-	g_autoptr(GBytes) fw = NULL;
+	gdouble start;
 	g_autoptr(FuDeviceLocker) locker  = NULL;
 
-	/* check args */
-	if (g_strv_length (values) < 1) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INTERNAL,
-				     "Invalid arguments, expected FILENAME");
-		return FALSE;
-	}
-
-	/* open file */
-	fw = fu_common_get_contents_bytes (values[0], error);
-	if (fw == NULL)
-		return FALSE;
-
 	/* open correct device */
-	device = dfu_tool_get_default_device (priv, error);
-	if (device == NULL)
-		return FALSE;
+	g_timer_start (helper->timer);
 	locker = fu_device_locker_new (device, error);
 	if (locker == NULL)
 		return FALSE;
@@ -914,6 +1014,7 @@ dfu_tool_write (DfuToolPrivate *priv, gchar **values, GError **error)
 
 	/* APP -> DFU */
 	if (!fu_device_has_flag (FU_DEVICE (device), FWUPD_DEVICE_FLAG_IS_BOOTLOADER)) {
+		start = g_timer_elapsed (helper->timer, NULL);
 		if (!fu_device_detach (FU_DEVICE (device), error))
 			return FALSE;
 		if (!dfu_device_wait_for_replug (priv, device,
@@ -921,6 +1022,7 @@ dfu_tool_write (DfuToolPrivate *priv, gchar **values, GError **error)
 						 error)) {
 			return FALSE;
 		}
+		helper->detach = g_timer_elapsed (helper->timer, NULL) - start;
 	}
 
 	/* allow wildcards */
@@ -929,20 +1031,161 @@ dfu_tool_write (DfuToolPrivate *priv, gchar **values, GError **error)
 
 	/* transfer */
 	g_signal_connect (device, "notify::status",
-			  G_CALLBACK (fu_tool_action_changed_cb), priv);
-	g_signal_connect (device, "notify::progress",
-			  G_CALLBACK (fu_tool_action_changed_cb), priv);
-	if (!fu_device_write_firmware (FU_DEVICE (device), fw, flags, error))
+			  G_CALLBACK (dfu_tool_write_status_cb), helper);
+	dfu_tool_write_helper_set_status (helper, fu_device_get_status (FU_DEVICE (device)));
+	if (!fu_device_write_firmware (FU_DEVICE (device), helper->fw, flags, error))
 		return FALSE;
+	dfu_tool_write_helper_set_status (helper, FWUPD_STATUS_LAST);
 
 	/* do host reset */
+	start = g_timer_elapsed (helper->timer, NULL);
 	if (!fu_device_attach (FU_DEVICE (device), error))
 		return FALSE;
-
 	if (dfu_device_has_attribute (device, DFU_DEVICE_ATTRIBUTE_MANIFEST_TOL)) {
 		if (!dfu_device_wait_for_replug (priv, device, FU_DEVICE_REMOVE_DELAY_RE_ENUMERATE, error))
 			return FALSE;
 	}
+	helper->manifest = g_timer_elapsed (helper->timer, NULL) - start;
+
+	/* success */
+	g_timer_stop (helper->timer);
+	return TRUE;
+}
+
+static void
+dfu_tool_write_helper_print (DfuToolWriteHelper *helper)
+{
+	gsize sz = g_bytes_get_size (helper->fw);
+	gdouble download = helper->durations[FWUPD_STATUS_DEVICE_WRITE];
+	gdouble elapsed = g_timer_elapsed (helper->timer, NULL);
+	const gchar *id = fu_usb_device_get_platform_id (FU_USB_DEVICE (helper->device));
+	struct {
+		const gchar	*title;
+		gdouble		 value;
+	} phases[] = {
+		{ "detach",	helper->detach },
+		{ "erase",	helper->durations[FWUPD_STATUS_DEVICE_ERASE] },
+		{ "download",	download },
+		{ "verify",	helper->durations[FWUPD_STATUS_DEVICE_VERIFY] },
+		{ "manifest",	helper->manifest },
+	};
+
+	if (helper->error != NULL) {
+		g_print ("%s: %s\n", id, helper->error->message);
+		return;
+	}
+	g_print ("%s: %u bytes in %.2fs, %.0f bytes/s\n",
+		 id, (guint) sz, elapsed, elapsed > 0.f ? sz / elapsed : 0.f);
+	for (guint i = 0; i < G_N_ELEMENTS (phases); i++) {
+		g_autofree gchar *tmp = NULL;
+		if (phases[i].value == 0.f)
+			continue;
+		if (g_strcmp0 (phases[i].title, "download") == 0) {
+			tmp = g_strdup_printf ("%.2fs, %.0f bytes/s",
+					       download, sz / download);
+		} else {
+			tmp = g_strdup_printf ("%.2fs", phases[i].value);
+		}
+		dfu_tool_print_indent (phases[i].title, tmp, 2);
+	}
+}
+
+static gpointer
+dfu_tool_write_thread_cb (gpointer user_data)
+{
+	DfuToolWriteHelper *helper = (DfuToolWriteHelper *) user_data;
+	g_autoptr(GMainContext) context = g_main_context_new ();
+
+	/* the replug waits iterate the thread-default context */
+	g_main_context_push_thread_default (context);
+	if (!dfu_tool_write_device (helper, &helper->error))
+		g_timer_stop (helper->timer);
+	g_main_context_pop_thread_default (context);
+	return NULL;
+}
+
+/* each device has its own USB handle, so they can all be written at once */
+static gboolean
+dfu_tool_write_all (DfuToolPrivate *priv, GBytes *fw, GError **error)
+{
+	guint cnt = 0;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GPtrArray) helpers = NULL;
+	g_autoptr(GPtrArray) threads = g_ptr_array_new ();
+
+	devices = dfu_tool_get_devices (priv, error);
+	if (devices == NULL)
+		return FALSE;
+	helpers = g_ptr_array_new_with_free_func ((GDestroyNotify) dfu_tool_write_helper_free);
+	for (guint i = 0; i < devices->len; i++) {
+		DfuDevice *device = g_ptr_array_index (devices, i);
+		DfuToolWriteHelper *helper = dfu_tool_write_helper_new (priv, device, fw);
+		g_ptr_array_add (helpers, helper);
+		g_ptr_array_add (threads, g_thread_new ("dfu-tool-write",
+							dfu_tool_write_thread_cb,
+							helper));
+	}
+	for (guint i = 0; i < threads->len; i++)
+		g_thread_join (g_ptr_array_index (threads, i));
+
+	/* print results */
+	for (guint i = 0; i < helpers->len; i++) {
+		DfuToolWriteHelper *helper = g_ptr_array_index (helpers, i);
+		dfu_tool_write_helper_print (helper);
+		if (helper->error == NULL)
+			cnt++;
+	}
+	if (cnt != helpers->len) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_WRITE,
+			     "%u of %u devices failed",
+			     helpers->len - cnt, helpers->len);
+		return FALSE;
+	}
+
+	/* success */
+	g_print ("%u bytes successfully downloaded to %u devices\n",
+		 (guint) g_bytes_get_size (fw), cnt);
+	return TRUE;
+}
+
+static gboolean
+dfu_tool_write (DfuToolPrivate *priv, gchar **values, GError **error)
+{
+	g_autoptr(DfuDevice) device = NULL;
+	g_autoptr(DfuToolWriteHelper) helper = NULL;
+	g_autoptr(GBytes) fw = NULL;
+
+	/* check args */
+	if (g_strv_length (values) < 1) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "Invalid arguments, expected FILENAME");
+		return FALSE;
+	}
+
+	/* open file */
+	fw = fu_common_get_contents_bytes (values[0], error);
+	if (fw == NULL)
+		return FALSE;
+
+	/* every matching device at the same time */
+	if (priv->all)
+		return dfu_tool_write_all (priv, fw, error);
+
+	/* open correct device */
+	device = dfu_tool_get_default_device (priv, error);
+	if (device == NULL)
+		return FALSE;
+	g_signal_connect (device, "notify::status",
+			  G_CALLBACK (fu_tool_action_changed_cb), priv);
+	g_signal_connect (device, "notify::progress",
+			  G_CALLBACK (fu_tool_action_changed_cb), priv);
+	helper = dfu_tool_write_helper_new (priv, device, fw);
+	if (!dfu_tool_write_device (helper, error))
+		return FALSE;
 
 	/* success */
 	g_print ("%u bytes successfully downloaded to device\n",
@@ -982,6 +1225,8 @@ main (int argc, char *argv[])
 			_("Specify the number of bytes per USB transfer"), "BYTES" },
 		{ "force", '\0', 0, G_OPTION_ARG_NONE, &priv->force,
 			_("Force the action ignoring all warnings"), NULL },
+		{ "all", '\0', 0, G_OPTION_ARG_NONE, &priv->all,
+			_("Write to all the matching devices at the same time"), NULL },
 		{ NULL}
 	};
 
@@ -96,40 +96,22 @@ fu_ebitdo_device_send (FuEbitdoDevice *self,
 	return TRUE;
 }
 
-static gboolean
-fu_ebitdo_device_receive (FuEbitdoDevice *self,
-		       guint8 *out,
-		       gsize out_len,
-		       GError **error)
+static guint8
+fu_ebitdo_device_get_ep_in (FuEbitdoDevice *self)
 {
-	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
-	guint8 packet[FU_EBITDO_USB_EP_SIZE] = {0};
-	gsize actual_length;
-	guint8 ep_in = FU_EBITDO_USB_RUNTIME_EP_IN;
-	g_autoptr(GError) error_local = NULL;
-	FuEbitdoPkt *hdr = (FuEbitdoPkt *) packet;
-
-	/* different */
 	if (fu_device_has_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_IS_BOOTLOADER))
-		ep_in = FU_EBITDO_USB_BOOTLOADER_EP_IN;
+		return FU_EBITDO_USB_BOOTLOADER_EP_IN;
+	return FU_EBITDO_USB_RUNTIME_EP_IN;
+}
 
-	/* get data from device */
-	if (!g_usb_device_interrupt_transfer (usb_device,
-					      ep_in,
-					      packet,
-					      FU_EBITDO_USB_EP_SIZE,
-					      &actual_length,
-					      FU_EBITDO_USB_TIMEOUT,
-					      NULL, /* cancellable */
-					      &error_local)) {
-		g_set_error (error,
-			     G_IO_ERROR,
-			     G_IO_ERROR_INVALID_DATA,
-			     "failed to retrieve from device on ep 0x%02x: %s",
-			     (guint) ep_in,
-			     error_local->message);
-		return FALSE;
-	}
+static gboolean
+fu_ebitdo_device_parse_reply (const guint8 *packet,
+			      gsize actual_length,
+			      guint8 *out,
+			      gsize out_len,
+			      GError **error)
+{
+	FuEbitdoPkt *hdr = (FuEbitdoPkt *) packet;
 
 	/* debug */
 	if (g_getenv ("FWUPD_EBITDO_VERBOSE") != NULL) {
@@ -152,7 +134,7 @@ fu_ebitdo_device_receive (FuEbitdoDevice *self,
 				return FALSE;
 			}
 			if (!fu_memcpy_safe (out, out_len, 0x0,					/* dst */
-					     packet, sizeof(packet), sizeof(FuEbitdoPkt),	/* src */
+					     packet, FU_EBITDO_USB_EP_SIZE, sizeof(FuEbitdoPkt),	/* src */
 					     hdr->payload_len, error))
 				return FALSE;
 		}
@@ -171,7 +153,7 @@ fu_ebitdo_device_receive (FuEbitdoDevice *self,
 				return FALSE;
 			}
 			if (!fu_memcpy_safe (out, out_len, 0x0,					/* dst */
-					     packet, sizeof(packet), 0x1,			/* src */
+					     packet, FU_EBITDO_USB_EP_SIZE, 0x1,			/* src */
 					     4, error))
 				return FALSE;
 		}
@@ -192,7 +174,7 @@ fu_ebitdo_device_receive (FuEbitdoDevice *self,
 				return FALSE;
 			}
 			if (!fu_memcpy_safe (out, out_len, 0x0,					/* dst */
-					     packet, sizeof(packet), sizeof(FuEbitdoPkt) - 3,	/* src */
+					     packet, FU_EBITDO_USB_EP_SIZE, sizeof(FuEbitdoPkt) - 3,	/* src */
 					     hdr->cmd_len, error))
 				return FALSE;
 		}
@@ -222,6 +204,106 @@ fu_ebitdo_device_receive (FuEbitdoDevice *self,
 	return FALSE;
 }
 
+static gboolean
+fu_ebitdo_device_receive (FuEbitdoDevice *self,
+		       guint8 *out,
+		       gsize out_len,
+		       GError **error)
+{
+	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
+	guint8 packet[FU_EBITDO_USB_EP_SIZE] = {0};
+	gsize actual_length;
+	guint8 ep_in = fu_ebitdo_device_get_ep_in (self);
+	g_autoptr(GError) error_local = NULL;
+
+	/* get data from device */
+	if (!g_usb_device_interrupt_transfer (usb_device,
+					      ep_in,
+					      packet,
+					      FU_EBITDO_USB_EP_SIZE,
+					      &actual_length,
+					      FU_EBITDO_USB_TIMEOUT,
+					      NULL, /* cancellable */
+					      &error_local)) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "failed to retrieve from device on ep 0x%02x: %s",
+			     (guint) ep_in,
+			     error_local->message);
+		return FALSE;
+	}
+	return fu_ebitdo_device_parse_reply (packet, actual_length, out, out_len, error);
+}
+
+typedef struct {
+	GMainLoop		*loop;
+	GError			*error;
+	gssize			 actual_length;
+} FuEbitdoDeviceAckHelper;
+
+static void
+fu_ebitdo_device_ack_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuEbitdoDeviceAckHelper *helper = (FuEbitdoDeviceAckHelper *) user_data;
+	helper->actual_length = g_usb_device_interrupt_transfer_finish (G_USB_DEVICE (source),
+									res, &helper->error);
+	g_main_loop_quit (helper->loop);
+}
+
+/* the read for the ACK is queued before the request is sent, so the reply
+ * is collected on the next interrupt poll rather than after a round trip */
+static gboolean
+fu_ebitdo_device_send_with_ack (FuEbitdoDevice *self,
+				FuEbitdoPktType type,
+				FuEbitdoPktCmd subtype,
+				FuEbitdoPktCmd cmd,
+				const guint8 *in,
+				gsize in_len,
+				GError **error)
+{
+	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
+	guint8 packet[FU_EBITDO_USB_EP_SIZE] = {0};
+	gboolean ret;
+	g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+	g_autoptr(GMainContext) context = g_main_context_new ();
+	g_autoptr(GMainLoop) loop = g_main_loop_new (context, FALSE);
+	g_autoptr(GError) error_send = NULL;
+	FuEbitdoDeviceAckHelper helper = { .loop = loop };
+
+	g_main_context_push_thread_default (context);
+	g_usb_device_interrupt_transfer_async (usb_device,
+					       fu_ebitdo_device_get_ep_in (self),
+					       packet,
+					       sizeof(packet),
+					       FU_EBITDO_USB_TIMEOUT,
+					       cancellable,
+					       fu_ebitdo_device_ack_cb,
+					       &helper);
+	ret = fu_ebitdo_device_send (self, type, subtype, cmd, in, in_len, &error_send);
+	if (!ret)
+		g_cancellable_cancel (cancellable);
+	g_main_loop_run (loop);
+	g_main_context_pop_thread_default (context);
+
+	if (!ret) {
+		g_clear_error (&helper.error);
+		g_propagate_error (error, g_steal_pointer (&error_send));
+		return FALSE;
+	}
+	if (helper.actual_length < 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "failed to get ACK: %s",
+			     helper.error->message);
+		g_error_free (helper.error);
+		return FALSE;
+	}
+	return fu_ebitdo_device_parse_reply (packet, (gsize) helper.actual_length,
+					     NULL, 0, error);
+}
+
 static void
 fu_ebitdo_device_set_version (FuEbitdoDevice *self, guint32 version)
 {
@@ -367,7 +449,7 @@ fu_ebitdo_device_write_firmware (FuDevice *device,
 	g_autoptr(GBytes) fw_hdr = NULL;
 	g_autoptr(GBytes) fw_payload = NULL;
 	g_autoptr(GError) error_local = NULL;
-	g_autoptr(GPtrArray) chunks = NULL;
+	g_autoptr(FuChunkView) chunks = NULL;
 	const guint32 app_key_index[16] = {
 		0x186976e5, 0xcac67acd, 0x38f27fee, 0x0a4948f1,
 		0xb75b7753, 0x1f8ffa5c, 0xbff8cf43, 0xc4936167,
@@ -446,31 +528,27 @@ fu_ebitdo_device_write_firmware (FuDevice *device,
 	}
 
 	/* flash the firmware in 32 byte blocks */
-	chunks = fu_chunk_array_new_from_bytes (fw_payload, 0x0, 0x0, 32);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chunk = g_ptr_array_index (chunks, i);
+	chunks = fu_chunk_view_new (fw_payload, 0x0, 0x0, 32);
+	for (guint i = 0; i < fu_chunk_view_get_length (chunks); i++) {
+		FuChunk chunk = { 0 };
+		fu_chunk_view_get_index (chunks, i, &chunk);
 		if (g_getenv ("FWUPD_EBITDO_VERBOSE") != NULL) {
 			g_debug ("writing %u bytes to 0x%04x of 0x%04x",
-				 chunk->data_sz, chunk->address, chunk->data_sz);
+				 chunk.data_sz, chunk.address, chunk.data_sz);
 		}
-		if (!fu_ebitdo_device_send (self,
-					    FU_EBITDO_PKT_TYPE_USER_CMD,
-					    FU_EBITDO_PKT_CMD_UPDATE_FIRMWARE_DATA,
-					    FU_EBITDO_PKT_CMD_FW_UPDATE_DATA,
-					    chunk->data, chunk->data_sz,
-					    error)) {
+		if (!fu_ebitdo_device_send_with_ack (self,
+						     FU_EBITDO_PKT_TYPE_USER_CMD,
+						     FU_EBITDO_PKT_CMD_UPDATE_FIRMWARE_DATA,
+						     FU_EBITDO_PKT_CMD_FW_UPDATE_DATA,
+						     chunk.data, chunk.data_sz,
+						     error)) {
 			g_prefix_error (error,
 					"failed to write firmware @0x%04x: ",
-					chunk->address);
-			return FALSE;
-		}
-		if (!fu_ebitdo_device_receive (self, NULL, 0, error)) {
-			g_prefix_error (error,
-					"failed to get ACK for write firmware @0x%04x: ",
-					chunk->address);
+					chunk.address);
 			return FALSE;
 		}
-		fu_device_set_progress_full (device, chunk->idx, chunks->len);
+		fu_device_set_progress_full (device, chunk.idx,
+					     fu_chunk_view_get_length (chunks));
 	}
 
 	/* set the "encode id" which is likely a checksum, bluetooth pairing
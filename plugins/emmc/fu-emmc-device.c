@@ -19,7 +19,13 @@
 #define MMC_SWITCH			6	/* ac	[31:0] See below	R1b */
 #define MMC_SEND_EXT_CSD		8	/* adtc				R1  */
 #define MMC_SWITCH_MODE_WRITE_BYTE	0x03	/* Set target to value */
-#define MMC_WRITE_BLOCK			24	/* adtc [31:0] data addr	R1  */
+#define MMC_SET_BLOCK_COUNT		23	/* adtc [31:0] data addr	R1  */
+#define MMC_WRITE_MULTIPLE_BLOCK	25	/* adtc				R1  */
+
+/* From kernel linux/mmc/ioctl.h, the most data the kernel accepts per command */
+#ifndef MMC_IOC_MAX_BYTES
+#define MMC_IOC_MAX_BYTES		(512L * 1024)
+#endif
 
 /* From kernel linux/mmc/core.h */
 #define MMC_RSP_PRESENT	(1 << 0)
@@ -320,6 +326,7 @@ fu_emmc_device_write_firmware (FuDevice *device,
 	FuEmmcDevice *self= FU_EMMC_DEVICE (device);
 	gsize fw_size = 0;
 	gsize total_done;
+	gsize chunk_sz;
 	guint32 arg;
 	guint32 sect_done = 0;
 	guint8 ext_csd[512];
@@ -342,10 +349,17 @@ fu_emmc_device_write_firmware (FuDevice *device,
 	      ext_csd[EXT_CSD_FFU_ARG_2] << 16 |
 	      ext_csd[EXT_CSD_FFU_ARG_3] << 24;
 
+	/* write as many sectors as the kernel allows in each command, as
+	 * each one is a round trip and is followed by reading the EXT_CSD */
+	chunk_sz = MIN (fw_size, (gsize) MMC_IOC_MAX_BYTES);
+	chunk_sz -= chunk_sz % self->sect_size;
+	if (chunk_sz == 0)
+		chunk_sz = self->sect_size;
+
 	/* prepare multi_cmd to be sent */
 	multi_cmd = g_malloc0 (sizeof(struct mmc_ioc_multi_cmd) +
-			       3 * sizeof(struct mmc_ioc_cmd));
-	multi_cmd->num_of_cmds = 3;
+			       4 * sizeof(struct mmc_ioc_cmd));
+	multi_cmd->num_of_cmds = 4;
 
 	/* put device into ffu mode */
 	multi_cmd->cmds[0].opcode = MMC_SWITCH;
@@ -356,33 +370,39 @@ fu_emmc_device_write_firmware (FuDevice *device,
 	multi_cmd->cmds[0].flags = MMC_RSP_SPI_R1B | MMC_RSP_R1B | MMC_CMD_AC;
 	multi_cmd->cmds[0].write_flag = 1;
 
+	/* number of sectors in the chunk */
+	multi_cmd->cmds[1].opcode = MMC_SET_BLOCK_COUNT;
+	multi_cmd->cmds[1].flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_AC;
+
 	/* send image chunk */
-	multi_cmd->cmds[1].opcode = MMC_WRITE_BLOCK;
-	multi_cmd->cmds[1].blksz = self->sect_size;
-	multi_cmd->cmds[1].blocks = 1;
-	multi_cmd->cmds[1].arg = arg;
-	multi_cmd->cmds[1].flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_ADTC;
-	multi_cmd->cmds[1].write_flag = 1;
+	multi_cmd->cmds[2].opcode = MMC_WRITE_MULTIPLE_BLOCK;
+	multi_cmd->cmds[2].blksz = self->sect_size;
+	multi_cmd->cmds[2].arg = arg;
+	multi_cmd->cmds[2].flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_ADTC;
+	multi_cmd->cmds[2].write_flag = 1;
 
 	/* return device into normal mode */
-	multi_cmd->cmds[2].opcode = MMC_SWITCH;
-	multi_cmd->cmds[2].arg = (MMC_SWITCH_MODE_WRITE_BYTE << 24) |
+	multi_cmd->cmds[3].opcode = MMC_SWITCH;
+	multi_cmd->cmds[3].arg = (MMC_SWITCH_MODE_WRITE_BYTE << 24) |
 				 (EXT_CSD_MODE_CONFIG << 16) |
 				 (EXT_CSD_NORMAL_MODE << 8) |
 				  EXT_CSD_CMD_SET_NORMAL;
-	multi_cmd->cmds[2].flags = MMC_RSP_SPI_R1B | MMC_RSP_R1B | MMC_CMD_AC;
-	multi_cmd->cmds[2].write_flag = 1;
+	multi_cmd->cmds[3].flags = MMC_RSP_SPI_R1B | MMC_RSP_R1B | MMC_CMD_AC;
+	multi_cmd->cmds[3].write_flag = 1;
 
 	/* build packets */
 	chunks = fu_chunk_array_new_from_bytes (fw,
 						0x00,	/* start addr */
 						0x00,	/* page_sz */
-						self->sect_size);
+						chunk_sz);
 	while (sect_done == 0) {
 		for (guint i = 0; i < chunks->len; i++) {
 			FuChunk *chk = g_ptr_array_index (chunks, i);
+			guint32 blocks = chk->data_sz / self->sect_size;
 
-			mmc_ioc_cmd_set_data (multi_cmd->cmds[1], chk->data);
+			multi_cmd->cmds[1].arg = blocks;
+			multi_cmd->cmds[2].blocks = blocks;
+			mmc_ioc_cmd_set_data (multi_cmd->cmds[2], chk->data);
 
 			if (!fu_udev_device_ioctl (FU_UDEV_DEVICE (self),
 						   MMC_IOC_MULTI_CMD, (guint8 *) multi_cmd,
@@ -390,7 +410,7 @@ fu_emmc_device_write_firmware (FuDevice *device,
 				g_prefix_error (error, "multi-cmd failed: ");
 				/* multi-cmd ioctl failed before exiting from ffu mode */
 				fu_udev_device_ioctl (FU_UDEV_DEVICE (self),
-						      MMC_IOC_CMD, (guint8 *) &multi_cmd->cmds[2],
+						      MMC_IOC_CMD, (guint8 *) &multi_cmd->cmds[3],
 						      NULL, NULL);
 				return FALSE;
 			}
@@ -458,7 +478,7 @@ fu_emmc_device_write_firmware (FuDevice *device,
 			/* In case multi-cmd ioctl failed before exiting from ffu mode */
 			g_prefix_error (error, "multi-cmd failed setting install mode: ");
 			fu_udev_device_ioctl (FU_UDEV_DEVICE (self),
-					      MMC_IOC_CMD, (guint8 *) &multi_cmd->cmds[2],
+					      MMC_IOC_CMD, (guint8 *) &multi_cmd->cmds[3],
 					      NULL, NULL);
 			return FALSE;
 		}
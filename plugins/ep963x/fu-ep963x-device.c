@@ -18,12 +18,13 @@ struct _FuEp963xDevice {
 G_DEFINE_TYPE (FuEp963xDevice, fu_ep963x_device, FU_TYPE_HID_DEVICE)
 
 #define FU_EP963_DEVICE_TIMEOUT			5000	/* ms */
+#define FU_EP963_DEVICE_WAIT_RETRIES		200	/* x 5ms */
 
 static gboolean
-fu_ep963x_device_write (FuEp963xDevice *self,
-			guint8 ctrl_id, guint8 cmd,
-			const guint8 *buf, gsize bufsz,
-			GError **error)
+fu_ep963x_device_set_report (FuEp963xDevice *self,
+			     guint8 ctrl_id, guint8 cmd,
+			     const guint8 *buf, gsize bufsz,
+			     GError **error)
 {
 	guint8 bufhw[FU_EP963_FEATURE_ID1_SIZE] = {
 		ctrl_id, cmd, 0x0,
@@ -34,11 +35,20 @@ fu_ep963x_device_write (FuEp963xDevice *self,
 				     bufsz, error))
 			return FALSE;
 	}
-	if (!fu_hid_device_set_report (FU_HID_DEVICE (self), 0x00,
-				       bufhw, sizeof(bufhw),
-				       FU_EP963_DEVICE_TIMEOUT,
-				       FU_HID_DEVICE_FLAG_IS_FEATURE,
-				       error))
+	return fu_hid_device_set_report (FU_HID_DEVICE (self), 0x00,
+					 bufhw, sizeof(bufhw),
+					 FU_EP963_DEVICE_TIMEOUT,
+					 FU_HID_DEVICE_FLAG_IS_FEATURE,
+					 error);
+}
+
+static gboolean
+fu_ep963x_device_write (FuEp963xDevice *self,
+			guint8 ctrl_id, guint8 cmd,
+			const guint8 *buf, gsize bufsz,
+			GError **error)
+{
+	if (!fu_ep963x_device_set_report (self, ctrl_id, cmd, buf, bufsz, error))
 		return FALSE;
 
 	/* wait for hardware */
@@ -213,6 +223,20 @@ fu_ep963x_device_wait_cb (FuDevice *device, gpointer user_data, GError **error)
 	return TRUE;
 }
 
+/* rather than sleeping after every command, poll the state until it is ready */
+static gboolean
+fu_ep963x_device_write_wait (FuEp963xDevice *self,
+			     guint8 cmd,
+			     const guint8 *buf, gsize bufsz,
+			     GError **error)
+{
+	if (!fu_ep963x_device_set_report (self, FU_EP963_USB_CONTROL_ID,
+					  cmd, buf, bufsz, error))
+		return FALSE;
+	return fu_device_retry (FU_DEVICE (self), fu_ep963x_device_wait_cb,
+				FU_EP963_DEVICE_WAIT_RETRIES, NULL, error);
+}
+
 static gboolean
 fu_ep963x_device_write_firmware (FuDevice *device,
 				 FuFirmware *firmware,
@@ -252,10 +276,9 @@ fu_ep963x_device_write_firmware (FuDevice *device,
 		g_autoptr(GPtrArray) chunks = NULL;
 
 		/* set the block index */
-		if (!fu_ep963x_device_write (self,
-					     FU_EP963_USB_CONTROL_ID,
-					     FU_EP963_OPCODE_SUBMCU_RESET_BLOCK_IDX,
-					     buf, sizeof(buf), &error_local)) {
+		if (!fu_ep963x_device_write_wait (self,
+						  FU_EP963_OPCODE_SUBMCU_RESET_BLOCK_IDX,
+						  buf, sizeof(buf), &error_local)) {
 			g_set_error (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_WRITE,
@@ -273,11 +296,10 @@ fu_ep963x_device_write_firmware (FuDevice *device,
 			g_autoptr(GError) error_loop = NULL;
 
 			/* copy data and write */
-			if (!fu_ep963x_device_write (self,
-						     FU_EP963_USB_CONTROL_ID,
-						     FU_EP963_OPCODE_SUBMCU_WRITE_BLOCK_DATA,
-						     chk->data, chk->data_sz,
-						     &error_loop)) {
+			if (!fu_ep963x_device_write_wait (self,
+							  FU_EP963_OPCODE_SUBMCU_WRITE_BLOCK_DATA,
+							  chk->data, chk->data_sz,
+							  &error_loop)) {
 				g_set_error (error,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_WRITE,
@@ -289,10 +311,9 @@ fu_ep963x_device_write_firmware (FuDevice *device,
 		}
 
 		/* program block */
-		if (!fu_ep963x_device_write (self,
-					     FU_EP963_USB_CONTROL_ID,
-					     FU_EP963_OPCODE_SUBMCU_PROGRAM_BLOCK,
-					     buf, sizeof(buf), &error_local)) {
+		if (!fu_ep963x_device_write_wait (self,
+						  FU_EP963_OPCODE_SUBMCU_PROGRAM_BLOCK,
+						  buf, sizeof(buf), &error_local)) {
 			g_set_error (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_WRITE,
@@ -302,12 +323,8 @@ fu_ep963x_device_write_firmware (FuDevice *device,
 			return FALSE;
 		}
 
-		/* wait for program finished */
-		if (!fu_device_retry (device, fu_ep963x_device_wait_cb, 5, NULL, error))
-			return FALSE;
-
 		/* update progress */
-		fu_device_set_progress_full (device, (gsize) i, (gsize) chunks->len);
+		fu_device_set_progress_full (device, (gsize) i + 1, (gsize) blocks->len);
 	}
 
 	/* success! */
@@ -322,7 +339,7 @@ fu_ep963x_device_init (FuEp963xDevice *self)
 	fu_device_set_version_format (FU_DEVICE (self), FWUPD_VERSION_FORMAT_NUMBER);
 	fu_device_set_remove_delay (FU_DEVICE (self), FU_DEVICE_REMOVE_DELAY_RE_ENUMERATE);
 	fu_device_set_firmware_size (FU_DEVICE (self), FU_EP963_FIRMWARE_SIZE);
-	fu_device_retry_set_delay (FU_DEVICE (self), 100);
+	fu_device_retry_set_delay (FU_DEVICE (self), 5);
 }
 
 static void
@@ -19,6 +19,22 @@ struct _FuEp963xFirmware {
 
 G_DEFINE_TYPE (FuEp963xFirmware, fu_ep963x_firmware, FU_TYPE_FIRMWARE)
 
+static gboolean
+fu_ep963x_firmware_check_magic (FuFirmware *firmware, GBytes *fw, GError **error)
+{
+	gsize len = 0x0;
+	const guint8 *data = g_bytes_get_data (fw, &len);
+
+	if (len != FU_EP963_FIRMWARE_SIZE || memcmp (data + 16, "EP963", 5) != 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "invalid EP963x binary file");
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_ep963x_firmware_parse (FuFirmware *firmware,
 			  GBytes *fw,
@@ -64,6 +80,7 @@ static void
 fu_ep963x_firmware_class_init (FuEp963xFirmwareClass *klass)
 {
 	FuFirmwareClass *klass_firmware = FU_FIRMWARE_CLASS (klass);
+	klass_firmware->check_magic = fu_ep963x_firmware_check_magic;
 	klass_firmware->parse = fu_ep963x_firmware_parse;
 }
 
@@ -12,18 +12,23 @@
 #include "fu-archive.h"
 #include "fu-chunk.h"
 #include "fu-fastboot-device.h"
+#include "fu-fastboot-sparse.h"
 
 #define FASTBOOT_REMOVE_DELAY_RE_ENUMERATE	60000 /* ms */
 #define FASTBOOT_TRANSACTION_TIMEOUT		1000 /* ms */
 #define FASTBOOT_TRANSACTION_RETRY_MAX		600
+#define FASTBOOT_TRANSFERS_IN_FLIGHT		4
 #define FASTBOOT_EP_IN				0x81
 #define FASTBOOT_EP_OUT				0x01
 #define FASTBOOT_CMD_BUFSZ			64 /* bytes */
+#define FASTBOOT_DOWNLOAD_BLOCKSZ		0x10000 /* bytes */
 
 struct _FuFastbootDevice {
 	FuUsbDevice			 parent_instance;
 	gboolean			 secure;
 	guint				 blocksz;
+	guint				 download_blocksz;
+	gsize				 max_download_size;
 	guint8				 intf_nr;
 };
 
@@ -35,6 +40,9 @@ fu_fastboot_device_to_string (FuDevice *device, guint idt, GString *str)
 	FuFastbootDevice *self = FU_FASTBOOT_DEVICE (device);
 	fu_common_string_append_kx (str, idt, "InterfaceNumber", self->intf_nr);
 	fu_common_string_append_kx (str, idt, "BlockSize", self->blocksz);
+	fu_common_string_append_kx (str, idt, "DownloadBlockSize", self->download_blocksz);
+	if (self->max_download_size > 0)
+		fu_common_string_append_kx (str, idt, "MaxDownloadSize", self->max_download_size);
 	fu_common_string_append_kb (str, idt, "Secure", self->secure);
 }
 
@@ -278,19 +286,74 @@ fu_fastboot_device_download (FuDevice *device, GBytes *fw, GError **error)
 	chunks = fu_chunk_array_new_from_bytes (fw,
 						0x00,	/* start addr */
 						0x00,	/* page_sz */
-						self->blocksz);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
-		if (!fu_fastboot_device_write (device, chk->data, chk->data_sz, error))
-			return FALSE;
-		fu_device_set_progress_full (device, (gsize) i, (gsize) chunks->len * 2);
-	}
+						self->download_blocksz);
+	if (!fu_usb_device_bulk_write_chunks (FU_USB_DEVICE (device),
+					      FASTBOOT_EP_OUT,
+					      chunks,
+					      FASTBOOT_TRANSFERS_IN_FLIGHT,
+					      FASTBOOT_TRANSACTION_TIMEOUT,
+					      error))
+		return FALSE;
 	if (!fu_fastboot_device_read (device, NULL,
 				      FU_FASTBOOT_DEVICE_READ_FLAG_STATUS_POLL, error))
 		return FALSE;
 	return TRUE;
 }
 
+/* large raw images are converted to sparse images that each fit in the
+ * download buffer, and mostly-empty images are only sent as sparse if the
+ * bootloader is known to support it */
+static gboolean
+fu_fastboot_device_download_and_flash (FuDevice *device,
+				       GBytes *data,
+				       const gchar *partition,
+				       GError **error)
+{
+	FuFastbootDevice *self = FU_FASTBOOT_DEVICE (device);
+	gsize sz = g_bytes_get_size (data);
+	gsize max_sz = self->max_download_size > 0 ? self->max_download_size : G_MAXUINT32;
+	gsize total_sz = 0;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) imgs = NULL;
+
+	/* send as-is */
+	if (fu_fastboot_sparse_is_sparse (data) ||
+	    (sz <= max_sz && !fu_device_has_custom_flag (device, "sparse"))) {
+		if (!fu_fastboot_device_download (device, data, error))
+			return FALSE;
+		return fu_fastboot_device_flash (device, partition, error);
+	}
+
+	/* only use the sparse images if there is something to gain */
+	imgs = fu_fastboot_sparse_new_from_raw (data, max_sz, &error_local);
+	if (imgs != NULL) {
+		for (guint i = 0; i < imgs->len; i++)
+			total_sz += g_bytes_get_size (g_ptr_array_index (imgs, i));
+	}
+	if (sz <= max_sz && (imgs == NULL || total_sz >= sz)) {
+		if (error_local != NULL)
+			g_debug ("not using sparse image: %s", error_local->message);
+		if (!fu_fastboot_device_download (device, data, error))
+			return FALSE;
+		return fu_fastboot_device_flash (device, partition, error);
+	}
+	if (imgs == NULL) {
+		g_propagate_prefixed_error (error, g_steal_pointer (&error_local),
+					    "image larger than download buffer: ");
+		return FALSE;
+	}
+	g_debug ("sending 0x%x bytes to %s as %u sparse images of 0x%x bytes",
+		 (guint) sz, partition, imgs->len, (guint) total_sz);
+	for (guint i = 0; i < imgs->len; i++) {
+		GBytes *img = g_ptr_array_index (imgs, i);
+		if (!fu_fastboot_device_download (device, img, error))
+			return FALSE;
+		if (!fu_fastboot_device_flash (device, partition, error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_fastboot_device_setup (FuDevice *device, GError **error)
 {
@@ -300,6 +363,8 @@ fu_fastboot_device_setup (FuDevice *device, GError **error)
 	g_autofree gchar *version = NULL;
 	g_autofree gchar *secure = NULL;
 	g_autofree gchar *version_bootloader = NULL;
+	g_autofree gchar *max_download_size = NULL;
+	g_autoptr(GError) error_local = NULL;
 
 	/* product */
 	if (!fu_fastboot_device_getvar (device, "product", &product, error))
@@ -335,6 +400,14 @@ fu_fastboot_device_setup (FuDevice *device, GError **error)
 	if (secure != NULL && secure[0] != '\0')
 		self->secure = TRUE;
 
+	/* size of the download buffer, which older bootloaders do not have */
+	if (!fu_fastboot_device_getvar (device, "max-download-size",
+					&max_download_size, &error_local)) {
+		g_debug ("no max-download-size: %s", error_local->message);
+	} else if (max_download_size != NULL && max_download_size[0] != '\0') {
+		self->max_download_size = fu_common_strtoull (max_download_size);
+	}
+
 	/* success */
 	return TRUE;
 }
@@ -367,9 +440,7 @@ fu_fastboot_device_write_qfil_part (FuDevice *device,
 		partition += 2;
 
 	/* flash the partition */
-	if (!fu_fastboot_device_download (device, data, error))
-		return FALSE;
-	return fu_fastboot_device_flash (device, partition, error);
+	return fu_fastboot_device_download_and_flash (device, data, partition, error);
 }
 
 static gboolean
@@ -492,9 +563,7 @@ fu_fastboot_device_write_motorola_part (FuDevice *device,
 		}
 
 		/* flash the partition */
-		if (!fu_fastboot_device_download (device, data, error))
-			return FALSE;
-		return fu_fastboot_device_flash (device, partition, error);
+		return fu_fastboot_device_download_and_flash (device, data, partition, error);
 	}
 
 	/* dumb operation that doesn't expect a response */
@@ -661,6 +730,7 @@ fu_fastboot_device_set_quirk_kv (FuDevice *device,
 		guint64 tmp = fu_common_strtoull (value);
 		if (tmp >= 0x40 && tmp < 0x100000) {
 			self->blocksz = tmp;
+			self->download_blocksz = tmp;
 			return TRUE;
 		}
 		g_set_error_literal (error,
@@ -696,6 +766,7 @@ fu_fastboot_device_init (FuFastbootDevice *self)
 {
 	/* this is a safe default, even using USBv1 */
 	self->blocksz = 512;
+	self->download_blocksz = FASTBOOT_DOWNLOAD_BLOCKSZ;
 	fu_device_set_protocol (FU_DEVICE (self), "com.google.fastboot");
 	fu_device_add_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_UPDATABLE);
 	fu_device_add_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_IS_BOOTLOADER);
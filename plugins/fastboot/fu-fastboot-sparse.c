@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "fu-common.h"
+#include "fu-fastboot-sparse.h"
+
+/* Android sparse image format, from libsparse sparse_format.h */
+#define FU_FASTBOOT_SPARSE_MAGIC		0xed26ff3a
+#define FU_FASTBOOT_SPARSE_MAJOR_VERSION	0x1
+#define FU_FASTBOOT_SPARSE_MINOR_VERSION	0x0
+#define FU_FASTBOOT_SPARSE_FILE_HDR_SZ		28	/* bytes */
+#define FU_FASTBOOT_SPARSE_CHUNK_HDR_SZ		12	/* bytes */
+#define FU_FASTBOOT_SPARSE_BLOCK_SZ		4096	/* bytes */
+
+#define FU_FASTBOOT_SPARSE_CHUNK_RAW		0xcac1
+#define FU_FASTBOOT_SPARSE_CHUNK_FILL		0xcac2
+#define FU_FASTBOOT_SPARSE_CHUNK_DONT_CARE	0xcac3
+
+typedef struct {
+	guint16			 chunk_type;
+	guint32			 fill;		/* only for FILL */
+	guint32			 blk_start;
+	guint32			 blk_count;
+} FuFastbootSparseRun;
+
+/**
+ * fu_fastboot_sparse_is_sparse:
+ * @blob: a #GBytes
+ *
+ * Checks if the image is already in the Android sparse format.
+ *
+ * Returns: %TRUE if the sparse header was found
+ **/
+gboolean
+fu_fastboot_sparse_is_sparse (GBytes *blob)
+{
+	gsize sz = 0;
+	const guint8 *buf = g_bytes_get_data (blob, &sz);
+	if (sz < FU_FASTBOOT_SPARSE_FILE_HDR_SZ)
+		return FALSE;
+	return fu_common_read_uint32 (buf, G_LITTLE_ENDIAN) == FU_FASTBOOT_SPARSE_MAGIC;
+}
+
+/* a block is a fill if every 32 bit word is the same */
+static gboolean
+fu_fastboot_sparse_block_is_fill (const guint8 *buf, guint32 *fill)
+{
+	if (memcmp (buf, buf + 4, FU_FASTBOOT_SPARSE_BLOCK_SZ - 4) != 0)
+		return FALSE;
+	*fill = fu_common_read_uint32 (buf, G_LITTLE_ENDIAN);
+	return TRUE;
+}
+
+static GArray *
+fu_fastboot_sparse_get_runs (const guint8 *buf, guint32 total_blks)
+{
+	GArray *runs = g_array_new (FALSE, FALSE, sizeof (FuFastbootSparseRun));
+	for (guint32 i = 0; i < total_blks; i++) {
+		FuFastbootSparseRun run = { FU_FASTBOOT_SPARSE_CHUNK_RAW, 0x0, i, 1 };
+		FuFastbootSparseRun *last = NULL;
+		if (fu_fastboot_sparse_block_is_fill (buf + (gsize) i * FU_FASTBOOT_SPARSE_BLOCK_SZ,
+						      &run.fill))
+			run.chunk_type = FU_FASTBOOT_SPARSE_CHUNK_FILL;
+
+		/* extend the previous run if the same kind */
+		if (runs->len > 0)
+			last = &g_array_index (runs, FuFastbootSparseRun, runs->len - 1);
+		if (last != NULL &&
+		    last->chunk_type == run.chunk_type &&
+		    last->fill == run.fill) {
+			last->blk_count++;
+			continue;
+		}
+		g_array_append_val (runs, run);
+	}
+	return runs;
+}
+
+static void
+fu_fastboot_sparse_append_chunk_hdr (GByteArray *buf,
+				     guint16 chunk_type,
+				     guint32 blk_count,
+				     guint32 data_sz)
+{
+	fu_byte_array_append_uint16 (buf, chunk_type, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint16 (buf, 0x0, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint32 (buf, blk_count, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint32 (buf, FU_FASTBOOT_SPARSE_CHUNK_HDR_SZ + data_sz,
+				     G_LITTLE_ENDIAN);
+}
+
+static GBytes *
+fu_fastboot_sparse_build_image (GByteArray *body,
+				guint32 nr_chunks,
+				guint32 blk_start,
+				guint32 blk_end,
+				guint32 total_blks)
+{
+	GByteArray *buf = g_byte_array_new ();
+
+	/* the blocks before and after this image are left alone */
+	if (blk_start > 0)
+		nr_chunks++;
+	if (blk_end < total_blks)
+		nr_chunks++;
+
+	fu_byte_array_append_uint32 (buf, FU_FASTBOOT_SPARSE_MAGIC, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint16 (buf, FU_FASTBOOT_SPARSE_MAJOR_VERSION, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint16 (buf, FU_FASTBOOT_SPARSE_MINOR_VERSION, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint16 (buf, FU_FASTBOOT_SPARSE_FILE_HDR_SZ, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint16 (buf, FU_FASTBOOT_SPARSE_CHUNK_HDR_SZ, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint32 (buf, FU_FASTBOOT_SPARSE_BLOCK_SZ, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint32 (buf, total_blks, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint32 (buf, nr_chunks, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint32 (buf, 0x0, G_LITTLE_ENDIAN); /* checksum */
+	if (blk_start > 0) {
+		fu_fastboot_sparse_append_chunk_hdr (buf, FU_FASTBOOT_SPARSE_CHUNK_DONT_CARE,
+						     blk_start, 0);
+	}
+	g_byte_array_append (buf, body->data, body->len);
+	if (blk_end < total_blks) {
+		fu_fastboot_sparse_append_chunk_hdr (buf, FU_FASTBOOT_SPARSE_CHUNK_DONT_CARE,
+						     total_blks - blk_end, 0);
+	}
+	return g_byte_array_free_to_bytes (buf);
+}
+
+/**
+ * fu_fastboot_sparse_new_from_raw:
+ * @blob: a #GBytes of a raw partition image
+ * @max_sz: the maximum size of each sparse image, typically the
+ *  `max-download-size` of the bootloader
+ * @error: A #GError, or %NULL
+ *
+ * Converts a raw image to one or more sparse images, where runs of blocks
+ * with a repeated 32 bit value are sent as a single FILL chunk. Each image
+ * covers the whole partition, with a DONT_CARE chunk for the blocks written
+ * by the other images.
+ *
+ * Returns: (transfer container) (element-type GBytes): sparse images, or %NULL
+ **/
+GPtrArray *
+fu_fastboot_sparse_new_from_raw (GBytes *blob, gsize max_sz, GError **error)
+{
+	gsize sz = 0;
+	gsize budget;
+	guint idx = 0;
+	guint32 run_offset = 0;
+	guint32 blk_done = 0;
+	guint32 total_blks;
+	const guint8 *buf = g_bytes_get_data (blob, &sz);
+	g_autoptr(GArray) runs = NULL;
+	g_autoptr(GPtrArray) imgs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+
+	/* sanity check */
+	if (sz == 0 || sz % FU_FASTBOOT_SPARSE_BLOCK_SZ != 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "image size 0x%x is not a multiple of the sparse block size",
+			     (guint) sz);
+		return NULL;
+	}
+	if (sz / FU_FASTBOOT_SPARSE_BLOCK_SZ > G_MAXUINT32) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_SUPPORTED,
+				     "image too large for the sparse format");
+		return NULL;
+	}
+
+	/* room for one raw block as well as the header and both DONT_CAREs */
+	budget = FU_FASTBOOT_SPARSE_FILE_HDR_SZ + FU_FASTBOOT_SPARSE_CHUNK_HDR_SZ * 3;
+	if (max_sz < budget + FU_FASTBOOT_SPARSE_BLOCK_SZ) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "maximum download size 0x%x is too small",
+			     (guint) max_sz);
+		return NULL;
+	}
+	budget = max_sz - (FU_FASTBOOT_SPARSE_FILE_HDR_SZ + FU_FASTBOOT_SPARSE_CHUNK_HDR_SZ * 2);
+
+	total_blks = sz / FU_FASTBOOT_SPARSE_BLOCK_SZ;
+	runs = fu_fastboot_sparse_get_runs (buf, total_blks);
+	while (idx < runs->len) {
+		guint32 blk_start = blk_done;
+		guint32 nr_chunks = 0;
+		g_autoptr(GByteArray) body = g_byte_array_new ();
+
+		while (idx < runs->len) {
+			FuFastbootSparseRun *run = &g_array_index (runs, FuFastbootSparseRun, idx);
+			guint32 blk_count = run->blk_count - run_offset;
+
+			if (run->chunk_type == FU_FASTBOOT_SPARSE_CHUNK_FILL) {
+				if (body->len + FU_FASTBOOT_SPARSE_CHUNK_HDR_SZ + 4 > budget)
+					break;
+				fu_fastboot_sparse_append_chunk_hdr (body, run->chunk_type,
+								     blk_count, 4);
+				fu_byte_array_append_uint32 (body, run->fill, G_LITTLE_ENDIAN);
+			} else {
+				gsize avail = budget - body->len;
+				if (avail < FU_FASTBOOT_SPARSE_CHUNK_HDR_SZ + FU_FASTBOOT_SPARSE_BLOCK_SZ)
+					break;
+				avail -= FU_FASTBOOT_SPARSE_CHUNK_HDR_SZ;
+				blk_count = MIN (blk_count, avail / FU_FASTBOOT_SPARSE_BLOCK_SZ);
+				fu_fastboot_sparse_append_chunk_hdr (body, run->chunk_type,
+								     blk_count,
+								     blk_count * FU_FASTBOOT_SPARSE_BLOCK_SZ);
+				g_byte_array_append (body,
+						     buf + (gsize) (run->blk_start + run_offset) *
+							   FU_FASTBOOT_SPARSE_BLOCK_SZ,
+						     blk_count * FU_FASTBOOT_SPARSE_BLOCK_SZ);
+			}
+			nr_chunks++;
+			blk_done += blk_count;
+			run_offset += blk_count;
+			if (run_offset == run->blk_count) {
+				run_offset = 0;
+				idx++;
+			}
+		}
+		g_ptr_array_add (imgs, fu_fastboot_sparse_build_image (body, nr_chunks,
+								       blk_start, blk_done,
+								       total_blks));
+	}
+	return g_steal_pointer (&imgs);
+}
@@ -0,0 +1,14 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include "fu-plugin.h"
+
+gboolean	 fu_fastboot_sparse_is_sparse		(GBytes		*blob);
+GPtrArray	*fu_fastboot_sparse_new_from_raw	(GBytes		*blob,
+							 gsize		 max_sz,
+							 GError		**error);
@@ -29,6 +29,11 @@
 
 #define SELFCHECK_TRUE 1
 
+/* the region written when the flash has an Intel Flash Descriptor */
+#define FU_FLASHROM_IFD_REGION_DEFAULT		"bios"
+/* the region written when the image only has a coreboot FMAP */
+#define FU_FLASHROM_FMAP_REGION_DEFAULT		"COREBOOT"
+
 struct FuPluginData {
 	gsize				 flash_size;
 	struct flashrom_flashctx	*flashctx;
@@ -98,9 +103,15 @@ fu_plugin_coldplug (FuPlugin *plugin, GError **error)
 							  quirk_key_prefixed,
 							  "DeviceId");
 		if (quirk_str != NULL) {
+			const gchar *region;
 			g_autofree gchar *device_id = g_strdup_printf ("flashrom-%s", quirk_str);
 			g_autoptr(FuDevice) dev = fu_device_new ();
 			fu_device_set_id (dev, device_id);
+			region = fu_plugin_lookup_quirk_by_id (plugin,
+							       quirk_key_prefixed,
+							       "FlashromRegion");
+			if (region != NULL)
+				fu_device_set_metadata (dev, "FlashromRegion", region);
 			fu_device_set_quirks (dev, fu_plugin_get_quirks (plugin));
 			fu_device_set_protocol (dev, "org.flashrom");
 			fu_device_add_flag (dev, FWUPD_DEVICE_FLAG_INTERNAL);
@@ -214,35 +225,51 @@ fu_plugin_update (FuPlugin *plugin,
 	FuPluginData *data = fu_plugin_get_data (plugin);
 	gsize sz = 0;
 	gint rc;
+	const gchar *region = fu_device_get_metadata (device, "FlashromRegion");
 	const guint8 *buf = g_bytes_get_data (blob_fw, &sz);
 
-	if (flashrom_layout_read_from_ifd (&data->layout, data->flashctx, NULL, 0)) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_READ,
-				     "failed to read layout from Intel ICH descriptor");
+	if (sz != data->flash_size) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "invalid image size 0x%x, expected 0x%x",
+			     (guint) sz, (guint) data->flash_size);
 		return FALSE;
 	}
 
-	/* include bios region for safety reasons */
-	if (flashrom_layout_include_region (data->layout, "bios")) {
+	/* use the Intel descriptor on the flash, falling back to the FMAP in
+	 * the new image for platforms without one */
+	flashrom_layout_release (data->layout);
+	data->layout = NULL;
+	if (flashrom_layout_read_from_ifd (&data->layout, data->flashctx, NULL, 0) == 0) {
+		if (region == NULL)
+			region = FU_FLASHROM_IFD_REGION_DEFAULT;
+	} else if (flashrom_layout_read_fmap_from_buffer (&data->layout,
+							  data->flashctx,
+							  buf, sz) == 0) {
+		if (region == NULL)
+			region = FU_FLASHROM_FMAP_REGION_DEFAULT;
+	} else {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
-				     FWUPD_ERROR_NOT_SUPPORTED,
-				     "invalid region name");
+				     FWUPD_ERROR_READ,
+				     "failed to read layout from Intel ICH descriptor or FMAP");
 		return FALSE;
 	}
 
-	/* write region */
-	flashrom_layout_set (data->flashctx, data->layout);
-	if (sz != data->flash_size) {
+	/* only write one region for safety reasons; flashrom only reads,
+	 * erases and writes the blocks of that region that have changed */
+	if (flashrom_layout_include_region (data->layout, region)) {
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_NOT_SUPPORTED,
-			     "invalid image size 0x%x, expected 0x%x",
-			     (guint) sz, (guint) data->flash_size);
+			     "invalid region name %s", region);
 		return FALSE;
 	}
+	g_debug ("writing %s region", region);
+
+	/* write region */
+	flashrom_layout_set (data->flashctx, data->layout);
 
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	rc = flashrom_image_write (data->flashctx, (void *) buf, sz, NULL /* refbuffer */);
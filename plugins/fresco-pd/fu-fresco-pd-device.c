@@ -19,6 +19,8 @@ struct _FuFrescoPdDevice
 
 G_DEFINE_TYPE (FuFrescoPdDevice, fu_fresco_pd_device, FU_TYPE_USB_DEVICE)
 
+#define FU_FRESCO_PD_DEVICE_TRANSFERS_IN_FLIGHT		8
+
 static void
 fu_fresco_pd_device_to_string (FuDevice *device, guint idt, GString *str)
 {
@@ -136,6 +138,180 @@ fu_fresco_pd_device_set_byte (FuFrescoPdDevice *self,
 	return fu_fresco_pd_device_write_byte (self, offset, val, error);
 }
 
+typedef struct {
+	guint16			 offset;
+	guint8			 val;
+} FuFrescoPdDeviceByte;
+
+typedef struct {
+	FuFrescoPdDevice	*self;
+	GMainLoop		*loop;
+	GCancellable		*cancellable;
+	GArray			*bytes;		/* of FuFrescoPdDeviceByte */
+	GUsbDeviceDirection	 direction;
+	GError			*error;		/* first failure */
+	guint			 in_flight;
+	guint			 idx_submit;
+	guint			 idx_complete;
+} FuFrescoPdDeviceBytesHelper;
+
+typedef struct {
+	FuFrescoPdDeviceBytesHelper *helper;
+	guint			 idx;
+} FuFrescoPdDeviceBytesTransfer;
+
+static void fu_fresco_pd_device_transfer_bytes_submit (FuFrescoPdDeviceBytesHelper *helper);
+
+static void
+fu_fresco_pd_device_transfer_bytes_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuFrescoPdDeviceBytesTransfer *xfer = (FuFrescoPdDeviceBytesTransfer *) user_data;
+	FuFrescoPdDeviceBytesHelper *helper = xfer->helper;
+	FuFrescoPdDeviceByte *byte = &g_array_index (helper->bytes, FuFrescoPdDeviceByte, xfer->idx);
+	GError *error_local = NULL;
+	gssize actual_len;
+
+	helper->in_flight--;
+	actual_len = g_usb_device_control_transfer_finish (G_USB_DEVICE (source), res, &error_local);
+	if (actual_len < 0) {
+		g_prefix_error (&error_local, "failed to %s offset 0x%x: ",
+				helper->direction == G_USB_DEVICE_DIRECTION_HOST_TO_DEVICE ?
+				"write" : "read from",
+				byte->offset);
+	} else if (actual_len != 1) {
+		error_local = g_error_new (FWUPD_ERROR,
+					   FWUPD_ERROR_NOT_SUPPORTED,
+					   "transferred 0x%x bytes of 0x1 at offset 0x%x",
+					   (guint) actual_len, byte->offset);
+	} else {
+		if (helper->direction == G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST &&
+		    g_getenv ("FWUPD_FRESCO_PD_VERBOSE") != NULL)
+			fu_common_dump_raw (G_LOG_DOMAIN, "read", &byte->val, 1);
+		fu_device_set_progress_full (FU_DEVICE (helper->self),
+					     ++helper->idx_complete,
+					     helper->bytes->len);
+	}
+	g_free (xfer);
+
+	/* keep the first error, the rest are likely cancellations */
+	if (error_local != NULL) {
+		if (helper->error == NULL) {
+			helper->error = error_local;
+			g_cancellable_cancel (helper->cancellable);
+		} else {
+			g_error_free (error_local);
+		}
+	}
+
+	/* queue more, or finish when everything has drained */
+	fu_fresco_pd_device_transfer_bytes_submit (helper);
+	if (helper->in_flight == 0)
+		g_main_loop_quit (helper->loop);
+}
+
+static void
+fu_fresco_pd_device_transfer_bytes_submit (FuFrescoPdDeviceBytesHelper *helper)
+{
+	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (helper->self));
+
+	while (helper->error == NULL &&
+	       helper->in_flight < FU_FRESCO_PD_DEVICE_TRANSFERS_IN_FLIGHT &&
+	       helper->idx_submit < helper->bytes->len) {
+		FuFrescoPdDeviceBytesTransfer *xfer = g_new0 (FuFrescoPdDeviceBytesTransfer, 1);
+		FuFrescoPdDeviceByte *byte;
+		xfer->helper = helper;
+		xfer->idx = helper->idx_submit++;
+		byte = &g_array_index (helper->bytes, FuFrescoPdDeviceByte, xfer->idx);
+		helper->in_flight++;
+		if (helper->direction == G_USB_DEVICE_DIRECTION_HOST_TO_DEVICE &&
+		    g_getenv ("FWUPD_FRESCO_PD_VERBOSE") != NULL)
+			fu_common_dump_raw (G_LOG_DOMAIN, "write", &byte->val, 1);
+		g_usb_device_control_transfer_async (usb_device,
+						     helper->direction,
+						     G_USB_DEVICE_REQUEST_TYPE_VENDOR,
+						     G_USB_DEVICE_RECIPIENT_DEVICE,
+						     helper->direction == G_USB_DEVICE_DIRECTION_HOST_TO_DEVICE ?
+						     0x41 : 0x40,
+						     0x0, byte->offset,
+						     &byte->val, 1,
+						     5000,
+						     helper->cancellable,
+						     fu_fresco_pd_device_transfer_bytes_cb,
+						     xfer);
+	}
+}
+
+/* the bridge only transfers one byte at a time, but the requests do not
+ * depend on each other and so several can be queued */
+static gboolean
+fu_fresco_pd_device_transfer_bytes (FuFrescoPdDevice *self,
+				    GUsbDeviceDirection direction,
+				    GArray *bytes,
+				    GError **error)
+{
+	FuFrescoPdDeviceBytesHelper helper = {
+		.self		= self,
+		.bytes		= bytes,
+		.direction	= direction,
+	};
+	g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+	g_autoptr(GMainContext) context = g_main_context_new ();
+	g_autoptr(GMainLoop) loop = g_main_loop_new (context, FALSE);
+
+	/* completions are dispatched to our own context */
+	helper.loop = loop;
+	helper.cancellable = cancellable;
+	g_main_context_push_thread_default (context);
+	fu_fresco_pd_device_transfer_bytes_submit (&helper);
+	if (helper.in_flight > 0)
+		g_main_loop_run (loop);
+	g_main_context_pop_thread_default (context);
+
+	if (helper.error != NULL) {
+		g_propagate_error (error, helper.error);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* like fu_fresco_pd_device_set_byte(), but for a range of bytes at once */
+static gboolean
+fu_fresco_pd_device_set_bytes (FuFrescoPdDevice *self,
+			       guint16 offset,
+			       const guint8 *buf,
+			       guint16 bufsz,
+			       GError **error)
+{
+	g_autoptr(GArray) bytes = g_array_sized_new (FALSE, FALSE, sizeof(FuFrescoPdDeviceByte), bufsz);
+	g_autoptr(GArray) bytes_changed = g_array_new (FALSE, FALSE, sizeof(FuFrescoPdDeviceByte));
+
+	/* read the existing contents */
+	for (guint16 i = 0; i < bufsz; i++) {
+		FuFrescoPdDeviceByte byte = { offset + i, 0x0 };
+		g_array_append_val (bytes, byte);
+	}
+	fu_device_set_status (FU_DEVICE (self), FWUPD_STATUS_DEVICE_READ);
+	if (!fu_fresco_pd_device_transfer_bytes (self,
+						 G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST,
+						 bytes, error))
+		return FALSE;
+
+	/* only write the bytes that are different */
+	for (guint16 i = 0; i < bufsz; i++) {
+		FuFrescoPdDeviceByte *byte = &g_array_index (bytes, FuFrescoPdDeviceByte, i);
+		if (byte->val == buf[i])
+			continue;
+		byte->val = buf[i];
+		g_array_append_val (bytes_changed, *byte);
+	}
+	g_debug ("writing 0x%x of 0x%x bytes at 0x%04x",
+		 bytes_changed->len, (guint) bufsz, offset);
+	fu_device_set_status (FU_DEVICE (self), FWUPD_STATUS_DEVICE_WRITE);
+	return fu_fresco_pd_device_transfer_bytes (self,
+						   G_USB_DEVICE_DIRECTION_HOST_TO_DEVICE,
+						   bytes_changed, error);
+}
+
 static gboolean
 fu_fresco_pd_device_and_byte (FuFrescoPdDevice *self,
 			      guint16 offset,
@@ -338,57 +514,28 @@ fu_fresco_pd_device_write_firmware (FuDevice *device,
 
 	/* copy buf offset [0 - 0x3FFFF] to mmio address [0x2000 - 0x5FFF] */
 	g_debug ("fill firmware body");
-	for (guint16 byte_index = 0; byte_index < 0x4000; byte_index++) {
-		if (!fu_fresco_pd_device_set_byte (self, byte_index + 0x2000, buf[byte_index], error))
-			return FALSE;
-		fu_device_set_progress_full (device, (gsize) byte_index, 0x4000);
-	}
+	if (!fu_fresco_pd_device_set_bytes (self, 0x2000, buf, 0x4000, error))
+		return FALSE;
 
 	/* write file buf 0x4200 ~ 0x4205, 6 bytes to internal address 0x6600 ~ 0x6605
 	 * write file buf 0x4210 ~ 0x4215, 6 bytes to internal address 0x6610 ~ 0x6615
 	 * write file buf 0x4220 ~ 0x4225, 6 bytes to internal address 0x6620 ~ 0x6625
 	 * write file buf 0x4230, 1 byte, to internal address 0x6630 */
 	g_debug ("update customize data");
-	for (guint16 byte_index = 0; byte_index < 6; byte_index++) {
-		if (!fu_fresco_pd_device_set_byte (self,
-						   0x6600 + byte_index,
-						   buf[0x4200 + byte_index],
-						   error))
-			return FALSE;
-		if (!fu_fresco_pd_device_set_byte (self,
-						   0x6610 + byte_index,
-						   buf[0x4210 + byte_index],
-						   error))
-			return FALSE;
-		if (!fu_fresco_pd_device_set_byte (self,
-						   0x6620 + byte_index,
-						   buf[0x4220 + byte_index],
-						   error))
-			return FALSE;
-	}
+	if (!fu_fresco_pd_device_set_bytes (self, 0x6600, buf + 0x4200, 6, error))
+		return FALSE;
+	if (!fu_fresco_pd_device_set_bytes (self, 0x6610, buf + 0x4210, 6, error))
+		return FALSE;
+	if (!fu_fresco_pd_device_set_bytes (self, 0x6620, buf + 0x4220, 6, error))
+		return FALSE;
 	if (!fu_fresco_pd_device_set_byte (self, 0x6630, buf[0x4230], error))
 		return FALSE;
 
 	/* overwrite firmware file's boot code area (0x4020 ~ 0x41ff) to the area on the device marked by begin_addr
 	 * example: if the begin_addr = 0x6420, then copy file buf [0x4020 ~ 0x41ff] to device offset[0x6420 ~ 0x65ff] */
 	g_debug ("write boot configuration area");
-	for (guint16 byte_index = 0; byte_index < 0x1e0; byte_index += 3) {
-		if (!fu_fresco_pd_device_set_byte (self,
-						   begin_addr + byte_index + 0,
-						   buf[0x4020 + byte_index],
-						   error))
-			return FALSE;
-		if (!fu_fresco_pd_device_set_byte (self,
-						   begin_addr + byte_index + 1,
-						   buf[0x4021 + byte_index],
-						   error))
-			return FALSE;
-		if (!fu_fresco_pd_device_set_byte (self,
-						   begin_addr + byte_index + 2,
-						   buf[0x4022 + byte_index],
-						   error))
-			return FALSE;
-	}
+	if (!fu_fresco_pd_device_set_bytes (self, begin_addr, buf + 0x4020, 0x1e0, error))
+		return FALSE;
 
 	/* reset the device */
 	return fu_fresco_pd_device_panther_reset_device (self, error);
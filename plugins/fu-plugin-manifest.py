@@ -0,0 +1,95 @@
+#!/usr/bin/python3
+""" Builds a manifest of the plugins that can be loaded on demand """
+
+# pylint: disable=invalid-name,wrong-import-position,pointless-string-statement
+
+"""
+SPDX-License-Identifier: LGPL-2.1+
+"""
+
+import os
+import re
+import sys
+
+# any of these mean the plugin has to be loaded at startup
+VFUNCS_EAGER = [
+    'fu_plugin_startup',
+    'fu_plugin_coldplug',
+    'fu_plugin_coldplug_prepare',
+    'fu_plugin_coldplug_cleanup',
+    'fu_plugin_recoldplug',
+    'fu_plugin_device_added',
+    'fu_plugin_device_registered',
+    'fu_plugin_add_security_attrs',
+]
+
+
+def usage(return_code):
+    """ print usage and exit with the supplied return code """
+    if return_code == 0:
+        out = sys.stdout
+    else:
+        out = sys.stderr
+    out.write("usage: fu-plugin-manifest.py <MANIFEST> <PLUGINDIR>")
+    sys.exit(return_code)
+
+
+def _read_files(path, suffix):
+    data = ''
+    for fn in sorted(os.listdir(path)):
+        if not fn.endswith(suffix) or fn.startswith('fu-self-test'):
+            continue
+        with open(os.path.join(path, fn), 'r') as f:
+            data += f.read()
+    return data
+
+
+def _get_plugin_name(path):
+    with open(os.path.join(path, 'meson.build'), 'r') as f:
+        match = re.search(r"shared_module\('fu_plugin_(\w+)'", f.read())
+    if not match:
+        return None
+    return match.group(1)
+
+
+def _get_udev_subsystems(path):
+    """ returns the udev subsystems for a plugin that can be deferred, or None """
+
+    # devices are only given to the plugin using the Plugin quirk
+    name = _get_plugin_name(path)
+    if not name:
+        return None
+    quirks = _read_files(path, '.quirk')
+    if not re.search(r'^Plugin\s*=\s*%s\s*$' % name, quirks, re.MULTILINE):
+        return None
+
+    # the plugin has to do something without any device
+    src = _read_files(path, '.c')
+    for vfunc in re.findall(r'^(fu_plugin_\w+)\s*\(', src, re.MULTILINE):
+        if vfunc in VFUNCS_EAGER:
+            return None
+
+    # other plugins depend on this being loaded
+    if 'fu_plugin_add_rule' in src:
+        return None
+    return sorted(set(re.findall(r'fu_plugin_add_udev_subsystem\s*\(\s*plugin\s*,\s*"([^"]+)"',
+                                 src)))
+
+
+if __name__ == '__main__':
+    if {'-?', '--help', '--usage'}.intersection(set(sys.argv)):
+        usage(0)
+    if len(sys.argv) != 3:
+        usage(1)
+    with open(sys.argv[1], 'w') as f2:
+        f2.write('# plugins that are only loaded when a matching device is added\n')
+        for plugin_dir in sorted(os.listdir(sys.argv[2])):
+            path = os.path.join(sys.argv[2], plugin_dir)
+            if not os.path.exists(os.path.join(path, 'meson.build')):
+                continue
+            subsystems = _get_udev_subsystems(path)
+            if subsystems is None:
+                continue
+            f2.write('\n[%s]\n' % _get_plugin_name(path))
+            if subsystems:
+                f2.write('UdevSubsystems=%s\n' % ''.join([s + ';' for s in subsystems]))
@@ -15,6 +15,13 @@ fu_plugin_init (FuPlugin *plugin)
 	fu_plugin_set_build_hash (plugin, FU_BUILD_HASH);
 }
 
+gboolean
+fu_plugin_startup (FuPlugin *plugin, GError **error)
+{
+	fu_plugin_add_watched_file (plugin, "/sys/power/mem_sleep");
+	return TRUE;
+}
+
 void
 fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
 {
@@ -12,10 +12,17 @@
 
 #define FU_PLUGIN_LINUX_SPI_LPC_SYSFS_DIR	"/sys/kernel/security/spi"
 
+/* BLE and SMM_BWP cannot be cleared until the next platform reset */
+struct FuPluginData {
+	gboolean		 ble_locked;
+	gboolean		 smm_bwp_locked;
+};
+
 void
 fu_plugin_init (FuPlugin *plugin)
 {
 	fu_plugin_set_build_hash (plugin, FU_BUILD_HASH);
+	fu_plugin_alloc_data (plugin, sizeof (FuPluginData));
 }
 
 static void
@@ -53,6 +60,7 @@ fu_plugin_add_security_attr_bioswe (FuPlugin *plugin, FuSecurityAttrs *attrs)
 static void
 fu_plugin_add_security_attr_ble (FuPlugin *plugin, FuSecurityAttrs *attrs)
 {
+	FuPluginData *data = fu_plugin_get_data (plugin);
 	gsize bufsz = 0;
 	g_autofree gchar *buf = NULL;
 	g_autofree gchar *fn = NULL;
@@ -65,16 +73,19 @@ fu_plugin_add_security_attr_ble (FuPlugin *plugin, FuSecurityAttrs *attrs)
 	fwupd_security_attr_set_name (attr, "SPI");
 	fu_security_attrs_append (attrs, attr);
 
-	/* load file */
-	fn = g_build_filename (FU_PLUGIN_LINUX_SPI_LPC_SYSFS_DIR, "ble", NULL);
-	if (!g_file_get_contents (fn, &buf, &bufsz, &error_local)) {
-		g_warning ("could not open %s: %s", fn, error_local->message);
-		fwupd_security_attr_set_result (attr, "Could not open file");
-		return;
-	}
-	if (g_strcmp0 (buf, "1\n") != 0) {
-		fwupd_security_attr_set_result (attr, "Lock disabled");
-		return;
+	/* load file, unless already seen locked */
+	if (!data->ble_locked) {
+		fn = g_build_filename (FU_PLUGIN_LINUX_SPI_LPC_SYSFS_DIR, "ble", NULL);
+		if (!g_file_get_contents (fn, &buf, &bufsz, &error_local)) {
+			g_warning ("could not open %s: %s", fn, error_local->message);
+			fwupd_security_attr_set_result (attr, "Could not open file");
+			return;
+		}
+		if (g_strcmp0 (buf, "1\n") != 0) {
+			fwupd_security_attr_set_result (attr, "Lock disabled");
+			return;
+		}
+		data->ble_locked = TRUE;
 	}
 
 	/* success */
@@ -85,6 +96,7 @@ fu_plugin_add_security_attr_ble (FuPlugin *plugin, FuSecurityAttrs *attrs)
 static void
 fu_plugin_add_security_attr_smm_bwp (FuPlugin *plugin, FuSecurityAttrs *attrs)
 {
+	FuPluginData *data = fu_plugin_get_data (plugin);
 	gsize bufsz = 0;
 	g_autofree gchar *buf = NULL;
 	g_autofree gchar *fn = NULL;
@@ -97,16 +109,19 @@ fu_plugin_add_security_attr_smm_bwp (FuPlugin *plugin, FuSecurityAttrs *attrs)
 	fwupd_security_attr_set_name (attr, "BIOS region of SPI");
 	fu_security_attrs_append (attrs, attr);
 
-	/* load file */
-	fn = g_build_filename (FU_PLUGIN_LINUX_SPI_LPC_SYSFS_DIR, "smm_bwp", NULL);
-	if (!g_file_get_contents (fn, &buf, &bufsz, &error_local)) {
-		g_warning ("could not open %s: %s", fn, error_local->message);
-		fwupd_security_attr_set_result (attr, "Could not open file");
-		return;
-	}
-	if (g_strcmp0 (buf, "1\n") != 0) {
-		fwupd_security_attr_set_result (attr, "Writable by OS");
-		return;
+	/* load file, unless already seen locked */
+	if (!data->smm_bwp_locked) {
+		fn = g_build_filename (FU_PLUGIN_LINUX_SPI_LPC_SYSFS_DIR, "smm_bwp", NULL);
+		if (!g_file_get_contents (fn, &buf, &bufsz, &error_local)) {
+			g_warning ("could not open %s: %s", fn, error_local->message);
+			fwupd_security_attr_set_result (attr, "Could not open file");
+			return;
+		}
+		if (g_strcmp0 (buf, "1\n") != 0) {
+			fwupd_security_attr_set_result (attr, "Writable by OS");
+			return;
+		}
+		data->smm_bwp_locked = TRUE;
 	}
 
 	/* success */
@@ -11,7 +11,6 @@
 
 struct FuPluginData {
 	GFile			*file;
-	GFileMonitor		*monitor;
 };
 
 void
@@ -27,19 +26,6 @@ fu_plugin_destroy (FuPlugin *plugin)
 	FuPluginData *data = fu_plugin_get_data (plugin);
 	if (data->file != NULL)
 		g_object_unref (data->file);
-	if (data->monitor != NULL)
-		g_object_unref (data->monitor);
-}
-
-static void
-fu_plugin_linux_tainted_changed_cb (GFileMonitor *monitor,
-				 GFile *file,
-				 GFile *other_file,
-				 GFileMonitorEvent event_type,
-				 gpointer user_data)
-{
-	FuPlugin *plugin = FU_PLUGIN (user_data);
-	fu_plugin_security_changed (plugin);
 }
 
 gboolean
@@ -52,11 +38,7 @@ fu_plugin_startup (FuPlugin *plugin, GError **error)
 	procfs = fu_common_get_path (FU_PATH_KIND_PROCFS);
 	fn = g_build_filename (procfs, "sys", "kernel", "tainted", NULL);
 	data->file = g_file_new_for_path (fn);
-	data->monitor = g_file_monitor (data->file, G_FILE_MONITOR_NONE, NULL, error);
-	if (data->monitor == NULL)
-		return FALSE;
-	g_signal_connect (data->monitor, "changed",
-			  G_CALLBACK (fu_plugin_linux_tainted_changed_cb), plugin);
+	fu_plugin_add_watched_file (plugin, fn);
 	return TRUE;
 }
 
@@ -14,6 +14,7 @@ typedef enum {
 	FU_UNIFYING_HIDPP_MSG_FLAG_IGNORE_SUB_ID	= 1 << 1,
 	FU_UNIFYING_HIDPP_MSG_FLAG_IGNORE_FNCT_ID	= 1 << 2,
 	FU_UNIFYING_HIDPP_MSG_FLAG_IGNORE_SWID		= 1 << 3,
+	FU_UNIFYING_HIDPP_MSG_FLAG_NO_FLUSH		= 1 << 4,
 	/*< private >*/
 	FU_UNIFYING_HIDPP_MSG_FLAG_LAST
 } FuLogitechHidPpHidppMsgFlags;
@@ -63,7 +63,11 @@ fu_logitech_hidpp_send (FuIOChannel *io_channel,
 			GError **error)
 {
 	gsize len = fu_logitech_hidpp_msg_get_payload_length (msg);
-	FuIOChannelFlags write_flags = FU_IO_CHANNEL_FLAG_FLUSH_INPUT;
+	FuIOChannelFlags write_flags = FU_IO_CHANNEL_FLAG_NONE;
+
+	/* replies to requests already sent may be waiting */
+	if ((msg->flags & FU_UNIFYING_HIDPP_MSG_FLAG_NO_FLUSH) == 0)
+		write_flags |= FU_IO_CHANNEL_FLAG_FLUSH_INPUT;
 
 	/* only for HID++2.0 */
 	if (msg->hidpp_version >= 2.f)
@@ -209,3 +213,74 @@ fu_logitech_hidpp_transfer (FuIOChannel *io_channel, FuLogitechHidPpHidppMsg *ms
 	fu_logitech_hidpp_msg_copy (msg, msg_tmp);
 	return TRUE;
 }
+
+/* each reply is matched to the request using the sub ID, function ID and
+ * SwId, so requests outstanding at the same time must differ in these */
+gboolean
+fu_logitech_hidpp_transfer_window (FuIOChannel *io_channel,
+				   GPtrArray *msgs,
+				   guint window,
+				   GError **error)
+{
+	guint idx_send = 0;
+	guint done = 0;
+	guint ignore_cnt = 0;
+	g_autofree gboolean *replied = g_new0 (gboolean, msgs->len);
+
+	g_return_val_if_fail (window > 0, FALSE);
+
+	while (done < msgs->len) {
+		FuLogitechHidPpHidppMsg *msg0 = g_ptr_array_index (msgs, 0);
+		gboolean matched = FALSE;
+		g_autoptr(FuLogitechHidPpHidppMsg) msg_tmp = fu_logitech_hidpp_msg_new ();
+
+		/* keep the window full, only flushing stale data before the first request */
+		while (idx_send < msgs->len && idx_send - done < window) {
+			FuLogitechHidPpHidppMsg *msg = g_ptr_array_index (msgs, idx_send);
+			if (idx_send > 0)
+				msg->flags |= FU_UNIFYING_HIDPP_MSG_FLAG_NO_FLUSH;
+			if (!fu_logitech_hidpp_send (io_channel, msg,
+						     FU_UNIFYING_DEVICE_TIMEOUT_MS,
+						     error))
+				return FALSE;
+			idx_send++;
+		}
+
+		msg_tmp->hidpp_version = msg0->hidpp_version;
+		if (!fu_logitech_hidpp_receive (io_channel, msg_tmp,
+						FU_UNIFYING_DEVICE_TIMEOUT_MS,
+						error))
+			return FALSE;
+		if (fu_logitech_hidpp_msg_get_payload_length (msg_tmp) == 0x0)
+			continue;
+		if (!fu_logitech_hidpp_msg_is_error (msg_tmp, error))
+			return FALSE;
+		if (msg0->hidpp_version < 2.f || fu_logitech_hidpp_msg_verify_swid (msg_tmp)) {
+			for (guint i = done; i < idx_send; i++) {
+				FuLogitechHidPpHidppMsg *msg = g_ptr_array_index (msgs, i);
+				if (replied[i] || !fu_logitech_hidpp_msg_is_reply (msg, msg_tmp))
+					continue;
+				fu_logitech_hidpp_msg_copy (msg, msg_tmp);
+				replied[i] = TRUE;
+				matched = TRUE;
+				break;
+			}
+		}
+		if (!matched) {
+			if (ignore_cnt++ > 10 * window) {
+				g_set_error (error,
+					     G_IO_ERROR,
+					     G_IO_ERROR_FAILED,
+					     "too many messages to ignore");
+				return FALSE;
+			}
+			g_debug ("ignoring message %u", ignore_cnt);
+			continue;
+		}
+
+		/* move the start of the window past everything that has replied */
+		while (done < idx_send && replied[done])
+			done++;
+	}
+	return TRUE;
+}
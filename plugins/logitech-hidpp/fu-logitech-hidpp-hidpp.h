@@ -146,3 +146,7 @@ gboolean	 fu_logitech_hidpp_receive	(FuIOChannel		*self,
 gboolean	 fu_logitech_hidpp_transfer	(FuIOChannel		*self,
 						 FuLogitechHidPpHidppMsg	*msg,
 						 GError			**error);
+gboolean	 fu_logitech_hidpp_transfer_window	(FuIOChannel		*self,
+						 GPtrArray		*msgs,
+						 guint			 window,
+						 GError			**error);
@@ -30,8 +30,20 @@ typedef struct {
 	guint16			 feature;
 } FuLogitechHidPpHidppMap;
 
+typedef struct {
+	gchar			*version;
+	GPtrArray		*feature_index;	/* of FuLogitechHidPpHidppMap */
+} FuLogitechHidPpFeatureCache;
+
+/* the feature indexes are fixed by the firmware, so remember them
+ * for when the peripheral next wakes up or is reconnected */
+static GHashTable *fu_logitech_hidpp_feature_cache = NULL;	/* model:FuLogitechHidPpFeatureCache */
+G_LOCK_DEFINE_STATIC (fu_logitech_hidpp_feature_cache);
+
 G_DEFINE_TYPE (FuLogitechHidPpPeripheral, fu_logitech_hidpp_peripheral, FU_TYPE_UDEV_DEVICE)
 
+#define FU_LOGITECH_HIDPP_PERIPHERAL_DFU_WINDOW		4	/* packets */
+
 typedef enum {
 	FU_UNIFYING_PERIPHERAL_KIND_KEYBOARD,
 	FU_UNIFYING_PERIPHERAL_KIND_REMOTE_CONTROL,
@@ -467,6 +479,119 @@ fu_logitech_hidpp_feature_search (FuDevice *device, guint16 feature, GError **er
 	return TRUE;
 }
 
+/* returns FALSE if the device stopped responding part way through */
+static gboolean
+fu_logitech_hidpp_peripheral_map_features (FuLogitechHidPpPeripheral *self)
+{
+	const guint16 map_features[] = {
+		HIDPP_FEATURE_GET_DEVICE_NAME_TYPE,
+		HIDPP_FEATURE_I_FIRMWARE_INFO,
+		HIDPP_FEATURE_BATTERY_LEVEL_STATUS,
+		HIDPP_FEATURE_DFU_CONTROL,
+		HIDPP_FEATURE_DFU_CONTROL_SIGNED,
+		HIDPP_FEATURE_DFU,
+		HIDPP_FEATURE_ROOT };
+
+	/* add known root for HID++2.0 */
+	g_ptr_array_set_size (self->feature_index, 0);
+	if (self->hidpp_version >= 2.f) {
+		FuLogitechHidPpHidppMap *map = g_new0 (FuLogitechHidPpHidppMap, 1);
+		map->idx = 0x00;
+		map->feature = HIDPP_FEATURE_ROOT;
+		g_ptr_array_add (self->feature_index, map);
+	}
+
+	/* map some *optional* HID++2.0 features we might use */
+	for (guint i = 0; map_features[i] != HIDPP_FEATURE_ROOT; i++) {
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_logitech_hidpp_feature_search (FU_DEVICE (self),
+						       map_features[i],
+						       &error_local)) {
+			g_debug ("%s", error_local->message);
+			if (g_error_matches (error_local,
+					     G_IO_ERROR,
+					     G_IO_ERROR_TIMED_OUT) ||
+			    g_error_matches (error_local,
+					     G_IO_ERROR,
+					     G_IO_ERROR_HOST_UNREACHABLE)) {
+				/* timed out, so not trying any more */
+				return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+static gchar *
+fu_logitech_hidpp_peripheral_feature_cache_key (FuLogitechHidPpPeripheral *self)
+{
+	return g_strdup_printf ("%04X:%u",
+				fu_udev_device_get_model (FU_UDEV_DEVICE (self)),
+				self->hidpp_version);
+}
+
+static void
+fu_logitech_hidpp_feature_cache_free (FuLogitechHidPpFeatureCache *cache)
+{
+	g_free (cache->version);
+	g_ptr_array_unref (cache->feature_index);
+	g_free (cache);
+}
+
+/* returns the firmware version the cached indexes were found on, or NULL */
+static gchar *
+fu_logitech_hidpp_peripheral_feature_cache_load (FuLogitechHidPpPeripheral *self)
+{
+	FuLogitechHidPpFeatureCache *cache = NULL;
+	gchar *version = NULL;
+	g_autofree gchar *key = fu_logitech_hidpp_peripheral_feature_cache_key (self);
+
+	G_LOCK (fu_logitech_hidpp_feature_cache);
+	if (fu_logitech_hidpp_feature_cache != NULL)
+		cache = g_hash_table_lookup (fu_logitech_hidpp_feature_cache, key);
+	if (cache != NULL) {
+		g_ptr_array_set_size (self->feature_index, 0);
+		for (guint i = 0; i < cache->feature_index->len; i++) {
+			FuLogitechHidPpHidppMap *map = g_ptr_array_index (cache->feature_index, i);
+			g_ptr_array_add (self->feature_index,
+					 g_memdup (map, sizeof (FuLogitechHidPpHidppMap)));
+		}
+		version = g_strdup (cache->version);
+	}
+	G_UNLOCK (fu_logitech_hidpp_feature_cache);
+	return version;
+}
+
+static void
+fu_logitech_hidpp_peripheral_feature_cache_save (FuLogitechHidPpPeripheral *self)
+{
+	FuLogitechHidPpFeatureCache *cache;
+	const gchar *version = fu_device_get_version (FU_DEVICE (self));
+
+	/* no way to tell if the firmware changes */
+	if (version == NULL)
+		return;
+
+	cache = g_new0 (FuLogitechHidPpFeatureCache, 1);
+	cache->version = g_strdup (version);
+	cache->feature_index = g_ptr_array_new_with_free_func (g_free);
+	for (guint i = 0; i < self->feature_index->len; i++) {
+		FuLogitechHidPpHidppMap *map = g_ptr_array_index (self->feature_index, i);
+		g_ptr_array_add (cache->feature_index,
+				 g_memdup (map, sizeof (FuLogitechHidPpHidppMap)));
+	}
+	G_LOCK (fu_logitech_hidpp_feature_cache);
+	if (fu_logitech_hidpp_feature_cache == NULL) {
+		fu_logitech_hidpp_feature_cache =
+			g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					       (GDestroyNotify) fu_logitech_hidpp_feature_cache_free);
+	}
+	g_hash_table_insert (fu_logitech_hidpp_feature_cache,
+			     fu_logitech_hidpp_peripheral_feature_cache_key (self),
+			     cache);
+	G_UNLOCK (fu_logitech_hidpp_feature_cache);
+}
+
 static gboolean
 fu_logitech_hidpp_peripheral_probe (FuUdevDevice *device, GError **error)
 {
@@ -492,14 +617,7 @@ fu_logitech_hidpp_peripheral_setup (FuDevice *device, GError **error)
 {
 	FuLogitechHidPpPeripheral *self = FU_UNIFYING_PERIPHERAL (device);
 	guint8 idx;
-	const guint16 map_features[] = {
-		HIDPP_FEATURE_GET_DEVICE_NAME_TYPE,
-		HIDPP_FEATURE_I_FIRMWARE_INFO,
-		HIDPP_FEATURE_BATTERY_LEVEL_STATUS,
-		HIDPP_FEATURE_DFU_CONTROL,
-		HIDPP_FEATURE_DFU_CONTROL_SIGNED,
-		HIDPP_FEATURE_DFU,
-		HIDPP_FEATURE_ROOT };
+	g_autofree gchar *version_cached = NULL;
 
 	/* ping device to get HID++ version */
 	if (!fu_logitech_hidpp_peripheral_ping (self, error))
@@ -514,37 +632,29 @@ fu_logitech_hidpp_peripheral_setup (FuDevice *device, GError **error)
 		return FALSE;
 	}
 
-	/* add known root for HID++2.0 */
-	g_ptr_array_set_size (self->feature_index, 0);
-	if (self->hidpp_version >= 2.f) {
-		FuLogitechHidPpHidppMap *map = g_new0 (FuLogitechHidPpHidppMap, 1);
-		map->idx = 0x00;
-		map->feature = HIDPP_FEATURE_ROOT;
-		g_ptr_array_add (self->feature_index, map);
-	}
-
-	/* map some *optional* HID++2.0 features we might use */
-	for (guint i = 0; map_features[i] != HIDPP_FEATURE_ROOT; i++) {
+	/* use the feature indexes from last time if the firmware is the same */
+	version_cached = fu_logitech_hidpp_peripheral_feature_cache_load (self);
+	if (version_cached != NULL) {
 		g_autoptr(GError) error_local = NULL;
-		if (!fu_logitech_hidpp_feature_search (device,
-						       map_features[i],
-						       &error_local)) {
-			g_debug ("%s", error_local->message);
-			if (g_error_matches (error_local,
-					     G_IO_ERROR,
-					     G_IO_ERROR_TIMED_OUT) ||
-			    g_error_matches (error_local,
-					     G_IO_ERROR,
-					     G_IO_ERROR_HOST_UNREACHABLE)) {
-				/* timed out, so not trying any more */
-				break;
-			}
+		if (!fu_logitech_hidpp_peripheral_fetch_firmware_info (self, &error_local)) {
+			g_debug ("ignoring cached features: %s", error_local->message);
+			g_clear_pointer (&version_cached, g_free);
+		} else if (g_strcmp0 (version_cached,
+				      fu_device_get_version (device)) != 0) {
+			g_debug ("firmware changed from %s, ignoring cached features",
+				 version_cached);
+			g_clear_pointer (&version_cached, g_free);
 		}
 	}
 
-	/* get the firmware information */
-	if (!fu_logitech_hidpp_peripheral_fetch_firmware_info (self, error))
-		return FALSE;
+	/* map the features and get the firmware information */
+	if (version_cached == NULL) {
+		gboolean complete = fu_logitech_hidpp_peripheral_map_features (self);
+		if (!fu_logitech_hidpp_peripheral_fetch_firmware_info (self, error))
+			return FALSE;
+		if (complete)
+			fu_logitech_hidpp_peripheral_feature_cache_save (self);
+	}
 
 	/* get the battery level */
 	if (!fu_logitech_hidpp_peripheral_fetch_battery_level (self, error))
@@ -837,28 +947,29 @@ fu_logitech_hidpp_peripheral_check_status (guint8 status, GError **error)
 	return FALSE;
 }
 
-static gboolean
-fu_logitech_hidpp_peripheral_write_firmware_pkt (FuLogitechHidPpPeripheral *self,
-					   guint8 idx,
-					   guint8 cmd,
-					   const guint8 *data,
-					   GError **error)
+static FuLogitechHidPpHidppMsg *
+fu_logitech_hidpp_peripheral_new_firmware_pkt (FuLogitechHidPpPeripheral *self,
+					       guint8 idx,
+					       guint8 cmd,
+					       const guint8 *data)
 {
-	guint32 packet_cnt;
-	g_autoptr(FuLogitechHidPpHidppMsg) msg = fu_logitech_hidpp_msg_new ();
-	g_autoptr(GError) error_local = NULL;
-
-	/* send firmware data */
+	FuLogitechHidPpHidppMsg *msg = fu_logitech_hidpp_msg_new ();
 	msg->report_id = HIDPP_REPORT_ID_LONG;
 	msg->device_id = self->hidpp_id;
 	msg->sub_id = idx;
 	msg->function_id = cmd << 4; /* dfuStart or dfuCmdDataX */
 	msg->hidpp_version = self->hidpp_version;
 	memcpy (msg->data, data, 16);
-	if (!fu_logitech_hidpp_transfer (self->io_channel, msg, &error_local)) {
-		g_prefix_error (error, "failed to supply program data: ");
-		return FALSE;
-	}
+	return msg;
+}
+
+static gboolean
+fu_logitech_hidpp_peripheral_check_firmware_pkt (FuLogitechHidPpPeripheral *self,
+						 FuLogitechHidPpHidppMsg *msg,
+						 GError **error)
+{
+	guint32 packet_cnt;
+	g_autoptr(GError) error_local = NULL;
 
 	/* check error */
 	packet_cnt = fu_common_read_uint32 (msg->data, G_BIG_ENDIAN);
@@ -904,6 +1015,57 @@ fu_logitech_hidpp_peripheral_write_firmware_pkt (FuLogitechHidPpPeripheral *self
 	return FALSE;
 }
 
+static gboolean
+fu_logitech_hidpp_peripheral_write_firmware_pkt (FuLogitechHidPpPeripheral *self,
+					   guint8 idx,
+					   guint8 cmd,
+					   const guint8 *data,
+					   GError **error)
+{
+	g_autoptr(FuLogitechHidPpHidppMsg) msg = NULL;
+
+	/* send firmware data */
+	msg = fu_logitech_hidpp_peripheral_new_firmware_pkt (self, idx, cmd, data);
+	if (!fu_logitech_hidpp_transfer (self->io_channel, msg, error)) {
+		g_prefix_error (error, "failed to supply program data: ");
+		return FALSE;
+	}
+	return fu_logitech_hidpp_peripheral_check_firmware_pkt (self, msg, error);
+}
+
+/* dfuCmdData0 to dfuCmdData3 have different function IDs, so up to four
+ * packets can be outstanding and the replies still matched up */
+static gboolean
+fu_logitech_hidpp_peripheral_write_firmware_pkts (FuLogitechHidPpPeripheral *self,
+						  guint8 idx,
+						  guint8 *cmd,
+						  const guint8 *data,
+						  guint cnt,
+						  GError **error)
+{
+	g_autoptr(GPtrArray) msgs = g_ptr_array_new_with_free_func (g_free);
+
+	for (guint i = 0; i < cnt; i++) {
+		FuLogitechHidPpHidppMsg *msg;
+		msg = fu_logitech_hidpp_peripheral_new_firmware_pkt (self, idx, *cmd,
+								     data + (i * 16));
+		g_ptr_array_add (msgs, msg);
+		*cmd = (*cmd + 1) % 4;
+	}
+	if (!fu_logitech_hidpp_transfer_window (self->io_channel, msgs,
+						FU_LOGITECH_HIDPP_PERIPHERAL_DFU_WINDOW,
+						error)) {
+		g_prefix_error (error, "failed to supply program data: ");
+		return FALSE;
+	}
+	for (guint i = 0; i < msgs->len; i++) {
+		FuLogitechHidPpHidppMsg *msg = g_ptr_array_index (msgs, i);
+		if (!fu_logitech_hidpp_peripheral_check_firmware_pkt (self, msg, error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_logitech_hidpp_peripheral_write_firmware (FuDevice *device,
 				       FuFirmware *firmware,
@@ -937,6 +1099,26 @@ fu_logitech_hidpp_peripheral_write_firmware (FuDevice *device,
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	for (gsize i = 0; i < sz / 16; i++) {
 
+		/* the first and last packets erase and check the flash */
+		if (fu_device_has_custom_flag (device, "dfu-pipeline") &&
+		    i > 0 && i + FU_LOGITECH_HIDPP_PERIPHERAL_DFU_WINDOW < sz / 16) {
+			g_debug ("send data at addr=0x%04x", (guint) i * 16);
+			if (!fu_logitech_hidpp_peripheral_write_firmware_pkts (self,
+									      idx,
+									      &cmd,
+									      data + (i * 16),
+									      FU_LOGITECH_HIDPP_PERIPHERAL_DFU_WINDOW,
+									      error)) {
+				g_prefix_error (error,
+						"failed to write @0x%04x: ",
+						(guint) i * 16);
+				return FALSE;
+			}
+			i += FU_LOGITECH_HIDPP_PERIPHERAL_DFU_WINDOW - 1;
+			fu_device_set_progress_full (device, i * 16, sz);
+			continue;
+		}
+
 		/* send packet and wait for reply */
 		g_debug ("send data at addr=0x%04x", (guint) i * 16);
 		if (!fu_logitech_hidpp_peripheral_write_firmware_pkt (self,
@@ -25,6 +25,10 @@
  * required (e.g. if switching from the default (DF) to generic (GC).*/
 #define FU_MM_DEVICE_REMOVE_DELAY_REPROBE	120000	/* ms */
 
+/* Number of MCFG chunks sent before waiting for the load config indication,
+ * only used on modems with the qmi-pdc-pipeline flag. */
+#define FU_MM_DEVICE_QMI_PDC_LOAD_WINDOW	4
+
 struct _FuMmDevice {
 	FuDevice			 parent_instance;
 	MMManager			*manager;
@@ -513,6 +517,8 @@ static gboolean
 fu_mm_device_qmi_open (FuMmDevice *self, GError **error)
 {
 	self->qmi_pdc_updater = fu_qmi_pdc_updater_new (self->port_qmi);
+	if (fu_device_has_custom_flag (FU_DEVICE (self), "qmi-pdc-pipeline"))
+		fu_qmi_pdc_updater_set_load_window (self->qmi_pdc_updater, FU_MM_DEVICE_QMI_PDC_LOAD_WINDOW);
 	return fu_qmi_pdc_updater_open (self->qmi_pdc_updater, error);
 }
 
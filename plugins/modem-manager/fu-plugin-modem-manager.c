@@ -20,70 +20,100 @@
 
 typedef struct FuPluginMmInhibitedDeviceInfo FuPluginMmInhibitedDeviceInfo;
 
+typedef struct {
+	FuPlugin			*plugin;	/* noref */
+	FuPluginMmInhibitedDeviceInfo	*info;
+	guint				 udev_timeout_id;
+} FuPluginMmInhibitedDevice;
+
 struct FuPluginData {
 	MMManager	*manager;
 	gboolean	 manager_ready;
 	GUdevClient	*udev_client;
-	guint		 udev_timeout_id;
 
 	/* when a device is inhibited from MM, we store all relevant details
-	 * ourselves to recreate a functional device object even without MM
+	 * ourselves to recreate a functional device object even without MM;
+	 * several modems can be inhibited and updated at the same time
 	 */
-	FuPluginMmInhibitedDeviceInfo *inhibited;
+	GPtrArray	*inhibited;	/* of FuPluginMmInhibitedDevice */
 };
 
 static void
-fu_plugin_mm_udev_device_removed (FuPlugin *plugin)
+fu_plugin_mm_inhibited_device_free (FuPluginMmInhibitedDevice *item)
+{
+	if (item->udev_timeout_id != 0)
+		g_source_remove (item->udev_timeout_id);
+	fu_plugin_mm_inhibited_device_info_free (item->info);
+	g_free (item);
+}
+
+static FuPluginMmInhibitedDevice *
+fu_plugin_mm_get_inhibited (FuPlugin *plugin, const gchar *physical_id)
 {
 	FuPluginData *priv = fu_plugin_get_data (plugin);
-	FuMmDevice *dev;
+	for (guint i = 0; i < priv->inhibited->len; i++) {
+		FuPluginMmInhibitedDevice *item = g_ptr_array_index (priv->inhibited, i);
+		if (g_strcmp0 (item->info->physical_id, physical_id) == 0)
+			return item;
+	}
+	return NULL;
+}
 
-	if (priv->inhibited == NULL)
-		return;
+static void
+fu_plugin_mm_udev_device_removed (FuPluginMmInhibitedDevice *item)
+{
+	FuPlugin *plugin = item->plugin;
+	FuMmDevice *dev;
 
-	dev = fu_plugin_cache_lookup (plugin, priv->inhibited->physical_id);
+	dev = fu_plugin_cache_lookup (plugin, item->info->physical_id);
 	if (dev == NULL)
 		return;
 
 	/* once the first port is gone, consider device is gone */
-	fu_plugin_cache_remove (plugin, priv->inhibited->physical_id);
+	fu_plugin_cache_remove (plugin, item->info->physical_id);
 	fu_plugin_device_remove (plugin, FU_DEVICE (dev));
 
 	/* no need to wait for more ports, cancel that right away */
-	if (priv->udev_timeout_id != 0) {
-		g_source_remove (priv->udev_timeout_id);
-		priv->udev_timeout_id = 0;
+	if (item->udev_timeout_id != 0) {
+		g_source_remove (item->udev_timeout_id);
+		item->udev_timeout_id = 0;
 	}
 }
 
 static void
-fu_plugin_mm_uninhibit_device (FuPlugin *plugin)
+fu_plugin_mm_uninhibit_device (FuPlugin *plugin, const gchar *physical_id)
 {
 	FuPluginData *priv = fu_plugin_get_data (plugin);
-	g_autoptr(FuPluginMmInhibitedDeviceInfo) info = NULL;
+	FuPluginMmInhibitedDevice *item;
 
-	/* get the device removed from the plugin cache before uninhibiting */
-	fu_plugin_mm_udev_device_removed (plugin);
+	item = fu_plugin_mm_get_inhibited (plugin, physical_id);
+	if (item == NULL)
+		return;
 
-	info = g_steal_pointer (&priv->inhibited);
-	if ((priv->manager != NULL) && (info != NULL)) {
-		g_debug ("uninhibit modemmanager device with uid %s", info->inhibited_uid);
-		mm_manager_uninhibit_device_sync (priv->manager, info->inhibited_uid, NULL, NULL);
+	/* get the device removed from the plugin cache before uninhibiting */
+	fu_plugin_mm_udev_device_removed (item);
+
+	if (priv->manager != NULL) {
+		g_debug ("uninhibit modemmanager device with uid %s",
+			 item->info->inhibited_uid);
+		mm_manager_uninhibit_device_sync (priv->manager,
+						  item->info->inhibited_uid,
+						  NULL, NULL);
 	}
+	g_ptr_array_remove (priv->inhibited, item);
 }
 
 static gboolean
 fu_plugin_mm_udev_device_ports_timeout (gpointer user_data)
 {
-	FuPlugin *plugin = user_data;
-	FuPluginData *priv = fu_plugin_get_data (plugin);
+	FuPluginMmInhibitedDevice *item = user_data;
+	FuPlugin *plugin = item->plugin;
 	FuMmDevice *dev;
 	g_autoptr(GError) error = NULL;
 
-	g_return_val_if_fail (priv->inhibited != NULL, G_SOURCE_REMOVE);
-	priv->udev_timeout_id = 0;
+	item->udev_timeout_id = 0;
 
-	dev = fu_plugin_cache_lookup (plugin, priv->inhibited->physical_id);
+	dev = fu_plugin_cache_lookup (plugin, item->info->physical_id);
 	if (dev != NULL) {
 		if (!fu_device_probe (FU_DEVICE (dev), &error)) {
 			g_warning ("failed to probe MM device: %s", error->message);
@@ -96,44 +126,40 @@ fu_plugin_mm_udev_device_ports_timeout (gpointer user_data)
 }
 
 static void
-fu_plugin_mm_udev_device_ports_timeout_reset (FuPlugin *plugin)
+fu_plugin_mm_udev_device_ports_timeout_reset (FuPluginMmInhibitedDevice *item)
 {
-	FuPluginData *priv = fu_plugin_get_data (plugin);
-
-	g_return_if_fail (priv->inhibited != NULL);
-	if (priv->udev_timeout_id != 0)
-		g_source_remove (priv->udev_timeout_id);
-	priv->udev_timeout_id = g_timeout_add_seconds (FU_MM_UDEV_DEVICE_PORTS_TIMEOUT,
+	if (item->udev_timeout_id != 0)
+		g_source_remove (item->udev_timeout_id);
+	item->udev_timeout_id = g_timeout_add_seconds (FU_MM_UDEV_DEVICE_PORTS_TIMEOUT,
 						       fu_plugin_mm_udev_device_ports_timeout,
-						       plugin);
+						       item);
 }
 
 static void
-fu_plugin_mm_udev_device_port_added (FuPlugin		*plugin,
-				     const gchar	*subsystem,
-				     const gchar	*path,
-				     gint		 ifnum)
+fu_plugin_mm_udev_device_port_added (FuPluginMmInhibitedDevice	*item,
+				     const gchar		*subsystem,
+				     const gchar		*path,
+				     gint			 ifnum)
 {
+	FuPlugin *plugin = item->plugin;
 	FuPluginData *priv = fu_plugin_get_data (plugin);
 	FuMmDevice *existing;
 	g_autoptr(FuMmDevice) dev = NULL;
-	g_autoptr(GError) error = NULL;
 
-	g_return_if_fail (priv->inhibited != NULL);
-	existing = fu_plugin_cache_lookup (plugin, priv->inhibited->physical_id);
+	existing = fu_plugin_cache_lookup (plugin, item->info->physical_id);
 	if (existing != NULL) {
 		/* add port to existing device */
 		fu_mm_device_udev_add_port (existing, subsystem, path, ifnum);
-		fu_plugin_mm_udev_device_ports_timeout_reset (plugin);
+		fu_plugin_mm_udev_device_ports_timeout_reset (item);
 		return;
 	}
 	/* create device and add to cache */
-	dev = fu_mm_device_udev_new (priv->manager, priv->inhibited);
+	dev = fu_mm_device_udev_new (priv->manager, item->info);
 	fu_mm_device_udev_add_port (dev, subsystem, path, ifnum);
-	fu_plugin_cache_add (plugin, priv->inhibited->physical_id, dev);
+	fu_plugin_cache_add (plugin, item->info->physical_id, dev);
 
 	/* wait a bit before probing, in case more ports get added */
-	fu_plugin_mm_udev_device_ports_timeout_reset (plugin);
+	fu_plugin_mm_udev_device_ports_timeout_reset (item);
 }
 
 static gboolean
@@ -144,21 +170,23 @@ fu_plugin_mm_udev_uevent_cb (GUdevClient	*udev,
 {
 	FuPlugin *plugin = FU_PLUGIN (user_data);
 	FuPluginData *priv = fu_plugin_get_data (plugin);
+	FuPluginMmInhibitedDevice *item;
 	const gchar *subsystem = g_udev_device_get_subsystem (device);
 	const gchar *name = g_udev_device_get_name (device);
 	g_autofree gchar *path = NULL;
 	g_autofree gchar *device_sysfs_path = NULL;
 	gint ifnum = -1;
 
-	if (action == NULL || subsystem == NULL || priv->inhibited == NULL || name == NULL)
+	if (action == NULL || subsystem == NULL || priv->inhibited->len == 0 || name == NULL)
 		return TRUE;
 
 	/* ignore if loading port info fails */
 	if (!fu_mm_utils_get_udev_port_info (device, &device_sysfs_path, &ifnum, NULL))
 		return TRUE;
 
-	/* ignore all events for ports not owned by our device */
-	if (g_strcmp0 (device_sysfs_path, priv->inhibited->physical_id) != 0)
+	/* ignore all events for ports not owned by an inhibited device */
+	item = fu_plugin_mm_get_inhibited (plugin, device_sysfs_path);
+	if (item == NULL)
 		return TRUE;
 
 	/* ignore non-cdc-wdm usbmisc ports */
@@ -169,10 +197,10 @@ fu_plugin_mm_udev_uevent_cb (GUdevClient	*udev,
 
 	if ((g_str_equal (action, "add")) || (g_str_equal (action, "change"))) {
 		g_debug ("added port to inhibited modem: %s (ifnum %d)", path, ifnum);
-		fu_plugin_mm_udev_device_port_added (plugin, subsystem, path, ifnum);
+		fu_plugin_mm_udev_device_port_added (item, subsystem, path, ifnum);
 	} else if (g_str_equal (action, "remove")) {
 		g_debug ("removed port from inhibited modem: %s", path);
-		fu_plugin_mm_udev_device_removed (plugin);
+		fu_plugin_mm_udev_device_removed (item);
 	}
 
 	return TRUE;
@@ -183,9 +211,10 @@ fu_plugin_mm_inhibit_device (FuPlugin *plugin, FuDevice *device, GError **error)
 {
 	static const gchar *subsystems[] = { "tty", "usbmisc", NULL };
 	FuPluginData *priv = fu_plugin_get_data (plugin);
+	FuPluginMmInhibitedDevice *item;
 	g_autoptr(FuPluginMmInhibitedDeviceInfo) info = NULL;
 
-	fu_plugin_mm_uninhibit_device (plugin);
+	fu_plugin_mm_uninhibit_device (plugin, fu_device_get_physical_id (device));
 
 	info = fu_plugin_mm_inhibited_device_info_new (FU_MM_DEVICE (device));
 
@@ -194,13 +223,19 @@ fu_plugin_mm_inhibit_device (FuPlugin *plugin, FuDevice *device, GError **error)
 		return FALSE;
 
 	/* setup inhibited device info */
-	priv->inhibited = g_steal_pointer (&info);
+	item = g_new0 (FuPluginMmInhibitedDevice, 1);
+	item->plugin = plugin;
+	item->info = g_steal_pointer (&info);
+	g_ptr_array_add (priv->inhibited, item);
 
 	/* as soon as inhibition is place, we need to do modem device monitoring based
-	 * on the udev client, as MM no longer reports devices */
-	priv->udev_client = g_udev_client_new (subsystems);
-	g_signal_connect (priv->udev_client, "uevent",
-			  G_CALLBACK (fu_plugin_mm_udev_uevent_cb), plugin);
+	 * on the udev client, as MM no longer reports devices; the same client
+	 * is used for all the inhibited devices */
+	if (priv->udev_client == NULL) {
+		priv->udev_client = g_udev_client_new (subsystems);
+		g_signal_connect (priv->udev_client, "uevent",
+				  G_CALLBACK (fu_plugin_mm_udev_uevent_cb), plugin);
+	}
 
 	return TRUE;
 }
@@ -337,8 +372,9 @@ fu_plugin_startup (FuPlugin *plugin, GError **error)
 void
 fu_plugin_init (FuPlugin *plugin)
 {
+	FuPluginData *priv = fu_plugin_alloc_data (plugin, sizeof (FuPluginData));
 	fu_plugin_set_build_hash (plugin, FU_BUILD_HASH);
-	fu_plugin_alloc_data (plugin, sizeof (FuPluginData));
+	priv->inhibited = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_plugin_mm_inhibited_device_free);
 }
 
 void
@@ -346,10 +382,12 @@ fu_plugin_destroy (FuPlugin *plugin)
 {
 	FuPluginData *priv = fu_plugin_get_data (plugin);
 
-	fu_plugin_mm_uninhibit_device (plugin);
+	while (priv->inhibited->len > 0) {
+		FuPluginMmInhibitedDevice *item = g_ptr_array_index (priv->inhibited, 0);
+		fu_plugin_mm_uninhibit_device (plugin, item->info->physical_id);
+	}
+	g_ptr_array_unref (priv->inhibited);
 
-	if (priv->udev_timeout_id)
-		g_source_remove (priv->udev_timeout_id);
 	if (priv->udev_client)
 		g_object_unref (priv->udev_client);
 	if (priv->manager != NULL)
@@ -371,14 +409,14 @@ fu_plugin_update_detach (FuPlugin *plugin, FuDevice *device, GError **error)
 	 * lifetime of the FuMmDevice, because that object will only exist for
 	 * as long as the ModemManager device exists, and inhibiting will
 	 * implicitly remove the device from ModemManager. */
-	if (priv->inhibited == NULL) {
+	if (fu_plugin_mm_get_inhibited (plugin, fu_device_get_physical_id (device)) == NULL) {
 		if (!fu_plugin_mm_inhibit_device (plugin, device, error))
 			return FALSE;
 	}
 
 	/* reset */
 	if (!fu_device_detach (device, error)) {
-		fu_plugin_mm_uninhibit_device (plugin);
+		fu_plugin_mm_uninhibit_device (plugin, fu_device_get_physical_id (device));
 		return FALSE;
 	}
 
@@ -387,10 +425,10 @@ fu_plugin_update_detach (FuPlugin *plugin, FuDevice *device, GError **error)
 }
 
 static void
-fu_plugin_mm_device_attach_finished (gpointer user_data)
+fu_plugin_mm_device_attach_finished (FuDevice *device, gpointer user_data)
 {
 	FuPlugin *plugin = FU_PLUGIN (user_data);
-	fu_plugin_mm_uninhibit_device (plugin);
+	fu_plugin_mm_uninhibit_device (plugin, fu_device_get_physical_id (device));
 }
 
 gboolean
@@ -411,8 +449,8 @@ fu_plugin_update_attach (FuPlugin *plugin, FuDevice *device, GError **error)
 		return FALSE;
 
 	/* this signal will always be emitted asynchronously */
-	g_signal_connect_swapped (device, "attach-finished",
-				  G_CALLBACK (fu_plugin_mm_device_attach_finished), plugin);
+	g_signal_connect (device, "attach-finished",
+			  G_CALLBACK (fu_plugin_mm_device_attach_finished), plugin);
 
 	return TRUE;
 }
@@ -18,6 +18,7 @@ struct _FuQmiPdcUpdater {
 	gchar		*qmi_port;
 	QmiDevice	*qmi_device;
 	QmiClientPdc	*qmi_client;
+	guint		 load_window;
 };
 
 G_DEFINE_TYPE (FuQmiPdcUpdater, fu_qmi_pdc_updater, G_TYPE_OBJECT)
@@ -224,6 +225,10 @@ typedef struct {
 	GArray		*digest;
 	gsize		 offset;
 	guint		 token;
+	guint		 window;	/* max chunks without an indication */
+	guint		 unacked;	/* chunks sent without an indication */
+	guint		 pending;	/* requests without a response */
+	gboolean	 done;
 } WriteContext;
 
 #pragma clang diagnostic push
@@ -232,7 +237,35 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(QmiMessagePdcLoadConfigInput, qmi_message_pdc_load
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(QmiMessagePdcLoadConfigOutput, qmi_message_pdc_load_config_output_unref)
 #pragma clang diagnostic pop
 
-static void fu_qmi_pdc_updater_load_config (WriteContext *ctx);
+static void fu_qmi_pdc_updater_load_config_fill (WriteContext *ctx);
+static gboolean fu_qmi_pdc_updater_load_config_timeout (gpointer user_data);
+
+/* the context lives on the stack of fu_qmi_pdc_updater_write(), so wait for
+ * the responses of any requests still in flight before returning */
+static void
+fu_qmi_pdc_updater_load_config_done (WriteContext *ctx)
+{
+	ctx->done = TRUE;
+	if (ctx->timeout_id != 0) {
+		g_source_remove (ctx->timeout_id);
+		ctx->timeout_id = 0;
+	}
+	if (ctx->indication_id != 0) {
+		g_signal_handler_disconnect (ctx->qmi_client, ctx->indication_id);
+		ctx->indication_id = 0;
+	}
+	if (ctx->pending == 0)
+		g_main_loop_quit (ctx->mainloop);
+}
+
+/* don't wait forever for the next response or indication */
+static void
+fu_qmi_pdc_updater_load_config_restart_timeout (WriteContext *ctx)
+{
+	if (ctx->timeout_id != 0)
+		g_source_remove (ctx->timeout_id);
+	ctx->timeout_id = g_timeout_add_seconds (5, fu_qmi_pdc_updater_load_config_timeout, ctx);
+}
 
 static gboolean
 fu_qmi_pdc_updater_load_config_timeout (gpointer user_data)
@@ -240,12 +273,9 @@ fu_qmi_pdc_updater_load_config_timeout (gpointer user_data)
 	WriteContext *ctx = user_data;
 
 	ctx->timeout_id = 0;
-	g_signal_handler_disconnect (ctx->qmi_client, ctx->indication_id);
-	ctx->indication_id = 0;
-
 	g_set_error_literal (&ctx->error, G_IO_ERROR, G_IO_ERROR_FAILED,
 			     "couldn't load mcfg: timed out");
-	g_main_loop_quit (ctx->mainloop);
+	fu_qmi_pdc_updater_load_config_done (ctx);
 
 	return G_SOURCE_REMOVE;
 }
@@ -259,13 +289,11 @@ fu_qmi_pdc_updater_load_config_indication (QmiClientPdc *client,
 	guint32 remaining_size;
 	guint16 error_code = 0;
 
-	g_source_remove (ctx->timeout_id);
-	ctx->timeout_id = 0;
-	g_signal_handler_disconnect (ctx->qmi_client, ctx->indication_id);
-	ctx->indication_id = 0;
+	if (ctx->unacked > 0)
+		ctx->unacked--;
 
 	if (!qmi_indication_pdc_load_config_output_get_indication_result (output, &error_code, &ctx->error)) {
-		g_main_loop_quit (ctx->mainloop);
+		fu_qmi_pdc_updater_load_config_done (ctx);
 		return;
 	}
 
@@ -276,37 +304,38 @@ fu_qmi_pdc_updater_load_config_indication (QmiClientPdc *client,
 		 */
 		if (error_code == QMI_PROTOCOL_ERROR_INVALID_QOS_ID) {
 			g_debug ("file already available in device");
-			g_main_loop_quit (ctx->mainloop);
+			fu_qmi_pdc_updater_load_config_done (ctx);
 			return;
 		}
 
 		g_set_error (&ctx->error, G_IO_ERROR, G_IO_ERROR_FAILED,
 			     "couldn't load mcfg: %s", qmi_protocol_error_get_string ((QmiProtocolError) error_code));
-		g_main_loop_quit (ctx->mainloop);
+		fu_qmi_pdc_updater_load_config_done (ctx);
 		return;
 	}
 
 	if (qmi_indication_pdc_load_config_output_get_frame_reset (output, &frame_reset, NULL) && frame_reset) {
 		g_set_error (&ctx->error, G_IO_ERROR, G_IO_ERROR_FAILED,
 			     "couldn't load mcfg: sent data discarded");
-		g_main_loop_quit (ctx->mainloop);
+		fu_qmi_pdc_updater_load_config_done (ctx);
 		return;
 	}
 
 	if (!qmi_indication_pdc_load_config_output_get_remaining_size (output, &remaining_size, &ctx->error)) {
 		g_prefix_error (&ctx->error, "couldn't load remaining size: ");
-		g_main_loop_quit (ctx->mainloop);
+		fu_qmi_pdc_updater_load_config_done (ctx);
 		return;
 	}
 
 	if (remaining_size == 0) {
 		g_debug ("finished loading mcfg");
-		g_main_loop_quit (ctx->mainloop);
+		fu_qmi_pdc_updater_load_config_done (ctx);
 		return;
 	}
 
 	g_debug ("loading next chunk (%u bytes remaining)", remaining_size);
-	fu_qmi_pdc_updater_load_config (ctx);
+	fu_qmi_pdc_updater_load_config_restart_timeout (ctx);
+	fu_qmi_pdc_updater_load_config_fill (ctx);
 }
 
 static void
@@ -314,27 +343,29 @@ fu_qmi_pdc_updater_load_config_ready (GObject *qmi_client, GAsyncResult *res, gp
 {
 	WriteContext *ctx = (WriteContext *) user_data;
 	g_autoptr(QmiMessagePdcLoadConfigOutput) output = NULL;
+	g_autoptr(GError) error_local = NULL;
 
-	output = qmi_client_pdc_load_config_finish (QMI_CLIENT_PDC (qmi_client), res, &ctx->error);
-	if (output == NULL) {
-		g_main_loop_quit (ctx->mainloop);
+	ctx->pending--;
+
+	output = qmi_client_pdc_load_config_finish (QMI_CLIENT_PDC (qmi_client), res, &error_local);
+	if (output != NULL)
+		qmi_message_pdc_load_config_output_get_result (output, &error_local);
+
+	/* already failed or finished, just waiting for the other responses */
+	if (ctx->done) {
+		if (ctx->pending == 0)
+			g_main_loop_quit (ctx->mainloop);
 		return;
 	}
-
-	if (!qmi_message_pdc_load_config_output_get_result (output, &ctx->error)) {
-		g_main_loop_quit (ctx->mainloop);
+	if (error_local != NULL) {
+		g_propagate_error (&ctx->error, g_steal_pointer (&error_local));
+		fu_qmi_pdc_updater_load_config_done (ctx);
 		return;
 	}
 
 	/* after receiving the response to our request, we now expect an indication
 	 * with the actual result of the operation */
-	g_warn_if_fail (ctx->indication_id == 0);
-	ctx->indication_id = g_signal_connect (ctx->qmi_client, "load-config",
-					       G_CALLBACK (fu_qmi_pdc_updater_load_config_indication), ctx);
-
-	/* don't wait forever */
-	g_warn_if_fail (ctx->timeout_id == 0);
-	ctx->timeout_id = g_timeout_add_seconds (5, fu_qmi_pdc_updater_load_config_timeout, ctx);
+	fu_qmi_pdc_updater_load_config_restart_timeout (ctx);
 }
 
 static void
@@ -371,11 +402,24 @@ fu_qmi_pdc_updater_load_config (WriteContext *ctx)
 							    chunk,
 							    NULL);
 	ctx->offset += chunk_size;
+	ctx->pending++;
+	ctx->unacked++;
 
 	qmi_client_pdc_load_config (ctx->qmi_client, input, 10, NULL,
 				    fu_qmi_pdc_updater_load_config_ready, ctx);
 }
 
+/* the modem appends each chunk in the order the requests are sent, so more
+ * than one can be in flight before the indication for the first arrives */
+static void
+fu_qmi_pdc_updater_load_config_fill (WriteContext *ctx)
+{
+	while (!ctx->done &&
+	       ctx->unacked < ctx->window &&
+	       ctx->offset < g_bytes_get_size (ctx->blob))
+		fu_qmi_pdc_updater_load_config (ctx);
+}
+
 static GArray *
 fu_qmi_pdc_updater_get_checksum (GBytes *blob)
 {
@@ -397,6 +441,13 @@ fu_qmi_pdc_updater_get_checksum (GBytes *blob)
 	return digest;
 }
 
+void
+fu_qmi_pdc_updater_set_load_window (FuQmiPdcUpdater *self, guint load_window)
+{
+	g_return_if_fail (FU_IS_QMI_PDC_UPDATER (self));
+	self->load_window = MAX (load_window, 1);
+}
+
 GArray *
 fu_qmi_pdc_updater_write (FuQmiPdcUpdater *self, const gchar *filename, GBytes *blob, GError **error)
 {
@@ -412,9 +463,16 @@ fu_qmi_pdc_updater_write (FuQmiPdcUpdater *self, const gchar *filename, GBytes *
 		.digest = digest,
 		.offset = 0,
 		.token = 0,
+		.window = self->load_window,
+		.unacked = 0,
+		.pending = 0,
+		.done = FALSE,
 	};
 
-	fu_qmi_pdc_updater_load_config (&ctx);
+	/* listen before sending so that no indication is missed */
+	ctx.indication_id = g_signal_connect (ctx.qmi_client, "load-config",
+					      G_CALLBACK (fu_qmi_pdc_updater_load_config_indication), &ctx);
+	fu_qmi_pdc_updater_load_config_fill (&ctx);
 	g_main_loop_run (mainloop);
 
 	if (ctx.error != NULL) {
@@ -666,6 +724,7 @@ fu_qmi_pdc_updater_activate (FuQmiPdcUpdater *self, GArray *digest, GError **err
 static void
 fu_qmi_pdc_updater_init (FuQmiPdcUpdater *self)
 {
+	self->load_window = 1;
 }
 
 static void
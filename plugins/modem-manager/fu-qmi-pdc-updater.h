@@ -15,6 +15,8 @@ G_DECLARE_FINAL_TYPE (FuQmiPdcUpdater, fu_qmi_pdc_updater, FU, QMI_PDC_UPDATER,
 FuQmiPdcUpdater	*fu_qmi_pdc_updater_new		(const gchar		*qmi_port);
 gboolean	 fu_qmi_pdc_updater_open	(FuQmiPdcUpdater	*self,
 						 GError			**error);
+void		 fu_qmi_pdc_updater_set_load_window	(FuQmiPdcUpdater	*self,
+							 guint			 load_window);
 GArray		*fu_qmi_pdc_updater_write	(FuQmiPdcUpdater	*self,
 						 const gchar		*filename,
 						 GBytes			*blob,
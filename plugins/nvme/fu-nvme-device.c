@@ -6,10 +6,10 @@
 
 #include "config.h"
 
+#include <string.h>
 #include <sys/ioctl.h>
 #include <linux/nvme_ioctl.h>
 
-#include "fu-chunk.h"
 #include "fu-nvme-common.h"
 #include "fu-nvme-device.h"
 
@@ -19,6 +19,8 @@ struct _FuNvmeDevice {
 	FuUdevDevice		 parent_instance;
 	guint			 pci_depth;
 	guint64			 write_block_size;
+	gboolean		 commit_staged;		/* commit after all downloads */
+	gboolean		 commit_pending;	/* downloaded, not committed */
 };
 
 G_DEFINE_TYPE (FuNvmeDevice, fu_nvme_device, FU_TYPE_UDEV_DEVICE)
@@ -28,6 +30,8 @@ fu_nvme_device_to_string (FuDevice *device, guint idt, GString *str)
 {
 	FuNvmeDevice *self = FU_NVME_DEVICE (device);
 	fu_common_string_append_ku (str, idt, "PciDepth", self->pci_depth);
+	if (self->commit_staged)
+		fu_common_string_append_kb (str, idt, "CommitPending", self->commit_pending);
 }
 
 /* @addr_start and @addr_end are *inclusive* to match the NMVe specification */
@@ -305,53 +309,81 @@ fu_nvme_device_setup (FuDevice *device, GError **error)
 }
 
 static gboolean
-fu_nvme_device_write_firmware (FuDevice *device,
-			       FuFirmware *firmware,
-			       FwupdInstallFlags flags,
-			       GError **error)
+fu_nvme_device_write_firmware_stream (FuDevice *device,
+				      GInputStream *stream,
+				      gsize streamsz,
+				      FwupdInstallFlags flags,
+				      GError **error)
 {
 	FuNvmeDevice *self = FU_NVME_DEVICE (device);
-	g_autoptr(GBytes) fw2 = NULL;
-	g_autoptr(GBytes) fw = NULL;
-	g_autoptr(GPtrArray) chunks = NULL;
-	guint64 block_size = self->write_block_size > 0 ?
-			     self->write_block_size : 0x1000;
-
-	/* get default image */
-	fw = fu_firmware_get_image_default_bytes (firmware, error);
-	if (fw == NULL)
-		return FALSE;
+	gsize block_size = self->write_block_size > 0 ?
+			   self->write_block_size : 0x1000;
+	guint blocks = (streamsz + block_size - 1) / block_size;
+	g_autofree guint8 *buf = g_malloc (block_size);
 
-	/* some vendors provide firmware files whose sizes are not multiples
-	 * of blksz *and* the device won't accept blocks of different sizes */
-	if (fu_device_has_custom_flag (device, "force-align")) {
-		fw2 = fu_common_bytes_align (fw, block_size, 0xff);
-	} else {
-		fw2 = g_bytes_ref (fw);
-	}
+	/* write each block as it arrives */
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
+	for (guint i = 0; ; i++) {
+		gsize bytes_read = 0;
+		if (!g_input_stream_read_all (stream, buf, block_size,
+					      &bytes_read, NULL, error)) {
+			g_prefix_error (error, "failed to read chunk %u: ", i);
+			return FALSE;
+		}
 
-	/* build packets */
-	chunks = fu_chunk_array_new_from_bytes (fw2,
-						0x00,		/* start_addr */
-						0x00,		/* page_sz */
-						block_size);	/* block size */
+		/* the stream is only known good once it has all been read */
+		if (bytes_read == 0)
+			break;
 
-	/* write each block */
-	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
+		/* some vendors provide firmware files whose sizes are not multiples
+		 * of blksz *and* the device won't accept blocks of different sizes */
+		if (bytes_read < block_size &&
+		    fu_device_has_custom_flag (device, "force-align")) {
+			memset (buf + bytes_read, 0xff, block_size - bytes_read);
+			bytes_read = block_size;
+		}
 		if (!fu_nvme_device_fw_download (self,
-						 chk->address,
-						 chk->data,
-						 chk->data_sz,
+						 i * block_size,
+						 buf,
+						 bytes_read,
 						 error)) {
 			g_prefix_error (error, "failed to write chunk %u: ", i);
 			return FALSE;
 		}
-		fu_device_set_progress_full (device, (gsize) i, (gsize) chunks->len + 1);
+		fu_device_set_progress_full (device, (gsize) i, (gsize) blocks + 1);
+	}
+
+	/* committed by the plugin once every drive has the new image */
+	if (self->commit_staged) {
+		g_debug ("download complete, commit is staged");
+		self->commit_pending = TRUE;
+		fu_device_set_progress (device, 100);
+		return TRUE;
 	}
 
 	/* commit */
+	if (!fu_nvme_device_commit (self, error))
+		return FALSE;
+
+	/* success! */
+	fu_device_set_progress (device, 100);
+	return TRUE;
+}
+
+/**
+ * fu_nvme_device_commit:
+ * @self: A #FuNvmeDevice, which must be open
+ * @error: A #GError, or %NULL
+ *
+ * Commits the downloaded image to a slot chosen by the controller, which is
+ * activated on the next reset.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_nvme_device_commit (FuNvmeDevice *self, GError **error)
+{
+	g_return_val_if_fail (FU_IS_NVME_DEVICE (self), FALSE);
 	if (!fu_nvme_device_fw_commit (self,
 				       0x00,	/* let controller choose */
 				       0x01,	/* download replaces, activated on reboot */
@@ -360,12 +392,59 @@ fu_nvme_device_write_firmware (FuDevice *device,
 		g_prefix_error (error, "failed to commit to auto slot: ");
 		return FALSE;
 	}
-
-	/* success! */
-	fu_device_set_progress (device, 100);
+	self->commit_pending = FALSE;
 	return TRUE;
 }
 
+/**
+ * fu_nvme_device_set_commit_staged:
+ * @self: A #FuNvmeDevice
+ * @commit_staged: %TRUE to only download the image when writing firmware
+ *
+ * Sets whether the image should be committed by fu_nvme_device_commit()
+ * rather than straight after the download.
+ **/
+void
+fu_nvme_device_set_commit_staged (FuNvmeDevice *self, gboolean commit_staged)
+{
+	g_return_if_fail (FU_IS_NVME_DEVICE (self));
+	self->commit_staged = commit_staged;
+	self->commit_pending = FALSE;
+}
+
+gboolean
+fu_nvme_device_get_commit_staged (FuNvmeDevice *self)
+{
+	g_return_val_if_fail (FU_IS_NVME_DEVICE (self), FALSE);
+	return self->commit_staged;
+}
+
+gboolean
+fu_nvme_device_get_commit_pending (FuNvmeDevice *self)
+{
+	g_return_val_if_fail (FU_IS_NVME_DEVICE (self), FALSE);
+	return self->commit_pending;
+}
+
+static gboolean
+fu_nvme_device_write_firmware (FuDevice *device,
+			       FuFirmware *firmware,
+			       FwupdInstallFlags flags,
+			       GError **error)
+{
+	g_autoptr(GBytes) fw = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+
+	/* get default image */
+	fw = fu_firmware_get_image_default_bytes (firmware, error);
+	if (fw == NULL)
+		return FALSE;
+	stream = g_memory_input_stream_new_from_bytes (fw);
+	return fu_nvme_device_write_firmware_stream (device, stream,
+						     g_bytes_get_size (fw),
+						     flags, error);
+}
+
 static gboolean
 fu_nvme_device_set_quirk_kv (FuDevice *device,
 			     const gchar *key,
@@ -416,6 +495,7 @@ fu_nvme_device_class_init (FuNvmeDeviceClass *klass)
 	klass_device->set_quirk_kv = fu_nvme_device_set_quirk_kv;
 	klass_device->setup = fu_nvme_device_setup;
 	klass_device->write_firmware = fu_nvme_device_write_firmware;
+	klass_device->write_firmware_stream = fu_nvme_device_write_firmware_stream;
 	klass_udev_device->probe = fu_nvme_device_probe;
 }
 
@@ -14,3 +14,9 @@ G_DECLARE_FINAL_TYPE (FuNvmeDevice, fu_nvme_device, FU, NVME_DEVICE, FuUdevDevic
 FuNvmeDevice	*fu_nvme_device_new_from_blob		(const guint8	*buf,
 							 gsize		 sz,
 							 GError		**error);
+gboolean	 fu_nvme_device_commit			(FuNvmeDevice	*self,
+							 GError		**error);
+void		 fu_nvme_device_set_commit_staged	(FuNvmeDevice	*self,
+							 gboolean	 commit_staged);
+gboolean	 fu_nvme_device_get_commit_staged	(FuNvmeDevice	*self);
+gboolean	 fu_nvme_device_get_commit_pending	(FuNvmeDevice	*self);
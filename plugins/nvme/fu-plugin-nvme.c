@@ -18,3 +18,78 @@ fu_plugin_init (FuPlugin *plugin)
 	fu_plugin_add_udev_subsystem (plugin, "nvme");
 	fu_plugin_set_device_gtype (plugin, FU_TYPE_NVME_DEVICE);
 }
+
+/* when several drives are updated in one transaction, e.g. identical drives
+ * in a storage server, the images are downloaded first and then only
+ * committed if all the downloads succeeded */
+gboolean
+fu_plugin_composite_prepare (FuPlugin *plugin,
+			     GPtrArray *devices,
+			     GError **error)
+{
+	g_autoptr(GPtrArray) devices_nvme = g_ptr_array_new ();
+
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *dev = g_ptr_array_index (devices, i);
+		if (FU_IS_NVME_DEVICE (dev))
+			g_ptr_array_add (devices_nvme, dev);
+	}
+	if (devices_nvme->len < 2)
+		return TRUE;
+	g_debug ("staging commit for %u drives", devices_nvme->len);
+	for (guint i = 0; i < devices_nvme->len; i++) {
+		FuNvmeDevice *dev = g_ptr_array_index (devices_nvme, i);
+		fu_nvme_device_set_commit_staged (dev, TRUE);
+	}
+	return TRUE;
+}
+
+gboolean
+fu_plugin_composite_cleanup (FuPlugin *plugin,
+			     GPtrArray *devices,
+			     GError **error)
+{
+	gboolean all_pending = TRUE;
+	g_autoptr(GPtrArray) devices_nvme = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *dev = g_ptr_array_index (devices, i);
+		if (!FU_IS_NVME_DEVICE (dev))
+			continue;
+		if (!fu_nvme_device_get_commit_staged (FU_NVME_DEVICE (dev)))
+			continue;
+		if (!fu_nvme_device_get_commit_pending (FU_NVME_DEVICE (dev)))
+			all_pending = FALSE;
+		g_ptr_array_add (devices_nvme, g_object_ref (dev));
+	}
+
+	/* stop staging, so that any later update is committed straight away */
+	for (guint i = 0; i < devices_nvme->len; i++) {
+		FuNvmeDevice *dev = g_ptr_array_index (devices_nvme, i);
+		fu_nvme_device_set_commit_staged (dev, FALSE);
+	}
+
+	/* do not activate anything unless every drive has the new image */
+	if (!all_pending) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_WRITE,
+			     "not all of the %u drives were downloaded, so not committing",
+			     devices_nvme->len);
+		return FALSE;
+	}
+
+	/* commit in one step */
+	for (guint i = 0; i < devices_nvme->len; i++) {
+		FuNvmeDevice *dev = g_ptr_array_index (devices_nvme, i);
+		g_autoptr(FuDeviceLocker) locker = fu_device_locker_new (dev, error);
+		if (locker == NULL)
+			return FALSE;
+		if (!fu_nvme_device_commit (dev, error)) {
+			g_prefix_error (error, "failed to commit %s: ",
+					fu_device_get_name (FU_DEVICE (dev)));
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
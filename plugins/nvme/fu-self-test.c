@@ -33,6 +33,12 @@ fu_nvme_cns_func (void)
 	g_assert_cmpstr (fu_device_get_version (FU_DEVICE (dev)), ==, "410557LA");
 	g_assert_cmpstr (fu_device_get_serial (FU_DEVICE (dev)), ==, "37RSDEADBEEF");
 	g_assert_cmpstr (fu_device_get_guid_default (FU_DEVICE (dev)), ==, "e1409b09-50cf-5aef-8ad8-760b9022f88d");
+
+	/* nothing is pending until the image has been downloaded */
+	g_assert_false (fu_nvme_device_get_commit_staged (dev));
+	fu_nvme_device_set_commit_staged (dev, TRUE);
+	g_assert_true (fu_nvme_device_get_commit_staged (dev));
+	g_assert_false (fu_nvme_device_get_commit_pending (dev));
 }
 
 static void
@@ -76,6 +76,7 @@ fu_rom_pci_strstr (FuRomPciHeader *hdr, const gchar *needle)
 {
 	gsize needle_len;
 	guint8 *haystack;
+	guint8 *haystack_end;
 	gsize haystack_len;
 
 	if (needle == NULL || needle[0] == '\0')
@@ -89,9 +90,17 @@ fu_rom_pci_strstr (FuRomPciHeader *hdr, const gchar *needle)
 	needle_len = strlen (needle);
 	if (needle_len > haystack_len)
 		return NULL;
-	for (guint i = 0; i < haystack_len - needle_len; i++) {
-		if (memcmp (haystack + i, needle, needle_len) == 0)
-			return &haystack[i];
+
+	/* let memchr() skip to each possible first byte rather than comparing
+	 * the needle at every offset */
+	haystack_end = haystack + haystack_len - needle_len;
+	while (haystack < haystack_end) {
+		haystack = memchr (haystack, needle[0], haystack_end - haystack);
+		if (haystack == NULL)
+			return NULL;
+		if (memcmp (haystack, needle, needle_len) == 0)
+			return haystack;
+		haystack++;
 	}
 	return NULL;
 }
@@ -696,6 +705,32 @@ fu_rom_load_file (FuRom *self, GFile *file, FuRomLoadFlags flags,
 
 	g_return_val_if_fail (FU_IS_ROM (self), FALSE);
 
+	/* regular files can be mapped rather than copied into a buffer; the
+	 * mapping is private so blanking the serial numbers is not written back */
+	fn = g_file_get_path (file);
+	if (fn != NULL && !g_str_has_prefix (fn, "/sys")) {
+		g_autoptr(GMappedFile) mapped = NULL;
+		mapped = g_mapped_file_new (fn, TRUE, &error_local);
+		if (mapped == NULL) {
+			g_set_error_literal (error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_AUTH_FAILED,
+					     error_local->message);
+			return FALSE;
+		}
+		sz = (gssize) MIN (g_mapped_file_get_length (mapped), (gsize) buffer_sz);
+		if (sz < 512) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "Firmware too small: %" G_GSSIZE_FORMAT " bytes", sz);
+			return FALSE;
+		}
+		return fu_rom_load_data (self,
+					 (guint8 *) g_mapped_file_get_contents (mapped),
+					 (gsize) sz, flags, cancellable, error);
+	}
+
 	/* open file */
 	stream = G_INPUT_STREAM (g_file_read (file, cancellable, &error_local));
 	if (stream == NULL) {
@@ -707,8 +742,7 @@ fu_rom_load_file (FuRom *self, GFile *file, FuRomLoadFlags flags,
 	}
 
 	/* we have to enable the read for devices */
-	fn = g_file_get_path (file);
-	if (g_str_has_prefix (fn, "/sys")) {
+	if (fn != NULL && g_str_has_prefix (fn, "/sys")) {
 		g_autoptr(GFileOutputStream) output_stream = NULL;
 		output_stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE,
 						cancellable, error);
@@ -117,6 +117,7 @@ fu_plugin_init (FuPlugin *plugin)
 {
 	FuPluginData *data = fu_plugin_alloc_data (plugin, sizeof (FuPluginData));
 	data->client = fu_redfish_client_new ();
+	fu_plugin_add_flag (plugin, FU_PLUGIN_FLAG_THREADED_COLDPLUG);
 	fu_plugin_set_build_hash (plugin, FU_BUILD_HASH);
 }
 
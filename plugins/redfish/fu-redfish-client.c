@@ -18,6 +18,13 @@
 #include "fu-redfish-client.h"
 #include "fu-redfish-common.h"
 
+/* also the number of inventory members fetched at the same time */
+#define FU_REDFISH_CLIENT_MAX_CONNS		8
+
+#define FU_REDFISH_CLIENT_TASK_POLL_MIN		1000	/* ms */
+#define FU_REDFISH_CLIENT_TASK_POLL_MAX		10000	/* ms */
+#define FU_REDFISH_CLIENT_TASK_TIMEOUT		1800	/* s */
+
 struct _FuRedfishClient
 {
 	GObject			 parent_instance;
@@ -28,6 +35,7 @@ struct _FuRedfishClient
 	gchar			*password;
 	gchar			*update_uri_path;
 	gchar			*push_uri_path;
+	gchar			*multipart_push_uri_path;
 	gboolean		 auth_created;
 	gboolean		 use_https;
 	gboolean		 cacheck;
@@ -58,11 +66,10 @@ fu_redfish_client_set_auth (FuRedfishClient *self, SoupURI *uri,
 	}
 }
 
-static GBytes *
-fu_redfish_client_fetch_data (FuRedfishClient *self, const gchar *uri_path, GError **error)
+static SoupMessage *
+fu_redfish_client_new_message (FuRedfishClient *self, const gchar *uri_path, GError **error)
 {
-	guint status_code;
-	g_autoptr(SoupMessage) msg = NULL;
+	SoupMessage *msg;
 	g_autoptr(SoupURI) uri = NULL;
 
 	/* create URI */
@@ -81,19 +88,75 @@ fu_redfish_client_fetch_data (FuRedfishClient *self, const gchar *uri_path, GErr
 		return NULL;
 	}
 	fu_redfish_client_set_auth (self, uri, msg);
-	status_code = soup_session_send_message (self->session, msg);
-	if (status_code != SOUP_STATUS_OK) {
-		g_autofree gchar *tmp = soup_uri_to_string (uri, FALSE);
+	return msg;
+}
+
+static GBytes *
+fu_redfish_client_message_get_data (SoupMessage *msg, GError **error)
+{
+	if (msg->status_code != SOUP_STATUS_OK) {
+		g_autofree gchar *tmp = soup_uri_to_string (soup_message_get_uri (msg), FALSE);
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_INVALID_FILE,
 			     "failed to download %s: %s",
-			     tmp, soup_status_get_phrase (status_code));
+			     tmp, soup_status_get_phrase (msg->status_code));
 		return NULL;
 	}
 	return g_bytes_new (msg->response_body->data, msg->response_body->length);
 }
 
+static GBytes *
+fu_redfish_client_fetch_data (FuRedfishClient *self, const gchar *uri_path, GError **error)
+{
+	g_autoptr(SoupMessage) msg = NULL;
+
+	msg = fu_redfish_client_new_message (self, uri_path, error);
+	if (msg == NULL)
+		return NULL;
+	soup_session_send_message (self->session, msg);
+	return fu_redfish_client_message_get_data (msg, error);
+}
+
+typedef struct {
+	GMainLoop		*loop;
+	guint			 pending;
+} FuRedfishClientHelper;
+
+static void
+fu_redfish_client_fetch_cb (SoupSession *session, SoupMessage *msg, gpointer user_data)
+{
+	FuRedfishClientHelper *helper = (FuRedfishClientHelper *) user_data;
+	if (--helper->pending == 0)
+		g_main_loop_quit (helper->loop);
+}
+
+/* the session limits how many of these are in flight at once, and reuses
+ * the connections to the BMC for the remaining requests */
+static void
+fu_redfish_client_fetch_messages (FuRedfishClient *self, GPtrArray *msgs)
+{
+	g_autoptr(GMainContext) context = g_main_context_new ();
+	g_autoptr(GMainLoop) loop = g_main_loop_new (context, FALSE);
+	FuRedfishClientHelper helper = {
+		.loop = loop,
+		.pending = msgs->len,
+	};
+
+	if (msgs->len == 0)
+		return;
+	g_main_context_push_thread_default (context);
+	for (guint i = 0; i < msgs->len; i++) {
+		SoupMessage *msg = g_ptr_array_index (msgs, i);
+		soup_session_queue_message (self->session,
+					    g_object_ref (msg),
+					    fu_redfish_client_fetch_cb,
+					    &helper);
+	}
+	g_main_loop_run (loop);
+	g_main_context_pop_thread_default (context);
+}
+
 static gboolean
 fu_redfish_client_coldplug_member (FuRedfishClient *self,
 				   JsonObject *member,
@@ -156,13 +219,13 @@ fu_redfish_client_coldplug_collection (FuRedfishClient *self,
 	JsonArray *members;
 	JsonNode *node_root;
 	JsonObject *member;
+	g_autoptr(GPtrArray) msgs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 
 	members = json_object_get_array_member (collection, "Members");
 	for (guint i = 0; i < json_array_get_length (members); i++) {
-		g_autoptr(JsonParser) parser = json_parser_new ();
-		g_autoptr(GBytes) blob = NULL;
 		JsonObject *member_id;
 		const gchar *member_uri;
+		SoupMessage *msg;
 
 		member_id = json_array_get_object_element (members, i);
 		member_uri = json_object_get_string_member (member_id, "@odata.id");
@@ -173,9 +236,22 @@ fu_redfish_client_coldplug_collection (FuRedfishClient *self,
 					     "no @odata.id string");
 			return FALSE;
 		}
+		msg = fu_redfish_client_new_message (self, member_uri, error);
+		if (msg == NULL)
+			return FALSE;
+		g_ptr_array_add (msgs, msg);
+	}
+
+	/* fetch all the members at the same time */
+	fu_redfish_client_fetch_messages (self, msgs);
 
-		/* try to connect */
-		blob = fu_redfish_client_fetch_data (self, member_uri, error);
+	/* add the devices in the same order as the collection */
+	for (guint i = 0; i < msgs->len; i++) {
+		SoupMessage *msg = g_ptr_array_index (msgs, i);
+		g_autoptr(JsonParser) parser = json_parser_new ();
+		g_autoptr(GBytes) blob = NULL;
+
+		blob = fu_redfish_client_message_get_data (msg, error);
 		if (blob == NULL)
 			return FALSE;
 
@@ -325,15 +401,21 @@ fu_redfish_client_coldplug (FuRedfishClient *self, GError **error)
 				     "service is not enabled");
 		return FALSE;
 	}
-	if (!json_object_has_member (obj_root, "HttpPushUri")) {
+	if (json_object_has_member (obj_root, "MultipartHttpPushUri")) {
+		self->multipart_push_uri_path =
+			g_strdup (json_object_get_string_member (obj_root, "MultipartHttpPushUri"));
+	}
+	if (!json_object_has_member (obj_root, "HttpPushUri") &&
+	    self->multipart_push_uri_path == NULL) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_NOT_SUPPORTED,
 				     "HttpPushUri is not available");
 		return FALSE;
 	}
-	self->push_uri_path = g_strdup (json_object_get_string_member (obj_root, "HttpPushUri"));
-	if (self->push_uri_path == NULL) {
+	if (json_object_has_member (obj_root, "HttpPushUri"))
+		self->push_uri_path = g_strdup (json_object_get_string_member (obj_root, "HttpPushUri"));
+	if (self->push_uri_path == NULL && self->multipart_push_uri_path == NULL) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_NOT_SUPPORTED,
@@ -568,11 +650,155 @@ fu_redfish_client_set_smbios_interfaces (FuRedfishClient *self,
 	return TRUE;
 }
 
+typedef struct {
+	FuDevice		*device;
+	gsize			 done;
+	gsize			 total;
+} FuRedfishClientUpload;
+
+static void
+fu_redfish_client_wrote_body_data_cb (SoupMessage *msg, SoupBuffer *chunk, gpointer user_data)
+{
+	FuRedfishClientUpload *upload = (FuRedfishClientUpload *) user_data;
+	upload->done += chunk->length;
+	fu_device_set_progress_full (upload->device, upload->done, upload->total);
+}
+
+static gboolean
+fu_redfish_client_parse_task (guint status_code,
+			      GBytes *blob,
+			      FuDevice *device,
+			      gboolean *done,
+			      GError **error)
+{
+	JsonNode *node_root;
+	JsonObject *obj_root = NULL;
+	const gchar *state;
+	g_autoptr(JsonParser) parser = json_parser_new ();
+
+	/* the final response of the operation does not have to be a task */
+	if (json_parser_load_from_data (parser,
+					g_bytes_get_data (blob, NULL),
+					(gssize) g_bytes_get_size (blob),
+					NULL)) {
+		node_root = json_parser_get_root (parser);
+		if (node_root != NULL && JSON_NODE_HOLDS_OBJECT (node_root))
+			obj_root = json_node_get_object (node_root);
+	}
+	if (obj_root == NULL) {
+		*done = status_code == SOUP_STATUS_OK;
+		return TRUE;
+	}
+	if (json_object_has_member (obj_root, "PercentComplete")) {
+		gint64 pc = json_object_get_int_member (obj_root, "PercentComplete");
+		if (pc >= 0 && pc <= 100)
+			fu_device_set_progress (device, (guint) pc);
+	}
+	if (!json_object_has_member (obj_root, "TaskState")) {
+		*done = status_code == SOUP_STATUS_OK;
+		return TRUE;
+	}
+	state = json_object_get_string_member (obj_root, "TaskState");
+	if (g_strcmp0 (state, "Exception") == 0 ||
+	    g_strcmp0 (state, "Killed") == 0 ||
+	    g_strcmp0 (state, "Cancelled") == 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_WRITE,
+			     "update task failed: %s", state);
+		return FALSE;
+	}
+	*done = g_strcmp0 (state, "Completed") == 0;
+	return TRUE;
+}
+
+/* the BMC may take many minutes to apply the image, so poll quickly while
+ * the task is making progress and back off when it is not */
+static gboolean
+fu_redfish_client_wait_for_task (FuRedfishClient *self,
+				 FuDevice *device,
+				 const gchar *location,
+				 GError **error)
+{
+	guint delay_ms = FU_REDFISH_CLIENT_TASK_POLL_MIN;
+	guint progress_old = 0;
+	g_autofree gchar *uri_path = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* the Location header may be an absolute URI */
+	if (g_str_has_prefix (location, "/")) {
+		uri_path = g_strdup (location);
+	} else {
+		g_autoptr(SoupURI) uri = soup_uri_new (location);
+		if (uri == NULL) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "invalid task monitor %s",
+				     location);
+			return FALSE;
+		}
+		uri_path = g_strdup (soup_uri_get_path (uri));
+	}
+
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_BUSY);
+	fu_device_set_progress (device, 0);
+	while (TRUE) {
+		gboolean done = FALSE;
+		g_autoptr(GBytes) blob = NULL;
+		g_autoptr(SoupMessage) msg = NULL;
+
+		msg = fu_redfish_client_new_message (self, uri_path, error);
+		if (msg == NULL)
+			return FALSE;
+		soup_session_send_message (self->session, msg);
+		if (msg->status_code == SOUP_STATUS_NO_CONTENT)
+			break;
+		if (msg->status_code != SOUP_STATUS_OK &&
+		    msg->status_code != SOUP_STATUS_ACCEPTED) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_WRITE,
+				     "failed to get task %s: %s",
+				     uri_path,
+				     soup_status_get_phrase (msg->status_code));
+			return FALSE;
+		}
+		blob = g_bytes_new (msg->response_body->data, msg->response_body->length);
+		if (!fu_redfish_client_parse_task (msg->status_code, blob, device, &done, error))
+			return FALSE;
+		if (done)
+			break;
+
+		/* still running */
+		if (g_timer_elapsed (timer, NULL) > FU_REDFISH_CLIENT_TASK_TIMEOUT) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_WRITE,
+				     "task %s did not complete after %us",
+				     uri_path, (guint) FU_REDFISH_CLIENT_TASK_TIMEOUT);
+			return FALSE;
+		}
+		if (fu_device_get_progress (device) != progress_old) {
+			progress_old = fu_device_get_progress (device);
+			delay_ms = FU_REDFISH_CLIENT_TASK_POLL_MIN;
+		} else {
+			delay_ms = MIN (delay_ms * 2, FU_REDFISH_CLIENT_TASK_POLL_MAX);
+		}
+		g_usleep (delay_ms * 1000);
+	}
+	fu_device_set_progress (device, 100);
+	return TRUE;
+}
+
 gboolean
 fu_redfish_client_update (FuRedfishClient *self, FuDevice *device, GBytes *blob_fw,
 			  GError **error)
 {
 	FwupdRelease *release;
+	FuRedfishClientUpload upload = { device, 0, 0 };
+	const gchar *location;
+	const gchar *push_uri_path;
 	g_autofree gchar *filename = NULL;
 
 	guint status_code;
@@ -594,21 +820,36 @@ fu_redfish_client_update (FuRedfishClient *self, FuDevice *device, GBytes *blob_
 	}
 
 	/* create URI */
+	push_uri_path = self->multipart_push_uri_path != NULL ?
+			self->multipart_push_uri_path : self->push_uri_path;
 	uri = soup_uri_new (NULL);
 	soup_uri_set_scheme (uri, self->use_https ? "https" : "http");
-	soup_uri_set_path (uri, self->push_uri_path);
+	soup_uri_set_path (uri, push_uri_path);
 	soup_uri_set_host (uri, self->hostname);
 	soup_uri_set_port (uri, self->port);
 	uri_str = soup_uri_to_string (uri, FALSE);
 
-	/* Create the multipart request */
+	/* Create the multipart request, referencing the image rather than
+	 * copying it as it may be very large */
 	multipart = soup_multipart_new (SOUP_FORM_MIME_TYPE_MULTIPART);
-	buffer = soup_buffer_new (SOUP_MEMORY_COPY,
-				  g_bytes_get_data (blob_fw, NULL),
-				  g_bytes_get_size (blob_fw));
-	soup_multipart_append_form_file (multipart, filename, filename,
-					 "application/octet-stream",
-					 buffer);
+	buffer = soup_buffer_new_with_owner (g_bytes_get_data (blob_fw, NULL),
+					     g_bytes_get_size (blob_fw),
+					     g_bytes_ref (blob_fw),
+					     (GDestroyNotify) g_bytes_unref);
+	if (self->multipart_push_uri_path != NULL) {
+		g_autoptr(SoupBuffer) params = NULL;
+		params = soup_buffer_new (SOUP_MEMORY_STATIC, "{}", 2);
+		soup_multipart_append_form_file (multipart, "UpdateParameters", NULL,
+						 "application/json",
+						 params);
+		soup_multipart_append_form_file (multipart, "UpdateFile", filename,
+						 "application/octet-stream",
+						 buffer);
+	} else {
+		soup_multipart_append_form_file (multipart, filename, filename,
+						 "application/octet-stream",
+						 buffer);
+	}
 	msg = soup_form_request_new_from_multipart (uri_str, multipart);
 	if (msg == NULL) {
 		g_set_error (error,
@@ -618,8 +859,15 @@ fu_redfish_client_update (FuRedfishClient *self, FuDevice *device, GBytes *blob_
 		return FALSE;
 	}
 	fu_redfish_client_set_auth (self, uri, msg);
+	upload.total = msg->request_body->length;
+	g_signal_connect (msg, "wrote-body-data",
+			  G_CALLBACK (fu_redfish_client_wrote_body_data_cb),
+			  &upload);
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	status_code = soup_session_send_message (self->session, msg);
-	if (status_code != SOUP_STATUS_OK) {
+	if (status_code != SOUP_STATUS_OK &&
+	    status_code != SOUP_STATUS_ACCEPTED &&
+	    status_code != SOUP_STATUS_NO_CONTENT) {
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_INVALID_FILE,
@@ -629,6 +877,11 @@ fu_redfish_client_update (FuRedfishClient *self, FuDevice *device, GBytes *blob_
 		return FALSE;
 	}
 
+	/* the BMC is applying the image in the background */
+	location = soup_message_headers_get_one (msg->response_headers, "Location");
+	if (status_code == SOUP_STATUS_ACCEPTED && location != NULL)
+		return fu_redfish_client_wait_for_task (self, device, location, error);
+
 	return TRUE;
 }
 
@@ -665,6 +918,8 @@ fu_redfish_client_setup (FuRedfishClient *self, GBytes *smbios_table, GError **e
 	user_agent = g_strdup_printf ("%s/%s", PACKAGE_NAME, PACKAGE_VERSION);
 	self->session = soup_session_new_with_options (SOUP_SESSION_USER_AGENT, user_agent,
 						       SOUP_SESSION_TIMEOUT, 60,
+						       SOUP_SESSION_MAX_CONNS_PER_HOST,
+						       FU_REDFISH_CLIENT_MAX_CONNS,
 						       NULL);
 	if (self->session == NULL) {
 		g_set_error_literal (error,
@@ -818,6 +1073,7 @@ fu_redfish_client_finalize (GObject *object)
 		g_object_unref (self->session);
 	g_free (self->update_uri_path);
 	g_free (self->push_uri_path);
+	g_free (self->multipart_push_uri_path);
 	g_free (self->hostname);
 	g_free (self->username);
 	g_free (self->password);
@@ -10,6 +10,7 @@
 
 #define FU_RTS54HID_TRANSFER_BLOCK_SIZE			0x80
 #define FU_RTS54FU_HID_REPORT_LENGTH			0xc0
+#define FU_RTS54HID_REPORTS_IN_FLIGHT			4
 
 /* [vendor-cmd:64] [data-payload:128] */
 #define FU_RTS54HID_CMD_BUFFER_OFFSET_DATA		0x40
@@ -24,6 +24,8 @@ struct _FuRts54HidModule {
 
 G_DEFINE_TYPE (FuRts54HidModule, fu_rts54hid_module, FU_TYPE_DEVICE)
 
+#define FU_RTS54HID_MODULE_CHUNKS_PER_BATCH		32
+
 static void
 fu_rts54hid_module_to_string (FuDevice *module, guint idt, GString *str)
 {
@@ -47,13 +49,12 @@ fu_rts54hid_module_get_parent (FuRts54HidModule *self, GError **error)
 	return FU_RTS54HID_DEVICE (parent);
 }
 
-static gboolean
-fu_rts54hid_module_i2c_write (FuRts54HidModule *self,
-			      const guint8 *data,
-			      guint8 data_sz,
-			      GError **error)
+static GByteArray *
+fu_rts54hid_module_build_i2c_write (FuRts54HidModule *self,
+				    const guint8 *data,
+				    guint8 data_sz,
+				    GError **error)
 {
-	FuRts54HidDevice *parent;
 	const FuRts54HidCmdBuffer cmd_buffer = {
 		.cmd = FU_RTS54HID_CMD_WRITE_DATA,
 		.ext = FU_RTS54HID_EXT_I2C_WRITE,
@@ -63,23 +64,40 @@ fu_rts54hid_module_i2c_write (FuRts54HidModule *self,
 				   .data_sz = self->register_addr_len,
 				   .speed = self->i2c_speed | 0x80},
 	};
-	guint8 buf[FU_RTS54FU_HID_REPORT_LENGTH] = { 0 };
+	g_autoptr(GByteArray) buf = g_byte_array_new ();
 
-	g_return_val_if_fail (data_sz <= 128, FALSE);
-	g_return_val_if_fail (data != NULL, FALSE);
-	g_return_val_if_fail (data_sz != 0, FALSE);
+	g_return_val_if_fail (data_sz <= 128, NULL);
+	g_return_val_if_fail (data != NULL, NULL);
+	g_return_val_if_fail (data_sz != 0, NULL);
+
+	g_byte_array_set_size (buf, FU_RTS54FU_HID_REPORT_LENGTH);
+	memset (buf->data, 0x0, buf->len);
+	memcpy (buf->data, &cmd_buffer, sizeof(cmd_buffer));
+	if (!fu_memcpy_safe (buf->data, buf->len, FU_RTS54HID_CMD_BUFFER_OFFSET_DATA,	/* dst */
+			     data, data_sz, 0x0,					/* src */
+			     data_sz, error))
+		return NULL;
+	return g_steal_pointer (&buf);
+}
+
+static gboolean
+fu_rts54hid_module_i2c_write (FuRts54HidModule *self,
+			      const guint8 *data,
+			      guint8 data_sz,
+			      GError **error)
+{
+	FuRts54HidDevice *parent;
+	g_autoptr(GByteArray) buf = NULL;
 
 	/* get parent to issue command */
 	parent = fu_rts54hid_module_get_parent (self, error);
 	if (parent == NULL)
 		return FALSE;
 
-	memcpy (buf, &cmd_buffer, sizeof(cmd_buffer));
-	if (!fu_memcpy_safe (buf, sizeof(buf), FU_RTS54HID_CMD_BUFFER_OFFSET_DATA,	/* dst */
-			     data, data_sz, 0x0,					/* src */
-			     data_sz, error))
+	buf = fu_rts54hid_module_build_i2c_write (self, data, data_sz, error);
+	if (buf == NULL)
 		return FALSE;
-	if (!fu_hid_device_set_report (FU_HID_DEVICE (parent), 0x0, buf, sizeof(buf),
+	if (!fu_hid_device_set_report (FU_HID_DEVICE (parent), 0x0, buf->data, buf->len,
 				       FU_RTS54HID_DEVICE_TIMEOUT * 2,
 				       FU_HID_DEVICE_FLAG_NONE,
 				       error)) {
@@ -89,6 +107,44 @@ fu_rts54hid_module_i2c_write (FuRts54HidModule *self,
 	return TRUE;
 }
 
+/* the parent does not reply to each i2c write, so several can be queued */
+static gboolean
+fu_rts54hid_module_i2c_write_chunks (FuRts54HidModule *self,
+				     GPtrArray *chunks,
+				     guint idx,
+				     guint len,
+				     GError **error)
+{
+	FuRts54HidDevice *parent;
+	g_autoptr(GPtrArray) reports = NULL;
+
+	/* get parent to issue command */
+	parent = fu_rts54hid_module_get_parent (self, error);
+	if (parent == NULL)
+		return FALSE;
+
+	reports = g_ptr_array_new_with_free_func ((GDestroyNotify) g_byte_array_unref);
+	for (guint i = idx; i < idx + len; i++) {
+		FuChunk *chk = g_ptr_array_index (chunks, i);
+		GByteArray *buf = fu_rts54hid_module_build_i2c_write (self,
+								      chk->data,
+								      chk->data_sz,
+								      error);
+		if (buf == NULL)
+			return FALSE;
+		g_ptr_array_add (reports, buf);
+	}
+	if (!fu_hid_device_set_reports (FU_HID_DEVICE (parent), 0x0, reports,
+					FU_RTS54HID_REPORTS_IN_FLIGHT,
+					FU_RTS54HID_DEVICE_TIMEOUT * 2,
+					FU_HID_DEVICE_FLAG_NONE,
+					error)) {
+		g_prefix_error (error, "failed to write i2c @%04x: ", self->slave_addr);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_rts54hid_module_i2c_read (FuRts54HidModule *self,
 			     guint32 cmd,
@@ -251,20 +307,15 @@ fu_rts54hid_module_write_firmware (FuDevice *module,
 			return FALSE;
 	}
 
-	/* write each block */
+	/* write each block, queuing a batch at a time so progress still works */
 	fu_device_set_status (module, FWUPD_STATUS_DEVICE_WRITE);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
-
-		/* write chunk */
-		if (!fu_rts54hid_module_i2c_write (self,
-						   chk->data,
-						   chk->data_sz,
-						   error))
+	for (guint i = 0; i < chunks->len; i += FU_RTS54HID_MODULE_CHUNKS_PER_BATCH) {
+		guint len = MIN (chunks->len - i, FU_RTS54HID_MODULE_CHUNKS_PER_BATCH);
+		if (!fu_rts54hid_module_i2c_write_chunks (self, chunks, i, len, error))
 			return FALSE;
 
 		/* update progress */
-		fu_device_set_progress_full (module, (gsize) i, (gsize) chunks->len * 2);
+		fu_device_set_progress_full (module, (gsize) i + len, (gsize) chunks->len * 2);
 	}
 
 	/* success! */
@@ -358,6 +358,12 @@ fu_rts54hub_device_write_firmware (FuDevice *device,
 	for (guint i = 0; i < chunks->len; i++) {
 		FuChunk *chk = g_ptr_array_index (chunks, i);
 
+		/* the spare bank has just been erased */
+		if (fu_common_data_is_empty (chk->data, chk->data_sz)) {
+			fu_device_set_progress_full (device, (gsize) i, (gsize) chunks->len - 1);
+			continue;
+		}
+
 		/* write chunk */
 		if (!fu_rts54hub_device_write_flash (self,
 						     chk->address,
@@ -6,6 +6,12 @@
 
 #include "config.h"
 
+#ifdef HAVE_IOPERM
+#include <errno.h>
+#include <string.h>
+#include <sys/io.h>
+#endif
+
 #include "fu-superio-common.h"
 #include "fu-superio-device.h"
 
@@ -18,6 +24,7 @@ typedef struct
 	guint16			 pm1_iobad0;
 	guint16			 pm1_iobad1;
 	guint16			 id;
+	gboolean		 ioperm;
 } FuSuperioDevicePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (FuSuperioDevice, fu_superio_device, FU_TYPE_UDEV_DEVICE)
@@ -32,14 +39,69 @@ enum {
 	PROP_LAST
 };
 
+/* accessing the ports directly avoids a syscall for every byte, but this is
+ * only possible when running as root without the kernel being locked down */
+static void
+fu_superio_device_ioperm (FuSuperioDevice *self, gboolean enable)
+{
+#ifdef HAVE_IOPERM
+	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
+	const int turn_on = enable ? 1 : 0;
+
+	if (priv->ioperm == enable)
+		return;
+	if (priv->port == 0 || priv->pm1_iobad0 == 0 || priv->pm1_iobad1 == 0)
+		return;
+	if (ioperm (priv->port, 2, turn_on) != 0 ||
+	    ioperm (priv->pm1_iobad0, 1, turn_on) != 0 ||
+	    ioperm (priv->pm1_iobad1, 1, turn_on) != 0) {
+		g_debug ("failed to set ioperm, using /dev/port: %s", strerror (errno));
+		if (enable) {
+			ioperm (priv->port, 2, 0);
+			ioperm (priv->pm1_iobad0, 1, 0);
+			ioperm (priv->pm1_iobad1, 1, 0);
+		}
+		priv->ioperm = FALSE;
+		return;
+	}
+	priv->ioperm = enable;
+#endif
+}
+
+static gboolean
+fu_superio_device_outb (FuSuperioDevice *self, guint16 port, guint8 data, GError **error)
+{
+#ifdef HAVE_IOPERM
+	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
+	if (priv->ioperm) {
+		outb (data, port);
+		return TRUE;
+	}
+#endif
+	return fu_udev_device_pwrite (FU_UDEV_DEVICE (self), port, data, error);
+}
+
+static gboolean
+fu_superio_device_inb (FuSuperioDevice *self, guint16 port, guint8 *data, GError **error)
+{
+#ifdef HAVE_IOPERM
+	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
+	if (priv->ioperm) {
+		*data = inb (port);
+		return TRUE;
+	}
+#endif
+	return fu_udev_device_pread (FU_UDEV_DEVICE (self), port, data, error);
+}
+
 gboolean
 fu_superio_device_regval (FuSuperioDevice *self, guint8 addr,
 			  guint8 *data, GError **error)
 {
 	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
-	if (!fu_udev_device_pwrite (FU_UDEV_DEVICE (self), priv->port, addr, error))
+	if (!fu_superio_device_outb (self, priv->port, addr, error))
 		return FALSE;
-	if (!fu_udev_device_pread (FU_UDEV_DEVICE (self), priv->port + 1, data, error))
+	if (!fu_superio_device_inb (self, priv->port + 1, data, error))
 		return FALSE;
 	return TRUE;
 }
@@ -63,9 +125,9 @@ fu_superio_device_regwrite (FuSuperioDevice *self, guint8 addr,
 			    guint8 data, GError **error)
 {
 	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
-	if (!fu_udev_device_pwrite (FU_UDEV_DEVICE (self), priv->port, addr, error))
+	if (!fu_superio_device_outb (self, priv->port, addr, error))
 		return FALSE;
-	if (!fu_udev_device_pwrite (FU_UDEV_DEVICE (self), priv->port + 1, data, error))
+	if (!fu_superio_device_outb (self, priv->port + 1, data, error))
 		return FALSE;
 	return TRUE;
 }
@@ -144,26 +206,45 @@ fu_superio_device_check_id (FuSuperioDevice *self, GError **error)
 }
 
 static gboolean
-fu_superio_device_wait_for (FuSuperioDevice *self, guint8 mask, gboolean set, GError **error)
+typedef struct {
+	guint8		 mask;
+	gboolean	 set;
+} FuSuperioDeviceWaitHelper;
+
+static gboolean
+fu_superio_device_wait_for_cb (FuDevice *device,
+			       gboolean *done,
+			       gpointer user_data,
+			       GError **error)
 {
+	FuSuperioDevice *self = FU_SUPERIO_DEVICE (device);
 	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
-	g_autoptr(GTimer) timer = g_timer_new ();
-	do {
-		guint8 status = 0x00;
-		if (!fu_udev_device_pread (FU_UDEV_DEVICE (self), priv->pm1_iobad1, &status, error))
-			return FALSE;
-		if (g_timer_elapsed (timer, NULL) > FU_PLUGIN_SUPERIO_TIMEOUT)
-			break;
-		if (set && (status & mask) != 0)
-			return TRUE;
-		if (!set && (status & mask) == 0)
-			return TRUE;
-	} while (TRUE);
-	g_set_error (error,
-		     G_IO_ERROR,
-		     G_IO_ERROR_TIMED_OUT,
-		     "timed out whilst waiting for 0x%02x:%i", mask, set);
-	return FALSE;
+	FuSuperioDeviceWaitHelper *helper = (FuSuperioDeviceWaitHelper *) user_data;
+	guint8 status = 0x00;
+	if (!fu_superio_device_inb (self, priv->pm1_iobad1, &status, error))
+		return FALSE;
+	if (helper->set && (status & helper->mask) != 0)
+		*done = TRUE;
+	if (!helper->set && (status & helper->mask) == 0)
+		*done = TRUE;
+	return TRUE;
+}
+
+static gboolean
+fu_superio_device_wait_for (FuSuperioDevice *self, guint8 mask, gboolean set, GError **error)
+{
+	FuSuperioDeviceWaitHelper helper = {
+		.mask = mask,
+		.set = set,
+	};
+	if (!fu_device_wait_for (FU_DEVICE (self),
+				 fu_superio_device_wait_for_cb,
+				 (guint) (FU_PLUGIN_SUPERIO_TIMEOUT * 1000),
+				 &helper, error)) {
+		g_prefix_error (error, "failed waiting for 0x%02x:%i: ", mask, set);
+		return FALSE;
+	}
+	return TRUE;
 }
 
 gboolean
@@ -172,7 +253,7 @@ fu_superio_device_ec_read (FuSuperioDevice *self, guint8 *data, GError **error)
 	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
 	if (!fu_superio_device_wait_for (self, SIO_STATUS_EC_OBF, TRUE, error))
 		return FALSE;
-	return fu_udev_device_pread (FU_UDEV_DEVICE (self), priv->pm1_iobad0, data, error);
+	return fu_superio_device_inb (self, priv->pm1_iobad0, data, error);
 }
 
 gboolean
@@ -181,7 +262,7 @@ fu_superio_device_ec_write0 (FuSuperioDevice *self, guint8 data, GError **error)
 	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
 	if (!fu_superio_device_wait_for (self, SIO_STATUS_EC_IBF, FALSE, error))
 		return FALSE;
-	return fu_udev_device_pwrite (FU_UDEV_DEVICE (self), priv->pm1_iobad0, data, error);
+	return fu_superio_device_outb (self, priv->pm1_iobad0, data, error);
 }
 
 gboolean
@@ -190,7 +271,7 @@ fu_superio_device_ec_write1 (FuSuperioDevice *self, guint8 data, GError **error)
 	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
 	if (!fu_superio_device_wait_for (self, SIO_STATUS_EC_IBF, FALSE, error))
 		return FALSE;
-	return fu_udev_device_pwrite (FU_UDEV_DEVICE (self), priv->pm1_iobad1, data, error);
+	return fu_superio_device_outb (self, priv->pm1_iobad1, data, error);
 }
 
 static gboolean
@@ -201,11 +282,11 @@ fu_superio_device_ec_flush (FuSuperioDevice *self, GError **error)
 	g_autoptr(GTimer) timer = g_timer_new ();
 	do {
 		guint8 unused = 0;
-		if (!fu_udev_device_pread (FU_UDEV_DEVICE (self), priv->pm1_iobad1, &status, error))
+		if (!fu_superio_device_inb (self, priv->pm1_iobad1, &status, error))
 			return FALSE;
 		if ((status & SIO_STATUS_EC_OBF) == 0)
 			break;
-		if (!fu_udev_device_pread (FU_UDEV_DEVICE (self), priv->pm1_iobad0, &unused, error))
+		if (!fu_superio_device_inb (self, priv->pm1_iobad0, &unused, error))
 			return FALSE;
 		if (g_timer_elapsed (timer, NULL) > FU_PLUGIN_SUPERIO_TIMEOUT) {
 			g_set_error_literal (error,
@@ -292,6 +373,9 @@ fu_superio_device_setup (FuDevice *device, GError **error)
 					 &priv->pm1_iobad1, error))
 		return FALSE;
 
+	/* all the ports are now known */
+	fu_superio_device_ioperm (self, TRUE);
+
 	/* drain */
 	if (!fu_superio_device_ec_flush (self, error)) {
 		g_prefix_error (error, "failed to flush: ");
@@ -319,6 +403,21 @@ fu_superio_device_setup (FuDevice *device, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_superio_device_open (FuUdevDevice *device, GError **error)
+{
+	/* the PM1 ports are only known after the first setup */
+	fu_superio_device_ioperm (FU_SUPERIO_DEVICE (device), TRUE);
+	return TRUE;
+}
+
+static gboolean
+fu_superio_device_close (FuUdevDevice *device, GError **error)
+{
+	fu_superio_device_ioperm (FU_SUPERIO_DEVICE (device), FALSE);
+	return TRUE;
+}
+
 static FuFirmware *
 fu_superio_device_prepare_firmware (FuDevice *device,
 				    GBytes *fw,
@@ -413,6 +512,7 @@ fu_superio_device_class_init (FuSuperioDeviceClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	GParamSpec *pspec;
 	FuDeviceClass *klass_device = FU_DEVICE_CLASS (klass);
+	FuUdevDeviceClass *klass_udev_device = FU_UDEV_DEVICE_CLASS (klass);
 
 	/* properties */
 	object_class->get_property = fu_superio_device_get_property;
@@ -439,5 +539,7 @@ fu_superio_device_class_init (FuSuperioDeviceClass *klass)
 	klass_device->to_string = fu_superio_device_to_string;
 	klass_device->probe = fu_superio_device_probe;
 	klass_device->setup = fu_superio_device_setup;
+	klass_udev_device->open = fu_superio_device_open;
+	klass_udev_device->close = fu_superio_device_close;
 	klass_device->prepare_firmware = fu_superio_device_prepare_firmware;
 }
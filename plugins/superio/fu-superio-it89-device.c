@@ -511,35 +511,51 @@ fu_superio_it89_device_check_eflash (FuSuperioDevice *self, GError **error)
 static gboolean
 fu_superio_it89_device_write_chunk (FuSuperioDevice *self, FuChunk *chk, GError **error)
 {
+	g_autoptr(GBytes) fw0 = NULL;
 	g_autoptr(GBytes) fw1 = NULL;
-	g_autoptr(GBytes) fw2 = NULL;
+	g_autoptr(GBytes) fw2 = g_bytes_new_static (chk->data, chk->data_sz);
 	g_autoptr(GBytes) fw3 = NULL;
 
-	/* erase page */
-	if (!fu_superio_it89_device_erase_addr (self, chk->address, error)) {
-		g_prefix_error (error, "failed to erase @0x%04x", (guint) chk->address);
-		return FALSE;
-	}
-
-	/* check erased */
-	fw1 = fu_superio_it89_device_read_addr (self, chk->address,
+	/* reading is much quicker than erasing and writing */
+	fw0 = fu_superio_it89_device_read_addr (self, chk->address,
 						chk->data_sz, NULL,
 						error);
-	if (fw1 == NULL) {
-		g_prefix_error (error, "failed to read erased "
+	if (fw0 == NULL) {
+		g_prefix_error (error, "failed to read existing "
 				"bytes @0x%04x", (guint) chk->address);
 		return FALSE;
 	}
-	if (!fu_common_bytes_is_empty (fw1)) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_READ,
-				     "sector was not erased");
-		return FALSE;
+	if (fu_common_bytes_compare (fw0, fw2, NULL)) {
+		g_debug ("skipping unchanged page @0x%04x", (guint) chk->address);
+		return TRUE;
+	}
+
+	/* erase page, unless already blank */
+	if (!fu_common_bytes_is_empty (fw0)) {
+		if (!fu_superio_it89_device_erase_addr (self, chk->address, error)) {
+			g_prefix_error (error, "failed to erase @0x%04x", (guint) chk->address);
+			return FALSE;
+		}
+
+		/* check erased */
+		fw1 = fu_superio_it89_device_read_addr (self, chk->address,
+							chk->data_sz, NULL,
+							error);
+		if (fw1 == NULL) {
+			g_prefix_error (error, "failed to read erased "
+					"bytes @0x%04x", (guint) chk->address);
+			return FALSE;
+		}
+		if (!fu_common_bytes_is_empty (fw1)) {
+			g_set_error_literal (error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_READ,
+					     "sector was not erased");
+			return FALSE;
+		}
 	}
 
 	/* skip empty page */
-	fw2 = g_bytes_new_static (chk->data, chk->data_sz);
 	if (fu_common_bytes_is_empty (fw2))
 		return TRUE;
 
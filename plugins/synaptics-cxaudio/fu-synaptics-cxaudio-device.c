@@ -16,6 +16,8 @@
 #include "fu-synaptics-cxaudio-device.h"
 #include "fu-synaptics-cxaudio-firmware.h"
 
+#define FU_SYNAPTICS_CXAUDIO_PAYLOAD_MAX		0x20
+
 struct _FuSynapticsCxaudioDevice
 {
 	FuHidDevice		 parent_instance;
@@ -108,7 +110,7 @@ fu_synaptics_cxaudio_device_operation (FuSynapticsCxaudioDevice *self,
 {
 	const guint32 idx_read = 0x1;
 	const guint32 idx_write = 0x5;
-	const guint32 payload_max = 0x20;
+	const guint32 payload_max = FU_SYNAPTICS_CXAUDIO_PAYLOAD_MAX;
 	guint32 size = 0x02800;
 	g_autoptr(GPtrArray) chunks = NULL;
 
@@ -566,6 +568,64 @@ fu_synaptics_cxaudio_device_prepare_firmware (FuDevice *device,
 	return g_steal_pointer (&firmware);
 }
 
+/* only the packets that differ from the EEPROM contents are written */
+static gboolean
+fu_synaptics_cxaudio_device_write_changed (FuSynapticsCxaudioDevice *self,
+					   FuSrecFirmwareRecord *rcd,
+					   guint *written,
+					   GError **error)
+{
+	g_autofree guint8 *buf_old = g_malloc0 (rcd->buf->len);
+	g_autoptr(GPtrArray) chunks = NULL;
+
+	if (!fu_synaptics_cxaudio_device_operation (self,
+						    FU_SYNAPTICS_CXAUDIO_OPERATION_READ,
+						    FU_SYNAPTICS_CXAUDIO_MEM_KIND_EEPROM,
+						    rcd->addr,
+						    buf_old, rcd->buf->len,
+						    FU_SYNAPTICS_CXAUDIO_OPERATION_FLAG_NONE,
+						    error)) {
+		g_prefix_error (error, "failed to read back: ");
+		return FALSE;
+	}
+	chunks = fu_chunk_array_new (rcd->buf->data, rcd->buf->len, rcd->addr,
+				     0x0, FU_SYNAPTICS_CXAUDIO_PAYLOAD_MAX);
+	for (guint i = 0; i < chunks->len; i++) {
+		FuChunk *chunk = g_ptr_array_index (chunks, i);
+		if (memcmp (buf_old + (chunk->address - rcd->addr),
+			    chunk->data, chunk->data_sz) == 0)
+			continue;
+		if (!fu_synaptics_cxaudio_device_operation (self,
+							    FU_SYNAPTICS_CXAUDIO_OPERATION_WRITE,
+							    FU_SYNAPTICS_CXAUDIO_MEM_KIND_EEPROM,
+							    chunk->address,
+							    (guint8 *) chunk->data, chunk->data_sz,
+							    FU_SYNAPTICS_CXAUDIO_OPERATION_FLAG_NONE,
+							    error))
+			return FALSE;
+		(*written)++;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_synaptics_cxaudio_device_verify_record (FuSynapticsCxaudioDevice *self,
+					   FuSrecFirmwareRecord *rcd,
+					   GError **error)
+{
+	g_autofree guint8 *buf = g_malloc0 (rcd->buf->len);
+	if (!fu_synaptics_cxaudio_device_operation (self,
+						    FU_SYNAPTICS_CXAUDIO_OPERATION_READ,
+						    FU_SYNAPTICS_CXAUDIO_MEM_KIND_EEPROM,
+						    rcd->addr,
+						    buf, rcd->buf->len,
+						    FU_SYNAPTICS_CXAUDIO_OPERATION_FLAG_NONE,
+						    error))
+		return FALSE;
+	return fu_common_bytes_compare_raw (rcd->buf->data, rcd->buf->len,
+					    buf, rcd->buf->len, error);
+}
+
 static gboolean
 fu_synaptics_cxaudio_device_write_firmware (FuDevice *device,
 					    FuFirmware *firmware,
@@ -575,6 +635,7 @@ fu_synaptics_cxaudio_device_write_firmware (FuDevice *device,
 	FuSynapticsCxaudioDevice *self = FU_SYNAPTICS_CXAUDIO_DEVICE (device);
 	GPtrArray *records = fu_srec_firmware_get_records (FU_SREC_FIRMWARE (firmware));
 	FuSynapticsCxaudioFileKind file_kind;
+	guint written = 0;
 
 	/* check if a patch file fits completely into the EEPROM */
 	for (guint i = 0; i < records->len; i++) {
@@ -628,26 +689,35 @@ fu_synaptics_cxaudio_device_write_firmware (FuDevice *device,
 		g_debug ("initialized layout signature");
 	}
 
-	/* perform the actual write */
+	/* perform the actual write, skipping the packets that are unchanged */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	for (guint i = 0; i < records->len; i++) {
 		FuSrecFirmwareRecord *rcd = g_ptr_array_index (records, i);
 		if (rcd->kind != FU_FIRMWARE_SREC_RECORD_KIND_S3_DATA_32)
 			continue;
 		g_debug ("writing @0x%04x len:0x%02x", rcd->addr, rcd->buf->len);
-		if (!fu_synaptics_cxaudio_device_operation (self,
-							    FU_SYNAPTICS_CXAUDIO_OPERATION_WRITE,
-							    FU_SYNAPTICS_CXAUDIO_MEM_KIND_EEPROM,
-							    rcd->addr,
-							    rcd->buf->data, rcd->buf->len,
-							    FU_SYNAPTICS_CXAUDIO_OPERATION_FLAG_VERIFY,
-							    error)) {
+		if (!fu_synaptics_cxaudio_device_write_changed (self, rcd, &written, error)) {
 			g_prefix_error (error, "failed to write @0x%04x len:0x%02x: ",
 					rcd->addr, rcd->buf->len);
 			return FALSE;
 		}
 		fu_device_set_progress_full (device, (gsize) i, (gsize) records->len);
 	}
+	g_debug ("wrote %u changed packets", written);
+
+	/* verify everything in one pass after all the writes */
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_VERIFY);
+	for (guint i = 0; i < records->len; i++) {
+		FuSrecFirmwareRecord *rcd = g_ptr_array_index (records, i);
+		if (rcd->kind != FU_FIRMWARE_SREC_RECORD_KIND_S3_DATA_32)
+			continue;
+		if (!fu_synaptics_cxaudio_device_verify_record (self, rcd, error)) {
+			g_prefix_error (error, "failed to verify @0x%04x len:0x%02x: ",
+					rcd->addr, rcd->buf->len);
+			return FALSE;
+		}
+		fu_device_set_progress_full (device, (gsize) i, (gsize) records->len);
+	}
 
 	/* in case of a full FW upgrade invalidate the old FW patch (if any)
 	 * as it may have not been done by the S37 file */
@@ -155,11 +155,83 @@ fu_plugin_update (FuPlugin *plugin,
 		return FALSE;
 	if (!fu_device_write_firmware (device, blob_fw, flags, error))
 		return FALSE;
+
+	/* removed in composite_cleanup once the restart is done */
+	if (fu_synaptics_mst_device_get_restart_pending (FU_SYNAPTICS_MST_DEVICE (device)))
+		return TRUE;
 	if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_SKIPS_RESTART))
 		fu_plugin_device_remove (plugin, device);
 	return TRUE;
 }
 
+gboolean
+fu_plugin_composite_prepare (FuPlugin *plugin,
+			     GPtrArray *devices,
+			     GError **error)
+{
+	g_autoptr(GPtrArray) devices_mst = g_ptr_array_new ();
+
+	/* hubs that skip the restart can already be written at the same time */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *dev = g_ptr_array_index (devices, i);
+		if (!FU_IS_SYNAPTICS_MST_DEVICE (dev))
+			continue;
+		if (fu_device_has_flag (dev, FWUPD_DEVICE_FLAG_SKIPS_RESTART))
+			continue;
+		g_ptr_array_add (devices_mst, dev);
+	}
+
+	/* a single hub restarts straight away, so make sure the daemon
+	 * knows it is going to re-enumerate before scheduling it */
+	if (devices_mst->len == 1) {
+		FuDevice *dev = g_ptr_array_index (devices_mst, 0);
+		fu_device_set_remove_delay (dev, FU_SYNAPTICS_MST_DEVICE_REMOVE_DELAY);
+		return TRUE;
+	}
+
+	/* each hub has its own aux device and so its own RC session, so write
+	 * them all and then restart them together */
+	for (guint i = 0; i < devices_mst->len; i++) {
+		FuDevice *dev = g_ptr_array_index (devices_mst, i);
+		fu_device_set_remove_delay (dev, 0);
+		fu_synaptics_mst_device_set_restart_deferred (FU_SYNAPTICS_MST_DEVICE (dev), TRUE);
+	}
+	if (devices_mst->len > 0)
+		g_debug ("deferring restart of %u hubs", devices_mst->len);
+	return TRUE;
+}
+
+gboolean
+fu_plugin_composite_cleanup (FuPlugin *plugin,
+			     GPtrArray *devices,
+			     GError **error)
+{
+	/* restart every hub that was written, even if another one failed */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *dev = g_ptr_array_index (devices, i);
+		g_autoptr(FuDeviceLocker) locker = NULL;
+		g_autoptr(GError) error_local = NULL;
+
+		if (!FU_IS_SYNAPTICS_MST_DEVICE (dev))
+			continue;
+		fu_synaptics_mst_device_set_restart_deferred (FU_SYNAPTICS_MST_DEVICE (dev), FALSE);
+		if (!fu_synaptics_mst_device_get_restart_pending (FU_SYNAPTICS_MST_DEVICE (dev)))
+			continue;
+		locker = fu_device_locker_new (dev, &error_local);
+		if (locker == NULL ||
+		    !fu_synaptics_mst_device_restart_pending (FU_SYNAPTICS_MST_DEVICE (dev),
+							      &error_local)) {
+			g_warning ("failed to restart %s: %s",
+				   fu_device_get_logical_id (dev),
+				   error_local->message);
+			continue;
+		}
+		fu_device_set_remove_delay (dev, FU_SYNAPTICS_MST_DEVICE_REMOVE_DELAY);
+		fu_plugin_device_remove (plugin, dev);
+	}
+	return TRUE;
+}
+
 void
 fu_plugin_init (FuPlugin *plugin)
 {
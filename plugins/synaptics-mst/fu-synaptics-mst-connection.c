@@ -39,6 +39,10 @@ fu_synaptics_mst_connection_aux_node_read (FuSynapticsMstConnection *self,
 					  guint32 offset, guint8 *buf,
 					  gint length, GError **error)
 {
+#ifdef HAVE_PWRITE
+	/* one syscall per transfer rather than seeking first */
+	if (pread (self->fd, buf, length, offset) != length) {
+#else
 	if (lseek (self->fd, offset, SEEK_SET) != offset) {
 		g_set_error (error,
 			     G_IO_ERROR,
@@ -47,8 +51,8 @@ fu_synaptics_mst_connection_aux_node_read (FuSynapticsMstConnection *self,
 			     offset, self->layer, self->rad);
 		return FALSE;
 	}
-
 	if (read (self->fd, buf, length) != length) {
+#endif
 		g_set_error (error,
 			     G_IO_ERROR,
 			     G_IO_ERROR_INVALID_DATA,
@@ -65,6 +69,10 @@ fu_synaptics_mst_connection_aux_node_write (FuSynapticsMstConnection *self,
 					    guint32 offset, const guint8 *buf,
 					    gint length, GError **error)
 {
+#ifdef HAVE_PWRITE
+	/* one syscall per transfer rather than seeking first */
+	if (pwrite (self->fd, buf, length, offset) != length) {
+#else
 	if (lseek (self->fd, offset, SEEK_SET) != offset) {
 		g_set_error (error,
 			     G_IO_ERROR,
@@ -73,8 +81,8 @@ fu_synaptics_mst_connection_aux_node_write (FuSynapticsMstConnection *self,
 			     offset, self->layer, self->rad);
 		return FALSE;
 	}
-
 	if (write (self->fd, buf, length) != length) {
+#endif
 		g_set_error (error,
 			     G_IO_ERROR,
 			     G_IO_ERROR_INVALID_DATA,
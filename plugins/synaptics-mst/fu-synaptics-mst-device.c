@@ -11,6 +11,7 @@
 
 #include <fcntl.h>
 
+#include "fu-crc.h"
 #include "fu-synaptics-mst-common.h"
 #include "fu-synaptics-mst-connection.h"
 #include "fu-synaptics-mst-device.h"
@@ -32,8 +33,6 @@
 #define BLOCK_UNIT			64
 #define BANKTAG_0			0
 #define BANKTAG_1			1
-#define CRC_8				8
-#define CRC_16				16
 #define REG_ESM_DISABLE			0x2000fc
 #define REG_QUAD_DISABLE		0x200fc0
 #define REG_HDCP22_DISABLE		0x200f90
@@ -51,6 +50,8 @@ struct _FuSynapticsMstDevice {
 	guint16			 rad;		/* relative address */
 	guint32			 board_id;
 	guint16			 chip_id;
+	gboolean		 restart_deferred;
+	gboolean		 restart_pending;
 };
 
 G_DEFINE_TYPE (FuSynapticsMstDevice, fu_synaptics_mst_device, FU_TYPE_UDEV_DEVICE)
@@ -159,64 +160,6 @@ fu_synaptics_mst_device_get_flash_checksum (FuSynapticsMstDevice *self,
 	return TRUE;
 }
 
-static guint16
-fu_synaptics_mst_device_get_crc (guint16 crc, guint8 type, guint32 length, const guint8 *payload_data)
-{
-	static const guint16 CRC16_table[] = {
-		0x0000, 0x8005, 0x800f, 0x000a, 0x801b, 0x001e, 0x0014, 0x8011, 0x8033, 0x0036, 0x003c, 0x8039, 0x0028, 0x802d, 0x8027, 0x0022,
-		0x8063, 0x0066, 0x006c, 0x8069, 0x0078, 0x807d, 0x8077, 0x0072, 0x0050, 0x8055, 0x805f, 0x005a, 0x804b, 0x004e, 0x0044, 0x8041,
-		0x80c3, 0x00c6, 0x00cc, 0x80c9, 0x00d8, 0x80dd, 0x80d7, 0x00d2, 0x00f0, 0x80f5, 0x80ff, 0x00fa, 0x80eb, 0x00ee, 0x00e4, 0x80e1,
-		0x00a0, 0x80a5, 0x80af, 0x00aa, 0x80bb, 0x00be, 0x00b4, 0x80b1, 0x8093, 0x0096, 0x009c, 0x8099, 0x0088, 0x808d, 0x8087, 0x0082,
-		0x8183, 0x0186, 0x018c, 0x8189, 0x0198, 0x819d, 0x8197, 0x0192, 0x01b0, 0x81b5, 0x81bf, 0x01ba, 0x81ab, 0x01ae, 0x01a4, 0x81a1,
-		0x01e0, 0x81e5, 0x81ef, 0x01ea, 0x81fb, 0x01fe, 0x01f4, 0x81f1, 0x81d3, 0x01d6, 0x01dc, 0x81d9, 0x01c8, 0x81cd, 0x81c7, 0x01c2,
-		0x0140, 0x8145, 0x814f, 0x014a, 0x815b, 0x015e, 0x0154, 0x8151, 0x8173, 0x0176, 0x017c, 0x8179, 0x0168, 0x816d, 0x8167, 0x0162,
-		0x8123, 0x0126, 0x012c, 0x8129, 0x0138, 0x813d, 0x8137, 0x0132, 0x0110, 0x8115, 0x811f, 0x011a, 0x810b, 0x010e, 0x0104, 0x8101,
-		0x8303, 0x0306, 0x030c, 0x8309, 0x0318, 0x831d, 0x8317, 0x0312, 0x0330, 0x8335, 0x833f, 0x033a, 0x832b, 0x032e, 0x0324, 0x8321,
-		0x0360, 0x8365, 0x836f, 0x036a, 0x837b, 0x037e, 0x0374, 0x8371, 0x8353, 0x0356, 0x035c, 0x8359, 0x0348, 0x834d, 0x8347, 0x0342,
-		0x03c0, 0x83c5, 0x83cf, 0x03ca, 0x83db, 0x03de, 0x03d4, 0x83d1, 0x83f3, 0x03f6, 0x03fc, 0x83f9, 0x03e8, 0x83ed, 0x83e7, 0x03e2,
-		0x83a3, 0x03a6, 0x03ac, 0x83a9, 0x03b8, 0x83bd, 0x83b7, 0x03b2, 0x0390, 0x8395, 0x839f, 0x039a, 0x838b, 0x038e, 0x0384, 0x8381,
-		0x0280, 0x8285, 0x828f, 0x028a, 0x829b, 0x029e, 0x0294, 0x8291, 0x82b3, 0x02b6, 0x02bc, 0x82b9, 0x02a8, 0x82ad, 0x82a7, 0x02a2,
-		0x82e3, 0x02e6, 0x02ec, 0x82e9, 0x02f8, 0x82fd, 0x82f7, 0x02f2, 0x02d0, 0x82d5, 0x82df, 0x02da, 0x82cb, 0x02ce, 0x02c4, 0x82c1,
-		0x8243, 0x0246, 0x024c, 0x8249, 0x0258, 0x825d, 0x8257, 0x0252, 0x0270, 0x8275, 0x827f, 0x027a, 0x826b, 0x026e, 0x0264, 0x8261,
-		0x0220, 0x8225, 0x822f, 0x022a, 0x823b, 0x023e, 0x0234, 0x8231, 0x8213, 0x0216, 0x021c, 0x8219, 0x0208, 0x820d, 0x8207, 0x0202
-	};
-	static const guint16 CRC8_table[] = {
-		0x00, 0xd5, 0x7f, 0xaa, 0xfe, 0x2b, 0x81, 0x54, 0x29, 0xfc, 0x56, 0x83, 0xd7, 0x02, 0xa8, 0x7d,
-		0x52, 0x87, 0x2d, 0xf8, 0xac, 0x79, 0xd3, 0x06, 0x7b, 0xae, 0x04, 0xd1, 0x85, 0x50, 0xfa, 0x2f,
-		0xa4, 0x71, 0xdb, 0x0e, 0x5a, 0x8f, 0x25, 0xf0, 0x8d, 0x58, 0xf2, 0x27, 0x73, 0xa6, 0x0c, 0xd9,
-		0xf6, 0x23, 0x89, 0x5c, 0x08, 0xdd, 0x77, 0xa2, 0xdf, 0x0a, 0xa0, 0x75, 0x21, 0xf4, 0x5e, 0x8b,
-		0x9d, 0x48, 0xe2, 0x37, 0x63, 0xb6, 0x1c, 0xc9, 0xb4, 0x61, 0xcb, 0x1e, 0x4a, 0x9f, 0x35, 0xe0,
-		0xcf, 0x1a, 0xb0, 0x65, 0x31, 0xe4, 0x4e, 0x9b, 0xe6, 0x33, 0x99, 0x4c, 0x18, 0xcd, 0x67, 0xb2,
-		0x39, 0xec, 0x46, 0x93, 0xc7, 0x12, 0xb8, 0x6d, 0x10, 0xc5, 0x6f, 0xba, 0xee, 0x3b, 0x91, 0x44,
-		0x6b, 0xbe, 0x14, 0xc1, 0x95, 0x40, 0xea, 0x3f, 0x42, 0x97, 0x3d, 0xe8, 0xbc, 0x69, 0xc3, 0x16,
-		0xef, 0x3a, 0x90, 0x45, 0x11, 0xc4, 0x6e, 0xbb, 0xc6, 0x13, 0xb9, 0x6c, 0x38, 0xed, 0x47, 0x92,
-		0xbd, 0x68, 0xc2, 0x17, 0x43, 0x96, 0x3c, 0xe9, 0x94, 0x41, 0xeb, 0x3e, 0x6a, 0xbf, 0x15, 0xc0,
-		0x4b, 0x9e, 0x34, 0xe1, 0xb5, 0x60, 0xca, 0x1f, 0x62, 0xb7, 0x1d, 0xc8, 0x9c, 0x49, 0xe3, 0x36,
-		0x19, 0xcc, 0x66, 0xb3, 0xe7, 0x32, 0x98, 0x4d, 0x30, 0xe5, 0x4f, 0x9a, 0xce, 0x1b, 0xb1, 0x64,
-		0x72, 0xa7, 0x0d, 0xd8, 0x8c, 0x59, 0xf3, 0x26, 0x5b, 0x8e, 0x24, 0xf1, 0xa5, 0x70, 0xda, 0x0f,
-		0x20, 0xf5, 0x5f, 0x8a, 0xde, 0x0b, 0xa1, 0x74, 0x09, 0xdc, 0x76, 0xa3, 0xf7, 0x22, 0x88, 0x5d,
-		0xd6, 0x03, 0xa9, 0x7c, 0x28, 0xfd, 0x57, 0x82, 0xff, 0x2a, 0x80, 0x55, 0x01, 0xd4, 0x7e, 0xab,
-		0x84, 0x51, 0xfb, 0x2e, 0x7a, 0xaf, 0x05, 0xd0, 0xad, 0x78, 0xd2, 0x07, 0x53, 0x86, 0x2c, 0xf9
-	};
-	guint8 val;
-	guint16 remainder = (guint16) crc;
-	const guint8 *message = payload_data;
-
-	if (type == CRC_8) {
-		for (guint32 byte = 0; byte < length; ++byte) {
-			val = (guint8)(message[byte] ^ remainder);
-			remainder = CRC8_table[val];
-		}
-	} else {
-		for (guint32 byte = 0; byte < length; ++byte) {
-			val = (guint8)(message[byte] ^ (remainder >> 8));
-			remainder = CRC16_table[val] ^ (remainder << 8);
-		}
-	}
-
-	return remainder;
-}
-
 static gboolean
 fu_synaptics_mst_device_set_flash_sector_erase (FuSynapticsMstDevice *self,
 					    guint16 rc_cmd,
@@ -549,7 +492,7 @@ fu_synaptics_mst_device_update_panamera_firmware (FuSynapticsMstDevice *self,
 		}
 
 		/* verify CRC */
-		checksum = fu_synaptics_mst_device_get_crc (0, 16, fw_size, payload_data );
+		checksum = fu_crc16 (payload_data, fw_size);
 		for (guint32 i = 0; i < 4; i++) {
 			g_usleep (1000);	/* wait crc calculation */
 			if (!fu_synaptics_mst_connection_rc_special_get_command (connection,
@@ -582,11 +525,11 @@ fu_synaptics_mst_device_update_panamera_firmware (FuSynapticsMstDevice *self,
 	tagData[1] = pTM->tm_mon + 1;
 	tagData[2] = pTM->tm_mday;
 	tagData[3] = pTM->tm_year + 1900 - 2000;
-	crc_tmp = fu_synaptics_mst_device_get_crc (0, 16, fw_size, payload_data);
+	crc_tmp = fu_crc16 (payload_data, fw_size);
 	tagData[0] = bank_to_update;
 	tagData[4] = (crc_tmp >> 8) & 0xff;
 	tagData[5] = crc_tmp & 0xff;
-	tagData[15] = (guint8) fu_synaptics_mst_device_get_crc (0, 8, 15, tagData);
+	tagData[15] = fu_crc8_full (tagData, 15, 0x00, 0xd5);
 	g_debug ("tag date %x %x %x crc %x %x %x %x", tagData[1], tagData[2], tagData[3], tagData[0], tagData[4], tagData[5], tagData[15]);
 
 	for (guint32 retries_cnt = 0; ; retries_cnt++) {
@@ -815,13 +758,15 @@ fu_synaptics_mst_device_write_firmware (FuDevice *device,
 
 	/* enable remote control and disable on exit */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
-	if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_SKIPS_RESTART)) {
+	if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_SKIPS_RESTART) &&
+	    !self->restart_deferred) {
 		locker = fu_device_locker_new_full (self,
 						(FuDeviceLockerFunc) fu_synaptics_mst_device_enable_rc,
 						(FuDeviceLockerFunc) fu_synaptics_mst_device_restart,
 						error);
 		fu_device_add_flag (device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG);
-		fu_device_set_remove_delay (FU_DEVICE (self), 10000); /* a long time */
+		fu_device_set_remove_delay (FU_DEVICE (self),
+					    FU_SYNAPTICS_MST_DEVICE_REMOVE_DELAY);
 	} else {
 		locker = fu_device_locker_new_full (self,
 						(FuDeviceLockerFunc) fu_synaptics_mst_device_enable_rc,
@@ -859,10 +804,70 @@ fu_synaptics_mst_device_write_firmware (FuDevice *device,
 			return FALSE;
 		}
 	}
+	if (self->restart_deferred &&
+	    !fu_device_has_flag (device, FWUPD_DEVICE_FLAG_SKIPS_RESTART)) {
+		self->restart_pending = TRUE;
+		return TRUE;
+	}
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_RESTART);
 	return TRUE;
 }
 
+/**
+ * fu_synaptics_mst_device_set_restart_deferred:
+ * @self: a #FuSynapticsMstDevice
+ * @restart_deferred: %TRUE to not restart the hub after writing the firmware
+ *
+ * Defers the restart so that hubs on different aux devices can be written
+ * at the same time, without any of them re-enumerating during the update.
+ * The caller must then use fu_synaptics_mst_device_restart_pending().
+ **/
+void
+fu_synaptics_mst_device_set_restart_deferred (FuSynapticsMstDevice *self,
+					      gboolean restart_deferred)
+{
+	g_return_if_fail (FU_IS_SYNAPTICS_MST_DEVICE (self));
+	self->restart_deferred = restart_deferred;
+}
+
+/**
+ * fu_synaptics_mst_device_restart_pending:
+ * @self: a #FuSynapticsMstDevice
+ * @error: a #GError, or %NULL
+ *
+ * Restarts the hub if new firmware was written with the restart deferred.
+ * The device must be open.
+ *
+ * Returns: %TRUE if the hub is restarting, or there was nothing to do
+ **/
+gboolean
+fu_synaptics_mst_device_restart_pending (FuSynapticsMstDevice *self, GError **error)
+{
+	g_return_val_if_fail (FU_IS_SYNAPTICS_MST_DEVICE (self), FALSE);
+	if (!self->restart_pending)
+		return TRUE;
+	if (!fu_synaptics_mst_device_enable_rc (self, error))
+		return FALSE;
+	self->restart_pending = FALSE;
+	fu_device_set_status (FU_DEVICE (self), FWUPD_STATUS_DEVICE_RESTART);
+	return fu_synaptics_mst_device_restart (self, error);
+}
+
+/**
+ * fu_synaptics_mst_device_get_restart_pending:
+ * @self: a #FuSynapticsMstDevice
+ *
+ * Gets if new firmware was written and the hub has not yet been restarted.
+ *
+ * Returns: %TRUE if a restart is required
+ **/
+gboolean
+fu_synaptics_mst_device_get_restart_pending (FuSynapticsMstDevice *self)
+{
+	g_return_val_if_fail (FU_IS_SYNAPTICS_MST_DEVICE (self), FALSE);
+	return self->restart_pending;
+}
+
 FuSynapticsMstDevice *
 fu_synaptics_mst_device_new (FuUdevDevice *device)
 {
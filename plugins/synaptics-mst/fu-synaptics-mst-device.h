@@ -9,8 +9,15 @@
 #include "fu-plugin.h"
 
 #define FU_TYPE_SYNAPTICS_MST_DEVICE (fu_synaptics_mst_device_get_type ())
+#define FU_SYNAPTICS_MST_DEVICE_REMOVE_DELAY	10000	/* ms */
+
 G_DECLARE_FINAL_TYPE (FuSynapticsMstDevice, fu_synaptics_mst_device, FU, SYNAPTICS_MST_DEVICE, FuUdevDevice)
 
 FuSynapticsMstDevice	*fu_synaptics_mst_device_new	(FuUdevDevice	*device);
 void	 fu_synaptics_mst_device_set_system_type	(FuSynapticsMstDevice	*self,
 						 const gchar 		*system_type);
+void	 fu_synaptics_mst_device_set_restart_deferred	(FuSynapticsMstDevice	*self,
+							 gboolean		 restart_deferred);
+gboolean fu_synaptics_mst_device_get_restart_pending	(FuSynapticsMstDevice	*self);
+gboolean fu_synaptics_mst_device_restart_pending	(FuSynapticsMstDevice	*self,
+							 GError			**error);
@@ -219,19 +219,6 @@ fu_synaprom_device_setup (FuDevice *device, GError **error)
 	return TRUE;
 }
 
-static gboolean
-fu_synaprom_device_cmd_download_chunk (FuSynapromDevice *device,
-				       const GByteArray *chunk,
-				       GError **error)
-{
-	g_autoptr(GByteArray) request = NULL;
-	g_autoptr(GByteArray) reply = NULL;
-	request = fu_synaprom_request_new (FU_SYNAPROM_CMD_BOOTLDR_PATCH,
-					   chunk->data, chunk->len);
-	reply = fu_synaprom_reply_new (sizeof(FuSynapromReplyGeneric));
-	return fu_synaprom_device_cmd_send (device, request, reply, 20000, error);
-}
-
 FuFirmware *
 fu_synaprom_device_prepare_fw (FuDevice *device,
 			       GBytes *fw,
@@ -286,14 +273,16 @@ fu_synaprom_device_write_fw (FuSynapromDevice *self, GBytes *fw, GError **error)
 {
 	const guint8 *buf;
 	gsize sz = 0;
+	gsize sz_total;
+	g_autoptr(GByteArray) request = g_byte_array_new ();
+	g_autoptr(GByteArray) reply = fu_synaprom_reply_new (sizeof(FuSynapromReplyGeneric));
 
-	/* write chunks */
-	fu_device_set_progress (FU_DEVICE (self), 10);
+	/* write chunks, each copied once from the image into the request */
 	fu_device_set_status (FU_DEVICE (self), FWUPD_STATUS_DEVICE_WRITE);
 	buf = g_bytes_get_data (fw, &sz);
+	sz_total = sz;
 	while (sz != 0) {
 		guint32 chunksz;
-		g_autoptr(GByteArray) chunk = g_byte_array_new ();
 
 		/* get chunk size */
 		if (sz < sizeof(guint32)) {
@@ -303,7 +292,7 @@ fu_synaprom_device_write_fw (FuSynapromDevice *self, GBytes *fw, GError **error)
 					     "No enough data for patch len");
 			return FALSE;
 		}
-		memcpy (&chunksz, buf, sizeof(guint32));
+		chunksz = fu_common_read_uint32 (buf, G_LITTLE_ENDIAN);
 		buf += sizeof(guint32);
 		sz -= sizeof(guint32);
 		if (sz < chunksz) {
@@ -314,18 +303,20 @@ fu_synaprom_device_write_fw (FuSynapromDevice *self, GBytes *fw, GError **error)
 			return FALSE;
 		}
 
-		/* download chunk */
-		g_byte_array_append (chunk, buf, chunksz);
-		if (!fu_synaprom_device_cmd_download_chunk (self, chunk, error))
+		/* download chunk, reusing the same request and reply buffers */
+		g_byte_array_set_size (request, 0);
+		fu_byte_array_append_uint8 (request, FU_SYNAPROM_CMD_BOOTLDR_PATCH);
+		g_byte_array_append (request, buf, chunksz);
+		if (!fu_synaprom_device_cmd_send (self, request, reply, 20000, error))
 			return FALSE;
 
 		/* next chunk */
 		buf += chunksz;
 		sz -= chunksz;
+		fu_device_set_progress_full (FU_DEVICE (self), sz_total - sz, sz_total);
 	}
 
 	/* success! */
-	fu_device_set_progress (FU_DEVICE (self), 100);
 	return TRUE;
 }
 
@@ -99,7 +99,7 @@ fu_synaprom_firmware_parse (FuFirmware *firmware,
 
 		/* move pointer to data */
 		buf += sizeof(header);
-		bytes = g_bytes_new (buf, hdrsz);
+		bytes = g_bytes_new_from_bytes (fw, offset - hdrsz, hdrsz);
 		g_debug ("adding 0x%04x (%s) with size 0x%04x",
 			 tag,
 			 fu_synaprom_firmware_tag_to_string (tag),
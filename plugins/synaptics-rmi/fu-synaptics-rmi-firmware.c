@@ -139,9 +139,9 @@ rmi_firmware_container_id_to_string (RmiFirmwareContainerId container_id)
 
 static void
 fu_synaptics_rmi_firmware_add_image (FuFirmware *firmware, const gchar *id,
-				     const guint8 *data, gsize sz)
+				     GBytes *fw, gsize offset, gsize sz)
 {
-	g_autoptr(GBytes) bytes = g_bytes_new (data, sz);
+	g_autoptr(GBytes) bytes = g_bytes_new_from_bytes (fw, offset, sz);
 	g_autoptr(FuFirmwareImage) img = fu_firmware_image_new (bytes);
 	fu_firmware_image_set_id (img, id);
 	fu_firmware_add_image (firmware, img);
@@ -239,16 +239,16 @@ fu_synaptics_rmi_firmware_parse_v10 (FuFirmware *firmware, GBytes *fw, GError **
 		case RMI_FIRMWARE_CONTAINER_ID_UI:
 		case RMI_FIRMWARE_CONTAINER_ID_CORE_CODE:
 			fu_synaptics_rmi_firmware_add_image (firmware, "ui",
-							     data + content_addr, length);
+							     fw, content_addr, length);
 			break;
 		case RMI_FIRMWARE_CONTAINER_ID_FLASH_CONFIG:
 			fu_synaptics_rmi_firmware_add_image (firmware, "flash-config",
-							     data + content_addr, length);
+							     fw, content_addr, length);
 			break;
 		case RMI_FIRMWARE_CONTAINER_ID_UI_CONFIG:
 		case RMI_FIRMWARE_CONTAINER_ID_CORE_CONFIG:
 			fu_synaptics_rmi_firmware_add_image (firmware, "config",
-							     data + content_addr, length);
+							     fw, content_addr, length);
 			break;
 		case RMI_FIRMWARE_CONTAINER_ID_GENERAL_INFORMATION:
 			if (length < 0x18 + RMI_PRODUCT_ID_LENGTH) {
@@ -294,24 +294,24 @@ fu_synaptics_rmi_firmware_parse_v0x (FuFirmware *firmware, GBytes *fw, GError **
 				     (guint) img_sz, (guint) sz - RMI_IMG_FW_OFFSET);
 			return FALSE;
 		}
-		fu_synaptics_rmi_firmware_add_image (firmware, "ui",
-						     data + RMI_IMG_FW_OFFSET,
+		fu_synaptics_rmi_firmware_add_image (firmware, "ui", fw,
+						     RMI_IMG_FW_OFFSET,
 						     img_sz);
 	}
 
 	/* config */
 	cfg_sz = fu_common_read_uint32 (data + RMI_IMG_CONFIG_SIZE_OFFSET, G_LITTLE_ENDIAN);
 	if (cfg_sz > 0) {
-		if (cfg_sz > sz - RMI_IMG_FW_OFFSET) {
+		if (cfg_sz > sz - RMI_IMG_FW_OFFSET - img_sz) {
 			g_set_error (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_INVALID_FILE,
 				     "cfg_sz offset invalid, got 0x%x, size 0x%x",
-				     (guint) cfg_sz, (guint) sz - RMI_IMG_FW_OFFSET);
+				     (guint) cfg_sz, (guint) (sz - RMI_IMG_FW_OFFSET - img_sz));
 			return FALSE;
 		}
-		fu_synaptics_rmi_firmware_add_image (firmware, "config",
-						     data + RMI_IMG_FW_OFFSET + img_sz,
+		fu_synaptics_rmi_firmware_add_image (firmware, "config", fw,
+						     RMI_IMG_FW_OFFSET + img_sz,
 						     cfg_sz);
 	}
 	return TRUE;
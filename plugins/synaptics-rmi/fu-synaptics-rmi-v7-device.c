@@ -118,7 +118,9 @@ fu_synaptics_rmi_v7_device_detach (FuDevice *device, GError **error)
 }
 
 static gboolean
-fu_synaptics_rmi_v7_device_erase_all (FuSynapticsRmiDevice *self, GError **error)
+fu_synaptics_rmi_v7_device_erase_all (FuSynapticsRmiDevice *self,
+				      gboolean erase_config,
+				      GError **error)
 {
 	FuSynapticsRmiFunction *f34;
 	FuSynapticsRmiFlash *flash = fu_synaptics_rmi_device_get_flash (self);
@@ -168,7 +170,7 @@ fu_synaptics_rmi_v7_device_erase_all (FuSynapticsRmiDevice *self, GError **error
 	}
 
 	/* for BL7, we need erase config partition */
-	if (flash->bootloader_id[1] == 7) {
+	if (flash->bootloader_id[1] == 7 && erase_config) {
 		g_autoptr(GByteArray) erase_config_cmd = g_byte_array_new ();
 
 		fu_byte_array_append_uint8 (erase_config_cmd, RMI_PARTITION_ID_CORE_CONFIG);
@@ -185,7 +187,6 @@ fu_synaptics_rmi_v7_device_erase_all (FuSynapticsRmiDevice *self, GError **error
 		}
 
 		/* wait for ATTN */
-		g_usleep (1000 * 100);
 		if (!fu_synaptics_rmi_device_wait_for_idle (self,
 							    RMI_F34_ERASE_WAIT_MS,
 							    RMI_DEVICE_WAIT_FOR_IDLE_FLAG_REFRESH_F34,
@@ -315,6 +316,113 @@ fu_synaptics_rmi_v7_device_write_partition (FuSynapticsRmiDevice *self,
 	return TRUE;
 }
 
+static GByteArray *
+fu_synaptics_rmi_v7_device_read_partition (FuSynapticsRmiDevice *self,
+					   RmiPartitionId partition_id,
+					   guint16 block_count,
+					   GError **error)
+{
+	FuSynapticsRmiFunction *f34;
+	FuSynapticsRmiFlash *flash = fu_synaptics_rmi_device_get_flash (self);
+	g_autoptr(GByteArray) buf = g_byte_array_new ();
+	g_autoptr(GByteArray) req_partition_id = g_byte_array_new ();
+
+	/* f34 */
+	f34 = fu_synaptics_rmi_device_get_function (self, 0x34, error);
+	if (f34 == NULL)
+		return NULL;
+	if (flash->payload_length == 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "payload length invalid");
+		return NULL;
+	}
+
+	/* write partition id */
+	fu_byte_array_append_uint8 (req_partition_id, partition_id);
+	if (!fu_synaptics_rmi_device_write (self,
+					    f34->data_base + 0x1,
+					    req_partition_id,
+					    error)) {
+		g_prefix_error (error, "failed to write flash partition: ");
+		return NULL;
+	}
+
+	/* read back each transfer */
+	for (guint16 blk = 0; blk < block_count; blk += flash->payload_length) {
+		guint16 blk_count = MIN (flash->payload_length, block_count - blk);
+		g_autoptr(GByteArray) req_offset = g_byte_array_new ();
+		g_autoptr(GByteArray) req_trans_sz = g_byte_array_new ();
+		g_autoptr(GByteArray) req_cmd = g_byte_array_new ();
+		g_autoptr(GByteArray) res = NULL;
+
+		fu_byte_array_append_uint16 (req_offset, blk, G_LITTLE_ENDIAN);
+		if (!fu_synaptics_rmi_device_write (self,
+						    f34->data_base + 0x2,
+						    req_offset,
+						    error)) {
+			g_prefix_error (error, "failed to write offset: ");
+			return NULL;
+		}
+		fu_byte_array_append_uint16 (req_trans_sz, blk_count, G_LITTLE_ENDIAN);
+		if (!fu_synaptics_rmi_device_write (self,
+						    f34->data_base + 0x3,
+						    req_trans_sz,
+						    error)) {
+			g_prefix_error (error, "failed to write transfer length: ");
+			return NULL;
+		}
+		fu_byte_array_append_uint8 (req_cmd, RMI_FLASH_CMD_READ);
+		if (!fu_synaptics_rmi_device_write (self,
+						    f34->data_base + 0x4,
+						    req_cmd,
+						    error)) {
+			g_prefix_error (error, "failed to write command to read: ");
+			return NULL;
+		}
+		if (!fu_synaptics_rmi_device_poll_wait (self, error)) {
+			g_prefix_error (error, "failed to wait: ");
+			return NULL;
+		}
+		res = fu_synaptics_rmi_device_read (self,
+						    f34->data_base + 0x5,
+						    (gsize) blk_count * (gsize) flash->block_size,
+						    error);
+		if (res == NULL) {
+			g_prefix_error (error, "failed to read @0x%x: ", blk);
+			return NULL;
+		}
+		g_byte_array_append (buf, res->data, res->len);
+	}
+	return g_steal_pointer (&buf);
+}
+
+/* BL7 erases the core config separately, so it can be left alone if the
+ * device already has the exact same contents */
+static gboolean
+fu_synaptics_rmi_v7_device_config_is_unchanged (FuSynapticsRmiDevice *self,
+						GBytes *bytes_cfg)
+{
+	FuSynapticsRmiFlash *flash = fu_synaptics_rmi_device_get_flash (self);
+	g_autoptr(GByteArray) buf = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	buf = fu_synaptics_rmi_v7_device_read_partition (self,
+							 RMI_PARTITION_ID_CORE_CONFIG,
+							 flash->block_count_cfg,
+							 &error_local);
+	if (buf == NULL) {
+		g_debug ("failed to read core config, writing anyway: %s",
+			 error_local->message);
+		return FALSE;
+	}
+	return fu_common_bytes_compare_raw (buf->data, buf->len,
+					    g_bytes_get_data (bytes_cfg, NULL),
+					    g_bytes_get_size (bytes_cfg),
+					    NULL);
+}
+
 gboolean
 fu_synaptics_rmi_v7_device_write_firmware (FuDevice *device,
 					   FuFirmware *firmware,
@@ -327,6 +435,7 @@ fu_synaptics_rmi_v7_device_write_firmware (FuDevice *device,
 	g_autoptr(GBytes) bytes_bin = NULL;
 	g_autoptr(GBytes) bytes_cfg = NULL;
 	g_autoptr(GBytes) bytes_flashcfg = NULL;
+	gboolean write_config = TRUE;
 
 	/* we should be in bootloader mode now, but check anyway */
 	if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_IS_BOOTLOADER)) {
@@ -359,9 +468,16 @@ fu_synaptics_rmi_v7_device_write_firmware (FuDevice *device,
 	if (!fu_synaptics_rmi_device_disable_sleep (self, error))
 		return FALSE;
 
+	/* skip the core config if it is already up to date */
+	if (flash->bootloader_id[1] == 7 &&
+	    fu_synaptics_rmi_v7_device_config_is_unchanged (self, bytes_cfg)) {
+		g_debug ("core config unchanged, skipping");
+		write_config = FALSE;
+	}
+
 	/* erase all */
 	g_debug ("erasing…");
-	if (!fu_synaptics_rmi_v7_device_erase_all (self, error)) {
+	if (!fu_synaptics_rmi_v7_device_erase_all (self, write_config, error)) {
 		g_prefix_error (error, "failed to erase all: ");
 		return FALSE;
 	}
@@ -383,7 +499,8 @@ fu_synaptics_rmi_v7_device_write_firmware (FuDevice *device,
 		return FALSE;
 
 	/* write core config */
-	if (!fu_synaptics_rmi_v7_device_write_partition (self,
+	if (write_config &&
+	    !fu_synaptics_rmi_v7_device_write_partition (self,
 							 RMI_PARTITION_ID_CORE_CONFIG,
 							 bytes_cfg,
 							 error))
@@ -11,8 +11,19 @@
 
 struct FuPluginData {
 	GMutex			 mutex;
+	GPtrArray		*load_devices;	/* of FuDevice, for FWUPD_PLUGIN_TEST=load */
+	guint			 load_churn_id;
+	guint			 load_churn_idx;
 };
 
+/* how the synthetic devices are created, from FWUPD_PLUGIN_TEST_LOAD */
+typedef struct {
+	guint			 devices;
+	guint			 guids;		/* per device */
+	guint			 depth;		/* 1 for no children */
+	guint			 churn;		/* hotplug events per second */
+} FuPluginTestLoad;
+
 void
 fu_plugin_init (FuPlugin *plugin)
 {
@@ -24,14 +35,138 @@ fu_plugin_init (FuPlugin *plugin)
 void
 fu_plugin_destroy (FuPlugin *plugin)
 {
-	//FuPluginData *data = fu_plugin_get_data (plugin);
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	if (data->load_churn_id != 0)
+		g_source_remove (data->load_churn_id);
+	if (data->load_devices != NULL)
+		g_ptr_array_unref (data->load_devices);
 	g_debug ("destroy");
 }
 
+/* e.g. `devices=1000,guids=4,depth=3,churn=10` */
+static void
+fu_plugin_test_load_parse (FuPluginTestLoad *load, const gchar *str)
+{
+	g_auto(GStrv) split = NULL;
+
+	load->devices = 100;
+	load->guids = 1;
+	load->depth = 1;
+	load->churn = 0;
+	if (str == NULL)
+		return;
+	split = g_strsplit (str, ",", -1);
+	for (guint i = 0; split[i] != NULL; i++) {
+		g_auto(GStrv) kv = g_strsplit (split[i], "=", 2);
+		guint64 val;
+		if (g_strv_length (kv) != 2) {
+			g_warning ("invalid load option: %s", split[i]);
+			continue;
+		}
+		val = fu_common_strtoull (kv[1]);
+		if (g_strcmp0 (kv[0], "devices") == 0)
+			load->devices = val;
+		else if (g_strcmp0 (kv[0], "guids") == 0)
+			load->guids = MAX (val, 1);
+		else if (g_strcmp0 (kv[0], "depth") == 0)
+			load->depth = MAX (val, 1);
+		else if (g_strcmp0 (kv[0], "churn") == 0)
+			load->churn = val;
+		else
+			g_warning ("unknown load option: %s", kv[0]);
+	}
+}
+
+/* the time the plugin added or removed the device, used by fwupdtool to
+ * measure how long the engine took to process the hotplug event */
+static void
+fu_plugin_test_load_set_timestamp (FuDevice *device)
+{
+	g_autofree gchar *tmp = g_strdup_printf ("%" G_GINT64_FORMAT, g_get_monotonic_time ());
+	fu_device_set_metadata (device, "LoadTestTimestamp", tmp);
+}
+
+static gboolean
+fu_plugin_test_load_churn_cb (gpointer user_data)
+{
+	FuPlugin *plugin = FU_PLUGIN (user_data);
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	FuDevice *device;
+
+	/* only leaf devices are replugged, so the hierarchy stays valid */
+	for (guint i = 0; i < data->load_devices->len; i++) {
+		device = g_ptr_array_index (data->load_devices,
+					    data->load_churn_idx++ % data->load_devices->len);
+		if (fu_device_get_children (device)->len > 0)
+			continue;
+		fu_plugin_test_load_set_timestamp (device);
+		if (fu_device_get_metadata_boolean (device, "LoadTestRemoved")) {
+			fu_device_set_metadata_boolean (device, "LoadTestRemoved", FALSE);
+			fu_plugin_device_add (plugin, device);
+		} else {
+			fu_device_set_metadata_boolean (device, "LoadTestRemoved", TRUE);
+			fu_plugin_device_remove (plugin, device);
+		}
+		break;
+	}
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+fu_plugin_test_load_coldplug (FuPlugin *plugin)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	FuPluginTestLoad load = { 0 };
+
+	fu_plugin_test_load_parse (&load, g_getenv ("FWUPD_PLUGIN_TEST_LOAD"));
+	data->load_devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < load.devices; i++) {
+		g_autofree gchar *id = g_strdup_printf ("LoadDevice%u", i);
+		g_autoptr(FuDevice) device = fu_device_new ();
+
+		fu_device_set_id (device, id);
+		fu_device_set_physical_id (device, id);
+		fu_device_set_name (device, "Synthetic Device");
+		fu_device_set_vendor_id (device, "USB:0xFFFF");
+		fu_device_set_protocol (device, "com.acme.test");
+		fu_device_set_version_format (device, FWUPD_VERSION_FORMAT_TRIPLET);
+		fu_device_set_version (device, "1.2.2");
+		fu_device_add_flag (device, FWUPD_DEVICE_FLAG_UPDATABLE);
+		for (guint j = 0; j < load.guids; j++) {
+			g_autofree gchar *instance_id = NULL;
+			instance_id = g_strdup_printf ("USB\\VID_FFFF&PID_%04X&REV_%04X", i, j);
+			fu_device_add_instance_id (device, instance_id);
+		}
+
+		/* a chain of children, each one level deeper */
+		if (i % load.depth != 0) {
+			FuDevice *parent = g_ptr_array_index (data->load_devices, i - 1);
+			fu_device_add_child (parent, device);
+		}
+		fu_plugin_test_load_set_timestamp (device);
+		fu_plugin_device_add (plugin, device);
+		g_ptr_array_add (data->load_devices, g_steal_pointer (&device));
+	}
+
+	/* hotplug */
+	if (load.churn > 0 && data->load_devices->len > 0) {
+		data->load_churn_id = g_timeout_add (MAX (1000 / load.churn, 1),
+						     fu_plugin_test_load_churn_cb,
+						     plugin);
+	}
+}
+
 gboolean
 fu_plugin_coldplug (FuPlugin *plugin, GError **error)
 {
 	g_autoptr(FuDevice) device = NULL;
+
+	/* synthetic devices only */
+	if (g_strcmp0 (g_getenv ("FWUPD_PLUGIN_TEST"), "load") == 0) {
+		fu_plugin_test_load_coldplug (plugin);
+		return TRUE;
+	}
+
 	device = fu_device_new ();
 	fu_device_set_id (device, "FakeDevice");
 	fu_device_add_guid (device, "b585990a-003e-5270-89d5-3705a17f9a43");
@@ -28,10 +28,12 @@ struct _FuThunderboltDevice {
 	gboolean		 is_native;
 	guint16			 gen;
 	gchar			*devpath;
+	FuThunderboltFirmware	*firmware_active;	/* nullable */
 };
 
 #define TBT_NVM_RETRY_TIMEOUT				200	/* ms */
 #define FU_PLUGIN_THUNDERBOLT_UPDATE_TIMEOUT		60000	/* ms */
+#define FU_THUNDERBOLT_DEVICE_WRITE_BLOCKSZ		0x40000	/* bytes */
 
 G_DEFINE_TYPE (FuThunderboltDevice, fu_thunderbolt_device, FU_TYPE_UDEV_DEVICE)
 
@@ -102,6 +104,31 @@ fu_thunderbolt_device_read_status_block (FuThunderboltDevice *self, GError **err
 	return TRUE;
 }
 
+/* the active image only changes when the device is updated, so only read
+ * the whole of nvm_active once for all the images being checked */
+static FuThunderboltFirmware *
+fu_thunderbolt_device_get_firmware_active (FuThunderboltDevice *self, GError **error)
+{
+	g_autoptr(FuThunderboltFirmware) firmware = fu_thunderbolt_firmware_new ();
+	g_autoptr(GBytes) controller_fw = NULL;
+	g_autoptr(GFile) nvmem = NULL;
+
+	if (self->firmware_active != NULL)
+		return g_object_ref (self->firmware_active);
+
+	nvmem = fu_thunderbolt_device_find_nvmem (self, TRUE, error);
+	if (nvmem == NULL)
+		return NULL;
+	controller_fw = g_file_load_bytes (nvmem, NULL, NULL, error);
+	if (controller_fw == NULL)
+		return NULL;
+	if (!fu_firmware_parse (FU_FIRMWARE (firmware), controller_fw,
+				FWUPD_INSTALL_FLAG_NONE, error))
+		return NULL;
+	self->firmware_active = g_object_ref (firmware);
+	return g_steal_pointer (&firmware);
+}
+
 static gboolean
 fu_thunderbolt_device_can_update (FuThunderboltDevice *self)
 {
@@ -198,16 +225,22 @@ fu_thunderbolt_device_probe (FuUdevDevice *device, GError **error)
 }
 
 static guint16
-fu_thunderbolt_device_get_attr_uint16 (FuThunderboltDevice *self,
+fu_thunderbolt_device_get_attr_uint16 (GHashTable *attrs,
 				       const gchar *name,
 				       GError **error)
 {
 	const gchar *str;
 	guint64 val;
 
-	str = fu_udev_device_get_sysfs_attr (FU_UDEV_DEVICE (self), name, error);
-	if (str == NULL)
+	str = g_hash_table_lookup (attrs, name);
+	if (str == NULL) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_FOUND,
+			     "attribute %s returned no data",
+			     name);
 		return 0x0;
+	}
 
 	val = g_ascii_strtoull (str, NULL, 16);
 	if (val == 0x0) {
@@ -235,9 +268,20 @@ fu_thunderbolt_device_setup (FuDevice *device, GError **error)
 	const gchar *tmp = NULL;
 	guint16 did;
 	guint16 vid;
+	const gchar *attr_names[] = { "generation", "device_name", "vendor_name", NULL };
 	g_autoptr(GError) error_gen = NULL;
+	g_autoptr(GHashTable) attrs = NULL;
 	g_autofree gchar *parent_name = fu_udev_device_get_parent_name (FU_UDEV_DEVICE (self));
 
+	/* the device may have been updated since last time */
+	g_clear_object (&self->firmware_active);
+
+	/* these never change for the lifetime of the device */
+	attrs = fu_udev_device_get_sysfs_attrs (FU_UDEV_DEVICE (self), attr_names,
+						FU_UDEV_DEVICE_ATTR_FLAG_CACHE, error);
+	if (attrs == NULL)
+		return FALSE;
+
 	self->devpath = g_strdup (fu_udev_device_get_sysfs_path (FU_UDEV_DEVICE (device)));
 	fu_device_set_metadata (device, "sysfs-path", self->devpath);
 
@@ -251,7 +295,7 @@ fu_thunderbolt_device_setup (FuDevice *device, GError **error)
 		g_debug ("failed to get Device ID");
 
 	/* requires kernel 5.5 or later, non-fatal if not available */
-	self->gen = fu_thunderbolt_device_get_attr_uint16 (self, "generation", &error_gen);
+	self->gen = fu_thunderbolt_device_get_attr_uint16 (attrs, "generation", &error_gen);
 	if (self->gen == 0)
 		g_debug ("Unable to read generation: %s", error_gen->message);
 
@@ -265,7 +309,7 @@ fu_thunderbolt_device_setup (FuDevice *device, GError **error)
 		fu_device_add_flag (device, FWUPD_DEVICE_FLAG_INTERNAL);
 		fu_device_set_summary (device, "Unmatched performance for high-speed I/O");
 	} else {
-		tmp = fu_udev_device_get_sysfs_attr (FU_UDEV_DEVICE (self), "device_name", NULL);
+		tmp = g_hash_table_lookup (attrs, "device_name");
 	}
 
 	/* set the controller name */
@@ -278,9 +322,14 @@ fu_thunderbolt_device_setup (FuDevice *device, GError **error)
 	fu_device_set_name (device, tmp);
 
 	/* set vendor string */
-	tmp = fu_udev_device_get_sysfs_attr (FU_UDEV_DEVICE (self), "vendor_name", error);
-	if (tmp == NULL)
+	tmp = g_hash_table_lookup (attrs, "vendor_name");
+	if (tmp == NULL) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_FOUND,
+				     "attribute vendor_name returned no data");
 		return FALSE;
+	}
 	fu_device_set_vendor (device, tmp);
 
 	/* try to read the version */
@@ -372,15 +421,20 @@ fu_thunderbolt_device_trigger_update (FuDevice *device, GError **error)
 static gboolean
 fu_thunderbolt_device_attach (FuDevice *device, GError **error)
 {
-	const gchar *attribute;
+	FuThunderboltDevice *self = FU_THUNDERBOLT_DEVICE (device);
 	guint64 status;
+	g_autofree gchar *attribute = NULL;
+	g_autofree gchar *auth_path = NULL;
 
-	/* now check if the update actually worked */
-	attribute = fu_udev_device_get_sysfs_attr (FU_UDEV_DEVICE (device),
-						   "nvm_authenticate",
-						   error);
-	if (attribute == NULL)
+	/* the controller authenticates the whole image itself, so the status
+	 * is all that is needed rather than reading the NVM back -- read the
+	 * file directly as the udev sysfs attribute values are cached */
+	auth_path = g_build_filename (self->devpath, "nvm_authenticate", NULL);
+	if (!g_file_get_contents (auth_path, &attribute, NULL, error)) {
+		g_prefix_error (error, "could not read 'nvm_authenticate': ");
 		return FALSE;
+	}
+	errno = 0;
 	status = g_ascii_strtoull (attribute, NULL, 16);
 	if (status == G_MAXUINT64 && errno == ERANGE) {
 		g_set_error (error, G_IO_ERROR,
@@ -415,56 +469,56 @@ fu_thunderbolt_device_write_data (FuThunderboltDevice	*self,
 				  GBytes		*blob_fw,
 				  GError		**error)
 {
-	gsize fw_size;
-	gsize nwritten;
-	gssize n;
+	const guint8 *buf;
+	gsize fw_size = 0;
+	gsize nwritten = 0;
+	int fd;
+	g_autofree gchar *fn = NULL;
 	g_autoptr(GFile) nvmem = NULL;
-	g_autoptr(GOutputStream) os = NULL;
 
 	nvmem = fu_thunderbolt_device_find_nvmem (self, FALSE, error);
 	if (nvmem == NULL)
 		return FALSE;
-
-	os = (GOutputStream *) g_file_append_to (nvmem,
-						 G_FILE_CREATE_NONE,
-						 NULL,
-						 error);
-
-	if (os == NULL)
+	fn = g_file_get_path (nvmem);
+	fd = open (fn, O_WRONLY | O_CLOEXEC);
+	if (fd < 0) {
+		g_set_error (error, G_IO_ERROR,
+			     g_io_error_from_errno (errno),
+			     "could not open %s: %s",
+			     fn, g_strerror (errno));
 		return FALSE;
+	}
 
-	nwritten = 0;
-	fw_size = g_bytes_get_size (blob_fw);
+	/* write from the image directly in large blocks at explicit offsets,
+	 * as the kernel may accept less than a block for each call */
+	buf = g_bytes_get_data (blob_fw, &fw_size);
 	fu_device_set_progress_full (FU_DEVICE (self), nwritten, fw_size);
-
-	do {
-		g_autoptr(GBytes) fw_data = NULL;
-
-		fw_data = g_bytes_new_from_bytes (blob_fw,
-						  nwritten,
-						  fw_size - nwritten);
-
-		n = g_output_stream_write_bytes (os,
-						 fw_data,
-						 NULL,
-						 error);
-		if (n < 0)
+	while (nwritten < fw_size) {
+		gsize blocksz = MIN (fw_size - nwritten, FU_THUNDERBOLT_DEVICE_WRITE_BLOCKSZ);
+		ssize_t n = pwrite (fd, buf + nwritten, blocksz, (off_t) nwritten);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			g_set_error (error, G_IO_ERROR,
+				     n < 0 ? g_io_error_from_errno (errno) : G_IO_ERROR_FAILED,
+				     "could not write to nvmem at 0x%x: %s",
+				     (guint) nwritten,
+				     n < 0 ? g_strerror (errno) : "no data written");
+			(void) close (fd);
 			return FALSE;
-
+		}
 		nwritten += n;
 		fu_device_set_progress_full (FU_DEVICE (self), nwritten, fw_size);
+	}
 
-	} while (nwritten < fw_size);
-
-	if (nwritten != fw_size) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_WRITE,
-				     "Could not write all data to nvmem");
+	if (close (fd) < 0 && errno != EINTR) {
+		g_set_error (error, G_IO_ERROR,
+			     g_io_error_from_errno (errno),
+			     "could not close nvmem: %s",
+			     g_strerror (errno));
 		return FALSE;
 	}
-
-	return g_output_stream_close (os, NULL, error);
+	return TRUE;
 }
 
 static FuFirmware *
@@ -475,21 +529,15 @@ fu_thunderbolt_device_prepare_firmware (FuDevice *device,
 {
 	FuThunderboltDevice *self = FU_THUNDERBOLT_DEVICE (device);
 	g_autoptr(FuThunderboltFirmwareUpdate) firmware = fu_thunderbolt_firmware_update_new ();
-	g_autoptr(FuThunderboltFirmware) firmware_old = fu_thunderbolt_firmware_new ();
-	g_autoptr(GBytes) controller_fw = NULL;
-	g_autoptr(GError) error_local = NULL;
-	g_autoptr(GFile) nvmem = NULL;
+	g_autoptr(FuThunderboltFirmware) firmware_old = NULL;
 
 	/* parse */
 	if (!fu_firmware_parse (FU_FIRMWARE (firmware), fw, flags, error))
 		return NULL;
 
 	/* get current NVMEM */
-	nvmem = fu_thunderbolt_device_find_nvmem (self, TRUE, error);
-	if (nvmem == NULL)
-		return NULL;
-	controller_fw = g_file_load_bytes (nvmem, NULL, NULL, error);
-	if (!fu_firmware_parse (FU_FIRMWARE (firmware_old), controller_fw, flags, error))
+	firmware_old = fu_thunderbolt_device_get_firmware_active (self, error);
+	if (firmware_old == NULL)
 		return NULL;
 	if (fu_thunderbolt_firmware_is_host (FU_THUNDERBOLT_FIRMWARE (firmware)) !=
 	    fu_thunderbolt_firmware_is_host (firmware_old)) {
@@ -570,6 +618,7 @@ fu_thunderbolt_device_write_firmware (FuDevice *device,
 		return FALSE;
 
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
+	g_clear_object (&self->firmware_active);
 	if (!fu_thunderbolt_device_write_data (self, blob_fw, error)) {
 		g_prefix_error (error,
 				"could not write firmware to thunderbolt device at %s: ",
@@ -608,6 +657,8 @@ static void
 fu_thunderbolt_device_finalize (GObject *object)
 {
 	FuThunderboltDevice *self = FU_THUNDERBOLT_DEVICE (object);
+	if (self->firmware_active != NULL)
+		g_object_unref (self->firmware_active);
 	G_OBJECT_CLASS (fu_thunderbolt_device_parent_class)->finalize (object);
 	g_free (self->devpath);
 }
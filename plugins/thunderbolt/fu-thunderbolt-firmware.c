@@ -25,6 +25,7 @@ typedef struct
 	guint				 gen;
 	guint				 ports;
 	guint8				 flash_size;
+	GBytes				*fw;		/* the default image */
 } FuThunderboltFirmwarePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (FuThunderboltFirmware, fu_thunderbolt_firmware, FU_TYPE_FIRMWARE)
@@ -166,10 +167,14 @@ fu_thunderbolt_firmware_read_location (FuThunderboltFirmware *self,
 	guint32 location_start = priv->sections[section] + offset;
 	g_autoptr(GBytes) fw = NULL;
 
-	/* get blob */
-	fw = fu_firmware_get_image_default_bytes (FU_FIRMWARE (self), error);
-	if (fw == NULL)
-		return FALSE;
+	/* get blob, which is only looked up once when parsing */
+	if (priv->fw != NULL) {
+		fw = g_bytes_ref (priv->fw);
+	} else {
+		fw = fu_firmware_get_image_default_bytes (FU_FIRMWARE (self), error);
+		if (fw == NULL)
+			return FALSE;
+	}
 	srcbuf = g_bytes_get_data (fw, &srcbufsz);
 
 	if (!fu_memcpy_safe (buf, len, 0x0,			/* dst */
@@ -389,6 +394,9 @@ fu_thunderbolt_firmware_parse (FuFirmware *firmware,
 
 	/* add this straight away so we can read it without a self */
 	fu_firmware_add_image (firmware, img);
+	if (priv->fw != NULL)
+		g_bytes_unref (priv->fw);
+	priv->fw = g_bytes_ref (fw);
 
 	/* subclassed */
 	if (klass_firmware->parse != NULL) {
@@ -521,10 +529,22 @@ fu_thunderbolt_firmware_init (FuThunderboltFirmware *self)
 {
 }
 
+static void
+fu_thunderbolt_firmware_finalize (GObject *object)
+{
+	FuThunderboltFirmware *self = FU_THUNDERBOLT_FIRMWARE (object);
+	FuThunderboltFirmwarePrivate *priv = GET_PRIVATE (self);
+	if (priv->fw != NULL)
+		g_bytes_unref (priv->fw);
+	G_OBJECT_CLASS (fu_thunderbolt_firmware_parent_class)->finalize (object);
+}
+
 static void
 fu_thunderbolt_firmware_class_init (FuThunderboltFirmwareClass *klass)
 {
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	FuFirmwareClass *klass_firmware = FU_FIRMWARE_CLASS (klass);
+	object_class->finalize = fu_thunderbolt_firmware_finalize;
 	klass_firmware->parse = fu_thunderbolt_firmware_parse;
 	klass_firmware->to_string = fu_thunderbolt_firmware_to_string;
 }
@@ -23,6 +23,7 @@ fu_plugin_init (FuPlugin *plugin)
 {
 	fu_plugin_alloc_data (plugin, sizeof (FuPluginData));
 	fu_plugin_add_rule (plugin, FU_PLUGIN_RULE_RUN_BEFORE, "uefi");
+	fu_plugin_add_flag (plugin, FU_PLUGIN_FLAG_THREADED_COLDPLUG);
 	fu_plugin_set_build_hash (plugin, FU_BUILD_HASH);
 }
 
@@ -53,9 +54,6 @@ fu_plugin_coldplug (FuPlugin *plugin, GError **error)
 		g_propagate_error (error, g_steal_pointer (&error_local));
 		return FALSE;
 	}
-
-	if (!g_file_get_contents (fn, (gchar **) &buf, &bufsz, error))
-		return FALSE;
 	if (bufsz == 0) {
 		g_set_error (error,
 			     FWUPD_ERROR,
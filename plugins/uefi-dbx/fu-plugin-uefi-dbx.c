@@ -6,6 +6,8 @@
 
 #include "config.h"
 
+#include <glib/gstdio.h>
+
 #include "fu-plugin-vfuncs.h"
 #include "fu-efivar.h"
 #include "fu-hash.h"
@@ -14,6 +16,8 @@
 
 struct FuPluginData {
 	gchar			*fn;
+	FuUefiDbxFile		*dbx_update;	/* nullable */
+	GStatBuf		 dbx_update_st;	/* when dbx_update was parsed */
 };
 
 void
@@ -28,6 +32,8 @@ fu_plugin_destroy (FuPlugin *plugin)
 {
 	FuPluginData *data = fu_plugin_get_data (plugin);
 	g_free (data->fn);
+	if (data->dbx_update != NULL)
+		g_object_unref (data->dbx_update);
 }
 
 gboolean
@@ -41,17 +47,53 @@ fu_plugin_startup (FuPlugin *plugin, GError **error)
 	return TRUE;
 }
 
+/* the update file only changes when dbxtool is upgraded, so only re-read
+ * it if the inode, size or modification time is different */
+static FuUefiDbxFile *
+fu_plugin_uefi_dbx_ensure_update (FuPlugin *plugin, const gchar **result)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	GStatBuf st = { 0 };
+	gsize bufsz = 0;
+	g_autofree guint8 *buf_update = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	if (g_stat (data->fn, &st) == 0 &&
+	    data->dbx_update != NULL &&
+	    st.st_dev == data->dbx_update_st.st_dev &&
+	    st.st_ino == data->dbx_update_st.st_ino &&
+	    st.st_size == data->dbx_update_st.st_size &&
+	    st.st_mtime == data->dbx_update_st.st_mtime)
+		return data->dbx_update;
+	g_clear_object (&data->dbx_update);
+
+	if (!g_file_get_contents (data->fn, (gchar **) &buf_update, &bufsz, &error_local)) {
+		g_warning ("failed to load %s: %s", data->fn, error_local->message);
+		*result = "Failed to load update DBX";
+		return NULL;
+	}
+	data->dbx_update = fu_uefi_dbx_file_new (buf_update, bufsz,
+						 FU_UEFI_DBX_FILE_PARSE_FLAGS_IGNORE_HEADER,
+						 &error_local);
+	if (data->dbx_update == NULL) {
+		g_warning ("failed to parse %s: %s", data->fn, error_local->message);
+		*result = "Failed to parse update DBX";
+		return NULL;
+	}
+	data->dbx_update_st = st;
+	return data->dbx_update;
+}
+
 void
 fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
 {
-	FuPluginData *data = fu_plugin_get_data (plugin);
-	GPtrArray *checksums;
+	FuUefiDbxFile *dbx_update;
+	GPtrArray *digests;
+	const gchar *result = NULL;
 	gsize bufsz = 0;
 	guint missing_cnt = 0;
 	g_autofree guint8 *buf_system = NULL;
-	g_autofree guint8 *buf_update = NULL;
 	g_autoptr(FuUefiDbxFile) dbx_system = NULL;
-	g_autoptr(FuUefiDbxFile) dbx_update = NULL;
 	g_autoptr(FwupdSecurityAttr) attr = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -73,17 +115,9 @@ fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
 	}
 
 	/* get update dbx */
-	if (!g_file_get_contents (data->fn, (gchar **) &buf_update, &bufsz, &error_local)) {
-		g_warning ("failed to load %s: %s", data->fn, error_local->message);
-		fwupd_security_attr_set_result (attr, "Failed to load update DBX");
-		return;
-	}
-	dbx_update = fu_uefi_dbx_file_new (buf_update, bufsz,
-					   FU_UEFI_DBX_FILE_PARSE_FLAGS_IGNORE_HEADER,
-					   &error_local);
+	dbx_update = fu_plugin_uefi_dbx_ensure_update (plugin, &result);
 	if (dbx_update == NULL) {
-		g_warning ("failed to parse %s: %s", data->fn, error_local->message);
-		fwupd_security_attr_set_result (attr, "Failed to parse update DBX");
+		fwupd_security_attr_set_result (attr, result);
 		return;
 	}
 
@@ -104,11 +138,13 @@ fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
 	}
 
 	/* look for each checksum in the update in the system version */
-	checksums = fu_uefi_dbx_file_get_checksums (dbx_update);
-	for (guint i = 0; i < checksums->len; i++) {
-		const gchar *checksum = g_ptr_array_index (checksums, i);
-		if (!fu_uefi_dbx_file_has_checksum (dbx_system, checksum)) {
-			g_debug ("%s missing from the system DBX", checksum);
+	digests = fu_uefi_dbx_file_get_digests (dbx_update);
+	for (guint i = 0; i < digests->len; i++) {
+		GBytes *digest = g_ptr_array_index (digests, i);
+		if (!fu_uefi_dbx_file_has_digest (dbx_system, digest)) {
+			GPtrArray *checksums = fu_uefi_dbx_file_get_checksums (dbx_update);
+			g_debug ("%s missing from the system DBX",
+				 (const gchar *) g_ptr_array_index (checksums, i));
 			missing_cnt += 1;
 		}
 	}
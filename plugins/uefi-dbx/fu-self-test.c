@@ -40,6 +40,11 @@ fu_uefi_dbx_file_parse_func (void)
 	g_assert_cmpint (fu_uefi_dbx_file_get_checksums(uefi_dbx_file)->len, ==, 77);
 	g_assert_true (fu_uefi_dbx_file_has_checksum (uefi_dbx_file, "72e0bd1867cf5d9d56ab158adf3bddbc82bf32a8d8aa1d8c5e2f6df29428d6d8"));
 	g_assert_false (fu_uefi_dbx_file_has_checksum (uefi_dbx_file, "dave"));
+	g_assert_cmpint (fu_uefi_dbx_file_get_digests(uefi_dbx_file)->len, ==, 77);
+	for (guint i = 0; i < 77; i++) {
+		GBytes *digest = g_ptr_array_index (fu_uefi_dbx_file_get_digests (uefi_dbx_file), i);
+		g_assert_true (fu_uefi_dbx_file_has_digest (uefi_dbx_file, digest));
+	}
 }
 
 int
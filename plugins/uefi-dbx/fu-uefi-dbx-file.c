@@ -15,7 +15,9 @@
 
 struct _FuUefiDbxFile {
 	GObject		 parent_instance;
-	GPtrArray	*checksums;
+	GPtrArray	*digests;	/* (element-type GBytes) */
+	GHashTable	*digests_set;	/* GBytes */
+	GPtrArray	*checksums;	/* (element-type utf-8), nullable */
 };
 
 G_DEFINE_TYPE (FuUefiDbxFile, fu_uefi_dbx_file, G_TYPE_OBJECT)
@@ -28,11 +30,10 @@ fu_uefi_dbx_file_parse_sig_item (FuUefiDbxFile *self,
 				 guint32 sig_size,
 				 GError **error)
 {
-	GString *sig_datastr;
 	fwupd_guid_t guid;
 	gsize sig_datasz = sig_size - sizeof(fwupd_guid_t);
-	g_autofree gchar *sig_owner = NULL;
 	g_autofree guint8 *sig_data = g_malloc0 (sig_datasz);
+	GBytes *digest;
 
 	/* read both blocks of data */
 	if (!fu_memcpy_safe ((guint8 *) &guid, sizeof(guid), 0x0,	/* dst */
@@ -48,13 +49,10 @@ fu_uefi_dbx_file_parse_sig_item (FuUefiDbxFile *self,
 		return FALSE;
 	}
 
-	/* we don't care about the owner, so just store the checksum */
-	sig_owner = fwupd_guid_to_string (&guid, FWUPD_GUID_FLAG_MIXED_ENDIAN);
-	sig_datastr = g_string_new (NULL);
-	for (gsize j = 0; j < sig_datasz; j++)
-		g_string_append_printf (sig_datastr, "%02x", sig_data[j]);
-	g_debug ("Owner: %s, Data: %s", sig_owner, sig_datastr->str);
-	g_ptr_array_add (self->checksums, g_string_free (sig_datastr, FALSE));
+	/* we don't care about the owner, so just store the raw digest */
+	digest = g_bytes_new_take (g_steal_pointer (&sig_data), sig_datasz);
+	g_ptr_array_add (self->digests, digest);
+	g_hash_table_add (self->digests_set, g_bytes_ref (digest));
 	return TRUE;
 }
 
@@ -160,22 +158,65 @@ fu_uefi_dbx_file_new (const guint8 *buf, gsize bufsz,
 	return g_steal_pointer (&self);
 }
 
+gboolean
+fu_uefi_dbx_file_has_digest (FuUefiDbxFile *self, GBytes *digest)
+{
+	g_return_val_if_fail (FU_IS_UEFI_DBX_FILE (self), FALSE);
+	g_return_val_if_fail (digest != NULL, FALSE);
+	return g_hash_table_contains (self->digests_set, digest);
+}
+
 gboolean
 fu_uefi_dbx_file_has_checksum (FuUefiDbxFile *self, const gchar *checksum)
 {
+	gsize checksumsz;
+	g_autofree guint8 *buf = NULL;
+	g_autoptr(GBytes) digest = NULL;
+
 	g_return_val_if_fail (FU_IS_UEFI_DBX_FILE (self), FALSE);
-	for (guint i = 0; i < self->checksums->len; i++) {
-		const gchar *checksums_tmp = g_ptr_array_index (self->checksums, i);
-		if (g_strcmp0 (checksums_tmp, checksum) == 0)
-			return TRUE;
+	g_return_val_if_fail (checksum != NULL, FALSE);
+
+	/* convert to the raw digest */
+	checksumsz = strlen (checksum);
+	if (checksumsz % 2 != 0)
+		return FALSE;
+	buf = g_malloc (checksumsz / 2);
+	for (gsize i = 0; i < checksumsz / 2; i++) {
+		gint hi = g_ascii_xdigit_value (checksum[i * 2]);
+		gint lo = g_ascii_xdigit_value (checksum[(i * 2) + 1]);
+		if (hi < 0 || lo < 0)
+			return FALSE;
+		buf[i] = (hi << 4) | lo;
 	}
-	return FALSE;
+	digest = g_bytes_new_take (g_steal_pointer (&buf), checksumsz / 2);
+	return fu_uefi_dbx_file_has_digest (self, digest);
+}
+
+GPtrArray *
+fu_uefi_dbx_file_get_digests (FuUefiDbxFile *self)
+{
+	g_return_val_if_fail (FU_IS_UEFI_DBX_FILE (self), NULL);
+	return self->digests;
 }
 
 GPtrArray *
 fu_uefi_dbx_file_get_checksums (FuUefiDbxFile *self)
 {
-	g_return_val_if_fail (FU_IS_UEFI_DBX_FILE (self), FALSE);
+	g_return_val_if_fail (FU_IS_UEFI_DBX_FILE (self), NULL);
+
+	/* only build the strings if required */
+	if (self->checksums == NULL) {
+		self->checksums = g_ptr_array_new_with_free_func (g_free);
+		for (guint i = 0; i < self->digests->len; i++) {
+			GBytes *digest = g_ptr_array_index (self->digests, i);
+			gsize bufsz = 0;
+			const guint8 *buf = g_bytes_get_data (digest, &bufsz);
+			GString *str = g_string_sized_new (bufsz * 2);
+			for (gsize j = 0; j < bufsz; j++)
+				g_string_append_printf (str, "%02x", buf[j]);
+			g_ptr_array_add (self->checksums, g_string_free (str, FALSE));
+		}
+	}
 	return self->checksums;
 }
 
@@ -183,7 +224,10 @@ static void
 fu_uefi_dbx_file_finalize (GObject *obj)
 {
 	FuUefiDbxFile *self = FU_UEFI_DBX_FILE (obj);
-	g_ptr_array_unref (self->checksums);
+	g_ptr_array_unref (self->digests);
+	g_hash_table_unref (self->digests_set);
+	if (self->checksums != NULL)
+		g_ptr_array_unref (self->checksums);
 	G_OBJECT_CLASS (fu_uefi_dbx_file_parent_class)->finalize (obj);
 }
 
@@ -197,5 +241,7 @@ fu_uefi_dbx_file_class_init (FuUefiDbxFileClass *klass)
 static void
 fu_uefi_dbx_file_init (FuUefiDbxFile *self)
 {
-	self->checksums = g_ptr_array_new_with_free_func (g_free);
+	self->digests = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+	self->digests_set = g_hash_table_new_full (g_bytes_hash, g_bytes_equal,
+						   (GDestroyNotify) g_bytes_unref, NULL);
 }
@@ -22,5 +22,8 @@ FuUefiDbxFile	*fu_uefi_dbx_file_new		(const guint8	*buf,
 						 FuUefiDbxFileParseFlags flags,
 						 GError		**error);
 GPtrArray	*fu_uefi_dbx_file_get_checksums	(FuUefiDbxFile	*self);
+GPtrArray	*fu_uefi_dbx_file_get_digests	(FuUefiDbxFile	*self);
 gboolean	 fu_uefi_dbx_file_has_checksum	(FuUefiDbxFile	*self,
 						 const gchar	*checksum);
+gboolean	 fu_uefi_dbx_file_has_digest	(FuUefiDbxFile	*self,
+						 GBytes		*digest);
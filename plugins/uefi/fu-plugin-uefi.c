@@ -29,6 +29,10 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(GUnixMountEntry, g_unix_mount_free)
 
 struct FuPluginData {
 	FuUefiBgrt		*bgrt;
+	FuUefiDevice		*bootmgr_device;	/* first staged capsule */
+	GBytes			*splash_bmp;		/* decompressed, nullable */
+	guint32			 splash_width;
+	guint32			 splash_height;
 };
 
 void
@@ -47,6 +51,10 @@ fu_plugin_destroy (FuPlugin *plugin)
 {
 	FuPluginData *data = fu_plugin_get_data (plugin);
 	g_object_unref (data->bgrt);
+	if (data->bootmgr_device != NULL)
+		g_object_unref (data->bootmgr_device);
+	if (data->splash_bmp != NULL)
+		g_bytes_unref (data->splash_bmp);
 }
 
 gboolean
@@ -354,12 +362,23 @@ fu_plugin_uefi_update_splash (FuPlugin *plugin, FuDevice *device, GError **error
 		return FALSE;
 	}
 
-	/* get the raw data */
-	image_bmp = fu_plugin_uefi_get_splash_data (sizes[best_idx].width,
-						    sizes[best_idx].height,
-						    error);
-	if (image_bmp == NULL)
-		return FALSE;
+	/* get the raw data, which is only decompressed once for each size */
+	if (data->splash_bmp != NULL &&
+	    data->splash_width == sizes[best_idx].width &&
+	    data->splash_height == sizes[best_idx].height) {
+		image_bmp = g_bytes_ref (data->splash_bmp);
+	} else {
+		image_bmp = fu_plugin_uefi_get_splash_data (sizes[best_idx].width,
+							    sizes[best_idx].height,
+							    error);
+		if (image_bmp == NULL)
+			return FALSE;
+		if (data->splash_bmp != NULL)
+			g_bytes_unref (data->splash_bmp);
+		data->splash_bmp = g_bytes_ref (image_bmp);
+		data->splash_width = sizes[best_idx].width;
+		data->splash_height = sizes[best_idx].height;
+	}
 
 	/* perform the upload */
 	return fu_plugin_uefi_write_splash_data (plugin, device, image_bmp, error);
@@ -372,8 +391,10 @@ fu_plugin_update (FuPlugin *plugin,
 		  FwupdInstallFlags flags,
 		  GError **error)
 {
+	FuPluginData *data = fu_plugin_get_data (plugin);
 	const gchar *str;
 	guint32 flashes_left;
+	gboolean first_capsule = TRUE;
 	g_autoptr(GError) error_splash = NULL;
 
 	/* test the flash counter */
@@ -400,13 +421,25 @@ fu_plugin_update (FuPlugin *plugin,
 	/* perform the update */
 	g_debug ("Performing UEFI capsule update");
 	fu_device_set_status (device, FWUPD_STATUS_SCHEDULING);
-	if (!fu_plugin_uefi_update_splash (plugin, device, &error_splash)) {
+
+	/* only clean the ESP and write the UX capsule once per composite update */
+	if (fu_uefi_device_get_staged (FU_UEFI_DEVICE (device))) {
+		first_capsule = data->bootmgr_device == NULL;
+		if (first_capsule &&
+		    !fu_uefi_device_cleanup_esp (FU_UEFI_DEVICE (device), error))
+			return FALSE;
+	}
+	if (first_capsule &&
+	    !fu_plugin_uefi_update_splash (plugin, device, &error_splash)) {
 		g_debug ("failed to upload UEFI UX capsule text: %s",
 			 error_splash->message);
 	}
 
 	if (!fu_device_write_firmware (device, blob_fw, flags, error))
 		return FALSE;
+	if (fu_uefi_device_get_staged (FU_UEFI_DEVICE (device)) &&
+	    data->bootmgr_device == NULL)
+		data->bootmgr_device = FU_UEFI_DEVICE (g_object_ref (device));
 
 	/* record if we had an invalid header during update */
 	str = fu_uefi_missing_capsule_header (device) ? "True" : "False";
@@ -419,6 +452,72 @@ fu_plugin_update (FuPlugin *plugin,
 	return TRUE;
 }
 
+gboolean
+fu_plugin_composite_prepare (FuPlugin *plugin,
+			     GPtrArray *devices,
+			     GError **error)
+{
+	g_autoptr(GPtrArray) devices_uefi = g_ptr_array_new ();
+
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *dev = g_ptr_array_index (devices, i);
+		if (FU_IS_UEFI_DEVICE (dev))
+			g_ptr_array_add (devices_uefi, dev);
+	}
+	if (devices_uefi->len < 2)
+		return TRUE;
+	g_debug ("staging %u capsules", devices_uefi->len);
+	for (guint i = 0; i < devices_uefi->len; i++) {
+		FuUefiDevice *dev = g_ptr_array_index (devices_uefi, i);
+		fu_uefi_device_set_staged (dev, TRUE);
+	}
+	return TRUE;
+}
+
+gboolean
+fu_plugin_composite_cleanup (FuPlugin *plugin,
+			     GPtrArray *devices,
+			     GError **error)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	g_autoptr(FuUefiDevice) bootmgr_device = g_steal_pointer (&data->bootmgr_device);
+	g_autoptr(GError) error_local = NULL;
+
+	/* stop staging, so that any later update sets up the boot entry itself */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *dev = g_ptr_array_index (devices, i);
+		if (FU_IS_UEFI_DEVICE (dev))
+			fu_uefi_device_set_staged (FU_UEFI_DEVICE (dev), FALSE);
+	}
+
+	/* run every capsule that was written, even if a later one failed */
+	if (bootmgr_device != NULL &&
+	    fu_uefi_device_get_bootmgr_pending (bootmgr_device)) {
+		g_debug ("setting up boot entry for staged capsules");
+		if (!fu_uefi_device_write_bootmgr (bootmgr_device, &error_local))
+			g_prefix_error (&error_local, "failed to set up boot entry: ");
+	}
+
+	/* the ESP was left mounted by the device cleanup */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *dev = g_ptr_array_index (devices, i);
+		g_autoptr(GError) error_umount = NULL;
+		if (!FU_IS_UEFI_DEVICE (dev))
+			continue;
+		if (!fu_uefi_device_umount_esp (FU_UEFI_DEVICE (dev), &error_umount)) {
+			if (error_local == NULL)
+				error_local = g_steal_pointer (&error_umount);
+			else
+				g_warning ("%s", error_umount->message);
+		}
+	}
+	if (error_local != NULL) {
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_plugin_uefi_load_config (FuPlugin *plugin, FuDevice *device, GError **error)
 {
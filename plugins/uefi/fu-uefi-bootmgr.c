@@ -90,25 +90,33 @@ fu_uefi_bootmgr_add_to_boot_order (guint16 boot_entry, GError **error)
 }
 
 static gboolean
-fu_uefi_setup_bootnext_with_dp (const guint8 *dp_buf, guint8 *opt, gssize opt_size, GError **error)
+fu_uefi_setup_bootnext_with_dp_snapshot (const guint8 *dp_buf, guint8 *opt, gssize opt_size, GError **error)
 {
-	efi_guid_t *guid = NULL;
 	efi_load_option *loadopt = NULL;
-	gchar *name = NULL;
+	const gchar *name = NULL;
 	gint rc;
 	gsize var_data_size = 0;
 	guint32 attr;
 	guint16 boot_next = G_MAXUINT16;
 	g_autofree guint8 *var_data = NULL;
 	g_autofree guint8 *set_entries = g_malloc0 (G_MAXUINT16);
+	g_autoptr(GPtrArray) names = NULL;
 
-	while ((rc = efi_get_next_variable_name (&guid, &name)) > 0) {
+	/* only the Boot#### variables are read */
+	names = fu_efivar_get_names (FU_EFIVAR_GUID_EFI_GLOBAL, error);
+	if (names == NULL) {
+		g_prefix_error (error, "failed to find boot variable: ");
+		return FALSE;
+	}
+	for (guint i = 0; i < names->len; i++) {
 		const gchar *desc;
 		gint scanned = 0;
 		guint16 entry = 0;
 		g_autofree guint8 *var_data_tmp = NULL;
+		g_autoptr(GError) error_local = NULL;
 
-		if (efi_guid_cmp (guid, &efi_guid_global) != 0)
+		name = g_ptr_array_index (names, i);
+		if (!g_str_has_prefix (name, "Boot"))
 			continue;
 		rc = sscanf (name, "Boot%hX%n", &entry, &scanned);
 		if (rc < 0) {
@@ -126,9 +134,10 @@ fu_uefi_setup_bootnext_with_dp (const guint8 *dp_buf, guint8 *opt, gssize opt_si
 		/* mark this as used */
 		set_entries[entry] = 1;
 
-		rc = efi_get_variable (*guid, name, &var_data_tmp, &var_data_size, &attr);
-		if (rc < 0) {
-			g_debug ("efi_get_variable(%s) failed", name);
+		if (!fu_efivar_get_data (FU_EFIVAR_GUID_EFI_GLOBAL, name,
+					 &var_data_tmp, &var_data_size,
+					 &attr, &error_local)) {
+			g_debug ("failed to get %s: %s", name, error_local->message);
 			continue;
 		}
 
@@ -147,16 +156,8 @@ fu_uefi_setup_bootnext_with_dp (const guint8 *dp_buf, guint8 *opt, gssize opt_si
 
 		var_data = g_steal_pointer (&var_data_tmp);
 		boot_next = entry;
-		efi_error_clear ();
 		break;
 	}
-	if (rc < 0) {
-		g_set_error_literal (error,
-				     G_IO_ERROR,
-				     G_IO_ERROR_FAILED,
-				     "failed to find boot variable");
-		return FALSE;
-	}
 
 	/* already exists */
 	if (var_data != NULL) {
@@ -165,12 +166,9 @@ fu_uefi_setup_bootnext_with_dp (const guint8 *dp_buf, guint8 *opt, gssize opt_si
 		if (var_data_size != (gsize) opt_size ||
 		    memcmp (var_data, opt, opt_size) != 0) {
 			efi_loadopt_attr_set (loadopt, LOAD_OPTION_ACTIVE);
-			rc = efi_set_variable (*guid, name, opt, opt_size, attr, 0644);
-			if (rc < 0) {
-				g_set_error_literal (error,
-						     G_IO_ERROR,
-						     G_IO_ERROR_FAILED,
-						     "could not set boot variable active");
+			if (!fu_efivar_set_data (FU_EFIVAR_GUID_EFI_GLOBAL, name,
+						 opt, opt_size, attr, error)) {
+				g_prefix_error (error, "could not set boot variable active: ");
 				return FALSE;
 			}
 		}
@@ -192,17 +190,14 @@ fu_uefi_setup_bootnext_with_dp (const guint8 *dp_buf, guint8 *opt, gssize opt_si
 			return FALSE;
 		}
 		boot_next_name = g_strdup_printf ("Boot%04X", (guint) boot_next);
-		rc = efi_set_variable (efi_guid_global, boot_next_name, opt, opt_size,
-				       EFI_VARIABLE_NON_VOLATILE |
-				       EFI_VARIABLE_BOOTSERVICE_ACCESS |
-				       EFI_VARIABLE_RUNTIME_ACCESS,
-				       0644);
-		if (rc < 0) {
-			g_set_error (error,
-				     G_IO_ERROR,
-				     G_IO_ERROR_FAILED,
-				     "could not set boot variable %s: %d",
-				     boot_next_name, rc);
+		if (!fu_efivar_set_data (FU_EFIVAR_GUID_EFI_GLOBAL, boot_next_name,
+					 opt, opt_size,
+					 FU_EFIVAR_ATTR_NON_VOLATILE |
+					 FU_EFIVAR_ATTR_BOOTSERVICE_ACCESS |
+					 FU_EFIVAR_ATTR_RUNTIME_ACCESS,
+					 error)) {
+			g_prefix_error (error, "could not set boot variable %s: ",
+					boot_next_name);
 			return FALSE;
 		}
 	}
@@ -228,6 +223,19 @@ fu_uefi_setup_bootnext_with_dp (const guint8 *dp_buf, guint8 *opt, gssize opt_si
 	return TRUE;
 }
 
+static gboolean
+fu_uefi_setup_bootnext_with_dp (const guint8 *dp_buf, guint8 *opt, gssize opt_size, GError **error)
+{
+	gboolean ret;
+
+	/* enumerate and read the boot entries once */
+	if (!fu_efivar_snapshot_begin (error))
+		return FALSE;
+	ret = fu_uefi_setup_bootnext_with_dp_snapshot (dp_buf, opt, opt_size, error);
+	fu_efivar_snapshot_end ();
+	return ret;
+}
+
 static gboolean
 fu_uefi_cmp_asset (const gchar *source, const gchar *target)
 {
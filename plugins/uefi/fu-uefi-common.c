@@ -25,6 +25,10 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(GUnixMountEntry, g_unix_mount_free)
 #pragma clang diagnostic pop
 #endif
 
+/* udisks objpath of the ESP, checked again before each use */
+static gchar *fu_uefi_udisks_esp_cache = NULL;
+G_LOCK_DEFINE_STATIC (fu_uefi_udisks_esp_cache);
+
 static const gchar *
 fu_uefi_bootmgr_get_suffix (GError **error)
 {
@@ -364,6 +368,21 @@ fu_uefi_probe_udisks_esp (GError **error)
 	g_autoptr(GPtrArray) devices = NULL;
 	g_autofree gchar *found_esp = NULL;
 
+	/* the partition may have been removed or reformatted since */
+	G_LOCK (fu_uefi_udisks_esp_cache);
+	if (fu_uefi_udisks_esp_cache != NULL) {
+		if (fu_uefi_udisks_objpath_is_esp (fu_uefi_udisks_esp_cache)) {
+			found_esp = g_strdup (fu_uefi_udisks_esp_cache);
+			G_UNLOCK (fu_uefi_udisks_esp_cache);
+			g_debug ("Udisks cached objpath %s", found_esp);
+			return g_steal_pointer (&found_esp);
+		}
+		g_debug ("cached objpath %s no longer an ESP",
+			 fu_uefi_udisks_esp_cache);
+		g_clear_pointer (&fu_uefi_udisks_esp_cache, g_free);
+	}
+	G_UNLOCK (fu_uefi_udisks_esp_cache);
+
 	devices = fu_uefi_udisks_get_block_devices (error);
 	if (devices == NULL)
 		return NULL;
@@ -393,6 +412,10 @@ fu_uefi_probe_udisks_esp (GError **error)
 	}
 
 	g_debug ("Udisks detected objpath %s", found_esp);
+	G_LOCK (fu_uefi_udisks_esp_cache);
+	g_free (fu_uefi_udisks_esp_cache);
+	fu_uefi_udisks_esp_cache = g_strdup (found_esp);
+	G_UNLOCK (fu_uefi_udisks_esp_cache);
 	return g_steal_pointer (&found_esp);
 }
 
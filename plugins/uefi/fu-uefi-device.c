@@ -34,7 +34,9 @@ struct _FuUefiDevice {
 	guint32			 last_attempt_version;
 	guint64			 fmp_hardware_instance;
 	gboolean		 missing_header;
-	gboolean		 automounted_esp;
+	gchar			*automounted_esp;	/* udisks objpath */
+	gboolean		 staged;
+	gboolean		 bootmgr_pending;
 };
 
 G_DEFINE_TYPE (FuUefiDevice, fu_uefi_device, FU_TYPE_DEVICE)
@@ -445,10 +447,10 @@ fu_uefi_device_check_esp_free (FuDevice *device, GError **error)
 	return 	fu_uefi_check_esp_free_space (esp_path, sz_reqd, error);
 }
 
-static gboolean
-fu_uefi_device_cleanup_esp (FuDevice *device, GError **error)
+gboolean
+fu_uefi_device_cleanup_esp (FuUefiDevice *self, GError **error)
 {
-	const gchar *esp_path = fu_device_get_metadata (device, "EspPath");
+	const gchar *esp_path = fu_device_get_metadata (FU_DEVICE (self), "EspPath");
 	g_autofree gchar *pattern = NULL;
 	g_autoptr(GPtrArray) files = NULL;
 
@@ -503,7 +505,7 @@ fu_uefi_device_prepare (FuDevice *device,
 				detected_esp = fu_uefi_udisks_objpath_mount (guessed, error);
 				if (detected_esp == NULL)
 					return FALSE;
-				self->automounted_esp = TRUE;
+				self->automounted_esp = g_strdup (guessed);
 			}
 		/* already mounted */
 		} else {
@@ -517,34 +519,87 @@ fu_uefi_device_prepare (FuDevice *device,
 		return FALSE;
 	if (!fu_uefi_device_check_esp_free (device, error))
 		return FALSE;
-	if (!fu_uefi_device_cleanup_esp (device, error))
+
+	/* when staged the plugin cleans up once before the first capsule */
+	if (!FU_UEFI_DEVICE (device)->staged &&
+	    !fu_uefi_device_cleanup_esp (FU_UEFI_DEVICE (device), error))
 		return FALSE;
 
 	return TRUE;
 }
 
+gboolean
+fu_uefi_device_umount_esp (FuUefiDevice *self, GError **error)
+{
+	/* unmount the partition we mounted, without probing again */
+	if (self->automounted_esp != NULL) {
+		g_debug ("Unmounting ESP @ %s", self->automounted_esp);
+		if (!fu_uefi_udisks_objpath_umount (self->automounted_esp, error))
+			return FALSE;
+		g_clear_pointer (&self->automounted_esp, g_free);
+		/* we will detect again if necessary */
+		fu_device_remove_metadata (FU_DEVICE (self), "EspPath");
+	}
+
+	return TRUE;
+}
+
 static gboolean
 fu_uefi_device_cleanup (FuDevice *device,
 			FwupdInstallFlags flags,
 			GError **error)
 {
 	FuUefiDevice *self = FU_UEFI_DEVICE (device);
-	if (self->automounted_esp) {
-		g_autofree gchar *guessed = NULL;
-		guessed = fu_uefi_guess_esp_path (error);
-		if (guessed == NULL)
-			return FALSE;
-		g_debug ("Unmounting ESP @ %s", guessed);
-		if (!fu_uefi_udisks_objpath_umount (guessed, error))
-			return FALSE;
-		self->automounted_esp = FALSE;
-		/* we will detect again if necessary */
-		fu_device_remove_metadata (device, "EspPath");
-	}
 
+	/* the ESP is needed until the boot entry has been written */
+	if (self->staged)
+		return TRUE;
+	return fu_uefi_device_umount_esp (self, error);
+}
+
+/* copy fwupd.efi if changed and set the boot entry and BootNext */
+gboolean
+fu_uefi_device_write_bootmgr (FuUefiDevice *self, GError **error)
+{
+	FuDevice *device = FU_DEVICE (self);
+	FuUefiBootmgrFlags flags = FU_UEFI_BOOTMGR_FLAG_NONE;
+	const gchar *bootmgr_desc = "Linux Firmware Updater";
+	const gchar *esp_path = fu_device_get_metadata (device, "EspPath");
+
+	/* update the firmware before the bootloader runs */
+	if (fu_device_get_metadata_boolean (device, "RequireShimForSecureBoot"))
+		flags |= FU_UEFI_BOOTMGR_FLAG_USE_SHIM_FOR_SB;
+	if (fu_device_has_custom_flag (device, "use-shim-unique"))
+		flags |= FU_UEFI_BOOTMGR_FLAG_USE_SHIM_UNIQUE;
+
+	/* some legacy devices use the old name to deduplicate boot entries */
+	if (fu_device_has_custom_flag (device, "use-legacy-bootmgr-desc"))
+		bootmgr_desc = "Linux-Firmware-Updater";
+	if (!fu_uefi_bootmgr_bootnext (esp_path, bootmgr_desc, flags, error))
+		return FALSE;
+	self->bootmgr_pending = FALSE;
 	return TRUE;
 }
 
+/* when staged the plugin writes the boot entry after all the capsules */
+void
+fu_uefi_device_set_staged (FuUefiDevice *self, gboolean staged)
+{
+	self->staged = staged;
+}
+
+gboolean
+fu_uefi_device_get_staged (FuUefiDevice *self)
+{
+	return self->staged;
+}
+
+gboolean
+fu_uefi_device_get_bootmgr_pending (FuUefiDevice *self)
+{
+	return self->bootmgr_pending;
+}
+
 static gboolean
 fu_uefi_device_write_firmware (FuDevice *device,
 			       FuFirmware *firmware,
@@ -552,8 +607,6 @@ fu_uefi_device_write_firmware (FuDevice *device,
 			       GError **error)
 {
 	FuUefiDevice *self = FU_UEFI_DEVICE (device);
-	FuUefiBootmgrFlags flags = FU_UEFI_BOOTMGR_FLAG_NONE;
-	const gchar *bootmgr_desc = "Linux Firmware Updater";
 	const gchar *esp_path = fu_device_get_metadata (device, "EspPath");
 	efi_guid_t guid;
 	g_autoptr(GBytes) fixed_fw = NULL;
@@ -600,16 +653,12 @@ fu_uefi_device_write_firmware (FuDevice *device,
 	if (!fu_uefi_device_write_update_info (self, fn, varname, &guid, error))
 		return FALSE;
 
-	/* update the firmware before the bootloader runs */
-	if (fu_device_get_metadata_boolean (device, "RequireShimForSecureBoot"))
-		flags |= FU_UEFI_BOOTMGR_FLAG_USE_SHIM_FOR_SB;
-	if (fu_device_has_custom_flag (device, "use-shim-unique"))
-		flags |= FU_UEFI_BOOTMGR_FLAG_USE_SHIM_UNIQUE;
-
-	/* some legacy devices use the old name to deduplicate boot entries */
-	if (fu_device_has_custom_flag (device, "use-legacy-bootmgr-desc"))
-		bootmgr_desc = "Linux-Firmware-Updater";
-	if (!fu_uefi_bootmgr_bootnext (esp_path, bootmgr_desc, flags, error))
+	/* the plugin sets up the boot entry once for all the capsules */
+	if (self->staged) {
+		self->bootmgr_pending = TRUE;
+		return TRUE;
+	}
+	if (!fu_uefi_device_write_bootmgr (self, error))
 		return FALSE;
 
 	/* success! */
@@ -736,6 +785,7 @@ fu_uefi_device_finalize (GObject *object)
 	FuUefiDevice *self = FU_UEFI_DEVICE (object);
 
 	g_free (self->fw_class);
+	g_free (self->automounted_esp);
 
 	G_OBJECT_CLASS (fu_uefi_device_parent_class)->finalize (object);
 }
@@ -55,6 +55,16 @@ const gchar	*fu_uefi_device_status_to_string	(FuUefiDeviceStatus status);
 FuUefiUpdateInfo *fu_uefi_device_load_update_info	(FuUefiDevice	*self,
 							 GError		**error);
 gboolean	 fu_uefi_missing_capsule_header		(FuDevice *device);
+gboolean	 fu_uefi_device_cleanup_esp		(FuUefiDevice	*self,
+							 GError		**error);
+gboolean	 fu_uefi_device_umount_esp		(FuUefiDevice	*self,
+							 GError		**error);
+gboolean	 fu_uefi_device_write_bootmgr		(FuUefiDevice	*self,
+							 GError		**error);
+void		 fu_uefi_device_set_staged		(FuUefiDevice	*self,
+							 gboolean	 staged);
+gboolean	 fu_uefi_device_get_staged		(FuUefiDevice	*self);
+gboolean	 fu_uefi_device_get_bootmgr_pending	(FuUefiDevice	*self);
 gboolean	 fu_uefi_device_write_update_info	(FuUefiDevice	*self,
 							 const gchar	*filename,
 							 const gchar	*varname,
@@ -113,6 +113,7 @@ fu_uefi_pcrs_setup_tpm20 (FuUefiPcrs *self, GError **error)
 	g_autoptr(ESYS_CONTEXT) ctx = NULL;
 	g_autofree TPMS_CAPABILITY_DATA *capability_data = NULL;
 	TPML_PCR_SELECTION pcr_selection_in = { 0, };
+	g_autofree TPML_PCR_SELECTION *pcr_selection_out = NULL;
 	g_autofree TPML_DIGEST *pcr_values = NULL;
 
 	/* suppress warning messages about missing TCTI libraries for tpm2-tss <2.3 */
@@ -152,31 +153,63 @@ fu_uefi_pcrs_setup_tpm20 (FuUefiPcrs *self, GError **error)
 		pcr_selection_in.pcrSelections[i].pcrSelect[0] = 0b00000001;
 	}
 
-	rc = Esys_PCR_Read (ctx, ESYS_TR_NONE, ESYS_TR_NONE, ESYS_TR_NONE,
-	                    &pcr_selection_in, NULL, NULL, &pcr_values);
-	if (rc != TSS2_RC_SUCCESS) {
-		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
-		                     "failed to read PCR values from TPM");
-		return FALSE;
-	}
-
-	for (guint i = 0; i < pcr_values->count; i++) {
-		FuUefiPcrItem *item;
-		g_autoptr(GString) str = NULL;
-
-		str = g_string_new (NULL);
-		for (guint j = 0; j < pcr_values->digests[i].size; j++) {
-			gint64 val = pcr_values->digests[i].buffer[j];
-			if (val > 0)
+	/* all the banks are read in one command, but the TPM may return fewer
+	 * digests than were asked for, so ask again for the ones left over */
+	while (pcr_selection_in.count > 0) {
+		TPML_PCR_SELECTION pcr_selection_todo = { 0, };
+
+		g_clear_pointer (&pcr_selection_out, g_free);
+		g_clear_pointer (&pcr_values, g_free);
+		rc = Esys_PCR_Read (ctx, ESYS_TR_NONE, ESYS_TR_NONE, ESYS_TR_NONE,
+				    &pcr_selection_in, NULL, &pcr_selection_out, &pcr_values);
+		if (rc != TSS2_RC_SUCCESS) {
+			g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+					     "failed to read PCR values from TPM");
+			return FALSE;
+		}
+		if (pcr_values->count == 0)
+			break;
+
+		for (guint i = 0; i < pcr_values->count; i++) {
+			FuUefiPcrItem *item;
+			g_autoptr(GString) str = NULL;
+			gboolean all_zero = TRUE;
+
+			/* an unextended bank is all zeros */
+			str = g_string_new (NULL);
+			for (guint j = 0; j < pcr_values->digests[i].size; j++) {
+				if (pcr_values->digests[i].buffer[j] != 0x0)
+					all_zero = FALSE;
 				g_string_append_printf (str, "%02x", pcr_values->digests[i].buffer[j]);
+			}
+			if (str->len > 0 && !all_zero) {
+				item = g_new0 (FuUefiPcrItem, 1);
+				item->idx = 0; /* constant PCR index 0, since we only read this single PCR */
+				item->checksum = g_string_free (g_steal_pointer (&str), FALSE);
+				g_ptr_array_add (self->items, item);
+				g_debug ("added PCR-%02u=%s", item->idx, item->checksum);
+			}
 		}
-		if (str->len > 0) {
-			item = g_new0 (FuUefiPcrItem, 1);
-			item->idx = 0; /* constant PCR index 0, since we only read this single PCR */
-			item->checksum = g_string_free (g_steal_pointer (&str), FALSE);
-			g_ptr_array_add (self->items, item);
-			g_debug ("added PCR-%02u=%s", item->idx, item->checksum);
+
+		/* remove the banks that were returned */
+		for (guint i = 0; i < pcr_selection_in.count; i++) {
+			gboolean done = FALSE;
+			for (guint j = 0; j < pcr_selection_out->count; j++) {
+				if (pcr_selection_out->pcrSelections[j].hash ==
+				    pcr_selection_in.pcrSelections[i].hash &&
+				    pcr_selection_out->pcrSelections[j].pcrSelect[0] != 0x0) {
+					done = TRUE;
+					break;
+				}
+			}
+			if (!done) {
+				pcr_selection_todo.pcrSelections[pcr_selection_todo.count++] =
+					pcr_selection_in.pcrSelections[i];
+			}
 		}
+		if (pcr_selection_todo.count == pcr_selection_in.count)
+			break;
+		pcr_selection_in = pcr_selection_todo;
 	}
 #endif
 
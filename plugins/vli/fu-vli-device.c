@@ -49,6 +49,8 @@ fu_vli_device_spi_req_to_string (FuVliDeviceSpiReq req)
 		return "SpiCmdWriteEn";
 	if (req == FU_VLI_DEVICE_SPI_REQ_WRITE_STATUS)
 		return "SpiCmdWriteStatus";
+	if (req == FU_VLI_DEVICE_SPI_REQ_BLOCK_ERASE)
+		return "SpiCmdBlockErase";
 	return NULL;
 }
 
@@ -144,6 +146,19 @@ fu_vli_device_spi_sector_erase (FuVliDevice *self, guint32 addr, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_vli_device_spi_block_erase (FuVliDevice *self, guint32 addr, GError **error)
+{
+	FuVliDeviceClass *klass = FU_VLI_DEVICE_GET_CLASS (self);
+	if (klass->spi_block_erase != NULL) {
+		if (!klass->spi_block_erase (self, addr, error)) {
+			g_prefix_error (error, "failed to erase SPI block @0x%x: ", addr);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
 gboolean
 fu_vli_device_spi_read_block (FuVliDevice *self, guint32 addr,
 			      guint8 *buf, gsize bufsz, GError **error)
@@ -173,38 +188,76 @@ fu_vli_device_spi_write_data (FuVliDevice *self, guint32 addr,
 }
 
 static gboolean
-fu_vli_device_spi_wait_finish (FuVliDevice *self, GError **error)
+fu_vli_device_spi_wait_finish_cb (FuDevice *device,
+				  gboolean *done,
+				  gpointer user_data,
+				  GError **error)
 {
+	FuVliDevice *self = FU_VLI_DEVICE (device);
+	guint32 *cnt = (guint32 *) user_data;
 	const guint32 rdy_cnt = 2;
-	guint32 cnt = 0;
+	guint8 status = 0x7f;
 
-	for (guint32 idx = 0; idx < 1000; idx++) {
-		guint8 status = 0x7f;
+	/* must get bit[1:0] == 0 twice in a row for success */
+	if (!fu_vli_device_spi_read_status (self, &status, error))
+		return FALSE;
+	if ((status & 0x03) == 0x00) {
+		if ((*cnt)++ >= rdy_cnt)
+			*done = TRUE;
+	} else {
+		*cnt = 0;
+	}
+	return TRUE;
+}
 
-		/* must get bit[1:0] == 0 twice in a row for success */
-		if (!fu_vli_device_spi_read_status (self, &status, error))
+static gboolean
+fu_vli_device_spi_wait_finish (FuVliDevice *self, GError **error)
+{
+	guint32 cnt = 0;
+	if (!fu_device_wait_for (FU_DEVICE (self),
+				 fu_vli_device_spi_wait_finish_cb,
+				 500 * 1000, &cnt, error)) {
+		g_prefix_error (error, "failed to wait for SPI: ");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* stops reading at the first block that is not blank */
+static gboolean
+fu_vli_device_spi_range_is_blank (FuVliDevice *self,
+				  guint32 addr,
+				  guint32 bufsz,
+				  gboolean *blank,
+				  GError **error)
+{
+	for (guint32 offset = 0; offset < bufsz; offset += FU_VLI_DEVICE_TXSIZE) {
+		guint8 buf[FU_VLI_DEVICE_TXSIZE] = { 0x0 };
+		if (!fu_vli_device_spi_read_block (self,
+						  addr + offset,
+						  buf, sizeof (buf),
+						  error))
 			return FALSE;
-		if ((status & 0x03) == 0x00) {
-			if (cnt++ >= rdy_cnt)
-				return TRUE;
-		} else {
-			cnt = 0;
+		if (!fu_common_data_is_empty (buf, sizeof(buf))) {
+			if (g_getenv ("FWUPD_VLI_USBHUB_VERBOSE") != NULL)
+				g_debug ("not blank @0x%x", addr + offset);
+			*blank = FALSE;
+			return TRUE;
 		}
-		g_usleep (500 * 1000);
 	}
-	g_set_error (error,
-		     G_IO_ERROR,
-		     G_IO_ERROR_FAILED,
-		     "failed to wait for SPI");
-	return FALSE;
+	*blank = TRUE;
+	return TRUE;
 }
 
-gboolean
-fu_vli_device_spi_erase_sector (FuVliDevice *self, guint32 addr, GError **error)
+static gboolean
+fu_vli_device_spi_erase_region (FuVliDevice *self,
+				guint32 addr,
+				guint32 sz,
+				GError **error)
 {
-	const guint32 bufsz = 0x1000;
+	gboolean blank = FALSE;
 
-	/* erase sector */
+	/* erase sector or block */
 	if (!fu_vli_device_spi_write_enable (self, error)) {
 		g_prefix_error (error, "->spi_write_enable failed: ");
 		return FALSE;
@@ -217,9 +270,16 @@ fu_vli_device_spi_erase_sector (FuVliDevice *self, guint32 addr, GError **error)
 		g_prefix_error (error, "->spi_write_enable failed: ");
 		return FALSE;
 	}
-	if (!fu_vli_device_spi_sector_erase (self, addr, error)) {
-		g_prefix_error (error, "->spi_sector_erase failed");
-		return FALSE;
+	if (sz == FU_VLI_DEVICE_SPI_BLOCK_SIZE) {
+		if (!fu_vli_device_spi_block_erase (self, addr, error)) {
+			g_prefix_error (error, "->spi_block_erase failed");
+			return FALSE;
+		}
+	} else {
+		if (!fu_vli_device_spi_sector_erase (self, addr, error)) {
+			g_prefix_error (error, "->spi_sector_erase failed");
+			return FALSE;
+		}
 	}
 	if (!fu_vli_device_spi_wait_finish (self, error)) {
 		g_prefix_error (error, "->spi_wait_finish failed");
@@ -227,31 +287,31 @@ fu_vli_device_spi_erase_sector (FuVliDevice *self, guint32 addr, GError **error)
 	}
 
 	/* verify it really was blanked */
-	for (guint32 offset = 0; offset < bufsz; offset += FU_VLI_DEVICE_TXSIZE) {
-		guint8 buf[FU_VLI_DEVICE_TXSIZE] = { 0x0 };
-		if (!fu_vli_device_spi_read_block (self,
-						  addr + offset,
-						  buf, sizeof (buf),
-						  error)) {
-			g_prefix_error (error, "failed to read back empty: ");
-			return FALSE;
-		}
-		for (guint i = 0; i < sizeof(buf); i++) {
-			if (buf[i] != 0xff) {
-				g_set_error (error,
-					     G_IO_ERROR,
-					     G_IO_ERROR_FAILED,
-					     "failed to check blank @0x%x",
-					     addr + offset + i);
-				return FALSE;
-			}
-		}
+	if (!fu_vli_device_spi_range_is_blank (self, addr, sz, &blank, error)) {
+		g_prefix_error (error, "failed to read back empty: ");
+		return FALSE;
+	}
+	if (!blank) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_FAILED,
+			     "failed to check blank @0x%x",
+			     addr);
+		return FALSE;
 	}
 
 	/* success */
 	return TRUE;
 }
 
+gboolean
+fu_vli_device_spi_erase_sector (FuVliDevice *self, guint32 addr, GError **error)
+{
+	return fu_vli_device_spi_erase_region (self, addr,
+					       FU_VLI_DEVICE_SPI_SECTOR_SIZE,
+					       error);
+}
+
 GBytes *
 fu_vli_device_spi_read (FuVliDevice *self, guint32 address, gsize bufsz, GError **error)
 {
@@ -324,6 +384,7 @@ fu_vli_device_spi_write (FuVliDevice *self,
 			 GError **error)
 {
 	FuChunk *chk;
+	guint skipped = 0;
 	g_autoptr(GPtrArray) chunks = NULL;
 
 	/* write SPI data, then CRC bytes last */
@@ -332,6 +393,12 @@ fu_vli_device_spi_write (FuVliDevice *self,
 	if (chunks->len > 1) {
 		for (guint i = 1; i < chunks->len; i++) {
 			chk = g_ptr_array_index (chunks, i);
+
+			/* the range has been erased, so do not program padding */
+			if (fu_common_data_is_empty (chk->data, chk->data_sz)) {
+				skipped++;
+				continue;
+			}
 			if (!fu_vli_device_spi_write_block (self,
 							    chk->address + address,
 							    chk->data,
@@ -355,6 +422,8 @@ fu_vli_device_spi_write (FuVliDevice *self,
 		return FALSE;
 	}
 	fu_device_set_progress_full (FU_DEVICE (self), (gsize) chunks->len, (gsize) chunks->len);
+	if (skipped > 0)
+		g_debug ("skipped %u blank blocks", skipped);
 	return TRUE;
 }
 
@@ -394,24 +463,57 @@ fu_vli_device_spi_erase_all (FuVliDevice *self, GError **error)
 	return TRUE;
 }
 
+/* use a block erase when the chip has one and it is wholly within the range */
+static guint32
+fu_vli_device_spi_erase_get_size (FuVliDevice *self, guint32 addr, guint32 addr_end)
+{
+	FuVliDevicePrivate *priv = GET_PRIVATE (self);
+	FuVliDeviceClass *klass = FU_VLI_DEVICE_GET_CLASS (self);
+	if (klass->spi_block_erase != NULL &&
+	    priv->spi_cmds[FU_VLI_DEVICE_SPI_REQ_BLOCK_ERASE] != 0x0 &&
+	    addr % FU_VLI_DEVICE_SPI_BLOCK_SIZE == 0 &&
+	    addr_end - addr >= FU_VLI_DEVICE_SPI_BLOCK_SIZE)
+		return FU_VLI_DEVICE_SPI_BLOCK_SIZE;
+	return FU_VLI_DEVICE_SPI_SECTOR_SIZE;
+}
+
 gboolean
 fu_vli_device_spi_erase (FuVliDevice *self, guint32 addr, gsize sz, GError **error)
 {
-	g_autoptr(GPtrArray) chunks = fu_chunk_array_new (NULL, sz, addr, 0x0, 0x1000);
+	guint skipped = 0;
+	guint erased = 0;
+	guint32 addr_end = addr + sz;
 	g_debug ("erasing 0x%x bytes @0x%x", (guint) sz, addr);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chunk = g_ptr_array_index (chunks, i);
-		if (g_getenv ("FWUPD_VLI_USBHUB_VERBOSE") != NULL)
-			g_debug ("erasing @0x%x", chunk->address);
-		if (!fu_vli_device_spi_erase_sector (FU_VLI_DEVICE (self), chunk->address, error)) {
+	for (guint32 addr_tmp = addr; addr_tmp < addr_end; ) {
+		guint32 erasesz = fu_vli_device_spi_erase_get_size (self, addr_tmp, addr_end);
+		gboolean blank = FALSE;
+
+		/* already erased, which is checked after erasing anyway */
+		if (!fu_vli_device_spi_range_is_blank (self, addr_tmp, erasesz, &blank, error)) {
 			g_prefix_error (error,
-					"failed to erase FW sector @0x%x: ",
-					chunk->address);
+					"failed to check FW sector @0x%x: ",
+					addr_tmp);
 			return FALSE;
 		}
+		if (blank) {
+			skipped++;
+		} else {
+			if (g_getenv ("FWUPD_VLI_USBHUB_VERBOSE") != NULL)
+				g_debug ("erasing 0x%x bytes @0x%x", erasesz, addr_tmp);
+			if (!fu_vli_device_spi_erase_region (self, addr_tmp, erasesz, error)) {
+				g_prefix_error (error,
+						"failed to erase FW sector @0x%x: ",
+						addr_tmp);
+				return FALSE;
+			}
+			erased++;
+		}
+		addr_tmp += erasesz;
 		fu_device_set_progress_full (FU_DEVICE (self),
-					     (gsize) i, (gsize) chunks->len);
+					     (gsize) MIN (addr_tmp, addr_end) - addr,
+					     (gsize) sz);
 	}
+	g_debug ("erased %u regions, skipped %u blank regions", erased, skipped);
 	return TRUE;
 }
 
@@ -606,6 +708,10 @@ fu_vli_device_set_quirk_kv (FuDevice *device,
 		priv->spi_cmds[FU_VLI_DEVICE_SPI_REQ_SECTOR_ERASE] = fu_common_strtoull (value);
 		return TRUE;
 	}
+	if (g_strcmp0 (key, "SpiCmdBlockErase") == 0) {
+		priv->spi_cmds[FU_VLI_DEVICE_SPI_REQ_BLOCK_ERASE] = fu_common_strtoull (value);
+		return TRUE;
+	}
 	if (g_strcmp0 (key, "SpiAutoDetect") == 0) {
 		priv->spi_auto_detect = fu_common_strtoull (value) > 0;
 		return TRUE;
@@ -26,6 +26,9 @@ struct _FuVliDeviceClass
 	gboolean		 (*spi_sector_erase)	(FuVliDevice	*self,
 							 guint32	 addr,
 							 GError		**error);
+	gboolean		 (*spi_block_erase)	(FuVliDevice	*self,
+							 guint32	 addr,
+							 GError		**error);
 	gboolean		 (*spi_read_data)	(FuVliDevice	*self,
 							 guint32	 addr,
 							 guint8		*buf,
@@ -55,11 +58,14 @@ typedef enum {
 	FU_VLI_DEVICE_SPI_REQ_SECTOR_ERASE,
 	FU_VLI_DEVICE_SPI_REQ_WRITE_EN,
 	FU_VLI_DEVICE_SPI_REQ_WRITE_STATUS,
+	FU_VLI_DEVICE_SPI_REQ_BLOCK_ERASE,
 	FU_VLI_DEVICE_SPI_REQ_LAST
 } FuVliDeviceSpiReq;
 
 #define FU_VLI_DEVICE_TIMEOUT			3000	/* ms */
 #define FU_VLI_DEVICE_TXSIZE			0x20	/* bytes */
+#define FU_VLI_DEVICE_SPI_SECTOR_SIZE		0x1000	/* bytes */
+#define FU_VLI_DEVICE_SPI_BLOCK_SIZE		0x10000	/* bytes */
 
 void		 fu_vli_device_set_kind			(FuVliDevice	*self,
 							 FuVliDeviceKind device_kind);
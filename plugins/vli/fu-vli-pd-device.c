@@ -176,13 +176,15 @@ fu_vli_pd_device_spi_chip_erase (FuVliDevice *self, GError **error)
 }
 
 static gboolean
-fu_vli_pd_device_spi_sector_erase (FuVliDevice *self, guint32 addr, GError **error)
+fu_vli_pd_device_spi_erase (FuVliDevice *self,
+			    FuVliDeviceSpiReq req,
+			    guint32 addr,
+			    GError **error)
 {
 	guint8 spi_cmd = 0x0;
 	guint16 value;
 	guint16 index;
-	if (!fu_vli_device_get_spi_cmd (self, FU_VLI_DEVICE_SPI_REQ_SECTOR_ERASE,
-					&spi_cmd, error))
+	if (!fu_vli_device_get_spi_cmd (self, req, &spi_cmd, error))
 		return FALSE;
 	value = ((addr << 8) & 0xff00) | spi_cmd;
 	index = addr >> 8;
@@ -196,6 +198,18 @@ fu_vli_pd_device_spi_sector_erase (FuVliDevice *self, guint32 addr, GError **err
 					      NULL, error);
 }
 
+static gboolean
+fu_vli_pd_device_spi_sector_erase (FuVliDevice *self, guint32 addr, GError **error)
+{
+	return fu_vli_pd_device_spi_erase (self, FU_VLI_DEVICE_SPI_REQ_SECTOR_ERASE, addr, error);
+}
+
+static gboolean
+fu_vli_pd_device_spi_block_erase (FuVliDevice *self, guint32 addr, GError **error)
+{
+	return fu_vli_pd_device_spi_erase (self, FU_VLI_DEVICE_SPI_REQ_BLOCK_ERASE, addr, error);
+}
+
 static gboolean
 fu_vli_pd_device_spi_write_data (FuVliDevice *self,
 				 guint32 addr,
@@ -656,6 +670,7 @@ fu_vli_pd_device_class_init (FuVliPdDeviceClass *klass)
 	klass_vli_device->setup = fu_vli_pd_device_setup;
 	klass_vli_device->spi_chip_erase = fu_vli_pd_device_spi_chip_erase;
 	klass_vli_device->spi_sector_erase = fu_vli_pd_device_spi_sector_erase;
+	klass_vli_device->spi_block_erase = fu_vli_pd_device_spi_block_erase;
 	klass_vli_device->spi_read_data = fu_vli_pd_device_spi_read_data;
 	klass_vli_device->spi_read_status = fu_vli_pd_device_spi_read_status;
 	klass_vli_device->spi_write_data = fu_vli_pd_device_spi_write_data;
@@ -7,6 +7,8 @@
 
 #include "config.h"
 
+#include "fu-crc.h"
+
 #include "fu-vli-pd-common.h"
 #include "fu-vli-pd-firmware.h"
 
@@ -136,7 +138,7 @@ fu_vli_pd_firmware_parse (FuFirmware *firmware,
 			g_prefix_error (error, "failed to read file CRC: ");
 			return FALSE;
 		}
-		crc_actual = fu_vli_common_crc16 (buf, bufsz - 2);
+		crc_actual = ~fu_crc16_reflected_full (buf, bufsz - 2, 0xffff, 0xa001);
 		if (crc_actual != crc_file) {
 			g_set_error (error,
 				     FWUPD_ERROR,
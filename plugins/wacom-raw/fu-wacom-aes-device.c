@@ -220,6 +220,10 @@ fu_wacom_aes_device_write_firmware (FuDevice *device, GPtrArray *chunks, GError
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	for (guint i = 0; i < chunks->len; i++) {
 		FuChunk *chk = g_ptr_array_index (chunks, i);
+
+		/* the whole flash was erased, so there is nothing to write */
+		if (fu_common_data_is_empty (chk->data, chk->data_sz))
+			continue;
 		if (!fu_wacom_aes_device_write_block (self,
 						      chk->idx,
 						      chk->address,
@@ -96,13 +96,3 @@ fu_wacom_common_rc_set_error (const FuWacomRawResponse *rsp, GError **error)
 		     "unknown error 0x%02x", rsp->resp);
 	return FALSE;
 }
-
-gboolean
-fu_wacom_common_block_is_empty (const guint8 *data, guint16 datasz)
-{
-	for (guint16 i = 0; i < datasz; i++) {
-		if (data[i] != 0xff)
-			return FALSE;
-	}
-	return TRUE;
-}
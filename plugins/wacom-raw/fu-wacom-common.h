@@ -68,5 +68,3 @@ gboolean	 fu_wacom_common_rc_set_error	(const FuWacomRawResponse *rsp,
 gboolean	 fu_wacom_common_check_reply	(const FuWacomRawRequest *req,
 						 const FuWacomRawResponse *rsp,
 						 GError		**error);
-gboolean	 fu_wacom_common_block_is_empty	(const guint8	*data,
-						 guint16	 datasz);
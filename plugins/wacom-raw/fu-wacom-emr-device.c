@@ -207,7 +207,7 @@ fu_wacom_emr_device_write_firmware (FuDevice *device, GPtrArray *chunks, GError
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	for (guint i = 0; i < chunks->len; i++) {
 		FuChunk *chk = g_ptr_array_index (chunks, i);
-		if (fu_wacom_common_block_is_empty (chk->data, chk->data_sz))
+		if (fu_common_data_is_empty (chk->data, chk->data_sz))
 			continue;
 		if (!fu_wacom_emr_device_write_block (self,
 						      chk->idx,
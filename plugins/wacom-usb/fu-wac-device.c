@@ -450,6 +450,7 @@ fu_wac_device_write_firmware (FuDevice *device,
 	FuWacDevice *self = FU_WAC_DEVICE (device);
 	gsize blocks_done = 0;
 	gsize blocks_total = 0;
+	g_autofree gboolean *unchanged = NULL;
 	g_autofree guint32 *csum_local = NULL;
 	g_autoptr(FuFirmwareImage) img = NULL;
 	g_autoptr(GHashTable) fd_blobs = NULL;
@@ -480,16 +481,6 @@ fu_wac_device_write_firmware (FuDevice *device,
 	if (!fu_wac_device_ensure_checksums (self, error))
 		return FALSE;
 
-	/* clear all checksums of pages */
-	fu_device_set_status (device, FWUPD_STATUS_DEVICE_ERASE);
-	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
-		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
-		if (fu_wav_device_flash_descriptor_is_wp (fd))
-			continue;
-		if (!fu_wac_device_set_checksum_of_block (self, i, 0x0, error))
-			return FALSE;
-	}
-
 	/* get the blobs for each chunk */
 	fd_blobs = g_hash_table_new_full (g_direct_hash, g_direct_equal,
 					  NULL, (GDestroyNotify) g_bytes_unref);
@@ -510,12 +501,44 @@ fu_wac_device_write_firmware (FuDevice *device,
 		g_hash_table_insert (fd_blobs, fd, blob_block);
 	}
 
+	/* ask the device for the CRC of what is in flash now */
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_VERIFY);
+	csum_local = g_new0 (guint32, self->flash_descriptors->len);
+	unchanged = g_new0 (gboolean, self->flash_descriptors->len);
+	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
+		if (!fu_wac_device_calculate_checksum_of_block (self, i, error))
+			return FALSE;
+	}
+	if (!fu_wac_device_ensure_checksums (self, error))
+		return FALSE;
+	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
+		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
+		GBytes *blob_block = g_hash_table_lookup (fd_blobs, fd);
+		if (blob_block == NULL || fu_common_bytes_is_empty (blob_block))
+			continue;
+		csum_local[i] = fu_wac_calculate_checksum32le_bytes (blob_block);
+		if (i < self->checksums->len &&
+		    g_array_index (self->checksums, guint32, i) == csum_local[i]) {
+			g_debug ("block %02u unchanged, skipping", i);
+			unchanged[i] = TRUE;
+		}
+	}
+
+	/* clear all checksums of pages */
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_ERASE);
+	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
+		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
+		if (fu_wav_device_flash_descriptor_is_wp (fd))
+			continue;
+		if (!fu_wac_device_set_checksum_of_block (self, i, 0x0, error))
+			return FALSE;
+	}
+
 	/* checksum actions post-write */
 	blocks_total = g_hash_table_size (fd_blobs) + 2;
 
 	/* write the data into the flash page */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
-	csum_local = g_new0 (guint32, self->flash_descriptors->len);
 	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
 		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
 		GBytes *blob_block;
@@ -537,6 +560,14 @@ fu_wac_device_write_firmware (FuDevice *device,
 			continue;
 		}
 
+		/* already has the right contents, so only restore the checksum */
+		if (unchanged[i]) {
+			if (!fu_wac_device_set_checksum_of_block (self, i, csum_local[i], error))
+				return FALSE;
+			fu_device_set_progress_full (device, blocks_done++, blocks_total);
+			continue;
+		}
+
 		/* erase entire block */
 		if (!fu_wac_device_erase_block (self, i, error))
 			return FALSE;
@@ -553,8 +584,7 @@ fu_wac_device_write_firmware (FuDevice *device,
 				return FALSE;
 		}
 
-		/* calculate expected checksum and save to device RAM */
-		csum_local[i] = fu_wac_calculate_checksum32le_bytes (blob_block);
+		/* save expected checksum to device RAM */
 		g_debug ("block checksum %02u: 0x%08x", i, csum_local[i]);
 		if (!fu_wac_device_set_checksum_of_block (self, i, csum_local[i], error))
 			return FALSE;
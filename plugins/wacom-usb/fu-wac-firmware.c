@@ -27,6 +27,22 @@ typedef struct {
 	guint32 prog_start_addr;
 } FuFirmwareWacHeaderRecord;
 
+static gboolean
+fu_wac_firmware_check_magic (FuFirmware *firmware, GBytes *fw, GError **error)
+{
+	gsize len = 0;
+	const guint8 *data = g_bytes_get_data (fw, &len);
+
+	if (len < 5 || memcmp (data, "WACOM", 5) != 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "invalid .wac prefix");
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_wac_firmware_parse (FuFirmware *firmware,
 		       GBytes *fw,
@@ -44,7 +60,7 @@ fu_wac_firmware_parse (FuFirmware *firmware,
 
 	/* check the prefix (BE) */
 	data = (guint8 *) g_bytes_get_data (fw, &len);
-	if (memcmp (data, "WACOM", 5) != 0) {
+	if (len < 5 || memcmp (data, "WACOM", 5) != 0) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_INTERNAL,
@@ -234,6 +250,7 @@ static void
 fu_wac_firmware_class_init (FuWacFirmwareClass *klass)
 {
 	FuFirmwareClass *klass_firmware = FU_FIRMWARE_CLASS (klass);
+	klass_firmware->check_magic = fu_wac_firmware_check_magic;
 	klass_firmware->parse = fu_wac_firmware_parse;
 }
 
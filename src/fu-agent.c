@@ -29,11 +29,75 @@ struct FuUtilPrivate {
 	GOptionContext		*context;
 	FwupdClient		*client;
 	FwupdInstallFlags	 flags;
+	gboolean		 json_lines;	/* one object per line */
+	guint			 limit;
+	guint			 offset;
 };
 
+static gboolean
+fu_util_print_builder (JsonBuilder *builder, gboolean pretty, GError **error)
+{
+	g_autofree gchar *data = NULL;
+	g_autoptr(JsonGenerator) json_generator = NULL;
+	g_autoptr(JsonNode) json_root = NULL;
+
+	/* export as a string */
+	json_root = json_builder_get_root (builder);
+	json_generator = json_generator_new ();
+	json_generator_set_pretty (json_generator, pretty);
+	json_generator_set_root (json_generator, json_root);
+	data = json_generator_to_data (json_generator, NULL);
+	if (data == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "Failed to convert to JSON string");
+		return FALSE;
+	}
+
+	/* just print */
+	g_print ("%s\n", data);
+	return TRUE;
+}
+
+/* in --json-lines mode each device is printed as soon as it is ready
+ * rather than being added to the document */
+static gboolean
+fu_util_add_device_json (FuUtilPrivate *priv,
+			 JsonBuilder *builder,
+			 FwupdDevice *dev,
+			 GError **error)
+{
+	g_autoptr(JsonBuilder) builder_line = NULL;
+	if (!priv->json_lines) {
+		json_builder_begin_object (builder);
+		fwupd_device_to_json (dev, builder);
+		json_builder_end_object (builder);
+		return TRUE;
+	}
+	builder_line = json_builder_new ();
+	json_builder_begin_object (builder_line);
+	fwupd_device_to_json (dev, builder_line);
+	json_builder_end_object (builder_line);
+	return fu_util_print_builder (builder_line, FALSE, error);
+}
+
+/* devices are not paged by the daemon, so apply --offset and --limit here */
+static gboolean
+fu_util_device_in_page (FuUtilPrivate *priv, guint *idx)
+{
+	guint idx_tmp = (*idx)++;
+	if (idx_tmp < priv->offset)
+		return FALSE;
+	if (priv->limit > 0 && idx_tmp >= priv->offset + priv->limit)
+		return FALSE;
+	return TRUE;
+}
+
 static gboolean
 fu_util_add_devices_json (FuUtilPrivate *priv, JsonBuilder *builder, GError **error)
 {
+	guint idx = 0;
 	g_autoptr(GPtrArray) devs = NULL;
 
 	/* get results from daemon */
@@ -41,13 +105,18 @@ fu_util_add_devices_json (FuUtilPrivate *priv, JsonBuilder *builder, GError **er
 	if (devs == NULL)
 		return FALSE;
 
-	json_builder_set_member_name (builder, "Devices");
-	json_builder_begin_array (builder);
+	if (!priv->json_lines) {
+		json_builder_set_member_name (builder, "Devices");
+		json_builder_begin_array (builder);
+	}
 	for (guint i = 0; i < devs->len; i++) {
 		FwupdDevice *dev = g_ptr_array_index (devs, i);
 		g_autoptr(GPtrArray) rels = NULL;
 		g_autoptr(GError) error_local = NULL;
 
+		if (!fu_util_device_in_page (priv, &idx))
+			continue;
+
 		/* add all releases that could be applied */
 		rels = fwupd_client_get_releases (priv->client,
 						  fwupd_device_get_id (dev),
@@ -64,53 +133,83 @@ fu_util_add_devices_json (FuUtilPrivate *priv, JsonBuilder *builder, GError **er
 		}
 
 		/* add to builder */
-		json_builder_begin_object (builder);
-		fwupd_device_to_json (dev, builder);
-		json_builder_end_object (builder);
+		if (!fu_util_add_device_json (priv, builder, dev, error))
+			return FALSE;
 	}
-	json_builder_end_array (builder);
+	if (!priv->json_lines)
+		json_builder_end_array (builder);
 	return TRUE;
 }
 
 static gboolean
 fu_util_add_updates_json (FuUtilPrivate *priv, JsonBuilder *builder, GError **error)
 {
+	guint idx = 0;
+	g_autoptr(GHashTable) upgrades = NULL;
 	g_autoptr(GPtrArray) devices = NULL;
 
 	/* get devices from daemon */
 	devices = fwupd_client_get_devices (priv->client, NULL, error);
 	if (devices == NULL)
 		return FALSE;
-	json_builder_set_member_name (builder, "Devices");
-	json_builder_begin_array (builder);
+	upgrades = fwupd_client_get_all_upgrades (priv->client, NULL, error);
+	if (upgrades == NULL)
+		return FALSE;
+	if (!priv->json_lines) {
+		json_builder_set_member_name (builder, "Devices");
+		json_builder_begin_array (builder);
+	}
 	for (guint i = 0; i < devices->len; i++) {
 		FwupdDevice *dev = g_ptr_array_index (devices, i);
-		g_autoptr(GPtrArray) rels = NULL;
-		g_autoptr(GError) error_local = NULL;
+		GPtrArray *rels;
 
-		/* not going to have results, so save a D-Bus round-trip */
+		/* not going to have results */
 		if (!fwupd_device_has_flag (dev, FWUPD_DEVICE_FLAG_SUPPORTED))
 			continue;
 
-		/* get the releases for this device and filter for validity */
-		rels = fwupd_client_get_upgrades (priv->client,
-						  fwupd_device_get_id (dev),
-						  NULL, &error_local);
-		if (rels == NULL) {
-			g_debug ("no upgrades: %s", error_local->message);
+		/* the daemon already filtered these for validity */
+		rels = g_hash_table_lookup (upgrades, fwupd_device_get_id (dev));
+		if (rels == NULL)
+			continue;
+		if (!fu_util_device_in_page (priv, &idx))
 			continue;
-		}
 		for (guint j = 0; j < rels->len; j++) {
 			FwupdRelease *rel = g_ptr_array_index (rels, j);
 			fwupd_device_add_release (dev, rel);
 		}
 
 		/* add to builder */
-		json_builder_begin_object (builder);
-		fwupd_device_to_json (dev, builder);
-		json_builder_end_object (builder);
+		if (!fu_util_add_device_json (priv, builder, dev, error))
+			return FALSE;
+	}
+	if (!priv->json_lines)
+		json_builder_end_array (builder);
+	return TRUE;
+}
+
+static gboolean
+fu_util_add_history_json (FuUtilPrivate *priv, JsonBuilder *builder, GError **error)
+{
+	g_autoptr(GPtrArray) devices = NULL;
+
+	/* the daemon does the paging */
+	devices = fwupd_client_get_history_full (priv->client, NULL,
+						 FWUPD_UPDATE_STATE_UNKNOWN, 0,
+						 priv->limit, priv->offset,
+						 priv->cancellable, error);
+	if (devices == NULL)
+		return FALSE;
+	if (!priv->json_lines) {
+		json_builder_set_member_name (builder, "Devices");
+		json_builder_begin_array (builder);
 	}
-	json_builder_end_array (builder);
+	for (guint i = 0; i < devices->len; i++) {
+		FwupdDevice *dev = g_ptr_array_index (devices, i);
+		if (!fu_util_add_device_json (priv, builder, dev, error))
+			return FALSE;
+	}
+	if (!priv->json_lines)
+		json_builder_end_array (builder);
 	return TRUE;
 }
 
@@ -133,68 +232,87 @@ fu_util_add_security_attributes_json (FuUtilPrivate *priv, JsonBuilder *builder,
 	attrs = fwupd_client_get_host_security_attrs (priv->client, NULL, error);
 	if (attrs == NULL)
 		return FALSE;
-	json_builder_set_member_name (builder, "HostSecurityAttributes");
-	json_builder_begin_array (builder);
+	if (!priv->json_lines) {
+		json_builder_set_member_name (builder, "HostSecurityAttributes");
+		json_builder_begin_array (builder);
+	}
 	for (guint i = 0; i < attrs->len; i++) {
 		FwupdSecurityAttr *attr = g_ptr_array_index (attrs, i);
+		if (priv->json_lines) {
+			g_autoptr(JsonBuilder) builder_line = json_builder_new ();
+			json_builder_begin_object (builder_line);
+			fwupd_security_attr_to_json (attr, builder_line);
+			json_builder_end_object (builder_line);
+			if (!fu_util_print_builder (builder_line, FALSE, error))
+				return FALSE;
+			continue;
+		}
 		json_builder_begin_object (builder);
 		fwupd_security_attr_to_json (attr, builder);
 		json_builder_end_object (builder);
 	}
-	json_builder_end_array (builder);
+	if (!priv->json_lines)
+		json_builder_end_array (builder);
 	return TRUE;
 }
 
-static gboolean
-fu_util_get_devices (FuUtilPrivate *priv, gchar **values, GError **error)
+static void
+fu_util_add_string_json (JsonBuilder *builder, const gchar *key, const gchar *value)
 {
-	g_autofree gchar *data = NULL;
-	g_autoptr(JsonBuilder) builder = NULL;
-	g_autoptr(JsonGenerator) json_generator = NULL;
-	g_autoptr(JsonNode) json_root = NULL;
+	if (value == NULL)
+		return;
+	json_builder_set_member_name (builder, key);
+	json_builder_add_string_value (builder, value);
+}
 
-	/* check args */
-	if (g_strv_length (values) != 0) {
+/* everything a fleet controller needs from one host, in one document */
+static gboolean
+fu_util_add_report_json (FuUtilPrivate *priv, JsonBuilder *builder, GError **error)
+{
+	/* the devices and attributes would be indistinguishable */
+	if (priv->json_lines) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_ARGS,
-				     "Invalid arguments");
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "--json-lines is not supported for a report");
 		return FALSE;
 	}
 
-	/* create header */
-	builder = json_builder_new ();
-	json_builder_begin_object (builder);
-	if (!fu_util_add_devices_json (priv, builder, error))
+	/* get the host properties */
+	if (!fwupd_client_connect (priv->client, priv->cancellable, error))
 		return FALSE;
-	json_builder_end_object (builder);
-
-	/* export as a string */
-	json_root = json_builder_get_root (builder);
-	json_generator = json_generator_new ();
-	json_generator_set_pretty (json_generator, TRUE);
-	json_generator_set_root (json_generator, json_root);
-	data = json_generator_to_data (json_generator, NULL);
-	if (data == NULL) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INTERNAL,
-				     "Failed to convert to JSON string");
+	fu_util_add_string_json (builder, "DaemonVersion",
+				 fwupd_client_get_daemon_version (priv->client));
+	fu_util_add_string_json (builder, "HostProduct",
+				 fwupd_client_get_host_product (priv->client));
+	fu_util_add_string_json (builder, "HostMachineId",
+				 fwupd_client_get_host_machine_id (priv->client));
+	fu_util_add_string_json (builder, "HostSecurityId",
+				 fwupd_client_get_host_security_id (priv->client));
+	json_builder_set_member_name (builder, "Tainted");
+	json_builder_add_boolean_value (builder, fwupd_client_get_tainted (priv->client));
+
+	/* only the devices with updates */
+	if (!fu_util_add_updates_json (priv, builder, error))
 		return FALSE;
-	}
 
-	/* just print */
-	g_print ("%s\n", data);
-	return TRUE;
+	/* the HSI attributes are only included when asked for */
+	if ((priv->flags & FWUPD_INSTALL_FLAG_FORCE) == 0)
+		return TRUE;
+	return fu_util_add_security_attributes_json (priv, builder, error);
 }
 
+typedef gboolean (*FuUtilAddJsonFunc) (FuUtilPrivate *priv,
+				       JsonBuilder *builder,
+				       GError **error);
+
 static gboolean
-fu_util_get_updates (FuUtilPrivate *priv, gchar **values, GError **error)
+fu_util_print_json (FuUtilPrivate *priv,
+		    gchar **values,
+		    FuUtilAddJsonFunc func,
+		    GError **error)
 {
-	g_autofree gchar *data = NULL;
 	g_autoptr(JsonBuilder) builder = NULL;
-	g_autoptr(JsonGenerator) json_generator = NULL;
-	g_autoptr(JsonNode) json_root = NULL;
 
 	/* check args */
 	if (g_strv_length (values) != 0) {
@@ -205,73 +323,47 @@ fu_util_get_updates (FuUtilPrivate *priv, gchar **values, GError **error)
 		return FALSE;
 	}
 
+	/* each object has already been printed */
+	if (priv->json_lines)
+		return func (priv, NULL, error);
+
 	/* create header */
 	builder = json_builder_new ();
 	json_builder_begin_object (builder);
-	if (!fu_util_add_updates_json (priv, builder, error))
+	if (!func (priv, builder, error))
 		return FALSE;
 	json_builder_end_object (builder);
-
-	/* export as a string */
-	json_root = json_builder_get_root (builder);
-	json_generator = json_generator_new ();
-	json_generator_set_pretty (json_generator, TRUE);
-	json_generator_set_root (json_generator, json_root);
-	data = json_generator_to_data (json_generator, NULL);
-	if (data == NULL) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INTERNAL,
-				     "Failed to convert to JSON string");
-		return FALSE;
-	}
-
-	/* just print */
-	g_print ("%s\n", data);
-	return TRUE;
+	return fu_util_print_builder (builder, TRUE, error);
 }
 
 static gboolean
-fu_util_security (FuUtilPrivate *priv, gchar **values, GError **error)
+fu_util_get_devices (FuUtilPrivate *priv, gchar **values, GError **error)
 {
-	g_autofree gchar *data = NULL;
-	g_autoptr(JsonBuilder) builder = NULL;
-	g_autoptr(JsonGenerator) json_generator = NULL;
-	g_autoptr(JsonNode) json_root = NULL;
+	return fu_util_print_json (priv, values, fu_util_add_devices_json, error);
+}
 
-	/* check args */
-	if (g_strv_length (values) != 0) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_ARGS,
-				     "Invalid arguments");
-		return FALSE;
-	}
+static gboolean
+fu_util_get_updates (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	return fu_util_print_json (priv, values, fu_util_add_updates_json, error);
+}
 
-	/* create header */
-	builder = json_builder_new ();
-	json_builder_begin_object (builder);
-	if (!fu_util_add_security_attributes_json (priv, builder, error))
-		return FALSE;
-	json_builder_end_object (builder);
+static gboolean
+fu_util_get_history (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	return fu_util_print_json (priv, values, fu_util_add_history_json, error);
+}
 
-	/* export as a string */
-	json_root = json_builder_get_root (builder);
-	json_generator = json_generator_new ();
-	json_generator_set_pretty (json_generator, TRUE);
-	json_generator_set_root (json_generator, json_root);
-	data = json_generator_to_data (json_generator, NULL);
-	if (data == NULL) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INTERNAL,
-				     "Failed to convert to JSON string");
-		return FALSE;
-	}
+static gboolean
+fu_util_security (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	return fu_util_print_json (priv, values, fu_util_add_security_attributes_json, error);
+}
 
-	/* just print */
-	g_print ("%s\n", data);
-	return TRUE;
+static gboolean
+fu_util_get_report (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	return fu_util_print_json (priv, values, fu_util_add_report_json, error);
 }
 
 static void
@@ -312,7 +404,10 @@ main (int argc, char *argv[])
 {
 	gboolean ret;
 	gboolean force = FALSE;
+	gboolean json_lines = FALSE;
 	gboolean verbose = FALSE;
+	gint limit = 0;
+	gint offset = 0;
 	g_autoptr(FuUtilPrivate) priv = g_new0 (FuUtilPrivate, 1);
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GPtrArray) cmd_array = fu_util_cmd_array_new ();
@@ -324,6 +419,15 @@ main (int argc, char *argv[])
 		{ "force", '\0', 0, G_OPTION_ARG_NONE, &force,
 			/* TRANSLATORS: command line option */
 			_("Override warnings and force the action"), NULL },
+		{ "json-lines", '\0', 0, G_OPTION_ARG_NONE, &json_lines,
+			/* TRANSLATORS: command line option */
+			_("Print each object on its own line as soon as it is available"), NULL },
+		{ "limit", '\0', 0, G_OPTION_ARG_INT, &limit,
+			/* TRANSLATORS: command line option */
+			_("Only return this number of devices"), NULL },
+		{ "offset", '\0', 0, G_OPTION_ARG_INT, &offset,
+			/* TRANSLATORS: command line option */
+			_("Skip this number of devices"), NULL },
 		{ NULL}
 	};
 
@@ -355,6 +459,16 @@ main (int argc, char *argv[])
 			       /* TRANSLATORS: command description */
 			       _("Gets the list of updates for connected hardware"),
 			       fu_util_get_updates);
+	fu_util_cmd_array_add (cmd_array,
+			       "get-history", NULL,
+			       /* TRANSLATORS: command description */
+			       _("Show history of firmware updates"),
+			       fu_util_get_history);
+	fu_util_cmd_array_add (cmd_array,
+			       "get-report", NULL,
+			       /* TRANSLATORS: command description */
+			       _("Gets the host details, updates and security attributes at once"),
+			       fu_util_get_report);
 	fu_util_cmd_array_add (cmd_array,
 			       "security", NULL,
 			       /* TRANSLATORS: command description */
@@ -390,6 +504,16 @@ main (int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
+	/* paging */
+	if (limit < 0 || offset < 0) {
+		/* TRANSLATORS: the user passed a negative --limit or --offset */
+		g_print ("%s\n", _("The limit and offset must not be negative"));
+		return EXIT_FAILURE;
+	}
+	priv->json_lines = json_lines;
+	priv->limit = (guint) limit;
+	priv->offset = (guint) offset;
+
 	/* set verbose? */
 	if (verbose) {
 		g_setenv ("G_MESSAGES_DEBUG", "all", FALSE);
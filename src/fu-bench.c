@@ -0,0 +1,652 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuBench"
+
+#include "config.h"
+
+#include <json-glib/json-glib.h>
+#include <stdlib.h>
+#ifdef HAVE_MALLINFO
+#include <malloc.h>
+#endif
+#ifdef HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
+
+#include "fwupd-device-private.h"
+
+#include "fu-chunk.h"
+#include "fu-common.h"
+#include "fu-common-version.h"
+#include "fu-debug.h"
+#include "fu-device-list.h"
+#include "fu-device-private.h"
+#include "fu-dfu-firmware.h"
+#include "fu-engine.h"
+#include "fu-history.h"
+#include "fu-ihex-firmware.h"
+#include "fu-quirks.h"
+#include "fu-srec-firmware.h"
+
+/* each micro benchmark runs for at least this long, in s */
+#define FU_BENCH_MICRO_DURATION		0.25f
+
+/* the timer is only read after this many calls to keep the overhead low */
+#define FU_BENCH_MICRO_BATCH		16
+
+typedef struct {
+	FuEngine		*engine;
+	GPtrArray		*blobs;		/* of GBytes */
+	guint			 iterations;
+	JsonBuilder		*json;		/* nullable */
+} FuBenchPrivate;
+
+typedef void (*FuBenchMicroFunc)	(gpointer	 user_data,
+					 guint		 idx);
+
+typedef struct {
+	guint			 files;		/* number of blobs that parsed */
+	gsize			 size;		/* bytes parsed per iteration */
+	gsize			 size_written;	/* bytes written per iteration */
+	gdouble			 parse;		/* s */
+	gdouble			 write;		/* s */
+	gdouble			 reparse;	/* s */
+	gsize			 heap_max;	/* bytes */
+	gboolean		 write_supported;
+} FuBenchResult;
+
+static gsize
+fu_bench_get_heap_size (void)
+{
+#ifdef HAVE_MALLINFO
+	struct mallinfo mi = mallinfo ();
+	return (gsize) mi.uordblks;
+#else
+	return 0;
+#endif
+}
+
+static glong
+fu_bench_get_maxrss (void)
+{
+#ifdef HAVE_GETRUSAGE
+	struct rusage usage = { 0 };
+	if (getrusage (RUSAGE_SELF, &usage) != 0)
+		return -1;
+	return usage.ru_maxrss;
+#else
+	return -1;
+#endif
+}
+
+static gdouble
+fu_bench_mb_per_sec (gsize size, guint iterations, gdouble elapsed)
+{
+	if (elapsed <= 0.f)
+		return 0.f;
+	return ((gdouble) size * iterations) / (elapsed * 1024.f * 1024.f);
+}
+
+/* returns FALSE if the blob is not of this format, which is not an error */
+static gboolean
+fu_bench_blob (FuBenchPrivate *priv, GType gtype, GBytes *blob, FuBenchResult *result)
+{
+	gsize heap_start = fu_bench_get_heap_size ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* check it is this format before timing anything */
+	{
+		g_autoptr(FuFirmware) firmware = g_object_new (gtype, NULL);
+		if (!fu_firmware_parse (firmware, blob, FWUPD_INSTALL_FLAG_FORCE, &error)) {
+			g_debug ("ignoring: %s", error->message);
+			return FALSE;
+		}
+	}
+	result->files++;
+	result->size += g_bytes_get_size (blob);
+
+	for (guint i = 0; i < priv->iterations; i++) {
+		g_autoptr(FuFirmware) firmware = g_object_new (gtype, NULL);
+		g_autoptr(FuFirmware) firmware_new = g_object_new (gtype, NULL);
+		g_autoptr(GBytes) blob_new = NULL;
+		g_autoptr(GError) error_local = NULL;
+		gsize heap_now;
+
+		/* parse */
+		g_timer_reset (timer);
+		if (!fu_firmware_parse (firmware, blob, FWUPD_INSTALL_FLAG_FORCE, &error_local)) {
+			g_warning ("failed to parse on iteration %u: %s",
+				   i, error_local->message);
+			return TRUE;
+		}
+		result->parse += g_timer_elapsed (timer, NULL);
+		heap_now = fu_bench_get_heap_size ();
+		if (heap_now > heap_start)
+			result->heap_max = MAX (result->heap_max, heap_now - heap_start);
+
+		/* write, which not every format supports */
+		g_timer_reset (timer);
+		blob_new = fu_firmware_write (firmware, &error_local);
+		if (blob_new == NULL) {
+			g_debug ("cannot write: %s", error_local->message);
+			continue;
+		}
+		result->write += g_timer_elapsed (timer, NULL);
+		result->write_supported = TRUE;
+		if (i == 0)
+			result->size_written += g_bytes_get_size (blob_new);
+
+		/* parse what we wrote */
+		g_timer_reset (timer);
+		if (!fu_firmware_parse (firmware_new, blob_new,
+					FWUPD_INSTALL_FLAG_FORCE, &error_local)) {
+			g_warning ("failed to re-parse written firmware: %s",
+				   error_local->message);
+			continue;
+		}
+		result->reparse += g_timer_elapsed (timer, NULL);
+	}
+	return TRUE;
+}
+
+static void
+fu_bench_firmware_type (FuBenchPrivate *priv, const gchar *id)
+{
+	FuBenchResult result = { 0 };
+	GType gtype = fu_engine_get_firmware_gtype_by_id (priv->engine, id);
+
+	for (guint i = 0; i < priv->blobs->len; i++) {
+		GBytes *blob = g_ptr_array_index (priv->blobs, i);
+		fu_bench_blob (priv, gtype, blob, &result);
+	}
+	if (result.files == 0) {
+		g_print ("%-24s no matching files\n", id);
+		return;
+	}
+	g_print ("%-24s %5u %10.1f", id, result.files,
+		 fu_bench_mb_per_sec (result.size, priv->iterations, result.parse));
+	if (result.write_supported) {
+		g_print (" %10.1f %10.1f",
+			 fu_bench_mb_per_sec (result.size_written, priv->iterations, result.write),
+			 fu_bench_mb_per_sec (result.size_written, priv->iterations, result.reparse));
+	} else {
+		g_print (" %10s %10s", "-", "-");
+	}
+	g_print (" %10" G_GSIZE_FORMAT " %10li\n",
+		 result.heap_max / 1024, fu_bench_get_maxrss ());
+}
+
+static gboolean
+fu_bench_add_path (FuBenchPrivate *priv, const gchar *path, GError **error)
+{
+	GBytes *blob;
+
+	/* load everything in a corpus directory */
+	if (g_file_test (path, G_FILE_TEST_IS_DIR)) {
+		const gchar *fn;
+		g_autoptr(GDir) dir = g_dir_open (path, 0, error);
+		if (dir == NULL)
+			return FALSE;
+		while ((fn = g_dir_read_name (dir)) != NULL) {
+			g_autofree gchar *tmp = g_build_filename (path, fn, NULL);
+			if (!fu_bench_add_path (priv, tmp, error))
+				return FALSE;
+		}
+		return TRUE;
+	}
+	blob = fu_common_get_contents_mapped (path, error);
+	if (blob == NULL)
+		return FALSE;
+	g_ptr_array_add (priv->blobs, blob);
+	return TRUE;
+}
+
+static void
+fu_bench_micro_run (FuBenchPrivate *priv,
+		    const gchar *name,
+		    FuBenchMicroFunc func,
+		    gpointer user_data)
+{
+	guint iterations = 0;
+	gdouble elapsed;
+	gdouble ns_per_op;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	do {
+		for (guint i = 0; i < FU_BENCH_MICRO_BATCH; i++)
+			func (user_data, iterations++);
+		elapsed = g_timer_elapsed (timer, NULL);
+	} while (elapsed < FU_BENCH_MICRO_DURATION);
+	ns_per_op = (elapsed * 1e9) / iterations;
+
+	if (priv->json != NULL) {
+		json_builder_begin_object (priv->json);
+		json_builder_set_member_name (priv->json, "Name");
+		json_builder_add_string_value (priv->json, name);
+		json_builder_set_member_name (priv->json, "Iterations");
+		json_builder_add_int_value (priv->json, iterations);
+		json_builder_set_member_name (priv->json, "NsPerOp");
+		json_builder_add_double_value (priv->json, ns_per_op);
+		json_builder_end_object (priv->json);
+		return;
+	}
+	g_print ("%-40s %10u %14.1f\n", name, iterations, ns_per_op);
+}
+
+static void
+fu_bench_micro_vercmp_cb (gpointer user_data, guint idx)
+{
+	const gchar *versions[] = {
+		"1.2.3", "1.2.4", "1.02.3", "10.2.3", "1.2.3.4",
+		"1.2.3~rc1", "0.0.1", "5.6.7.8", NULL };
+	guint nr = G_N_ELEMENTS (versions) - 1;
+	fu_common_vercmp_full (versions[idx % nr],
+			       versions[(idx / nr) % nr],
+			       FWUPD_VERSION_FORMAT_UNKNOWN);
+}
+
+static void
+fu_bench_micro_quirks_cb (gpointer user_data, guint idx)
+{
+	FuQuirks *quirks = FU_QUIRKS (user_data);
+	g_autofree gchar *group = NULL;
+
+	/* a mix of hits and misses, which are both cached */
+	group = g_strdup_printf ("DeviceInstanceId=USB\\VID_%04X&PID_%04X",
+				 0x273f + (idx % 4), 0x1000 + (idx % 64));
+	fu_quirks_lookup_by_id (quirks, group, FU_QUIRKS_PLUGIN);
+}
+
+static void
+fu_bench_micro_device_list_id_cb (gpointer user_data, guint idx)
+{
+	GPtrArray *devices = (GPtrArray *) user_data;
+	FuDeviceList *device_list = g_ptr_array_index (devices, 0);
+	FuDevice *device = g_ptr_array_index (devices, 1 + (idx % (devices->len - 1)));
+	g_autoptr(FuDevice) device_tmp = NULL;
+	device_tmp = fu_device_list_get_by_id (device_list, fu_device_get_id (device), NULL);
+}
+
+static void
+fu_bench_micro_device_list_guid_cb (gpointer user_data, guint idx)
+{
+	GPtrArray *devices = (GPtrArray *) user_data;
+	FuDeviceList *device_list = g_ptr_array_index (devices, 0);
+	FuDevice *device = g_ptr_array_index (devices, 1 + (idx % (devices->len - 1)));
+	g_autoptr(FuDevice) device_tmp = NULL;
+	device_tmp = fu_device_list_get_by_guid (device_list, fu_device_get_guid_default (device), NULL);
+}
+
+static void
+fu_bench_micro_device_list (FuBenchPrivate *priv, guint nr_devices)
+{
+	g_autofree gchar *name_guid = g_strdup_printf ("device-list-get-by-guid:%u", nr_devices);
+	g_autofree gchar *name_id = g_strdup_printf ("device-list-get-by-id:%u", nr_devices);
+	g_autoptr(FuDeviceList) device_list = fu_device_list_new ();
+	g_autoptr(GPtrArray) devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+
+	/* the list is the first item so the callbacks only need one pointer */
+	g_ptr_array_add (devices, g_object_ref (device_list));
+	for (guint i = 0; i < nr_devices; i++) {
+		g_autoptr(FuDevice) device = fu_device_new ();
+		g_autofree gchar *id = g_strdup_printf ("bench-device-%u", i);
+		g_autofree gchar *instance_id = g_strdup_printf ("USB\\VID_FFFF&PID_%04X", i);
+		fu_device_set_id (device, id);
+		fu_device_add_instance_id (device, instance_id);
+		fu_device_convert_instance_ids (device);
+		fu_device_list_add (device_list, device);
+		g_ptr_array_add (devices, g_steal_pointer (&device));
+	}
+	fu_bench_micro_run (priv, name_id, fu_bench_micro_device_list_id_cb, devices);
+	fu_bench_micro_run (priv, name_guid, fu_bench_micro_device_list_guid_cb, devices);
+}
+
+static void
+fu_bench_micro_get_upgrades_cb (gpointer user_data, guint idx)
+{
+	FuBenchPrivate *priv = (FuBenchPrivate *) user_data;
+	g_autoptr(GPtrArray) releases = NULL;
+	releases = fu_engine_get_upgrades (priv->engine, "bench-upgrades", NULL);
+}
+
+static gboolean
+fu_bench_micro_get_upgrades (FuBenchPrivate *priv, GError **error)
+{
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(GString) xml = g_string_new ("<components>");
+	g_autoptr(XbBuilder) builder = xb_builder_new ();
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new ();
+	g_autoptr(XbSilo) silo = NULL;
+
+	/* lots of components, each with a few releases */
+	for (guint i = 0; i < 1000; i++) {
+		g_autofree gchar *instance_id = g_strdup_printf ("USB\\VID_FFFF&PID_%04X", i);
+		g_autofree gchar *guid = fwupd_guid_hash_string (instance_id);
+		g_string_append_printf (xml,
+					"<component type=\"firmware\">"
+					"<id>com.example.Bench%u.firmware</id>"
+					"<provides><firmware type=\"flashed\">%s</firmware></provides>"
+					"<releases>", i, guid);
+		for (guint j = 5; j > 0; j--) {
+			g_string_append_printf (xml,
+						"<release version=\"1.2.%u\">"
+						"<checksum target=\"content\" type=\"sha1\">%040x</checksum>"
+						"</release>", j, i * 10 + j);
+		}
+		g_string_append (xml, "</releases></component>");
+	}
+	g_string_append (xml, "</components>");
+	if (!xb_builder_source_load_xml (source, xml->str,
+					 XB_BUILDER_SOURCE_FLAG_NONE, error))
+		return FALSE;
+	xb_builder_import_source (builder, source);
+	silo = xb_builder_compile (builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, error);
+	if (silo == NULL)
+		return FALSE;
+	fu_engine_set_silo (priv->engine, silo);
+
+	/* a device in the middle of the metadata */
+	fu_device_set_id (device, "bench-upgrades");
+	fu_device_set_version_format (device, FWUPD_VERSION_FORMAT_TRIPLET);
+	fu_device_set_version (device, "1.2.1");
+	fu_device_add_instance_id (device, "USB\\VID_FFFF&PID_01F4");
+	fu_device_add_flag (device, FWUPD_DEVICE_FLAG_UPDATABLE);
+	fu_engine_add_device (priv->engine, device);
+	fu_bench_micro_run (priv, "engine-get-upgrades:1000",
+			    fu_bench_micro_get_upgrades_cb, priv);
+	return TRUE;
+}
+
+static void
+fu_bench_micro_device_to_variant_cb (gpointer user_data, guint idx)
+{
+	g_autoptr(GVariant) val = NULL;
+	val = g_variant_ref_sink (fwupd_device_to_variant (FWUPD_DEVICE (user_data)));
+}
+
+static void
+fu_bench_micro_history_add_cb (gpointer user_data, guint idx)
+{
+	GPtrArray *array = (GPtrArray *) user_data;
+	FuHistory *history = g_ptr_array_index (array, 0);
+	FuDevice *device = g_ptr_array_index (array, 1);
+	FwupdRelease *release = g_ptr_array_index (array, 2);
+	g_autoptr(GError) error = NULL;
+	if (!fu_history_add_device (history, device, release, &error))
+		g_warning ("failed to add device: %s", error->message);
+}
+
+static gboolean
+fu_bench_micro_history (FuBenchPrivate *priv, FuDevice *device, GError **error)
+{
+	g_autofree gchar *tmpdir = NULL;
+	g_autoptr(FuHistory) history = NULL;
+	g_autoptr(FwupdRelease) release = fwupd_release_new ();
+	g_autoptr(GPtrArray) array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+
+	/* use a throwaway database */
+	tmpdir = g_dir_make_tmp ("fwupd-bench-XXXXXX", error);
+	if (tmpdir == NULL)
+		return FALSE;
+	g_setenv ("STATE_DIRECTORY", tmpdir, TRUE);
+	history = fu_history_new ();
+	fwupd_release_set_version (release, "1.2.4");
+	fwupd_release_add_checksum (release, "abcdef");
+	g_ptr_array_add (array, g_object_ref (history));
+	g_ptr_array_add (array, g_object_ref (device));
+	g_ptr_array_add (array, g_object_ref (release));
+	fu_bench_micro_run (priv, "history-add-device",
+			    fu_bench_micro_history_add_cb, array);
+	g_unsetenv ("STATE_DIRECTORY");
+	g_clear_object (&history);
+	return fu_common_rmtree (tmpdir, error);
+}
+
+static void
+fu_bench_micro_chunk_array_cb (gpointer user_data, guint idx)
+{
+	GBytes *blob = (GBytes *) user_data;
+	g_autoptr(GPtrArray) chunks = NULL;
+	chunks = fu_chunk_array_new (g_bytes_get_data (blob, NULL),
+				     g_bytes_get_size (blob),
+				     0x0, 0x1000, 64);
+}
+
+static void
+fu_bench_micro_firmware_parse_cb (gpointer user_data, guint idx)
+{
+	FuFirmware *firmware = FU_FIRMWARE (user_data);
+	GBytes *blob = g_object_get_data (G_OBJECT (firmware), "fwupd::BenchBlob");
+	g_autoptr(FuFirmware) firmware_new = g_object_new (G_OBJECT_TYPE (firmware), NULL);
+	g_autoptr(GError) error = NULL;
+	if (!fu_firmware_parse (firmware_new, blob, FWUPD_INSTALL_FLAG_NONE, &error))
+		g_warning ("failed to parse: %s", error->message);
+}
+
+/* there is no SREC writer, so build the records directly */
+static GBytes *
+fu_bench_micro_srec_build (GBytes *blob)
+{
+	gsize sz = 0;
+	const guint8 *buf = g_bytes_get_data (blob, &sz);
+	GString *str = g_string_new ("S0030000FC\n");
+
+	for (gsize off = 0; off < sz; off += 32) {
+		guint8 csum;
+		guint8 len = MIN (sz - off, 32);
+		guint8 cnt = len + 5;
+		csum = cnt + (off >> 24) + ((off >> 16) & 0xff) + ((off >> 8) & 0xff) + (off & 0xff);
+		g_string_append_printf (str, "S3%02X%08X", cnt, (guint) off);
+		for (guint i = 0; i < len; i++) {
+			g_string_append_printf (str, "%02X", buf[off + i]);
+			csum += buf[off + i];
+		}
+		g_string_append_printf (str, "%02X\n", (guint) (guint8) ~csum);
+	}
+	g_string_append (str, "S70500000000FA\n");
+	sz = str->len;
+	return g_bytes_new_take (g_string_free (str, FALSE), sz);
+}
+
+static gboolean
+fu_bench_micro_firmware (FuBenchPrivate *priv, GBytes *blob, GError **error)
+{
+	struct {
+		const gchar *name;
+		FuFirmware *(*new_func) (void);
+	} formats[] = {
+		{ "firmware-parse:ihex",	fu_ihex_firmware_new },
+		{ "firmware-parse:srec",	fu_srec_firmware_new },
+		{ "firmware-parse:dfu",		fu_dfu_firmware_new },
+		{ NULL, NULL }
+	};
+
+	for (guint i = 0; formats[i].name != NULL; i++) {
+		g_autoptr(FuFirmware) firmware = formats[i].new_func ();
+		g_autoptr(GBytes) blob_fw = NULL;
+		if (g_strcmp0 (formats[i].name, "firmware-parse:srec") == 0) {
+			blob_fw = fu_bench_micro_srec_build (blob);
+		} else {
+			g_autoptr(FuFirmwareImage) img = fu_firmware_image_new (blob);
+			fu_firmware_add_image (firmware, img);
+			blob_fw = fu_firmware_write (firmware, error);
+			if (blob_fw == NULL)
+				return FALSE;
+		}
+		g_object_set_data_full (G_OBJECT (firmware), "fwupd::BenchBlob",
+					g_bytes_ref (blob_fw),
+					(GDestroyNotify) g_bytes_unref);
+		fu_bench_micro_run (priv, formats[i].name,
+				    fu_bench_micro_firmware_parse_cb, firmware);
+	}
+	return TRUE;
+}
+
+/* the hot paths of the daemon, using synthetic data */
+static gboolean
+fu_bench_micro (FuBenchPrivate *priv, GError **error)
+{
+	guint nr_devices[] = { 10, 100, 1000, 0 };
+	g_autofree guint8 *buf = g_malloc (0x10000);
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(FuQuirks) quirks = fu_quirks_new ();
+	g_autoptr(GBytes) blob = NULL;
+
+	/* a pattern that does not compress to nothing */
+	for (guint i = 0; i < 0x10000; i++)
+		buf[i] = (guint8) (i * 7 + (i >> 8));
+	blob = g_bytes_new_take (g_steal_pointer (&buf), 0x10000);
+
+	/* a typical device */
+	fu_device_set_id (device, "bench-device");
+	fu_device_set_name (device, "Bench Device");
+	fu_device_set_vendor (device, "Example");
+	fu_device_set_vendor_id (device, "USB:0xFFFF");
+	fu_device_set_version_format (device, FWUPD_VERSION_FORMAT_TRIPLET);
+	fu_device_set_version (device, "1.2.3");
+	fu_device_set_version_bootloader (device, "0.1.2");
+	fu_device_set_protocol (device, "com.example.bench");
+	fu_device_add_instance_id (device, "USB\\VID_FFFF&PID_0001");
+	fu_device_add_instance_id (device, "USB\\VID_FFFF&PID_0001&REV_0001");
+	fu_device_add_instance_id (device, "USB\\VID_FFFF");
+	fu_device_convert_instance_ids (device);
+	fu_device_add_flag (device, FWUPD_DEVICE_FLAG_UPDATABLE);
+	fu_device_add_flag (device, FWUPD_DEVICE_FLAG_REQUIRE_AC);
+	fu_device_add_checksum (device, "7f5ac34fc8a53bd3af9a3e5ee4d5c7babc1a8214");
+
+	if (priv->json == NULL)
+		g_print ("%-40s %10s %14s\n", "Name", "Iterations", "ns/op");
+	fu_bench_micro_run (priv, "vercmp", fu_bench_micro_vercmp_cb, NULL);
+	if (!fu_quirks_load (quirks, FU_QUIRKS_LOAD_FLAG_READONLY_FS, error))
+		return FALSE;
+	fu_bench_micro_run (priv, "quirks-lookup-by-id", fu_bench_micro_quirks_cb, quirks);
+	for (guint i = 0; nr_devices[i] != 0; i++)
+		fu_bench_micro_device_list (priv, nr_devices[i]);
+	fu_bench_micro_run (priv, "device-to-variant",
+			    fu_bench_micro_device_to_variant_cb, device);
+	fu_bench_micro_run (priv, "chunk-array-new:64KiB",
+			    fu_bench_micro_chunk_array_cb, blob);
+	if (!fu_bench_micro_firmware (priv, blob, error))
+		return FALSE;
+	if (!fu_bench_micro_history (priv, device, error))
+		return FALSE;
+	return fu_bench_micro_get_upgrades (priv, error);
+}
+
+int
+main (int argc, char *argv[])
+{
+	gboolean json = FALSE;
+	gboolean micro = FALSE;
+	guint iterations = 100;
+	g_autofree gchar *firmware_type = NULL;
+	g_autoptr(FuEngine) engine = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GOptionContext) context = NULL;
+	g_autoptr(GPtrArray) blobs = NULL;
+	g_autoptr(GPtrArray) firmware_types = NULL;
+	FuBenchPrivate priv = { 0 };
+	const GOptionEntry options[] = {
+		{ "iterations", 'n', 0, G_OPTION_ARG_INT, &iterations,
+			"Number of parse/write/re-parse cycles for each file", NULL },
+		{ "type", 't', 0, G_OPTION_ARG_STRING, &firmware_type,
+			"Only benchmark one firmware type, e.g. ihex", NULL },
+		{ "micro", '\0', 0, G_OPTION_ARG_NONE, &micro,
+			"Benchmark the daemon hot paths rather than a corpus", NULL },
+		{ "json", '\0', 0, G_OPTION_ARG_NONE, &json,
+			"Show the --micro results as JSON", NULL },
+		{ NULL}
+	};
+
+	context = g_option_context_new ("FILE|DIRECTORY...");
+	g_option_context_set_summary (context, "Firmware parser benchmark");
+	g_option_context_set_description (context,
+		"Each file is parsed, written and re-parsed using every firmware "
+		"type that accepts it. Throughput is shown in MB/s. The heap "
+		"column is the largest growth in allocated memory during a parse "
+		"in KiB. The RSS column is the process peak so far, so use --type "
+		"to measure the peak RSS of a single format. With --micro the "
+		"daemon hot paths are benchmarked using synthetic data instead, "
+		"showing the time taken per call in ns.");
+	g_option_context_add_main_entries (context, options, NULL);
+	g_option_context_add_group (context, fu_debug_get_option_group ());
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("Failed to parse arguments: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	if ((!micro && argc < 2) || iterations == 0) {
+		g_printerr ("corpus filename or directory required\n");
+		return EXIT_FAILURE;
+	}
+
+	/* load the corpus */
+	blobs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+	priv.blobs = blobs;
+	priv.iterations = iterations;
+	for (gint i = 1; i < argc; i++) {
+		if (!fu_bench_add_path (&priv, argv[i], &error)) {
+			g_printerr ("Failed to load %s: %s\n", argv[i], error->message);
+			return EXIT_FAILURE;
+		}
+	}
+
+	/* load plugins, which register the plugin firmware types */
+	engine = fu_engine_new (FU_APP_FLAGS_NO_IDLE_SOURCES);
+	if (!fu_engine_load (engine, FU_ENGINE_LOAD_FLAG_NO_ENUMERATE, &error)) {
+		g_printerr ("Failed to load engine: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	priv.engine = engine;
+
+	/* synthetic data, for tracking regressions */
+	if (micro) {
+		g_autoptr(JsonBuilder) builder = NULL;
+		if (json) {
+			builder = json_builder_new ();
+			json_builder_begin_object (builder);
+			json_builder_set_member_name (builder, "Benchmarks");
+			json_builder_begin_array (builder);
+			priv.json = builder;
+		}
+		if (!fu_bench_micro (&priv, &error)) {
+			g_printerr ("Failed to run benchmarks: %s\n", error->message);
+			return EXIT_FAILURE;
+		}
+		if (builder != NULL) {
+			g_autofree gchar *data = NULL;
+			g_autoptr(JsonGenerator) generator = json_generator_new ();
+			g_autoptr(JsonNode) root = NULL;
+			json_builder_end_array (builder);
+			json_builder_end_object (builder);
+			root = json_builder_get_root (builder);
+			json_generator_set_root (generator, root);
+			json_generator_set_pretty (generator, TRUE);
+			data = json_generator_to_data (generator, NULL);
+			g_print ("%s\n", data);
+		}
+		return EXIT_SUCCESS;
+	}
+
+	/* run each format over the whole corpus */
+	g_print ("%-24s %5s %10s %10s %10s %10s %10s\n",
+		 "Type", "Files", "Parse", "Write", "Reparse", "Heap/KiB", "RSS/KiB");
+	if (firmware_type != NULL) {
+		if (fu_engine_get_firmware_gtype_by_id (engine, firmware_type) == G_TYPE_INVALID) {
+			g_printerr ("Firmware type %s not supported\n", firmware_type);
+			return EXIT_FAILURE;
+		}
+		fu_bench_firmware_type (&priv, firmware_type);
+		return EXIT_SUCCESS;
+	}
+	firmware_types = fu_engine_get_firmware_gtype_ids (engine);
+	for (guint i = 0; i < firmware_types->len; i++) {
+		const gchar *id = g_ptr_array_index (firmware_types, i);
+		fu_bench_firmware_type (&priv, id);
+	}
+	return EXIT_SUCCESS;
+}
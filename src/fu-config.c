@@ -32,9 +32,12 @@ struct _FuConfig
 	GPtrArray		*approved_firmware;	/* (element-type utf-8) */
 	guint64			 archive_size_max;
 	guint			 idle_timeout;
+	guint			 signal_interval;	/* ms */
 	gchar			*config_file;
+	gchar			*metrics_file;		/* nullable */
 	gboolean		 update_motd;
 	gboolean		 enumerate_all_devices;
+	gboolean		 parallel_install;
 };
 
 G_DEFINE_TYPE (FuConfig, fu_config, G_TYPE_OBJECT)
@@ -51,13 +54,16 @@ fu_config_reload (FuConfig *self, GError **error)
 {
 	guint64 archive_size_max;
 	guint idle_timeout;
+	guint64 signal_interval;
 	g_auto(GStrv) approved_firmware = NULL;
 	g_auto(GStrv) devices = NULL;
 	g_auto(GStrv) plugins = NULL;
 	g_autofree gchar *domains = NULL;
+	g_autofree gchar *metrics_file = NULL;
 	g_autoptr(GKeyFile) keyfile = g_key_file_new ();
 	g_autoptr(GError) error_update_motd = NULL;
 	g_autoptr(GError) error_enumerate_all = NULL;
+	g_autoptr(GError) error_signal_interval = NULL;
 
 	g_debug ("loading config values from %s", self->config_file);
 	if (!g_key_file_load_from_file (keyfile, self->config_file,
@@ -122,6 +128,14 @@ fu_config_reload (FuConfig *self, GError **error)
 	if (idle_timeout > 0)
 		self->idle_timeout = idle_timeout;
 
+	/* get how long to coalesce D-Bus signals, where 0 is 'never' */
+	signal_interval = g_key_file_get_uint64 (keyfile,
+						 "fwupd",
+						 "SignalInterval",
+						 &error_signal_interval);
+	if (error_signal_interval == NULL)
+		self->signal_interval = MIN (signal_interval, G_MAXUINT);
+
 	/* get the domains to run in verbose */
 	domains = g_key_file_get_string (keyfile,
 					 "fwupd",
@@ -151,6 +165,21 @@ fu_config_reload (FuConfig *self, GError **error)
 		self->enumerate_all_devices = TRUE;
 	}
 
+	/* whether to update unrelated devices at the same time */
+	self->parallel_install = g_key_file_get_boolean (keyfile,
+							 "fwupd",
+							 "ParallelInstall",
+							 NULL);
+
+	/* where to export the daemon metrics, if anywhere */
+	g_clear_pointer (&self->metrics_file, g_free);
+	metrics_file = g_key_file_get_string (keyfile,
+					      "fwupd",
+					      "MetricsFile",
+					      NULL);
+	if (metrics_file != NULL && metrics_file[0] != '\0')
+		self->metrics_file = g_steal_pointer (&metrics_file);
+
 	return TRUE;
 }
 
@@ -227,6 +256,13 @@ fu_config_get_blacklist_devices (FuConfig *self)
 	return self->blacklist_devices;
 }
 
+guint
+fu_config_get_signal_interval (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), 0);
+	return self->signal_interval;
+}
+
 guint64
 fu_config_get_archive_size_max (FuConfig *self)
 {
@@ -262,6 +298,20 @@ fu_config_get_enumerate_all_devices (FuConfig *self)
 	return self->enumerate_all_devices;
 }
 
+gboolean
+fu_config_get_parallel_install (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), FALSE);
+	return self->parallel_install;
+}
+
+const gchar *
+fu_config_get_metrics_file (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), NULL);
+	return self->metrics_file;
+}
+
 static void
 fu_config_class_init (FuConfigClass *klass)
 {
@@ -279,6 +329,7 @@ static void
 fu_config_init (FuConfig *self)
 {
 	self->archive_size_max = 512 * 0x100000;
+	self->signal_interval = 50;
 	self->blacklist_devices = g_ptr_array_new_with_free_func (g_free);
 	self->blacklist_plugins = g_ptr_array_new_with_free_func (g_free);
 	self->approved_firmware = g_ptr_array_new_with_free_func (g_free);
@@ -295,6 +346,7 @@ fu_config_finalize (GObject *obj)
 	g_ptr_array_unref (self->blacklist_plugins);
 	g_ptr_array_unref (self->approved_firmware);
 	g_free (self->config_file);
+	g_free (self->metrics_file);
 
 	G_OBJECT_CLASS (fu_config_parent_class)->finalize (obj);
 }
@@ -11,8 +11,26 @@
 #include <unistd.h>
 #include <stdio.h>
 
+#include <fu-common.h>
 #include <fu-debug.h>
 
+/* the flight recorder keeps the last few messages of every level and domain,
+ * even when not verbose, so they can be added to the report on failure */
+#define FU_DEBUG_RECORDER_SIZE		256	/* messages */
+#define FU_DEBUG_RECORDER_MESSAGE_MAX	512	/* bytes */
+
+typedef struct {
+	gint64		 timestamp;	/* us since the epoch */
+	GLogLevelFlags	 log_level;
+	gchar		*log_domain;
+	gchar		*message;
+	guint		 repeated;
+} FuDebugRecord;
+
+static FuDebugRecord fu_debug_recorder[FU_DEBUG_RECORDER_SIZE];
+static guint fu_debug_recorder_idx = 0;	/* the next record to overwrite */
+static GMutex fu_debug_recorder_mutex;
+
 typedef struct {
 	GOptionGroup	*group;
 	gboolean	 verbose;
@@ -36,11 +54,8 @@ fu_debug_free (FuDebug *self)
 static gboolean
 fu_debug_filter_cb (FuDebug *self, const gchar *log_domain, GLogLevelFlags log_level)
 {
-	const gchar *domains = g_getenv ("FWUPD_VERBOSE");
-	g_auto(GStrv) domains_str = NULL;
-
 	/* include important things by default only */
-	if (domains == NULL) {
+	if (g_getenv ("FWUPD_VERBOSE") == NULL) {
 		if (log_level == G_LOG_LEVEL_INFO ||
 		    log_level == G_LOG_LEVEL_CRITICAL ||
 		    log_level == G_LOG_LEVEL_WARNING ||
@@ -50,13 +65,76 @@ fu_debug_filter_cb (FuDebug *self, const gchar *log_domain, GLogLevelFlags log_l
 		return FALSE;
 	}
 
-	/* everything */
-	if (g_strcmp0 (domains, "*") == 0)
-		return TRUE;
-
 	/* filter on domain */
-	domains_str = g_strsplit (domains, ",", -1);
-	return g_strv_contains ((const gchar * const *) domains_str, log_domain);
+	return fu_common_log_domain_enabled (log_domain);
+}
+
+static void
+fu_debug_recorder_add (const gchar *log_domain,
+		       GLogLevelFlags log_level,
+		       const gchar *message)
+{
+	FuDebugRecord *rec;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_debug_recorder_mutex);
+
+	/* just count messages repeated in a loop, e.g. when polling */
+	rec = &fu_debug_recorder[(fu_debug_recorder_idx + FU_DEBUG_RECORDER_SIZE - 1) %
+				 FU_DEBUG_RECORDER_SIZE];
+	if (rec->message != NULL &&
+	    rec->log_level == log_level &&
+	    g_strcmp0 (rec->log_domain, log_domain) == 0 &&
+	    g_strcmp0 (rec->message, message) == 0) {
+		rec->repeated++;
+		return;
+	}
+
+	/* overwrite the oldest */
+	rec = &fu_debug_recorder[fu_debug_recorder_idx];
+	g_free (rec->log_domain);
+	g_free (rec->message);
+	rec->timestamp = g_get_real_time ();
+	rec->log_level = log_level;
+	rec->log_domain = g_strdup (log_domain);
+	rec->message = g_strndup (message, FU_DEBUG_RECORDER_MESSAGE_MAX);
+	rec->repeated = 0;
+	fu_debug_recorder_idx = (fu_debug_recorder_idx + 1) % FU_DEBUG_RECORDER_SIZE;
+}
+
+/**
+ * fu_debug_get_recorder:
+ *
+ * Gets the recent log messages, including the ones that were not shown.
+ *
+ * Returns: the messages as text, or %NULL if nothing was recorded
+ **/
+gchar *
+fu_debug_get_recorder (void)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&fu_debug_recorder_mutex);
+	g_autoptr(GString) str = g_string_new (NULL);
+
+	for (guint i = 0; i < FU_DEBUG_RECORDER_SIZE; i++) {
+		FuDebugRecord *rec = &fu_debug_recorder[(fu_debug_recorder_idx + i) %
+							FU_DEBUG_RECORDER_SIZE];
+		g_autoptr(GDateTime) dt = NULL;
+		if (rec->message == NULL)
+			continue;
+		dt = g_date_time_new_from_unix_utc (rec->timestamp / G_USEC_PER_SEC);
+		g_string_append_printf (str, "%02i:%02i:%02i:%04i %-20s %s\n",
+					g_date_time_get_hour (dt),
+					g_date_time_get_minute (dt),
+					g_date_time_get_second (dt),
+					(gint) (rec->timestamp % G_USEC_PER_SEC) / 1000,
+					rec->log_domain != NULL ? rec->log_domain : "FIXME",
+					rec->message);
+		if (rec->repeated > 0) {
+			g_string_append_printf (str, "%-34s (repeated %u times)\n",
+						"", rec->repeated);
+		}
+	}
+	if (str->len == 0)
+		return NULL;
+	return g_string_free (g_steal_pointer (&str), FALSE);
 }
 
 static void
@@ -67,15 +145,19 @@ fu_debug_handler_cb (const gchar *log_domain,
 {
 	FuDebug *self = (FuDebug *) user_data;
 	g_autofree gchar *tmp = NULL;
-	g_autoptr(GDateTime) dt = g_date_time_new_now_utc ();
+	g_autoptr(GDateTime) dt = NULL;
 	g_autoptr(GString) domain = NULL;
 
+	/* always kept in case the update fails */
+	fu_debug_recorder_add (log_domain, log_level, message);
+
 	/* should ignore */
 	if (!fu_debug_filter_cb (self, log_domain, log_level))
 		return;
 
 	/* time header */
 	if (!self->no_timestamp) {
+		dt = g_date_time_new_now_utc ();
 		tmp = g_strdup_printf ("%02i:%02i:%02i:%04i",
 				       g_date_time_get_hour (dt),
 				       g_date_time_get_minute (dt),
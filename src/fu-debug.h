@@ -9,3 +9,4 @@
 #include <glib.h>
 
 GOptionGroup	*fu_debug_get_option_group	(void);
+gchar		*fu_debug_get_recorder		(void);
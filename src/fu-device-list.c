@@ -9,11 +9,11 @@
 #include "config.h"
 
 #include <glib-object.h>
-#include <string.h>
 
 #include "fu-device-list.h"
 #include "fu-device-private.h"
 #include "fu-mutex.h"
+#include "fu-timeline-private.h"
 
 #include "fwupd-error.h"
 
@@ -33,13 +33,25 @@
 
 static void fu_device_list_finalize	 (GObject *obj);
 
+typedef struct {
+	GHashTable		*guids;		/* utf8 : GPtrArray of FuDeviceItem */
+	GHashTable		*connections;	/* utf8 : GPtrArray of FuDeviceItem */
+	GPtrArray		*ids;		/* of FuDeviceIdEntry, sorted by ID */
+} FuDeviceIndex;
+
 struct _FuDeviceList
 {
 	GObject			 parent_instance;
 	GPtrArray		*devices;	/* of FuDeviceItem */
+	FuDeviceIndex		*index;		/* of FuDeviceItem->device */
+	FuDeviceIndex		*index_old;	/* of FuDeviceItem->device_old */
+	guint64			 seq;		/* insertion order of items */
 	GRWLock			 devices_mutex;
+	GPtrArray		*snapshot;	/* of FuDevice, never modified */
+	GMutex			 snapshot_mutex;
 	GMainLoop		*replug_loop;	/* block waiting for replug */
 	guint			 replug_id;	/* timeout the loop */
+	GPtrArray		*replug_items;	/* of FuDeviceItem, noref, nullable */
 };
 
 enum {
@@ -51,13 +63,28 @@ enum {
 
 static guint signals[SIGNAL_LAST] = { 0 };
 
+/* the values a device was indexed with, so it can be unindexed later */
+typedef struct {
+	GPtrArray		*ids;		/* of utf8 */
+	GPtrArray		*guids;		/* of utf8 */
+	gchar			*connection;
+} FuDeviceIndexKeys;
+
 typedef struct {
 	FuDevice		*device;
 	FuDevice		*device_old;
 	FuDeviceList		*self;		/* no ref */
 	guint			 remove_id;
+	guint64			 seq;
+	FuDeviceIndexKeys	*keys;
+	FuDeviceIndexKeys	*keys_old;
 } FuDeviceItem;
 
+typedef struct {
+	gchar			*id;
+	FuDeviceItem		*item;		/* no ref */
+} FuDeviceIdEntry;
+
 G_DEFINE_TYPE (FuDeviceList, fu_device_list, G_TYPE_OBJECT)
 
 static void
@@ -81,6 +108,275 @@ fu_device_list_emit_device_changed (FuDeviceList *self, FuDevice *device)
 	g_signal_emit (self, signals[SIGNAL_CHANGED], 0, device);
 }
 
+static void
+fu_device_id_entry_free (FuDeviceIdEntry *entry)
+{
+	g_free (entry->id);
+	g_free (entry);
+}
+
+static FuDeviceIndex *
+fu_device_index_new (void)
+{
+	FuDeviceIndex *index = g_new0 (FuDeviceIndex, 1);
+	index->guids = g_hash_table_new_full (g_str_hash, g_str_equal,
+					      g_free, (GDestroyNotify) g_ptr_array_unref);
+	index->connections = g_hash_table_new_full (g_str_hash, g_str_equal,
+						    g_free, (GDestroyNotify) g_ptr_array_unref);
+	index->ids = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_device_id_entry_free);
+	return index;
+}
+
+static void
+fu_device_index_free (FuDeviceIndex *index)
+{
+	g_hash_table_unref (index->guids);
+	g_hash_table_unref (index->connections);
+	g_ptr_array_unref (index->ids);
+	g_free (index);
+}
+
+/* returns the position of the first entry that sorts at or after @id */
+static guint
+fu_device_index_ids_lower_bound (FuDeviceIndex *index, const gchar *id)
+{
+	guint lo = 0;
+	guint hi = index->ids->len;
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+		FuDeviceIdEntry *entry = g_ptr_array_index (index->ids, mid);
+		if (g_strcmp0 (entry->id, id) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static void
+fu_device_index_table_add (GHashTable *table, const gchar *key, FuDeviceItem *item)
+{
+	GPtrArray *items = g_hash_table_lookup (table, key);
+	if (items == NULL) {
+		items = g_ptr_array_new ();
+		g_hash_table_insert (table, g_strdup (key), items);
+	}
+	g_ptr_array_add (items, item);
+}
+
+static void
+fu_device_index_table_remove (GHashTable *table, const gchar *key, FuDeviceItem *item)
+{
+	GPtrArray *items = g_hash_table_lookup (table, key);
+	if (items == NULL)
+		return;
+	g_ptr_array_remove (items, item);
+	if (items->len == 0)
+		g_hash_table_remove (table, key);
+}
+
+static gchar *
+fu_device_index_connection_key (const gchar *physical_id, const gchar *logical_id)
+{
+	if (physical_id == NULL)
+		return NULL;
+	if (logical_id == NULL)
+		return g_strdup (physical_id);
+	return g_strdup_printf ("%s\n%s", physical_id, logical_id);
+}
+
+static void
+fu_device_index_keys_free (FuDeviceIndexKeys *keys)
+{
+	g_ptr_array_unref (keys->ids);
+	g_ptr_array_unref (keys->guids);
+	g_free (keys->connection);
+	g_free (keys);
+}
+
+static FuDeviceIndexKeys *
+fu_device_index_keys_new (FuDevice *device)
+{
+	FuDeviceIndexKeys *keys = g_new0 (FuDeviceIndexKeys, 1);
+	GPtrArray *guids = fu_device_get_guids (device);
+	const gchar *ids[] = {
+		fu_device_get_id (device),
+		fu_device_get_equivalent_id (device),
+		NULL };
+
+	keys->ids = g_ptr_array_new_with_free_func (g_free);
+	for (guint i = 0; ids[i] != NULL; i++)
+		g_ptr_array_add (keys->ids, g_strdup (ids[i]));
+	keys->guids = g_ptr_array_new_with_free_func (g_free);
+	for (guint i = 0; i < guids->len; i++) {
+		const gchar *guid = g_ptr_array_index (guids, i);
+		g_ptr_array_add (keys->guids, g_strdup (guid));
+	}
+	keys->connection = fu_device_index_connection_key (fu_device_get_physical_id (device),
+							   fu_device_get_logical_id (device));
+	return keys;
+}
+
+static void
+fu_device_index_add (FuDeviceIndex *index, FuDeviceItem *item, FuDeviceIndexKeys *keys)
+{
+	for (guint i = 0; i < keys->ids->len; i++) {
+		const gchar *id = g_ptr_array_index (keys->ids, i);
+		FuDeviceIdEntry *entry = g_new0 (FuDeviceIdEntry, 1);
+		entry->id = g_strdup (id);
+		entry->item = item;
+		g_ptr_array_insert (index->ids,
+				    fu_device_index_ids_lower_bound (index, id),
+				    entry);
+	}
+	for (guint i = 0; i < keys->guids->len; i++) {
+		const gchar *guid = g_ptr_array_index (keys->guids, i);
+		fu_device_index_table_add (index->guids, guid, item);
+	}
+	if (keys->connection != NULL)
+		fu_device_index_table_add (index->connections, keys->connection, item);
+}
+
+static void
+fu_device_index_remove (FuDeviceIndex *index, FuDeviceItem *item, FuDeviceIndexKeys *keys)
+{
+	for (guint i = 0; i < keys->ids->len; i++) {
+		const gchar *id = g_ptr_array_index (keys->ids, i);
+		for (guint j = fu_device_index_ids_lower_bound (index, id);
+		     j < index->ids->len; j++) {
+			FuDeviceIdEntry *entry = g_ptr_array_index (index->ids, j);
+			if (g_strcmp0 (entry->id, id) != 0)
+				break;
+			if (entry->item == item) {
+				g_ptr_array_remove_index (index->ids, j);
+				break;
+			}
+		}
+	}
+	for (guint i = 0; i < keys->guids->len; i++) {
+		const gchar *guid = g_ptr_array_index (keys->guids, i);
+		fu_device_index_table_remove (index->guids, guid, item);
+	}
+	if (keys->connection != NULL)
+		fu_device_index_table_remove (index->connections, keys->connection, item);
+}
+
+/* the lowest sequence number is the item added to the list first */
+static FuDeviceItem *
+fu_device_index_items_first (GPtrArray *items, FuDeviceItem *item_best, gboolean removed_only)
+{
+	if (items == NULL)
+		return item_best;
+	for (guint i = 0; i < items->len; i++) {
+		FuDeviceItem *item = g_ptr_array_index (items, i);
+		if (removed_only && item->remove_id == 0)
+			continue;
+		if (item_best == NULL || item->seq < item_best->seq)
+			item_best = item;
+	}
+	return item_best;
+}
+
+/* must be called with the writer lock held */
+static void
+fu_device_list_item_unindex (FuDeviceList *self, FuDeviceItem *item)
+{
+	if (item->keys != NULL) {
+		fu_device_index_remove (self->index, item, item->keys);
+		g_clear_pointer (&item->keys, fu_device_index_keys_free);
+	}
+	if (item->keys_old != NULL) {
+		fu_device_index_remove (self->index_old, item, item->keys_old);
+		g_clear_pointer (&item->keys_old, fu_device_index_keys_free);
+	}
+}
+
+/* must be called with the writer lock held */
+static void
+fu_device_list_item_reindex (FuDeviceList *self, FuDeviceItem *item)
+{
+	fu_device_list_item_unindex (self, item);
+	if (item->device != NULL) {
+		item->keys = fu_device_index_keys_new (item->device);
+		fu_device_index_add (self->index, item, item->keys);
+	}
+	if (item->device_old != NULL) {
+		item->keys_old = fu_device_index_keys_new (item->device_old);
+		fu_device_index_add (self->index_old, item, item->keys_old);
+	}
+}
+
+/* plugins are allowed to add GUIDs after the device has been added */
+static gboolean
+fu_device_list_item_is_stale (FuDeviceItem *item)
+{
+	if (item->keys != NULL &&
+	    fu_device_get_guids (item->device)->len != item->keys->guids->len)
+		return TRUE;
+	if (item->keys_old != NULL &&
+	    fu_device_get_guids (item->device_old)->len != item->keys_old->guids->len)
+		return TRUE;
+	return FALSE;
+}
+
+static void
+fu_device_list_ensure_index (FuDeviceList *self)
+{
+	gboolean stale = FALSE;
+
+	g_rw_lock_reader_lock (&self->devices_mutex);
+	for (guint i = 0; i < self->devices->len; i++) {
+		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
+		if (fu_device_list_item_is_stale (item)) {
+			stale = TRUE;
+			break;
+		}
+	}
+	g_rw_lock_reader_unlock (&self->devices_mutex);
+	if (!stale)
+		return;
+
+	/* the list may have changed without the lock held */
+	g_rw_lock_writer_lock (&self->devices_mutex);
+	for (guint i = 0; i < self->devices->len; i++) {
+		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
+		if (fu_device_list_item_is_stale (item))
+			fu_device_list_item_reindex (self, item);
+	}
+	g_rw_lock_writer_unlock (&self->devices_mutex);
+}
+
+static void
+fu_device_list_item_notify_cb (FuDevice *device, GParamSpec *pspec, gpointer user_data)
+{
+	FuDeviceItem *item = (FuDeviceItem *) user_data;
+	FuDeviceList *self = FU_DEVICE_LIST (item->self);
+
+	/* the physical or logical ID changed */
+	g_rw_lock_writer_lock (&self->devices_mutex);
+	fu_device_list_item_reindex (self, item);
+	g_rw_lock_writer_unlock (&self->devices_mutex);
+}
+
+/* must be called with the writer lock held */
+static void
+fu_device_list_invalidate_snapshot (FuDeviceList *self)
+{
+	g_mutex_lock (&self->snapshot_mutex);
+	g_clear_pointer (&self->snapshot, g_ptr_array_unref);
+	g_mutex_unlock (&self->snapshot_mutex);
+}
+
+static void
+fu_device_list_remove_item (FuDeviceList *self, FuDeviceItem *item)
+{
+	g_rw_lock_writer_lock (&self->devices_mutex);
+	fu_device_list_item_unindex (self, item);
+	g_ptr_array_remove (self->devices, item);
+	fu_device_list_invalidate_snapshot (self);
+	g_rw_lock_writer_unlock (&self->devices_mutex);
+}
+
 /**
  * fu_device_list_get_all:
  * @self: A #FuDeviceList
@@ -115,6 +411,50 @@ fu_device_list_get_all (FuDeviceList *self)
 	return devices;
 }
 
+/**
+ * fu_device_list_get_snapshot:
+ * @self: A #FuDeviceList
+ *
+ * Returns the active devices as they were after the last add, remove or
+ * replug. The array is shared between all callers and is replaced rather than
+ * changed, so it can be iterated without holding any lock.
+ *
+ * Returns: (transfer container) (element-type FuDevice): the devices, which
+ * must not be modified
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fu_device_list_get_snapshot (FuDeviceList *self)
+{
+	GPtrArray *snapshot = NULL;
+
+	g_return_val_if_fail (FU_IS_DEVICE_LIST (self), NULL);
+
+	/* does not wait for any writer */
+	g_mutex_lock (&self->snapshot_mutex);
+	if (self->snapshot != NULL)
+		snapshot = g_ptr_array_ref (self->snapshot);
+	g_mutex_unlock (&self->snapshot_mutex);
+	if (snapshot != NULL)
+		return snapshot;
+
+	/* publish while holding the reader lock so a writer cannot invalidate
+	 * the list between copying and swapping it in */
+	g_rw_lock_reader_lock (&self->devices_mutex);
+	snapshot = g_ptr_array_new_full (self->devices->len, (GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < self->devices->len; i++) {
+		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
+		g_ptr_array_add (snapshot, g_object_ref (item->device));
+	}
+	g_mutex_lock (&self->snapshot_mutex);
+	if (self->snapshot == NULL)
+		self->snapshot = g_ptr_array_ref (snapshot);
+	g_mutex_unlock (&self->snapshot_mutex);
+	g_rw_lock_reader_unlock (&self->devices_mutex);
+	return snapshot;
+}
+
 /**
  * fu_device_list_get_active:
  * @self: A #FuDeviceList
@@ -131,14 +471,15 @@ GPtrArray *
 fu_device_list_get_active (FuDeviceList *self)
 {
 	GPtrArray *devices;
+	g_autoptr(GPtrArray) snapshot = NULL;
+
 	g_return_val_if_fail (FU_IS_DEVICE_LIST (self), NULL);
-	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	g_rw_lock_reader_lock (&self->devices_mutex);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
-		g_ptr_array_add (devices, g_object_ref (item->device));
-	}
-	g_rw_lock_reader_unlock (&self->devices_mutex);
+
+	/* the caller is allowed to modify this */
+	snapshot = fu_device_list_get_snapshot (self);
+	devices = g_ptr_array_new_full (snapshot->len, (GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < snapshot->len; i++)
+		g_ptr_array_add (devices, g_object_ref (g_ptr_array_index (snapshot, i)));
 	return devices;
 }
 
@@ -163,21 +504,25 @@ fu_device_list_find_by_device (FuDeviceList *self, FuDevice *device)
 static FuDeviceItem *
 fu_device_list_find_by_guid (FuDeviceList *self, const gchar *guid)
 {
-	g_autoptr(GRWLockReaderLocker) locker = g_rw_lock_reader_locker_new (&self->devices_mutex);
-	g_return_val_if_fail (locker != NULL, NULL);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
-		if (fu_device_has_guid (item->device, guid))
-			return item;
-	}
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
-		if (item->device_old == NULL)
-			continue;
-		if (fu_device_has_guid (item->device_old, guid))
-			return item;
+	FuDeviceItem *item;
+	g_autofree gchar *guid_hash = NULL;
+	g_autoptr(GRWLockReaderLocker) locker = NULL;
+
+	/* make valid */
+	if (!fwupd_guid_is_valid (guid)) {
+		guid_hash = fwupd_guid_hash_string (guid);
+		guid = guid_hash;
 	}
-	return NULL;
+
+	fu_device_list_ensure_index (self);
+	locker = g_rw_lock_reader_locker_new (&self->devices_mutex);
+	g_return_val_if_fail (locker != NULL, NULL);
+	item = fu_device_index_items_first (g_hash_table_lookup (self->index->guids, guid),
+					    NULL, FALSE);
+	if (item != NULL)
+		return item;
+	return fu_device_index_items_first (g_hash_table_lookup (self->index_old->guids, guid),
+					    NULL, FALSE);
 }
 
 static FuDeviceItem *
@@ -185,28 +530,40 @@ fu_device_list_find_by_connection (FuDeviceList *self,
 				   const gchar *physical_id,
 				   const gchar *logical_id)
 {
+	FuDeviceItem *item;
+	g_autofree gchar *key = NULL;
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 	if (physical_id == NULL)
 		return NULL;
+	key = fu_device_index_connection_key (physical_id, logical_id);
 	locker = g_rw_lock_reader_locker_new (&self->devices_mutex);
 	g_return_val_if_fail (locker != NULL, NULL);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item_tmp = g_ptr_array_index (self->devices, i);
-		FuDevice *device = item_tmp->device;
-		if (device != NULL &&
-		    g_strcmp0 (fu_device_get_physical_id (device), physical_id) == 0 &&
-		    g_strcmp0 (fu_device_get_logical_id (device), logical_id) == 0)
-			return item_tmp;
-	}
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item_tmp = g_ptr_array_index (self->devices, i);
-		FuDevice *device = item_tmp->device_old;
-		if (device != NULL &&
-		    g_strcmp0 (fu_device_get_physical_id (device), physical_id) == 0 &&
-		    g_strcmp0 (fu_device_get_logical_id (device), logical_id) == 0)
-			return item_tmp;
+	item = fu_device_index_items_first (g_hash_table_lookup (self->index->connections, key),
+					    NULL, FALSE);
+	if (item != NULL)
+		return item;
+	return fu_device_index_items_first (g_hash_table_lookup (self->index_old->connections, key),
+					    NULL, FALSE);
+}
+
+/* the last item added wins, as with the abbreviated hash semantics of git */
+static FuDeviceItem *
+fu_device_index_find_by_id (FuDeviceIndex *index,
+			    const gchar *device_id,
+			    gboolean *multiple_matches)
+{
+	FuDeviceItem *item = NULL;
+	for (guint i = fu_device_index_ids_lower_bound (index, device_id);
+	     i < index->ids->len; i++) {
+		FuDeviceIdEntry *entry = g_ptr_array_index (index->ids, i);
+		if (!g_str_has_prefix (entry->id, device_id))
+			break;
+		if (item != NULL && multiple_matches != NULL)
+			*multiple_matches = TRUE;
+		if (item == NULL || entry->item->seq > item->seq)
+			item = entry->item;
 	}
-	return NULL;
+	return item;
 }
 
 static FuDeviceItem *
@@ -214,8 +571,8 @@ fu_device_list_find_by_id (FuDeviceList *self,
 			   const gchar *device_id,
 			   gboolean *multiple_matches)
 {
-	FuDeviceItem *item = NULL;
-	gsize device_id_len;
+	FuDeviceItem *item;
+	g_autoptr(GRWLockReaderLocker) locker = NULL;
 
 	/* sanity check */
 	if (device_id == NULL) {
@@ -224,45 +581,14 @@ fu_device_list_find_by_id (FuDeviceList *self,
 	}
 
 	/* support abbreviated hashes */
-	device_id_len = strlen (device_id);
-	g_rw_lock_reader_lock (&self->devices_mutex);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item_tmp = g_ptr_array_index (self->devices, i);
-		const gchar *ids[] = {
-			fu_device_get_id (item_tmp->device),
-			fu_device_get_equivalent_id (item_tmp->device),
-			NULL };
-		for (guint j = 0; ids[j] != NULL; j++) {
-			if (strncmp (ids[j], device_id, device_id_len) == 0) {
-				if (item != NULL && multiple_matches != NULL)
-					*multiple_matches = TRUE;
-				item = item_tmp;
-			}
-		}
-	}
-	g_rw_lock_reader_unlock (&self->devices_mutex);
+	locker = g_rw_lock_reader_locker_new (&self->devices_mutex);
+	g_return_val_if_fail (locker != NULL, NULL);
+	item = fu_device_index_find_by_id (self->index, device_id, multiple_matches);
 	if (item != NULL)
 		return item;
 
 	/* only search old devices if we didn't find the active device */
-	g_rw_lock_reader_lock (&self->devices_mutex);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item_tmp = g_ptr_array_index (self->devices, i);
-		const gchar *ids[3] = { NULL };
-		if (item_tmp->device_old == NULL)
-			continue;
-		ids[0] = fu_device_get_id (item_tmp->device_old);
-		ids[1] = fu_device_get_equivalent_id (item_tmp->device_old);
-		for (guint j = 0; ids[j] != NULL; j++) {
-			if (strncmp (ids[j], device_id, device_id_len) == 0) {
-				if (item != NULL && multiple_matches != NULL)
-					*multiple_matches = TRUE;
-				item = item_tmp;
-			}
-		}
-	}
-	g_rw_lock_reader_unlock (&self->devices_mutex);
-	return item;
+	return fu_device_index_find_by_id (self->index_old, device_id, multiple_matches);
 }
 
 /**
@@ -287,60 +613,46 @@ fu_device_list_get_old (FuDeviceList *self, FuDevice *device)
 	return g_object_ref (item->device_old);
 }
 
+static FuDeviceItem *
+fu_device_index_find_by_guids (FuDeviceIndex *index, GPtrArray *guids, gboolean removed_only)
+{
+	FuDeviceItem *item = NULL;
+	for (guint j = 0; j < guids->len; j++) {
+		const gchar *guid = g_ptr_array_index (guids, j);
+		item = fu_device_index_items_first (g_hash_table_lookup (index->guids, guid),
+						    item, removed_only);
+	}
+	return item;
+}
+
 static FuDeviceItem *
 fu_device_list_get_by_guids (FuDeviceList *self, GPtrArray *guids)
 {
-	g_autoptr(GRWLockReaderLocker) locker = g_rw_lock_reader_locker_new (&self->devices_mutex);
+	FuDeviceItem *item;
+	g_autoptr(GRWLockReaderLocker) locker = NULL;
+
+	fu_device_list_ensure_index (self);
+	locker = g_rw_lock_reader_locker_new (&self->devices_mutex);
 	g_return_val_if_fail (locker != NULL, NULL);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
-		for (guint j = 0; j < guids->len; j++) {
-			const gchar *guid = g_ptr_array_index (guids, j);
-			if (fu_device_has_guid (item->device, guid))
-				return item;
-		}
-	}
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
-		if (item->device_old == NULL)
-			continue;
-		for (guint j = 0; j < guids->len; j++) {
-			const gchar *guid = g_ptr_array_index (guids, j);
-			if (fu_device_has_guid (item->device_old, guid))
-				return item;
-		}
-	}
-	return NULL;
+	item = fu_device_index_find_by_guids (self->index, guids, FALSE);
+	if (item != NULL)
+		return item;
+	return fu_device_index_find_by_guids (self->index_old, guids, FALSE);
 }
 
 static FuDeviceItem *
 fu_device_list_get_by_guids_removed (FuDeviceList *self, GPtrArray *guids)
 {
-	g_autoptr(GRWLockReaderLocker) locker = g_rw_lock_reader_locker_new (&self->devices_mutex);
+	FuDeviceItem *item;
+	g_autoptr(GRWLockReaderLocker) locker = NULL;
+
+	fu_device_list_ensure_index (self);
+	locker = g_rw_lock_reader_locker_new (&self->devices_mutex);
 	g_return_val_if_fail (locker != NULL, NULL);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
-		if (item->remove_id == 0)
-			continue;
-		for (guint j = 0; j < guids->len; j++) {
-			const gchar *guid = g_ptr_array_index (guids, j);
-			if (fu_device_has_guid (item->device, guid))
-				return item;
-		}
-	}
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
-		if (item->device_old == NULL)
-			continue;
-		if (item->remove_id == 0)
-			continue;
-		for (guint j = 0; j < guids->len; j++) {
-			const gchar *guid = g_ptr_array_index (guids, j);
-			if (fu_device_has_guid (item->device_old, guid))
-				return item;
-		}
-	}
-	return NULL;
+	item = fu_device_index_find_by_guids (self->index, guids, TRUE);
+	if (item != NULL)
+		return item;
+	return fu_device_index_find_by_guids (self->index_old, guids, TRUE);
 }
 
 static gboolean
@@ -365,17 +677,13 @@ fu_device_list_device_delayed_remove_cb (gpointer user_data)
 			continue;
 		}
 		fu_device_list_emit_device_removed (self, child);
-		g_rw_lock_writer_lock (&self->devices_mutex);
-		g_ptr_array_remove (self->devices, child_item);
-		g_rw_lock_writer_unlock (&self->devices_mutex);
+		fu_device_list_remove_item (self, child_item);
 	}
 
 	/* just remove now */
 	g_debug ("doing delayed removal");
 	fu_device_list_emit_device_removed (self, item->device);
-	g_rw_lock_writer_lock (&self->devices_mutex);
-	g_ptr_array_remove (self->devices, item);
-	g_rw_lock_writer_unlock (&self->devices_mutex);
+	fu_device_list_remove_item (self, item);
 	return G_SOURCE_REMOVE;
 }
 
@@ -451,16 +759,12 @@ fu_device_list_remove (FuDeviceList *self, FuDevice *device)
 			continue;
 		}
 		fu_device_list_emit_device_removed (self, child);
-		g_rw_lock_writer_lock (&self->devices_mutex);
-		g_ptr_array_remove (self->devices, child_item);
-		g_rw_lock_writer_unlock (&self->devices_mutex);
+		fu_device_list_remove_item (self, child_item);
 	}
 
 	/* remove right now */
 	fu_device_list_emit_device_removed (self, item->device);
-	g_rw_lock_writer_lock (&self->devices_mutex);
-	g_ptr_array_remove (self->devices, item);
-	g_rw_lock_writer_unlock (&self->devices_mutex);
+	fu_device_list_remove_item (self, item);
 }
 
 static void
@@ -491,9 +795,7 @@ fu_device_list_item_finalized_cb (gpointer data, GObject *where_the_object_was)
 	g_critical ("FuDevice %p was finalized without being removed from "
 		    "FuDeviceList, removing item!",
 		    where_the_object_was);
-	g_rw_lock_writer_lock (&self->devices_mutex);
-	g_ptr_array_remove (self->devices, item);
-	g_rw_lock_writer_unlock (&self->devices_mutex);
+	fu_device_list_remove_item (self, item);
 }
 
 /* this should never be required, and yet here we are */
@@ -501,6 +803,7 @@ static void
 fu_device_list_item_set_device (FuDeviceItem *item, FuDevice *device)
 {
 	if (item->device != NULL) {
+		g_signal_handlers_disconnect_by_data (item->device, item);
 		g_object_weak_unref (G_OBJECT (item->device),
 				     fu_device_list_item_finalized_cb,
 				     item);
@@ -509,6 +812,12 @@ fu_device_list_item_set_device (FuDeviceItem *item, FuDevice *device)
 		g_object_weak_ref (G_OBJECT (device),
 				   fu_device_list_item_finalized_cb,
 				   item);
+		g_signal_connect (device, "notify::physical-id",
+				  G_CALLBACK (fu_device_list_item_notify_cb),
+				  item);
+		g_signal_connect (device, "notify::logical-id",
+				  G_CALLBACK (fu_device_list_item_notify_cb),
+				  item);
 	}
 	g_set_object (&item->device, device);
 }
@@ -574,15 +883,32 @@ fu_device_list_replace (FuDeviceList *self, FuDeviceItem *item, FuDevice *device
 	}
 
 	/* assign the new device */
+	g_rw_lock_writer_lock (&self->devices_mutex);
 	g_set_object (&item->device_old, item->device);
 	fu_device_list_item_set_device (item, device);
+	fu_device_list_item_reindex (self, item);
+	fu_device_list_invalidate_snapshot (self);
+	g_rw_lock_writer_unlock (&self->devices_mutex);
 	fu_device_list_emit_device_changed (self, device);
 
 	/* we were waiting for this... */
 	if (fu_device_has_flag (item->device_old, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG) &&
 	    g_main_loop_is_running (self->replug_loop)) {
-		g_debug ("quitting replug loop");
 		fu_device_remove_flag (item->device_old, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG);
+
+		/* waiting for more than one device, so keep going until all are back */
+		if (self->replug_items != NULL) {
+			for (guint i = 0; i < self->replug_items->len; i++) {
+				FuDeviceItem *item_tmp = g_ptr_array_index (self->replug_items, i);
+				if (fu_device_has_flag (item_tmp->device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG)) {
+					g_debug ("%s replugged, still waiting for %s",
+						 fu_device_get_id (device),
+						 fu_device_get_id (item_tmp->device));
+					return;
+				}
+			}
+		}
+		g_debug ("quitting replug loop");
 		g_main_loop_quit (self->replug_loop);
 	}
 }
@@ -705,7 +1031,10 @@ fu_device_list_add (FuDeviceList *self, FuDevice *device)
 	item->self = self; /* no ref */
 	fu_device_list_item_set_device (item, device);
 	g_rw_lock_writer_lock (&self->devices_mutex);
+	item->seq = self->seq++;
 	g_ptr_array_add (self->devices, item);
+	fu_device_list_item_reindex (self, item);
+	fu_device_list_invalidate_snapshot (self);
 	g_rw_lock_writer_unlock (&self->devices_mutex);
 	fu_device_list_emit_device_added (self, device);
 }
@@ -754,6 +1083,26 @@ fu_device_list_replug_cb (gpointer user_data)
 	return FALSE;
 }
 
+static guint
+fu_device_list_get_replug_delay (FuDevice *device)
+{
+	guint remove_delay = fu_device_get_remove_delay (device);
+
+	/* plugin did not specify */
+	if (remove_delay == 0) {
+		remove_delay = FU_DEVICE_REMOVE_DELAY_RE_ENUMERATE;
+		g_warning ("plugin %s did not specify a remove delay for %s, "
+			   "so guessing we should wait %ums for replug",
+			   fu_device_get_plugin (device),
+			   fu_device_get_id (device),
+			   remove_delay);
+	} else {
+		g_debug ("waiting %ums for %s replug",
+			 remove_delay, fu_device_get_id (device));
+	}
+	return remove_delay;
+}
+
 /**
  * fu_device_list_wait_for_replug:
  * @self: A #FuDeviceList
@@ -773,6 +1122,7 @@ gboolean
 fu_device_list_wait_for_replug (FuDeviceList *self, FuDevice *device, GError **error)
 {
 	FuDeviceItem *item;
+	gint64 start;
 	guint remove_delay;
 
 	g_return_val_if_fail (FU_IS_DEVICE_LIST (self), FALSE);
@@ -803,22 +1153,12 @@ fu_device_list_wait_for_replug (FuDeviceList *self, FuDevice *device, GError **e
 		}
 	}
 
-	/* plugin did not specify */
-	remove_delay = fu_device_get_remove_delay (device);
-	if (remove_delay == 0) {
-		remove_delay = FU_DEVICE_REMOVE_DELAY_RE_ENUMERATE;
-		g_warning ("plugin %s did not specify a remove delay for %s, "
-			   "so guessing we should wait %ums for replug",
-			   fu_device_get_plugin (device),
-			   fu_device_get_id (device),
-			   remove_delay);
-	} else {
-		g_debug ("waiting %ums for replug", remove_delay);
-	}
-
 	/* time to unplug and then re-plug */
+	remove_delay = fu_device_list_get_replug_delay (device);
+	start = fu_timeline_begin ();
 	self->replug_id = g_timeout_add (remove_delay, fu_device_list_replug_cb, self);
 	g_main_loop_run (self->replug_loop);
+	fu_timeline_add ("device-list", "wait-for-replug", fu_device_get_id (device), start);
 
 	/* cancel timeout if still pending */
 	if (self->replug_id != 0) {
@@ -852,6 +1192,97 @@ fu_device_list_wait_for_replug (FuDeviceList *self, FuDevice *device, GError **e
 	return TRUE;
 }
 
+/**
+ * fu_device_list_wait_for_replug_all:
+ * @self: A #FuDeviceList
+ * @devices: (element-type FuDevice): devices, some of which may be waiting for replug
+ * @error: A #GError, or %NULL
+ *
+ * Waits for all the devices in @devices with the %FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG
+ * flag to be removed and re-added to the device list, for example when a
+ * dock is reset and all the child devices re-enumerate at the same time.
+ *
+ * The devices are waited for at the same time, using the longest remove
+ * delay of any of them rather than the sum of all of them.
+ *
+ * Returns: %TRUE for success, or %FALSE if any device did not come back
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_device_list_wait_for_replug_all (FuDeviceList *self, GPtrArray *devices, GError **error)
+{
+	gint64 start;
+	guint remove_delay = 0;
+	g_autoptr(GPtrArray) items = g_ptr_array_new ();
+	g_autoptr(GString) missing = g_string_new (NULL);
+
+	g_return_val_if_fail (FU_IS_DEVICE_LIST (self), FALSE);
+	g_return_val_if_fail (devices != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	g_return_val_if_fail (self->replug_id == 0, FALSE);
+
+	/* only the devices that are in the list and still need a replug */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		FuDeviceItem *item = fu_device_list_find_by_device (self, device);
+		if (item == NULL)
+			continue;
+		if (!fu_device_has_flag (item->device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG))
+			continue;
+		g_ptr_array_add (items, item);
+	}
+	if (items->len == 0) {
+		g_debug ("no replug or re-enumerate required");
+		return TRUE;
+	}
+	if (items->len == 1) {
+		FuDeviceItem *item = g_ptr_array_index (items, 0);
+		return fu_device_list_wait_for_replug (self, item->device, error);
+	}
+
+	/* time to unplug and then re-plug */
+	for (guint i = 0; i < items->len; i++) {
+		FuDeviceItem *item = g_ptr_array_index (items, i);
+		remove_delay = MAX (remove_delay, fu_device_list_get_replug_delay (item->device));
+	}
+	start = fu_timeline_begin ();
+	self->replug_items = items;
+	self->replug_id = g_timeout_add (remove_delay, fu_device_list_replug_cb, self);
+	g_main_loop_run (self->replug_loop);
+	self->replug_items = NULL;
+	fu_timeline_add ("device-list", "wait-for-replug-all", NULL, start);
+
+	/* cancel timeout if still pending */
+	if (self->replug_id != 0) {
+		g_source_remove (self->replug_id);
+		self->replug_id = 0;
+	}
+
+	/* any devices not added back to the device list */
+	for (guint i = 0; i < items->len; i++) {
+		FuDeviceItem *item = g_ptr_array_index (items, i);
+		if (!fu_device_has_flag (item->device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG))
+			continue;
+		if (missing->len > 0)
+			g_string_append (missing, ", ");
+		g_string_append (missing, fu_device_get_id (item->device));
+		fu_device_remove_flag (item->device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG);
+	}
+	if (missing->len > 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_FOUND,
+			     "devices %s did not come back",
+			     missing->str);
+		return FALSE;
+	}
+
+	/* the loop was quit without the timer */
+	g_debug ("waited for %u devices to replug", items->len);
+	return TRUE;
+}
+
 /**
  * fu_device_list_get_by_id:
  * @self: A #FuDeviceList
@@ -907,6 +1338,10 @@ fu_device_list_item_free (FuDeviceItem *item)
 		g_source_remove (item->remove_id);
 	if (item->device_old != NULL)
 		g_object_unref (item->device_old);
+	if (item->keys != NULL)
+		fu_device_index_keys_free (item->keys);
+	if (item->keys_old != NULL)
+		fu_device_index_keys_free (item->keys_old);
 	fu_device_list_item_set_device (item, NULL);
 	g_free (item);
 }
@@ -938,8 +1373,11 @@ static void
 fu_device_list_init (FuDeviceList *self)
 {
 	self->devices = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_device_list_item_free);
+	self->index = fu_device_index_new ();
+	self->index_old = fu_device_index_new ();
 	self->replug_loop = g_main_loop_new (NULL, FALSE);
 	g_rw_lock_init (&self->devices_mutex);
+	g_mutex_init (&self->snapshot_mutex);
 }
 
 static void
@@ -950,8 +1388,13 @@ fu_device_list_finalize (GObject *obj)
 	if (self->replug_id != 0)
 		g_source_remove (self->replug_id);
 	g_ptr_array_unref (self->devices);
+	fu_device_index_free (self->index);
+	fu_device_index_free (self->index_old);
 	g_main_loop_unref (self->replug_loop);
 	g_rw_lock_clear (&self->devices_mutex);
+	if (self->snapshot != NULL)
+		g_ptr_array_unref (self->snapshot);
+	g_mutex_clear (&self->snapshot_mutex);
 
 	G_OBJECT_CLASS (fu_device_list_parent_class)->finalize (obj);
 }
@@ -20,6 +20,7 @@ void		 fu_device_list_remove			(FuDeviceList	*self,
 							 FuDevice	*device);
 GPtrArray	*fu_device_list_get_all			(FuDeviceList	*self);
 GPtrArray	*fu_device_list_get_active		(FuDeviceList	*self);
+GPtrArray	*fu_device_list_get_snapshot		(FuDeviceList	*self);
 FuDevice	*fu_device_list_get_old			(FuDeviceList	*self,
 							 FuDevice	*device);
 FuDevice	*fu_device_list_get_by_id		(FuDeviceList	*self,
@@ -31,3 +32,6 @@ FuDevice	*fu_device_list_get_by_guid		(FuDeviceList	*self,
 gboolean	 fu_device_list_wait_for_replug		(FuDeviceList	*self,
 							 FuDevice	*device,
 							 GError		**error);
+gboolean	 fu_device_list_wait_for_replug_all	(FuDeviceList	*self,
+							 GPtrArray	*devices,
+							 GError		**error);
@@ -13,9 +13,13 @@
 #include <gio/gunixinputstream.h>
 #endif
 #include <glib-object.h>
+#include <glib/gstdio.h>
 #ifdef HAVE_GUDEV
 #include <gudev/gudev.h>
 #endif
+#if defined(HAVE_MALLINFO) || defined(HAVE_MALLOC_TRIM)
+#include <malloc.h>
+#endif
 #include <string.h>
 #ifdef HAVE_UTSNAME_H
 #include <sys/utsname.h>
@@ -23,6 +27,7 @@
 #include <errno.h>
 
 #include "fwupd-common-private.h"
+#include "fwupd-device-private.h"
 #include "fwupd-enums-private.h"
 #include "fwupd-error.h"
 #include "fwupd-release-private.h"
@@ -36,9 +41,10 @@
 #include "fu-debug.h"
 #include "fu-device-list.h"
 #include "fu-device-private.h"
+#include "fu-efivar.h"
 #include "fu-engine.h"
 #include "fu-engine-helper.h"
-#include "fu-hwids.h"
+#include "fu-hwids-private.h"
 #include "fu-idle.h"
 #include "fu-keyring-utils.h"
 #include "fu-hash.h"
@@ -48,8 +54,10 @@
 #include "fu-plugin-list.h"
 #include "fu-plugin-private.h"
 #include "fu-quirks.h"
+#include "fu-quirks-private.h"
 #include "fu-remote-list.h"
 #include "fu-security-attrs-private.h"
+#include "fu-timeline-private.h"
 #include "fu-smbios-private.h"
 #include "fu-udev-device-private.h"
 #include "fu-usb-device-private.h"
@@ -63,6 +71,22 @@
 #endif
 
 static void fu_engine_finalize	 (GObject *obj);
+static GPtrArray *fu_engine_get_releases_for_device_full (FuEngine *self,
+							FuDevice *device,
+							gboolean summary,
+							GError **error);
+static gboolean fu_engine_ensure_plugin_loaded (FuEngine *self,
+						const gchar *name,
+						GError **error);
+static void fu_engine_ensure_plugins_loaded (FuEngine *self);
+static gboolean fu_engine_ensure_device_setup (FuEngine *self,
+					       FuDevice *device,
+					       GError **error);
+static void fu_engine_setup_deferred_schedule (FuEngine *self);
+static void fu_engine_schedule_idle_tasks (FuEngine *self);
+static gboolean fu_engine_host_security_idle_cb (gpointer user_data);
+static gboolean fu_engine_is_plugin_name_blacklisted (FuEngine *self, const gchar *name);
+static const gchar *fu_engine_get_device_blacklisted_guid (FuEngine *self, FuDevice *device);
 
 struct _FuEngine
 {
@@ -80,15 +104,24 @@ struct _FuEngine
 	guint			 percentage;
 	FuHistory		*history;
 	FuIdle			*idle;
-	XbSilo			*silo;
+	GPtrArray		*silos;		/* of XbSilo, in remote order */
+	GHashTable		*remote_silos;	/* remote-id:FuEngineRemoteSilo */
+	GHashTable		*requirements_cache;	/* XbNode:GPtrArray */
+	GHashTable		*component_index;	/* guid:GPtrArray */
+	GHashTable		*component_checksums;	/* guid:checksum */
+	GHashTable		*component_guids_changed;	/* guid */
 	gboolean		 coldplug_running;
 	guint			 coldplug_id;
 	guint			 coldplug_delay;
 	FuPluginList		*plugin_list;
 	GPtrArray		*plugin_filter;
+	GHashTable		*plugins_deferred;	/* name:filename */
 	GPtrArray		*udev_subsystems;
+	GHashTable		*udev_subsystem_plugins;	/* subsystem:GPtrArray of FuPlugin, or NULL */
 #ifdef HAVE_GUDEV
-	GHashTable		*udev_changed_ids;	/* sysfs:FuEngineUdevChangedHelper */
+	GHashTable		*udev_events;		/* sysfs:FuEngineUdevEvent */
+	guint			 udev_events_id;
+	gint64			 udev_events_start;	/* µs */
 #endif
 	FuSmbios		*smbios;
 	FuHwids			*hwids;
@@ -100,10 +133,62 @@ struct _FuEngine
 	gchar			*host_machine_id;
 	JcatContext		*jcat_context;
 	gboolean		 loaded;
-	gchar			*host_security_id;
-	gboolean		 host_security_id_valid;
+	FuSecurityAttrs		*host_security_attrs;	/* nullable, cached */
+	gchar			*host_security_id;	/* nullable, cached */
+	gchar			*host_security_key;	/* nullable, for the HSI cache */
+	GPtrArray		*profile;	/* of FuEngineProfileItem */
+	guint64			 generation;
+	guint64			 generation_horizon;	/* oldest valid for removals */
+	GHashTable		*device_generations;	/* device-id:guint64 */
+	GHashTable		*removed_generations;	/* device-id:guint64 */
+	GMutex			 generations_mutex;	/* for the above */
+	gchar			*engine_id;		/* random, for the verify cache */
+	gboolean		 workers_running;	/* parallel install or verify */
+	gchar			*boot_id;		/* for the coldplug and HWIDs caches */
+	GHashTable		*coldplug_cache;	/* key:GVariant, from the last start */
+	GHashTable		*coldplug_cache_new;	/* key:GVariant, for the next start */
+	guint			 idle_requirements_idx;
+	guint			 watched_files_id;
+	FuWorkerPool		*worker_pool;		/* shared by all plugins */
+	GPtrArray		*silo_cabinets;		/* of FuEngineCabinetSilo, most recent first */
+	gint64			 metadata_duration;	/* µs, of the last reload */
+	GMutex			 metrics_mutex;		/* for the install counters */
+	guint			 install_cnt[2];	/* failure, success */
+	gint64			 install_duration[2];	/* µs */
 };
 
+/* uevents are batched until none arrive for this long, in ms */
+#define FU_ENGINE_UDEV_EVENTS_TIMEOUT		250
+#define FU_ENGINE_UDEV_EVENTS_TIMEOUT_MAX	2000
+
+/* procfs and sysfs files watched by plugins are all re-read this often, in s */
+#define FU_ENGINE_WATCHED_FILES_INTERVAL	10
+
+/* the number of devices that can be opened at the same time by the plugins */
+#define FU_ENGINE_WORKERS_MAX			8
+
+/* the number of removed devices remembered for fu_engine_get_devices_since() */
+#define FU_ENGINE_REMOVED_GENERATIONS_MAX	256
+
+/* the number of parsed cabinets kept, each holding all its payloads */
+#define FU_ENGINE_CABINET_SILOS_MAX		3
+
+typedef struct {
+	gchar			*name;
+	gint64			 duration;	/* µs */
+} FuEngineProfileItem;
+
+typedef struct {
+	gchar			*checksum;	/* of the remote metadata */
+	XbSilo			*silo;
+	GHashTable		*component_checksums;	/* guid:checksum */
+} FuEngineRemoteSilo;
+
+typedef struct {
+	gchar			*checksum;	/* SHA256 of the cabinet blob */
+	XbSilo			*silo;
+} FuEngineCabinetSilo;
+
 enum {
 	SIGNAL_CHANGED,
 	SIGNAL_DEVICE_ADDED,
@@ -118,9 +203,25 @@ static guint signals[SIGNAL_LAST] = { 0 };
 
 G_DEFINE_TYPE (FuEngine, fu_engine, G_TYPE_OBJECT)
 
+/* the attrs are rebuilt on the next request, rather than on each change */
+static void
+fu_engine_invalidate_host_security (FuEngine *self)
+{
+	/* only precompute again if a client has asked before */
+	if (self->host_security_attrs != NULL &&
+	    self->loaded &&
+	    (self->app_flags & FU_APP_FLAGS_NO_IDLE_SOURCES) == 0) {
+		fu_idle_add_task (self->idle, "host-security",
+				  fu_engine_host_security_idle_cb, self);
+	}
+	g_clear_object (&self->host_security_attrs);
+	g_clear_pointer (&self->host_security_id, g_free);
+}
+
 static void
 fu_engine_emit_changed (FuEngine *self)
 {
+	fu_engine_invalidate_host_security (self);
 	g_signal_emit (self, signals[SIGNAL_CHANGED], 0);
 	fu_engine_idle_reset (self);
 
@@ -133,10 +234,64 @@ fu_engine_emit_changed (FuEngine *self)
 	}
 }
 
+static void
+fu_engine_device_generation_bump (FuEngine *self, FuDevice *device)
+{
+	guint64 *generation = g_new0 (guint64, 1);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->generations_mutex);
+	*generation = ++self->generation;
+	g_hash_table_remove (self->removed_generations, fu_device_get_id (device));
+	g_hash_table_insert (self->device_generations,
+			     g_strdup (fu_device_get_id (device)),
+			     generation);
+}
+
+static void
+fu_engine_device_generation_remove (FuEngine *self, FuDevice *device)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	const gchar *oldest_id = NULL;
+	guint64 oldest = G_MAXUINT64;
+	guint64 *generation = g_new0 (guint64, 1);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->generations_mutex);
+
+	*generation = ++self->generation;
+	g_hash_table_remove (self->device_generations, fu_device_get_id (device));
+	g_hash_table_insert (self->removed_generations,
+			     g_strdup (fu_device_get_id (device)),
+			     generation);
+	if (g_hash_table_size (self->removed_generations) <= FU_ENGINE_REMOVED_GENERATIONS_MAX)
+		return;
+
+	/* forget the oldest removal; clients older than this have to resync */
+	g_hash_table_iter_init (&iter, self->removed_generations);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		guint64 *tmp = value;
+		if (*tmp < oldest) {
+			oldest = *tmp;
+			oldest_id = key;
+		}
+	}
+	self->generation_horizon = oldest;
+	g_hash_table_remove (self->removed_generations, oldest_id);
+}
+
+/* returns 0 if the device has never been added */
+static guint64
+fu_engine_device_generation_get (FuEngine *self, FuDevice *device)
+{
+	guint64 *tmp;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->generations_mutex);
+	tmp = g_hash_table_lookup (self->device_generations, fu_device_get_id (device));
+	return tmp != NULL ? *tmp : 0;
+}
+
 static void
 fu_engine_emit_device_changed (FuEngine *self, FuDevice *device)
 {
-	self->host_security_id_valid = FALSE;
+	fu_engine_invalidate_host_security (self);
+	fu_engine_device_generation_bump (self, device);
 	g_signal_emit (self, signals[SIGNAL_DEVICE_CHANGED], 0, device);
 }
 
@@ -152,7 +307,10 @@ GPtrArray *
 fu_engine_get_firmware_gtype_ids (FuEngine *self)
 {
 	GPtrArray *firmware_gtypes = g_ptr_array_new_with_free_func (g_free);
-	g_autoptr(GList) keys = g_hash_table_get_keys (self->firmware_gtypes);
+	g_autoptr(GList) keys = NULL;
+
+	fu_engine_ensure_plugins_loaded (self);
+	keys = g_hash_table_get_keys (self->firmware_gtypes);
 	for (GList *l = keys; l != NULL; l = l->next) {
 		const gchar *id = l->data;
 		g_ptr_array_add (firmware_gtypes, g_strdup (id));
@@ -164,9 +322,38 @@ fu_engine_get_firmware_gtype_ids (FuEngine *self)
 GType
 fu_engine_get_firmware_gtype_by_id (FuEngine *self, const gchar *id)
 {
+	fu_engine_ensure_plugins_loaded (self);
 	return GPOINTER_TO_SIZE (g_hash_table_lookup (self->firmware_gtypes, id));
 }
 
+/* only checks the magic bytes, so the types returned may still fail to parse */
+GPtrArray *
+fu_engine_get_firmware_gtype_ids_for_bytes (FuEngine *self, GBytes *fw)
+{
+	GPtrArray *firmware_gtypes = g_ptr_array_new_with_free_func (g_free);
+	g_autoptr(GPtrArray) ids = fu_engine_get_firmware_gtype_ids (self);
+
+	for (guint i = 0; i < ids->len; i++) {
+		const gchar *id = g_ptr_array_index (ids, i);
+		GType gtype = fu_engine_get_firmware_gtype_by_id (self, id);
+		g_autoptr(FuFirmware) firmware = g_object_new (gtype, NULL);
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_firmware_check_magic (firmware, fw, &error_local)) {
+			g_debug ("ignoring %s: %s", id, error_local->message);
+			continue;
+		}
+		g_ptr_array_add (firmware_gtypes, g_strdup (id));
+	}
+	return firmware_gtypes;
+}
+
+/* may be NULL if the threads could not be created */
+FuWorkerPool *
+fu_engine_get_worker_pool (FuEngine *self)
+{
+	return self->worker_pool;
+}
+
 static void
 fu_engine_add_firmware_gtype (FuEngine *self, const gchar *id, GType gtype)
 {
@@ -217,6 +404,10 @@ fu_engine_progress_notify_cb (FuDevice *device, GParamSpec *pspec, FuEngine *sel
 {
 	if (fu_device_get_status (device) == FWUPD_STATUS_UNKNOWN)
 		return;
+
+	/* aggregated by fu_engine_install_tasks_parallel() instead */
+	if (self->workers_running)
+		return;
 	fu_engine_set_percentage (self, fu_device_get_progress (device));
 	fu_engine_emit_device_changed (self, device);
 }
@@ -224,6 +415,8 @@ fu_engine_progress_notify_cb (FuDevice *device, GParamSpec *pspec, FuEngine *sel
 static void
 fu_engine_status_notify_cb (FuDevice *device, GParamSpec *pspec, FuEngine *self)
 {
+	if (self->workers_running)
+		return;
 	fu_engine_set_status (self, fu_device_get_status (device));
 	fu_engine_emit_device_changed (self, device);
 }
@@ -250,7 +443,14 @@ static void
 fu_engine_device_added_cb (FuDeviceList *device_list, FuDevice *device, FuEngine *self)
 {
 	fu_engine_watch_device (self, device);
+	fu_engine_invalidate_host_security (self);
+	fu_engine_device_generation_bump (self, device);
 	g_signal_emit (self, signals[SIGNAL_DEVICE_ADDED], 0, device);
+
+	/* finish setting up when the daemon is not busy */
+	if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_SETUP_ON_DEMAND) &&
+	    fu_device_get_setup_deferred (device))
+		fu_engine_setup_deferred_schedule (self);
 }
 
 static void
@@ -267,6 +467,8 @@ static void
 fu_engine_device_removed_cb (FuDeviceList *device_list, FuDevice *device, FuEngine *self)
 {
 	fu_engine_device_runner_device_removed (self, device);
+	fu_engine_invalidate_host_security (self);
+	fu_engine_device_generation_remove (self, device);
 	g_signal_handlers_disconnect_by_data (device, self);
 	g_signal_emit (self, signals[SIGNAL_DEVICE_REMOVED], 0, device);
 }
@@ -314,42 +516,20 @@ fu_engine_get_release_version (FuEngine *self, FuDevice *dev, XbNode *rel, GErro
 	return fu_common_version_from_uint32 ((guint32) ver_uint32, fmt);
 }
 
+/* only the fields needed to filter and sort the releases for a device */
 static gboolean
-fu_engine_set_release_from_appstream (FuEngine *self,
-				      FuDevice *dev,
-				      FwupdRelease *rel,
-				      XbNode *component,
-				      XbNode *release,
-				      GError **error)
+fu_engine_set_release_from_appstream_summary (FuEngine *self,
+					      FuDevice *dev,
+					      FwupdRelease *rel,
+					      XbNode *component,
+					      XbNode *release,
+					      GError **error)
 {
 	FwupdRemote *remote = NULL;
 	const gchar *tmp;
 	const gchar *remote_id;
 	guint64 tmp64;
 	g_autofree gchar *version_rel = NULL;
-	g_autoptr(GPtrArray) cats = NULL;
-	g_autoptr(GPtrArray) issues = NULL;
-	g_autoptr(XbNode) description = NULL;
-
-	/* set from the component */
-	tmp = xb_node_query_text (component, "id", NULL);
-	if (tmp != NULL)
-		fwupd_release_set_appstream_id (rel, tmp);
-	tmp = xb_node_query_text (component, "url[@type='homepage']", NULL);
-	if (tmp != NULL)
-		fwupd_release_set_homepage (rel, tmp);
-	tmp = xb_node_query_text (component, "project_license", NULL);
-	if (tmp != NULL)
-		fwupd_release_set_license (rel, tmp);
-	tmp = xb_node_query_text (component, "name", NULL);
-	if (tmp != NULL)
-		fwupd_release_set_name (rel, tmp);
-	tmp = xb_node_query_text (component, "summary", NULL);
-	if (tmp != NULL)
-		fwupd_release_set_summary (rel, tmp);
-	tmp = xb_node_query_text (component, "developer_name", NULL);
-	if (tmp != NULL)
-		fwupd_release_set_vendor (rel, tmp);
 
 	/* refresh the device and release to the new version format too */
 	fu_engine_md_refresh_device_from_component (self, dev, component);
@@ -368,13 +548,6 @@ fu_engine_set_release_from_appstream (FuEngine *self,
 		if (remote == NULL)
 			g_warning ("no remote found for release %s", version_rel);
 	}
-	description = xb_node_query_first (release, "description", NULL);
-	if (description != NULL) {
-		g_autofree gchar *xml = NULL;
-		xml = xb_node_export (description, XB_NODE_EXPORT_FLAG_ONLY_CHILDREN, NULL);
-		if (xml != NULL)
-			fwupd_release_set_description (rel, xml);
-	}
 	tmp = xb_node_query_text (release, "location", NULL);
 	if (tmp != NULL) {
 		g_autofree gchar *uri = NULL;
@@ -392,6 +565,64 @@ fu_engine_set_release_from_appstream (FuEngine *self,
 			fwupd_release_set_uri (rel, uri);
 		}
 	}
+	tmp = xb_node_query_text (release, "checksum[@target='container']", NULL);
+	if (tmp != NULL)
+		fwupd_release_add_checksum (rel, tmp);
+	tmp = xb_node_get_attr (release, "urgency");
+	if (tmp != NULL)
+		fwupd_release_set_urgency (rel, fwupd_release_urgency_from_string (tmp));
+	tmp64 = xb_node_get_attr_as_uint (release, "install_duration");
+	if (tmp64 != G_MAXUINT64)
+		fwupd_release_set_install_duration (rel, tmp64);
+	tmp64 = xb_node_get_attr_as_uint (release, "timestamp");
+	if (tmp64 != G_MAXUINT64)
+		fwupd_release_set_created (rel, tmp64);
+	tmp = xb_node_query_text (component, "custom/value[@key='LVFS::UpdateMessage']", NULL);
+	if (tmp != NULL)
+		fwupd_release_set_update_message (rel, tmp);
+	return TRUE;
+}
+
+/* everything else, which is only needed when the release is shown */
+static void
+fu_engine_set_release_from_appstream_details (FuEngine *self,
+					      FwupdRelease *rel,
+					      XbNode *component,
+					      XbNode *release)
+{
+	const gchar *tmp;
+	guint64 tmp64;
+	g_autoptr(GPtrArray) cats = NULL;
+	g_autoptr(GPtrArray) issues = NULL;
+	g_autoptr(XbNode) description = NULL;
+
+	/* set from the component */
+	tmp = xb_node_query_text (component, "id", NULL);
+	if (tmp != NULL)
+		fwupd_release_set_appstream_id (rel, tmp);
+	tmp = xb_node_query_text (component, "url[@type='homepage']", NULL);
+	if (tmp != NULL)
+		fwupd_release_set_homepage (rel, tmp);
+	tmp = xb_node_query_text (component, "project_license", NULL);
+	if (tmp != NULL)
+		fwupd_release_set_license (rel, tmp);
+	tmp = xb_node_query_text (component, "name", NULL);
+	if (tmp != NULL)
+		fwupd_release_set_name (rel, tmp);
+	tmp = xb_node_query_text (component, "summary", NULL);
+	if (tmp != NULL)
+		fwupd_release_set_summary (rel, tmp);
+	tmp = xb_node_query_text (component, "developer_name", NULL);
+	if (tmp != NULL)
+		fwupd_release_set_vendor (rel, tmp);
+
+	description = xb_node_query_first (release, "description", NULL);
+	if (description != NULL) {
+		g_autofree gchar *xml = NULL;
+		xml = xb_node_export (description, XB_NODE_EXPORT_FLAG_ONLY_CHILDREN, NULL);
+		if (xml != NULL)
+			fwupd_release_set_description (rel, xml);
+	}
 	tmp = xb_node_query_text (release, "checksum[@target='content']", NULL);
 	if (tmp != NULL)
 		fwupd_release_set_filename (rel, tmp);
@@ -401,9 +632,6 @@ fu_engine_set_release_from_appstream (FuEngine *self,
 	tmp = xb_node_query_text (release, "url[@type='source']", NULL);
 	if (tmp != NULL)
 		fwupd_release_set_source_url (rel, tmp);
-	tmp = xb_node_query_text (release, "checksum[@target='container']", NULL);
-	if (tmp != NULL)
-		fwupd_release_add_checksum (rel, tmp);
 	tmp64 = xb_node_query_text_as_uint (release, "size[@type='installed']", NULL);
 	if (tmp64 != G_MAXUINT64) {
 		fwupd_release_set_size (rel, tmp64);
@@ -414,15 +642,6 @@ fu_engine_set_release_from_appstream (FuEngine *self,
 			fwupd_release_set_size (rel, *sizeptr);
 		}
 	}
-	tmp = xb_node_get_attr (release, "urgency");
-	if (tmp != NULL)
-		fwupd_release_set_urgency (rel, fwupd_release_urgency_from_string (tmp));
-	tmp64 = xb_node_get_attr_as_uint (release, "install_duration");
-	if (tmp64 != G_MAXUINT64)
-		fwupd_release_set_install_duration (rel, tmp64);
-	tmp64 = xb_node_get_attr_as_uint (release, "timestamp");
-	if (tmp64 != G_MAXUINT64)
-		fwupd_release_set_created (rel, tmp64);
 	cats = xb_node_query (component, "categories/category", 0, NULL);
 	if (cats != NULL) {
 		for (guint i = 0; i < cats->len; i++) {
@@ -446,12 +665,96 @@ fu_engine_set_release_from_appstream (FuEngine *self,
 	tmp = xb_node_query_text (component, "custom/value[@key='LVFS::UpdateProtocol']", NULL);
 	if (tmp != NULL)
 		fwupd_release_set_protocol (rel, tmp);
-	tmp = xb_node_query_text (component, "custom/value[@key='LVFS::UpdateMessage']", NULL);
-	if (tmp != NULL)
-		fwupd_release_set_update_message (rel, tmp);
+}
+
+static gboolean
+fu_engine_set_release_from_appstream (FuEngine *self,
+				      FuDevice *dev,
+				      FwupdRelease *rel,
+				      XbNode *component,
+				      XbNode *release,
+				      GError **error)
+{
+	if (!fu_engine_set_release_from_appstream_summary (self, dev, rel,
+							   component, release,
+							   error))
+		return FALSE;
+	fu_engine_set_release_from_appstream_details (self, rel, component, release);
 	return TRUE;
 }
 
+/* a summary release keeps the nodes so the details can be added later */
+static void
+fu_engine_release_ensure_details (FuEngine *self, FwupdRelease *rel)
+{
+	XbNode *component = g_object_get_data (G_OBJECT (rel), "fwupd::Component");
+	XbNode *release = g_object_get_data (G_OBJECT (rel), "fwupd::Release");
+	if (component == NULL || release == NULL)
+		return;
+	fu_engine_set_release_from_appstream_details (self, rel, component, release);
+	g_object_set_data (G_OBJECT (rel), "fwupd::Component", NULL);
+	g_object_set_data (G_OBJECT (rel), "fwupd::Release", NULL);
+}
+
+static void
+fu_engine_remote_silo_free (FuEngineRemoteSilo *item)
+{
+	g_free (item->checksum);
+	g_object_unref (item->silo);
+	g_hash_table_unref (item->component_checksums);
+	g_free (item);
+}
+
+static void
+fu_engine_cabinet_silo_free (FuEngineCabinetSilo *item)
+{
+	g_free (item->checksum);
+	g_object_unref (item->silo);
+	g_free (item);
+}
+
+/* each remote has its own silo, so return the first match in remote order */
+static XbNode *
+fu_engine_silos_query_first (FuEngine *self, const gchar *xpath)
+{
+	for (guint i = 0; i < self->silos->len; i++) {
+		XbSilo *silo = g_ptr_array_index (self->silos, i);
+		g_autoptr(XbNode) n = xb_silo_query_first (silo, xpath, NULL);
+		if (n != NULL)
+			return g_steal_pointer (&n);
+	}
+	return NULL;
+}
+
+/* returns the results from all the remote silos, or G_IO_ERROR_NOT_FOUND
+ * if there were none */
+static GPtrArray *
+fu_engine_silos_query (FuEngine *self, const gchar *xpath, GError **error)
+{
+	g_autoptr(GPtrArray) results = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < self->silos->len; i++) {
+		XbSilo *silo = g_ptr_array_index (self->silos, i);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GPtrArray) tmp = xb_silo_query (silo, xpath, 0, &error_local);
+		if (tmp == NULL) {
+			if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+				continue;
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			return NULL;
+		}
+		for (guint j = 0; j < tmp->len; j++)
+			g_ptr_array_add (results, g_object_ref (g_ptr_array_index (tmp, j)));
+	}
+	if (results->len == 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_FOUND,
+			     "no results for %s", xpath);
+		return NULL;
+	}
+	return g_steal_pointer (&results);
+}
+
 /* finds the remote-id for the first firmware in the silo that matches this
  * container checksum */
 static const gchar *
@@ -462,7 +765,7 @@ fu_engine_get_remote_id_for_checksum (FuEngine *self, const gchar *csum)
 	xpath = g_strdup_printf ("components/component/releases/release/"
 				 "checksum[@target='container'][text()='%s']/../../"
 				 "../../custom/value[@key='fwupd::RemoteId']", csum);
-	key = xb_silo_query_first (self->silo, xpath, NULL);
+	key = fu_engine_silos_query_first (self, xpath);
 	if (key == NULL)
 		return NULL;
 	return xb_node_get_text (key);
@@ -518,9 +821,11 @@ fu_engine_modify_config (FuEngine *self, const gchar *key, const gchar *value, G
 		"BlacklistDevices",
 		"BlacklistPlugins",
 		"IdleTimeout",
+		"SignalInterval",
 		"VerboseDomains",
 		"UpdateMotd",
 		"EnumerateAllDevices",
+		"ParallelInstall",
 		NULL };
 
 	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
@@ -752,53 +1057,229 @@ fu_engine_verify_update (FuEngine *self, const gchar *device_id, GError **error)
 	return TRUE;
 }
 
-XbNode *
-fu_engine_get_component_by_guids (FuEngine *self, FuDevice *device)
+typedef struct {
+	guint		 silo_idx;
+	XbNode		*component;
+} FuEngineComponentIndexItem;
+
+static void
+fu_engine_component_index_item_free (FuEngineComponentIndexItem *item)
 {
-	GPtrArray *guids = fu_device_get_guids (device);
-	g_autoptr(GString) xpath = g_string_new (NULL);
-	g_autoptr(XbNode) component = NULL;
-	for (guint i = 0; i < guids->len; i++) {
-		const gchar *guid = g_ptr_array_index (guids, i);
-		xb_string_append_union (xpath,
-					"components/component/"
-					"provides/firmware[@type='flashed'][text()='%s']/"
-					"../..", guid);
+	g_object_unref (item->component);
+	g_free (item);
+}
+
+/* every device is looked up after each metadata refresh, so build the
+ * GUID to component mapping once rather than querying each silo */
+static void
+fu_engine_ensure_component_index (FuEngine *self)
+{
+	if (self->component_index != NULL)
+		return;
+	self->component_index = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						       (GDestroyNotify) g_ptr_array_unref);
+	for (guint i = 0; i < self->silos->len; i++) {
+		XbSilo *silo = g_ptr_array_index (self->silos, i);
+		g_autoptr(GPtrArray) provides = NULL;
+		provides = xb_silo_query (silo,
+					  "components/component/"
+					  "provides/firmware[@type='flashed']",
+					  0, NULL);
+		if (provides == NULL)
+			continue;
+		for (guint j = 0; j < provides->len; j++) {
+			XbNode *n = g_ptr_array_index (provides, j);
+			const gchar *guid = xb_node_get_text (n);
+			FuEngineComponentIndexItem *item;
+			GPtrArray *items;
+			g_autoptr(XbNode) parent = NULL;
+			if (guid == NULL)
+				continue;
+			parent = xb_node_get_parent (n);
+			if (parent == NULL)
+				continue;
+			item = g_new0 (FuEngineComponentIndexItem, 1);
+			item->silo_idx = i;
+			item->component = xb_node_get_parent (parent);
+			if (item->component == NULL) {
+				g_free (item);
+				continue;
+			}
+			items = g_hash_table_lookup (self->component_index, guid);
+			if (items == NULL) {
+				items = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_component_index_item_free);
+				g_hash_table_insert (self->component_index, g_strdup (guid), items);
+			}
+			g_ptr_array_add (items, item);
+		}
 	}
-	component = xb_silo_query_first (self->silo, xpath->str, NULL);
-	if (component != NULL)
-		return g_steal_pointer (&component);
-	return NULL;
 }
 
-/**
- * fu_engine_verify:
- * @self: A #FuEngine
- * @device_id: A device ID
- * @error: A #GError, or %NULL
- *
- * Verifies a device firmware checksum using the verification silo entry.
- *
- * Returns: %TRUE for success
- **/
-gboolean
-fu_engine_verify (FuEngine *self, const gchar *device_id, GError **error)
+/* returns all the components that provide any of the device GUIDs, in
+ * remote order, or %NULL if there are none */
+static GPtrArray *
+fu_engine_get_components_by_guids (FuEngine *self, FuDevice *device)
 {
-	FuPlugin *plugin;
-	GPtrArray *checksums;
-	const gchar *version;
-	g_autofree gchar *fn = NULL;
-	g_autofree gchar *localstatedir = NULL;
-	g_autoptr(FuDevice) device = NULL;
-	g_autoptr(GFile) file = NULL;
-	g_autoptr(GString) xpath_csum = g_string_new (NULL);
-	g_autoptr(XbNode) csum = NULL;
-	g_autoptr(XbNode) release = NULL;
-	g_autoptr(XbSilo) silo = xb_silo_new ();
+	GPtrArray *guids = fu_device_get_guids (device);
+	g_autoptr(GHashTable) seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+	g_autoptr(GPtrArray) components = NULL;
 
-	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
-	g_return_val_if_fail (device_id != NULL, FALSE);
-	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	fu_engine_ensure_component_index (self);
+	components = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < self->silos->len; i++) {
+		for (guint j = 0; j < guids->len; j++) {
+			const gchar *guid = g_ptr_array_index (guids, j);
+			GPtrArray *items = g_hash_table_lookup (self->component_index, guid);
+			if (items == NULL)
+				continue;
+			for (guint k = 0; k < items->len; k++) {
+				FuEngineComponentIndexItem *item = g_ptr_array_index (items, k);
+				if (item->silo_idx != i)
+					continue;
+				if (g_hash_table_contains (seen, item->component))
+					continue;
+				g_hash_table_add (seen, item->component);
+				g_ptr_array_add (components, g_object_ref (item->component));
+			}
+		}
+	}
+	if (components->len == 0)
+		return NULL;
+	return g_steal_pointer (&components);
+}
+
+XbNode *
+fu_engine_get_component_by_guids (FuEngine *self, FuDevice *device)
+{
+	g_autoptr(GPtrArray) components = fu_engine_get_components_by_guids (self, device);
+	if (components == NULL)
+		return NULL;
+	return g_object_ref (g_ptr_array_index (components, 0));
+}
+
+/* devices behind the same proxy or with the same root share a bus, and
+ * may re-enumerate each other, so have to be updated in order */
+static FuDevice *
+fu_engine_get_group_device (FuDevice *device)
+{
+	FuDevice *proxy = fu_device_get_proxy (device);
+	return fu_device_get_root (proxy != NULL ? proxy : device);
+}
+
+/* the checksum the device computes itself, or %NULL if not supported */
+static gchar *
+fu_engine_device_read_checksum (FuDevice *device)
+{
+	gchar *checksum;
+	g_autoptr(FuDeviceLocker) locker = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	if (FU_DEVICE_GET_CLASS (device)->read_checksum == NULL)
+		return NULL;
+	locker = fu_device_locker_new (device, &error_local);
+	if (locker == NULL) {
+		g_debug ("failed to open device: %s", error_local->message);
+		return NULL;
+	}
+	checksum = fu_device_read_checksum (device, &error_local);
+	if (checksum == NULL)
+		g_debug ("failed to read device checksum: %s", error_local->message);
+	return checksum;
+}
+
+/* reading back the firmware can take minutes, so reuse the checksums if the
+ * device has not changed since the last time it was read in this session,
+ * or in any session if the device can compute a checksum of the flash */
+static gboolean
+fu_engine_verify_readback (FuEngine *self,
+			   FuPlugin *plugin,
+			   FuDevice *device,
+			   GError **error)
+{
+	const gchar *version = fu_device_get_version (device);
+	const gchar *engine_id = self->engine_id;
+	guint64 generation = fu_engine_device_generation_get (self, device);
+	g_autofree gchar *device_checksum = NULL;
+	g_autofree gchar *device_checksum_id = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) checksums_cached = NULL;
+
+	if (version != NULL) {
+		device_checksum = fu_engine_device_read_checksum (device);
+		if (device_checksum != NULL) {
+			device_checksum_id = g_strdup_printf ("device:%s", device_checksum);
+			engine_id = device_checksum_id;
+			generation = 0;
+		}
+		checksums_cached = fu_history_get_verify_cache (self->history,
+								fu_device_get_id (device),
+								version,
+								engine_id,
+								generation,
+								&error_local);
+	}
+	if (checksums_cached != NULL) {
+		GPtrArray *checksums = fu_device_get_checksums (device);
+		g_debug ("using cached checksums for %s", fu_device_get_id (device));
+		g_ptr_array_set_size (checksums, 0);
+		for (guint i = 0; i < checksums_cached->len; i++) {
+			const gchar *checksum = g_ptr_array_index (checksums_cached, i);
+			fu_device_add_checksum (device, checksum);
+		}
+		return TRUE;
+	}
+	if (error_local != NULL &&
+	    !g_error_matches (error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND))
+		g_debug ("failed to get verify cache: %s", error_local->message);
+
+	/* do the slow readback */
+	if (!fu_plugin_runner_verify (plugin, device,
+				      FU_PLUGIN_VERIFY_FLAG_NONE, error))
+		return FALSE;
+	if (version != NULL) {
+		g_autoptr(GError) error_cache = NULL;
+		if (device_checksum == NULL)
+			generation = fu_engine_device_generation_get (self, device);
+		if (!fu_history_set_verify_cache (self->history,
+						  fu_device_get_id (device),
+						  version,
+						  engine_id,
+						  generation,
+						  fu_device_get_checksums (device),
+						  &error_cache))
+			g_debug ("failed to set verify cache: %s", error_cache->message);
+	}
+	return TRUE;
+}
+
+/**
+ * fu_engine_verify:
+ * @self: A #FuEngine
+ * @device_id: A device ID
+ * @error: A #GError, or %NULL
+ *
+ * Verifies a device firmware checksum using the verification silo entry.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_engine_verify (FuEngine *self, const gchar *device_id, GError **error)
+{
+	FuPlugin *plugin;
+	GPtrArray *checksums;
+	const gchar *version;
+	g_autofree gchar *fn = NULL;
+	g_autofree gchar *localstatedir = NULL;
+	g_autoptr(FuDevice) device = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GString) xpath_csum = g_string_new (NULL);
+	g_autoptr(XbNode) csum = NULL;
+	g_autoptr(XbNode) release = NULL;
+	g_autoptr(XbSilo) silo = xb_silo_new ();
+
+	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
+	g_return_val_if_fail (device_id != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
 	/* check the id exists */
 	device = fu_device_list_get_by_id (self->device_list, device_id, error);
@@ -814,8 +1295,7 @@ fu_engine_verify (FuEngine *self, const gchar *device_id, GError **error)
 
 	/* update the device firmware hashes if possible */
 	if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_CAN_VERIFY_IMAGE)) {
-		if (!fu_plugin_runner_verify (plugin, device,
-					      FU_PLUGIN_VERIFY_FLAG_NONE, error))
+		if (!fu_engine_verify_readback (self, plugin, device, error))
 			return FALSE;
 	}
 
@@ -854,7 +1334,7 @@ fu_engine_verify (FuEngine *self, const gchar *device_id, GError **error)
 						  "provides/firmware[@type='flashed'][text()='%s']/"
 						  "../../releases/release",
 						  guid);
-			releases = xb_silo_query (self->silo, xpath2, 0, error);
+			releases = fu_engine_silos_query (self, xpath2, error);
 			if (releases == NULL)
 				return FALSE;
 			for (guint j = 0; j < releases->len; j++) {
@@ -942,73 +1422,319 @@ fu_engine_verify (FuEngine *self, const gchar *device_id, GError **error)
 	return TRUE;
 }
 
+typedef struct {
+	FuEngine	*self;
+	GPtrArray	*devices;	/* (element-type FuDevice) */
+	GPtrArray	*results;	/* (element-type utf-8) */
+	gboolean	 parallel;
+} FuEngineVerifyGroup;
+
+static void
+fu_engine_verify_group_free (FuEngineVerifyGroup *group)
+{
+	g_ptr_array_unref (group->devices);
+	g_ptr_array_unref (group->results);
+	g_free (group);
+}
+
+/* same rules as fu_engine_install_group_can_parallel() */
+static gboolean
+fu_engine_verify_group_can_parallel (FuEngineVerifyGroup *group)
+{
+	for (guint i = 0; i < group->devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (group->devices, i);
+		if (fu_device_get_remove_delay (device) > 0)
+			return FALSE;
+		if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* a failure of one device does not stop the others being verified */
+static void
+fu_engine_verify_group_run (gpointer user_data, GCancellable *cancellable)
+{
+	FuEngineVerifyGroup *group = (FuEngineVerifyGroup *) user_data;
+	for (guint i = 0; i < group->devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (group->devices, i);
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_engine_verify (group->self, fu_device_get_id (device), &error_local)) {
+			g_ptr_array_add (group->results, g_strdup (error_local->message));
+			continue;
+		}
+		g_ptr_array_add (group->results, g_strdup (""));
+	}
+}
+
+/**
+ * fu_engine_verify_all:
+ * @self: A #FuEngine
+ * @error: A #GError, or %NULL
+ *
+ * Verifies all the devices that support it. Devices on different buses are
+ * read back at the same time, and devices that may re-enumerate are verified
+ * one at a time afterwards.
+ *
+ * Returns: (transfer container) (element-type utf8 utf8): device-id to an
+ * error message, where an empty string is success
+ **/
+GHashTable *
+fu_engine_verify_all (FuEngine *self, GError **error)
+{
+	g_autoptr(FuWorkerBatch) batch = NULL;
+	g_autoptr(GHashTable) groups_by_device = g_hash_table_new (g_direct_hash, g_direct_equal);
+	g_autoptr(GHashTable) results = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GPtrArray) groups = NULL;
+
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* group by physical device, as for parallel install */
+	devices = fu_device_list_get_active (self->device_list);
+	groups = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_verify_group_free);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		FuDevice *device_group;
+		FuEngineVerifyGroup *group;
+		if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_CAN_VERIFY))
+			continue;
+		device_group = fu_engine_get_group_device (device);
+		group = g_hash_table_lookup (groups_by_device, device_group);
+		if (group == NULL) {
+			group = g_new0 (FuEngineVerifyGroup, 1);
+			group->self = self;
+			group->devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+			group->results = g_ptr_array_new_with_free_func (g_free);
+			g_hash_table_insert (groups_by_device, device_group, group);
+			g_ptr_array_add (groups, group);
+		}
+		g_ptr_array_add (group->devices, g_object_ref (device));
+	}
+	if (groups->len == 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOTHING_TO_DO,
+				     "No devices can be verified");
+		return NULL;
+	}
+
+	/* read back the independent groups at the same time */
+	self->workers_running = TRUE;
+	batch = fu_worker_batch_new (self->worker_pool, FU_WORKER_PRIORITY_BACKGROUND, NULL);
+	for (guint i = 0; i < groups->len; i++) {
+		FuEngineVerifyGroup *group = g_ptr_array_index (groups, i);
+		if (!fu_engine_verify_group_can_parallel (group))
+			continue;
+		group->parallel = TRUE;
+		fu_worker_batch_add (batch, fu_engine_verify_group_run, group);
+	}
+	fu_worker_batch_wait (batch);
+	self->workers_running = FALSE;
+
+	/* the devices that may replug are done one at a time */
+	for (guint i = 0; i < groups->len; i++) {
+		FuEngineVerifyGroup *group = g_ptr_array_index (groups, i);
+		if (!group->parallel)
+			fu_engine_verify_group_run (group, NULL);
+	}
+
+	/* success */
+	results = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	for (guint i = 0; i < groups->len; i++) {
+		FuEngineVerifyGroup *group = g_ptr_array_index (groups, i);
+		for (guint j = 0; j < group->devices->len; j++) {
+			FuDevice *device = g_ptr_array_index (group->devices, j);
+			const gchar *result = g_ptr_array_index (group->results, j);
+			g_hash_table_insert (results,
+					     g_strdup (fu_device_get_id (device)),
+					     g_strdup (result));
+		}
+	}
+	return g_steal_pointer (&results);
+}
+
+typedef enum {
+	FU_ENGINE_REQUIREMENT_KIND_UNKNOWN,
+	FU_ENGINE_REQUIREMENT_KIND_ID,
+	FU_ENGINE_REQUIREMENT_KIND_FIRMWARE,
+	FU_ENGINE_REQUIREMENT_KIND_HARDWARE,
+} FuEngineRequirementKind;
+
+typedef enum {
+	FU_ENGINE_REQUIREMENT_COMPARE_UNKNOWN,
+	FU_ENGINE_REQUIREMENT_COMPARE_EQ,
+	FU_ENGINE_REQUIREMENT_COMPARE_NE,
+	FU_ENGINE_REQUIREMENT_COMPARE_LT,
+	FU_ENGINE_REQUIREMENT_COMPARE_GT,
+	FU_ENGINE_REQUIREMENT_COMPARE_LE,
+	FU_ENGINE_REQUIREMENT_COMPARE_GE,
+	FU_ENGINE_REQUIREMENT_COMPARE_GLOB,
+	FU_ENGINE_REQUIREMENT_COMPARE_REGEX,
+} FuEngineRequirementCompare;
+
+/* a <requires> child node parsed once, with the result of the last version
+ * comparison and the HWID lookup remembered as neither changes at runtime */
+typedef struct {
+	FuEngineRequirementKind		 kind;
+	FuEngineRequirementCompare	 compare;
+	gchar				*element;
+	gchar				*compare_str;
+	gchar				*version;
+	gchar				*text;
+	guint64				 depth;
+	GRegex				*regex;
+	gchar				**hwids;
+	gint				 hwids_result;	/* -1 for unknown */
+	gboolean			 vercmp_valid;
+	gchar				*vercmp_version;
+	FwupdVersionFormat		 vercmp_fmt;
+	gboolean			 vercmp_ret;
+} FuEngineRequirement;
+
+static void
+fu_engine_requirement_free (FuEngineRequirement *req)
+{
+	g_free (req->element);
+	g_free (req->compare_str);
+	g_free (req->version);
+	g_free (req->text);
+	if (req->regex != NULL)
+		g_regex_unref (req->regex);
+	g_strfreev (req->hwids);
+	g_free (req->vercmp_version);
+	g_free (req);
+}
+
+static FuEngineRequirementCompare
+fu_engine_requirement_compare_from_string (const gchar *compare)
+{
+	if (g_strcmp0 (compare, "eq") == 0)
+		return FU_ENGINE_REQUIREMENT_COMPARE_EQ;
+	if (g_strcmp0 (compare, "ne") == 0)
+		return FU_ENGINE_REQUIREMENT_COMPARE_NE;
+	if (g_strcmp0 (compare, "lt") == 0)
+		return FU_ENGINE_REQUIREMENT_COMPARE_LT;
+	if (g_strcmp0 (compare, "gt") == 0)
+		return FU_ENGINE_REQUIREMENT_COMPARE_GT;
+	if (g_strcmp0 (compare, "le") == 0)
+		return FU_ENGINE_REQUIREMENT_COMPARE_LE;
+	if (g_strcmp0 (compare, "ge") == 0)
+		return FU_ENGINE_REQUIREMENT_COMPARE_GE;
+	if (g_strcmp0 (compare, "glob") == 0)
+		return FU_ENGINE_REQUIREMENT_COMPARE_GLOB;
+	if (g_strcmp0 (compare, "regex") == 0)
+		return FU_ENGINE_REQUIREMENT_COMPARE_REGEX;
+	return FU_ENGINE_REQUIREMENT_COMPARE_UNKNOWN;
+}
+
+static FuEngineRequirement *
+fu_engine_requirement_new (XbNode *n)
+{
+	FuEngineRequirement *req = g_new0 (FuEngineRequirement, 1);
+
+	req->element = g_strdup (xb_node_get_element (n));
+	req->compare_str = g_strdup (xb_node_get_attr (n, "compare"));
+	req->version = g_strdup (xb_node_get_attr (n, "version"));
+	req->text = g_strdup (xb_node_get_text (n));
+	req->depth = xb_node_get_attr_as_uint (n, "depth");
+	req->compare = fu_engine_requirement_compare_from_string (req->compare_str);
+	req->hwids_result = -1;
+	if (req->compare == FU_ENGINE_REQUIREMENT_COMPARE_REGEX && req->version != NULL)
+		req->regex = g_regex_new (req->version, G_REGEX_OPTIMIZE, 0, NULL);
+	if (g_strcmp0 (req->element, "id") == 0) {
+		req->kind = FU_ENGINE_REQUIREMENT_KIND_ID;
+	} else if (g_strcmp0 (req->element, "firmware") == 0) {
+		req->kind = FU_ENGINE_REQUIREMENT_KIND_FIRMWARE;
+	} else if (g_strcmp0 (req->element, "hardware") == 0) {
+		req->kind = FU_ENGINE_REQUIREMENT_KIND_HARDWARE;
+		req->hwids = g_strsplit (req->text != NULL ? req->text : "", "|", -1);
+	}
+	return req;
+}
+
+static gboolean
+fu_engine_require_vercmp_uncached (FuEngineRequirement *req,
+				   const gchar *version,
+				   FwupdVersionFormat fmt)
+{
+	switch (req->compare) {
+	case FU_ENGINE_REQUIREMENT_COMPARE_EQ:
+		return fu_common_vercmp_full (version, req->version, fmt) == 0;
+	case FU_ENGINE_REQUIREMENT_COMPARE_NE:
+		return fu_common_vercmp_full (version, req->version, fmt) != 0;
+	case FU_ENGINE_REQUIREMENT_COMPARE_LT:
+		return fu_common_vercmp_full (version, req->version, fmt) < 0;
+	case FU_ENGINE_REQUIREMENT_COMPARE_GT:
+		return fu_common_vercmp_full (version, req->version, fmt) > 0;
+	case FU_ENGINE_REQUIREMENT_COMPARE_LE:
+		return fu_common_vercmp_full (version, req->version, fmt) <= 0;
+	case FU_ENGINE_REQUIREMENT_COMPARE_GE:
+		return fu_common_vercmp_full (version, req->version, fmt) >= 0;
+	case FU_ENGINE_REQUIREMENT_COMPARE_GLOB:
+		return fu_common_fnmatch (req->version, version);
+	case FU_ENGINE_REQUIREMENT_COMPARE_REGEX:
+		if (req->regex == NULL || version == NULL)
+			return FALSE;
+		return g_regex_match (req->regex, version, 0, NULL);
+	default:
+		break;
+	}
+	return FALSE;
+}
+
 static gboolean
-fu_engine_require_vercmp (XbNode *req,
+fu_engine_require_vercmp (FuEngineRequirement *req,
 			  const gchar *version,
 			  FwupdVersionFormat fmt,
 			  GError **error)
 {
-	gboolean ret = FALSE;
-	gint rc = 0;
-	const gchar *tmp = xb_node_get_attr (req, "compare");
-	const gchar *version_req = xb_node_get_attr (req, "version");
-
-	if (g_strcmp0 (tmp, "eq") == 0) {
-		rc = fu_common_vercmp_full (version, version_req, fmt);
-		ret = rc == 0;
-	} else if (g_strcmp0 (tmp, "ne") == 0) {
-		rc = fu_common_vercmp_full (version, version_req, fmt);
-		ret = rc != 0;
-	} else if (g_strcmp0 (tmp, "lt") == 0) {
-		rc = fu_common_vercmp_full (version, version_req, fmt);
-		ret = rc < 0;
-	} else if (g_strcmp0 (tmp, "gt") == 0) {
-		rc = fu_common_vercmp_full (version, version_req, fmt);
-		ret = rc > 0;
-	} else if (g_strcmp0 (tmp, "le") == 0) {
-		rc = fu_common_vercmp_full (version, version_req, fmt);
-		ret = rc <= 0;
-	} else if (g_strcmp0 (tmp, "ge") == 0) {
-		rc = fu_common_vercmp_full (version, version_req, fmt);
-		ret = rc >= 0;
-	} else if (g_strcmp0 (tmp, "glob") == 0) {
-		ret = fu_common_fnmatch (version_req, version);
-	} else if (g_strcmp0 (tmp, "regex") == 0) {
-		ret = g_regex_match_simple (version_req, version, 0, 0);
-	} else {
+	if (req->compare == FU_ENGINE_REQUIREMENT_COMPARE_UNKNOWN) {
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_NOT_SUPPORTED,
 			     "failed to compare [%s] and [%s]",
-			     version_req,
+			     req->version,
 			     version);
 		return FALSE;
 	}
 
+	/* the same device version is usually checked for every release */
+	if (!req->vercmp_valid ||
+	    req->vercmp_fmt != fmt ||
+	    g_strcmp0 (req->vercmp_version, version) != 0) {
+		g_free (req->vercmp_version);
+		req->vercmp_version = g_strdup (version);
+		req->vercmp_fmt = fmt;
+		req->vercmp_ret = fu_engine_require_vercmp_uncached (req, version, fmt);
+		req->vercmp_valid = TRUE;
+	}
+
 	/* set error */
-	if (!ret) {
+	if (!req->vercmp_ret) {
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_INTERNAL,
 			     "failed predicate [%s %s %s]",
-			     version_req, tmp, version);
+			     req->version, req->compare_str, version);
 	}
-	return ret;
+	return req->vercmp_ret;
 }
 
 static gboolean
-fu_engine_check_requirement_not_child (FuEngine *self, XbNode *req,
+fu_engine_check_requirement_not_child (FuEngine *self, FuEngineRequirement *req,
 				       FuDevice *device, GError **error)
 {
 	GPtrArray *children = fu_device_get_children (device);
 
 	/* only <firmware> supported */
-	if (g_strcmp0 (xb_node_get_element (req), "firmware") != 0) {
+	if (req->kind != FU_ENGINE_REQUIREMENT_KIND_FIRMWARE) {
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_NOT_SUPPORTED,
 			     "cannot handle not-child %s requirement",
-			     xb_node_get_element (req));
+			     req->element);
 		return FALSE;
 	}
 
@@ -1040,17 +1766,15 @@ fu_engine_check_requirement_not_child (FuEngine *self, XbNode *req,
 }
 
 static gboolean
-fu_engine_check_requirement_firmware (FuEngine *self, XbNode *req,
+fu_engine_check_requirement_firmware (FuEngine *self, FuEngineRequirement *req,
 				      FuDevice *device, GError **error)
 {
-	guint64 depth;
 	g_autoptr(FuDevice) device_actual = g_object_ref (device);
 	g_autoptr(GError) error_local = NULL;
 
 	/* look at the parent device */
-	depth = xb_node_get_attr_as_uint (req, "depth");
-	if (depth != G_MAXUINT64) {
-		for (guint64 i = 0; i < depth; i++) {
+	if (req->depth != G_MAXUINT64) {
+		for (guint64 i = 0; i < req->depth; i++) {
 			FuDevice *device_tmp = fu_device_get_parent (device_actual);
 			if (device_actual == NULL) {
 				g_set_error (error,
@@ -1058,7 +1782,7 @@ fu_engine_check_requirement_firmware (FuEngine *self, XbNode *req,
 					     FWUPD_ERROR_NOT_SUPPORTED,
 					     "No parent device for %s "
 					     "(%" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT ")",
-					     fu_device_get_name (device_actual), i, depth);
+					     fu_device_get_name (device_actual), i, req->depth);
 				return FALSE;
 			}
 			g_set_object (&device_actual, device_tmp);
@@ -1066,17 +1790,17 @@ fu_engine_check_requirement_firmware (FuEngine *self, XbNode *req,
 	}
 
 	/* old firmware version */
-	if (xb_node_get_text (req) == NULL) {
+	if (req->text == NULL) {
 		const gchar *version = fu_device_get_version (device_actual);
 		if (!fu_engine_require_vercmp (req, version,
 					       fu_device_get_version_format (device_actual),
 					       &error_local)) {
-			if (g_strcmp0 (xb_node_get_attr (req, "compare"), "ge") == 0) {
+			if (req->compare == FU_ENGINE_REQUIREMENT_COMPARE_GE) {
 				g_set_error (error,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_INVALID_FILE,
 					     "Not compatible with firmware version %s, requires >= %s",
-					     version, xb_node_get_attr (req, "version"));
+					     version, req->version);
 			} else {
 				g_set_error (error,
 					     FWUPD_ERROR,
@@ -1090,17 +1814,17 @@ fu_engine_check_requirement_firmware (FuEngine *self, XbNode *req,
 	}
 
 	/* bootloader version */
-	if (g_strcmp0 (xb_node_get_text (req), "bootloader") == 0) {
+	if (g_strcmp0 (req->text, "bootloader") == 0) {
 		const gchar *version = fu_device_get_version_bootloader (device_actual);
 		if (!fu_engine_require_vercmp (req, version,
 					       fu_device_get_version_format (device_actual),
 					       &error_local)) {
-			if (g_strcmp0 (xb_node_get_attr (req, "compare"), "ge") == 0) {
+			if (req->compare == FU_ENGINE_REQUIREMENT_COMPARE_GE) {
 				g_set_error (error,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_NOT_SUPPORTED,
 					     "Not compatible with bootloader version %s, requires >= %s",
-                                             version, xb_node_get_attr (req, "version"));
+                                             version, req->version);
 
 			} else {
 				g_debug ("Bootloader is not compatible: %s", error_local->message);
@@ -1115,7 +1839,7 @@ fu_engine_check_requirement_firmware (FuEngine *self, XbNode *req,
 	}
 
 	/* vendor ID */
-	if (g_strcmp0 (xb_node_get_text (req), "vendor-id") == 0 &&
+	if (g_strcmp0 (req->text, "vendor-id") == 0 &&
 	    fu_device_get_vendor_id (device_actual) != NULL) {
 		const gchar *version = fu_device_get_vendor_id (device_actual);
 		if (!fu_engine_require_vercmp (req, version,
@@ -1132,16 +1856,16 @@ fu_engine_check_requirement_firmware (FuEngine *self, XbNode *req,
 	}
 
 	/* child version */
-	if (g_strcmp0 (xb_node_get_text (req), "not-child") == 0)
+	if (g_strcmp0 (req->text, "not-child") == 0)
 		return fu_engine_check_requirement_not_child (self, req, device_actual, error);
 
 	/* another device */
-	if (fwupd_guid_is_valid (xb_node_get_text (req))) {
-		const gchar *guid = xb_node_get_text (req);
+	if (fwupd_guid_is_valid (req->text)) {
+		const gchar *guid = req->text;
 		const gchar *version;
 
 		/* find if the other device exists */
-		if (depth == G_MAXUINT64) {
+		if (req->depth == G_MAXUINT64) {
 			g_autoptr(FuDevice) device_tmp = NULL;
 			device_tmp = fu_device_list_get_by_guid (self->device_list, guid, error);
 			if (device_tmp == NULL)
@@ -1163,18 +1887,18 @@ fu_engine_check_requirement_firmware (FuEngine *self, XbNode *req,
 		/* get the version of the other device */
 		version = fu_device_get_version (device_actual);
 		if (version != NULL &&
-		    xb_node_get_attr (req, "compare") != NULL &&
+		    req->compare_str != NULL &&
 		    !fu_engine_require_vercmp (req, version,
 					       fu_device_get_version_format (device_actual),
 					       &error_local)) {
-			if (g_strcmp0 (xb_node_get_attr (req, "compare"), "ge") == 0) {
+			if (req->compare == FU_ENGINE_REQUIREMENT_COMPARE_GE) {
 				g_set_error (error,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_INVALID_FILE,
 					     "Not compatible with %s version %s, requires >= %s",
 					     fu_device_get_name (device_actual),
 					     version,
-					     xb_node_get_attr (req, "version"));
+					     req->version);
 			} else {
 				g_set_error (error,
 					     FWUPD_ERROR,
@@ -1194,88 +1918,87 @@ fu_engine_check_requirement_firmware (FuEngine *self, XbNode *req,
 		     FWUPD_ERROR,
 		     FWUPD_ERROR_NOT_SUPPORTED,
 		     "cannot handle firmware requirement '%s'",
-		     xb_node_get_text (req));
+		     req->text);
 	return FALSE;
 }
 
 static gboolean
-fu_engine_check_requirement_id (FuEngine *self, XbNode *req, GError **error)
+fu_engine_check_requirement_id (FuEngine *self, FuEngineRequirement *req, GError **error)
 {
 	g_autoptr(GError) error_local = NULL;
-	const gchar *version = g_hash_table_lookup (self->runtime_versions,
-						    xb_node_get_text (req));
+	const gchar *version = g_hash_table_lookup (self->runtime_versions, req->text);
 	if (version == NULL) {
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_NOT_FOUND,
 			     "no version available for %s",
-			     xb_node_get_text (req));
+			     req->text);
 		return FALSE;
 	}
 	if (!fu_engine_require_vercmp (req, version, FWUPD_VERSION_FORMAT_UNKNOWN, &error_local)) {
-		if (g_strcmp0 (xb_node_get_attr (req, "compare"), "ge") == 0) {
+		if (req->compare == FU_ENGINE_REQUIREMENT_COMPARE_GE) {
 			g_set_error (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_INVALID_FILE,
 				     "Not compatible with %s version %s, requires >= %s",
-				     xb_node_get_text (req), version,
-				     xb_node_get_attr (req, "version"));
+				     req->text, version, req->version);
 		} else {
 			g_set_error (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_INVALID_FILE,
 				     "Not compatible with %s version: %s",
-				     xb_node_get_text (req), error_local->message);
+				     req->text, error_local->message);
 		}
 		return FALSE;
 	}
 
 	g_debug ("requirement %s %s %s on %s passed",
-		 xb_node_get_attr (req, "version"),
-		 xb_node_get_attr (req, "compare"),
-		 version, xb_node_get_text (req));
+		 req->version, req->compare_str, version, req->text);
 	return TRUE;
 }
 
 static gboolean
-fu_engine_check_requirement_hardware (FuEngine *self, XbNode *req, GError **error)
-{
-	g_auto(GStrv) hwid_split = NULL;
-
-	/* split and treat as OR */
-	hwid_split = g_strsplit (xb_node_get_text (req), "|", -1);
-	for (guint i = 0; hwid_split[i] != NULL; i++) {
-		if (fu_hwids_has_guid (self->hwids, hwid_split[i])) {
-			g_debug ("HWID provided %s", hwid_split[i]);
-			return TRUE;
+fu_engine_check_requirement_hardware (FuEngine *self, FuEngineRequirement *req, GError **error)
+{
+	/* the HWIDs are only loaded once, so only check the first time */
+	if (req->hwids_result == -1) {
+		req->hwids_result = 0;
+		for (guint i = 0; req->hwids[i] != NULL; i++) {
+			if (fu_hwids_has_guid (self->hwids, req->hwids[i])) {
+				g_debug ("HWID provided %s", req->hwids[i]);
+				req->hwids_result = 1;
+				break;
+			}
 		}
 	}
+	if (req->hwids_result == 1)
+		return TRUE;
 
 	/* nothing matched */
 	g_set_error (error,
 		     FWUPD_ERROR,
 		     FWUPD_ERROR_INVALID_FILE,
 		     "no HWIDs matched %s",
-		     xb_node_get_text (req));
+		     req->text);
 	return FALSE;
 }
 
 static gboolean
-fu_engine_check_requirement (FuEngine *self, XbNode *req, FuDevice *device, GError **error)
+fu_engine_check_requirement (FuEngine *self, FuEngineRequirement *req, FuDevice *device, GError **error)
 {
 	/* ensure component requirement */
-	if (g_strcmp0 (xb_node_get_element (req), "id") == 0)
+	if (req->kind == FU_ENGINE_REQUIREMENT_KIND_ID)
 		return fu_engine_check_requirement_id (self, req, error);
 
 	/* ensure firmware requirement */
-	if (g_strcmp0 (xb_node_get_element (req), "firmware") == 0) {
+	if (req->kind == FU_ENGINE_REQUIREMENT_KIND_FIRMWARE) {
 		if (device == NULL)
 			return TRUE;
 		return fu_engine_check_requirement_firmware (self, req, device, error);
 	}
 
 	/* ensure hardware requirement */
-	if (g_strcmp0 (xb_node_get_element (req), "hardware") == 0)
+	if (req->kind == FU_ENGINE_REQUIREMENT_KIND_HARDWARE)
 		return fu_engine_check_requirement_hardware (self, req, error);
 
 	/* not supported */
@@ -1283,43 +2006,90 @@ fu_engine_check_requirement (FuEngine *self, XbNode *req, FuDevice *device, GErr
 		     FWUPD_ERROR,
 		     FWUPD_ERROR_NOT_SUPPORTED,
 		     "cannot handle requirement type %s",
-		     xb_node_get_element (req));
+		     req->element);
 	return FALSE;
 }
 
-gboolean
-fu_engine_check_requirements (FuEngine *self, FuInstallTask *task,
-			      FwupdInstallFlags flags, GError **error)
+/* returns an empty array if the component has no requirements */
+static GPtrArray *
+fu_engine_get_requirements (FuEngine *self, XbNode *component, gboolean cache, GError **error)
 {
-	FuDevice *device = fu_install_task_get_device (task);
+	GPtrArray *reqs;
 	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) nodes = NULL;
+
+	/* parsed already */
+	reqs = g_hash_table_lookup (self->requirements_cache, component);
+	if (reqs != NULL)
+		return g_ptr_array_ref (reqs);
+
+	reqs = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_requirement_free);
+	nodes = xb_node_query (component, "requires/*", 0, &error_local);
+	if (nodes == NULL) {
+		if (!g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) &&
+		    !g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			g_ptr_array_unref (reqs);
+			return NULL;
+		}
+	} else {
+		for (guint i = 0; i < nodes->len; i++) {
+			XbNode *n = g_ptr_array_index (nodes, i);
+			g_ptr_array_add (reqs, fu_engine_requirement_new (n));
+		}
+	}
+
+	/* the node holds a reference to the silo, so only do this for the
+	 * metadata and not for things like a user-supplied archive */
+	if (cache) {
+		g_hash_table_insert (self->requirements_cache,
+				     g_object_ref (component),
+				     g_ptr_array_ref (reqs));
+	}
+	return reqs;
+}
+
+static gboolean
+fu_engine_check_requirements_full (FuEngine *self, FuInstallTask *task,
+				   FwupdInstallFlags flags, gboolean cache,
+				   GError **error)
+{
+	FuDevice *device = fu_install_task_get_device (task);
 	g_autoptr(GPtrArray) reqs = NULL;
 
 	/* all install task checks require a device */
 	if (device != NULL) {
+		if (!fu_engine_ensure_device_setup (self, device, error))
+			return FALSE;
 		if (!fu_install_task_check_requirements (task, flags, error))
 			return FALSE;
 	}
 
 	/* do engine checks */
-	reqs = xb_node_query (fu_install_task_get_component (task),
-			      "requires/*", 0, &error_local);
-	if (reqs == NULL) {
-		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
-			return TRUE;
-		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
-			return TRUE;
-		g_propagate_error (error, g_steal_pointer (&error_local));
+	reqs = fu_engine_get_requirements (self, fu_install_task_get_component (task),
+					   cache, error);
+	if (reqs == NULL)
 		return FALSE;
-	}
 	for (guint i = 0; i < reqs->len; i++) {
-		XbNode *req = g_ptr_array_index (reqs, i);
+		FuEngineRequirement *req = g_ptr_array_index (reqs, i);
 		if (!fu_engine_check_requirement (self, req, device, error))
 			return FALSE;
 	}
 	return TRUE;
 }
 
+gboolean
+fu_engine_check_requirements (FuEngine *self, FuInstallTask *task,
+			      FwupdInstallFlags flags, GError **error)
+{
+	gint64 start = fu_timeline_begin ();
+	gboolean ret = fu_engine_check_requirements_full (self, task, flags, FALSE, error);
+	fu_timeline_add ("engine", "check-requirements",
+			 xb_node_query_text (fu_install_task_get_component (task), "id", NULL),
+			 start);
+	return ret;
+}
+
 void
 fu_engine_idle_reset (FuEngine *self)
 {
@@ -1405,7 +2175,10 @@ fu_engine_composite_prepare (FuEngine *self, GPtrArray *devices, GError **error)
 	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
 	for (guint j = 0; j < plugins->len; j++) {
 		FuPlugin *plugin_tmp = g_ptr_array_index (plugins, j);
-		if (!fu_plugin_runner_composite_prepare (plugin_tmp, devices, error))
+		gint64 start = fu_timeline_begin ();
+		gboolean ret = fu_plugin_runner_composite_prepare (plugin_tmp, devices, error);
+		fu_timeline_add ("engine", "composite-prepare", fu_plugin_get_name (plugin_tmp), start);
+		if (!ret)
 			return FALSE;
 	}
 	return TRUE;
@@ -1427,74 +2200,454 @@ fu_engine_composite_cleanup (FuEngine *self, GPtrArray *devices, GError **error)
 	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
 	for (guint j = 0; j < plugins->len; j++) {
 		FuPlugin *plugin_tmp = g_ptr_array_index (plugins, j);
-		if (!fu_plugin_runner_composite_cleanup (plugin_tmp, devices, error))
+		gint64 start = fu_timeline_begin ();
+		gboolean ret = fu_plugin_runner_composite_cleanup (plugin_tmp, devices, error);
+		fu_timeline_add ("engine", "composite-cleanup", fu_plugin_get_name (plugin_tmp), start);
+		if (!ret)
 			return FALSE;
 	}
 	return TRUE;
 }
 
-/**
- * fu_engine_install_tasks:
- * @self: A #FuEngine
- * @install_tasks: (element-type FuInstallTask): A #FuDevice
- * @blob_cab: The #GBytes of the .cab file
- * @flags: The #FwupdInstallFlags, e.g. %FWUPD_DEVICE_FLAG_UPDATABLE
- * @error: A #GError, or %NULL
- *
- * Installs a specific firmware file on one or more install tasks.
- *
- * By this point all the requirements and tests should have been done in
- * fu_engine_check_requirements() so this should not fail before running
- * the plugin loader.
- *
- * Returns: %TRUE for success
- **/
-gboolean
-fu_engine_install_tasks (FuEngine *self,
-			 GPtrArray *install_tasks,
-			 GBytes *blob_cab,
-			 FwupdInstallFlags flags,
-			 GError **error)
-{
-	g_autoptr(FuIdleLocker) locker = NULL;
-	g_autoptr(GPtrArray) devices = NULL;
-	g_autoptr(GPtrArray) devices_new = NULL;
+typedef struct {
+	FuEngine		*self;
+	GPtrArray		*tasks;		/* of FuInstallTask, in install order */
+	GBytes			*blob_cab;
+	FwupdInstallFlags	 flags;
+	GError			*error;
+	guint			 idx;		/* task being installed, atomic */
+	guint			 idx_last;	/* as last emitted */
+	guint			 progress_last;
+	FwupdStatus		 status_last;
+} FuEngineInstallGroup;
 
-	/* do not allow auto-shutdown during this time */
-	locker = fu_idle_locker_new (self->idle, "performing update");
-	g_assert (locker != NULL);
+typedef struct {
+	GMainLoop		*loop;
+	GPtrArray		*groups;	/* of FuEngineInstallGroup */
+	guint			 pending;
+} FuEngineInstallParallelHelper;
 
-	/* notify the plugins about the composite action */
-	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	for (guint i = 0; i < install_tasks->len; i++) {
-		FuInstallTask *task = g_ptr_array_index (install_tasks, i);
-		g_debug ("composite update %u: %s", i + 1,
-			 fu_device_get_id (fu_install_task_get_device (task)));
-		g_ptr_array_add (devices, g_object_ref (fu_install_task_get_device (task)));
+static void
+fu_engine_install_group_free (FuEngineInstallGroup *group)
+{
+	if (group->error != NULL)
+		g_error_free (group->error);
+	g_ptr_array_unref (group->tasks);
+	g_free (group);
+}
+
+/* waiting for replug uses the default main context, so only one device in
+ * the whole transaction can do this at any one time -- plugins are expected
+ * to set a remove delay on any device that re-enumerates */
+static gboolean
+fu_engine_install_group_can_parallel (FuEngineInstallGroup *group)
+{
+	for (guint i = 0; i < group->tasks->len; i++) {
+		FuInstallTask *task = g_ptr_array_index (group->tasks, i);
+		FuDevice *device = fu_install_task_get_device (task);
+		if (fu_device_get_remove_delay (device) > 0)
+			return FALSE;
+		if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG))
+			return FALSE;
 	}
-	if (!fu_engine_composite_prepare (self, devices, error)) {
-		g_prefix_error (error, "failed to prepare composite action: ");
-		return FALSE;
+	return TRUE;
+}
+
+static gboolean
+fu_engine_install_group_run (FuEngineInstallGroup *group, GError **error)
+{
+	for (guint i = 0; i < group->tasks->len; i++) {
+		FuInstallTask *task = g_ptr_array_index (group->tasks, i);
+		g_atomic_int_set (&group->idx, i);
+		if (!fu_engine_install (group->self, task, group->blob_cab,
+					group->flags, error))
+			return FALSE;
 	}
+	g_atomic_int_set (&group->idx, group->tasks->len);
+	return TRUE;
+}
 
-	/* all authenticated, so install all the things */
-	for (guint i = 0; i < install_tasks->len; i++) {
-		FuInstallTask *task = g_ptr_array_index (install_tasks, i);
-		if (!fu_engine_install (self, task, blob_cab, flags, error)) {
-			g_autoptr(GError) error_local = NULL;
-			if (!fu_engine_composite_cleanup (self, devices, &error_local)) {
-				g_warning ("failed to cleanup failed composite action: %s",
-					   error_local->message);
+static gboolean
+fu_engine_install_group_done_cb (gpointer user_data)
+{
+	FuEngineInstallParallelHelper *helper = (FuEngineInstallParallelHelper *) user_data;
+	if (--helper->pending == 0)
+		g_main_loop_quit (helper->loop);
+	return G_SOURCE_REMOVE;
+}
+
+typedef struct {
+	FuEngineInstallGroup		*group;
+	FuEngineInstallParallelHelper	*helper;
+} FuEngineInstallThreadHelper;
+
+static void
+fu_engine_install_group_thread_cb (gpointer user_data, GCancellable *cancellable)
+{
+	FuEngineInstallThreadHelper *thread_helper = (FuEngineInstallThreadHelper *) user_data;
+	FuEngineInstallGroup *group = thread_helper->group;
+	fu_engine_install_group_run (group, &group->error);
+	g_idle_add (fu_engine_install_group_done_cb, thread_helper->helper);
+	g_free (thread_helper);
+}
+
+/* runs in the main thread on behalf of all the workers */
+static gboolean
+fu_engine_install_parallel_progress_cb (gpointer user_data)
+{
+	FuEngineInstallParallelHelper *helper = (FuEngineInstallParallelHelper *) user_data;
+	FuEngine *self = NULL;
+	guint64 done = 0;
+	guint64 total = 0;
+
+	for (guint i = 0; i < helper->groups->len; i++) {
+		FuEngineInstallGroup *group = g_ptr_array_index (helper->groups, i);
+		guint idx = (guint) g_atomic_int_get (&group->idx);
+		self = group->self;
+		total += (guint64) group->tasks->len * 100;
+		done += (guint64) idx * 100;
+		if (idx < group->tasks->len) {
+			FuInstallTask *task = g_ptr_array_index (group->tasks, idx);
+			FuDevice *device = fu_install_task_get_device (task);
+			guint progress = fu_device_get_progress (device);
+			FwupdStatus status = fu_device_get_status (device);
+			done += progress;
+
+			/* coalesce all the updates since the last poll */
+			if (idx != group->idx_last ||
+			    progress != group->progress_last ||
+			    status != group->status_last) {
+				group->idx_last = idx;
+				group->progress_last = progress;
+				group->status_last = status;
+				fu_engine_emit_device_changed (self, device);
 			}
-			return FALSE;
 		}
 	}
+	if (self != NULL && total > 0) {
+		fu_engine_set_status (self, FWUPD_STATUS_DEVICE_WRITE);
+		fu_engine_set_percentage (self, (guint) ((done * 100) / total));
+	}
+	return G_SOURCE_CONTINUE;
+}
 
-	/* set all the device statuses back to unknown */
+static gboolean
+fu_engine_install_tasks_serial (FuEngine *self,
+				GPtrArray *install_tasks,
+				GBytes *blob_cab,
+				FwupdInstallFlags flags,
+				GError **error)
+{
 	for (guint i = 0; i < install_tasks->len; i++) {
 		FuInstallTask *task = g_ptr_array_index (install_tasks, i);
-		FuDevice *device = fu_install_task_get_device (task);
-		fu_device_set_status (device, FWUPD_STATUS_UNKNOWN);
+		if (!fu_engine_install (self, task, blob_cab, flags, error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* returns the shares, which must outlive the device writes, and adds the
+ * first task using each share to @tasks_first */
+static GHashTable *
+fu_engine_install_tasks_share_firmware (GPtrArray *install_tasks, GPtrArray *tasks_first)
+{
+	GHashTable *shares = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						    (GDestroyNotify) fu_device_firmware_share_free);
+	g_autoptr(GHashTable) first = g_hash_table_new_full (g_str_hash, g_str_equal,
+							     g_free, NULL);
+
+	for (guint i = 0; i < install_tasks->len; i++) {
+		FuInstallTask *task = g_ptr_array_index (install_tasks, i);
+		FuDevice *device = fu_install_task_get_device (task);
+		FuDevice *device_first;
+		FuDeviceFirmwareShare *share;
+		g_autofree gchar *guids = fu_device_get_guids_as_str (device);
+		g_autofree gchar *key = NULL;
+
+		key = g_strdup_printf ("%s;%s;%s;%p",
+				       fu_device_get_plugin (device),
+				       G_OBJECT_TYPE_NAME (device),
+				       guids,
+				       fu_install_task_get_component (task));
+		device_first = g_hash_table_lookup (first, key);
+		if (device_first == NULL) {
+			share = fu_device_firmware_share_new ();
+			fu_device_set_firmware_share (device, share);
+			g_hash_table_insert (shares, g_strdup (key), share);
+			g_hash_table_insert (first, g_steal_pointer (&key), device);
+			g_ptr_array_add (tasks_first, task);
+			continue;
+		}
+		share = g_hash_table_lookup (shares, key);
+		g_debug ("%s shares firmware with %s",
+			 fu_device_get_id (device),
+			 fu_device_get_id (device_first));
+		fu_device_set_firmware_share (device, share);
+	}
+	return shares;
+}
+
+/* returns the blob that will be written, or %NULL if not known yet */
+static GBytes *
+fu_engine_install_task_get_blob (FuInstallTask *task)
+{
+	XbNode *component = fu_install_task_get_component (task);
+	FuDevice *device = fu_install_task_get_device (task);
+	g_autoptr(XbNode) rel = NULL;
+
+	/* several blobs, or built at install time */
+	if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_INSTALL_ALL_RELEASES))
+		return NULL;
+	if (g_object_get_data (G_OBJECT (component), "fwupd::BuilderScript") != NULL)
+		return NULL;
+	rel = xb_node_query_first (component, "releases/release", NULL);
+	if (rel == NULL)
+		return NULL;
+	return xb_node_get_data (rel, "fwupd::FirmwareBlob");
+}
+
+typedef struct {
+	FuDevice		*device;
+	GBytes			*blob_fw;
+	FwupdInstallFlags	 flags;
+} FuEnginePreloadHelper;
+
+static void
+fu_engine_install_tasks_preload_cb (gpointer user_data, GCancellable *cancellable)
+{
+	FuEnginePreloadHelper *helper = (FuEnginePreloadHelper *) user_data;
+	g_autoptr(GError) error_local = NULL;
+
+	/* not fatal, as the firmware may only be valid once detached */
+	if (!fu_device_preload_firmware (helper->device, helper->blob_fw,
+					 helper->flags, &error_local)) {
+		g_debug ("failed to prepare firmware for %s ahead of time: %s",
+			 fu_device_get_id (helper->device),
+			 error_local->message);
+	}
+}
+
+/* prepare the firmware for all the devices before the first one is
+ * detached, so each write can use it straight away */
+static void
+fu_engine_install_tasks_preload (FuEngine *self,
+				 GPtrArray *tasks_first,
+				 FwupdInstallFlags flags)
+{
+	FuWorkerPool *pool = NULL;
+	g_autoptr(FuWorkerBatch) batch = NULL;
+	g_autoptr(GArray) helpers = NULL;
+
+	helpers = g_array_sized_new (FALSE, TRUE, sizeof (FuEnginePreloadHelper),
+				     tasks_first->len);
+	for (guint i = 0; i < tasks_first->len; i++) {
+		FuInstallTask *task = g_ptr_array_index (tasks_first, i);
+		FuDevice *device = fu_install_task_get_device (task);
+		FuEnginePreloadHelper helper = {
+			.device = device,
+			.blob_fw = fu_engine_install_task_get_blob (task),
+			.flags = flags,
+		};
+
+		/* the device may need to be set up first */
+		if (helper.blob_fw == NULL || fu_device_get_setup_deferred (device))
+			continue;
+		g_array_append_val (helpers, helper);
+	}
+	if (helpers->len == 0)
+		return;
+
+	/* only use worker threads if the devices can be written in parallel */
+	if (helpers->len > 1 && fu_config_get_parallel_install (self->config))
+		pool = self->worker_pool;
+	batch = fu_worker_batch_new (pool, FU_WORKER_PRIORITY_INSTALL, NULL);
+	for (guint i = 0; i < helpers->len; i++) {
+		fu_worker_batch_add (batch, fu_engine_install_tasks_preload_cb,
+				     &g_array_index (helpers, FuEnginePreloadHelper, i));
+	}
+	fu_worker_batch_wait (batch);
+}
+
+static gboolean
+fu_engine_install_tasks_parallel (FuEngine *self,
+				  GPtrArray *install_tasks,
+				  GBytes *blob_cab,
+				  FwupdInstallFlags flags,
+				  GError **error)
+{
+	guint progress_id;
+	g_autoptr(FuWorkerBatch) batch = NULL;
+	g_autoptr(GHashTable) groups_by_device = g_hash_table_new (g_direct_hash, g_direct_equal);
+	g_autoptr(GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+	g_autoptr(GPtrArray) groups = NULL;
+	g_autoptr(GPtrArray) groups_parallel = g_ptr_array_new ();
+	g_autoptr(GPtrArray) groups_serial = g_ptr_array_new ();
+	FuEngineInstallParallelHelper helper = {
+		.loop = loop,
+		.groups = groups_parallel,
+		.pending = 0,
+	};
+
+	/* group by physical device, keeping the requested order */
+	groups = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_install_group_free);
+	for (guint i = 0; i < install_tasks->len; i++) {
+		FuInstallTask *task = g_ptr_array_index (install_tasks, i);
+		FuDevice *device = fu_install_task_get_device (task);
+		FuDevice *device_group = fu_engine_get_group_device (device);
+		FuEngineInstallGroup *group = g_hash_table_lookup (groups_by_device, device_group);
+		if (group == NULL) {
+			group = g_new0 (FuEngineInstallGroup, 1);
+			group->self = self;
+			group->tasks = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+			group->blob_cab = blob_cab;
+			group->flags = flags;
+			g_hash_table_insert (groups_by_device, device_group, group);
+			g_ptr_array_add (groups, group);
+		}
+		g_ptr_array_add (group->tasks, g_object_ref (task));
+	}
+
+	/* split out the groups that need the main context */
+	for (guint i = 0; i < groups->len; i++) {
+		FuEngineInstallGroup *group = g_ptr_array_index (groups, i);
+		if (fu_engine_install_group_can_parallel (group))
+			g_ptr_array_add (groups_parallel, group);
+		else
+			g_ptr_array_add (groups_serial, group);
+	}
+	if (groups_parallel->len < 2) {
+		g_debug ("only %u independent device groups, installing serially",
+			 groups_parallel->len);
+		return fu_engine_install_tasks_serial (self, install_tasks,
+						       blob_cab, flags, error);
+	}
+
+	/* the workers only store the progress, and the main thread polls it */
+	g_debug ("installing %u device groups in parallel", groups_parallel->len);
+	self->workers_running = TRUE;
+	batch = fu_worker_batch_new (self->worker_pool, FU_WORKER_PRIORITY_INSTALL, NULL);
+	for (guint i = 0; i < groups_parallel->len; i++) {
+		FuEngineInstallGroup *group = g_ptr_array_index (groups_parallel, i);
+		for (guint j = 0; j < group->tasks->len; j++) {
+			FuInstallTask *task = g_ptr_array_index (group->tasks, j);
+			fu_device_defer_progress_notify (fu_install_task_get_device (task));
+		}
+	}
+	for (guint i = 0; i < groups_parallel->len; i++) {
+		FuEngineInstallGroup *group = g_ptr_array_index (groups_parallel, i);
+		FuEngineInstallThreadHelper *thread_helper = g_new0 (FuEngineInstallThreadHelper, 1);
+		thread_helper->group = group;
+		thread_helper->helper = &helper;
+		helper.pending++;
+		fu_worker_batch_add (batch, fu_engine_install_group_thread_cb, thread_helper);
+	}
+	progress_id = g_timeout_add (100, fu_engine_install_parallel_progress_cb, &helper);
+	g_main_loop_run (loop);
+	g_source_remove (progress_id);
+	fu_worker_batch_wait (batch);
+	fu_engine_install_parallel_progress_cb (&helper);
+	for (guint i = 0; i < groups_parallel->len; i++) {
+		FuEngineInstallGroup *group = g_ptr_array_index (groups_parallel, i);
+		for (guint j = 0; j < group->tasks->len; j++) {
+			FuInstallTask *task = g_ptr_array_index (group->tasks, j);
+			fu_device_flush_progress_notify (fu_install_task_get_device (task));
+		}
+	}
+	self->workers_running = FALSE;
+
+	/* return the first error, but show all of them */
+	for (guint i = 0; i < groups_parallel->len; i++) {
+		FuEngineInstallGroup *group = g_ptr_array_index (groups_parallel, i);
+		if (group->error == NULL)
+			continue;
+		if (error != NULL && *error == NULL) {
+			g_propagate_error (error, g_steal_pointer (&group->error));
+			continue;
+		}
+		g_warning ("failed to install in parallel: %s", group->error->message);
+	}
+	if (error != NULL && *error != NULL)
+		return FALSE;
+
+	/* the devices that may replug are done one at a time */
+	for (guint i = 0; i < groups_serial->len; i++) {
+		FuEngineInstallGroup *group = g_ptr_array_index (groups_serial, i);
+		if (!fu_engine_install_group_run (group, error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_engine_install_tasks_locked (FuEngine *self,
+				GPtrArray *install_tasks,
+				GBytes *blob_cab,
+				FwupdInstallFlags flags,
+				GError **error)
+{
+	gboolean ret;
+	g_autoptr(GHashTable) shares = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GPtrArray) devices_new = NULL;
+	g_autoptr(GPtrArray) tasks_first = g_ptr_array_new ();
+
+	/* notify the plugins about the composite action */
+	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < install_tasks->len; i++) {
+		FuInstallTask *task = g_ptr_array_index (install_tasks, i);
+		g_debug ("composite update %u: %s", i + 1,
+			 fu_device_get_id (fu_install_task_get_device (task)));
+		g_ptr_array_add (devices, g_object_ref (fu_install_task_get_device (task)));
+	}
+	if (!fu_engine_composite_prepare (self, devices, error)) {
+		g_prefix_error (error, "failed to prepare composite action: ");
+		return FALSE;
+	}
+
+	/* the composite prepare may have reset a parent with many children */
+	if (!fu_device_list_wait_for_replug_all (self->device_list, devices, error)) {
+		g_prefix_error (error, "failed to wait for composite prepare replug: ");
+		return FALSE;
+	}
+
+	/* identical devices getting the same release only prepare it once, and
+	 * all the firmware is prepared before the first write */
+	shares = fu_engine_install_tasks_share_firmware (install_tasks, tasks_first);
+	fu_engine_install_tasks_preload (self, tasks_first, flags);
+
+	/* all authenticated, so install all the things */
+	if (fu_config_get_parallel_install (self->config)) {
+		ret = fu_engine_install_tasks_parallel (self, install_tasks,
+							blob_cab, flags, error);
+	} else {
+		ret = fu_engine_install_tasks_serial (self, install_tasks,
+						      blob_cab, flags, error);
+	}
+	for (guint i = 0; i < install_tasks->len; i++) {
+		FuInstallTask *task = g_ptr_array_index (install_tasks, i);
+		fu_device_set_firmware_share (fu_install_task_get_device (task), NULL);
+	}
+
+	/* wait for any devices still re-enumerating at the same time */
+	if (ret) {
+		ret = fu_device_list_wait_for_replug_all (self->device_list, devices, error);
+		if (!ret)
+			g_prefix_error (error, "failed to wait for composite replug: ");
+	}
+	if (!ret) {
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_engine_composite_cleanup (self, devices, &error_local)) {
+			g_warning ("failed to cleanup failed composite action: %s",
+				   error_local->message);
+		}
+		return FALSE;
+	}
+
+	/* set all the device statuses back to unknown */
+	for (guint i = 0; i < install_tasks->len; i++) {
+		FuInstallTask *task = g_ptr_array_index (install_tasks, i);
+		FuDevice *device = fu_install_task_get_device (task);
+		fu_device_set_status (device, FWUPD_STATUS_UNKNOWN);
 	}
 
 	/* get a new list of devices in case they replugged */
@@ -1525,6 +2678,46 @@ fu_engine_install_tasks (FuEngine *self,
 	return TRUE;
 }
 
+/**
+ * fu_engine_install_tasks:
+ * @self: A #FuEngine
+ * @install_tasks: (element-type FuInstallTask): A #FuDevice
+ * @blob_cab: The #GBytes of the .cab file
+ * @flags: The #FwupdInstallFlags, e.g. %FWUPD_DEVICE_FLAG_UPDATABLE
+ * @error: A #GError, or %NULL
+ *
+ * Installs a specific firmware file on one or more install tasks.
+ *
+ * If ParallelInstall is set in the config file then tasks for devices that
+ * do not share a proxy or root device are installed at the same time using
+ * worker threads. Devices that may re-enumerate are installed afterwards,
+ * one at a time.
+ *
+ * By this point all the requirements and tests should have been done in
+ * fu_engine_check_requirements() so this should not fail before running
+ * the plugin loader.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_engine_install_tasks (FuEngine *self,
+			 GPtrArray *install_tasks,
+			 GBytes *blob_cab,
+			 FwupdInstallFlags flags,
+			 GError **error)
+{
+	gboolean ret;
+	g_autoptr(FuIdleLocker) locker = NULL;
+
+	/* do not allow auto-shutdown or background work during this time */
+	locker = fu_idle_locker_new (self->idle, "performing update");
+	g_assert (locker != NULL);
+	fu_idle_pause_tasks (self->idle);
+	ret = fu_engine_install_tasks_locked (self, install_tasks, blob_cab, flags, error);
+	fu_idle_resume_tasks (self->idle);
+	return ret;
+}
+
 static FwupdRelease *
 fu_engine_create_release_metadata (FuEngine *self, FuPlugin *plugin, GError **error)
 {
@@ -1740,7 +2933,30 @@ fu_engine_schedule_update (FuEngine *self,
 	return fu_engine_offline_setup (error);
 }
 
+/* include the recent log messages, so a failed update can be debugged from
+ * the uploaded report without having to reproduce it with --verbose */
 static gboolean
+fu_engine_history_modify_failed (FuEngine *self, FuDevice *device, GError **error)
+{
+	g_autofree gchar *debug_log = fu_debug_get_recorder ();
+	gboolean ret;
+
+	if (debug_log != NULL)
+		fu_device_set_metadata (device, FU_HISTORY_METADATA_DEBUG_LOG, debug_log);
+	ret = fu_history_modify_device (self->history, device, error);
+	fu_device_remove_metadata (device, FU_HISTORY_METADATA_DEBUG_LOG);
+	return ret;
+}
+
+static void
+fu_engine_metrics_add_install (FuEngine *self, gboolean success, gint64 duration)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->metrics_mutex);
+	self->install_cnt[success ? 1 : 0]++;
+	self->install_duration[success ? 1 : 0] += duration;
+}
+
+gboolean
 fu_engine_install_release (FuEngine *self,
 			   FuDevice *device_orig,
 			   XbNode *component,
@@ -1752,6 +2968,8 @@ fu_engine_install_release (FuEngine *self,
 	FwupdVersionFormat fmt;
 	GBytes *blob_fw;
 	const gchar *tmp;
+	gboolean ret;
+	gint64 start;
 	g_autofree gchar *version_orig = NULL;
 	g_autofree gchar *version_rel = NULL;
 	g_autoptr(FuDevice) device_tmp = NULL;
@@ -1816,7 +3034,10 @@ fu_engine_install_release (FuEngine *self,
 
 	/* install firmware blob */
 	version_orig = g_strdup (fu_device_get_version (device));
-	if (!fu_engine_install_blob (self, device, blob_fw2, flags, &error_local)) {
+	start = g_get_monotonic_time ();
+	ret = fu_engine_install_blob (self, device, blob_fw2, flags, &error_local);
+	fu_engine_metrics_add_install (self, ret, g_get_monotonic_time () - start);
+	if (!ret) {
 		fu_device_set_status (device, FWUPD_STATUS_IDLE);
 		if (g_error_matches (error_local,
 				     FWUPD_ERROR,
@@ -1836,7 +3057,7 @@ fu_engine_install_release (FuEngine *self,
 		}
 		fu_device_set_update_error (device, error_local->message);
 		if ((flags & FWUPD_INSTALL_FLAG_NO_HISTORY) == 0 &&
-		    !fu_history_modify_device (self->history, device, error)) {
+		    !fu_engine_history_modify_failed (self, device, error)) {
 			return FALSE;
 		}
 		g_propagate_error (error, g_steal_pointer (&error_local));
@@ -1875,7 +3096,7 @@ fu_engine_install_release (FuEngine *self,
 				       version_rel, fu_device_get_version (device));
 		fu_device_set_update_error (device, str);
 		if ((flags & FWUPD_INSTALL_FLAG_NO_HISTORY) == 0 &&
-		    !fu_history_modify_device (self->history, device, error))
+		    !fu_engine_history_modify_failed (self, device, error))
 			return FALSE;
 		/* success */
 		return TRUE;
@@ -1901,51 +3122,67 @@ fu_engine_install_release (FuEngine *self,
 	return TRUE;
 }
 
+/* each version is parsed once rather than for every comparison */
 typedef struct {
-	gboolean	 ret;
-	GError		**error;
-	FuEngine	*self;
-	FuDevice	*device;
-} FuEngineSortHelper;
+	FuCommonVersionKey	*key;
+	gpointer		 data;
+} FuEngineSortItem;
 
-static gint
-fu_engine_sort_release_versions_cb (gconstpointer a, gconstpointer b, gpointer user_data)
+static void
+fu_engine_sort_item_free (FuEngineSortItem *item)
 {
-	FuEngineSortHelper *helper = (FuEngineSortHelper *) user_data;
-	XbNode *na = *((XbNode **) a);
-	XbNode *nb = *((XbNode **) b);
-	g_autofree gchar *va = NULL;
-	g_autofree gchar *vb = NULL;
+	fu_common_version_key_free (item->key);
+	g_free (item);
+}
 
-	/* already failed */
-	if (!helper->ret)
-		return 0;
+static gint
+fu_engine_sort_items_cb (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	gboolean reverse = GPOINTER_TO_INT (user_data);
+	FuEngineSortItem *item_a = *((FuEngineSortItem **) a);
+	FuEngineSortItem *item_b = *((FuEngineSortItem **) b);
+	if (reverse)
+		return fu_common_version_key_compare (item_b->key, item_a->key);
+	return fu_common_version_key_compare (item_a->key, item_b->key);
+}
 
-	/* get the semver from the release */
-	va = fu_engine_get_release_version (helper->self, helper->device, na, helper->error);
-	if (va == NULL) {
-		g_prefix_error (helper->error, "failed to get release version: ");
-		return 0;
-	}
-	vb = fu_engine_get_release_version (helper->self, helper->device, nb, helper->error);
-	if (vb == NULL) {
-		g_prefix_error (helper->error, "failed to get release version: ");
-		return 0;
+/* sorts the array in place, using the data of each item */
+static void
+fu_engine_sort_items (GPtrArray *array, GPtrArray *items, gboolean reverse)
+{
+	g_ptr_array_sort_with_data (items, fu_engine_sort_items_cb,
+				    GINT_TO_POINTER (reverse));
+	for (guint i = 0; i < items->len; i++) {
+		FuEngineSortItem *item = g_ptr_array_index (items, i);
+		array->pdata[i] = item->data;
 	}
-	return fu_common_vercmp_full (va, vb, fu_device_get_version_format (helper->device));
 }
 
 static gboolean
 fu_engine_sort_releases (FuEngine *self, FuDevice *device, GPtrArray *rels, GError **error)
 {
-	FuEngineSortHelper helper = {
-		.ret = TRUE,
-		.self = self,
-		.device = device,
-		.error = error,
-	};
-	g_ptr_array_sort_with_data (rels, fu_engine_sort_release_versions_cb, &helper);
-	return helper.ret;
+	FwupdVersionFormat fmt = fu_device_get_version_format (device);
+	g_autoptr(GPtrArray) items = NULL;
+
+	items = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_sort_item_free);
+	for (guint i = 0; i < rels->len; i++) {
+		XbNode *rel = g_ptr_array_index (rels, i);
+		FuEngineSortItem *item;
+		g_autofree gchar *version = NULL;
+
+		/* get the semver from the release */
+		version = fu_engine_get_release_version (self, device, rel, error);
+		if (version == NULL) {
+			g_prefix_error (error, "failed to get release version: ");
+			return FALSE;
+		}
+		item = g_new0 (FuEngineSortItem, 1);
+		item->key = fu_common_version_key_new (version, fmt);
+		item->data = rel;
+		g_ptr_array_add (items, item);
+	}
+	fu_engine_sort_items (rels, items, FALSE);
+	return TRUE;
 }
 
 /**
@@ -2458,6 +3695,31 @@ fu_engine_firmware_read (FuEngine *self,
 	return fu_firmware_write (firmware, error);
 }
 
+static const gchar *install_timing_keys[] = {
+	FU_HISTORY_METADATA_DURATION_DETACH,
+	FU_HISTORY_METADATA_DURATION_WRITE,
+	FU_HISTORY_METADATA_DURATION_ATTACH,
+	FU_HISTORY_METADATA_DURATION_RELOAD,
+	FU_HISTORY_METADATA_BYTES_WRITTEN,
+	NULL
+};
+
+/* accumulated as a write may be required more than once */
+static void
+fu_engine_install_blob_add_timing (FuDevice *device, const gchar *key, guint value)
+{
+	guint value_old = fu_device_get_metadata_integer (device, key);
+	if (value_old != G_MAXUINT)
+		value += value_old;
+	fu_device_set_metadata_integer (device, key, value);
+}
+
+static void
+fu_engine_install_blob_add_duration (FuDevice *device, const gchar *key, GTimer *timer)
+{
+	fu_engine_install_blob_add_timing (device, key, g_timer_elapsed (timer, NULL) * 1000);
+}
+
 gboolean
 fu_engine_install_blob (FuEngine *self,
 			FuDevice *device,
@@ -2465,9 +3727,13 @@ fu_engine_install_blob (FuEngine *self,
 			FwupdInstallFlags flags,
 			GError **error)
 {
+	gboolean ret;
+	gint64 start;
 	guint retries = 0;
 	g_autofree gchar *device_id = NULL;
+	g_autoptr(FuDevice) device_new = NULL;
 	g_autoptr(GTimer) timer = g_timer_new ();
+	g_autoptr(GTimer) timer_phase = g_timer_new ();
 
 	/* test the firmware is not an empty blob */
 	if (g_bytes_get_size (blob_fw) == 0) {
@@ -2481,6 +3747,13 @@ fu_engine_install_blob (FuEngine *self,
 	/* mark this as modified even if we actually fail to do the update */
 	fu_device_set_modified (device, (guint64) g_get_real_time () / G_USEC_PER_SEC);
 
+	/* any device may look different after the update */
+	fu_engine_invalidate_coldplug_cache (self);
+
+	/* do not report the timings of a previous update */
+	for (guint i = 0; install_timing_keys[i] != NULL; i++)
+		fu_device_remove_metadata (device, install_timing_keys[i]);
+
 	/* plugins can set FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED to run again, but they
 	 * must return TRUE rather than an error */
 	device_id = g_strdup (fu_device_get_id (device));
@@ -2498,29 +3771,67 @@ fu_engine_install_blob (FuEngine *self,
 		fu_device_remove_flag (device, FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED);
 
 		/* signal to all the plugins the update is about to happen */
-		if (!fu_engine_update_prepare (self, flags, device_id, error))
+		start = fu_timeline_begin ();
+		ret = fu_engine_update_prepare (self, flags, device_id, error);
+		fu_timeline_add ("engine", "prepare", device_id, start);
+		if (!ret)
 			return FALSE;
 
 		/* detach to bootloader mode */
-		if (!fu_engine_update_detach (self, device_id, error))
+		g_timer_start (timer_phase);
+		start = fu_timeline_begin ();
+		ret = fu_engine_update_detach (self, device_id, error);
+		fu_timeline_add ("engine", "detach", device_id, start);
+		fu_engine_install_blob_add_duration (device, FU_HISTORY_METADATA_DURATION_DETACH, timer_phase);
+		if (!ret)
 			return FALSE;
 
 		/* install */
-		if (!fu_engine_update (self, device_id, blob_fw, flags, error))
+		g_timer_start (timer_phase);
+		start = fu_timeline_begin ();
+		ret = fu_engine_update (self, device_id, blob_fw, flags, error);
+		fu_timeline_add ("engine", "update", device_id, start);
+		fu_engine_install_blob_add_duration (device, FU_HISTORY_METADATA_DURATION_WRITE, timer_phase);
+		if (!ret)
 			return FALSE;
+		fu_engine_install_blob_add_timing (device, FU_HISTORY_METADATA_BYTES_WRITTEN,
+						   g_bytes_get_size (blob_fw));
 
 		/* attach into runtime mode */
-		if (!fu_engine_update_attach (self, device_id, error))
+		g_timer_start (timer_phase);
+		start = fu_timeline_begin ();
+		ret = fu_engine_update_attach (self, device_id, error);
+		fu_timeline_add ("engine", "attach", device_id, start);
+		fu_engine_install_blob_add_duration (device, FU_HISTORY_METADATA_DURATION_ATTACH, timer_phase);
+		if (!ret)
 			return FALSE;
 
 	} while (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED));
 
 	/* get the new version number */
-	if (!fu_engine_update_reload (self, device_id, error))
+	g_timer_start (timer_phase);
+	start = fu_timeline_begin ();
+	ret = fu_engine_update_reload (self, device_id, error);
+	fu_timeline_add ("engine", "reload", device_id, start);
+	fu_engine_install_blob_add_duration (device, FU_HISTORY_METADATA_DURATION_RELOAD, timer_phase);
+	if (!ret)
 		return FALSE;
 
+	/* the device may have been replaced, so copy the timings to the new object */
+	device_new = fu_device_list_get_by_id (self->device_list, device_id, NULL);
+	if (device_new != NULL && device_new != device) {
+		for (guint i = 0; install_timing_keys[i] != NULL; i++) {
+			const gchar *tmp = fu_device_get_metadata (device, install_timing_keys[i]);
+			if (tmp != NULL)
+				fu_device_set_metadata (device_new, install_timing_keys[i], tmp);
+		}
+	}
+
 	/* signal to all the plugins the update has happened */
-	if (!fu_engine_update_cleanup (self, flags, device_id, error))
+	start = fu_timeline_begin ();
+	ret = fu_engine_update_cleanup (self, flags, device_id, error);
+	fu_timeline_add ("engine", "cleanup", device_id, start);
+	if (!ret)
 		return FALSE;
 
 	/* make the UI update */
@@ -2591,7 +3902,12 @@ fu_engine_set_silo (FuEngine *self, XbSilo *silo)
 {
 	g_return_if_fail (FU_IS_ENGINE (self));
 	g_return_if_fail (XB_IS_SILO (silo));
-	g_set_object (&self->silo, silo);
+	g_hash_table_remove_all (self->remote_silos);
+	g_hash_table_remove_all (self->requirements_cache);
+	g_hash_table_remove_all (self->component_checksums);
+	g_clear_pointer (&self->component_index, g_hash_table_unref);
+	g_ptr_array_set_size (self->silos, 0);
+	g_ptr_array_add (self->silos, g_object_ref (silo));
 }
 
 static gboolean
@@ -2692,9 +4008,10 @@ fu_engine_ensure_device_supported (FuEngine *self, FuDevice *device)
 	g_autoptr(GPtrArray) releases = NULL;
 
 	/* get all releases that pass the requirements */
-	releases = fu_engine_get_releases_for_device (self,
-						      device,
-						      &error);
+	releases = fu_engine_get_releases_for_device_full (self,
+							   device,
+							   TRUE,
+							   &error);
 	if (releases == NULL) {
 		if (!g_error_matches (error,
 				      FWUPD_ERROR,
@@ -2855,13 +4172,32 @@ fu_engine_md_refresh_device_from_component (FuEngine *self, FuDevice *device, Xb
 		fu_engine_md_refresh_device_verfmt (self, device, component);
 }
 
+static gboolean
+fu_engine_device_has_guid_in_set (FuDevice *device, GHashTable *guids)
+{
+	GPtrArray *device_guids = fu_device_get_guids (device);
+	for (guint i = 0; i < device_guids->len; i++) {
+		const gchar *guid = g_ptr_array_index (device_guids, i);
+		if (g_hash_table_contains (guids, guid))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* if @guids is set then only devices with a GUID provided by a component
+ * that was added, removed or changed are refreshed */
 static void
-fu_engine_md_refresh_devices (FuEngine *self)
+fu_engine_md_refresh_devices (FuEngine *self, GHashTable *guids)
 {
 	g_autoptr(GPtrArray) devices = fu_device_list_get_all (self->device_list);
 	for (guint i = 0; i < devices->len; i++) {
 		FuDevice *device = g_ptr_array_index (devices, i);
-		g_autoptr(XbNode) component = fu_engine_get_component_by_guids (self, device);
+		g_autoptr(XbNode) component = NULL;
+
+		/* metadata for this device is unchanged */
+		if (guids != NULL && !fu_engine_device_has_guid_in_set (device, guids))
+			continue;
+		component = fu_engine_get_component_by_guids (self, device);
 
 		/* set or clear the SUPPORTED flag */
 		fu_engine_ensure_device_supported (self, device);
@@ -2871,70 +4207,175 @@ fu_engine_md_refresh_devices (FuEngine *self)
 	}
 }
 
+/* runs the setup skipped during coldplug, e.g. for setup-on-demand devices */
 static gboolean
-fu_engine_load_metadata_store (FuEngine *self, FuEngineLoadFlags flags, GError **error)
+fu_engine_ensure_device_setup (FuEngine *self, FuDevice *device, GError **error)
 {
-	GPtrArray *remotes;
-	XbBuilderCompileFlags compile_flags = XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID;
-	g_autofree gchar *cachedirpkg = NULL;
-	g_autofree gchar *xmlbfn = NULL;
-	g_autoptr(GFile) xmlb = NULL;
-	g_autoptr(GPtrArray) components = NULL;
-	g_autoptr(XbBuilder) builder = xb_builder_new ();
-
-	/* clear existing silo */
-	g_clear_object (&self->silo);
+	g_autoptr(XbNode) component = NULL;
 
-	/* verbose profiling */
-	if (g_getenv ("FWUPD_VERBOSE") != NULL) {
-		xb_builder_set_profile_flags (builder,
-					      XB_SILO_PROFILE_FLAG_XPATH |
-					      XB_SILO_PROFILE_FLAG_DEBUG);
+	if (!fu_device_get_setup_deferred (device))
+		return TRUE;
+	if (!fu_device_ensure_setup (device, error)) {
+		g_prefix_error (error, "failed to set up %s: ",
+				fu_device_get_id (device));
+		return FALSE;
 	}
 
-	/* load each enabled metadata file */
-	remotes = fu_remote_list_get_all (self->remote_list);
-	for (guint i = 0; i < remotes->len; i++) {
-		const gchar *path = NULL;
-		g_autoptr(GError) error_local = NULL;
-		g_autoptr(GFile) file = NULL;
-		g_autoptr(XbBuilderFixup) fixup = NULL;
-		g_autoptr(XbBuilderNode) custom = NULL;
-		g_autoptr(XbBuilderSource) source = xb_builder_source_new ();
+	/* the GUIDs and version may have changed */
+	component = fu_engine_get_component_by_guids (self, device);
+	fu_engine_ensure_device_supported (self, device);
+	fu_engine_md_refresh_device_from_component (self, device, component);
+	fu_engine_emit_device_changed (self, device);
+	return TRUE;
+}
 
-		FwupdRemote *remote = g_ptr_array_index (remotes, i);
-		if (!fwupd_remote_get_enabled (remote)) {
-			g_debug ("remote %s not enabled, so skipping",
-				 fwupd_remote_get_id (remote));
-			continue;
-		}
-		path = fwupd_remote_get_filename_cache (remote);
-		if (!g_file_test (path, G_FILE_TEST_EXISTS)) {
-			g_debug ("no %s, so skipping", path);
-			continue;
-		}
+static gboolean
+fu_engine_setup_deferred_cb (gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (user_data);
+	g_autoptr(GPtrArray) devices = fu_device_list_get_snapshot (self->device_list);
 
-		/* generate all metadata on demand */
-		if (fwupd_remote_get_kind (remote) == FWUPD_REMOTE_KIND_DIRECTORY) {
-			g_debug ("building metadata for remote '%s'",
-				 fwupd_remote_get_id (remote));
-			if (!fu_engine_create_metadata (self, builder, remote, &error_local)) {
-				g_warning ("failed to generate remote %s: %s",
-					   fwupd_remote_get_id (remote),
-					   error_local->message);
-			}
+	/* only do one device each time so D-Bus requests are not delayed */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_SETUP_ON_DEMAND) ||
+		    !fu_device_get_setup_deferred (device))
 			continue;
-		}
+		if (!fu_engine_ensure_device_setup (self, device, &error_local))
+			g_warning ("%s", error_local->message);
+		return TRUE;
+	}
 
-		/* save the remote-id in the custom metadata space */
-		file = g_file_new_for_path (path);
-		if (!xb_builder_source_load_file (source, file,
-						  XB_BUILDER_SOURCE_FLAG_NONE,
-						  NULL, &error_local)) {
-			g_warning ("failed to load remote %s: %s",
-				   fwupd_remote_get_id (remote),
-				   error_local->message);
-			continue;
+	/* all done */
+	return FALSE;
+}
+
+static void
+fu_engine_setup_deferred_schedule (FuEngine *self)
+{
+	if (self->app_flags & FU_APP_FLAGS_NO_IDLE_SOURCES)
+		return;
+
+	/* auto-shutdown is not allowed until the devices are complete */
+	fu_idle_add_task (self->idle, "setup-deferred",
+			  fu_engine_setup_deferred_cb, self);
+}
+
+static gboolean
+fu_engine_host_security_idle_cb (gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (user_data);
+	g_autoptr(FuSecurityAttrs) attrs = NULL;
+
+	/* the next GetHostSecurityAttrs does not have to wait for the plugins */
+	attrs = fu_engine_get_host_security_attrs (self, NULL);
+	if (attrs != NULL)
+		fu_engine_get_host_security_id (self);
+	return FALSE;
+}
+
+static gboolean
+fu_engine_requirements_idle_cb (gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (user_data);
+	g_autoptr(GPtrArray) devices = fu_device_list_get_snapshot (self->device_list);
+
+	/* one device each time, filling the requirements cache for GetUpgrades */
+	while (self->idle_requirements_idx < devices->len) {
+		FuDevice *device = g_ptr_array_index (devices, self->idle_requirements_idx++);
+		g_autoptr(GPtrArray) releases = NULL;
+		if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_UPDATABLE))
+			continue;
+		releases = fu_engine_get_releases_for_device_full (self, device, TRUE, NULL);
+		return TRUE;
+	}
+
+	/* all done */
+	self->idle_requirements_idx = 0;
+	return FALSE;
+}
+
+static gboolean
+fu_engine_compact_idle_cb (gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (user_data);
+	fu_engine_compact (self);
+	return FALSE;
+}
+
+/* work done when there are no requests, so clients do not have to wait */
+static void
+fu_engine_schedule_idle_tasks (FuEngine *self)
+{
+	if (!self->loaded)
+		return;
+	if (self->app_flags & FU_APP_FLAGS_NO_IDLE_SOURCES)
+		return;
+	self->idle_requirements_idx = 0;
+	fu_idle_add_task (self->idle, "requirements",
+			  fu_engine_requirements_idle_cb, self);
+	fu_idle_add_task (self->idle, "compact",
+			  fu_engine_compact_idle_cb, self);
+}
+
+/* the checksum of the metadata contents, or %NULL for directory remotes
+ * where the metadata is generated from many files */
+static gchar *
+fu_engine_get_remote_checksum (FwupdRemote *remote, GError **error)
+{
+	g_autoptr(GBytes) blob = NULL;
+	if (fwupd_remote_get_kind (remote) == FWUPD_REMOTE_KIND_DIRECTORY)
+		return NULL;
+	blob = fu_common_get_contents_bytes (fwupd_remote_get_filename_cache (remote), error);
+	if (blob == NULL)
+		return NULL;
+	return g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob);
+}
+
+static XbSilo *
+fu_engine_load_metadata_remote (FuEngine *self, FwupdRemote *remote,
+				const gchar *checksum,
+				XbBuilderCompileFlags compile_flags,
+				GError **error)
+{
+	const gchar *path = fwupd_remote_get_filename_cache (remote);
+	g_autofree gchar *basename = NULL;
+	g_autofree gchar *cachedirpkg = NULL;
+	g_autofree gchar *xmlbfn = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GFile) xmlb = NULL;
+	g_autoptr(XbBuilder) builder = xb_builder_new ();
+	g_autoptr(XbBuilderFixup) fixup = NULL;
+	g_autoptr(XbBuilderNode) custom = NULL;
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new ();
+	g_autoptr(XbSilo) silo = NULL;
+
+	/* verbose profiling */
+	if (g_getenv ("FWUPD_VERBOSE") != NULL) {
+		xb_builder_set_profile_flags (builder,
+					      XB_SILO_PROFILE_FLAG_XPATH |
+					      XB_SILO_PROFILE_FLAG_DEBUG);
+	}
+
+	/* generate all metadata on demand */
+	if (fwupd_remote_get_kind (remote) == FWUPD_REMOTE_KIND_DIRECTORY) {
+		g_debug ("building metadata for remote '%s'",
+			 fwupd_remote_get_id (remote));
+		if (!fu_engine_create_metadata (self, builder, remote, error)) {
+			g_prefix_error (error, "failed to generate remote %s: ",
+					fwupd_remote_get_id (remote));
+			return NULL;
+		}
+	} else {
+		/* save the remote-id in the custom metadata space */
+		file = g_file_new_for_path (path);
+		if (!xb_builder_source_load_file (source, file,
+						  XB_BUILDER_SOURCE_FLAG_NONE,
+						  NULL, error)) {
+			g_prefix_error (error, "failed to load remote %s: ",
+					fwupd_remote_get_id (remote));
+			return NULL;
 		}
 
 		/* fix up any legacy installed files */
@@ -2955,46 +4396,292 @@ fu_engine_load_metadata_store (FuEngine *self, FuEngineLoadFlags flags, GError *
 					     "key", "fwupd::RemoteId",
 					     NULL);
 		xb_builder_source_set_info (source, custom);
-
-		/* we need to watch for changes? */
 		xb_builder_import_source (builder, source);
 	}
 
-	/* on a read-only filesystem don't care about the cache GUID */
-	if (flags & FU_ENGINE_LOAD_FLAG_READONLY_FS)
-		compile_flags |= XB_BUILDER_COMPILE_FLAG_IGNORE_GUID;
-
-	/* ensure silo is up to date */
+	/* the mmap'ed silo is only rebuilt if the metadata changed */
+	if (checksum != NULL)
+		xb_builder_append_guid (builder, checksum);
 	cachedirpkg = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
-	xmlbfn = g_build_filename (cachedirpkg, "metadata.xmlb", NULL);
+	basename = g_strdup_printf ("%s.xmlb", fwupd_remote_get_id (remote));
+	xmlbfn = g_build_filename (cachedirpkg, "metadata", basename, NULL);
 	xmlb = g_file_new_for_path (xmlbfn);
-	self->silo = xb_builder_ensure (builder, xmlb, compile_flags, NULL, error);
-	if (self->silo == NULL)
-		return FALSE;
-
-	/* print what we've got */
-	components = xb_silo_query (self->silo, "components/component", 0, NULL);
-	if (components != NULL)
-		g_debug ("%u components now in silo", components->len);
+	silo = xb_builder_ensure (builder, xmlb, compile_flags, NULL, error);
+	if (silo == NULL)
+		return NULL;
 
 	/* build the index */
-	if (!xb_silo_query_build_index (self->silo,
+	if (!xb_silo_query_build_index (silo,
 					"components/component/provides/firmware",
 					"type", error))
-		return FALSE;
-	if (!xb_silo_query_build_index (self->silo,
+		return NULL;
+	if (!xb_silo_query_build_index (silo,
 					"components/component/provides/firmware",
 					NULL, error))
-		return FALSE;
+		return NULL;
+
+	/* success */
+	return g_steal_pointer (&silo);
+}
+
+/* returns a checksum of every component in the silo, keyed by each GUID
+ * the component provides */
+static GHashTable *
+fu_engine_get_silo_component_checksums (XbSilo *silo)
+{
+	GHashTable *checksums = g_hash_table_new_full (g_str_hash, g_str_equal,
+						       g_free, g_free);
+	g_autoptr(GPtrArray) components = NULL;
+
+	components = xb_silo_query (silo, "components/component", 0, NULL);
+	if (components == NULL)
+		return checksums;
+	for (guint i = 0; i < components->len; i++) {
+		XbNode *component = g_ptr_array_index (components, i);
+		g_autofree gchar *checksum = NULL;
+		g_autofree gchar *xml = NULL;
+		g_autoptr(GPtrArray) provides = NULL;
+
+		provides = xb_node_query (component,
+					  "provides/firmware[@type='flashed']",
+					  0, NULL);
+		if (provides == NULL)
+			continue;
+		xml = xb_node_export (component, XB_NODE_EXPORT_FLAG_NONE, NULL);
+		if (xml == NULL)
+			continue;
+		checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, xml, -1);
+		for (guint j = 0; j < provides->len; j++) {
+			XbNode *n = g_ptr_array_index (provides, j);
+			const gchar *guid = xb_node_get_text (n);
+			const gchar *checksum_old;
+			if (guid == NULL)
+				continue;
+			checksum_old = g_hash_table_lookup (checksums, guid);
+			if (checksum_old != NULL) {
+				g_hash_table_insert (checksums, g_strdup (guid),
+						     g_strdup_printf ("%s,%s", checksum_old, checksum));
+			} else {
+				g_hash_table_insert (checksums, g_strdup (guid),
+						     g_strdup (checksum));
+			}
+		}
+	}
+	return checksums;
+}
+
+/* adds the per-GUID checksums of one silo to the checksums of all the
+ * silos, which are appended in remote order so priority changes show up */
+static void
+fu_engine_add_component_checksums (GHashTable *checksums, GHashTable *silo_checksums)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	g_hash_table_iter_init (&iter, silo_checksums);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		const gchar *checksum_old = g_hash_table_lookup (checksums, key);
+		if (checksum_old != NULL) {
+			g_hash_table_insert (checksums, g_strdup (key),
+					     g_strdup_printf ("%s;%s", checksum_old,
+							      (const gchar *) value));
+		} else {
+			g_hash_table_insert (checksums, g_strdup (key),
+					     g_strdup (value));
+		}
+	}
+}
+
+/* returns the GUIDs that were added, removed or are provided by a
+ * component that is now different */
+static GHashTable *
+fu_engine_get_component_guids_changed (GHashTable *checksums_old, GHashTable *checksums_new)
+{
+	GHashTable *guids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	GHashTableIter iter;
+	gpointer key, value;
+
+	g_hash_table_iter_init (&iter, checksums_new);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		const gchar *checksum_old = g_hash_table_lookup (checksums_old, key);
+		if (g_strcmp0 (checksum_old, value) != 0)
+			g_hash_table_add (guids, g_strdup (key));
+	}
+	g_hash_table_iter_init (&iter, checksums_old);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		if (!g_hash_table_contains (checksums_new, key))
+			g_hash_table_add (guids, g_strdup (key));
+	}
+	return guids;
+}
+
+static gboolean
+fu_engine_load_metadata_store (FuEngine *self, FuEngineLoadFlags flags, GError **error)
+{
+	GPtrArray *remotes;
+	XbBuilderCompileFlags compile_flags = XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID;
+	guint components_cnt = 0;
+	gint64 start = g_get_monotonic_time ();
+	g_autoptr(GHashTable) component_checksums = NULL;
+	g_autoptr(GHashTable) remote_silos = NULL;
+
+	/* on a read-only filesystem don't care about the cache GUID */
+	if (flags & FU_ENGINE_LOAD_FLAG_READONLY_FS)
+		compile_flags |= XB_BUILDER_COMPILE_FLAG_IGNORE_GUID;
+
+	/* any remote that is not re-added is removed or disabled */
+	remote_silos = g_steal_pointer (&self->remote_silos);
+	self->remote_silos = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						    (GDestroyNotify) fu_engine_remote_silo_free);
+	g_hash_table_remove_all (self->requirements_cache);
+	fu_engine_schedule_idle_tasks (self);
+	g_clear_pointer (&self->component_index, g_hash_table_unref);
+	g_ptr_array_set_size (self->silos, 0);
+	component_checksums = g_hash_table_new_full (g_str_hash, g_str_equal,
+						     g_free, g_free);
+
+	/* load each enabled metadata file */
+	remotes = fu_remote_list_get_all (self->remote_list);
+	for (guint i = 0; i < remotes->len; i++) {
+		FuEngineRemoteSilo *item;
+		const gchar *path = NULL;
+		const gchar *remote_id;
+		g_autofree gchar *checksum = NULL;
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GHashTable) silo_checksums = NULL;
+		g_autoptr(GPtrArray) components = NULL;
+		g_autoptr(XbSilo) silo = NULL;
+
+		FwupdRemote *remote = g_ptr_array_index (remotes, i);
+		remote_id = fwupd_remote_get_id (remote);
+		if (!fwupd_remote_get_enabled (remote)) {
+			g_debug ("remote %s not enabled, so skipping", remote_id);
+			continue;
+		}
+		path = fwupd_remote_get_filename_cache (remote);
+		if (!g_file_test (path, G_FILE_TEST_EXISTS)) {
+			g_debug ("no %s, so skipping", path);
+			continue;
+		}
+
+		/* reuse the silo if the metadata has not changed */
+		checksum = fu_engine_get_remote_checksum (remote, &error_local);
+		if (checksum == NULL && error_local != NULL) {
+			g_warning ("failed to load remote %s: %s",
+				   remote_id, error_local->message);
+			continue;
+		}
+		item = g_hash_table_lookup (remote_silos, remote_id);
+		if (item != NULL && checksum != NULL &&
+		    g_strcmp0 (item->checksum, checksum) == 0) {
+			g_debug ("metadata for %s unchanged", remote_id);
+			silo = g_object_ref (item->silo);
+			silo_checksums = g_hash_table_ref (item->component_checksums);
+		} else {
+			silo = fu_engine_load_metadata_remote (self, remote, checksum,
+							       compile_flags,
+							       &error_local);
+			if (silo == NULL) {
+				g_warning ("%s", error_local->message);
+				continue;
+			}
+		}
+
+		/* print what we've got */
+		components = xb_silo_query (silo, "components/component", 0, NULL);
+		if (components != NULL)
+			components_cnt += components->len;
+
+		/* only changed silos need to be checksummed again */
+		if (silo_checksums == NULL)
+			silo_checksums = fu_engine_get_silo_component_checksums (silo);
+		fu_engine_add_component_checksums (component_checksums, silo_checksums);
+
+		item = g_new0 (FuEngineRemoteSilo, 1);
+		item->checksum = g_steal_pointer (&checksum);
+		item->silo = g_object_ref (silo);
+		item->component_checksums = g_steal_pointer (&silo_checksums);
+		g_hash_table_insert (self->remote_silos, g_strdup (remote_id), item);
+		g_ptr_array_add (self->silos, g_steal_pointer (&silo));
+	}
+	g_debug ("%u components now in %u silos", components_cnt, self->silos->len);
+
+	/* work out which devices need the metadata refreshing */
+	if (self->component_guids_changed != NULL)
+		g_hash_table_unref (self->component_guids_changed);
+	self->component_guids_changed =
+		fu_engine_get_component_guids_changed (self->component_checksums,
+						       component_checksums);
+	g_debug ("%u GUIDs have changed metadata",
+		 g_hash_table_size (self->component_guids_changed));
+	g_hash_table_unref (self->component_checksums);
+	self->component_checksums = g_steal_pointer (&component_checksums);
+	self->metadata_duration = g_get_monotonic_time () - start;
 
 	/* success */
 	return TRUE;
 }
 
+static gboolean
+fu_engine_load_approved_firmware (FuEngine *self, GError **error)
+{
+	GPtrArray *checksums_config = fu_config_get_approved_firmware (self->config);
+	g_autoptr(GPtrArray) checksums = NULL;
+
+	checksums = fu_history_get_approved_firmware (self->history, error);
+	if (checksums == NULL)
+		return FALSE;
+	g_hash_table_remove_all (self->approved_firmware);
+	for (guint i = 0; i < checksums_config->len; i++)
+		fu_engine_add_approved_firmware (self, g_ptr_array_index (checksums_config, i));
+	for (guint i = 0; i < checksums->len; i++)
+		fu_engine_add_approved_firmware (self, g_ptr_array_index (checksums, i));
+	return TRUE;
+}
+
+/* plugins that are no longer blacklisted are only loaded on restart, as
+ * they would have to be coldplugged in the right order */
 static void
 fu_engine_config_changed_cb (FuConfig *config, FuEngine *self)
 {
+	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	/* the other limits are read each time they are used */
 	fu_idle_set_timeout (self->idle, fu_config_get_idle_timeout (config));
+	if (!fu_engine_load_approved_firmware (self, &error_local))
+		g_warning ("failed to reload approved firmware: %s", error_local->message);
+
+	/* stop using newly blacklisted plugins */
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		if (!fu_plugin_get_enabled (plugin))
+			continue;
+		if (!fu_engine_is_plugin_name_blacklisted (self, fu_plugin_get_name (plugin)))
+			continue;
+		g_debug ("disabling %s as now blacklisted", fu_plugin_get_name (plugin));
+		fu_plugin_set_enabled (plugin, FALSE);
+	}
+
+	/* remove the devices from disabled plugins or with blacklisted GUIDs */
+	devices = fu_device_list_get_all (self->device_list);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		FuPlugin *plugin = NULL;
+		if (fu_device_get_plugin (device) != NULL) {
+			plugin = fu_plugin_list_find_by_name (self->plugin_list,
+							      fu_device_get_plugin (device),
+							      NULL);
+		}
+		if ((plugin != NULL && !fu_plugin_get_enabled (plugin)) ||
+		    fu_engine_get_device_blacklisted_guid (self, device) != NULL) {
+			g_debug ("removing %s as now blacklisted", fu_device_get_id (device));
+			fu_device_list_remove (self->device_list, device);
+		}
+	}
+
+	/* make the UI update */
+	fu_engine_emit_changed (self);
 }
 
 static void
@@ -3007,7 +4694,7 @@ fu_engine_remote_list_changed_cb (FuRemoteList *remote_list, FuEngine *self)
 			   error_local->message);
 
 	/* set device properties from the metadata */
-	fu_engine_md_refresh_devices (self);
+	fu_engine_md_refresh_devices (self, self->component_guids_changed);
 
 	/* make the UI update */
 	fu_engine_emit_changed (self);
@@ -3049,11 +4736,11 @@ fu_engine_get_system_jcat_result (FuEngine *self, FwupdRemote *remote, GError **
 	jcat_item = jcat_file_get_item_default (jcat_file, error);
 	if (jcat_item == NULL)
 		return NULL;
-	results = jcat_context_verify_item (self->jcat_context,
-					    blob, jcat_item,
-					    JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM |
-					    JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE,
-					    error);
+	results = fu_cabinet_jcat_verify_item (self->jcat_context,
+					       blob, jcat_item,
+					       JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM |
+					       JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE,
+					       error);
 	if (results == NULL)
 		return NULL;
 	g_ptr_array_sort (results, fu_engine_sort_jcat_results_timestamp_cb);
@@ -3111,6 +4798,7 @@ fu_engine_update_metadata_bytes (FuEngine *self, const gchar *remote_id,
 	FwupdRemote *remote;
 	g_autofree gchar *pki_dir = NULL;
 	g_autofree gchar *sysconfdir = NULL;
+	g_autoptr(GBytes) bytes_old = NULL;
 
 	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
 	g_return_val_if_fail (remote_id != NULL, FALSE);
@@ -3191,6 +4879,10 @@ fu_engine_update_metadata_bytes (FuEngine *self, const gchar *remote_id,
 	}
 
 	/* save XML and signature to remotes.d */
+	if (g_file_test (fwupd_remote_get_filename_cache (remote), G_FILE_TEST_EXISTS)) {
+		bytes_old = fu_common_get_contents_bytes (fwupd_remote_get_filename_cache (remote),
+							  NULL);
+	}
 	if (!fu_common_set_contents_bytes (fwupd_remote_get_filename_cache (remote),
 					   bytes_raw, error))
 		return FALSE;
@@ -3199,9 +4891,16 @@ fu_engine_update_metadata_bytes (FuEngine *self, const gchar *remote_id,
 						   bytes_sig, error))
 			return FALSE;
 	}
+
+	/* the metadata is unchanged, so only the age needs updating */
+	if (bytes_old != NULL && g_bytes_compare (bytes_old, bytes_raw) == 0) {
+		g_debug ("metadata for %s unchanged, not reloading", remote_id);
+		fwupd_remote_set_mtime (remote, (guint64) (g_get_real_time () / G_USEC_PER_SEC));
+		return TRUE;
+	}
 	if (!fu_engine_load_metadata_store (self, FU_ENGINE_LOAD_FLAG_NONE, error))
 		return FALSE;
-	fu_engine_md_refresh_devices (self);
+	fu_engine_md_refresh_devices (self, self->component_guids_changed);
 	fu_engine_emit_changed (self);
 	return TRUE;
 }
@@ -3276,6 +4975,10 @@ fu_engine_update_metadata (FuEngine *self, const gchar *remote_id,
 XbSilo *
 fu_engine_get_silo_from_blob (FuEngine *self, GBytes *blob_cab, GError **error)
 {
+	gboolean ret;
+	gint64 start = fu_timeline_begin ();
+	FuEngineCabinetSilo *item;
+	g_autofree gchar *csum = NULL;
 	g_autoptr(FuCabinet) cabinet = fu_cabinet_new ();
 	g_autoptr(XbSilo) silo = NULL;
 
@@ -3283,14 +4986,39 @@ fu_engine_get_silo_from_blob (FuEngine *self, GBytes *blob_cab, GError **error)
 	g_return_val_if_fail (blob_cab != NULL, NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+	/* clients often ask for the details of a cabinet and then install it,
+	 * so avoid decompressing and verifying the same file again */
+	csum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob_cab);
+	for (guint i = 0; i < self->silo_cabinets->len; i++) {
+		FuEngineCabinetSilo *item = g_ptr_array_index (self->silo_cabinets, i);
+		if (g_strcmp0 (csum, item->checksum) != 0)
+			continue;
+		g_debug ("using cached silo for cabinet %s", csum);
+		for (guint j = i; j > 0; j--)
+			self->silo_cabinets->pdata[j] = self->silo_cabinets->pdata[j - 1];
+		self->silo_cabinets->pdata[0] = item;
+		return g_object_ref (item->silo);
+	}
+
 	/* load file */
 	fu_engine_set_status (self, FWUPD_STATUS_DECOMPRESSING);
 	fu_cabinet_set_size_max (cabinet, fu_engine_get_archive_size_max (self));
 	fu_cabinet_set_jcat_context (cabinet, self->jcat_context);
-	if (!fu_cabinet_parse (cabinet, blob_cab, FU_CABINET_PARSE_FLAG_NONE, error))
+	fu_cabinet_set_worker_pool (cabinet, self->worker_pool);
+	ret = fu_cabinet_parse (cabinet, blob_cab, FU_CABINET_PARSE_FLAG_STREAM, error);
+	fu_timeline_add ("engine", "cabinet-parse", NULL, start);
+	if (!ret)
 		return NULL;
 	silo = fu_cabinet_get_silo (cabinet);
 	fu_engine_set_status (self, FWUPD_STATUS_IDLE);
+
+	/* only keep the last few, as the silo holds all the payloads */
+	if (self->silo_cabinets->len >= FU_ENGINE_CABINET_SILOS_MAX)
+		g_ptr_array_remove_index (self->silo_cabinets, self->silo_cabinets->len - 1);
+	item = g_new0 (FuEngineCabinetSilo, 1);
+	item->checksum = g_steal_pointer (&csum);
+	item->silo = g_object_ref (silo);
+	g_ptr_array_insert (self->silo_cabinets, 0, item);
 	return g_steal_pointer (&silo);
 }
 
@@ -3420,6 +5148,7 @@ fu_engine_get_details (FuEngine *self, gint fd, GError **error)
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GPtrArray) components = NULL;
 	g_autoptr(GPtrArray) details = NULL;
+	g_autoptr(XbNode) csum_container = NULL;
 	g_autoptr(XbSilo) silo = NULL;
 
 	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
@@ -3453,8 +5182,16 @@ fu_engine_get_details (FuEngine *self, gint fd, GError **error)
 					NULL, error))
 		return NULL;
 
-	/* does this exist in any enabled remote */
-	csum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA1, blob);
+	/* does this exist in any enabled remote; the cabinet has already
+	 * computed the container checksum so avoid hashing it again */
+	csum_container = xb_silo_query_first (silo,
+					      "components/component/releases/release/"
+					      "checksum[@target='container']",
+					      NULL);
+	if (csum_container != NULL && xb_node_get_text (csum_container) != NULL)
+		csum = g_strdup (xb_node_get_text (csum_container));
+	else
+		csum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA1, blob);
 	remote_id = fu_engine_get_remote_id_for_checksum (self, csum);
 
 	/* create results with all the metadata in */
@@ -3522,7 +5259,98 @@ fu_engine_get_devices (FuEngine *self, GError **error)
 				     "No detected devices");
 		return NULL;
 	}
+
+	/* the client wants the version and serial now */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_SETUP_ON_DEMAND))
+			continue;
+		if (!fu_engine_ensure_device_setup (self, device, &error_local))
+			g_warning ("%s", error_local->message);
+	}
+	g_ptr_array_sort (devices, fu_engine_sort_devices_by_priority_name);
+	return g_steal_pointer (&devices);
+}
+
+/**
+ * fu_engine_get_generation:
+ * @self: A #FuEngine
+ *
+ * Gets the generation of the newest device change.
+ *
+ * Returns: a generation number, or 0 if no devices were ever added
+ **/
+guint64
+fu_engine_get_generation (FuEngine *self)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), 0);
+	return self->generation;
+}
+
+/**
+ * fu_engine_get_devices_since:
+ * @self: A #FuEngine
+ * @generation: A generation from fu_engine_get_generation(), or 0
+ * @removed: (out) (transfer container) (element-type utf8): removed device IDs
+ * @error: A #GError, or %NULL
+ *
+ * Gets the devices that were added or changed after @generation, and the
+ * IDs of the devices that have been removed since then.
+ *
+ * Returns: (transfer container) (element-type FwupdDevice): results, which may be empty
+ **/
+GPtrArray *
+fu_engine_get_devices_since (FuEngine *self,
+			     guint64 generation,
+			     GPtrArray **removed,
+			     GError **error)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GPtrArray) devices_active = NULL;
+	g_autoptr(GPtrArray) removed_tmp = g_ptr_array_new_with_free_func (g_free);
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	g_return_val_if_fail (removed != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	locker = g_mutex_locker_new (&self->generations_mutex);
+
+	/* we might have forgotten about some removed devices */
+	if (generation > 0 && generation < self->generation_horizon) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_FOUND,
+			     "generation %" G_GUINT64_FORMAT " has expired",
+			     generation);
+		return NULL;
+	}
+
+	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	devices_active = fu_device_list_get_snapshot (self->device_list);
+	for (guint i = 0; i < devices_active->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices_active, i);
+		guint64 *tmp = g_hash_table_lookup (self->device_generations,
+						    fu_device_get_id (device));
+		if (tmp != NULL && *tmp <= generation)
+			continue;
+		g_ptr_array_add (devices, g_object_ref (device));
+	}
 	g_ptr_array_sort (devices, fu_engine_sort_devices_by_priority_name);
+
+	/* a full snapshot does not need any removals */
+	if (generation > 0) {
+		g_hash_table_iter_init (&iter, self->removed_generations);
+		while (g_hash_table_iter_next (&iter, &key, &value)) {
+			guint64 *tmp = value;
+			if (*tmp > generation)
+				g_ptr_array_add (removed_tmp, g_strdup (key));
+		}
+	}
+	*removed = g_steal_pointer (&removed_tmp);
 	return g_steal_pointer (&devices);
 }
 
@@ -3597,13 +5425,43 @@ fu_engine_get_devices_by_guid (FuEngine *self, const gchar *guid, GError **error
 GPtrArray *
 fu_engine_get_history (FuEngine *self, GError **error)
 {
-	g_autoptr(GPtrArray) devices = NULL;
-
-	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
-	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return fu_engine_get_history_full (self, NULL,
+					   FWUPD_UPDATE_STATE_UNKNOWN,
+					   0, 0, 0, error);
+}
 
-	devices = fu_history_get_devices (self->history, error);
-	if (devices == NULL)
+/**
+ * fu_engine_get_history_full:
+ * @self: A #FuEngine
+ * @device_id: (nullable): A device ID, or %NULL for all devices
+ * @update_state: A #FwupdUpdateState, or %FWUPD_UPDATE_STATE_UNKNOWN for any
+ * @since: A UNIX timestamp the device was modified after, or 0
+ * @limit: The maximum number of devices to return, or 0 for no limit
+ * @offset: The number of devices to skip
+ * @error: A #GError, or %NULL
+ *
+ * Gets a filtered page of the history.
+ *
+ * Returns: (transfer container) (element-type FwupdDevice): results
+ **/
+GPtrArray *
+fu_engine_get_history_full (FuEngine *self,
+			    const gchar *device_id,
+			    FwupdUpdateState update_state,
+			    guint64 since,
+			    guint limit,
+			    guint offset,
+			    GError **error)
+{
+	g_autoptr(GPtrArray) devices = NULL;
+
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	devices = fu_history_get_devices_full (self->history, device_id,
+					       update_state, since,
+					       limit, offset, error);
+	if (devices == NULL)
 		return NULL;
 	if (devices->len == 0) {
 		g_set_error_literal (error,
@@ -3700,15 +5558,22 @@ fu_engine_get_remote_by_id (FuEngine *self, const gchar *remote_id, GError **err
 }
 
 
-static gint
-fu_engine_sort_releases_cb (gconstpointer a, gconstpointer b, gpointer user_data)
+/* newest first */
+static void
+fu_engine_sort_releases_by_version (FuDevice *device, GPtrArray *releases)
 {
-	FuDevice *device = FU_DEVICE (user_data);
-	FwupdRelease *rel_a = FWUPD_RELEASE (*((FwupdRelease **) a));
-	FwupdRelease *rel_b = FWUPD_RELEASE (*((FwupdRelease **) b));
-	return fu_common_vercmp_full (fwupd_release_get_version (rel_b),
-				      fwupd_release_get_version (rel_a),
-				      fu_device_get_version_format (device));
+	FwupdVersionFormat fmt = fu_device_get_version_format (device);
+	g_autoptr(GPtrArray) items = NULL;
+
+	items = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_sort_item_free);
+	for (guint i = 0; i < releases->len; i++) {
+		FwupdRelease *rel = g_ptr_array_index (releases, i);
+		FuEngineSortItem *item = g_new0 (FuEngineSortItem, 1);
+		item->key = fu_common_version_key_new (fwupd_release_get_version (rel), fmt);
+		item->data = rel;
+		g_ptr_array_add (items, item);
+	}
+	fu_engine_sort_items (releases, items, TRUE);
 }
 
 static gboolean
@@ -3729,6 +5594,7 @@ fu_engine_add_releases_for_device_component (FuEngine *self,
 					     FuDevice *device,
 					     XbNode *component,
 					     GPtrArray *releases,
+					     gboolean summary,
 					     GError **error)
 {
 	FwupdVersionFormat fmt = fu_device_get_version_format (device);
@@ -3736,11 +5602,11 @@ fu_engine_add_releases_for_device_component (FuEngine *self,
 	g_autoptr(FuInstallTask) task = fu_install_task_new (device, component);
 	g_autoptr(GPtrArray) releases_tmp = NULL;
 
-	if (!fu_engine_check_requirements (self, task,
-					   FWUPD_INSTALL_FLAG_OFFLINE |
-					   FWUPD_INSTALL_FLAG_ALLOW_REINSTALL |
-					   FWUPD_INSTALL_FLAG_ALLOW_OLDER,
-					   error))
+	if (!fu_engine_check_requirements_full (self, task,
+						FWUPD_INSTALL_FLAG_OFFLINE |
+						FWUPD_INSTALL_FLAG_ALLOW_REINSTALL |
+						FWUPD_INSTALL_FLAG_ALLOW_OLDER,
+						TRUE, error))
 		return FALSE;
 
 	/* get all releases */
@@ -3763,12 +5629,12 @@ fu_engine_add_releases_for_device_component (FuEngine *self,
 		g_autoptr(GError) error_loop = NULL;
 
 		/* create new FwupdRelease for the XbNode */
-		if (!fu_engine_set_release_from_appstream (self,
-							   device,
-							   rel,
-							   component,
-							   release,
-							   &error_loop)) {
+		if (!fu_engine_set_release_from_appstream_summary (self,
+								   device,
+								   rel,
+								   component,
+								   release,
+								   &error_loop)) {
 			g_warning ("failed to set release for component: %s",
 				   error_loop->message);
 			continue;
@@ -3819,6 +5685,21 @@ fu_engine_add_releases_for_device_component (FuEngine *self,
 		    update_message != NULL) {
 			    fwupd_device_set_update_message (FWUPD_DEVICE (device), update_message);
 		}
+
+		/* only add the details for releases that are going to be shown */
+		if (summary) {
+			g_object_set_data_full (G_OBJECT (rel), "fwupd::Component",
+						g_object_ref (component),
+						(GDestroyNotify) g_object_unref);
+			g_object_set_data_full (G_OBJECT (rel), "fwupd::Release",
+						g_object_ref (release),
+						(GDestroyNotify) g_object_unref);
+		} else {
+			fu_engine_set_release_from_appstream_details (self, rel,
+								      component,
+								      release);
+		}
+
 		/* success */
 		g_ptr_array_add (releases, g_steal_pointer (&rel));
 	}
@@ -3827,16 +5708,18 @@ fu_engine_add_releases_for_device_component (FuEngine *self,
 	return TRUE;
 }
 
-GPtrArray *
-fu_engine_get_releases_for_device (FuEngine *self, FuDevice *device, GError **error)
+/* in summary mode only the fields used for filtering and sorting are set,
+ * and fu_engine_release_ensure_details() has to be used on the results */
+static GPtrArray *
+fu_engine_get_releases_for_device_full (FuEngine *self,
+					FuDevice *device,
+					gboolean summary,
+					GError **error)
 {
-	GPtrArray *device_guids;
 	GPtrArray *releases;
 	const gchar *version;
 	g_autoptr(GError) error_all = NULL;
-	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GPtrArray) components = NULL;
-	g_autoptr(GString) xpath = g_string_new (NULL);
 
 	/* get device version */
 	version = fu_device_get_version (device);
@@ -3858,25 +5741,12 @@ fu_engine_get_releases_for_device (FuEngine *self, FuDevice *device, GError **er
 	}
 
 	/* get all the components that provide any of these GUIDs */
-	device_guids = fu_device_get_guids (device);
-	for (guint i = 0; i < device_guids->len; i++) {
-		const gchar *guid = g_ptr_array_index (device_guids, i);
-		xb_string_append_union (xpath,
-					"components/component/"
-					"provides/firmware[@type=$'flashed'][text()=$'%s']/"
-					"../..", guid);
-	}
-	components = xb_silo_query (self->silo, xpath->str, 0, &error_local);
+	components = fu_engine_get_components_by_guids (self, device);
 	if (components == NULL) {
-		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) ||
-		    g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_NOTHING_TO_DO,
-					     "No releases found");
-			return NULL;
-		}
-		g_propagate_error (error, g_steal_pointer (&error_local));
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOTHING_TO_DO,
+				     "No releases found");
 		return NULL;
 	}
 
@@ -3889,6 +5759,7 @@ fu_engine_get_releases_for_device (FuEngine *self, FuDevice *device, GError **er
 								  device,
 								  component,
 								  releases,
+								  summary,
 								  &error_tmp)) {
 			if (error_all == NULL) {
 				error_all = g_steal_pointer (&error_tmp);
@@ -3916,6 +5787,12 @@ fu_engine_get_releases_for_device (FuEngine *self, FuDevice *device, GError **er
 	return releases;
 }
 
+GPtrArray *
+fu_engine_get_releases_for_device (FuEngine *self, FuDevice *device, GError **error)
+{
+	return fu_engine_get_releases_for_device_full (self, device, FALSE, error);
+}
+
 /**
  * fu_engine_get_releases:
  * @self: A #FuEngine
@@ -3952,7 +5829,7 @@ fu_engine_get_releases (FuEngine *self, const gchar *device_id, GError **error)
 				     "No releases for device");
 		return NULL;
 	}
-	g_ptr_array_sort_with_data (releases, fu_engine_sort_releases_cb, device);
+	fu_engine_sort_releases_by_version (device, releases);
 	return g_steal_pointer (&releases);
 }
 
@@ -3984,7 +5861,7 @@ fu_engine_get_downgrades (FuEngine *self, const gchar *device_id, GError **error
 		return NULL;
 
 	/* get all the releases for the device */
-	releases_tmp = fu_engine_get_releases_for_device (self, device, error);
+	releases_tmp = fu_engine_get_releases_for_device_full (self, device, TRUE, error);
 	if (releases_tmp == NULL)
 		return NULL;
 	releases = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
@@ -4021,6 +5898,7 @@ fu_engine_get_downgrades (FuEngine *self, const gchar *device_id, GError **error
 				 fu_device_get_version_lowest (device));
 			continue;
 		}
+		fu_engine_release_ensure_details (self, rel_tmp);
 		g_ptr_array_add (releases, g_object_ref (rel_tmp));
 	}
 	if (error_str->len > 2)
@@ -4042,7 +5920,7 @@ fu_engine_get_downgrades (FuEngine *self, const gchar *device_id, GError **error
 		}
 		return NULL;
 	}
-	g_ptr_array_sort_with_data (releases, fu_engine_sort_releases_cb, device);
+	fu_engine_sort_releases_by_version (device, releases);
 	return g_steal_pointer (&releases);
 }
 
@@ -4064,6 +5942,27 @@ fu_engine_add_approved_firmware (FuEngine *self, const gchar *checksum)
 	g_hash_table_add (self->approved_firmware, g_strdup (checksum));
 }
 
+/* replaces the saved list, but the ones from the config file always stay */
+gboolean
+fu_engine_set_approved_firmware (FuEngine *self, GPtrArray *checksums, GError **error)
+{
+	GPtrArray *checksums_config;
+
+	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
+	g_return_val_if_fail (checksums != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (!fu_history_set_approved_firmware (self->history, checksums, error))
+		return FALSE;
+	g_hash_table_remove_all (self->approved_firmware);
+	checksums_config = fu_config_get_approved_firmware (self->config);
+	for (guint i = 0; i < checksums_config->len; i++)
+		fu_engine_add_approved_firmware (self, g_ptr_array_index (checksums_config, i));
+	for (guint i = 0; i < checksums->len; i++)
+		fu_engine_add_approved_firmware (self, g_ptr_array_index (checksums, i));
+	return TRUE;
+}
+
 gchar *
 fu_engine_self_sign (FuEngine *self,
 		     const gchar *value,
@@ -4093,33 +5992,13 @@ fu_engine_self_sign (FuEngine *self,
 	return jcat_blob_get_data_as_string (jcat_signature);
 }
 
-/**
- * fu_engine_get_upgrades:
- * @self: A #FuEngine
- * @device_id: A device ID
- * @error: A #GError, or %NULL
- *
- * Gets the upgrades available for a specific device.
- *
- * Returns: (transfer container) (element-type FwupdDevice): results
- **/
-GPtrArray *
-fu_engine_get_upgrades (FuEngine *self, const gchar *device_id, GError **error)
+static GPtrArray *
+fu_engine_get_upgrades_for_device (FuEngine *self, FuDevice *device, GError **error)
 {
-	g_autoptr(FuDevice) device = NULL;
 	g_autoptr(GPtrArray) releases = NULL;
 	g_autoptr(GPtrArray) releases_tmp = NULL;
 	g_autoptr(GString) error_str = g_string_new (NULL);
 
-	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
-	g_return_val_if_fail (device_id != NULL, NULL);
-	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
-
-	/* find the device */
-	device = fu_device_list_get_by_id (self->device_list, device_id, error);
-	if (device == NULL)
-		return NULL;
-
 	/* don't show upgrades again until we reboot */
 	if (fu_device_get_update_state (device) == FWUPD_UPDATE_STATE_NEEDS_REBOOT) {
 		g_set_error_literal (error,
@@ -4130,7 +6009,7 @@ fu_engine_get_upgrades (FuEngine *self, const gchar *device_id, GError **error)
 	}
 
 	/* get all the releases for the device */
-	releases_tmp = fu_engine_get_releases_for_device (self, device, error);
+	releases_tmp = fu_engine_get_releases_for_device_full (self, device, TRUE, error);
 	if (releases_tmp == NULL)
 		return NULL;
 	releases = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
@@ -4168,6 +6047,7 @@ fu_engine_get_upgrades (FuEngine *self, const gchar *device_id, GError **error)
 			continue;
 		}
 
+		fu_engine_release_ensure_details (self, rel_tmp);
 		g_ptr_array_add (releases, g_object_ref (rel_tmp));
 	}
 	if (error_str->len > 2)
@@ -4189,10 +6069,82 @@ fu_engine_get_upgrades (FuEngine *self, const gchar *device_id, GError **error)
 		}
 		return NULL;
 	}
-	g_ptr_array_sort_with_data (releases, fu_engine_sort_releases_cb, device);
+	fu_engine_sort_releases_by_version (device, releases);
 	return g_steal_pointer (&releases);
 }
 
+/**
+ * fu_engine_get_upgrades:
+ * @self: A #FuEngine
+ * @device_id: A device ID
+ * @error: A #GError, or %NULL
+ *
+ * Gets the upgrades available for a specific device.
+ *
+ * Returns: (transfer container) (element-type FwupdDevice): results
+ **/
+GPtrArray *
+fu_engine_get_upgrades (FuEngine *self, const gchar *device_id, GError **error)
+{
+	g_autoptr(FuDevice) device = NULL;
+
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	g_return_val_if_fail (device_id != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* find the device */
+	device = fu_device_list_get_by_id (self->device_list, device_id, error);
+	if (device == NULL)
+		return NULL;
+	return fu_engine_get_upgrades_for_device (self, device, error);
+}
+
+/**
+ * fu_engine_get_all_upgrades:
+ * @self: A #FuEngine
+ * @error: A #GError, or %NULL
+ *
+ * Gets the upgrades available for all devices in one pass, so that the
+ * parsed requirements and component lookups are shared between devices.
+ * Devices without any upgrades are not included.
+ *
+ * Returns: (transfer container) (element-type utf8 GPtrArray): device-id to
+ * an array of #FwupdRelease
+ **/
+GHashTable *
+fu_engine_get_all_upgrades (FuEngine *self, GError **error)
+{
+	g_autoptr(GHashTable) results = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	devices = fu_device_list_get_active (self->device_list);
+	results = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					 (GDestroyNotify) g_ptr_array_unref);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GPtrArray) releases = NULL;
+
+		/* not going to have results */
+		if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_UPDATABLE))
+			continue;
+		releases = fu_engine_get_upgrades_for_device (self, device, &error_local);
+		if (releases == NULL) {
+			g_debug ("no upgrades for %s: %s",
+				 fu_device_get_id (device),
+				 error_local->message);
+			continue;
+		}
+		g_hash_table_insert (results,
+				     g_strdup (fu_device_get_id (device)),
+				     g_steal_pointer (&releases));
+	}
+	return g_steal_pointer (&results);
+}
+
 /**
  * fu_engine_clear_results:
  * @self: A #FuEngine
@@ -4294,6 +6246,91 @@ fu_engine_plugins_setup (FuEngine *self)
 	}
 }
 
+typedef struct {
+	FuPlugin		*plugin;	/* no ref */
+	GError			*error;
+} FuEngineColdplugHelper;
+
+static void
+fu_engine_coldplug_helper_free (FuEngineColdplugHelper *helper)
+{
+	if (helper->error != NULL)
+		g_error_free (helper->error);
+	g_free (helper);
+}
+
+static void
+fu_engine_plugins_coldplug_thread_cb (gpointer data, GCancellable *cancellable)
+{
+	FuEngineColdplugHelper *helper = (FuEngineColdplugHelper *) data;
+	fu_plugin_runner_coldplug (helper->plugin, &helper->error);
+}
+
+static void
+fu_engine_plugins_coldplug_failed (FuPlugin *plugin, const GError *error)
+{
+	fu_plugin_set_enabled (plugin, FALSE);
+	g_message ("disabling plugin because: %s", error->message);
+}
+
+/* plugins with the same order have no run-after or run-before rules between
+ * them, and so can be run at the same time if the plugin says it is safe */
+static void
+fu_engine_plugins_coldplug_level (FuEngine *self, GPtrArray *plugins)
+{
+	g_autoptr(FuWorkerBatch) batch = NULL;
+	g_autoptr(GPtrArray) helpers = NULL;
+
+	batch = fu_worker_batch_new (self->worker_pool, FU_WORKER_PRIORITY_BACKGROUND, NULL);
+	helpers = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_coldplug_helper_free);
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		FuEngineColdplugHelper *helper;
+		if (plugins->len == 1)
+			break;
+		if (!fu_plugin_has_flag (plugin, FU_PLUGIN_FLAG_THREADED_COLDPLUG))
+			continue;
+		if (!fu_plugin_get_enabled (plugin))
+			continue;
+		if (self->worker_pool == NULL)
+			break;
+		helper = g_new0 (FuEngineColdplugHelper, 1);
+		helper->plugin = plugin;
+		fu_plugin_defer_device_signals (plugin);
+		g_ptr_array_add (helpers, helper);
+		g_debug ("performing threaded coldplug() on %s",
+			 fu_plugin_get_name (plugin));
+		fu_worker_batch_add (batch, fu_engine_plugins_coldplug_thread_cb, helper);
+	}
+
+	/* everything else is run on the main thread at the same time */
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		g_autoptr(GError) error = NULL;
+		gboolean is_threaded = FALSE;
+		for (guint j = 0; j < helpers->len; j++) {
+			FuEngineColdplugHelper *helper = g_ptr_array_index (helpers, j);
+			if (helper->plugin == plugin) {
+				is_threaded = TRUE;
+				break;
+			}
+		}
+		if (is_threaded)
+			continue;
+		if (!fu_plugin_runner_coldplug (plugin, &error))
+			fu_engine_plugins_coldplug_failed (plugin, error);
+	}
+
+	/* wait for the workers, then deliver the devices in plugin order */
+	fu_worker_batch_wait (batch);
+	for (guint i = 0; i < helpers->len; i++) {
+		FuEngineColdplugHelper *helper = g_ptr_array_index (helpers, i);
+		fu_plugin_flush_device_signals (helper->plugin);
+		if (helper->error != NULL)
+			fu_engine_plugins_coldplug_failed (helper->plugin, helper->error);
+	}
+}
+
 static void
 fu_engine_plugins_coldplug (FuEngine *self, gboolean is_recoldplug)
 {
@@ -4319,19 +6356,28 @@ fu_engine_plugins_coldplug (FuEngine *self, gboolean is_recoldplug)
 	}
 
 	/* exec */
-	for (guint i = 0; i < plugins->len; i++) {
-		g_autoptr(GError) error = NULL;
-		FuPlugin *plugin = g_ptr_array_index (plugins, i);
-		if (is_recoldplug) {
+	if (is_recoldplug) {
+		for (guint i = 0; i < plugins->len; i++) {
+			g_autoptr(GError) error = NULL;
+			FuPlugin *plugin = g_ptr_array_index (plugins, i);
 			if (!fu_plugin_runner_recoldplug (plugin, &error))
 				g_message ("failed recoldplug: %s", error->message);
-		} else {
-			if (!fu_plugin_runner_coldplug (plugin, &error)) {
-				fu_plugin_set_enabled (plugin, FALSE);
-				g_message ("disabling plugin because: %s",
-					   error->message);
+		}
+	} else {
+		g_autoptr(GPtrArray) level = g_ptr_array_new ();
+		for (guint i = 0; i < plugins->len; i++) {
+			FuPlugin *plugin = g_ptr_array_index (plugins, i);
+			if (level->len > 0) {
+				FuPlugin *plugin_tmp = g_ptr_array_index (level, 0);
+				if (fu_plugin_get_order (plugin_tmp) != fu_plugin_get_order (plugin)) {
+					fu_engine_plugins_coldplug_level (self, level);
+					g_ptr_array_set_size (level, 0);
+				}
 			}
+			g_ptr_array_add (level, plugin);
 		}
+		if (level->len > 0)
+			fu_engine_plugins_coldplug_level (self, level);
 	}
 
 	/* cleanup */
@@ -4384,6 +6430,152 @@ fu_engine_plugin_device_register_cb (FuPlugin *plugin,
 	fu_engine_plugin_device_register (self, device);
 }
 
+/* the key is only valid until the device, the daemon or the boot changes */
+static gchar *
+fu_engine_get_coldplug_cache_key (FuEngine *self, FuDevice *device)
+{
+	g_autoptr(GString) str = g_string_new (NULL);
+
+	if (self->boot_id == NULL)
+		return NULL;
+	if (fu_device_get_physical_id (device) == NULL)
+		return NULL;
+	g_string_append_printf (str, "%s;%s;%s;%s;",
+				self->boot_id,
+				PACKAGE_VERSION,
+				FU_BUILD_HASH,
+				fu_device_get_physical_id (device));
+	if (FU_IS_UDEV_DEVICE (device)) {
+		const gchar *sysfs_path = fu_udev_device_get_sysfs_path (FU_UDEV_DEVICE (device));
+		GStatBuf st = { 0 };
+		if (sysfs_path == NULL || g_stat (sysfs_path, &st) != 0)
+			return NULL;
+		g_string_append_printf (str, "%s;%" G_GINT64_FORMAT,
+					sysfs_path, (gint64) st.st_mtime);
+	} else if (FU_IS_USB_DEVICE (device)) {
+		GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (device));
+		if (usb_device == NULL)
+			return NULL;
+		g_string_append_printf (str, "%s;%u;%u;%u",
+					g_usb_device_get_platform_id (usb_device),
+					g_usb_device_get_bus (usb_device),
+					g_usb_device_get_address (usb_device),
+					g_usb_device_get_release (usb_device));
+	} else {
+		return NULL;
+	}
+	return g_compute_checksum_for_string (G_CHECKSUM_SHA1, str->str, -1);
+}
+
+static gchar *
+fu_engine_get_coldplug_cache_filename (void)
+{
+	g_autofree gchar *cachedirpkg = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
+	return g_build_filename (cachedirpkg, "coldplug.cache", NULL);
+}
+
+static void
+fu_engine_load_coldplug_cache (FuEngine *self)
+{
+	GVariant *value;
+	const gchar *key;
+	g_autofree gchar *fn = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GVariant) cache = NULL;
+	g_autoptr(GVariantIter) iter = NULL;
+
+	/* the cache is useless without a way to detect a reboot */
+	if (self->boot_id == NULL)
+		return;
+
+	fn = fu_engine_get_coldplug_cache_filename ();
+	if (!g_file_test (fn, G_FILE_TEST_EXISTS))
+		return;
+	blob = fu_common_get_contents_bytes (fn, &error_local);
+	if (blob == NULL) {
+		g_debug ("failed to load coldplug cache: %s", error_local->message);
+		return;
+	}
+	cache = g_variant_new_from_bytes (G_VARIANT_TYPE_VARDICT, blob, FALSE);
+	if (!g_variant_is_normal_form (cache)) {
+		g_debug ("ignoring invalid coldplug cache");
+		return;
+	}
+	iter = g_variant_iter_new (cache);
+	while (g_variant_iter_next (iter, "{&sv}", &key, &value))
+		g_hash_table_insert (self->coldplug_cache, g_strdup (key), value);
+	g_debug ("loaded %u devices from coldplug cache",
+		 g_hash_table_size (self->coldplug_cache));
+}
+
+static void
+fu_engine_save_coldplug_cache (FuEngine *self)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	GVariantBuilder builder;
+	g_autofree gchar *fn = fu_engine_get_coldplug_cache_filename ();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GVariant) cache = NULL;
+
+	if (self->boot_id == NULL)
+		return;
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_hash_table_iter_init (&iter, self->coldplug_cache_new);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		g_variant_builder_add (&builder, "{sv}", (const gchar *) key, (GVariant *) value);
+	cache = g_variant_ref_sink (g_variant_builder_end (&builder));
+	blob = g_variant_get_data_as_bytes (cache);
+	if (!fu_common_mkdir_parent (fn, &error_local) ||
+	    !fu_common_set_contents_bytes (fn, blob, &error_local))
+		g_warning ("failed to save coldplug cache: %s", error_local->message);
+}
+
+static void
+fu_engine_invalidate_coldplug_cache (FuEngine *self)
+{
+	g_autofree gchar *fn = fu_engine_get_coldplug_cache_filename ();
+	g_hash_table_remove_all (self->coldplug_cache);
+	g_hash_table_remove_all (self->coldplug_cache_new);
+	if (g_file_test (fn, G_FILE_TEST_EXISTS) && g_unlink (fn) != 0)
+		g_debug ("failed to delete %s", fn);
+}
+
+static void
+fu_engine_restore_coldplug_cache (FuEngine *self, FuDevice *device)
+{
+	GVariant *value;
+	g_autofree gchar *key = fu_engine_get_coldplug_cache_key (self, device);
+
+	if (key == NULL)
+		return;
+	value = g_hash_table_lookup (self->coldplug_cache, key);
+	if (value != NULL)
+		fu_device_set_setup_cache (device, value);
+}
+
+static void
+fu_engine_record_coldplug_cache (FuEngine *self, FuDevice *device)
+{
+	g_autofree gchar *key = NULL;
+
+	/* only standalone devices, as the hierarchy is made by the plugins */
+	if (self->loaded || self->boot_id == NULL)
+		return;
+	if (fu_device_get_parent (device) != NULL ||
+	    fu_device_get_children (device)->len > 0)
+		return;
+	key = fu_engine_get_coldplug_cache_key (self, device);
+	if (key == NULL)
+		return;
+	g_hash_table_insert (self->coldplug_cache_new,
+			     g_steal_pointer (&key),
+			     g_variant_ref_sink (fwupd_device_to_variant_full (FWUPD_DEVICE (device),
+									       FWUPD_DEVICE_FLAG_TRUSTED)));
+}
+
 static void
 fu_engine_plugin_device_added_cb (FuPlugin *plugin,
 				  FuDevice *device,
@@ -4400,6 +6592,7 @@ fu_engine_plugin_device_added_cb (FuPlugin *plugin,
 		fu_device_set_priority (device, fu_plugin_get_priority (plugin));
 	}
 
+	fu_engine_record_coldplug_cache (self, device);
 	fu_engine_add_device (self, device);
 }
 
@@ -4407,7 +6600,7 @@ static void
 fu_engine_adopt_children (FuEngine *self, FuDevice *device)
 {
 	GPtrArray *guids;
-	g_autoptr(GPtrArray) devices = fu_device_list_get_active (self->device_list);
+	g_autoptr(GPtrArray) devices = fu_device_list_get_snapshot (self->device_list);
 
 	/* find the parent GUID in any existing device */
 	guids = fu_device_get_parent_guids (device);
@@ -4526,11 +6719,28 @@ fu_engine_device_inherit_history (FuEngine *self, FuDevice *device)
 	}
 }
 
+/* returns the blacklisted GUID, or NULL */
+static const gchar *
+fu_engine_get_device_blacklisted_guid (FuEngine *self, FuDevice *device)
+{
+	GPtrArray *blacklisted_devices = fu_config_get_blacklist_devices (self->config);
+	GPtrArray *device_guids = fu_device_get_guids (device);
+	for (guint i = 0; i < blacklisted_devices->len; i++) {
+		const gchar *blacklisted_guid = g_ptr_array_index (blacklisted_devices, i);
+		for (guint j = 0; j < device_guids->len; j++) {
+			const gchar *device_guid = g_ptr_array_index (device_guids, j);
+			if (g_strcmp0 (blacklisted_guid, device_guid) == 0)
+				return device_guid;
+		}
+	}
+	return NULL;
+}
+
 void
 fu_engine_add_device (FuEngine *self, FuDevice *device)
 {
-	GPtrArray *blacklisted_devices;
 	GPtrArray *device_guids;
+	const gchar *blacklisted_guid;
 	g_autoptr(XbNode) component = NULL;
 
 	/* device has no GUIDs set! */
@@ -4543,20 +6753,14 @@ fu_engine_add_device (FuEngine *self, FuDevice *device)
 	}
 
 	/* is this GUID blacklisted */
-	blacklisted_devices = fu_config_get_blacklist_devices (self->config);
-	for (guint i = 0; i < blacklisted_devices->len; i++) {
-		const gchar *blacklisted_guid = g_ptr_array_index (blacklisted_devices, i);
-		for (guint j = 0; j < device_guids->len; j++) {
-			const gchar *device_guid = g_ptr_array_index (device_guids, j);
-			if (g_strcmp0 (blacklisted_guid, device_guid) == 0) {
-				g_debug ("%s [%s] is blacklisted [%s], ignoring from %s",
-					 fu_device_get_name (device),
-					 fu_device_get_id (device),
-					 device_guid,
-					 fu_device_get_plugin (device));
-				return;
-			}
-		}
+	blacklisted_guid = fu_engine_get_device_blacklisted_guid (self, device);
+	if (blacklisted_guid != NULL) {
+		g_debug ("%s [%s] is blacklisted [%s], ignoring from %s",
+			 fu_device_get_name (device),
+			 fu_device_get_id (device),
+			 blacklisted_guid,
+			 fu_device_get_plugin (device));
+		return;
 	}
 
 	/* does the device not have an assigned protocol */
@@ -4718,6 +6922,18 @@ fu_engine_plugin_device_removed_cb (FuPlugin *plugin,
 	fu_engine_emit_changed (self);
 }
 
+static gboolean
+fu_engine_watched_files_cb (gpointer user_data)
+{
+	FuEngine *self = (FuEngine *) user_data;
+	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		fu_plugin_check_watched_files (plugin);
+	}
+	return G_SOURCE_CONTINUE;
+}
+
 static gboolean
 fu_engine_recoldplug_delay_cb (gpointer user_data)
 {
@@ -4750,6 +6966,7 @@ fu_engine_udev_device_add (FuEngine *self, GUdevDevice *udev_device)
 			   error_local->message);
 		return;
 	}
+	fu_engine_restore_coldplug_cache (self, FU_DEVICE (device));
 
 	/* can be specified using a quirk */
 	possible_plugins = fu_device_get_possible_plugins (FU_DEVICE (device));
@@ -4758,6 +6975,11 @@ fu_engine_udev_device_add (FuEngine *self, GUdevDevice *udev_device)
 		const gchar *plugin_name = g_ptr_array_index (possible_plugins, i);
 		g_autoptr(GError) error = NULL;
 
+		if (!fu_engine_ensure_plugin_loaded (self, plugin_name, &error)) {
+			g_warning ("failed to load plugin %s: %s",
+				   plugin_name, error->message);
+			continue;
+		}
 		plugin = fu_plugin_list_find_by_name (self->plugin_list,
 						      plugin_name, &error);
 		if (plugin == NULL) {
@@ -4807,40 +7029,29 @@ fu_engine_udev_device_remove (FuEngine *self, GUdevDevice *udev_device)
 	}
 }
 
-typedef struct {
-	FuEngine	*self;
-	GUdevDevice	*udev_device;
-	guint		 idle_id;
-} FuEngineUdevChangedHelper;
-
 static void
-fu_engine_udev_changed_helper_free (FuEngineUdevChangedHelper *helper)
-{
-	if (helper->idle_id != 0)
-		g_source_remove (helper->idle_id);
-	g_object_unref (helper->self);
-	g_object_unref (helper->udev_device);
-	g_free (helper);
-}
-
-static FuEngineUdevChangedHelper *
-fu_engine_udev_changed_helper_new (FuEngine *self, GUdevDevice *udev_device)
+fu_engine_udev_device_changed (FuEngine *self,
+			       GUdevDevice *udev_device,
+			       GPtrArray *plugins)
 {
-	FuEngineUdevChangedHelper *helper = g_new0 (FuEngineUdevChangedHelper, 1);
-	helper->self = g_object_ref (self);
-	helper->udev_device = g_object_ref (udev_device);
-	return helper;
-}
+	const gchar *sysfs_path = g_udev_device_get_sysfs_path (udev_device);
+	g_autoptr(FuUdevDevice) device = fu_udev_device_new (udev_device);
+	g_autoptr(GPtrArray) devices = NULL;
 
-static gboolean
-fu_engine_udev_changed_cb (gpointer user_data)
-{
-	FuEngineUdevChangedHelper *helper = (FuEngineUdevChangedHelper *) user_data;
-	GPtrArray *plugins = fu_plugin_list_get_all (helper->self->plugin_list);
-	g_autoptr(FuUdevDevice) device = fu_udev_device_new (helper->udev_device);
+	/* emit changed on any that match */
+	devices = fu_device_list_get_all (self->device_list);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device_tmp = g_ptr_array_index (devices, i);
+		if (!FU_IS_UDEV_DEVICE (device_tmp))
+			continue;
+		if (g_strcmp0 (fu_udev_device_get_sysfs_path (FU_UDEV_DEVICE (device_tmp)),
+			       sysfs_path) == 0) {
+			fu_udev_device_emit_changed (FU_UDEV_DEVICE (device_tmp));
+		}
+	}
 
-	/* run all plugins */
-	for (guint j = 0; j < plugins->len; j++) {
+	/* only the plugins watching this subsystem */
+	for (guint j = 0; plugins != NULL && j < plugins->len; j++) {
 		FuPlugin *plugin_tmp = g_ptr_array_index (plugins, j);
 		g_autoptr(GError) error = NULL;
 		if (!fu_plugin_runner_udev_device_changed (plugin_tmp, device, &error)) {
@@ -4852,46 +7063,150 @@ fu_engine_udev_changed_cb (gpointer user_data)
 			}
 			g_warning ("%s failed to change udev device %s: %s",
 				   fu_plugin_get_name (plugin_tmp),
-				   g_udev_device_get_sysfs_path (helper->udev_device),
+				   sysfs_path,
 				   error->message);
 		}
 	}
+}
 
-	/* device done, so remove ref */
-	helper->idle_id = 0;
-	g_hash_table_remove (helper->self->udev_changed_ids,
-			     g_udev_device_get_sysfs_path (helper->udev_device));
-	return FALSE;
+/* the net result of all the uevents for one sysfs path in the batch */
+typedef struct {
+	GUdevDevice	*udev_device;	/* newest */
+	gboolean	 removed;	/* done before any add */
+	gboolean	 added;
+	gboolean	 changed;	/* not required if added */
+} FuEngineUdevEvent;
+
+static void
+fu_engine_udev_event_free (FuEngineUdevEvent *event)
+{
+	g_object_unref (event->udev_device);
+	g_free (event);
+}
+
+/* subsystem:GPtrArray of FuPlugin, rebuilt when a plugin is added */
+static GHashTable *
+fu_engine_get_udev_subsystem_plugins (FuEngine *self)
+{
+	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	GHashTable *index;
+
+	if (self->udev_subsystem_plugins != NULL)
+		return self->udev_subsystem_plugins;
+	index = g_hash_table_new_full (g_str_hash, g_str_equal,
+				       g_free, (GDestroyNotify) g_ptr_array_unref);
+	for (guint i = 0; i < self->udev_subsystems->len; i++) {
+		const gchar *subsystem = g_ptr_array_index (self->udev_subsystems, i);
+		GPtrArray *plugins_tmp = g_ptr_array_new ();
+		for (guint j = 0; j < plugins->len; j++) {
+			FuPlugin *plugin = g_ptr_array_index (plugins, j);
+			if (fu_plugin_has_udev_subsystem (plugin, subsystem))
+				g_ptr_array_add (plugins_tmp, plugin);
+		}
+		g_hash_table_insert (index, g_strdup (subsystem), plugins_tmp);
+	}
+	self->udev_subsystem_plugins = index;
+	return index;
+}
+
+static void
+fu_engine_udev_events_flush (FuEngine *self)
+{
+	g_autoptr(GHashTable) index = NULL;
+	g_autoptr(GHashTable) events = NULL;
+	g_autoptr(GList) sysfs_paths = NULL;
+
+	if (self->udev_events_id != 0) {
+		g_source_remove (self->udev_events_id);
+		self->udev_events_id = 0;
+	}
+	if (g_hash_table_size (self->udev_events) == 0)
+		return;
+
+	/* plugins can add events while this is being processed */
+	events = g_steal_pointer (&self->udev_events);
+	self->udev_events = g_hash_table_new_full (g_str_hash, g_str_equal,
+						   g_free, (GDestroyNotify) fu_engine_udev_event_free);
+	g_debug ("processing %u batched udev events", g_hash_table_size (events));
+
+	/* parents sort before children */
+	sysfs_paths = g_hash_table_get_keys (events);
+	sysfs_paths = g_list_sort (sysfs_paths, (GCompareFunc) g_strcmp0);
+
+	/* remove children first */
+	for (GList *l = g_list_last (sysfs_paths); l != NULL; l = l->prev) {
+		FuEngineUdevEvent *event = g_hash_table_lookup (events, l->data);
+		if (event->removed)
+			fu_engine_udev_device_remove (self, event->udev_device);
+	}
+
+	/* add parents first */
+	/* loading a plugin for an added device rebuilds the index */
+	index = g_hash_table_ref (fu_engine_get_udev_subsystem_plugins (self));
+	for (GList *l = sysfs_paths; l != NULL; l = l->next) {
+		FuEngineUdevEvent *event = g_hash_table_lookup (events, l->data);
+		if (event->added) {
+			fu_engine_udev_device_add (self, event->udev_device);
+		} else if (event->changed) {
+			const gchar *subsystem = g_udev_device_get_subsystem (event->udev_device);
+			fu_engine_udev_device_changed (self, event->udev_device,
+						       g_hash_table_lookup (index, subsystem));
+		}
+	}
+}
+
+static gboolean
+fu_engine_udev_events_cb (gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (user_data);
+	self->udev_events_id = 0;
+	fu_engine_udev_events_flush (self);
+	return G_SOURCE_REMOVE;
 }
 
 static void
-fu_engine_udev_device_changed (FuEngine *self, GUdevDevice *udev_device)
+fu_engine_udev_event_add (FuEngine *self, const gchar *action, GUdevDevice *udev_device)
 {
 	const gchar *sysfs_path = g_udev_device_get_sysfs_path (udev_device);
-	g_autoptr(GPtrArray) devices = NULL;
-	FuEngineUdevChangedHelper *helper;
+	FuEngineUdevEvent *event = g_hash_table_lookup (self->udev_events, sysfs_path);
 
-	/* emit changed on any that match */
-	devices = fu_device_list_get_all (self->device_list);
-	for (guint i = 0; i < devices->len; i++) {
-		FuDevice *device = g_ptr_array_index (devices, i);
-		if (!FU_IS_UDEV_DEVICE (device))
-			continue;
-		if (g_strcmp0 (fu_udev_device_get_sysfs_path (FU_UDEV_DEVICE (device)),
-			       sysfs_path) == 0) {
-			fu_udev_device_emit_changed (FU_UDEV_DEVICE (device));
+	if (event == NULL) {
+		event = g_new0 (FuEngineUdevEvent, 1);
+		event->udev_device = g_object_ref (udev_device);
+		g_hash_table_insert (self->udev_events, g_strdup (sysfs_path), event);
+	} else {
+		g_set_object (&event->udev_device, udev_device);
+	}
+
+	/* merge with any earlier events for this device */
+	if (g_strcmp0 (action, "add") == 0) {
+		event->added = TRUE;
+		event->changed = FALSE;
+	} else if (g_strcmp0 (action, "remove") == 0) {
+		if (event->added && !event->removed) {
+			g_debug ("%s added and removed, ignoring", sysfs_path);
+			g_hash_table_remove (self->udev_events, sysfs_path);
+			return;
 		}
+		event->removed = TRUE;
+		event->added = FALSE;
+		event->changed = FALSE;
+	} else if (g_strcmp0 (action, "change") == 0) {
+		if (!event->added && !event->removed)
+			event->changed = TRUE;
 	}
 
-	/* run all plugins, with per-device rate limiting */
-	if (g_hash_table_remove (self->udev_changed_ids, sysfs_path)) {
-		g_debug ("re-adding rate-limited timeout for %s", sysfs_path);
+	/* wait for the events to stop, but not forever */
+	if (self->udev_events_id == 0) {
+		self->udev_events_start = g_get_monotonic_time ();
 	} else {
-		g_debug ("adding rate-limited timeout for %s", sysfs_path);
+		if (g_get_monotonic_time () - self->udev_events_start >
+		    FU_ENGINE_UDEV_EVENTS_TIMEOUT_MAX * 1000)
+			return;
+		g_source_remove (self->udev_events_id);
 	}
-	helper = fu_engine_udev_changed_helper_new (self, udev_device);
-	helper->idle_id = g_timeout_add (500, fu_engine_udev_changed_cb, helper);
-	g_hash_table_insert (self->udev_changed_ids, g_strdup (sysfs_path), helper);
+	self->udev_events_id = g_timeout_add (FU_ENGINE_UDEV_EVENTS_TIMEOUT,
+					      fu_engine_udev_events_cb, self);
 }
 
 static void
@@ -4935,6 +7250,51 @@ fu_engine_plugin_recoldplug_cb (FuPlugin *plugin, FuEngine *self)
 	self->coldplug_id = g_timeout_add (1500, fu_engine_recoldplug_delay_cb, self);
 }
 
+/* only the devices from this plugin, rather than everything */
+static void
+fu_engine_plugin_rescan_cb (FuPlugin *plugin, const gchar *physical_id, FuEngine *self)
+{
+	g_autoptr(GPtrArray) devices = NULL;
+
+	if (self->coldplug_running) {
+		g_debug ("coldplug already running, ignoring rescan of %s", physical_id);
+		return;
+	}
+	devices = fu_device_list_get_active (self->device_list);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		g_autoptr(FuDeviceLocker) locker = NULL;
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(XbNode) component = NULL;
+
+		if (g_strcmp0 (fu_device_get_plugin (device),
+			       fu_plugin_get_name (plugin)) != 0)
+			continue;
+		if (g_strcmp0 (fu_device_get_physical_id (device), physical_id) != 0)
+			continue;
+		g_debug ("rescanning %s", fu_device_get_id (device));
+		locker = fu_device_locker_new (device, &error_local);
+		if (locker == NULL) {
+			g_warning ("failed to open %s: %s",
+				   fu_device_get_id (device),
+				   error_local->message);
+			continue;
+		}
+		if (!fu_device_rescan (device, &error_local)) {
+			g_warning ("failed to rescan %s: %s",
+				   fu_device_get_id (device),
+				   error_local->message);
+			continue;
+		}
+
+		/* the GUIDs may have changed */
+		component = fu_engine_get_component_by_guids (self, device);
+		fu_engine_ensure_device_supported (self, device);
+		fu_engine_md_refresh_device_from_component (self, device, component);
+		fu_engine_emit_device_changed (self, device);
+	}
+}
+
 static void
 fu_engine_plugin_set_coldplug_delay_cb (FuPlugin *plugin, guint duration, FuEngine *self)
 {
@@ -4964,6 +7324,7 @@ fu_engine_add_plugin (FuEngine *self, FuPlugin *plugin)
 	}
 
 	fu_plugin_list_add (self->plugin_list, plugin);
+	g_clear_pointer (&self->udev_subsystem_plugins, g_hash_table_unref);
 }
 
 static gboolean
@@ -4999,6 +7360,44 @@ fu_engine_add_plugin_filter (FuEngine *self, const gchar *plugin_glob)
 	g_ptr_array_add (self->plugin_filter, g_strdup (plugin_glob));
 }
 
+/* in system-update.target only the plugins with a pending update are needed,
+ * and the devices are restored using the coldplug cache */
+static void
+fu_engine_add_plugin_filter_offline (FuEngine *self)
+{
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GHashTable) plugins = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	g_autoptr(GList) plugin_names = NULL;
+
+	/* the user asked for specific plugins */
+	if (self->plugin_filter->len > 0)
+		return;
+	devices = fu_history_get_devices (self->history, &error_local);
+	if (devices == NULL) {
+		g_debug ("not filtering offline plugins: %s", error_local->message);
+		return;
+	}
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *dev = g_ptr_array_index (devices, i);
+		const gchar *plugin = fu_device_get_plugin (dev);
+		if (fu_device_get_update_state (dev) != FWUPD_UPDATE_STATE_PENDING)
+			continue;
+		if (plugin == NULL) {
+			g_debug ("pending %s has no plugin, loading all",
+				 fu_device_get_id (dev));
+			return;
+		}
+		g_hash_table_add (plugins, g_strdup (plugin));
+	}
+	plugin_names = g_hash_table_get_keys (plugins);
+	for (GList *l = plugin_names; l != NULL; l = l->next) {
+		const gchar *plugin = l->data;
+		g_debug ("only loading plugin %s for offline update", plugin);
+		fu_engine_add_plugin_filter (self, plugin);
+	}
+}
+
 static gboolean
 fu_engine_plugin_check_supported_cb (FuPlugin *plugin, const gchar *guid, FuEngine *self)
 {
@@ -5011,7 +7410,7 @@ fu_engine_plugin_check_supported_cb (FuPlugin *plugin, const gchar *guid, FuEngi
 	xpath = g_strdup_printf ("components/component/"
 				 "provides/firmware[@type='flashed'][text()='%s']",
 				 guid);
-	n = xb_silo_query_first (self->silo, xpath, NULL);
+	n = fu_engine_silos_query_first (self, xpath);
 	return n != NULL;
 }
 
@@ -5088,7 +7487,7 @@ fu_engine_add_security_attrs_supported (FuEngine *self, FuSecurityAttrs *attrs)
 	if (device == NULL) {
 		fwupd_security_attr_set_result (attr_u, "No system device");
 	} else {
-		releases = fu_engine_get_releases_for_device (self, device, NULL);
+		releases = fu_engine_get_releases_for_device_full (self, device, TRUE, NULL);
 		if (releases == NULL) {
 			fwupd_security_attr_set_result (attr_u, "No releases");
 		} else {
@@ -5131,24 +7530,185 @@ fu_engine_add_security_attrs_supported (FuEngine *self, FuSecurityAttrs *attrs)
 	}
 }
 
+typedef struct {
+	FuPlugin		*plugin;
+	FuSecurityAttrs		*attrs;		/* only used by this plugin */
+} FuEngineSecurityAttrsJob;
+
+static void
+fu_engine_security_attrs_job_free (FuEngineSecurityAttrsJob *job)
+{
+	g_object_unref (job->plugin);
+	g_object_unref (job->attrs);
+	g_free (job);
+}
+
+static void
+fu_engine_security_attrs_job_run (gpointer data, GCancellable *cancellable)
+{
+	FuEngineSecurityAttrsJob *job = (FuEngineSecurityAttrsJob *) data;
+	fu_plugin_runner_add_security_attrs (job->plugin, job->attrs);
+}
+
+/* each plugin only reads its own state and the hardware, and the main
+ * thread is blocked until all are done, so the slow probes can overlap */
+static void
+fu_engine_add_security_attrs_plugins (FuEngine *self, FuSecurityAttrs *attrs)
+{
+	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	g_autoptr(FuWorkerBatch) batch = NULL;
+	g_autoptr(GPtrArray) jobs = NULL;
+
+	jobs = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_security_attrs_job_free);
+	for (guint j = 0; j < plugins->len; j++) {
+		FuPlugin *plugin_tmp = g_ptr_array_index (plugins, j);
+		FuEngineSecurityAttrsJob *job = g_new0 (FuEngineSecurityAttrsJob, 1);
+		job->plugin = g_object_ref (plugin_tmp);
+		job->attrs = fu_security_attrs_new ();
+		g_ptr_array_add (jobs, job);
+	}
+	batch = fu_worker_batch_new (self->worker_pool, FU_WORKER_PRIORITY_INTERACTIVE, NULL);
+	for (guint j = 0; j < jobs->len; j++) {
+		FuEngineSecurityAttrsJob *job = g_ptr_array_index (jobs, j);
+		fu_worker_batch_add (batch, fu_engine_security_attrs_job_run, job);
+	}
+	fu_worker_batch_wait (batch);
+
+	/* merge in plugin order so the result does not depend on timing */
+	for (guint j = 0; j < jobs->len; j++) {
+		FuEngineSecurityAttrsJob *job = g_ptr_array_index (jobs, j);
+		g_autoptr(GPtrArray) items = fu_security_attrs_get_all (job->attrs);
+		for (guint i = 0; i < items->len; i++) {
+			FwupdSecurityAttr *attr = g_ptr_array_index (items, i);
+			fu_security_attrs_append (attrs, attr);
+		}
+	}
+}
+
+static gchar *
+fu_engine_get_host_security_cache_filename (void)
+{
+	g_autofree gchar *cachedirpkg = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
+	return g_build_filename (cachedirpkg, "hsi.cache", NULL);
+}
+
+static void
+fu_engine_save_host_security_cache (FuEngine *self, FuSecurityAttrs *attrs)
+{
+	g_autofree gchar *fn = fu_engine_get_host_security_cache_filename ();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GVariant) cache = NULL;
+
+	if (self->host_security_key == NULL)
+		return;
+	cache = g_variant_ref_sink (g_variant_new ("(s@(aa{sv}))",
+						   self->host_security_key,
+						   fu_security_attrs_to_variant (attrs)));
+	blob = g_variant_get_data_as_bytes (cache);
+	if (!fu_common_mkdir_parent (fn, &error_local) ||
+	    !fu_common_set_contents_bytes (fn, blob, &error_local))
+		g_debug ("failed to save HSI cache: %s", error_local->message);
+}
+
+static gboolean
+fu_engine_host_security_revalidate_cb (gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (user_data);
+	g_autofree gchar *hsi_old = g_strdup (self->host_security_id);
+	g_autoptr(FuSecurityAttrs) attrs = NULL;
+
+	/* the restored attrs are only a guess until the plugins are asked */
+	g_clear_object (&self->host_security_attrs);
+	g_clear_pointer (&self->host_security_id, g_free);
+	attrs = fu_engine_get_host_security_attrs (self, NULL);
+	if (attrs != NULL &&
+	    g_strcmp0 (hsi_old, fu_engine_get_host_security_id (self)) != 0) {
+		g_debug ("HSI changed from %s to %s since the cache was saved",
+			 hsi_old, self->host_security_id);
+	}
+	return FALSE;
+}
+
+/* a restart in the same boot does not have to wait for the plugins */
+static void
+fu_engine_load_host_security_cache (FuEngine *self, FuEngineLoadFlags flags)
+{
+	const gchar *checksum = fu_smbios_get_checksum (self->smbios);
+	const gchar *key_tmp = NULL;
+	g_autofree gchar *fn = fu_engine_get_host_security_cache_filename ();
+	g_autofree gchar *key = NULL;
+	g_autoptr(FuSecurityAttrs) attrs = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) items = NULL;
+	g_autoptr(GVariant) cache = NULL;
+	g_autoptr(GVariant) value = NULL;
+
+	/* only the daemon can revalidate the cache in the background */
+	if (checksum == NULL || self->boot_id == NULL)
+		return;
+	if (self->app_flags & FU_APP_FLAGS_NO_IDLE_SOURCES)
+		return;
+	key = g_strdup_printf ("%s;%s;%s", self->boot_id, FU_BUILD_HASH, checksum);
+	if ((flags & FU_ENGINE_LOAD_FLAG_READONLY_FS) == 0)
+		self->host_security_key = g_strdup (key);
+	if (!g_file_test (fn, G_FILE_TEST_EXISTS))
+		return;
+	blob = fu_common_get_contents_bytes (fn, &error_local);
+	if (blob == NULL) {
+		g_debug ("failed to load HSI cache: %s", error_local->message);
+		return;
+	}
+	cache = g_variant_new_from_bytes (G_VARIANT_TYPE ("(s(aa{sv}))"), blob, FALSE);
+	if (!g_variant_is_normal_form (cache)) {
+		g_debug ("ignoring invalid HSI cache");
+		return;
+	}
+	g_variant_get (cache, "(&s@(aa{sv}))", &key_tmp, &value);
+	if (g_strcmp0 (key_tmp, key) != 0) {
+		g_debug ("ignoring HSI cache as SMBIOS or boot changed");
+		return;
+	}
+	items = fwupd_security_attr_array_from_variant (value);
+	if (items->len == 0) {
+		g_debug ("ignoring empty HSI cache");
+		return;
+	}
+	attrs = fu_security_attrs_new ();
+	for (guint i = 0; i < items->len; i++) {
+		FwupdSecurityAttr *attr = g_ptr_array_index (items, i);
+		fu_security_attrs_append (attrs, attr);
+	}
+	self->host_security_attrs = g_steal_pointer (&attrs);
+	self->host_security_id = fu_security_attrs_calculate_hsi (self->host_security_attrs);
+	g_debug ("loaded HSI %s from cache", self->host_security_id);
+	fu_idle_add_task (self->idle, "host-security",
+			  fu_engine_host_security_revalidate_cb, self);
+}
+
 FuSecurityAttrs *
 fu_engine_get_host_security_attrs (FuEngine *self, GError **error)
 {
-	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
-	g_autoptr(FuSecurityAttrs) attrs = fu_security_attrs_new ();
+	g_autoptr(FuSecurityAttrs) attrs = NULL;
+
+	/* plugins may read MSRs, efivars and TPM PCRs, so only do this when
+	 * something has changed */
+	if (self->host_security_attrs != NULL)
+		return g_object_ref (self->host_security_attrs);
 
 	/* built in */
+	attrs = fu_security_attrs_new ();
 	fu_engine_add_security_attrs_tainted (self, attrs);
 	fu_engine_add_security_attrs_supported (self, attrs);
 
 	/* call into plugins */
-	for (guint j = 0; j < plugins->len; j++) {
-		FuPlugin *plugin_tmp = g_ptr_array_index (plugins, j);
-		fu_plugin_runner_add_security_attrs (plugin_tmp, attrs);
-	}
+	fu_engine_add_security_attrs_plugins (self, attrs);
 
 	/* set the obsoletes flag for each attr */
 	fu_security_attrs_depsolve (attrs);
+	self->host_security_attrs = g_object_ref (attrs);
+	fu_engine_save_host_security_cache (self, attrs);
 	return g_steal_pointer (&attrs);
 }
 
@@ -5158,11 +7718,8 @@ fu_engine_get_host_security_id (FuEngine *self)
 	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
 
 	/* rebuild */
-	if (!self->host_security_id_valid) {
+	if (self->host_security_id == NULL) {
 		g_autoptr(FuSecurityAttrs) attrs = NULL;
-		g_free (self->host_security_id);
-		self->host_security_id = NULL;
-		self->host_security_id_valid = TRUE;
 		attrs = fu_engine_get_host_security_attrs (self, NULL);
 		if (attrs != NULL)
 			self->host_security_id = fu_security_attrs_calculate_hsi (attrs);
@@ -5171,11 +7728,157 @@ fu_engine_get_host_security_id (FuEngine *self)
 	return self->host_security_id;
 }
 
+static FuPlugin *
+fu_engine_load_plugin (FuEngine *self, const gchar *name, const gchar *filename, GError **error)
+{
+	g_autoptr(FuPlugin) plugin = fu_plugin_new ();
+
+	/* open module */
+	fu_plugin_set_name (plugin, name);
+	fu_plugin_set_usb_context (plugin, self->usb_ctx);
+	fu_plugin_set_hwids (plugin, self->hwids);
+	fu_plugin_set_smbios (plugin, self->smbios);
+	fu_plugin_set_udev_subsystems (plugin, self->udev_subsystems);
+	fu_plugin_set_quirks (plugin, self->quirks);
+	fu_plugin_set_runtime_versions (plugin, self->runtime_versions);
+	fu_plugin_set_compile_versions (plugin, self->compile_versions);
+	fu_plugin_set_worker_pool (plugin, self->worker_pool);
+	g_signal_connect (plugin, "add-firmware-gtype",
+			  G_CALLBACK (fu_engine_plugin_add_firmware_gtype_cb),
+			  self);
+	g_debug ("adding plugin %s", filename);
+
+	/* if loaded from fu_engine_load() open the plugin */
+	if (self->usb_ctx != NULL) {
+		if (!fu_plugin_open (plugin, filename, error))
+			return NULL;
+	}
+
+	/* self disabled */
+	if (!fu_plugin_get_enabled (plugin)) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "%s self disabled",
+			     fu_plugin_get_name (plugin));
+		return NULL;
+	}
+
+	/* watch for changes */
+	g_signal_connect (plugin, "device-added",
+			  G_CALLBACK (fu_engine_plugin_device_added_cb),
+			  self);
+	g_signal_connect (plugin, "device-removed",
+			  G_CALLBACK (fu_engine_plugin_device_removed_cb),
+			  self);
+	g_signal_connect (plugin, "device-register",
+			  G_CALLBACK (fu_engine_plugin_device_register_cb),
+			  self);
+	g_signal_connect (plugin, "recoldplug",
+			  G_CALLBACK (fu_engine_plugin_recoldplug_cb),
+			  self);
+	g_signal_connect (plugin, "rescan",
+			  G_CALLBACK (fu_engine_plugin_rescan_cb),
+			  self);
+	g_signal_connect (plugin, "set-coldplug-delay",
+			  G_CALLBACK (fu_engine_plugin_set_coldplug_delay_cb),
+			  self);
+	g_signal_connect (plugin, "check-supported",
+			  G_CALLBACK (fu_engine_plugin_check_supported_cb),
+			  self);
+	g_signal_connect (plugin, "rules-changed",
+			  G_CALLBACK (fu_engine_plugin_rules_changed_cb),
+			  self);
+	g_signal_connect (plugin, "security-changed",
+			  G_CALLBACK (fu_engine_plugin_security_changed_cb),
+			  self);
+
+	/* add */
+	fu_engine_add_plugin (self, plugin);
+	return g_steal_pointer (&plugin);
+}
+
+/* opens a plugin listed in the manifest the first time a device needs it,
+ * and does nothing if the plugin was not deferred */
+static gboolean
+fu_engine_ensure_plugin_loaded (FuEngine *self, const gchar *name, GError **error)
+{
+	const gchar *filename_tmp;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(FuPlugin) plugin = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	filename_tmp = g_hash_table_lookup (self->plugins_deferred, name);
+	if (filename_tmp == NULL)
+		return TRUE;
+	filename = g_strdup (filename_tmp);
+	g_hash_table_remove (self->plugins_deferred, name);
+	plugin = fu_engine_load_plugin (self, name, filename, &error_local);
+	if (plugin == NULL) {
+		if (g_error_matches (error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
+			g_debug ("%s", error_local->message);
+			return TRUE;
+		}
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return FALSE;
+	}
+	if (!fu_plugin_list_depsolve (self->plugin_list, error))
+		return FALSE;
+	if (!fu_plugin_runner_startup (plugin, &error_local)) {
+		fu_plugin_set_enabled (plugin, FALSE);
+		g_message ("disabling plugin because: %s", error_local->message);
+	}
+	return TRUE;
+}
+
+/* all the firmware types are only known once every plugin is open */
+static void
+fu_engine_ensure_plugins_loaded (FuEngine *self)
+{
+	g_autoptr(GList) names = g_hash_table_get_keys (self->plugins_deferred);
+	for (GList *l = names; l != NULL; l = l->next) {
+		g_autofree gchar *name = g_strdup (l->data);
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_engine_ensure_plugin_loaded (self, name, &error_local))
+			g_warning ("failed to load %s: %s", name, error_local->message);
+	}
+}
+
+static void
+fu_engine_add_udev_subsystem (FuEngine *self, const gchar *subsystem)
+{
+	for (guint i = 0; i < self->udev_subsystems->len; i++) {
+		const gchar *subsystem_tmp = g_ptr_array_index (self->udev_subsystems, i);
+		if (g_strcmp0 (subsystem_tmp, subsystem) == 0)
+			return;
+	}
+	g_ptr_array_add (self->udev_subsystems, g_strdup (subsystem));
+}
+
+/* the manifest is generated at build time and lists the plugins that only
+ * handle devices matched using the Plugin quirk */
+static GKeyFile *
+fu_engine_load_plugin_manifest (const gchar *plugin_path)
+{
+	g_autofree gchar *filename = g_build_filename (plugin_path, "plugins.manifest", NULL);
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+
+	if (!g_file_test (filename, G_FILE_TEST_EXISTS))
+		return NULL;
+	if (!g_key_file_load_from_file (kf, filename, G_KEY_FILE_NONE, &error_local)) {
+		g_warning ("failed to load %s: %s", filename, error_local->message);
+		return NULL;
+	}
+	return g_steal_pointer (&kf);
+}
+
 gboolean
 fu_engine_load_plugins (FuEngine *self, GError **error)
 {
 	const gchar *fn;
 	g_autoptr(GDir) dir = NULL;
+	g_autoptr(GKeyFile) manifest = NULL;
 	g_autofree gchar *plugin_path = NULL;
 	g_autofree gchar *suffix = g_strdup_printf (".%s", G_MODULE_SUFFIX);
 
@@ -5184,6 +7887,10 @@ fu_engine_load_plugins (FuEngine *self, GError **error)
 	dir = g_dir_open (plugin_path, 0, error);
 	if (dir == NULL)
 		return FALSE;
+
+	/* plugins are only deferred when loaded from fu_engine_load() */
+	if (self->usb_ctx != NULL)
+		manifest = fu_engine_load_plugin_manifest (plugin_path);
 	while ((fn = g_dir_read_name (dir)) != NULL) {
 		g_autofree gchar *filename = NULL;
 		g_autofree gchar *name = NULL;
@@ -5206,66 +7913,33 @@ fu_engine_load_plugins (FuEngine *self, GError **error)
 			g_debug ("plugin %s is not whitelisted", name);
 			continue;
 		}
+		filename = g_build_filename (plugin_path, fn, NULL);
+
+		/* open when the first matching device is added */
+		if (manifest != NULL && g_key_file_has_group (manifest, name)) {
+			g_auto(GStrv) subsystems = NULL;
+			subsystems = g_key_file_get_string_list (manifest, name,
+								 "UdevSubsystems",
+								 NULL, NULL);
+			for (guint i = 0; subsystems != NULL && subsystems[i] != NULL; i++)
+				fu_engine_add_udev_subsystem (self, subsystems[i]);
+			g_debug ("deferring plugin %s", filename);
+			g_hash_table_insert (self->plugins_deferred,
+					     g_steal_pointer (&name),
+					     g_steal_pointer (&filename));
+			continue;
+		}
 
 		/* open module */
-		filename = g_build_filename (plugin_path, fn, NULL);
-		plugin = fu_plugin_new ();
-		fu_plugin_set_name (plugin, name);
-		fu_plugin_set_usb_context (plugin, self->usb_ctx);
-		fu_plugin_set_hwids (plugin, self->hwids);
-		fu_plugin_set_smbios (plugin, self->smbios);
-		fu_plugin_set_udev_subsystems (plugin, self->udev_subsystems);
-		fu_plugin_set_quirks (plugin, self->quirks);
-		fu_plugin_set_runtime_versions (plugin, self->runtime_versions);
-		fu_plugin_set_compile_versions (plugin, self->compile_versions);
-		g_signal_connect (plugin, "add-firmware-gtype",
-				  G_CALLBACK (fu_engine_plugin_add_firmware_gtype_cb),
-				  self);
-		g_debug ("adding plugin %s", filename);
-
-		/* if loaded from fu_engine_load() open the plugin */
-		if (self->usb_ctx != NULL) {
-			if (!fu_plugin_open (plugin, filename, &error_local)) {
-				g_warning ("%s", error_local->message);
+		plugin = fu_engine_load_plugin (self, name, filename, &error_local);
+		if (plugin == NULL) {
+			if (g_error_matches (error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
+				g_debug ("%s", error_local->message);
 				continue;
 			}
-		}
-
-		/* self disabled */
-		if (!fu_plugin_get_enabled (plugin)) {
-			g_debug ("%s self disabled",
-				 fu_plugin_get_name (plugin));
+			g_warning ("%s", error_local->message);
 			continue;
 		}
-
-		/* watch for changes */
-		g_signal_connect (plugin, "device-added",
-				  G_CALLBACK (fu_engine_plugin_device_added_cb),
-				  self);
-		g_signal_connect (plugin, "device-removed",
-				  G_CALLBACK (fu_engine_plugin_device_removed_cb),
-				  self);
-		g_signal_connect (plugin, "device-register",
-				  G_CALLBACK (fu_engine_plugin_device_register_cb),
-				  self);
-		g_signal_connect (plugin, "recoldplug",
-				  G_CALLBACK (fu_engine_plugin_recoldplug_cb),
-				  self);
-		g_signal_connect (plugin, "set-coldplug-delay",
-				  G_CALLBACK (fu_engine_plugin_set_coldplug_delay_cb),
-				  self);
-		g_signal_connect (plugin, "check-supported",
-				  G_CALLBACK (fu_engine_plugin_check_supported_cb),
-				  self);
-		g_signal_connect (plugin, "rules-changed",
-				  G_CALLBACK (fu_engine_plugin_rules_changed_cb),
-				  self);
-		g_signal_connect (plugin, "security-changed",
-				  G_CALLBACK (fu_engine_plugin_security_changed_cb),
-				  self);
-
-		/* add */
-		fu_engine_add_plugin (self, plugin);
 	}
 
 	/* depsolve into the correct order */
@@ -5299,6 +7973,18 @@ fu_engine_get_archive_size_max (FuEngine *self)
 	return fu_config_get_archive_size_max (self->config);
 }
 
+guint
+fu_engine_get_signal_interval (FuEngine *self)
+{
+	return fu_config_get_signal_interval (self->config);
+}
+
+const gchar *
+fu_engine_get_metrics_file (FuEngine *self)
+{
+	return fu_config_get_metrics_file (self->config);
+}
+
 static void
 fu_engine_usb_device_removed_cb (GUsbContext *ctx,
 				 GUsbDevice *usb_device,
@@ -5351,6 +8037,7 @@ fu_engine_usb_device_added_cb (GUsbContext *ctx,
 			   error_local->message);
 		return;
 	}
+	fu_engine_restore_coldplug_cache (self, FU_DEVICE (device));
 
 	/* can be specified using a quirk */
 	possible_plugins = fu_device_get_possible_plugins (FU_DEVICE (device));
@@ -5359,6 +8046,11 @@ fu_engine_usb_device_added_cb (GUsbContext *ctx,
 		const gchar *plugin_name = g_ptr_array_index (possible_plugins, i);
 		g_autoptr(GError) error = NULL;
 
+		if (!fu_engine_ensure_plugin_loaded (self, plugin_name, &error)) {
+			g_warning ("failed to load plugin %s: %s",
+				   plugin_name, error->message);
+			continue;
+		}
 		plugin = fu_plugin_list_find_by_name (self->plugin_list,
 						      plugin_name, &error);
 		if (plugin == NULL) {
@@ -5401,11 +8093,91 @@ fu_engine_load_smbios (FuEngine *self)
 }
 
 static void
-fu_engine_load_hwids (FuEngine *self)
+fu_engine_load_boot_id (FuEngine *self)
+{
+	g_autofree gchar *boot_id = NULL;
+	g_autofree gchar *fn = NULL;
+	g_autofree gchar *procfs = fu_common_get_path (FU_PATH_KIND_PROCFS);
+	g_autoptr(GError) error_local = NULL;
+
+	fn = g_build_filename (procfs, "sys", "kernel", "random", "boot_id", NULL);
+	if (!g_file_get_contents (fn, &boot_id, NULL, &error_local)) {
+		g_debug ("failed to get boot ID: %s", error_local->message);
+		return;
+	}
+	self->boot_id = g_strdup (g_strstrip (boot_id));
+}
+
+static gboolean
+fu_engine_load_hwids_cache (FuEngine *self, const gchar *fn, const gchar *key)
+{
+	const gchar *key_tmp = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GVariant) cache = NULL;
+	g_autoptr(GVariant) value = NULL;
+
+	if (!g_file_test (fn, G_FILE_TEST_EXISTS))
+		return FALSE;
+	blob = fu_common_get_contents_bytes (fn, &error_local);
+	if (blob == NULL) {
+		g_debug ("failed to load HWIDs cache: %s", error_local->message);
+		return FALSE;
+	}
+	cache = g_variant_new_from_bytes (G_VARIANT_TYPE ("(sa{sv})"), blob, FALSE);
+	if (!g_variant_is_normal_form (cache)) {
+		g_debug ("ignoring invalid HWIDs cache");
+		return FALSE;
+	}
+	g_variant_get (cache, "(&s@a{sv})", &key_tmp, &value);
+	if (g_strcmp0 (key_tmp, key) != 0) {
+		g_debug ("ignoring HWIDs cache as SMBIOS or boot changed");
+		return FALSE;
+	}
+	if (!fu_hwids_setup_from_variant (self->hwids, value, &error_local)) {
+		g_debug ("ignoring HWIDs cache: %s", error_local->message);
+		return FALSE;
+	}
+	g_debug ("loaded HWIDs from cache");
+	return TRUE;
+}
+
+static void
+fu_engine_save_hwids_cache (FuEngine *self, const gchar *fn, const gchar *key)
 {
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GVariant) cache = NULL;
+
+	cache = g_variant_ref_sink (g_variant_new ("(s@a{sv})", key,
+						   fu_hwids_to_variant (self->hwids)));
+	blob = g_variant_get_data_as_bytes (cache);
+	if (!fu_common_mkdir_parent (fn, &error_local) ||
+	    !fu_common_set_contents_bytes (fn, blob, &error_local))
+		g_warning ("failed to save HWIDs cache: %s", error_local->message);
+}
+
+static void
+fu_engine_load_hwids (FuEngine *self, FuEngineLoadFlags flags)
+{
+	const gchar *checksum = fu_smbios_get_checksum (self->smbios);
+	g_autofree gchar *cachedirpkg = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
+	g_autofree gchar *fn = g_build_filename (cachedirpkg, "hwids.cache", NULL);
+	g_autofree gchar *key = NULL;
 	g_autoptr(GError) error = NULL;
-	if (!fu_hwids_setup (self->hwids, self->smbios, &error))
+
+	/* the SMBIOS tables can only change with a reboot */
+	if (checksum != NULL && self->boot_id != NULL) {
+		key = g_strdup_printf ("%s;%s;%s", self->boot_id, FU_BUILD_HASH, checksum);
+		if (fu_engine_load_hwids_cache (self, fn, key))
+			return;
+	}
+	if (!fu_hwids_setup (self->hwids, self->smbios, &error)) {
 		g_warning ("Failed to load HWIDs: %s", error->message);
+		return;
+	}
+	if (key != NULL && (flags & FU_ENGINE_LOAD_FLAG_READONLY_FS) == 0)
+		fu_engine_save_hwids_cache (self, fn, key);
 }
 
 static gboolean
@@ -5491,23 +8263,25 @@ fu_engine_update_history_database (FuEngine *self, GError **error)
 {
 	g_autoptr(GPtrArray) devices = NULL;
 
-	/* get any devices */
-	devices = fu_history_get_devices (self->history, error);
+	/* get the devices in the required state */
+	devices = fu_history_get_devices_full (self->history, NULL,
+					       FWUPD_UPDATE_STATE_NEEDS_REBOOT,
+					       0, 0, 0, error);
 	if (devices == NULL)
 		return FALSE;
+
+	/* write all the changes in one transaction */
+	if (!fu_history_start_batch (self->history, error))
+		return FALSE;
 	for (guint i = 0; i < devices->len; i++) {
 		FuDevice *dev = g_ptr_array_index (devices, i);
 		g_autoptr(GError) error_local = NULL;
 
-		/* not in the required state */
-		if (fu_device_get_update_state (dev) != FWUPD_UPDATE_STATE_NEEDS_REBOOT)
-			continue;
-
 		/* try to save the new update-state, but ignoring any error */
 		if (!fu_engine_update_history_device (self, dev, &error_local))
 			g_warning ("%s", error_local->message);
 	}
-	return TRUE;
+	return fu_history_commit_batch (self->history, error);
 }
 
 #ifdef HAVE_GUDEV
@@ -5517,18 +8291,15 @@ fu_engine_udev_uevent_cb (GUdevClient *gudev_client,
 			  GUdevDevice *udev_device,
 			  FuEngine *self)
 {
-	if (g_strcmp0 (action, "add") == 0) {
-		fu_engine_udev_device_add (self, udev_device);
+	if (g_strcmp0 (action, "add") != 0 &&
+	    g_strcmp0 (action, "remove") != 0 &&
+	    g_strcmp0 (action, "change") != 0)
 		return;
-	}
-	if (g_strcmp0 (action, "remove") == 0) {
-		fu_engine_udev_device_remove (self, udev_device);
-		return;
-	}
-	if (g_strcmp0 (action, "change") == 0) {
-		fu_engine_udev_device_changed (self, udev_device);
-		return;
-	}
+
+	/* a dock can add dozens of devices at once */
+	fu_engine_udev_event_add (self, action, udev_device);
+	if (self->app_flags & FU_APP_FLAGS_NO_IDLE_SOURCES)
+		fu_engine_udev_events_flush (self);
 }
 #endif
 
@@ -5556,6 +8327,334 @@ fu_engine_ensure_client_certificate (FuEngine *self)
 	g_debug ("client certificate exists and working");
 }
 
+static void
+fu_engine_profile_item_free (FuEngineProfileItem *item)
+{
+	g_free (item->name);
+	g_free (item);
+}
+
+/* records how long the named startup phase took, returning the time to use
+ * as the start of the next phase */
+static gint64
+fu_engine_profile_add (FuEngine *self, const gchar *name, gint64 start)
+{
+	FuEngineProfileItem *item = g_new0 (FuEngineProfileItem, 1);
+	gint64 now = g_get_monotonic_time ();
+	item->name = g_strdup (name);
+	item->duration = now - start;
+	g_ptr_array_add (self->profile, item);
+	g_debug ("startup phase %s took %.2fms", name, (gdouble) item->duration / 1000.f);
+	return now;
+}
+
+/**
+ * fu_engine_get_profile:
+ * @self: A #FuEngine
+ *
+ * Gets the time spent in each phase of fu_engine_load() followed by the
+ * accumulated time spent in each plugin vfunc, e.g. `redfish:coldplug`.
+ *
+ * Returns: a #GVariant of type `a(sut)` with the name, the number of calls
+ * and the total duration in microseconds
+ **/
+GVariant *
+fu_engine_get_profile (FuEngine *self)
+{
+	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	GVariantBuilder builder;
+
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sut)"));
+	for (guint i = 0; i < self->profile->len; i++) {
+		FuEngineProfileItem *item = g_ptr_array_index (self->profile, i);
+		g_variant_builder_add (&builder, "(sut)",
+				       item->name, (guint32) 1,
+				       (guint64) item->duration);
+	}
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		g_autoptr(GHashTable) durations = fu_plugin_get_runner_durations (plugin);
+		g_autoptr(GList) keys = g_hash_table_get_keys (durations);
+		keys = g_list_sort (keys, (GCompareFunc) g_strcmp0);
+		for (GList *l = keys; l != NULL; l = l->next) {
+			const gchar *vfunc = l->data;
+			FuPluginRunnerDuration *duration = g_hash_table_lookup (durations, vfunc);
+			g_autofree gchar *name = g_strdup_printf ("%s:%s",
+								  fu_plugin_get_name (plugin),
+								  vfunc);
+			g_variant_builder_add (&builder, "(sut)",
+					       name, (guint32) duration->count,
+					       (guint64) duration->total);
+		}
+	}
+	return g_variant_builder_end (&builder);
+}
+
+static gsize
+fu_engine_variant_hash_get_size (GHashTable *hash)
+{
+	GHashTableIter iter;
+	gpointer value;
+	gsize sz = 0;
+	g_hash_table_iter_init (&iter, hash);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		sz += g_variant_get_size (value);
+	return sz;
+}
+
+/**
+ * fu_engine_get_memory_usage:
+ * @self: A #FuEngine
+ *
+ * Gets the memory used by the large engine structures. The size is only
+ * included when it can be found cheaply, e.g. for silos; otherwise only the
+ * number of entries is set.
+ *
+ * Returns: a #GVariant of type `a(stu)` with the name, the size in bytes and
+ * the number of entries
+ **/
+GVariant *
+fu_engine_get_memory_usage (FuEngine *self)
+{
+	GVariantBuilder builder;
+	gsize sz;
+	guint entries = 0;
+	g_autoptr(GList) remote_ids = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(stu)"));
+
+	/* metadata */
+	remote_ids = g_hash_table_get_keys (self->remote_silos);
+	remote_ids = g_list_sort (remote_ids, (GCompareFunc) g_strcmp0);
+	for (GList *l = remote_ids; l != NULL; l = l->next) {
+		const gchar *remote_id = l->data;
+		FuEngineRemoteSilo *item = g_hash_table_lookup (self->remote_silos, remote_id);
+		g_autoptr(GBytes) blob = xb_silo_get_bytes (item->silo);
+		g_autofree gchar *name = g_strdup_printf ("metadata-silo:%s", remote_id);
+		g_variant_builder_add (&builder, "(stu)", name,
+				       (guint64) (blob != NULL ? g_bytes_get_size (blob) : 0),
+				       (guint32) 1);
+	}
+	g_variant_builder_add (&builder, "(stu)", "component-index", (guint64) 0,
+			       (guint32) g_hash_table_size (self->component_index));
+	g_variant_builder_add (&builder, "(stu)", "component-checksums", (guint64) 0,
+			       (guint32) g_hash_table_size (self->component_checksums));
+	g_variant_builder_add (&builder, "(stu)", "requirements-cache", (guint64) 0,
+			       (guint32) g_hash_table_size (self->requirements_cache));
+
+	/* quirks */
+	sz = fu_quirks_get_silo_size (self->quirks, &entries);
+	g_variant_builder_add (&builder, "(stu)", "quirks-silo", (guint64) sz, (guint32) entries);
+
+	/* devices, including the ones waiting to be replugged */
+	devices = fu_device_list_get_all (self->device_list);
+	g_variant_builder_add (&builder, "(stu)", "device-list", (guint64) 0,
+			       (guint32) devices->len);
+	g_variant_builder_add (&builder, "(stu)", "coldplug-cache",
+			       (guint64) (fu_engine_variant_hash_get_size (self->coldplug_cache) +
+					  fu_engine_variant_hash_get_size (self->coldplug_cache_new)),
+			       (guint32) (g_hash_table_size (self->coldplug_cache) +
+					  g_hash_table_size (self->coldplug_cache_new)));
+
+	/* history */
+	sz = fu_history_get_memory_usage (self->history, &entries);
+	g_variant_builder_add (&builder, "(stu)", "history", (guint64) sz, (guint32) entries);
+
+#ifdef HAVE_MALLINFO
+	/* everything else allocated */
+	{
+		struct mallinfo mi = mallinfo ();
+		g_variant_builder_add (&builder, "(stu)", "heap", (guint64) (guint) mi.uordblks,
+				       (guint32) 0);
+	}
+#endif
+	return g_variant_builder_end (&builder);
+}
+
+/**
+ * fu_engine_trim:
+ * @self: A #FuEngine
+ *
+ * Drops the caches that are rebuilt on demand, typically because the system
+ * is under memory pressure. This does nothing if devices are being updated.
+ **/
+void
+fu_engine_trim (FuEngine *self)
+{
+	g_return_if_fail (FU_IS_ENGINE (self));
+
+	if (self->workers_running) {
+		g_debug ("not trimming as workers are running");
+		return;
+	}
+	g_hash_table_remove_all (self->requirements_cache);
+	fu_quirks_trim (self->quirks);
+	fu_history_trim (self->history);
+
+	/* only needed until saved for the next start */
+	if (self->loaded)
+		g_hash_table_remove_all (self->coldplug_cache_new);
+#ifdef HAVE_MALLOC_TRIM
+	malloc_trim (0);
+#endif
+}
+
+/**
+ * fu_engine_compact:
+ * @self: A #FuEngine
+ *
+ * Returns the memory freed by a finished transaction to the OS, without
+ * dropping any of the caches. The caller should have already released the
+ * install tasks, the archive and the archive silo.
+ **/
+void
+fu_engine_compact (FuEngine *self)
+{
+	g_return_if_fail (FU_IS_ENGINE (self));
+
+	if (self->workers_running) {
+		g_debug ("not compacting as workers are running");
+		return;
+	}
+#ifdef HAVE_MALLOC_TRIM
+	malloc_trim (0);
+#endif
+}
+
+static void
+fu_engine_metrics_add_type (GString *str, const gchar *name,
+			    const gchar *kind, const gchar *help)
+{
+	g_string_append_printf (str, "# TYPE %s %s\n", name, kind);
+	g_string_append_printf (str, "# HELP %s %s\n", name, help);
+}
+
+/**
+ * fu_engine_add_metrics:
+ * @self: A #FuEngine
+ * @str: A #GString
+ *
+ * Appends the engine metrics in the OpenMetrics text format, without the
+ * trailing `# EOF` so the caller can add more.
+ **/
+void
+fu_engine_add_metrics (FuEngine *self, GString *str)
+{
+	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	GStatBuf st = { 0 };
+	GVariantIter iter;
+	const gchar *name;
+	guint32 memory_entries;
+	guint64 memory_bytes;
+	guint quirk_lookups;
+	guint quirk_lookups_cached = 0;
+	g_autofree gchar *localstatedir = NULL;
+	g_autofree gchar *history_fn = NULL;
+	g_autoptr(GList) remote_ids = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GVariant) memory = NULL;
+
+	g_return_if_fail (FU_IS_ENGINE (self));
+	g_return_if_fail (str != NULL);
+
+	/* devices */
+	devices = fu_device_list_get_snapshot (self->device_list);
+	fu_engine_metrics_add_type (str, "fwupd_devices", "gauge",
+				    "Number of devices");
+	g_string_append_printf (str, "fwupd_devices %u\n", devices->len);
+
+	/* coldplug, which is only run at startup */
+	fu_engine_metrics_add_type (str, "fwupd_plugin_coldplug_seconds", "gauge",
+				    "Time spent in the plugin coldplug");
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		FuPluginRunnerDuration *duration;
+		g_autoptr(GHashTable) durations = fu_plugin_get_runner_durations (plugin);
+		duration = g_hash_table_lookup (durations, "coldplug");
+		if (duration == NULL)
+			continue;
+		g_string_append_printf (str, "fwupd_plugin_coldplug_seconds{plugin=\"%s\"} %.6f\n",
+					fu_plugin_get_name (plugin),
+					(gdouble) duration->total / G_USEC_PER_SEC);
+	}
+
+	/* metadata */
+	fu_engine_metrics_add_type (str, "fwupd_metadata_silo_bytes", "gauge",
+				    "Size of the metadata silo for each remote");
+	remote_ids = g_hash_table_get_keys (self->remote_silos);
+	remote_ids = g_list_sort (remote_ids, (GCompareFunc) g_strcmp0);
+	for (GList *l = remote_ids; l != NULL; l = l->next) {
+		const gchar *remote_id = l->data;
+		FuEngineRemoteSilo *item = g_hash_table_lookup (self->remote_silos, remote_id);
+		g_autoptr(GBytes) blob = xb_silo_get_bytes (item->silo);
+		g_string_append_printf (str, "fwupd_metadata_silo_bytes{remote=\"%s\"} %" G_GSIZE_FORMAT "\n",
+					remote_id, blob != NULL ? g_bytes_get_size (blob) : 0);
+	}
+	fu_engine_metrics_add_type (str, "fwupd_metadata_load_seconds", "gauge",
+				    "Time spent loading the metadata silos");
+	g_string_append_printf (str, "fwupd_metadata_load_seconds %.6f\n",
+				(gdouble) self->metadata_duration / G_USEC_PER_SEC);
+
+	/* quirks */
+	quirk_lookups = fu_quirks_get_lookup_count (self->quirks, &quirk_lookups_cached);
+	fu_engine_metrics_add_type (str, "fwupd_quirk_lookups", "counter",
+				    "Number of quirk group lookups");
+	g_string_append_printf (str, "fwupd_quirk_lookups_total %u\n", quirk_lookups);
+	fu_engine_metrics_add_type (str, "fwupd_quirk_lookups_cached", "counter",
+				    "Number of quirk group lookups returned from the cache");
+	g_string_append_printf (str, "fwupd_quirk_lookups_cached_total %u\n",
+				quirk_lookups_cached);
+
+	/* history */
+	localstatedir = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
+	history_fn = g_build_filename (localstatedir, "pending.db", NULL);
+	if (g_stat (history_fn, &st) == 0) {
+		fu_engine_metrics_add_type (str, "fwupd_history_database_bytes", "gauge",
+					    "Size of the history database");
+		g_string_append_printf (str, "fwupd_history_database_bytes %" G_GINT64_FORMAT "\n",
+					(gint64) st.st_size);
+	}
+
+	/* memory */
+	memory = fu_engine_get_memory_usage (self);
+	fu_engine_metrics_add_type (str, "fwupd_memory_bytes", "gauge",
+				    "Memory used by each engine structure");
+	g_variant_iter_init (&iter, memory);
+	while (g_variant_iter_next (&iter, "(&stu)", &name, &memory_bytes, &memory_entries)) {
+		if (memory_bytes == 0)
+			continue;
+		g_string_append_printf (str, "fwupd_memory_bytes{structure=\"%s\"} %" G_GUINT64_FORMAT "\n",
+					name, memory_bytes);
+	}
+	fu_engine_metrics_add_type (str, "fwupd_memory_entries", "gauge",
+				    "Number of entries in each engine structure");
+	g_variant_iter_init (&iter, memory);
+	while (g_variant_iter_next (&iter, "(&stu)", &name, &memory_bytes, &memory_entries)) {
+		if (memory_entries == 0)
+			continue;
+		g_string_append_printf (str, "fwupd_memory_entries{structure=\"%s\"} %u\n",
+					name, memory_entries);
+	}
+
+	/* installs */
+	g_mutex_lock (&self->metrics_mutex);
+	fu_engine_metrics_add_type (str, "fwupd_install_seconds", "summary",
+				    "Time spent installing firmware");
+	for (guint i = 0; i < 2; i++) {
+		const gchar *result = i == 1 ? "success" : "failure";
+		g_string_append_printf (str, "fwupd_install_seconds_count{result=\"%s\"} %u\n",
+					result, self->install_cnt[i]);
+		g_string_append_printf (str, "fwupd_install_seconds_sum{result=\"%s\"} %.6f\n",
+					result, (gdouble) self->install_duration[i] / G_USEC_PER_SEC);
+	}
+	g_mutex_unlock (&self->metrics_mutex);
+}
+
 /**
  * fu_engine_load:
  * @self: A #FuEngine
@@ -5571,7 +8670,8 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 {
 	FuRemoteListLoadFlags remote_list_flags = FU_REMOTE_LIST_LOAD_FLAG_NONE;
 	FuQuirksLoadFlags quirks_flags = FU_QUIRKS_LOAD_FLAG_NONE;
-	g_autoptr(GPtrArray) checksums = NULL;
+	gint64 start = g_get_monotonic_time ();
+	g_autoptr(GError) error_efivar = NULL;
 #ifndef _WIN32
 	g_autoptr(GError) error_local = NULL;
 #endif
@@ -5595,6 +8695,7 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 		g_prefix_error (error, "Failed to load config: ");
 		return FALSE;
 	}
+	start = fu_engine_profile_add (self, "config", start);
 
 	/* read remotes */
 	if (flags & FU_ENGINE_LOAD_FLAG_READONLY_FS)
@@ -5603,43 +8704,39 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 		g_prefix_error (error, "Failed to load remotes: ");
 		return FALSE;
 	}
+	start = fu_engine_profile_add (self, "remotes", start);
 
 	/* create client certificate */
 	fu_engine_ensure_client_certificate (self);
+	start = fu_engine_profile_add (self, "client-certificate", start);
 
-	/* get hardcoded approved firmware */
-	checksums = fu_config_get_approved_firmware (self->config);
-	for (guint i = 0; i < checksums->len; i++) {
-		const gchar *csum = g_ptr_array_index (checksums, i);
-		fu_engine_add_approved_firmware (self, csum);
-	}
-
-	/* get extra firmware saved to the database */
-	checksums = fu_history_get_approved_firmware (self->history, error);
-	if (checksums == NULL)
+	/* get hardcoded approved firmware and extra firmware saved to the database */
+	if (!fu_engine_load_approved_firmware (self, error))
 		return FALSE;
-	for (guint i = 0; i < checksums->len; i++) {
-		const gchar *csum = g_ptr_array_index (checksums, i);
-		fu_engine_add_approved_firmware (self, csum);
-	}
+	start = fu_engine_profile_add (self, "history", start);
 
 	/* set up idle exit */
 	if ((self->app_flags & FU_APP_FLAGS_NO_IDLE_SOURCES) == 0)
 		fu_idle_set_timeout (self->idle, fu_config_get_idle_timeout (self->config));
 
 	/* load quirks, SMBIOS and the hwids */
+	fu_engine_load_boot_id (self);
 	fu_engine_load_smbios (self);
-	fu_engine_load_hwids (self);
+	start = fu_engine_profile_add (self, "smbios", start);
+	fu_engine_load_hwids (self, flags);
+	start = fu_engine_profile_add (self, "hwids", start);
 	/* on a read-only filesystem don't care about the cache GUID */
 	if (flags & FU_ENGINE_LOAD_FLAG_READONLY_FS)
 		quirks_flags |= FU_QUIRKS_LOAD_FLAG_READONLY_FS;
 	fu_engine_load_quirks (self, quirks_flags);
+	start = fu_engine_profile_add (self, "quirks", start);
 
 	/* load AppStream metadata */
 	if (!fu_engine_load_metadata_store (self, flags, error)) {
 		g_prefix_error (error, "Failed to load AppStream data: ");
 		return FALSE;
 	}
+	start = fu_engine_profile_add (self, "metadata", start);
 
 	/* add the "built-in" firmware types */
 	fu_engine_add_firmware_gtype (self, "raw", FU_TYPE_FIRMWARE);
@@ -5653,18 +8750,28 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 		g_prefix_error (error, "Failed to get USB context: ");
 		return FALSE;
 	}
+	start = fu_engine_profile_add (self, "usb-context", start);
 
 	/* delete old data files */
 	if (!fu_engine_cleanup_state (error)) {
 		g_prefix_error (error, "Failed to clean up: ");
 		return FALSE;
 	}
+	start = fu_engine_profile_add (self, "cleanup", start);
+
+	/* devices that have not changed since the last start can skip setup */
+	fu_engine_load_coldplug_cache (self);
+	start = fu_engine_profile_add (self, "coldplug-cache", start);
 
 	/* load plugin */
+	if ((flags & FU_ENGINE_LOAD_FLAG_NO_ENUMERATE) == 0 &&
+	    fu_engine_is_running_offline (self))
+		fu_engine_add_plugin_filter_offline (self);
 	if (!fu_engine_load_plugins (self, error)) {
 		g_prefix_error (error, "Failed to load plugins: ");
 		return FALSE;
 	}
+	start = fu_engine_profile_add (self, "plugins", start);
 
 	/* watch the device list for updates and proxy */
 	g_signal_connect (self->device_list, "added",
@@ -5693,10 +8800,23 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 
 	fu_engine_set_status (self, FWUPD_STATUS_LOADING);
 
+	/* share one view of the EFI variables between all the plugins */
+	if (!fu_efivar_snapshot_begin (&error_efivar))
+		g_debug ("no EFI variable snapshot: %s", error_efivar->message);
+
 	/* add devices */
 	fu_engine_plugins_setup (self);
+	start = fu_engine_profile_add (self, "setup", start);
 	if ((flags & FU_ENGINE_LOAD_FLAG_NO_ENUMERATE) == 0)
 		fu_engine_plugins_coldplug (self, FALSE);
+	start = fu_engine_profile_add (self, "coldplug", start);
+	if (error_efivar == NULL)
+		fu_efivar_snapshot_end ();
+
+	/* one timer for all the files the plugins want watched */
+	self->watched_files_id = g_timeout_add_seconds (FU_ENGINE_WATCHED_FILES_INTERVAL,
+							fu_engine_watched_files_cb,
+							self);
 
 	/* coldplug USB devices */
 	g_signal_connect (self->usb_ctx, "device-added",
@@ -5707,25 +8827,38 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 			  self);
 	if ((flags & FU_ENGINE_LOAD_FLAG_NO_ENUMERATE) == 0)
 		g_usb_context_enumerate (self->usb_ctx);
+	start = fu_engine_profile_add (self, "usb", start);
 
 #ifdef HAVE_GUDEV
 	/* coldplug udev devices */
 	if ((flags & FU_ENGINE_LOAD_FLAG_NO_ENUMERATE) == 0)
 		fu_engine_enumerate_udev (self);
+	start = fu_engine_profile_add (self, "udev", start);
 #endif
 
 	/* set device properties from the metadata */
-	fu_engine_md_refresh_devices (self);
+	fu_engine_md_refresh_devices (self, NULL);
+	start = fu_engine_profile_add (self, "md-refresh", start);
 
 	/* update the db for devices that were updated during the reboot */
 	if (!fu_engine_update_history_database (self, error))
 		return FALSE;
+	start = fu_engine_profile_add (self, "history-update", start);
+
+	/* save for the next start */
+	if ((flags & FU_ENGINE_LOAD_FLAG_READONLY_FS) == 0 &&
+	    (flags & FU_ENGINE_LOAD_FLAG_NO_ENUMERATE) == 0)
+		fu_engine_save_coldplug_cache (self);
+	g_hash_table_remove_all (self->coldplug_cache);
+	fu_engine_profile_add (self, "coldplug-cache-save", start);
 
 	fu_engine_set_status (self, FWUPD_STATUS_IDLE);
 	self->loaded = TRUE;
 
 	/* let clients know engine finished starting up */
 	fu_engine_emit_changed (self);
+	fu_engine_load_host_security_cache (self, flags);
+	fu_engine_schedule_idle_tasks (self);
 
 	/* success */
 	return TRUE;
@@ -5804,6 +8937,7 @@ fu_engine_init (FuEngine *self)
 	g_autofree gchar *pkidir_fw = NULL;
 	g_autofree gchar *pkidir_md = NULL;
 	g_autofree gchar *sysconfdir = NULL;
+	g_autoptr(GError) error_pool = NULL;
 	self->percentage = 0;
 	self->status = FWUPD_STATUS_IDLE;
 	self->config = fu_config_new ();
@@ -5816,15 +8950,41 @@ fu_engine_init (FuEngine *self)
 	self->history = fu_history_new ();
 	self->plugin_list = fu_plugin_list_new ();
 	self->plugin_filter = g_ptr_array_new_with_free_func (g_free);
+	self->plugins_deferred = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	self->coldplug_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+						      g_free, (GDestroyNotify) g_variant_unref);
+	self->coldplug_cache_new = g_hash_table_new_full (g_str_hash, g_str_equal,
+							  g_free, (GDestroyNotify) g_variant_unref);
 	self->udev_subsystems = g_ptr_array_new_with_free_func (g_free);
+	self->silo_cabinets = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_cabinet_silo_free);
 #ifdef HAVE_GUDEV
-	self->udev_changed_ids = g_hash_table_new_full (g_str_hash, g_str_equal,
-							g_free, (GDestroyNotify) fu_engine_udev_changed_helper_free);
+	self->udev_events = g_hash_table_new_full (g_str_hash, g_str_equal,
+						   g_free, (GDestroyNotify) fu_engine_udev_event_free);
 #endif
 	self->runtime_versions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	self->compile_versions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	self->approved_firmware = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 	self->firmware_gtypes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	self->profile = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_profile_item_free);
+	self->device_generations = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	self->removed_generations = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	g_mutex_init (&self->generations_mutex);
+	g_mutex_init (&self->metrics_mutex);
+	self->worker_pool = fu_worker_pool_new (MIN (g_get_num_processors (), FU_ENGINE_WORKERS_MAX),
+						&error_pool);
+	if (self->worker_pool == NULL)
+		g_warning ("failed to create worker pool: %s", error_pool->message);
+	self->engine_id = g_strdup_printf ("%08x%08x%08x%08x",
+					   g_random_int (), g_random_int (),
+					   g_random_int (), g_random_int ());
+	self->silos = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	self->remote_silos = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						    (GDestroyNotify) fu_engine_remote_silo_free);
+	self->requirements_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+							  (GDestroyNotify) g_object_unref,
+							  (GDestroyNotify) g_ptr_array_unref);
+	self->component_checksums = g_hash_table_new_full (g_str_hash, g_str_equal,
+							   g_free, g_free);
 
 	g_signal_connect (self->config, "changed",
 			  G_CALLBACK (fu_engine_config_changed_cb),
@@ -5883,17 +9043,31 @@ fu_engine_finalize (GObject *obj)
 
 	if (self->usb_ctx != NULL)
 		g_object_unref (self->usb_ctx);
-	if (self->silo != NULL)
-		g_object_unref (self->silo);
+	g_ptr_array_unref (self->silos);
+	g_hash_table_unref (self->remote_silos);
+	g_hash_table_unref (self->requirements_cache);
+	if (self->component_index != NULL)
+		g_hash_table_unref (self->component_index);
+	g_hash_table_unref (self->component_checksums);
+	if (self->component_guids_changed != NULL)
+		g_hash_table_unref (self->component_guids_changed);
 #ifdef HAVE_GUDEV
 	if (self->gudev_client != NULL)
 		g_object_unref (self->gudev_client);
 #endif
 	if (self->coldplug_id != 0)
 		g_source_remove (self->coldplug_id);
+	fu_idle_remove_tasks (self->idle, self);
+	if (self->watched_files_id != 0)
+		g_source_remove (self->watched_files_id);
 
+	if (self->worker_pool != NULL)
+		g_object_unref (self->worker_pool);
 	g_free (self->host_machine_id);
 	g_free (self->host_security_id);
+	g_free (self->host_security_key);
+	if (self->host_security_attrs != NULL)
+		g_object_unref (self->host_security_attrs);
 	g_object_unref (self->idle);
 	g_object_unref (self->config);
 	g_object_unref (self->remote_list);
@@ -5904,14 +9078,29 @@ fu_engine_finalize (GObject *obj)
 	g_object_unref (self->device_list);
 	g_object_unref (self->jcat_context);
 	g_ptr_array_unref (self->plugin_filter);
+	g_hash_table_unref (self->plugins_deferred);
+	g_hash_table_unref (self->coldplug_cache);
+	g_hash_table_unref (self->coldplug_cache_new);
+	g_ptr_array_unref (self->silo_cabinets);
+	g_free (self->boot_id);
 	g_ptr_array_unref (self->udev_subsystems);
+	if (self->udev_subsystem_plugins != NULL)
+		g_hash_table_unref (self->udev_subsystem_plugins);
 #ifdef HAVE_GUDEV
-	g_hash_table_unref (self->udev_changed_ids);
+	if (self->udev_events_id != 0)
+		g_source_remove (self->udev_events_id);
+	g_hash_table_unref (self->udev_events);
 #endif
 	g_hash_table_unref (self->runtime_versions);
 	g_hash_table_unref (self->compile_versions);
 	g_hash_table_unref (self->approved_firmware);
 	g_hash_table_unref (self->firmware_gtypes);
+	g_ptr_array_unref (self->profile);
+	g_hash_table_unref (self->device_generations);
+	g_hash_table_unref (self->removed_generations);
+	g_mutex_clear (&self->generations_mutex);
+	g_mutex_clear (&self->metrics_mutex);
+	g_free (self->engine_id);
 	g_object_unref (self->plugin_list);
 
 	G_OBJECT_CLASS (fu_engine_parent_class)->finalize (obj);
@@ -51,11 +51,19 @@ gboolean	 fu_engine_get_tainted			(FuEngine	*self);
 const gchar	*fu_engine_get_host_product		(FuEngine *self);
 const gchar	*fu_engine_get_host_machine_id		(FuEngine *self);
 const gchar	*fu_engine_get_host_security_id		(FuEngine	*self);
+GVariant	*fu_engine_get_profile			(FuEngine	*self);
+GVariant	*fu_engine_get_memory_usage		(FuEngine	*self);
+void		 fu_engine_trim				(FuEngine	*self);
+void		 fu_engine_compact			(FuEngine	*self);
+void		 fu_engine_add_metrics			(FuEngine	*self,
+							 GString	*str);
 FwupdStatus	 fu_engine_get_status			(FuEngine	*self);
 XbSilo		*fu_engine_get_silo_from_blob		(FuEngine	*self,
 							 GBytes		*blob_cab,
 							 GError		**error);
 guint64		 fu_engine_get_archive_size_max		(FuEngine	*self);
+guint		 fu_engine_get_signal_interval		(FuEngine	*self);
+const gchar	*fu_engine_get_metrics_file		(FuEngine	*self);
 GPtrArray	*fu_engine_get_plugins			(FuEngine	*self);
 GPtrArray	*fu_engine_get_devices			(FuEngine	*self,
 							 GError		**error);
@@ -65,8 +73,20 @@ FuDevice	*fu_engine_get_device			(FuEngine	*self,
 GPtrArray	*fu_engine_get_devices_by_guid		(FuEngine	*self,
 							 const gchar	*guid,
 							 GError		**error);
+guint64		 fu_engine_get_generation		(FuEngine	*self);
+GPtrArray	*fu_engine_get_devices_since		(FuEngine	*self,
+							 guint64	 generation,
+							 GPtrArray	**removed,
+							 GError		**error);
 GPtrArray	*fu_engine_get_history			(FuEngine	*self,
 							 GError		**error);
+GPtrArray	*fu_engine_get_history_full		(FuEngine	*self,
+							 const gchar	*device_id,
+							 FwupdUpdateState update_state,
+							 guint64	 since,
+							 guint		 limit,
+							 guint		 offset,
+							 GError		**error);
 FwupdRemote 	*fu_engine_get_remote_by_id		(FuEngine	*self,
 							 const gchar	*remote_id,
 							 GError		**error);
@@ -78,6 +98,8 @@ GPtrArray	*fu_engine_get_releases			(FuEngine	*self,
 GPtrArray	*fu_engine_get_downgrades		(FuEngine	*self,
 							 const gchar	*device_id,
 							 GError		**error);
+GHashTable	*fu_engine_get_all_upgrades		(FuEngine	*self,
+							 GError		**error);
 GPtrArray	*fu_engine_get_upgrades			(FuEngine	*self,
 							 const gchar	*device_id,
 							 GError		**error);
@@ -105,6 +127,8 @@ gboolean	 fu_engine_unlock			(FuEngine	*self,
 gboolean	 fu_engine_verify			(FuEngine	*self,
 							 const gchar	*device_id,
 							 GError		**error);
+GHashTable	*fu_engine_verify_all			(FuEngine	*self,
+							 GError		**error);
 gboolean	 fu_engine_verify_update		(FuEngine	*self,
 							 const gchar	*device_id,
 							 GError		**error);
@@ -150,6 +174,9 @@ gboolean	 fu_engine_activate			(FuEngine	*self,
 							 const gchar	*device_id,
 							 GError		**error);
 GPtrArray	*fu_engine_get_approved_firmware	(FuEngine	*self);
+gboolean	 fu_engine_set_approved_firmware	(FuEngine	*self,
+							 GPtrArray	*checksums,
+							 GError		**error);
 void		 fu_engine_add_approved_firmware	(FuEngine	*self,
 							 const gchar	*checksum);
 gchar		*fu_engine_self_sign			(FuEngine	*self,
@@ -163,6 +190,9 @@ gboolean	 fu_engine_modify_config		(FuEngine	*self,
 GPtrArray	*fu_engine_get_firmware_gtype_ids	(FuEngine	*engine);
 GType		 fu_engine_get_firmware_gtype_by_id	(FuEngine	*engine,
 							 const gchar	*id);
+GPtrArray	*fu_engine_get_firmware_gtype_ids_for_bytes (FuEngine	*engine,
+							 GBytes		*fw);
+FuWorkerPool	*fu_engine_get_worker_pool		(FuEngine	*self);
 void		 fu_engine_md_refresh_device_from_component (FuEngine	*self,
 							 FuDevice	*device,
 							 XbNode		*component);
@@ -27,7 +27,7 @@ main (int argc, char **argv)
 	}
 
 	/* load firmware */
-	blob = fu_common_get_contents_bytes (argv[1], &error);
+	blob = fu_common_get_contents_mapped (argv[1], &error);
 	if (blob == NULL) {
 		g_printerr ("failed to load file: %s\n", error->message);
 		return 1;
@@ -20,7 +20,20 @@
 #include "fu-history.h"
 #include "fu-mutex.h"
 
-#define FU_HISTORY_CURRENT_SCHEMA_VERSION	5
+#define FU_HISTORY_CURRENT_SCHEMA_VERSION	9
+
+/* the duration of each phase of the update, and the number of bytes written */
+static const struct {
+	const gchar	*column;
+	const gchar	*key;
+} timing_columns[] = {
+	{ "duration_detach",	FU_HISTORY_METADATA_DURATION_DETACH },
+	{ "duration_write",	FU_HISTORY_METADATA_DURATION_WRITE },
+	{ "duration_attach",	FU_HISTORY_METADATA_DURATION_ATTACH },
+	{ "duration_reload",	FU_HISTORY_METADATA_DURATION_RELOAD },
+	{ "bytes_written",	FU_HISTORY_METADATA_BYTES_WRITTEN },
+	{ NULL,			NULL }
+};
 
 static void fu_history_finalize			 (GObject *object);
 
@@ -29,6 +42,8 @@ struct _FuHistory
 	GObject			 parent_instance;
 	sqlite3			*db;
 	GRWLock			 db_mutex;
+	GHashTable		*stmts;		/* SQL:sqlite3_stmt */
+	guint			 batch_depth;
 };
 
 G_DEFINE_TYPE (FuHistory, fu_history, G_TYPE_OBJECT)
@@ -38,6 +53,46 @@ G_DEFINE_TYPE (FuHistory, fu_history, G_TYPE_OBJECT)
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(sqlite3_stmt, sqlite3_finalize);
 #pragma clang diagnostic pop
 
+/* new rows use a serialized a{ss} variant, older rows use key=value text */
+static void
+fu_history_release_add_metadata (FwupdRelease *release, sqlite3_stmt *stmt, gint col)
+{
+	const gchar *tmp;
+
+	if (sqlite3_column_type (stmt, col) == SQLITE_BLOB) {
+		GVariantIter iter;
+		const gchar *key;
+		const gchar *value;
+		gconstpointer buf = sqlite3_column_blob (stmt, col);
+		gsize bufsz = (gsize) sqlite3_column_bytes (stmt, col);
+		g_autoptr(GVariant) metadata = NULL;
+
+		/* the blob is only valid until the next step, so do not copy it */
+		metadata = g_variant_ref_sink (g_variant_new_from_data (G_VARIANT_TYPE ("a{ss}"),
+									 buf, bufsz, FALSE,
+									 NULL, NULL));
+		if (!g_variant_is_normal_form (metadata)) {
+			g_debug ("ignoring invalid history metadata");
+			return;
+		}
+		g_variant_iter_init (&iter, metadata);
+		while (g_variant_iter_next (&iter, "{&s&s}", &key, &value))
+			fwupd_release_add_metadata_item (release, key, value);
+		return;
+	}
+
+	tmp = (const gchar *) sqlite3_column_text (stmt, col);
+	if (tmp != NULL) {
+		g_auto(GStrv) split = g_strsplit (tmp, ";", -1);
+		for (guint i = 0; split[i] != NULL; i++) {
+			g_auto(GStrv) kv = g_strsplit (split[i], "=", 2);
+			if (g_strv_length (kv) != 2)
+				continue;
+			fwupd_release_add_metadata_item (release, kv[0], kv[1]);
+		}
+	}
+}
+
 static FuDevice *
 fu_history_device_from_stmt (sqlite3_stmt *stmt)
 {
@@ -85,16 +140,7 @@ fu_history_device_from_stmt (sqlite3_stmt *stmt)
 				     FWUPD_DEVICE_FLAG_HISTORICAL);
 
 	/* metadata */
-	tmp = (const gchar *) sqlite3_column_text (stmt, 8);
-	if (tmp != NULL) {
-		g_auto(GStrv) split = g_strsplit (tmp, ";", -1);
-		for (guint i = 0; split[i] != NULL; i++) {
-			g_auto(GStrv) kv = g_strsplit (split[i], "=", 2);
-			if (g_strv_length (kv) != 2)
-				continue;
-			fwupd_release_add_metadata_item (release, kv[0], kv[1]);
-		}
-	}
+	fu_history_release_add_metadata (release, stmt, 8);
 
 	/* guid_default */
 	tmp = (const gchar *) sqlite3_column_text (stmt, 9);
@@ -127,6 +173,21 @@ fu_history_device_from_stmt (sqlite3_stmt *stmt)
 	tmp = (const gchar *) sqlite3_column_text (stmt, 15);
 	if (tmp != NULL)
 		fwupd_release_set_protocol (release, tmp);
+
+	/* timings, added as release metadata so they are included in reports */
+	for (guint i = 0; timing_columns[i].column != NULL; i++) {
+		g_autofree gchar *value = NULL;
+		if (sqlite3_column_type (stmt, 16 + i) == SQLITE_NULL)
+			continue;
+		value = g_strdup_printf ("%" G_GINT64_FORMAT,
+					 sqlite3_column_int64 (stmt, 16 + i));
+		fwupd_release_add_metadata_item (release, timing_columns[i].key, value);
+	}
+
+	/* debug_log */
+	tmp = (const gchar *) sqlite3_column_text (stmt, 21);
+	if (tmp != NULL)
+		fwupd_release_add_metadata_item (release, FU_HISTORY_METADATA_DEBUG_LOG, tmp);
 	return device;
 }
 
@@ -147,11 +208,38 @@ fu_history_stmt_exec (FuHistory *self, sqlite3_stmt *stmt,
 		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_WRITE,
 			     "failed to execute prepared statement: %s",
 			     sqlite3_errmsg (self->db));
+		sqlite3_reset (stmt);
 		return FALSE;
 	}
+
+	/* do not keep the read transaction open on a cached statement */
+	sqlite3_reset (stmt);
 	return TRUE;
 }
 
+/* the statement is owned by the cache and is reused on the next call with the
+ * same SQL, so must only be used with the writer lock held */
+static sqlite3_stmt *
+fu_history_prepare (FuHistory *self, const gchar *sql, GError **error)
+{
+	sqlite3_stmt *stmt = g_hash_table_lookup (self->stmts, sql);
+	if (stmt == NULL) {
+		gint rc = sqlite3_prepare_v2 (self->db, sql, -1, &stmt, NULL);
+		if (rc != SQLITE_OK) {
+			g_set_error_literal (error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_INTERNAL,
+					     sqlite3_errmsg (self->db));
+			return NULL;
+		}
+		g_hash_table_insert (self->stmts, g_strdup (sql), stmt);
+		return stmt;
+	}
+	sqlite3_reset (stmt);
+	sqlite3_clear_bindings (stmt);
+	return stmt;
+}
+
 static gboolean
 fu_history_create_database (FuHistory *self, GError **error)
 {
@@ -178,9 +266,25 @@ fu_history_create_database (FuHistory *self, GError **error)
 			 "version_old TEXT,"
 			 "version_new TEXT,"
 			 "checksum_device TEXT DEFAULT NULL,"
-			 "protocol TEXT DEFAULT NULL);"
+			 "protocol TEXT DEFAULT NULL,"
+			 "duration_detach INTEGER DEFAULT NULL,"
+			 "duration_write INTEGER DEFAULT NULL,"
+			 "duration_attach INTEGER DEFAULT NULL,"
+			 "duration_reload INTEGER DEFAULT NULL,"
+			 "bytes_written INTEGER DEFAULT NULL,"
+			 "debug_log TEXT DEFAULT NULL);"
 			 "CREATE TABLE IF NOT EXISTS approved_firmware ("
 			 "checksum TEXT);"
+			 "CREATE TABLE IF NOT EXISTS verify_cache ("
+			 "device_id TEXT PRIMARY KEY,"
+			 "version TEXT,"
+			 "engine_id TEXT,"
+			 "generation INTEGER DEFAULT 0,"
+			 "checksums TEXT);"
+			 "CREATE INDEX IF NOT EXISTS history_device_id ON history (device_id);"
+			 "CREATE INDEX IF NOT EXISTS history_checksum ON history (checksum);"
+			 "CREATE INDEX IF NOT EXISTS history_update_state ON history (update_state);"
+			 "CREATE INDEX IF NOT EXISTS history_device_modified ON history (device_modified);"
 			 "COMMIT;", NULL, NULL, NULL);
 	if (rc != SQLITE_OK) {
 		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
@@ -215,7 +319,8 @@ fu_history_migrate_database_v1 (FuHistory *self, GError **error)
 			   "device_id, update_state, update_error, filename, "
 			   "display_name, plugin, device_created, device_modified, "
 			   "checksum, flags, metadata, guid_default, version_old, "
-			   "version_new, NULL, NULL FROM history_old;"
+			   "version_new, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL "
+			   "FROM history_old;"
 			   "DROP TABLE history_old;",
 			   NULL, NULL, NULL);
 	if (rc != SQLITE_OK) {
@@ -269,6 +374,82 @@ fu_history_migrate_database_v4 (FuHistory *self, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_history_migrate_database_v5 (FuHistory *self, GError **error)
+{
+	gint rc;
+	rc = sqlite3_exec (self->db,
+			   "CREATE INDEX IF NOT EXISTS history_device_id ON history (device_id);"
+			   "CREATE INDEX IF NOT EXISTS history_checksum ON history (checksum);"
+			   "CREATE INDEX IF NOT EXISTS history_update_state ON history (update_state);"
+			   "CREATE INDEX IF NOT EXISTS history_device_modified ON history (device_modified);",
+			   NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to create index: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_history_migrate_database_v6 (FuHistory *self, GError **error)
+{
+	gint rc;
+	rc = sqlite3_exec (self->db,
+			   "CREATE TABLE IF NOT EXISTS verify_cache ("
+			   "device_id TEXT PRIMARY KEY,"
+			   "version TEXT,"
+			   "engine_id TEXT,"
+			   "generation INTEGER DEFAULT 0,"
+			   "checksums TEXT);",
+			   NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to create table: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_history_migrate_database_v7 (FuHistory *self, GError **error)
+{
+	gint rc;
+	rc = sqlite3_exec (self->db,
+			   "ALTER TABLE history ADD COLUMN duration_detach INTEGER DEFAULT NULL;"
+			   "ALTER TABLE history ADD COLUMN duration_write INTEGER DEFAULT NULL;"
+			   "ALTER TABLE history ADD COLUMN duration_attach INTEGER DEFAULT NULL;"
+			   "ALTER TABLE history ADD COLUMN duration_reload INTEGER DEFAULT NULL;"
+			   "ALTER TABLE history ADD COLUMN bytes_written INTEGER DEFAULT NULL;",
+			   NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to alter database: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_history_migrate_database_v8 (FuHistory *self, GError **error)
+{
+	gint rc;
+	rc = sqlite3_exec (self->db,
+			   "ALTER TABLE history ADD COLUMN debug_log TEXT DEFAULT NULL;",
+			   NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to alter database: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 /* returns 0 if database is not initialised */
 static guint
 fu_history_get_schema_version (FuHistory *self)
@@ -315,16 +496,68 @@ fu_history_create_or_migrate (FuHistory *self, guint schema_ver, GError **error)
 			return FALSE;
 		if (!fu_history_migrate_database_v4 (self, error))
 			return FALSE;
+		if (!fu_history_migrate_database_v5 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v6 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v7 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v8 (self, error))
+			return FALSE;
 	} else if (schema_ver == 3) {
 		g_debug ("migrating v%u database by altering", schema_ver);
 		if (!fu_history_migrate_database_v3 (self, error))
 			return FALSE;
 		if (!fu_history_migrate_database_v4 (self, error))
 			return FALSE;
+		if (!fu_history_migrate_database_v5 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v6 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v7 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v8 (self, error))
+			return FALSE;
 	} else if (schema_ver == 4) {
 		g_debug ("migrating v%u database by altering", schema_ver);
 		if (!fu_history_migrate_database_v4 (self, error))
 			return FALSE;
+		if (!fu_history_migrate_database_v5 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v6 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v7 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v8 (self, error))
+			return FALSE;
+	} else if (schema_ver == 5) {
+		g_debug ("migrating v%u database by adding indexes", schema_ver);
+		if (!fu_history_migrate_database_v5 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v6 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v7 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v8 (self, error))
+			return FALSE;
+	} else if (schema_ver == 6) {
+		g_debug ("migrating v%u database by adding table", schema_ver);
+		if (!fu_history_migrate_database_v6 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v7 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v8 (self, error))
+			return FALSE;
+	} else if (schema_ver == 7) {
+		g_debug ("migrating v%u database by altering", schema_ver);
+		if (!fu_history_migrate_database_v7 (self, error))
+			return FALSE;
+		if (!fu_history_migrate_database_v8 (self, error))
+			return FALSE;
+	} else if (schema_ver == 8) {
+		g_debug ("migrating v%u database by altering", schema_ver);
+		if (!fu_history_migrate_database_v8 (self, error))
+			return FALSE;
 	} else {
 		/* this is probably okay, but return an error if we ever delete
 		 * or rename columns */
@@ -360,6 +593,14 @@ fu_history_open (FuHistory *self, const gchar *filename, GError **error)
 			     filename, sqlite3_errmsg (self->db));
 		return FALSE;
 	}
+
+	/* avoid an fsync for every write; only the daemon writes the database */
+	rc = sqlite3_exec (self->db,
+			   "PRAGMA journal_mode=WAL;"
+			   "PRAGMA synchronous=NORMAL;",
+			   NULL, NULL, NULL);
+	if (rc != SQLITE_OK)
+		g_debug ("failed to enable WAL: %s", sqlite3_errmsg (self->db));
 	return TRUE;
 }
 
@@ -432,19 +673,20 @@ fu_history_load (FuHistory *self, GError **error)
 	return TRUE;
 }
 
-static gchar *
-_convert_hash_to_string (GHashTable *hash)
+static GVariant *
+_convert_hash_to_variant (GHashTable *hash)
 {
-	GString *str = g_string_new (NULL);
-	g_autoptr(GList) keys = g_hash_table_get_keys (hash);
-	for (GList *l = keys; l != NULL; l = l->next) {
-		const gchar *key = l->data;
-		const gchar *value = g_hash_table_lookup (hash, key);
-		if (str->len > 0)
-			g_string_append (str, ";");
-		g_string_append_printf (str, "%s=%s", key, value);
-	}
-	return g_string_free (str, FALSE);
+	GHashTableIter iter;
+	gpointer key, value;
+	GVariantBuilder builder;
+
+	if (g_hash_table_size (hash) == 0)
+		return NULL;
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{ss}"));
+	g_hash_table_iter_init (&iter, hash);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		g_variant_builder_add (&builder, "{ss}", (const gchar *) key, (const gchar *) value);
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
 }
 
 /* unset some flags we don't want to store */
@@ -472,8 +714,7 @@ fu_history_get_device_flags_filtered (FuDevice *device)
 gboolean
 fu_history_modify_device (FuHistory *self, FuDevice *device, GError **error)
 {
-	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	sqlite3_stmt *stmt;
 	g_autoptr(GRWLockWriterLocker) locker = NULL;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
@@ -489,19 +730,23 @@ fu_history_modify_device (FuHistory *self, FuDevice *device, GError **error)
 	g_debug ("modifying device %s [%s]",
 		 fu_device_get_name (device),
 		 fu_device_get_id (device));
-	rc = sqlite3_prepare_v2 (self->db,
-				 "UPDATE history SET "
-				 "update_state = ?1, "
-				 "update_error = ?2, "
-				 "checksum_device = ?6, "
-				 "device_modified = ?7, "
-				 "flags = ?3 "
-				 "WHERE device_id = ?4;",
-				 -1, &stmt, NULL);
-	if (rc != SQLITE_OK) {
-		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
-			     "Failed to prepare SQL to update history: %s",
-			     sqlite3_errmsg (self->db));
+	stmt = fu_history_prepare (self,
+				   "UPDATE history SET "
+				   "update_state = ?1, "
+				   "update_error = ?2, "
+				   "checksum_device = ?6, "
+				   "device_modified = ?7, "
+				   "flags = ?3, "
+				   "duration_detach = COALESCE(?8, duration_detach), "
+				   "duration_write = COALESCE(?9, duration_write), "
+				   "duration_attach = COALESCE(?10, duration_attach), "
+				   "duration_reload = COALESCE(?11, duration_reload), "
+				   "bytes_written = COALESCE(?12, bytes_written), "
+				   "debug_log = COALESCE(?13, debug_log) "
+				   "WHERE device_id = ?4;",
+				   error);
+	if (stmt == NULL) {
+		g_prefix_error (error, "Failed to prepare SQL to update history: ");
 		return FALSE;
 	}
 
@@ -514,6 +759,16 @@ fu_history_modify_device (FuHistory *self, FuDevice *device, GError **error)
 								G_CHECKSUM_SHA1), -1, SQLITE_STATIC);
 	sqlite3_bind_int64 (stmt, 7, fu_device_get_modified (device));
 
+	/* keep the old timings if not set, e.g. when modified after a reboot */
+	for (guint i = 0; timing_columns[i].column != NULL; i++) {
+		guint value = fu_device_get_metadata_integer (device, timing_columns[i].key);
+		if (value != G_MAXUINT)
+			sqlite3_bind_int64 (stmt, 8 + i, value);
+	}
+	sqlite3_bind_text (stmt, 13,
+			   fu_device_get_metadata (device, FU_HISTORY_METADATA_DEBUG_LOG),
+			   -1, SQLITE_STATIC);
+
 	return fu_history_stmt_exec (self, stmt, NULL, error);
 }
 
@@ -535,10 +790,9 @@ fu_history_add_device (FuHistory *self, FuDevice *device, FwupdRelease *release,
 {
 	const gchar *checksum_device;
 	const gchar *checksum = NULL;
-	gint rc;
-	g_autofree gchar *metadata = NULL;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	sqlite3_stmt *stmt;
 	g_autoptr(GRWLockWriterLocker) locker = NULL;
+	g_autoptr(GVariant) metadata = NULL;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
 	g_return_val_if_fail (FU_IS_DEVICE (device), FALSE);
@@ -561,14 +815,14 @@ fu_history_add_device (FuHistory *self, FuDevice *device, FwupdRelease *release,
 	checksum_device = fwupd_checksum_get_by_kind (fu_device_get_checksums (device),
 						      G_CHECKSUM_SHA1);
 
-	/* metadata is stored as a simple string */
-	metadata = _convert_hash_to_string (fwupd_release_get_metadata (release));
+	/* metadata is stored as a binary variant, which is quick to read back */
+	metadata = _convert_hash_to_variant (fwupd_release_get_metadata (release));
 
 	/* add */
 	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
 	g_return_val_if_fail (locker != NULL, FALSE);
-	rc = sqlite3_prepare_v2 (self->db,
-				 "INSERT INTO history (device_id,"
+	stmt = fu_history_prepare (self,
+				   "INSERT INTO history (device_id,"
 						      "update_state,"
 						      "update_error,"
 						      "flags,"
@@ -584,12 +838,11 @@ fu_history_add_device (FuHistory *self, FuDevice *device, FwupdRelease *release,
 						      "version_new,"
 						      "checksum_device,"
 						      "protocol) "
-				 "VALUES (?1,?2,?3,?4,?5,?6,?7,?8,?9,?10,"
-					 "?11,?12,?13,?14,?15,?16)", -1, &stmt, NULL);
-	if (rc != SQLITE_OK) {
-		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
-			     "Failed to prepare SQL to insert history: %s",
-			     sqlite3_errmsg (self->db));
+				   "VALUES (?1,?2,?3,?4,?5,?6,?7,?8,?9,?10,"
+					 "?11,?12,?13,?14,?15,?16)",
+				   error);
+	if (stmt == NULL) {
+		g_prefix_error (error, "Failed to prepare SQL to insert history: ");
 		return FALSE;
 	}
 	sqlite3_bind_text (stmt, 1, fu_device_get_id (device), -1, SQLITE_STATIC);
@@ -601,7 +854,14 @@ fu_history_add_device (FuHistory *self, FuDevice *device, FwupdRelease *release,
 	sqlite3_bind_text (stmt, 7, fu_device_get_name (device), -1, SQLITE_STATIC);
 	sqlite3_bind_text (stmt, 8, fu_device_get_plugin (device), -1, SQLITE_STATIC);
 	sqlite3_bind_text (stmt, 9, fu_device_get_guid_default (device), -1, SQLITE_STATIC);
-	sqlite3_bind_text (stmt, 10, metadata, -1, SQLITE_STATIC);
+	if (metadata != NULL) {
+		sqlite3_bind_blob (stmt, 10,
+				   g_variant_get_data (metadata),
+				   (gint) g_variant_get_size (metadata),
+				   SQLITE_STATIC);
+	} else {
+		sqlite3_bind_null (stmt, 10);
+	}
 	sqlite3_bind_int64 (stmt, 11, fu_device_get_created (device));
 	sqlite3_bind_int64 (stmt, 12, fu_device_get_modified (device));
 	sqlite3_bind_text (stmt, 13, fu_device_get_version (device), -1, SQLITE_STATIC);
@@ -629,8 +889,7 @@ fu_history_remove_all_with_state (FuHistory *self,
 				  FwupdUpdateState update_state,
 				  GError **error)
 {
-	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	sqlite3_stmt *stmt;
 	g_autoptr(GRWLockWriterLocker) locker = NULL;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
@@ -644,13 +903,11 @@ fu_history_remove_all_with_state (FuHistory *self,
 	g_return_val_if_fail (locker != NULL, FALSE);
 	g_debug ("removing all devices with update_state %s",
 		 fwupd_update_state_to_string (update_state));
-	rc = sqlite3_prepare_v2 (self->db,
-				 "DELETE FROM history WHERE update_state = ?1",
-				 -1, &stmt, NULL);
-	if (rc != SQLITE_OK) {
-		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
-			     "Failed to prepare SQL to delete history: %s",
-			     sqlite3_errmsg (self->db));
+	stmt = fu_history_prepare (self,
+				   "DELETE FROM history WHERE update_state = ?1",
+				   error);
+	if (stmt == NULL) {
+		g_prefix_error (error, "Failed to prepare SQL to delete history: ");
 		return FALSE;
 	}
 	sqlite3_bind_int (stmt, 1, update_state);
@@ -671,8 +928,7 @@ fu_history_remove_all_with_state (FuHistory *self,
 gboolean
 fu_history_remove_all (FuHistory *self, GError **error)
 {
-	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	sqlite3_stmt *stmt;
 	g_autoptr(GRWLockWriterLocker) locker = NULL;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
@@ -685,11 +941,11 @@ fu_history_remove_all (FuHistory *self, GError **error)
 	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
 	g_return_val_if_fail (locker != NULL, FALSE);
 	g_debug ("removing all devices");
-	rc = sqlite3_prepare_v2 (self->db, "DELETE FROM history;", -1, &stmt, NULL);
-	if (rc != SQLITE_OK) {
-		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
-			     "Failed to prepare SQL to delete history: %s",
-			     sqlite3_errmsg (self->db));
+	stmt = fu_history_prepare (self,
+				   "DELETE FROM history;",
+				   error);
+	if (stmt == NULL) {
+		g_prefix_error (error, "Failed to prepare SQL to delete history: ");
 		return FALSE;
 	}
 	return fu_history_stmt_exec (self, stmt, NULL, error);
@@ -710,8 +966,7 @@ fu_history_remove_all (FuHistory *self, GError **error)
 gboolean
 fu_history_remove_device (FuHistory *self,  FuDevice *device, GError **error)
 {
-	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	sqlite3_stmt *stmt;
 	g_autoptr(GRWLockWriterLocker) locker = NULL;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
@@ -726,13 +981,11 @@ fu_history_remove_device (FuHistory *self,  FuDevice *device, GError **error)
 	g_debug ("remove device %s [%s]",
 		 fu_device_get_name (device),
 		 fu_device_get_id (device));
-	rc = sqlite3_prepare_v2 (self->db,
-				 "DELETE FROM history WHERE device_id = ?1;",
-				 -1, &stmt, NULL);
-	if (rc != SQLITE_OK) {
-		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
-			     "Failed to prepare SQL to delete history: %s",
-			     sqlite3_errmsg (self->db));
+	stmt = fu_history_prepare (self,
+				   "DELETE FROM history WHERE device_id = ?1;",
+				   error);
+	if (stmt == NULL) {
+		g_prefix_error (error, "Failed to prepare SQL to delete history: ");
 		return FALSE;
 	}
 	sqlite3_bind_text (stmt, 1, fu_device_get_id (device), -1, SQLITE_STATIC);
@@ -755,10 +1008,9 @@ fu_history_remove_device (FuHistory *self,  FuDevice *device, GError **error)
 FuDevice *
 fu_history_get_device_by_id (FuHistory *self, const gchar *device_id, GError **error)
 {
-	gint rc;
 	g_autoptr(GPtrArray) array_tmp = NULL;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
-	g_autoptr(GRWLockReaderLocker) locker = NULL;
+	sqlite3_stmt *stmt;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), NULL);
 	g_return_val_if_fail (device_id != NULL, NULL);
@@ -768,11 +1020,11 @@ fu_history_get_device_by_id (FuHistory *self, const gchar *device_id, GError **e
 		return NULL;
 
 	/* get all the devices */
-	locker = g_rw_lock_reader_locker_new (&self->db_mutex);
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
 	g_return_val_if_fail (locker != NULL, NULL);
 	g_debug ("get device");
-	rc = sqlite3_prepare_v2 (self->db,
-				 "SELECT device_id, "
+	stmt = fu_history_prepare (self,
+				   "SELECT device_id, "
 					"checksum, "
 					"plugin, "
 					"device_created, "
@@ -787,13 +1039,18 @@ fu_history_get_device_by_id (FuHistory *self, const gchar *device_id, GError **e
 					"version_new, "
 					"version_old, "
 					"checksum_device, "
-					"protocol FROM history WHERE "
-				 "device_id = ?1 ORDER BY device_created DESC "
-				 "LIMIT 1", -1, &stmt, NULL);
-	if (rc != SQLITE_OK) {
-		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
-			     "Failed to prepare SQL to get history: %s",
-			     sqlite3_errmsg (self->db));
+					"protocol, "
+					"duration_detach, "
+					"duration_write, "
+					"duration_attach, "
+					"duration_reload, "
+					"bytes_written, "
+					"debug_log FROM history WHERE "
+				   "device_id = ?1 ORDER BY device_created DESC "
+				   "LIMIT 1",
+				   error);
+	if (stmt == NULL) {
+		g_prefix_error (error, "Failed to prepare SQL to get history: ");
 		return NULL;
 	}
 	sqlite3_bind_text (stmt, 1, device_id, -1, SQLITE_STATIC);
@@ -823,11 +1080,40 @@ fu_history_get_device_by_id (FuHistory *self, const gchar *device_id, GError **e
 GPtrArray *
 fu_history_get_devices (FuHistory *self, GError **error)
 {
-	GPtrArray *array = NULL;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
-	gint rc;
+	return fu_history_get_devices_full (self, NULL,
+					    FWUPD_UPDATE_STATE_UNKNOWN,
+					    0, 0, 0, error);
+}
+
+/**
+ * fu_history_get_devices_full:
+ * @self: A #FuHistory
+ * @device_id: (nullable): A device ID, or %NULL for all devices
+ * @update_state: A #FwupdUpdateState, or %FWUPD_UPDATE_STATE_UNKNOWN for any
+ * @since: A UNIX timestamp the device was modified after, or 0
+ * @limit: The maximum number of devices to return, or 0 for no limit
+ * @offset: The number of devices to skip
+ * @error: A #GError or NULL
+ *
+ * Gets a page of the devices in the history database, oldest first.
+ *
+ * Returns: (element-type #FuDevice) (transfer container): devices
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fu_history_get_devices_full (FuHistory *self,
+			     const gchar *device_id,
+			     FwupdUpdateState update_state,
+			     guint64 since,
+			     guint limit,
+			     guint offset,
+			     GError **error)
+{
+	sqlite3_stmt *stmt;
 	g_autoptr(GPtrArray) array_tmp = NULL;
-	g_autoptr(GRWLockReaderLocker) locker = NULL;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+	g_autoptr(GString) sql = g_string_new (NULL);
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), NULL);
 
@@ -837,39 +1123,53 @@ fu_history_get_devices (FuHistory *self, GError **error)
 			return NULL;
 	}
 
+	/* only use the clauses that are needed so the indexes are used */
+	g_string_append (sql, "SELECT device_id, "
+			      "checksum, "
+			      "plugin, "
+			      "device_created, "
+			      "device_modified, "
+			      "display_name, "
+			      "filename, "
+			      "flags, "
+			      "metadata, "
+			      "guid_default, "
+			      "update_state, "
+			      "update_error, "
+			      "version_new, "
+			      "version_old, "
+			      "checksum_device, "
+			      "protocol, "
+			      "duration_detach, "
+			      "duration_write, "
+			      "duration_attach, "
+			      "duration_reload, "
+			      "bytes_written, "
+			      "debug_log FROM history "
+			      "WHERE device_modified >= ?3");
+	if (device_id != NULL)
+		g_string_append (sql, " AND device_id = ?1");
+	if (update_state != FWUPD_UPDATE_STATE_UNKNOWN)
+		g_string_append (sql, " AND update_state = ?2");
+	g_string_append (sql, " ORDER BY device_modified ASC LIMIT ?4 OFFSET ?5;");
+
 	/* get all the devices */
-	locker = g_rw_lock_reader_locker_new (&self->db_mutex);
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
 	g_return_val_if_fail (locker != NULL, NULL);
-	rc = sqlite3_prepare_v2 (self->db,
-				 "SELECT device_id, "
-					"checksum, "
-					"plugin, "
-					"device_created, "
-					"device_modified, "
-					"display_name, "
-					"filename, "
-					"flags, "
-					"metadata, "
-					"guid_default, "
-					"update_state, "
-					"update_error, "
-					"version_new, "
-					"version_old, "
-					"checksum_device, "
-					"protocol FROM history "
-					"ORDER BY device_modified ASC;",
-					-1, &stmt, NULL);
-	if (rc != SQLITE_OK) {
-		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
-			     "Failed to prepare SQL to get history: %s",
-			     sqlite3_errmsg (self->db));
+	stmt = fu_history_prepare (self, sql->str, error);
+	if (stmt == NULL) {
+		g_prefix_error (error, "Failed to prepare SQL to get history: ");
 		return NULL;
 	}
+	sqlite3_bind_text (stmt, 1, device_id, -1, SQLITE_STATIC);
+	sqlite3_bind_int (stmt, 2, update_state);
+	sqlite3_bind_int64 (stmt, 3, (sqlite3_int64) since);
+	sqlite3_bind_int64 (stmt, 4, limit > 0 ? (sqlite3_int64) limit : -1);
+	sqlite3_bind_int64 (stmt, 5, offset);
 	array_tmp = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	if (!fu_history_stmt_exec (self, stmt, array_tmp, error))
 		return NULL;
-	array = g_ptr_array_ref (array_tmp);
-	return array;
+	return g_steal_pointer (&array_tmp);
 }
 
 /**
@@ -887,9 +1187,9 @@ GPtrArray *
 fu_history_get_approved_firmware (FuHistory *self, GError **error)
 {
 	gint rc;
-	g_autoptr(GRWLockReaderLocker) locker = NULL;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
 	g_autoptr(GPtrArray) array = NULL;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	sqlite3_stmt *stmt;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), NULL);
 
@@ -900,15 +1200,13 @@ fu_history_get_approved_firmware (FuHistory *self, GError **error)
 	}
 
 	/* get all the approved firmware */
-	locker = g_rw_lock_reader_locker_new (&self->db_mutex);
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
 	g_return_val_if_fail (locker != NULL, NULL);
-	rc = sqlite3_prepare_v2 (self->db,
-				 "SELECT checksum FROM approved_firmware;",
-				 -1, &stmt, NULL);
-	if (rc != SQLITE_OK) {
-		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
-			     "Failed to prepare SQL to get checksum: %s",
-			     sqlite3_errmsg (self->db));
+	stmt = fu_history_prepare (self,
+				   "SELECT checksum FROM approved_firmware;",
+				   error);
+	if (stmt == NULL) {
+		g_prefix_error (error, "Failed to prepare SQL to get checksum: ");
 		return NULL;
 	}
 	array = g_ptr_array_new_with_free_func (g_free);
@@ -916,6 +1214,7 @@ fu_history_get_approved_firmware (FuHistory *self, GError **error)
 		const gchar *tmp = (const gchar *) sqlite3_column_text (stmt, 0);
 		g_ptr_array_add (array, g_strdup (tmp));
 	}
+	sqlite3_reset (stmt);
 	if (rc != SQLITE_DONE) {
 		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_WRITE,
 			     "failed to execute prepared statement: %s",
@@ -939,8 +1238,7 @@ fu_history_get_approved_firmware (FuHistory *self, GError **error)
 gboolean
 fu_history_clear_approved_firmware (FuHistory *self, GError **error)
 {
-	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	sqlite3_stmt *stmt;
 	g_autoptr(GRWLockWriterLocker) locker = NULL;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
@@ -952,13 +1250,11 @@ fu_history_clear_approved_firmware (FuHistory *self, GError **error)
 	/* remove entries */
 	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
 	g_return_val_if_fail (locker != NULL, FALSE);
-	rc = sqlite3_prepare_v2 (self->db,
-				 "DELETE FROM approved_firmware;",
-				 -1, &stmt, NULL);
-	if (rc != SQLITE_OK) {
-		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
-			     "Failed to prepare SQL to delete approved firmware: %s",
-			     sqlite3_errmsg (self->db));
+	stmt = fu_history_prepare (self,
+				   "DELETE FROM approved_firmware;",
+				   error);
+	if (stmt == NULL) {
+		g_prefix_error (error, "Failed to prepare SQL to delete approved firmware: ");
 		return FALSE;
 	}
 	return fu_history_stmt_exec (self, stmt, NULL, error);
@@ -981,8 +1277,7 @@ fu_history_add_approved_firmware (FuHistory *self,
 				  const gchar *checksum,
 				  GError **error)
 {
-	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	sqlite3_stmt *stmt;
 	g_autoptr(GRWLockWriterLocker) locker = NULL;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
@@ -995,19 +1290,348 @@ fu_history_add_approved_firmware (FuHistory *self,
 	/* add */
 	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
 	g_return_val_if_fail (locker != NULL, FALSE);
-	rc = sqlite3_prepare_v2 (self->db,
-				 "INSERT INTO approved_firmware (checksum) "
-				 "VALUES (?1)", -1, &stmt, NULL);
-	if (rc != SQLITE_OK) {
-		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
-			     "Failed to prepare SQL to insert checksum: %s",
-			     sqlite3_errmsg (self->db));
+	stmt = fu_history_prepare (self,
+				   "INSERT INTO approved_firmware (checksum) "
+				   "VALUES (?1)",
+				   error);
+	if (stmt == NULL) {
+		g_prefix_error (error, "Failed to prepare SQL to insert checksum: ");
 		return FALSE;
 	}
 	sqlite3_bind_text (stmt, 1, checksum, -1, SQLITE_STATIC);
 	return fu_history_stmt_exec (self, stmt, NULL, error);
 }
 
+/**
+ * fu_history_set_approved_firmware:
+ * @self: A #FuHistory
+ * @checksums: (element-type utf8): checksums
+ * @error: A #GError or NULL
+ *
+ * Replaces all the approved firmware records in one transaction, reusing the
+ * same prepared statement for each row.
+ *
+ * Returns: #TRUE for success, #FALSE for failure
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_history_set_approved_firmware (FuHistory *self, GPtrArray *checksums, GError **error)
+{
+	gboolean in_batch;
+	sqlite3_stmt *stmt;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
+	g_return_val_if_fail (checksums != NULL, FALSE);
+
+	/* lazy load */
+	if (!fu_history_load (self, error))
+		return FALSE;
+
+	/* an outer batch commits or discards everything */
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, FALSE);
+	in_batch = self->batch_depth > 0;
+	if (!in_batch && sqlite3_exec (self->db, "BEGIN TRANSACTION;",
+				       NULL, NULL, NULL) != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_WRITE,
+			     "Failed to start transaction: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	stmt = fu_history_prepare (self, "DELETE FROM approved_firmware;", error);
+	if (stmt == NULL) {
+		g_prefix_error (error, "Failed to prepare SQL to delete approved firmware: ");
+		goto rollback;
+	}
+	if (!fu_history_stmt_exec (self, stmt, NULL, error))
+		goto rollback;
+	for (guint i = 0; i < checksums->len; i++) {
+		const gchar *checksum = g_ptr_array_index (checksums, i);
+		stmt = fu_history_prepare (self,
+					   "INSERT INTO approved_firmware (checksum) "
+					   "VALUES (?1)",
+					   error);
+		if (stmt == NULL) {
+			g_prefix_error (error, "Failed to prepare SQL to insert checksum: ");
+			goto rollback;
+		}
+		sqlite3_bind_text (stmt, 1, checksum, -1, SQLITE_STATIC);
+		if (!fu_history_stmt_exec (self, stmt, NULL, error))
+			goto rollback;
+	}
+	if (!in_batch && sqlite3_exec (self->db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_WRITE,
+			     "Failed to commit transaction: %s",
+			     sqlite3_errmsg (self->db));
+		goto rollback;
+	}
+	return TRUE;
+rollback:
+	if (!in_batch)
+		sqlite3_exec (self->db, "ROLLBACK;", NULL, NULL, NULL);
+	return FALSE;
+}
+
+/**
+ * fu_history_get_verify_cache:
+ * @self: A #FuHistory
+ * @device_id: A device ID
+ * @version: The device version
+ * @engine_id: The ID of the engine that did the verification
+ * @generation: The device generation when verified
+ * @error: A #GError or NULL
+ *
+ * Gets the cached checksums for a device, which are only valid if the
+ * device has not been changed since it was last verified.
+ *
+ * Returns: (transfer full) (element-type utf8): checksums, or %NULL if not found
+ *
+ * Since: 1.5.0
+ **/
+GPtrArray *
+fu_history_get_verify_cache (FuHistory *self,
+			     const gchar *device_id,
+			     const gchar *version,
+			     const gchar *engine_id,
+			     guint64 generation,
+			     GError **error)
+{
+	gint rc;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+	g_autoptr(GPtrArray) array = NULL;
+	g_auto(GStrv) split = NULL;
+	sqlite3_stmt *stmt;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), NULL);
+	g_return_val_if_fail (device_id != NULL, NULL);
+	g_return_val_if_fail (engine_id != NULL, NULL);
+
+	/* lazy load */
+	if (!fu_history_load (self, error))
+		return NULL;
+
+	/* find the entry, if still valid */
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, NULL);
+	stmt = fu_history_prepare (self,
+				   "SELECT checksums FROM verify_cache WHERE "
+				   "device_id = ?1 AND version = ?2 AND "
+				   "engine_id = ?3 AND generation = ?4;",
+				   error);
+	if (stmt == NULL) {
+		g_prefix_error (error, "Failed to prepare SQL to get verify cache: ");
+		return NULL;
+	}
+	sqlite3_bind_text (stmt, 1, device_id, -1, SQLITE_STATIC);
+	sqlite3_bind_text (stmt, 2, version != NULL ? version : "", -1, SQLITE_STATIC);
+	sqlite3_bind_text (stmt, 3, engine_id, -1, SQLITE_STATIC);
+	sqlite3_bind_int64 (stmt, 4, (sqlite3_int64) generation);
+	rc = sqlite3_step (stmt);
+	if (rc == SQLITE_ROW) {
+		const gchar *tmp = (const gchar *) sqlite3_column_text (stmt, 0);
+		split = g_strsplit (tmp != NULL ? tmp : "", ",", -1);
+	}
+	sqlite3_reset (stmt);
+	if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_READ,
+			     "failed to execute prepared statement: %s",
+			     sqlite3_errmsg (self->db));
+		return NULL;
+	}
+	if (split == NULL || split[0] == NULL) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_FOUND,
+			     "no valid verify cache for %s", device_id);
+		return NULL;
+	}
+	array = g_ptr_array_new_with_free_func (g_free);
+	for (guint i = 0; split[i] != NULL; i++)
+		g_ptr_array_add (array, g_strdup (split[i]));
+	return g_steal_pointer (&array);
+}
+
+/**
+ * fu_history_set_verify_cache:
+ * @self: A #FuHistory
+ * @device_id: A device ID
+ * @version: The device version
+ * @engine_id: The ID of the engine that did the verification
+ * @generation: The device generation when verified
+ * @checksums: (element-type utf8): The device checksums
+ * @error: A #GError or NULL
+ *
+ * Caches the checksums for a device, replacing any previous entry.
+ *
+ * Returns: #TRUE for success, #FALSE for failure
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_history_set_verify_cache (FuHistory *self,
+			     const gchar *device_id,
+			     const gchar *version,
+			     const gchar *engine_id,
+			     guint64 generation,
+			     GPtrArray *checksums,
+			     GError **error)
+{
+	sqlite3_stmt *stmt;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+	g_autoptr(GString) str = g_string_new (NULL);
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
+	g_return_val_if_fail (device_id != NULL, FALSE);
+	g_return_val_if_fail (engine_id != NULL, FALSE);
+	g_return_val_if_fail (checksums != NULL, FALSE);
+
+	/* lazy load */
+	if (!fu_history_load (self, error))
+		return FALSE;
+
+	/* checksums are hex, so cannot contain the delimiter */
+	for (guint i = 0; i < checksums->len; i++) {
+		const gchar *checksum = g_ptr_array_index (checksums, i);
+		if (str->len > 0)
+			g_string_append_c (str, ',');
+		g_string_append (str, checksum);
+	}
+
+	/* add or replace */
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, FALSE);
+	stmt = fu_history_prepare (self,
+				   "INSERT OR REPLACE INTO verify_cache "
+				   "(device_id, version, engine_id, generation, checksums) "
+				   "VALUES (?1,?2,?3,?4,?5)",
+				   error);
+	if (stmt == NULL) {
+		g_prefix_error (error, "Failed to prepare SQL to set verify cache: ");
+		return FALSE;
+	}
+	sqlite3_bind_text (stmt, 1, device_id, -1, SQLITE_STATIC);
+	sqlite3_bind_text (stmt, 2, version != NULL ? version : "", -1, SQLITE_STATIC);
+	sqlite3_bind_text (stmt, 3, engine_id, -1, SQLITE_STATIC);
+	sqlite3_bind_int64 (stmt, 4, (sqlite3_int64) generation);
+	sqlite3_bind_text (stmt, 5, str->str, -1, SQLITE_STATIC);
+	return fu_history_stmt_exec (self, stmt, NULL, error);
+}
+
+/**
+ * fu_history_start_batch:
+ * @self: A #FuHistory
+ * @error: A #GError or NULL
+ *
+ * Starts a transaction so that all following writes are committed to disk
+ * together when fu_history_commit_batch() is called. Batches can be nested,
+ * in which case only the outermost commit writes to disk.
+ *
+ * Returns: #TRUE for success, #FALSE for failure
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_history_start_batch (FuHistory *self, GError **error)
+{
+	gint rc;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
+
+	/* lazy load */
+	if (!fu_history_load (self, error))
+		return FALSE;
+
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, FALSE);
+	if (self->batch_depth++ > 0)
+		return TRUE;
+	rc = sqlite3_exec (self->db, "BEGIN TRANSACTION;", NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		self->batch_depth--;
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_WRITE,
+			     "Failed to start transaction: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_history_commit_batch:
+ * @self: A #FuHistory
+ * @error: A #GError or NULL
+ *
+ * Commits all the writes since fu_history_start_batch() was called.
+ *
+ * Returns: #TRUE for success, #FALSE for failure
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fu_history_commit_batch (FuHistory *self, GError **error)
+{
+	gint rc;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
+	g_return_val_if_fail (self->batch_depth > 0, FALSE);
+
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, FALSE);
+	if (--self->batch_depth > 0)
+		return TRUE;
+	rc = sqlite3_exec (self->db, "COMMIT;", NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_WRITE,
+			     "Failed to commit transaction: %s",
+			     sqlite3_errmsg (self->db));
+		sqlite3_exec (self->db, "ROLLBACK;", NULL, NULL, NULL);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* the page cache and the prepared statements, which are only allocated once
+ * the database has been opened */
+gsize
+fu_history_get_memory_usage (FuHistory *self, guint *stmts)
+{
+	gint cache_used = 0;
+	gint stmt_used = 0;
+	gint hiwtr = 0;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), 0);
+
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, 0);
+	if (stmts != NULL)
+		*stmts = g_hash_table_size (self->stmts);
+	if (self->db == NULL)
+		return 0;
+	sqlite3_db_status (self->db, SQLITE_DBSTATUS_CACHE_USED, &cache_used, &hiwtr, FALSE);
+	sqlite3_db_status (self->db, SQLITE_DBSTATUS_STMT_USED, &stmt_used, &hiwtr, FALSE);
+	return (gsize) cache_used + (gsize) stmt_used;
+}
+
+/* statements are prepared again when next used */
+void
+fu_history_trim (FuHistory *self)
+{
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+
+	g_return_if_fail (FU_IS_HISTORY (self));
+
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_if_fail (locker != NULL);
+	g_hash_table_remove_all (self->stmts);
+	if (self->db != NULL)
+		sqlite3_db_release_memory (self->db);
+}
+
 static void
 fu_history_class_init (FuHistoryClass *klass)
 {
@@ -1019,6 +1643,8 @@ static void
 fu_history_init (FuHistory *self)
 {
 	g_rw_lock_init (&self->db_mutex);
+	self->stmts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					     (GDestroyNotify) sqlite3_finalize);
 }
 
 static void
@@ -1026,6 +1652,7 @@ fu_history_finalize (GObject *object)
 {
 	FuHistory *self = FU_HISTORY (object);
 
+	g_hash_table_unref (self->stmts);
 	if (self->db != NULL)
 		sqlite3_close (self->db);
 	g_rw_lock_clear (&self->db_mutex);
@@ -10,6 +10,14 @@
 
 #include "fu-device.h"
 
+/* set on the device by the engine during the update, in ms */
+#define FU_HISTORY_METADATA_DURATION_DETACH	"DurationDetach"
+#define FU_HISTORY_METADATA_DURATION_WRITE	"DurationWrite"
+#define FU_HISTORY_METADATA_DURATION_ATTACH	"DurationAttach"
+#define FU_HISTORY_METADATA_DURATION_RELOAD	"DurationReload"
+#define FU_HISTORY_METADATA_BYTES_WRITTEN	"BytesWritten"
+#define FU_HISTORY_METADATA_DEBUG_LOG		"DebugLog"
+
 #define FU_TYPE_PENDING (fu_history_get_type ())
 G_DECLARE_FINAL_TYPE (FuHistory, fu_history, FU, HISTORY, GObject)
 
@@ -35,6 +43,13 @@ FuDevice	*fu_history_get_device_by_id		(FuHistory	*self,
 							 GError		**error);
 GPtrArray	*fu_history_get_devices			(FuHistory	*self,
 							 GError		**error);
+GPtrArray	*fu_history_get_devices_full		(FuHistory	*self,
+							 const gchar	*device_id,
+							 FwupdUpdateState update_state,
+							 guint64	 since,
+							 guint		 limit,
+							 guint		 offset,
+							 GError		**error);
 
 gboolean	 fu_history_clear_approved_firmware	(FuHistory	*self,
 							 GError		**error);
@@ -43,3 +58,28 @@ gboolean	 fu_history_add_approved_firmware	(FuHistory	*self,
 							 GError		**error);
 GPtrArray	*fu_history_get_approved_firmware	(FuHistory	*self,
 							 GError		**error);
+gboolean	 fu_history_set_approved_firmware	(FuHistory	*self,
+							 GPtrArray	*checksums,
+							 GError		**error);
+
+GPtrArray	*fu_history_get_verify_cache		(FuHistory	*self,
+							 const gchar	*device_id,
+							 const gchar	*version,
+							 const gchar	*engine_id,
+							 guint64	 generation,
+							 GError		**error);
+gboolean	 fu_history_set_verify_cache		(FuHistory	*self,
+							 const gchar	*device_id,
+							 const gchar	*version,
+							 const gchar	*engine_id,
+							 guint64	 generation,
+							 GPtrArray	*checksums,
+							 GError		**error);
+
+gboolean	 fu_history_start_batch			(FuHistory	*self,
+							 GError		**error);
+gboolean	 fu_history_commit_batch		(FuHistory	*self,
+							 GError		**error);
+gsize		 fu_history_get_memory_usage		(FuHistory	*self,
+							 guint		*stmts);
+void		 fu_history_trim			(FuHistory	*self);
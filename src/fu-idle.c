@@ -15,6 +15,9 @@
 
 static void fu_idle_finalize	 (GObject *obj);
 
+/* how long there must be no client activity before running tasks */
+#define FU_IDLE_TASK_DELAY			2	/* s */
+
 struct _FuIdle
 {
 	GObject			 parent_instance;
@@ -23,6 +26,11 @@ struct _FuIdle
 	guint			 idle_id;
 	guint			 timeout;
 	FwupdStatus		 status;
+	GPtrArray		*tasks;	/* of FuIdleTask */
+	guint			 task_id;
+	guint			 tasks_paused;
+	gboolean		 task_running;
+	gint64			 activity;	/* monotonic */
 };
 
 enum {
@@ -60,6 +68,12 @@ typedef struct {
 	guint32			 token;
 } FuIdleItem;
 
+typedef struct {
+	gchar			*id;
+	FuIdleTaskFunc		 func;
+	gpointer		 user_data;
+} FuIdleTask;
+
 G_DEFINE_TYPE (FuIdle, fu_idle, G_TYPE_OBJECT)
 
 FwupdStatus
@@ -97,6 +111,134 @@ fu_idle_start (FuIdle *self)
 	self->idle_id = g_timeout_add_seconds (self->timeout, fu_idle_check_cb, self);
 }
 
+static gboolean fu_idle_task_delay_cb (gpointer user_data);
+
+/* one step of the first task each time the main loop has nothing else to do */
+static gboolean
+fu_idle_task_run_cb (gpointer user_data)
+{
+	FuIdle *self = FU_IDLE (user_data);
+	FuIdleTask *task;
+	gint64 quiet = g_get_monotonic_time () - self->activity;
+
+	/* resumed by fu_idle_resume_tasks() */
+	if (self->tasks_paused > 0) {
+		self->task_id = 0;
+		return G_SOURCE_REMOVE;
+	}
+
+	/* a client is active, so wait for it to go away again */
+	if (quiet < FU_IDLE_TASK_DELAY * G_USEC_PER_SEC) {
+		self->task_id = g_timeout_add_seconds_full (G_PRIORITY_LOW,
+							    FU_IDLE_TASK_DELAY,
+							    fu_idle_task_delay_cb,
+							    self, NULL);
+		return G_SOURCE_REMOVE;
+	}
+
+	task = g_ptr_array_index (self->tasks, 0);
+	self->task_running = TRUE;
+	if (!task->func (task->user_data)) {
+		g_debug ("idle task %s complete", task->id);
+		g_ptr_array_remove (self->tasks, task);
+	}
+	self->task_running = FALSE;
+	if (self->tasks->len > 0)
+		return G_SOURCE_CONTINUE;
+
+	/* the daemon can now exit */
+	self->task_id = 0;
+	fu_idle_reset (self);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+fu_idle_task_delay_cb (gpointer user_data)
+{
+	FuIdle *self = FU_IDLE (user_data);
+	self->task_id = g_idle_add_full (G_PRIORITY_LOW, fu_idle_task_run_cb, self, NULL);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+fu_idle_task_schedule (FuIdle *self)
+{
+	if (self->task_id != 0)
+		return;
+	if (self->tasks->len == 0 || self->tasks_paused > 0)
+		return;
+	self->task_id = g_timeout_add_seconds_full (G_PRIORITY_LOW,
+						    FU_IDLE_TASK_DELAY,
+						    fu_idle_task_delay_cb,
+						    self, NULL);
+}
+
+static void
+fu_idle_task_free (FuIdleTask *task)
+{
+	g_free (task->id);
+	g_free (task);
+}
+
+/* low-priority work run when no clients have been active for a few seconds,
+ * called until it returns FALSE -- the daemon does not exit on idle while
+ * any are pending, and adding a task with the same ID again does nothing */
+void
+fu_idle_add_task (FuIdle *self, const gchar *id, FuIdleTaskFunc func, gpointer user_data)
+{
+	FuIdleTask *task;
+
+	g_return_if_fail (FU_IS_IDLE (self));
+	g_return_if_fail (id != NULL);
+	g_return_if_fail (func != NULL);
+
+	for (guint i = 0; i < self->tasks->len; i++) {
+		FuIdleTask *task_tmp = g_ptr_array_index (self->tasks, i);
+		if (g_strcmp0 (task_tmp->id, id) == 0)
+			return;
+	}
+	task = g_new0 (FuIdleTask, 1);
+	task->id = g_strdup (id);
+	task->func = func;
+	task->user_data = user_data;
+	g_ptr_array_add (self->tasks, task);
+	fu_idle_stop (self);
+	fu_idle_task_schedule (self);
+}
+
+/* typically called when @user_data is being destroyed */
+void
+fu_idle_remove_tasks (FuIdle *self, gpointer user_data)
+{
+	g_return_if_fail (FU_IS_IDLE (self));
+	for (guint i = self->tasks->len; i > 0; i--) {
+		FuIdleTask *task = g_ptr_array_index (self->tasks, i - 1);
+		if (task->user_data == user_data)
+			g_ptr_array_remove_index (self->tasks, i - 1);
+	}
+	if (self->tasks->len == 0 && self->task_id != 0) {
+		g_source_remove (self->task_id);
+		self->task_id = 0;
+	}
+}
+
+/* for instance when a device is being updated */
+void
+fu_idle_pause_tasks (FuIdle *self)
+{
+	g_return_if_fail (FU_IS_IDLE (self));
+	self->tasks_paused++;
+}
+
+void
+fu_idle_resume_tasks (FuIdle *self)
+{
+	g_return_if_fail (FU_IS_IDLE (self));
+	g_return_if_fail (self->tasks_paused > 0);
+	if (--self->tasks_paused == 0)
+		fu_idle_task_schedule (self);
+}
+
 static void
 fu_idle_stop (FuIdle *self)
 {
@@ -110,9 +252,14 @@ void
 fu_idle_reset (FuIdle *self)
 {
 	g_return_if_fail (FU_IS_IDLE (self));
+
+	/* a task making changes is not client activity */
+	if (!self->task_running)
+		self->activity = g_get_monotonic_time ();
 	fu_idle_stop (self);
-	if (self->items->len == 0)
+	if (self->items->len == 0 && self->tasks->len == 0)
 		fu_idle_start (self);
+	fu_idle_task_schedule (self);
 }
 
 void
@@ -213,6 +360,7 @@ fu_idle_init (FuIdle *self)
 {
 	self->status = FWUPD_STATUS_IDLE;
 	self->items = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_idle_item_free);
+	self->tasks = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_idle_task_free);
 	g_rw_lock_init (&self->items_mutex);
 }
 
@@ -222,7 +370,10 @@ fu_idle_finalize (GObject *obj)
 	FuIdle *self = FU_IDLE (obj);
 
 	fu_idle_stop (self);
+	if (self->task_id != 0)
+		g_source_remove (self->task_id);
 	g_ptr_array_unref (self->items);
+	g_ptr_array_unref (self->tasks);
 	g_rw_lock_clear (&self->items_mutex);
 
 	G_OBJECT_CLASS (fu_idle_parent_class)->finalize (obj);
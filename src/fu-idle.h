@@ -14,6 +14,9 @@
 #define FU_TYPE_IDLE (fu_idle_get_type ())
 G_DECLARE_FINAL_TYPE (FuIdle, fu_idle, FU, IDLE, GObject)
 
+/* returns %TRUE if there is more work to do */
+typedef gboolean (*FuIdleTaskFunc)		(gpointer	 user_data);
+
 FuIdle		*fu_idle_new			(void);
 guint32		 fu_idle_inhibit		(FuIdle		*self,
 						 const gchar	*reason);
@@ -23,6 +26,14 @@ void		 fu_idle_set_timeout		(FuIdle		*self,
 						 guint		 timeout);
 void		 fu_idle_reset			(FuIdle		*self);
 FwupdStatus	 fu_idle_get_status		(FuIdle		*self);
+void		 fu_idle_add_task		(FuIdle		*self,
+						 const gchar	*id,
+						 FuIdleTaskFunc	 func,
+						 gpointer	 user_data);
+void		 fu_idle_remove_tasks		(FuIdle		*self,
+						 gpointer	 user_data);
+void		 fu_idle_pause_tasks		(FuIdle		*self);
+void		 fu_idle_resume_tasks		(FuIdle		*self);
 
 /**
  * FuIdleLocker:
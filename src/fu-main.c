@@ -8,16 +8,28 @@
 
 #include "config.h"
 
+/* for memfd_create() and the file seals */
+#ifdef HAVE_MEMFD_CREATE
+#define _GNU_SOURCE
+#endif
+
 #include <xmlb.h>
 #include <fwupd.h>
 #include <gio/gunixfdlist.h>
 #include <glib/gi18n.h>
 #include <glib-unix.h>
+#include <glib/gstdio.h>
 #include <locale.h>
 #include <polkit/polkit.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <jcat.h>
+#include <unistd.h>
+#ifdef HAVE_MEMFD_CREATE
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
 
 #include "fwupd-device-private.h"
 #include "fwupd-security-attr-private.h"
@@ -31,6 +43,7 @@
 #include "fu-engine.h"
 #include "fu-install-task.h"
 #include "fu-security-attrs-private.h"
+#include "fu-trace-private.h"
 
 #ifndef HAVE_POLKIT_0_114
 #pragma clang diagnostic push
@@ -42,6 +55,9 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(PolkitSubject, g_object_unref)
 
 typedef struct {
 	GDBusConnection		*connection;
+	GDBusServer		*server;		/* nullable */
+	GPtrArray		*peer_connections;	/* of GDBusConnection */
+	GMutex			 peer_mutex;		/* for peer_connections */
 	GDBusNodeInfo		*introspection_daemon;
 	GDBusProxy		*proxy_uid;
 	GMainLoop		*loop;
@@ -54,8 +70,203 @@ typedef struct {
 	FuEngine		*engine;
 	gboolean		 update_in_progress;
 	gboolean		 pending_sigterm;
+	GMutex			 signal_mutex;	/* engine signals can be from threads */
+	guint			 signal_flush_id;
+	gboolean		 signal_changed;
+	gboolean		 signal_percentage;
+	guint			 percentage;
+	GHashTable		*signal_devices;	/* device-id:FuDevice */
+	GHashTable		*method_durations;	/* method:FuMainMethodDuration */
+	guint			 metrics_id;
+	gsize			 blob_cab_bytes;	/* held while waiting for polkit */
+	GHashTable		*auth_cache;		/* sender:action-id:gint64 expiry */
 } FuMainPrivate;
 
+/* how long a retained polkit authorization is reused, in s */
+#define FU_MAIN_AUTH_CACHE_TIMEOUT	10
+
+/* how often the metrics file is written, in s */
+#define FU_MAIN_METRICS_INTERVAL	15
+
+/* upper bounds of the method latency histogram, in µs, with a final +Inf */
+static const gint64 fu_main_method_buckets[] = {
+	1000, 10000, 100000, 1000000, 10000000
+};
+#define FU_MAIN_METHOD_BUCKETS		(G_N_ELEMENTS (fu_main_method_buckets) + 1)
+
+typedef struct {
+	guint			 count;
+	guint			 in_flight;
+	gint64			 total;		/* µs */
+	gint64			 auth;		/* µs, waiting for polkit */
+	gint64			 max;		/* µs */
+	guint64			 histogram[FU_MAIN_METHOD_BUCKETS];
+} FuMainMethodDuration;
+
+typedef struct {
+	FuMainMethodDuration	*duration;
+	gint64			 start;
+	gint64			 auth_start;
+	gint64			 auth;
+} FuMainMethodHelper;
+
+static FuMainMethodDuration *
+fu_main_method_duration_get (FuMainPrivate *priv, const gchar *method_name)
+{
+	FuMainMethodDuration *duration;
+	duration = g_hash_table_lookup (priv->method_durations, method_name);
+	if (duration == NULL) {
+		duration = g_new0 (FuMainMethodDuration, 1);
+		g_hash_table_insert (priv->method_durations,
+				     g_strdup (method_name),
+				     duration);
+	}
+	return duration;
+}
+
+/* called when the invocation is destroyed, i.e. after the reply was sent */
+static void
+fu_main_method_helper_free (FuMainMethodHelper *helper)
+{
+	FuMainMethodDuration *duration = helper->duration;
+	gint64 elapsed = g_get_monotonic_time () - helper->start;
+	guint idx = 0;
+
+	/* still waiting for polkit when the caller went away */
+	if (helper->auth_start != 0)
+		helper->auth += g_get_monotonic_time () - helper->auth_start;
+	while (idx < G_N_ELEMENTS (fu_main_method_buckets) &&
+	       elapsed > fu_main_method_buckets[idx])
+		idx++;
+	duration->histogram[idx]++;
+	duration->count++;
+	duration->in_flight--;
+	duration->total += elapsed;
+	duration->auth += helper->auth;
+	duration->max = MAX (duration->max, elapsed);
+	g_free (helper);
+}
+
+static void
+fu_main_method_auth_begin (GDBusMethodInvocation *invocation)
+{
+	FuMainMethodHelper *helper = g_object_get_data (G_OBJECT (invocation),
+							"fwupd::MethodHelper");
+	if (helper != NULL)
+		helper->auth_start = g_get_monotonic_time ();
+}
+
+static void
+fu_main_method_auth_end (GDBusMethodInvocation *invocation)
+{
+	FuMainMethodHelper *helper = g_object_get_data (G_OBJECT (invocation),
+							"fwupd::MethodHelper");
+	if (helper == NULL || helper->auth_start == 0)
+		return;
+	helper->auth += g_get_monotonic_time () - helper->auth_start;
+	helper->auth_start = 0;
+}
+
+static GVariant *
+fu_main_method_durations_to_variant (FuMainPrivate *priv)
+{
+	GVariantBuilder builder;
+	g_autoptr(GList) methods = g_hash_table_get_keys (priv->method_durations);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sa{sv}}"));
+	methods = g_list_sort (methods, (GCompareFunc) g_strcmp0);
+	for (GList *l = methods; l != NULL; l = l->next) {
+		const gchar *method_name = l->data;
+		FuMainMethodDuration *duration = g_hash_table_lookup (priv->method_durations,
+								      method_name);
+		GVariantBuilder dict;
+		g_variant_builder_init (&dict, G_VARIANT_TYPE_VARDICT);
+		g_variant_builder_add (&dict, "{sv}", "Count",
+				       g_variant_new_uint32 (duration->count));
+		g_variant_builder_add (&dict, "{sv}", "InFlight",
+				       g_variant_new_uint32 (duration->in_flight));
+		g_variant_builder_add (&dict, "{sv}", "DurationTotal",
+				       g_variant_new_uint64 (duration->total));
+		g_variant_builder_add (&dict, "{sv}", "DurationAuth",
+				       g_variant_new_uint64 (duration->auth));
+		g_variant_builder_add (&dict, "{sv}", "DurationMax",
+				       g_variant_new_uint64 (duration->max));
+		g_variant_builder_add (&dict, "{sv}", "Histogram",
+				       g_variant_new_fixed_array (G_VARIANT_TYPE_UINT64,
+								  duration->histogram,
+								  FU_MAIN_METHOD_BUCKETS,
+								  sizeof (guint64)));
+		g_variant_builder_add (&builder, "{sa{sv}}", method_name, &dict);
+	}
+	return g_variant_new ("(a{sa{sv}})", &builder);
+}
+
+static gboolean
+fu_main_metrics_write_cb (gpointer user_data)
+{
+	FuMainPrivate *priv = (FuMainPrivate *) user_data;
+	const gchar *filename = fu_engine_get_metrics_file (priv->engine);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GList) methods = NULL;
+	g_autoptr(GString) str = NULL;
+
+	/* not enabled */
+	if (filename == NULL)
+		return G_SOURCE_CONTINUE;
+
+	str = g_string_new (NULL);
+	fu_engine_add_metrics (priv->engine, str);
+	methods = g_hash_table_get_keys (priv->method_durations);
+	methods = g_list_sort (methods, (GCompareFunc) g_strcmp0);
+	g_string_append (str, "# TYPE fwupd_install_cabinet_bytes gauge\n");
+	g_string_append (str, "# HELP fwupd_install_cabinet_bytes Size of the cabinet archives waiting to be installed\n");
+	g_string_append_printf (str, "fwupd_install_cabinet_bytes %" G_GSIZE_FORMAT "\n",
+				priv->blob_cab_bytes);
+	g_string_append (str, "# TYPE fwupd_dbus_method_seconds histogram\n");
+	g_string_append (str, "# HELP fwupd_dbus_method_seconds Time taken to reply to D-Bus method calls\n");
+	for (GList *l = methods; l != NULL; l = l->next) {
+		const gchar *method_name = l->data;
+		FuMainMethodDuration *duration = g_hash_table_lookup (priv->method_durations,
+								      method_name);
+		guint64 cumulative = 0;
+		for (guint i = 0; i < G_N_ELEMENTS (fu_main_method_buckets); i++) {
+			cumulative += duration->histogram[i];
+			g_string_append_printf (str, "fwupd_dbus_method_seconds_bucket{method=\"%s\",le=\"%g\"} %" G_GUINT64_FORMAT "\n",
+						method_name,
+						(gdouble) fu_main_method_buckets[i] / G_USEC_PER_SEC,
+						cumulative);
+		}
+		g_string_append_printf (str, "fwupd_dbus_method_seconds_bucket{method=\"%s\",le=\"+Inf\"} %u\n",
+					method_name, duration->count);
+		g_string_append_printf (str, "fwupd_dbus_method_seconds_count{method=\"%s\"} %u\n",
+					method_name, duration->count);
+		g_string_append_printf (str, "fwupd_dbus_method_seconds_sum{method=\"%s\"} %.6f\n",
+					method_name, (gdouble) duration->total / G_USEC_PER_SEC);
+	}
+	g_string_append (str, "# TYPE fwupd_dbus_method_auth_seconds counter\n");
+	g_string_append (str, "# HELP fwupd_dbus_method_auth_seconds Time D-Bus method calls spent waiting for polkit\n");
+	for (GList *l = methods; l != NULL; l = l->next) {
+		const gchar *method_name = l->data;
+		FuMainMethodDuration *duration = g_hash_table_lookup (priv->method_durations,
+								      method_name);
+		g_string_append_printf (str, "fwupd_dbus_method_auth_seconds_total{method=\"%s\"} %.6f\n",
+					method_name, (gdouble) duration->auth / G_USEC_PER_SEC);
+	}
+	g_string_append (str, "# TYPE fwupd_dbus_method_in_flight gauge\n");
+	g_string_append (str, "# HELP fwupd_dbus_method_in_flight D-Bus method calls not yet replied to\n");
+	for (GList *l = methods; l != NULL; l = l->next) {
+		const gchar *method_name = l->data;
+		FuMainMethodDuration *duration = g_hash_table_lookup (priv->method_durations,
+								      method_name);
+		g_string_append_printf (str, "fwupd_dbus_method_in_flight{method=\"%s\"} %u\n",
+					method_name, duration->in_flight);
+	}
+	g_string_append (str, "# EOF\n");
+	if (!g_file_set_contents (filename, str->str, str->len, &error))
+		g_warning ("failed to write metrics: %s", error->message);
+	return G_SOURCE_CONTINUE;
+}
+
 static gboolean
 fu_main_sigterm_cb (gpointer user_data)
 {
@@ -69,110 +280,228 @@ fu_main_sigterm_cb (gpointer user_data)
 	return G_SOURCE_CONTINUE;
 }
 
+/* clients on the private socket get every signal too */
+static gboolean
+fu_main_has_listeners (FuMainPrivate *priv)
+{
+	gboolean ret;
+	if (priv->connection != NULL)
+		return TRUE;
+	g_mutex_lock (&priv->peer_mutex);
+	ret = priv->peer_connections->len > 0;
+	g_mutex_unlock (&priv->peer_mutex);
+	return ret;
+}
+
 static void
-fu_main_engine_changed_cb (FuEngine *engine, FuMainPrivate *priv)
+fu_main_emit_signal (FuMainPrivate *priv,
+		     const gchar *interface_name,
+		     const gchar *signal_name,
+		     GVariant *parameters)
+{
+	g_autoptr(GPtrArray) peers = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	g_autoptr(GVariant) val = NULL;
+
+	/* status changes can be emitted from threads */
+	g_mutex_lock (&priv->peer_mutex);
+	for (guint i = 0; i < priv->peer_connections->len; i++)
+		g_ptr_array_add (peers, g_object_ref (g_ptr_array_index (priv->peer_connections, i)));
+	g_mutex_unlock (&priv->peer_mutex);
+
+	if (parameters != NULL)
+		val = g_variant_ref_sink (parameters);
+	if (priv->connection != NULL) {
+		g_dbus_connection_emit_signal (priv->connection,
+					       NULL,
+					       FWUPD_DBUS_PATH,
+					       interface_name,
+					       signal_name,
+					       val, NULL);
+	}
+	for (guint i = 0; i < peers->len; i++) {
+		GDBusConnection *connection = g_ptr_array_index (peers, i);
+		g_dbus_connection_emit_signal (connection,
+					       NULL,
+					       FWUPD_DBUS_PATH,
+					       interface_name,
+					       signal_name,
+					       val, NULL);
+	}
+}
+
+static void
+fu_main_emit_property_changed (FuMainPrivate *priv,
+			       const gchar *property_name,
+			       GVariant *property_value)
 {
+	GVariantBuilder builder;
+	GVariantBuilder invalidated_builder;
+
 	/* not yet connected */
-	if (priv->connection == NULL)
+	if (!fu_main_has_listeners (priv)) {
+		g_variant_unref (g_variant_ref_sink (property_value));
 		return;
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       FWUPD_DBUS_PATH,
-				       FWUPD_DBUS_INTERFACE,
-				       "Changed",
-				       NULL, NULL);
+	}
+
+	/* build the dict */
+	g_variant_builder_init (&invalidated_builder, G_VARIANT_TYPE ("as"));
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&builder,
+			       "{sv}",
+			       property_name,
+			       property_value);
+	fu_main_emit_signal (priv,
+			     "org.freedesktop.DBus.Properties",
+			     "PropertiesChanged",
+			     g_variant_new ("(sa{sv}as)",
+					    FWUPD_DBUS_INTERFACE,
+					    &builder,
+					    &invalidated_builder));
+	g_variant_builder_clear (&builder);
+	g_variant_builder_clear (&invalidated_builder);
 }
 
 static void
-fu_main_engine_device_added_cb (FuEngine *engine,
-				FuDevice *device,
-				FuMainPrivate *priv)
+fu_main_emit_device_changed (FuMainPrivate *priv, FuDevice *device)
 {
-	GVariant *val;
+	g_autoptr(GVariant) val = NULL;
 
 	/* not yet connected */
-	if (priv->connection == NULL)
+	if (!fu_main_has_listeners (priv))
 		return;
-	val = fwupd_device_to_variant (FWUPD_DEVICE (device));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       FWUPD_DBUS_PATH,
-				       FWUPD_DBUS_INTERFACE,
-				       "DeviceAdded",
-				       g_variant_new_tuple (&val, 1), NULL);
+	val = fwupd_device_to_variant_cached (FWUPD_DEVICE (device),
+					      FWUPD_DEVICE_FLAG_NONE);
+	fu_main_emit_signal (priv, FWUPD_DBUS_INTERFACE, "DeviceChanged",
+			     g_variant_new_tuple (&val, 1));
 }
 
+/* sends the final state of everything that changed since the last flush */
 static void
-fu_main_engine_device_removed_cb (FuEngine *engine,
-				  FuDevice *device,
-				  FuMainPrivate *priv)
+fu_main_signal_flush (FuMainPrivate *priv)
 {
-	GVariant *val;
+	gboolean signal_changed;
+	gboolean signal_percentage;
+	guint percentage;
+	GHashTableIter iter;
+	gpointer value;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	/* take the pending state so the engine can add to it while emitting */
+	g_mutex_lock (&priv->signal_mutex);
+	if (priv->signal_flush_id != 0) {
+		g_source_remove (priv->signal_flush_id);
+		priv->signal_flush_id = 0;
+	}
+	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	g_hash_table_iter_init (&iter, priv->signal_devices);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		g_ptr_array_add (devices, g_object_ref (value));
+	g_hash_table_remove_all (priv->signal_devices);
+	signal_changed = priv->signal_changed;
+	signal_percentage = priv->signal_percentage;
+	percentage = priv->percentage;
+	priv->signal_changed = FALSE;
+	priv->signal_percentage = FALSE;
+	g_mutex_unlock (&priv->signal_mutex);
 
-	/* not yet connected */
-	if (priv->connection == NULL)
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		fu_main_emit_device_changed (priv, device);
+	}
+	if (signal_changed)
+		fu_main_emit_signal (priv, FWUPD_DBUS_INTERFACE, "Changed", NULL);
+	if (signal_percentage) {
+		g_debug ("Emitting PropertyChanged('Percentage'='%u%%')", percentage);
+		fu_main_emit_property_changed (priv, "Percentage",
+					       g_variant_new_uint32 (percentage));
+	}
+}
+
+static gboolean
+fu_main_signal_flush_cb (gpointer user_data)
+{
+	FuMainPrivate *priv = (FuMainPrivate *) user_data;
+	g_mutex_lock (&priv->signal_mutex);
+	priv->signal_flush_id = 0;
+	g_mutex_unlock (&priv->signal_mutex);
+	fu_main_signal_flush (priv);
+	return G_SOURCE_REMOVE;
+}
+
+/* the timeout is not reset by later changes, so a constant stream of
+ * changes still gets sent once every interval */
+static void
+fu_main_signal_schedule (FuMainPrivate *priv)
+{
+	guint interval = fu_engine_get_signal_interval (priv->engine);
+	if (interval == 0) {
+		fu_main_signal_flush (priv);
 		return;
-	val = fwupd_device_to_variant (FWUPD_DEVICE (device));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       FWUPD_DBUS_PATH,
-				       FWUPD_DBUS_INTERFACE,
-				       "DeviceRemoved",
-				       g_variant_new_tuple (&val, 1), NULL);
+	}
+	g_mutex_lock (&priv->signal_mutex);
+	if (priv->signal_flush_id == 0)
+		priv->signal_flush_id = g_timeout_add (interval, fu_main_signal_flush_cb, priv);
+	g_mutex_unlock (&priv->signal_mutex);
 }
 
 static void
-fu_main_engine_device_changed_cb (FuEngine *engine,
-				  FuDevice *device,
-				  FuMainPrivate *priv)
+fu_main_engine_changed_cb (FuEngine *engine, FuMainPrivate *priv)
 {
-	GVariant *val;
+	g_mutex_lock (&priv->signal_mutex);
+	priv->signal_changed = TRUE;
+	g_mutex_unlock (&priv->signal_mutex);
+	fu_main_signal_schedule (priv);
+}
+
+static void
+fu_main_engine_device_added_cb (FuEngine *engine,
+				FuDevice *device,
+				FuMainPrivate *priv)
+{
+	g_autoptr(GVariant) val = NULL;
 
 	/* not yet connected */
-	if (priv->connection == NULL)
+	if (!fu_main_has_listeners (priv))
 		return;
-	val = fwupd_device_to_variant (FWUPD_DEVICE (device));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       FWUPD_DBUS_PATH,
-				       FWUPD_DBUS_INTERFACE,
-				       "DeviceChanged",
-				       g_variant_new_tuple (&val, 1), NULL);
+	val = fwupd_device_to_variant_cached (FWUPD_DEVICE (device),
+					      FWUPD_DEVICE_FLAG_NONE);
+	fu_main_emit_signal (priv, FWUPD_DBUS_INTERFACE, "DeviceAdded",
+			     g_variant_new_tuple (&val, 1));
 }
 
 static void
-fu_main_emit_property_changed (FuMainPrivate *priv,
-			       const gchar *property_name,
-			       GVariant *property_value)
+fu_main_engine_device_removed_cb (FuEngine *engine,
+				  FuDevice *device,
+				  FuMainPrivate *priv)
 {
-	GVariantBuilder builder;
-	GVariantBuilder invalidated_builder;
+	g_autoptr(GVariant) val = NULL;
+
+	/* never send a pending change after the device has gone */
+	g_mutex_lock (&priv->signal_mutex);
+	g_hash_table_remove (priv->signal_devices, fu_device_get_id (device));
+	g_mutex_unlock (&priv->signal_mutex);
 
 	/* not yet connected */
-	if (priv->connection == NULL) {
-		g_variant_unref (g_variant_ref_sink (property_value));
+	if (!fu_main_has_listeners (priv))
 		return;
-	}
+	val = fwupd_device_to_variant_cached (FWUPD_DEVICE (device),
+					      FWUPD_DEVICE_FLAG_NONE);
+	fu_main_emit_signal (priv, FWUPD_DBUS_INTERFACE, "DeviceRemoved",
+			     g_variant_new_tuple (&val, 1));
+}
 
-	/* build the dict */
-	g_variant_builder_init (&invalidated_builder, G_VARIANT_TYPE ("as"));
-	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
-	g_variant_builder_add (&builder,
-			       "{sv}",
-			       property_name,
-			       property_value);
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       FWUPD_DBUS_PATH,
-				       "org.freedesktop.DBus.Properties",
-				       "PropertiesChanged",
-				       g_variant_new ("(sa{sv}as)",
-				       FWUPD_DBUS_INTERFACE,
-				       &builder,
-				       &invalidated_builder),
-				       NULL);
-	g_variant_builder_clear (&builder);
-	g_variant_builder_clear (&invalidated_builder);
+static void
+fu_main_engine_device_changed_cb (FuEngine *engine,
+				  FuDevice *device,
+				  FuMainPrivate *priv)
+{
+	/* the device is converted when the signal is sent */
+	g_mutex_lock (&priv->signal_mutex);
+	g_hash_table_insert (priv->signal_devices,
+			     g_strdup (fu_device_get_id (device)),
+			     g_object_ref (device));
+	g_mutex_unlock (&priv->signal_mutex);
+	fu_main_signal_schedule (priv);
 }
 
 static void
@@ -189,6 +518,8 @@ fu_main_engine_status_changed_cb (FuEngine *engine,
 				  FwupdStatus status,
 				  FuMainPrivate *priv)
 {
+	/* keep the order the same as the engine */
+	fu_main_signal_flush (priv);
 	fu_main_set_status (priv, status);
 
 	/* engine has gone idle */
@@ -201,21 +532,46 @@ fu_main_engine_percentage_changed_cb (FuEngine *engine,
 				      guint percentage,
 				      FuMainPrivate *priv)
 {
-	g_debug ("Emitting PropertyChanged('Percentage'='%u%%')", percentage);
-	fu_main_emit_property_changed (priv, "Percentage",
-				       g_variant_new_uint32 (percentage));
+	g_mutex_lock (&priv->signal_mutex);
+	priv->percentage = percentage;
+	priv->signal_percentage = TRUE;
+	g_mutex_unlock (&priv->signal_mutex);
+	fu_main_signal_schedule (priv);
+}
+
+/* a peer connection has no bus name, so use the credentials of the socket */
+static PolkitSubject *
+fu_main_get_subject (GDBusConnection *connection, const gchar *sender)
+{
+	GCredentials *credentials;
+	if (sender != NULL)
+		return polkit_system_bus_name_new (sender);
+	credentials = g_dbus_connection_get_peer_credentials (connection);
+	return polkit_unix_process_new_for_owner (g_credentials_get_unix_pid (credentials, NULL),
+						  0, /* start time */
+						  g_credentials_get_unix_user (credentials, NULL));
 }
 
 static gboolean
-fu_main_get_device_flags_for_sender (FuMainPrivate *priv, const char *sender,
-				     FwupdDeviceFlags *flags, GError **error)
+fu_main_get_device_flags_for_sender (FuMainPrivate *priv,
+				     GDBusConnection *connection,
+				     const char *sender,
+				     FwupdDeviceFlags *flags,
+				     GError **error)
 {
 	uid_t calling_uid;
 	g_autoptr(GVariant) value = NULL;
 
-	g_return_val_if_fail (sender != NULL, FALSE);
 	g_return_val_if_fail (flags != NULL, FALSE);
 
+	/* already checked when the peer connected */
+	if (sender == NULL) {
+		GCredentials *credentials = g_dbus_connection_get_peer_credentials (connection);
+		if (g_credentials_get_unix_user (credentials, NULL) == 0)
+			*flags |= FWUPD_DEVICE_FLAG_TRUSTED;
+		return TRUE;
+	}
+
 	value = g_dbus_proxy_call_sync (priv->proxy_uid,
 					"GetConnectionUnixUser",
 					g_variant_new ("(s)", sender),
@@ -235,8 +591,11 @@ fu_main_get_device_flags_for_sender (FuMainPrivate *priv, const char *sender,
 }
 
 static GVariant *
-fu_main_device_array_to_variant (FuMainPrivate *priv, const gchar *sender,
-				 GPtrArray *devices, GError **error)
+fu_main_device_array_to_variant (FuMainPrivate *priv,
+				 GDBusConnection *connection,
+				 const gchar *sender,
+				 GPtrArray *devices,
+				 GError **error)
 {
 	GVariantBuilder builder;
 	FwupdDeviceFlags flags = FWUPD_DEVICE_FLAG_NONE;
@@ -244,18 +603,72 @@ fu_main_device_array_to_variant (FuMainPrivate *priv, const gchar *sender,
 	g_return_val_if_fail (devices->len > 0, NULL);
 	g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
 
-	if (!fu_main_get_device_flags_for_sender (priv, sender, &flags, error))
+	if (!fu_main_get_device_flags_for_sender (priv, connection, sender, &flags, error))
 		return NULL;
 
 	for (guint i = 0; i < devices->len; i++) {
 		FuDevice *device = g_ptr_array_index (devices, i);
-		GVariant *tmp = fwupd_device_to_variant_full (FWUPD_DEVICE (device),
-							      flags);
+		g_autoptr(GVariant) tmp = NULL;
+		tmp = fwupd_device_to_variant_cached (FWUPD_DEVICE (device), flags);
 		g_variant_builder_add_value (&builder, tmp);
 	}
 	return g_variant_new ("(aa{sv})", &builder);
 }
 
+/* the client can map this rather than copying a huge reply off the bus */
+static gint
+fu_main_variant_to_sealed_memfd (GVariant *value, GError **error)
+{
+#ifdef HAVE_MEMFD_CREATE
+	gint memfd;
+	gsize offset = 0;
+	gsize bufsz = g_variant_get_size (value);
+	const guint8 *buf = g_variant_get_data (value);
+
+	memfd = memfd_create ("fwupd-devices", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (memfd < 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "failed to create memfd: %s",
+			     g_strerror (errno));
+		return -1;
+	}
+	while (offset < bufsz) {
+		gssize wrote = write (memfd, buf + offset, bufsz - offset);
+		if (wrote < 0 && errno == EINTR)
+			continue;
+		if (wrote <= 0) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_WRITE,
+				     "failed to write memfd: %s",
+				     g_strerror (errno));
+			close (memfd);
+			return -1;
+		}
+		offset += wrote;
+	}
+	if (fcntl (memfd, F_ADD_SEALS,
+		   F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "failed to seal memfd: %s",
+			     g_strerror (errno));
+		close (memfd);
+		return -1;
+	}
+	return memfd;
+#else
+	g_set_error_literal (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "memfd_create() is not available");
+	return -1;
+#endif
+}
+
 static GVariant *
 fu_main_release_array_to_variant (GPtrArray *results)
 {
@@ -264,7 +677,7 @@ fu_main_release_array_to_variant (GPtrArray *results)
 	g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
 	for (guint i = 0; i < results->len; i++) {
 		FwupdRelease *rel = g_ptr_array_index (results, i);
-		GVariant *tmp = fwupd_release_to_variant (rel);
+		g_autoptr(GVariant) tmp = fwupd_release_to_variant_cached (rel);
 		g_variant_builder_add_value (&builder, tmp);
 	}
 	return g_variant_new ("(aa{sv})", &builder);
@@ -292,7 +705,8 @@ fu_main_result_array_to_variant (GPtrArray *results)
 	g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
 	for (guint i = 0; i < results->len; i++) {
 		FwupdDevice *result = g_ptr_array_index (results, i);
-		GVariant *tmp = fwupd_device_to_variant (result);
+		g_autoptr(GVariant) tmp = NULL;
+		tmp = fwupd_device_to_variant_cached (result, FWUPD_DEVICE_FLAG_NONE);
 		g_variant_builder_add_value (&builder, tmp);
 	}
 	return g_variant_new ("(aa{sv})", &builder);
@@ -317,8 +731,10 @@ typedef struct {
 static void
 fu_main_auth_helper_free (FuMainAuthHelper *helper)
 {
-	if (helper->blob_cab != NULL)
+	if (helper->blob_cab != NULL) {
+		helper->priv->blob_cab_bytes -= g_bytes_get_size (helper->blob_cab);
 		g_bytes_unref (helper->blob_cab);
+	}
 	if (helper->subject != NULL)
 		g_object_unref (helper->subject);
 	if (helper->silo != NULL)
@@ -337,6 +753,18 @@ fu_main_auth_helper_free (FuMainAuthHelper *helper)
 	g_free (helper);
 }
 
+/* drop everything only needed for the transaction in one go */
+static void
+fu_main_auth_helper_release_transaction (FuMainAuthHelper *helper)
+{
+	if (helper->blob_cab != NULL) {
+		helper->priv->blob_cab_bytes -= g_bytes_get_size (helper->blob_cab);
+		g_clear_pointer (&helper->blob_cab, g_bytes_unref);
+	}
+	g_clear_pointer (&helper->install_tasks, g_ptr_array_unref);
+	g_clear_object (&helper->silo);
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunused-function"
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuMainAuthHelper, fu_main_auth_helper_free)
@@ -370,19 +798,105 @@ fu_main_authorization_is_valid (PolkitAuthorizationResult *auth, GError **error)
 	return TRUE;
 }
 
+typedef struct {
+	FuMainPrivate		*priv;
+	gchar			*key;		/* nullable */
+} FuMainAuthCheck;
+
+static void
+fu_main_auth_check_free (FuMainAuthCheck *check)
+{
+	g_free (check->key);
+	g_free (check);
+}
+
+/* only results that polkit itself retains are cached, and only for bus
+ * names as they are never reused */
+static void
+fu_main_check_authorization_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	FuMainAuthCheck *check = g_task_get_task_data (task);
+	FuMainPrivate *priv = check->priv;
+	GError *error = NULL;
+	GHashTableIter iter;
+	gpointer value;
+	gint64 now = g_get_monotonic_time ();
+	g_autoptr(PolkitAuthorizationResult) auth = NULL;
+
+	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
+							    res, &error);
+	if (!fu_main_authorization_is_valid (auth, &error)) {
+		g_task_return_error (task, error);
+		return;
+	}
+	if (check->key != NULL &&
+	    (polkit_authorization_result_get_retains_authorization (auth) ||
+	     polkit_authorization_result_get_temporary_authorization_id (auth) != NULL)) {
+		gint64 *expiry = g_new0 (gint64, 1);
+		g_hash_table_iter_init (&iter, priv->auth_cache);
+		while (g_hash_table_iter_next (&iter, NULL, &value)) {
+			if (*((gint64 *) value) < now)
+				g_hash_table_iter_remove (&iter);
+		}
+		*expiry = now + FU_MAIN_AUTH_CACHE_TIMEOUT * G_USEC_PER_SEC;
+		g_hash_table_insert (priv->auth_cache, g_strdup (check->key), expiry);
+	}
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+fu_main_check_authorization (FuMainPrivate *priv,
+			     PolkitSubject *subject,
+			     const gchar *action_id,
+			     GAsyncReadyCallback callback,
+			     gpointer user_data)
+{
+	FuMainAuthCheck *check = g_new0 (FuMainAuthCheck, 1);
+	GTask *task = g_task_new (NULL, NULL, callback, user_data);
+
+	check->priv = priv;
+	g_task_set_task_data (task, check, (GDestroyNotify) fu_main_auth_check_free);
+
+	/* the same client already has a temporary authorization */
+	if (POLKIT_IS_SYSTEM_BUS_NAME (subject)) {
+		gint64 *expiry;
+		check->key = g_strdup_printf ("%s:%s",
+					      polkit_system_bus_name_get_name (POLKIT_SYSTEM_BUS_NAME (subject)),
+					      action_id);
+		expiry = g_hash_table_lookup (priv->auth_cache, check->key);
+		if (expiry != NULL && *expiry >= g_get_monotonic_time ()) {
+			g_debug ("using cached authorization for %s", check->key);
+			g_task_return_boolean (task, TRUE);
+			g_object_unref (task);
+			return;
+		}
+	}
+	polkit_authority_check_authorization (priv->authority, subject,
+					      action_id, NULL,
+					      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
+					      NULL,
+					      fu_main_check_authorization_cb,
+					      task);
+}
+
+static gboolean
+fu_main_check_authorization_finish (GAsyncResult *res, GError **error)
+{
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 static void
 fu_main_authorize_unlock_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
 
 
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	fu_main_method_auth_end (helper->invocation);
+	if (!fu_main_check_authorization_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -402,21 +916,19 @@ fu_main_authorize_set_approved_firmware_cb (GObject *source, GAsyncResult *res,
 {
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
 
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	fu_main_method_auth_end (helper->invocation);
+	if (!fu_main_check_authorization_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
 
-	/* success */
-	for (guint i = 0; i < helper->checksums->len; i++) {
-		const gchar *csum = g_ptr_array_index (helper->checksums, i);
-		fu_engine_add_approved_firmware (helper->priv->engine, csum);
+	/* save the whole list at once */
+	if (!fu_engine_set_approved_firmware (helper->priv->engine, helper->checksums, &error)) {
+		g_dbus_method_invocation_return_gerror (helper->invocation, error);
+		return;
 	}
 	g_dbus_method_invocation_return_value (helper->invocation, NULL);
 }
@@ -427,13 +939,11 @@ fu_main_authorize_self_sign_cb (GObject *source, GAsyncResult *res, gpointer use
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autofree gchar *sig = NULL;
 	g_autoptr(GError) error = NULL;
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
 
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	fu_main_method_auth_end (helper->invocation);
+	if (!fu_main_check_authorization_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -454,12 +964,10 @@ fu_main_modify_config_cb (GObject *source, GAsyncResult *res, gpointer user_data
 {
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
 
 	/* get result */
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	fu_main_method_auth_end (helper->invocation);
+	if (!fu_main_check_authorization_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -478,13 +986,11 @@ fu_main_authorize_activate_cb (GObject *source, GAsyncResult *res, gpointer user
 {
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
 
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	fu_main_method_auth_end (helper->invocation);
+	if (!fu_main_check_authorization_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -504,13 +1010,11 @@ fu_main_authorize_verify_update_cb (GObject *source, GAsyncResult *res, gpointer
 {
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
 
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	fu_main_method_auth_end (helper->invocation);
+	if (!fu_main_check_authorization_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -530,13 +1034,11 @@ fu_main_authorize_modify_remote_cb (GObject *source, GAsyncResult *res, gpointer
 {
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
 
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	fu_main_method_auth_end (helper->invocation);
+	if (!fu_main_check_authorization_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -562,13 +1064,11 @@ fu_main_authorize_install_cb (GObject *source, GAsyncResult *res, gpointer user_
 {
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
 
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	fu_main_method_auth_end (helper->invocation);
+	if (!fu_main_check_authorization_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -590,12 +1090,11 @@ fu_main_authorize_install_queue (FuMainAuthHelper *helper_ref)
 		g_autofree gchar *action_id = g_strdup (g_ptr_array_index (helper->action_ids, 0));
 		g_autoptr(PolkitSubject) subject = g_object_ref (helper->subject);
 		g_ptr_array_remove_index (helper->action_ids, 0);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      action_id, NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_install_cb,
-						      g_steal_pointer (&helper));
+		fu_main_method_auth_begin (helper->invocation);
+		fu_main_check_authorization (priv, subject,
+					     action_id,
+					     fu_main_authorize_install_cb,
+					     g_steal_pointer (&helper));
 		return;
 	}
 
@@ -607,6 +1106,11 @@ fu_main_authorize_install_queue (FuMainAuthHelper *helper_ref)
 				       helper->flags,
 				       &error);
 	priv->update_in_progress = FALSE;
+
+	/* the daemon is long running, so give back the firmware and the
+	 * parsed archive now rather than relying on the allocator */
+	fu_main_auth_helper_release_transaction (helper);
+	fu_engine_compact (priv->engine);
 	if (priv->pending_sigterm)
 		g_main_loop_quit (priv->loop);
 	if (!ret) {
@@ -805,12 +1309,29 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 			    GDBusMethodInvocation *invocation, gpointer user_data)
 {
 	FuMainPrivate *priv = (FuMainPrivate *) user_data;
+	FuMainMethodHelper *helper_method;
 	GVariant *val = NULL;
 	g_autoptr(GError) error = NULL;
 
 	/* activity */
+	FU_TRACE2 (dbus_method_call, sender, method_name);
 	fu_engine_idle_reset (priv->engine);
 
+	/* record how long the reply takes, which may be after polkit */
+	helper_method = g_new0 (FuMainMethodHelper, 1);
+	helper_method->duration = fu_main_method_duration_get (priv, method_name);
+	helper_method->duration->in_flight++;
+	helper_method->start = g_get_monotonic_time ();
+	g_object_set_data_full (G_OBJECT (invocation), "fwupd::MethodHelper", helper_method,
+				(GDestroyNotify) fu_main_method_helper_free);
+
+	if (g_strcmp0 (method_name, "GetStatistics") == 0) {
+		g_debug ("Called %s()", method_name);
+		val = fu_main_method_durations_to_variant (priv);
+		g_dbus_method_invocation_return_value (invocation, val);
+		return;
+	}
+
 	if (g_strcmp0 (method_name, "GetDevices") == 0) {
 		g_autoptr(GPtrArray) devices = NULL;
 		g_debug ("Called %s()", method_name);
@@ -819,7 +1340,7 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 			g_dbus_method_invocation_return_gerror (invocation, error);
 			return;
 		}
-		val = fu_main_device_array_to_variant (priv, sender, devices, &error);
+		val = fu_main_device_array_to_variant (priv, connection, sender, devices, &error);
 		if (val == NULL) {
 			g_dbus_method_invocation_return_gerror (invocation, error);
 			return;
@@ -827,6 +1348,75 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		g_dbus_method_invocation_return_value (invocation, val);
 		return;
 	}
+	if (g_strcmp0 (method_name, "GetDevicesFd") == 0) {
+		gint fd;
+		g_autoptr(GPtrArray) devices = NULL;
+		g_autoptr(GUnixFDList) fd_list = NULL;
+		g_autoptr(GVariant) snapshot = NULL;
+		g_debug ("Called %s()", method_name);
+		devices = fu_engine_get_devices (priv->engine, &error);
+		if (devices == NULL) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		val = fu_main_device_array_to_variant (priv, connection, sender, devices, &error);
+		if (val == NULL) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		snapshot = g_variant_ref_sink (val);
+		fd = fu_main_variant_to_sealed_memfd (snapshot, &error);
+		if (fd < 0) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+
+		/* g_unix_fd_list_append does a dup() */
+		fd_list = g_unix_fd_list_new ();
+		if (g_unix_fd_list_append (fd_list, fd, &error) < 0) {
+			close (fd);
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		close (fd);
+		g_dbus_method_invocation_return_value_with_unix_fd_list (invocation,
+									 g_variant_new ("(h)", 0),
+									 fd_list);
+		return;
+	}
+	if (g_strcmp0 (method_name, "GetDevicesSince") == 0) {
+		FwupdDeviceFlags flags = FWUPD_DEVICE_FLAG_NONE;
+		GVariantBuilder builder;
+		guint64 generation = 0;
+		g_autoptr(GPtrArray) devices = NULL;
+		g_autoptr(GPtrArray) removed = NULL;
+
+		g_variant_get (parameters, "(t)", &generation);
+		g_debug ("Called %s(%" G_GUINT64_FORMAT ")", method_name, generation);
+		devices = fu_engine_get_devices_since (priv->engine, generation,
+						       &removed, &error);
+		if (devices == NULL) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		if (!fu_main_get_device_flags_for_sender (priv, connection, sender, &flags, &error)) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+		for (guint i = 0; i < devices->len; i++) {
+			FuDevice *device = g_ptr_array_index (devices, i);
+			g_autoptr(GVariant) tmp = NULL;
+			tmp = fwupd_device_to_variant_cached (FWUPD_DEVICE (device), flags);
+			g_variant_builder_add_value (&builder, tmp);
+		}
+		g_ptr_array_add (removed, NULL);
+		val = g_variant_new ("(aa{sv}^ast)", &builder,
+				     (const gchar * const *) removed->pdata,
+				     fu_engine_get_generation (priv->engine));
+		g_dbus_method_invocation_return_value (invocation, val);
+		return;
+	}
 	if (g_strcmp0 (method_name, "GetReleases") == 0) {
 		const gchar *device_id;
 		g_autoptr(GPtrArray) releases = NULL;
@@ -876,14 +1466,12 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		helper->checksums = g_ptr_array_new_with_free_func (g_free);
 		for (guint i = 0; checksums[i] != NULL; i++)
 			g_ptr_array_add (helper->checksums, g_strdup (checksums[i]));
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.set-approved-firmware",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_set_approved_firmware_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_get_subject (connection, sender);
+		fu_main_method_auth_begin (helper->invocation);
+		fu_main_check_authorization (priv, subject,
+					     "org.freedesktop.fwupd.set-approved-firmware",
+					     fu_main_authorize_set_approved_firmware_cb,
+					     g_steal_pointer (&helper));
 		return;
 	}
 	if (g_strcmp0 (method_name, "SelfSign") == 0) {
@@ -915,14 +1503,12 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		helper->priv = priv;
 		helper->value = g_steal_pointer (&value);
 		helper->invocation = g_object_ref (invocation);
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.self-sign",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_self_sign_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_get_subject (connection, sender);
+		fu_main_method_auth_begin (helper->invocation);
+		fu_main_check_authorization (priv, subject,
+					     "org.freedesktop.fwupd.self-sign",
+					     fu_main_authorize_self_sign_cb,
+					     g_steal_pointer (&helper));
 		return;
 	}
 	if (g_strcmp0 (method_name, "GetDowngrades") == 0) {
@@ -961,6 +1547,36 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		g_dbus_method_invocation_return_value (invocation, val);
 		return;
 	}
+	if (g_strcmp0 (method_name, "GetAllUpgrades") == 0) {
+		GHashTableIter iter;
+		GVariantBuilder builder;
+		gpointer key, value;
+		g_autoptr(GHashTable) results = NULL;
+		g_debug ("Called %s()", method_name);
+		results = fu_engine_get_all_upgrades (priv->engine, &error);
+		if (results == NULL) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{saa{sv}}"));
+		g_hash_table_iter_init (&iter, results);
+		while (g_hash_table_iter_next (&iter, &key, &value)) {
+			GPtrArray *releases = (GPtrArray *) value;
+			GVariantBuilder builder_rels;
+			g_variant_builder_init (&builder_rels, G_VARIANT_TYPE ("aa{sv}"));
+			for (guint i = 0; i < releases->len; i++) {
+				FwupdRelease *rel = g_ptr_array_index (releases, i);
+				g_autoptr(GVariant) tmp = fwupd_release_to_variant_cached (rel);
+				g_variant_builder_add_value (&builder_rels, tmp);
+			}
+			g_variant_builder_add (&builder, "{saa{sv}}",
+					       (const gchar *) key, &builder_rels);
+		}
+		val = g_variant_builder_end (&builder);
+		g_dbus_method_invocation_return_value (invocation,
+						       g_variant_new_tuple (&val, 1));
+		return;
+	}
 	if (g_strcmp0 (method_name, "GetRemotes") == 0) {
 		g_autoptr(GPtrArray) remotes = NULL;
 		g_debug ("Called %s()", method_name);
@@ -981,7 +1597,57 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 			g_dbus_method_invocation_return_gerror (invocation, error);
 			return;
 		}
-		val = fu_main_device_array_to_variant (priv, sender, devices, &error);
+		val = fu_main_device_array_to_variant (priv, connection, sender, devices, &error);
+		if (val == NULL) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		g_dbus_method_invocation_return_value (invocation, val);
+		return;
+	}
+	if (g_strcmp0 (method_name, "GetHistoryFiltered") == 0) {
+		FwupdUpdateState update_state = FWUPD_UPDATE_STATE_UNKNOWN;
+		GVariant *prop_value;
+		const gchar *device_id = NULL;
+		gchar *prop_key;
+		guint limit = 0;
+		guint offset = 0;
+		guint64 since = 0;
+		g_autoptr(GPtrArray) devices = NULL;
+		g_autoptr(GVariantIter) iter = NULL;
+
+		g_variant_get (parameters, "(a{sv})", &iter);
+		while (g_variant_iter_next (iter, "{&sv}", &prop_key, &prop_value)) {
+			g_debug ("got option %s", prop_key);
+			if (g_strcmp0 (prop_key, "device-id") == 0 &&
+			    g_variant_is_of_type (prop_value, G_VARIANT_TYPE_STRING))
+				device_id = g_variant_get_string (prop_value, NULL);
+			if (g_strcmp0 (prop_key, "update-state") == 0 &&
+			    g_variant_is_of_type (prop_value, G_VARIANT_TYPE_UINT32))
+				update_state = g_variant_get_uint32 (prop_value);
+			if (g_strcmp0 (prop_key, "since") == 0 &&
+			    g_variant_is_of_type (prop_value, G_VARIANT_TYPE_UINT64))
+				since = g_variant_get_uint64 (prop_value);
+			if (g_strcmp0 (prop_key, "limit") == 0 &&
+			    g_variant_is_of_type (prop_value, G_VARIANT_TYPE_UINT32))
+				limit = g_variant_get_uint32 (prop_value);
+			if (g_strcmp0 (prop_key, "offset") == 0 &&
+			    g_variant_is_of_type (prop_value, G_VARIANT_TYPE_UINT32))
+				offset = g_variant_get_uint32 (prop_value);
+			g_variant_unref (prop_value);
+		}
+		g_debug ("Called %s(%s,%s,%" G_GUINT64_FORMAT ",%u,%u)",
+			 method_name, device_id,
+			 fwupd_update_state_to_string (update_state),
+			 since, limit, offset);
+		devices = fu_engine_get_history_full (priv->engine, device_id,
+						      update_state, since,
+						      limit, offset, &error);
+		if (devices == NULL) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		val = fu_main_device_array_to_variant (priv, connection, sender, devices, &error);
 		if (val == NULL) {
 			g_dbus_method_invocation_return_gerror (invocation, error);
 			return;
@@ -1106,14 +1772,12 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		helper->priv = priv;
 		helper->invocation = g_object_ref (invocation);
 		helper->device_id = g_strdup (device_id);
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.device-unlock",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_unlock_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_get_subject (connection, sender);
+		fu_main_method_auth_begin (helper->invocation);
+		fu_main_check_authorization (priv, subject,
+					     "org.freedesktop.fwupd.device-unlock",
+					     fu_main_authorize_unlock_cb,
+					     g_steal_pointer (&helper));
 		return;
 	}
 	if (g_strcmp0 (method_name, "Activate") == 0) {
@@ -1134,14 +1798,12 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		helper->priv = priv;
 		helper->invocation = g_object_ref (invocation);
 		helper->device_id = g_strdup (device_id);
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.device-activate",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_activate_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_get_subject (connection, sender);
+		fu_main_method_auth_begin (helper->invocation);
+		fu_main_check_authorization (priv, subject,
+					     "org.freedesktop.fwupd.device-activate",
+					     fu_main_authorize_activate_cb,
+					     g_steal_pointer (&helper));
 		return;
 	}
 	if (g_strcmp0 (method_name, "ModifyConfig") == 0) {
@@ -1159,14 +1821,12 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		helper->key = g_steal_pointer (&key);
 		helper->value = g_steal_pointer (&value);
 		helper->invocation = g_object_ref (invocation);
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.modify-config",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_modify_config_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_get_subject (connection, sender);
+		fu_main_method_auth_begin (helper->invocation);
+		fu_main_check_authorization (priv, subject,
+					     "org.freedesktop.fwupd.modify-config",
+					     fu_main_modify_config_cb,
+					     g_steal_pointer (&helper));
 		return;
 	}
 	if (g_strcmp0 (method_name, "ModifyRemote") == 0) {
@@ -1190,14 +1850,12 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 
 		/* authenticate */
 		fu_main_set_status (priv, FWUPD_STATUS_WAITING_FOR_AUTH);
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.modify-remote",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_modify_remote_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_get_subject (connection, sender);
+		fu_main_method_auth_begin (helper->invocation);
+		fu_main_check_authorization (priv, subject,
+					     "org.freedesktop.fwupd.modify-remote",
+					     fu_main_authorize_modify_remote_cb,
+					     g_steal_pointer (&helper));
 		return;
 	}
 	if (g_strcmp0 (method_name, "VerifyUpdate") == 0) {
@@ -1221,14 +1879,12 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 
 		/* authenticate */
 		fu_main_set_status (priv, FWUPD_STATUS_WAITING_FOR_AUTH);
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.verify-update",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_verify_update_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_get_subject (connection, sender);
+		fu_main_method_auth_begin (helper->invocation);
+		fu_main_check_authorization (priv, subject,
+					     "org.freedesktop.fwupd.verify-update",
+					     fu_main_authorize_verify_update_cb,
+					     g_steal_pointer (&helper));
 		return;
 	}
 	if (g_strcmp0 (method_name, "Verify") == 0) {
@@ -1246,6 +1902,29 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		g_dbus_method_invocation_return_value (invocation, NULL);
 		return;
 	}
+	if (g_strcmp0 (method_name, "VerifyAll") == 0) {
+		GHashTableIter iter;
+		GVariantBuilder builder;
+		gpointer key, value;
+		g_autoptr(GHashTable) results = NULL;
+		g_debug ("Called %s()", method_name);
+		results = fu_engine_verify_all (priv->engine, &error);
+		if (results == NULL) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{ss}"));
+		g_hash_table_iter_init (&iter, results);
+		while (g_hash_table_iter_next (&iter, &key, &value)) {
+			g_variant_builder_add (&builder, "{ss}",
+					       (const gchar *) key,
+					       (const gchar *) value);
+		}
+		val = g_variant_builder_end (&builder);
+		g_dbus_method_invocation_return_value (invocation,
+						       g_variant_new_tuple (&val, 1));
+		return;
+	}
 	if (g_strcmp0 (method_name, "Install") == 0) {
 		GVariant *prop_value;
 		const gchar *device_id = NULL;
@@ -1320,9 +1999,10 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 			g_dbus_method_invocation_return_gerror (invocation, error);
 			return;
 		}
+		priv->blob_cab_bytes += g_bytes_get_size (helper->blob_cab);
 
 		/* install all the things in the store */
-		helper->subject = polkit_system_bus_name_new (sender);
+		helper->subject = fu_main_get_subject (connection, sender);
 		if (!fu_main_install_with_helper (g_steal_pointer (&helper), &error)) {
 			g_dbus_method_invocation_return_gerror (invocation, error);
 			return;
@@ -1405,6 +2085,9 @@ fu_main_daemon_get_property (GDBusConnection *connection_, const gchar *sender,
 	if (g_strcmp0 (property_name, "HostSecurityId") == 0)
 		return g_variant_new_string (fu_engine_get_host_security_id (priv->engine));
 
+	if (g_strcmp0 (property_name, "StartupProfile") == 0)
+		return fu_engine_get_profile (priv->engine);
+
 	if (g_strcmp0 (property_name, "Interactive") == 0)
 		return g_variant_new_boolean (isatty (fileno (stdout)) != 0);
 
@@ -1417,6 +2100,23 @@ fu_main_daemon_get_property (GDBusConnection *connection_, const gchar *sender,
 	return NULL;
 }
 
+static guint
+fu_main_register_object (FuMainPrivate *priv, GDBusConnection *connection, GError **error)
+{
+	static const GDBusInterfaceVTable interface_vtable = {
+		fu_main_daemon_method_call,
+		fu_main_daemon_get_property,
+		NULL
+	};
+	return g_dbus_connection_register_object (connection,
+						  FWUPD_DBUS_PATH,
+						  priv->introspection_daemon->interfaces[0],
+						  &interface_vtable,
+						  priv,  /* user_data */
+						  NULL,  /* user_data_free_func */
+						  error);
+}
+
 static void
 fu_main_on_bus_acquired_cb (GDBusConnection *connection,
 			    const gchar *name,
@@ -1425,20 +2125,9 @@ fu_main_on_bus_acquired_cb (GDBusConnection *connection,
 	FuMainPrivate *priv = (FuMainPrivate *) user_data;
 	guint registration_id;
 	g_autoptr(GError) error = NULL;
-	static const GDBusInterfaceVTable interface_vtable = {
-		fu_main_daemon_method_call,
-		fu_main_daemon_get_property,
-		NULL
-	};
 
 	priv->connection = g_object_ref (connection);
-	registration_id = g_dbus_connection_register_object (connection,
-							     FWUPD_DBUS_PATH,
-							     priv->introspection_daemon->interfaces[0],
-							     &interface_vtable,
-							     priv,  /* user_data */
-							     NULL,  /* user_data_free_func */
-							     NULL); /* GError** */
+	registration_id = fu_main_register_object (priv, connection, NULL);
 	g_assert (registration_id > 0);
 
 	/* connect to D-Bus directly */
@@ -1458,6 +2147,115 @@ fu_main_on_bus_acquired_cb (GDBusConnection *connection,
 	}
 }
 
+/* only peers that can be identified can connect, as polkit needs a subject */
+static gboolean
+fu_main_server_allow_mechanism_cb (GDBusAuthObserver *observer,
+				   const gchar *mechanism,
+				   gpointer user_data)
+{
+	return g_strcmp0 (mechanism, "EXTERNAL") == 0;
+}
+
+static gboolean
+fu_main_server_authorize_peer_cb (GDBusAuthObserver *observer,
+				  GIOStream *stream,
+				  GCredentials *credentials,
+				  gpointer user_data)
+{
+	if (credentials == NULL)
+		return FALSE;
+	if (g_credentials_get_unix_pid (credentials, NULL) == -1)
+		return FALSE;
+	if (g_credentials_get_unix_user (credentials, NULL) == (uid_t) -1)
+		return FALSE;
+	return TRUE;
+}
+
+static void
+fu_main_peer_closed_cb (GDBusConnection *connection,
+			gboolean remote_peer_vanished,
+			GError *error,
+			gpointer user_data)
+{
+	FuMainPrivate *priv = (FuMainPrivate *) user_data;
+	g_debug ("peer connection closed");
+	g_signal_handlers_disconnect_by_data (connection, priv);
+	g_mutex_lock (&priv->peer_mutex);
+	g_ptr_array_remove (priv->peer_connections, connection);
+	g_mutex_unlock (&priv->peer_mutex);
+}
+
+static gboolean
+fu_main_server_new_connection_cb (GDBusServer *server,
+				  GDBusConnection *connection,
+				  gpointer user_data)
+{
+	FuMainPrivate *priv = (FuMainPrivate *) user_data;
+	g_autoptr(GError) error = NULL;
+
+	if (fu_main_register_object (priv, connection, &error) == 0) {
+		g_warning ("failed to register peer: %s", error->message);
+		return FALSE;
+	}
+	g_debug ("new peer connection");
+	g_mutex_lock (&priv->peer_mutex);
+	g_ptr_array_add (priv->peer_connections, g_object_ref (connection));
+	g_mutex_unlock (&priv->peer_mutex);
+	g_signal_connect (connection, "closed",
+			  G_CALLBACK (fu_main_peer_closed_cb), priv);
+	return TRUE;
+}
+
+/* large replies and signals are not copied through the bus daemon, and
+ * access is controlled by the permissions of the socket and then polkit */
+static gboolean
+fu_main_server_start (FuMainPrivate *priv, GError **error)
+{
+	const gchar *path = g_getenv ("FWUPD_DBUS_SOCKET");
+	g_autofree gchar *address = NULL;
+	g_autofree gchar *guid = NULL;
+	g_autofree gchar *path_escaped = NULL;
+	g_autoptr(GDBusAuthObserver) observer = NULL;
+
+	/* not enabled */
+	if (path == NULL || path[0] == '\0')
+		return TRUE;
+
+	/* remove the socket from a previous instance */
+	if (g_file_test (path, G_FILE_TEST_EXISTS) && g_unlink (path) != 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_FAILED,
+			     "failed to remove %s",
+			     path);
+		return FALSE;
+	}
+
+	observer = g_dbus_auth_observer_new ();
+	g_signal_connect (observer, "allow-mechanism",
+			  G_CALLBACK (fu_main_server_allow_mechanism_cb), priv);
+	g_signal_connect (observer, "authorize-authenticated-peer",
+			  G_CALLBACK (fu_main_server_authorize_peer_cb), priv);
+	path_escaped = g_dbus_address_escape_value (path);
+	address = g_strdup_printf ("unix:path=%s", path_escaped);
+	guid = g_dbus_generate_guid ();
+	priv->server = g_dbus_server_new_sync (address,
+					       G_DBUS_SERVER_FLAGS_NONE,
+					       guid,
+					       observer,
+					       NULL,
+					       error);
+	if (priv->server == NULL) {
+		g_prefix_error (error, "failed to listen on %s: ", path);
+		return FALSE;
+	}
+	g_signal_connect (priv->server, "new-connection",
+			  G_CALLBACK (fu_main_server_new_connection_cb), priv);
+	g_dbus_server_start (priv->server);
+	g_debug ("listening on %s", path);
+	return TRUE;
+}
+
 static void
 fu_main_on_name_acquired_cb (GDBusConnection *connection,
 			     const gchar *name,
@@ -1505,6 +2303,13 @@ fu_main_memory_monitor_warning_cb (GMemoryMonitor *memory_monitor,
 				   GMemoryMonitorWarningLevel level,
 				   FuMainPrivate *priv)
 {
+	/* drop the caches first, and only shut down if that was not enough */
+	fu_engine_trim (priv->engine);
+	if (level < G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM) {
+		g_debug ("low memory, dropped caches");
+		return;
+	}
+
 	/* can do straight away? */
 	if (priv->update_in_progress) {
 		g_warning ("OOM during a firmware update, ignoring");
@@ -1540,6 +2345,17 @@ fu_main_private_free (FuMainPrivate *priv)
 {
 	if (priv->loop != NULL)
 		g_main_loop_unref (priv->loop);
+	if (priv->signal_flush_id != 0)
+		g_source_remove (priv->signal_flush_id);
+	if (priv->signal_devices != NULL)
+		g_hash_table_unref (priv->signal_devices);
+	if (priv->metrics_id != 0)
+		g_source_remove (priv->metrics_id);
+	if (priv->method_durations != NULL)
+		g_hash_table_unref (priv->method_durations);
+	if (priv->auth_cache != NULL)
+		g_hash_table_unref (priv->auth_cache);
+	g_mutex_clear (&priv->signal_mutex);
 	if (priv->owner_id > 0)
 		g_bus_unown_name (priv->owner_id);
 	if (priv->proxy_uid != NULL)
@@ -1548,6 +2364,18 @@ fu_main_private_free (FuMainPrivate *priv)
 		g_object_unref (priv->engine);
 	if (priv->connection != NULL)
 		g_object_unref (priv->connection);
+	if (priv->server != NULL) {
+		g_dbus_server_stop (priv->server);
+		g_object_unref (priv->server);
+	}
+	if (priv->peer_connections != NULL) {
+		for (guint i = 0; i < priv->peer_connections->len; i++) {
+			GDBusConnection *connection = g_ptr_array_index (priv->peer_connections, i);
+			g_signal_handlers_disconnect_by_data (connection, priv);
+		}
+		g_ptr_array_unref (priv->peer_connections);
+	}
+	g_mutex_clear (&priv->peer_mutex);
 	if (priv->authority != NULL)
 		g_object_unref (priv->authority);
 	if (priv->argv0_monitor != NULL)
@@ -1606,6 +2434,14 @@ main (int argc, char *argv[])
 	/* create new objects */
 	priv = g_new0 (FuMainPrivate, 1);
 	priv->loop = g_main_loop_new (NULL, FALSE);
+	g_mutex_init (&priv->signal_mutex);
+	g_mutex_init (&priv->peer_mutex);
+	priv->auth_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	priv->peer_connections = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	priv->signal_devices = g_hash_table_new_full (g_str_hash, g_str_equal,
+						      g_free, (GDestroyNotify) g_object_unref);
+	priv->method_durations = g_hash_table_new_full (g_str_hash, g_str_equal,
+							g_free, g_free);
 
 	/* load engine */
 	priv->engine = fu_engine_new (FU_APP_FLAGS_NONE);
@@ -1632,6 +2468,12 @@ main (int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
+	/* export the metrics if enabled in the config */
+	fu_main_metrics_write_cb (priv);
+	priv->metrics_id = g_timeout_add_seconds (FU_MAIN_METRICS_INTERVAL,
+						  fu_main_metrics_write_cb,
+						  priv);
+
 	g_unix_signal_add_full (G_PRIORITY_DEFAULT,
 				SIGTERM, fu_main_sigterm_cb,
 				priv, NULL);
@@ -1674,6 +2516,12 @@ main (int argc, char *argv[])
 					 fu_main_on_name_lost_cb,
 					 priv, NULL);
 
+	/* optionally allow clients to connect directly */
+	if (!fu_main_server_start (priv, &error)) {
+		g_printerr ("Failed to start server: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+
 	/* Only timeout and close the mainloop if we have specified it
 	 * on the command line */
 	if (immediate_exit)
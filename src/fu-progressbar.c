@@ -16,6 +16,16 @@
 
 static void fu_progressbar_finalize	 (GObject *obj);
 
+/* how often the percentage is redrawn, so that a slow console is never the
+ * bottleneck when the device is sending many updates */
+#define FU_PROGRESSBAR_REFRESH_INTERVAL		100	/* ms */
+
+/* the shortest time used for each rate sample, in s */
+#define FU_PROGRESSBAR_RATE_SAMPLE_MIN		0.5
+
+/* the weight of the newest rate sample */
+#define FU_PROGRESSBAR_RATE_ALPHA		0.3
+
 struct _FuProgressbar
 {
 	GObject			 parent_instance;
@@ -27,9 +37,14 @@ struct _FuProgressbar
 	guint			 percentage;
 	guint			 to_erase;		/* chars */
 	guint			 timer_id;
+	guint			 refresh_id;
 	gint64			 last_animated;		/* monotonic */
-	GTimer			*time_elapsed;
-	gdouble			 last_estimate;
+	gint64			 last_refresh;		/* monotonic */
+	gint64			 rate_time;		/* monotonic, of the last sample */
+	guint			 rate_percentage;	/* of the last sample */
+	guint			 rate_samples;
+	gdouble			 rate;			/* smoothed, percent per second */
+	gdouble			 last_estimate;		/* s */
 	gboolean		 interactive;
 };
 
@@ -105,25 +120,53 @@ fu_progressbar_erase_line (FuProgressbar *self)
 	self->to_erase = 0;
 }
 
-static gboolean
-fu_progressbar_estimate_ready (FuProgressbar *self, guint percentage)
+static void
+fu_progressbar_estimate_reset (FuProgressbar *self, guint percentage)
+{
+	self->rate = 0;
+	self->rate_samples = 0;
+	self->rate_time = g_get_monotonic_time ();
+	self->rate_percentage = percentage;
+	self->last_estimate = 0;
+}
+
+/* the rate is smoothed so that a short stall or burst of writes does not
+ * make the estimate jump around, and is only updated when data arrives */
+static void
+fu_progressbar_estimate_update (FuProgressbar *self, guint percentage)
 {
-	gdouble old;
+	gint64 now = g_get_monotonic_time ();
 	gdouble elapsed;
+	gdouble rate;
 
 	/* now invalid */
-	if (percentage == 0 || percentage == 100) {
-		g_timer_start (self->time_elapsed);
-		self->last_estimate = 0;
-		return FALSE;
+	if (percentage == 0 || percentage == 100 ||
+	    percentage < self->rate_percentage) {
+		fu_progressbar_estimate_reset (self, percentage);
+		return;
 	}
 
-	old = self->last_estimate;
-	elapsed = g_timer_elapsed (self->time_elapsed, NULL);
-	self->last_estimate = elapsed / percentage * (100 - percentage);
+	/* wait for enough progress to measure */
+	elapsed = (gdouble) (now - self->rate_time) / G_USEC_PER_SEC;
+	if (percentage == self->rate_percentage ||
+	    elapsed < FU_PROGRESSBAR_RATE_SAMPLE_MIN)
+		return;
+	rate = (gdouble) (percentage - self->rate_percentage) / elapsed;
+	if (self->rate_samples++ == 0)
+		self->rate = rate;
+	else
+		self->rate = FU_PROGRESSBAR_RATE_ALPHA * rate + (1 - FU_PROGRESSBAR_RATE_ALPHA) * self->rate;
+	self->rate_time = now;
+	self->rate_percentage = percentage;
+	self->last_estimate = (100 - percentage) / self->rate;
+}
 
-	/* estimate is ready if we have decreased */
-	return old > self->last_estimate;
+static gboolean
+fu_progressbar_estimate_ready (FuProgressbar *self, guint percentage)
+{
+	if (percentage == 0 || percentage == 100)
+		return FALSE;
+	return self->rate_samples >= 3;
 }
 
 static gchar *
@@ -195,6 +238,7 @@ fu_progressbar_refresh (FuProgressbar *self, FwupdStatus status, guint percentag
 	/* dump to screen */
 	g_print ("%s", str->str);
 	self->to_erase = str->len;
+	self->last_refresh = g_get_monotonic_time ();
 
 	/* done */
 	if (is_idle_newline) {
@@ -263,7 +307,7 @@ fu_progressbar_spin_end (FuProgressbar *self)
 		self->timer_id = 0;
 
 		/* reset when the spinner has been stopped */
-		g_timer_start (self->time_elapsed);
+		fu_progressbar_estimate_reset (self, 0);
 	}
 
 	/* go back to the start when we next go into unknown percentage mode */
@@ -279,6 +323,15 @@ fu_progressbar_spin_start (FuProgressbar *self)
 	self->timer_id = g_timeout_add (40, fu_progressbar_spin_cb, self);
 }
 
+static gboolean
+fu_progressbar_refresh_cb (gpointer user_data)
+{
+	FuProgressbar *self = FU_PROGRESSBAR (user_data);
+	self->refresh_id = 0;
+	fu_progressbar_refresh (self, self->status, self->percentage);
+	return G_SOURCE_REMOVE;
+}
+
 /**
  * fu_progressbar_update:
  * @self: A #FuProgressbar
@@ -329,8 +382,23 @@ fu_progressbar_update (FuProgressbar *self, FwupdStatus status, guint percentage
 		fu_progressbar_spin_start (self);
 	}
 
-	/* update the terminal */
-	fu_progressbar_refresh (self, status, percentage);
+	fu_progressbar_estimate_update (self, percentage);
+
+	/* only show the latest percentage at a fixed rate, but always show
+	 * a change of status or the start and end straight away */
+	if (status != self->status ||
+	    status == FWUPD_STATUS_IDLE ||
+	    percentage == 0 || percentage == 100 ||
+	    (g_get_monotonic_time () - self->last_refresh) / 1000 >= FU_PROGRESSBAR_REFRESH_INTERVAL) {
+		if (self->refresh_id != 0) {
+			g_source_remove (self->refresh_id);
+			self->refresh_id = 0;
+		}
+		fu_progressbar_refresh (self, status, percentage);
+	} else if (self->refresh_id == 0) {
+		self->refresh_id = g_timeout_add (FU_PROGRESSBAR_REFRESH_INTERVAL,
+						  fu_progressbar_refresh_cb, self);
+	}
 
 	/* cache */
 	self->status = status;
@@ -400,8 +468,8 @@ fu_progressbar_init (FuProgressbar *self)
 	self->length_percentage = 40;
 	self->length_status = 25;
 	self->spinner_count_up = TRUE;
-	self->time_elapsed = g_timer_new ();
 	self->interactive = TRUE;
+	fu_progressbar_estimate_reset (self, 0);
 }
 
 static void
@@ -411,7 +479,8 @@ fu_progressbar_finalize (GObject *obj)
 
 	if (self->timer_id != 0)
 		g_source_remove (self->timer_id);
-	g_timer_destroy (self->time_elapsed);
+	if (self->refresh_id != 0)
+		g_source_remove (self->refresh_id);
 
 	G_OBJECT_CLASS (fu_progressbar_parent_class)->finalize (obj);
 }
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2020 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuQuirksCompile"
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include "fu-quirks-private.h"
+
+/* compiles DATADIR/quirks.d into DATADIR/quirks.xmlb when installing */
+int
+main (int argc, char *argv[])
+{
+	const gchar *destdir = g_getenv ("DESTDIR");
+	g_autofree gchar *path = NULL;
+	g_autofree gchar *xmlbfn = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file = NULL;
+
+	if (argc != 2) {
+		g_printerr ("usage: %s DATADIR\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	path = g_build_filename (destdir != NULL ? destdir : "", argv[1], NULL);
+	xmlbfn = g_build_filename (path, "quirks.xmlb", NULL);
+	file = g_file_new_for_path (xmlbfn);
+	if (!fu_quirks_compile (path, file, &error)) {
+		g_printerr ("failed to compile %s: %s\n", path, error->message);
+		return EXIT_FAILURE;
+	}
+	g_print ("Compiled quirks to %s\n", xmlbfn);
+	return EXIT_SUCCESS;
+}
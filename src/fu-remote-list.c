@@ -46,6 +46,24 @@ fu_remote_list_emit_changed (FuRemoteList *self)
 	g_signal_emit (self, signals[SIGNAL_CHANGED], 0);
 }
 
+/* compares every property of every remote, including the mtime of the
+ * metadata, so only a change the engine has to act on emits ::changed */
+static gboolean
+fu_remote_list_array_equal (GPtrArray *array1, GPtrArray *array2)
+{
+	if (array1->len != array2->len)
+		return FALSE;
+	for (guint i = 0; i < array1->len; i++) {
+		FwupdRemote *remote1 = g_ptr_array_index (array1, i);
+		FwupdRemote *remote2 = g_ptr_array_index (array2, i);
+		g_autoptr(GVariant) value1 = fwupd_remote_to_variant (remote1);
+		g_autoptr(GVariant) value2 = fwupd_remote_to_variant (remote2);
+		if (!g_variant_equal (value1, value2))
+			return FALSE;
+	}
+	return TRUE;
+}
+
 static void
 fu_remote_list_monitor_changed_cb (GFileMonitor *monitor,
 				   GFile *file,
@@ -56,9 +74,25 @@ fu_remote_list_monitor_changed_cb (GFileMonitor *monitor,
 	FuRemoteList *self = FU_REMOTE_LIST (user_data);
 	g_autoptr(GError) error = NULL;
 	g_autofree gchar *filename = g_file_get_path (file);
+	g_autoptr(GPtrArray) array_old = NULL;
+
+	/* a touch or a chmod does not change the contents */
+	if (event_type == G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED ||
+	    event_type == G_FILE_MONITOR_EVENT_PRE_UNMOUNT ||
+	    event_type == G_FILE_MONITOR_EVENT_UNMOUNTED)
+		return;
+
 	g_debug ("%s changed, reloading all remotes", filename);
+	array_old = g_steal_pointer (&self->array);
+	self->array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	if (!fu_remote_list_reload (self, &error))
 		g_warning ("failed to rescan remotes: %s", error->message);
+
+	/* config management often rewrites files with the same contents */
+	if (fu_remote_list_array_equal (array_old, self->array)) {
+		g_debug ("no remotes changed");
+		return;
+	}
 	fu_remote_list_emit_changed (self);
 }
 
@@ -183,6 +183,40 @@ fu_plugin_hash_func (gconstpointer user_data)
 	g_assert_true (ret);
 }
 
+static void
+fu_engine_profile_func (gconstpointer user_data)
+{
+	GVariantIter iter;
+	const gchar *name;
+	guint32 count;
+	guint64 duration;
+	gboolean ret;
+	gboolean seen_config = FALSE;
+	gboolean seen_plugins = FALSE;
+	g_autoptr(FuEngine) engine = fu_engine_new (FU_APP_FLAGS_NONE);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) profile = NULL;
+
+	ret = fu_engine_load (engine, FU_ENGINE_LOAD_FLAG_NO_ENUMERATE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* each phase is recorded once */
+	profile = fu_engine_get_profile (engine);
+	g_assert_cmpstr (g_variant_get_type_string (profile), ==, "a(sut)");
+	g_variant_iter_init (&iter, profile);
+	while (g_variant_iter_next (&iter, "(&sut)", &name, &count, &duration)) {
+		if (g_strcmp0 (name, "config") == 0) {
+			g_assert_cmpint (count, ==, 1);
+			seen_config = TRUE;
+		}
+		if (g_strcmp0 (name, "plugins") == 0)
+			seen_plugins = TRUE;
+	}
+	g_assert_true (seen_config);
+	g_assert_true (seen_plugins);
+}
+
 static void
 fu_engine_requirements_missing_func (gconstpointer user_data)
 {
@@ -916,6 +950,64 @@ fu_engine_device_priority_func (gconstpointer user_data)
 	g_assert_cmpstr (fu_device_get_name (device), ==, "BCD");
 }
 
+static void
+fu_engine_devices_since_func (gconstpointer user_data)
+{
+	guint64 generation;
+	g_autoptr(FuDevice) device1 = fu_device_new ();
+	g_autoptr(FuDevice) device2 = fu_device_new ();
+	g_autoptr(FuEngine) engine = fu_engine_new (FU_APP_FLAGS_NONE);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GPtrArray) removed = NULL;
+	g_autoptr(XbSilo) silo_empty = xb_silo_new ();
+
+	/* no metadata in daemon */
+	fu_engine_set_silo (engine, silo_empty);
+	g_assert_cmpint (fu_engine_get_generation (engine), ==, 0);
+
+	/* add one device */
+	fu_device_set_id (device1, "device1");
+	fu_device_add_instance_id (device1, "foobar1");
+	fu_device_convert_instance_ids (device1);
+	fu_engine_add_device (engine, device1);
+	generation = fu_engine_get_generation (engine);
+	g_assert_cmpint (generation, >, 0);
+
+	/* add another */
+	fu_device_set_id (device2, "device2");
+	fu_device_add_instance_id (device2, "foobar2");
+	fu_device_convert_instance_ids (device2);
+	fu_engine_add_device (engine, device2);
+	g_assert_cmpint (fu_engine_get_generation (engine), >, generation);
+
+	/* only the new device has changed */
+	devices = fu_engine_get_devices_since (engine, generation, &removed, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (devices);
+	g_assert_cmpint (devices->len, ==, 1);
+	g_assert (g_ptr_array_index (devices, 0) == device2);
+	g_assert_cmpint (removed->len, ==, 0);
+	g_clear_pointer (&devices, g_ptr_array_unref);
+	g_clear_pointer (&removed, g_ptr_array_unref);
+
+	/* full snapshot */
+	devices = fu_engine_get_devices_since (engine, 0, &removed, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (devices);
+	g_assert_cmpint (devices->len, ==, 2);
+	g_clear_pointer (&devices, g_ptr_array_unref);
+	g_clear_pointer (&removed, g_ptr_array_unref);
+
+	/* nothing changed */
+	devices = fu_engine_get_devices_since (engine,
+					       fu_engine_get_generation (engine),
+					       &removed, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (devices);
+	g_assert_cmpint (devices->len, ==, 0);
+}
+
 static void
 fu_engine_device_parent_func (gconstpointer user_data)
 {
@@ -2182,6 +2274,24 @@ fu_device_list_func (gconstpointer user_data)
 	device = fu_device_list_get_by_guid (device_list, "notfound", &error);
 	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
 	g_assert (device == NULL);
+	g_clear_error (&error);
+
+	/* find by abbreviated ID */
+	device = fu_device_list_get_by_id (device_list, "99249eb1", &error);
+	g_assert_no_error (error);
+	g_assert (device != NULL);
+	g_assert_cmpstr (fu_device_get_id (device), ==,
+			 "99249eb1bd9ef0b6e192b271a8cb6a3090cfec7a");
+	g_clear_object (&device);
+
+	/* find by GUID added after the device was added */
+	fu_device_add_counterpart_guid (device2, "late");
+	device = fu_device_list_get_by_guid (device_list, "late", &error);
+	g_assert_no_error (error);
+	g_assert (device != NULL);
+	g_assert_cmpstr (fu_device_get_id (device), ==,
+			 "1a8d0d9a96ad3e67ba76cf3033623625dc6d6882");
+	g_clear_object (&device);
 
 	/* remove device */
 	added_cnt = removed_cnt = changed_cnt = 0;
@@ -2471,9 +2581,12 @@ fu_history_func (gconstpointer user_data)
 	gboolean ret;
 	FuDevice *device;
 	FwupdRelease *release;
+	GPtrArray *devices;
 	g_autoptr(FuDevice) device_found = NULL;
 	g_autoptr(FuHistory) history = NULL;
+	GPtrArray *verify_cache_found;
 	g_autoptr(GPtrArray) approved_firmware = NULL;
+	g_autoptr(GPtrArray) verify_cache = NULL;
 	g_autofree gchar *dirname = NULL;
 	g_autofree gchar *filename = NULL;
 
@@ -2553,6 +2666,30 @@ fu_history_func (gconstpointer user_data)
 	g_assert (device_found != NULL);
 	g_object_unref (device_found);
 
+	/* get filtered pages of devices */
+	devices = fu_history_get_devices_full (history,
+					       "2ba16d10df45823dd4494ff10a0bfccfef512c9d",
+					       FWUPD_UPDATE_STATE_UNKNOWN,
+					       0, 10, 0, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (devices);
+	g_assert_cmpint (devices->len, ==, 1);
+	g_ptr_array_unref (devices);
+	devices = fu_history_get_devices_full (history, NULL,
+					       FWUPD_UPDATE_STATE_UNKNOWN,
+					       0, 10, 1, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (devices);
+	g_assert_cmpint (devices->len, ==, 0);
+	g_ptr_array_unref (devices);
+	devices = fu_history_get_devices_full (history, "XXXXXXXXXXXXX",
+					       FWUPD_UPDATE_STATE_UNKNOWN,
+					       0, 0, 0, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (devices);
+	g_assert_cmpint (devices->len, ==, 0);
+	g_ptr_array_unref (devices);
+
 	/* remove device */
 	ret = fu_history_remove_device (history, device, &error);
 	g_assert_no_error (error);
@@ -2565,22 +2702,74 @@ fu_history_func (gconstpointer user_data)
 	g_assert (device_found == NULL);
 	g_clear_error (&error);
 
-	/* approved firmware */
+	/* approved firmware, written in one nested batch */
+	ret = fu_history_start_batch (history, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
 	ret = fu_history_clear_approved_firmware (history, &error);
 	g_assert_no_error (error);
 	g_assert (ret);
 	ret = fu_history_add_approved_firmware (history, "foo", &error);
 	g_assert_no_error (error);
 	g_assert (ret);
+	ret = fu_history_start_batch (history, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
 	ret = fu_history_add_approved_firmware (history, "bar", &error);
 	g_assert_no_error (error);
 	g_assert (ret);
+	ret = fu_history_commit_batch (history, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_history_commit_batch (history, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
 	approved_firmware = fu_history_get_approved_firmware (history, &error);
 	g_assert_no_error (error);
 	g_assert_nonnull (approved_firmware);
 	g_assert_cmpint (approved_firmware->len, ==, 2);
 	g_assert_cmpstr (g_ptr_array_index (approved_firmware, 0), ==, "foo");
 	g_assert_cmpstr (g_ptr_array_index (approved_firmware, 1), ==, "bar");
+
+	/* replace the whole list */
+	g_ptr_array_set_size (approved_firmware, 1);
+	g_ptr_array_add (approved_firmware, g_strdup ("baz"));
+	ret = fu_history_set_approved_firmware (history, approved_firmware, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_ptr_array_unref (approved_firmware);
+	approved_firmware = fu_history_get_approved_firmware (history, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (approved_firmware);
+	g_assert_cmpint (approved_firmware->len, ==, 2);
+	g_assert_cmpstr (g_ptr_array_index (approved_firmware, 0), ==, "foo");
+	g_assert_cmpstr (g_ptr_array_index (approved_firmware, 1), ==, "baz");
+
+	/* verify cache, only valid for the same version, engine and generation */
+	verify_cache = g_ptr_array_new_with_free_func (g_free);
+	g_ptr_array_add (verify_cache, g_strdup ("abc"));
+	g_ptr_array_add (verify_cache, g_strdup ("def"));
+	ret = fu_history_set_verify_cache (history, "self-test", "1.2.3",
+					   "engine", 5, verify_cache, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	verify_cache_found = fu_history_get_verify_cache (history, "self-test", "1.2.3",
+							  "engine", 5, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (verify_cache_found);
+	g_assert_cmpint (verify_cache_found->len, ==, 2);
+	g_assert_cmpstr (g_ptr_array_index (verify_cache_found, 1), ==, "def");
+	g_ptr_array_unref (verify_cache_found);
+	verify_cache_found = fu_history_get_verify_cache (history, "self-test", "1.2.3",
+							  "engine", 6, &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert_null (verify_cache_found);
+	g_clear_error (&error);
+	verify_cache_found = fu_history_get_verify_cache (history, "self-test", "1.2.4",
+							  "engine", 5, &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert_null (verify_cache_found);
+	g_clear_error (&error);
 }
 
 static GBytes *
@@ -2985,6 +3174,8 @@ main (int argc, char **argv)
 			      fu_plugin_hash_func);
 	g_test_add_data_func ("/fwupd/plugin{module}", self,
 			      fu_plugin_module_func);
+	g_test_add_data_func ("/fwupd/engine{profile}", self,
+			      fu_engine_profile_func);
 	g_test_add_data_func ("/fwupd/memcpy", self,
 			      fu_memcpy_func);
 	g_test_add_data_func ("/fwupd/device-list", self,
@@ -3041,6 +3232,8 @@ main (int argc, char **argv)
 			      fu_engine_requirements_device_plain_func);
 	g_test_add_data_func ("/fwupd/engine{requirements-version-format}", self,
 			      fu_engine_requirements_version_format_func);
+	g_test_add_data_func ("/fwupd/engine{devices-since}", self,
+			      fu_engine_devices_since_func);
 	g_test_add_data_func ("/fwupd/engine{device-auto-parent}", self,
 			      fu_engine_device_parent_func);
 	g_test_add_data_func ("/fwupd/engine{device-priority}", self,
@@ -17,17 +17,20 @@
 #include <fcntl.h>
 #include <locale.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <libsoup/soup.h>
 #include <jcat.h>
 
 #include "fu-device-private.h"
+#include "fu-emulation-private.h"
 #include "fu-engine.h"
 #include "fu-history.h"
 #include "fu-plugin-private.h"
 #include "fu-progressbar.h"
 #include "fu-security-attrs-private.h"
 #include "fu-smbios-private.h"
+#include "fu-timeline-private.h"
 #include "fu-util-common.h"
 #include "fu-debug.h"
 #include "fwupd-common-private.h"
@@ -457,21 +460,22 @@ fu_util_get_device_flags (FuUtilPrivate *priv, gchar **values, GError **error)
 	return TRUE;
 }
 
-static void
-fu_util_build_device_tree (FuUtilPrivate *priv, GNode *root, GPtrArray *devs, FuDevice *dev)
+static FwupdDevice *
+fu_util_get_device_parent_cb (FwupdDevice *dev)
 {
-	for (guint i = 0; i < devs->len; i++) {
-		FuDevice *dev_tmp = g_ptr_array_index (devs, i);
-		if (!fu_util_filter_device (priv, FWUPD_DEVICE (dev_tmp)))
-			continue;
-		if (!priv->show_all_devices &&
-		    !fu_util_is_interesting_device (FWUPD_DEVICE (dev_tmp)))
-			continue;
-		if (fu_device_get_parent (dev_tmp) == dev) {
-			GNode *child = g_node_append_data (root, dev_tmp);
-			fu_util_build_device_tree (priv, child, devs, dev_tmp);
-		}
-	}
+	return FWUPD_DEVICE (fu_device_get_parent (FU_DEVICE (dev)));
+}
+
+static GNode *
+fu_util_add_device_tree_cb (GNode *parent, FwupdDevice *dev, gpointer user_data)
+{
+	FuUtilPrivate *priv = (FuUtilPrivate *) user_data;
+	if (!fu_util_filter_device (priv, dev))
+		return NULL;
+	if (!priv->show_all_devices &&
+	    !fu_util_is_interesting_device (dev))
+		return NULL;
+	return g_node_append_data (parent, dev);
 }
 
 static gboolean
@@ -498,7 +502,10 @@ fu_util_get_devices (FuUtilPrivate *priv, gchar **values, GError **error)
 		return TRUE;
 	}
 	fwupd_device_array_ensure_parents (devs);
-	fu_util_build_device_tree (priv, root, devs, NULL);
+	fu_util_build_device_tree (root, devs,
+				   fu_util_get_device_parent_cb,
+				   fu_util_add_device_tree_cb,
+				   priv);
 	fu_util_print_tree (root, title);
 
 	/* save the device state for other applications to see */
@@ -663,6 +670,7 @@ fu_util_get_device (FuUtilPrivate *priv, const gchar *id, GError **error)
 static gboolean
 fu_util_install_blob (FuUtilPrivate *priv, gchar **values, GError **error)
 {
+	gint64 start;
 	g_autoptr(FuDevice) device = NULL;
 	g_autoptr(GBytes) blob_fw = NULL;
 
@@ -676,7 +684,7 @@ fu_util_install_blob (FuUtilPrivate *priv, gchar **values, GError **error)
 	}
 
 	/* parse blob */
-	blob_fw = fu_common_get_contents_bytes (values[0], error);
+	blob_fw = fu_common_get_contents_mapped (values[0], error);
 	if (blob_fw == NULL) {
 		fu_util_maybe_prefix_sandbox_error (values[0], error);
 		return FALSE;
@@ -712,8 +720,15 @@ fu_util_install_blob (FuUtilPrivate *priv, gchar **values, GError **error)
 		}
 	}
 	priv->flags |= FWUPD_INSTALL_FLAG_NO_HISTORY;
+	start = g_get_monotonic_time ();
 	if (!fu_engine_install_blob (priv->engine, device, blob_fw, priv->flags, error))
 		return FALSE;
+	if (fu_emulation_get_mode () != FU_EMULATION_MODE_NONE) {
+		g_print ("Write took %.2fs using %u transfers, %.2fs waiting for the device\n",
+			 (gdouble) (g_get_monotonic_time () - start) / G_USEC_PER_SEC,
+			 fu_emulation_get_event_count (),
+			 (gdouble) fu_emulation_get_device_duration () / G_USEC_PER_SEC);
+	}
 	if (priv->cleanup_blob) {
 		g_autoptr(FuDevice) device_new = NULL;
 		g_autoptr(GError) error_local = NULL;
@@ -851,6 +866,8 @@ fu_util_download_if_required (FuUtilPrivate *priv, const gchar *perhapsfn, GErro
 static gboolean
 fu_util_install (FuUtilPrivate *priv, gchar **values, GError **error)
 {
+	gboolean ret;
+	gint64 start;
 	g_autofree gchar *filename = NULL;
 	g_autoptr(GBytes) blob_cab = NULL;
 	g_autoptr(GPtrArray) components = NULL;
@@ -962,7 +979,10 @@ fu_util_install (FuUtilPrivate *priv, gchar **values, GError **error)
 			  G_CALLBACK (fu_util_update_device_changed_cb), priv);
 
 	/* install all the tasks */
-	if (!fu_engine_install_tasks (priv->engine, install_tasks, blob_cab, priv->flags, error))
+	start = fu_timeline_begin ();
+	ret = fu_engine_install_tasks (priv->engine, install_tasks, blob_cab, priv->flags, error);
+	fu_timeline_add ("fwupdtool", "install-tasks", NULL, start);
+	if (!ret)
 		return FALSE;
 
 	fu_util_display_current_message (priv);
@@ -1574,11 +1594,9 @@ fu_util_get_firmware_types (FuUtilPrivate *priv, gchar **values, GError **error)
 }
 
 static gchar *
-fu_util_prompt_for_firmware_type (FuUtilPrivate *priv, GError **error)
+fu_util_prompt_for_firmware_type_full (GPtrArray *firmware_types, GError **error)
 {
-	g_autoptr(GPtrArray) firmware_types = NULL;
 	guint idx;
-	firmware_types = fu_engine_get_firmware_gtype_ids (priv->engine);
 
 	/* TRANSLATORS: get interactive prompt */
 	g_print ("%s\n", _("Choose a firmware type:"));
@@ -1600,6 +1618,30 @@ fu_util_prompt_for_firmware_type (FuUtilPrivate *priv, GError **error)
 	return g_strdup (g_ptr_array_index (firmware_types, idx - 1));
 }
 
+static gchar *
+fu_util_prompt_for_firmware_type (FuUtilPrivate *priv, GError **error)
+{
+	g_autoptr(GPtrArray) firmware_types = fu_engine_get_firmware_gtype_ids (priv->engine);
+	return fu_util_prompt_for_firmware_type_full (firmware_types, error);
+}
+
+/* only prompt for the types with matching magic bytes, if any */
+static gchar *
+fu_util_detect_firmware_type (FuUtilPrivate *priv, GBytes *blob, GError **error)
+{
+	g_autoptr(GPtrArray) firmware_types = NULL;
+
+	firmware_types = fu_engine_get_firmware_gtype_ids_for_bytes (priv->engine, blob);
+	if (firmware_types->len == 0)
+		return fu_util_prompt_for_firmware_type (priv, error);
+	if (firmware_types->len == 1) {
+		const gchar *id = g_ptr_array_index (firmware_types, 0);
+		g_debug ("detected firmware type %s", id);
+		return g_strdup (id);
+	}
+	return fu_util_prompt_for_firmware_type_full (firmware_types, error);
+}
+
 static gboolean
 fu_util_firmware_parse (FuUtilPrivate *priv, gchar **values, GError **error)
 {
@@ -1632,7 +1674,7 @@ fu_util_firmware_parse (FuUtilPrivate *priv, gchar **values, GError **error)
 
 	/* find the GType to use */
 	if (firmware_type == NULL)
-		firmware_type = fu_util_prompt_for_firmware_type (priv, error);
+		firmware_type = fu_util_detect_firmware_type (priv, blob, error);
 	if (firmware_type == NULL)
 		return FALSE;
 	gtype = fu_engine_get_firmware_gtype_by_id (priv->engine, firmware_type);
@@ -1691,7 +1733,7 @@ fu_util_firmware_convert (FuUtilPrivate *priv, gchar **values, GError **error)
 
 	/* find the GType to use */
 	if (firmware_type_src == NULL)
-		firmware_type_src = fu_util_prompt_for_firmware_type (priv, error);
+		firmware_type_src = fu_util_detect_firmware_type (priv, blob_src, error);
 	if (firmware_type_src == NULL)
 		return FALSE;
 	if (firmware_type_dst == NULL)
@@ -1741,6 +1783,156 @@ fu_util_firmware_convert (FuUtilPrivate *priv, gchar **values, GError **error)
 	return TRUE;
 }
 
+typedef struct {
+	GType			 gtype_src;
+	GType			 gtype_dst;
+	FwupdInstallFlags	 flags;
+	gchar			*filename_src;
+	gchar			*filename_dst;
+	GError			*error;
+} FuUtilConvertHelper;
+
+static void
+fu_util_convert_helper_free (FuUtilConvertHelper *helper)
+{
+	if (helper->error != NULL)
+		g_error_free (helper->error);
+	g_free (helper->filename_src);
+	g_free (helper->filename_dst);
+	g_free (helper);
+}
+
+static gboolean
+fu_util_firmware_convert_file (FuUtilConvertHelper *helper, GError **error)
+{
+	g_autoptr(FuFirmware) firmware_dst = g_object_new (helper->gtype_dst, NULL);
+	g_autoptr(FuFirmware) firmware_src = g_object_new (helper->gtype_src, NULL);
+	g_autoptr(GBytes) blob_dst = NULL;
+	g_autoptr(GBytes) blob_src = NULL;
+	g_autoptr(GPtrArray) images = NULL;
+
+	blob_src = fu_common_get_contents_bytes (helper->filename_src, error);
+	if (blob_src == NULL)
+		return FALSE;
+	if (!fu_firmware_parse (firmware_src, blob_src, helper->flags, error))
+		return FALSE;
+	images = fu_firmware_get_images (firmware_src);
+	for (guint i = 0; i < images->len; i++) {
+		FuFirmwareImage *img = g_ptr_array_index (images, i);
+		fu_firmware_add_image (firmware_dst, img);
+	}
+	blob_dst = fu_firmware_write (firmware_dst, error);
+	if (blob_dst == NULL)
+		return FALSE;
+	return fu_common_set_contents_bytes (helper->filename_dst, blob_dst, error);
+}
+
+static void
+fu_util_firmware_convert_file_cb (gpointer data, GCancellable *cancellable)
+{
+	FuUtilConvertHelper *helper = (FuUtilConvertHelper *) data;
+	fu_util_firmware_convert_file (helper, &helper->error);
+}
+
+static gboolean
+fu_util_firmware_convert_dir (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	GType gtype_dst;
+	GType gtype_src;
+	const gchar *fn;
+	guint failed = 0;
+	g_autoptr(GDir) dir = NULL;
+	g_autoptr(FuWorkerBatch) batch = NULL;
+	g_autoptr(GPtrArray) helpers = NULL;
+
+	/* check args */
+	if (g_strv_length (values) != 4) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_ARGS,
+				     "Invalid arguments: directories and firmware types required");
+		return FALSE;
+	}
+
+	/* load engine */
+	if (!fu_engine_load (priv->engine, FU_ENGINE_LOAD_FLAG_NO_ENUMERATE, error))
+		return FALSE;
+
+	/* find the GTypes to use */
+	gtype_src = fu_engine_get_firmware_gtype_by_id (priv->engine, values[2]);
+	if (gtype_src == G_TYPE_INVALID) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_FOUND,
+			     "GType %s not supported", values[2]);
+		return FALSE;
+	}
+	gtype_dst = fu_engine_get_firmware_gtype_by_id (priv->engine, values[3]);
+	if (gtype_dst == G_TYPE_INVALID) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_FOUND,
+			     "GType %s not supported", values[3]);
+		return FALSE;
+	}
+	if (g_mkdir_with_parents (values[1], 0755) == -1) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "Failed to create %s", values[1]);
+		return FALSE;
+	}
+
+	/* each file is converted independently */
+	dir = g_dir_open (values[0], 0, error);
+	if (dir == NULL)
+		return FALSE;
+	helpers = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_util_convert_helper_free);
+	while ((fn = g_dir_read_name (dir)) != NULL) {
+		FuUtilConvertHelper *helper;
+		g_autofree gchar *filename_src = g_build_filename (values[0], fn, NULL);
+		if (!g_file_test (filename_src, G_FILE_TEST_IS_REGULAR))
+			continue;
+		helper = g_new0 (FuUtilConvertHelper, 1);
+		helper->gtype_src = gtype_src;
+		helper->gtype_dst = gtype_dst;
+		helper->flags = priv->flags;
+		helper->filename_src = g_steal_pointer (&filename_src);
+		helper->filename_dst = g_build_filename (values[1], fn, NULL);
+		g_ptr_array_add (helpers, helper);
+	}
+	batch = fu_worker_batch_new (fu_engine_get_worker_pool (priv->engine),
+				     FU_WORKER_PRIORITY_INTERACTIVE, NULL);
+	for (guint i = 0; i < helpers->len; i++)
+		fu_worker_batch_add (batch, fu_util_firmware_convert_file_cb,
+				     g_ptr_array_index (helpers, i));
+	fu_worker_batch_wait (batch);
+
+	/* summary */
+	for (guint i = 0; i < helpers->len; i++) {
+		FuUtilConvertHelper *helper = g_ptr_array_index (helpers, i);
+		if (helper->error != NULL) {
+			g_printerr ("%s: %s\n", helper->filename_src, helper->error->message);
+			failed++;
+			continue;
+		}
+		g_print ("%s\n", helper->filename_dst);
+	}
+	if (failed > 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "Failed to convert %u of %u files",
+			     failed, helpers->len);
+		return FALSE;
+	}
+
+	/* TRANSLATORS: the number of files converted */
+	g_print (ngettext ("Converted %u file\n", "Converted %u files\n", helpers->len),
+		 helpers->len);
+	return TRUE;
+}
+
 static gboolean
 fu_util_verify_update (FuUtilPrivate *priv, gchar **values, GError **error)
 {
@@ -1972,6 +2164,237 @@ fu_util_security (FuUtilPrivate *priv, gchar **values, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_util_profile_startup (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	GVariantIter iter;
+	const gchar *name;
+	guint32 count;
+	guint64 duration;
+	guint64 total = 0;
+	g_autoptr(GVariant) profile = NULL;
+
+	if (!fu_util_start_engine (priv, FU_ENGINE_LOAD_FLAG_NONE, error))
+		return FALSE;
+
+	profile = fu_engine_get_profile (priv->engine);
+	g_variant_iter_init (&iter, profile);
+	while (g_variant_iter_next (&iter, "(&sut)", &name, &count, &duration)) {
+		/* plugin vfuncs are already included in the engine phases */
+		if (g_strstr_len (name, -1, ":") == NULL)
+			total += duration;
+		g_print ("%-40s %6u %10.2fms\n", name, count, (gdouble) duration / 1000.f);
+	}
+	/* TRANSLATORS: total time taken to start the daemon */
+	g_print ("%-40s %6s %10.2fms\n", _("Total"), "", (gdouble) total / 1000.f);
+	return TRUE;
+}
+
+static void
+fu_util_print_memory_usage (GVariant *memory)
+{
+	GVariantIter iter;
+	const gchar *name;
+	guint32 entries;
+	guint64 bytes;
+
+	g_variant_iter_init (&iter, memory);
+	while (g_variant_iter_next (&iter, "(&stu)", &name, &bytes, &entries)) {
+		g_autofree gchar *size = bytes > 0 ? g_format_size (bytes) : g_strdup ("");
+		g_print ("%-40s %12s %8u\n", name, size, entries);
+	}
+}
+
+static gboolean
+fu_util_get_memory_usage (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	g_autoptr(GVariant) memory = NULL;
+	g_autoptr(GVariant) memory_trimmed = NULL;
+
+	if (!fu_util_start_engine (priv, FU_ENGINE_LOAD_FLAG_NONE, error))
+		return FALSE;
+
+	memory = fu_engine_get_memory_usage (priv->engine);
+	fu_util_print_memory_usage (memory);
+
+	/* show what the daemon can drop under memory pressure */
+	fu_engine_trim (priv->engine);
+	memory_trimmed = fu_engine_get_memory_usage (priv->engine);
+	/* TRANSLATORS: the caches were dropped to use less memory */
+	g_print ("\n%s\n", _("After dropping caches:"));
+	fu_util_print_memory_usage (memory_trimmed);
+	return TRUE;
+}
+
+/* hotplug latency, using the timestamp set by the test plugin */
+typedef struct {
+	guint		 added;
+	guint		 removed;
+	gint64		 added_latency;		/* us */
+	gint64		 removed_latency;	/* us */
+	gint64		 max_latency;		/* us */
+} FuUtilLoadTest;
+
+static gint64
+fu_util_load_test_get_latency (FuDevice *device)
+{
+	const gchar *tmp = fu_device_get_metadata (device, "LoadTestTimestamp");
+	if (tmp == NULL)
+		return 0;
+	return g_get_monotonic_time () - (gint64) fu_common_strtoull (tmp);
+}
+
+static void
+fu_util_load_test_device_added_cb (FuEngine *engine, FuDevice *device, FuUtilLoadTest *load)
+{
+	gint64 latency = fu_util_load_test_get_latency (device);
+	load->added++;
+	load->added_latency += latency;
+	load->max_latency = MAX (load->max_latency, latency);
+}
+
+static void
+fu_util_load_test_device_removed_cb (FuEngine *engine, FuDevice *device, FuUtilLoadTest *load)
+{
+	gint64 latency = fu_util_load_test_get_latency (device);
+	load->removed++;
+	load->removed_latency += latency;
+	load->max_latency = MAX (load->max_latency, latency);
+}
+
+static gboolean
+fu_util_load_test_timeout_cb (gpointer user_data)
+{
+	FuUtilPrivate *priv = (FuUtilPrivate *) user_data;
+	g_main_loop_quit (priv->loop);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+fu_util_load_test_print (const gchar *title, guint count, gint64 total)
+{
+	g_print ("%-40s %8u %10.3fms\n", title, count,
+		 count > 0 ? (gdouble) total / (1000.f * count) : 0.f);
+}
+
+static gboolean
+fu_util_load_test_run (FuUtilPrivate *priv,
+		       FuUtilLoadTest *load,
+		       guint churn,
+		       guint seconds,
+		       GError **error)
+{
+	guint upgrades_cnt = 0;
+	gint64 upgrades_total = 0;
+	gint64 devices_total = 0;
+	gint64 start;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	/* coldplug */
+	start = g_get_monotonic_time ();
+	if (!fu_util_start_engine (priv, FU_ENGINE_LOAD_FLAG_NONE, error))
+		return FALSE;
+	g_print ("%-40s %8u %10.3fms\n", "coldplug", load->added,
+		 (gdouble) (g_get_monotonic_time () - start) / 1000.f);
+	fu_util_load_test_print ("coldplug-device-added", load->added, load->added_latency);
+	devices = fu_engine_get_devices (priv->engine, error);
+	if (devices == NULL) {
+		g_prefix_error (error, "test plugin not available, build with -Dplugin_dummy=true: ");
+		return FALSE;
+	}
+
+	/* GetDevices */
+	for (guint i = 0; i < 100; i++) {
+		g_autoptr(GPtrArray) devices_tmp = NULL;
+		start = g_get_monotonic_time ();
+		devices_tmp = fu_engine_get_devices (priv->engine, error);
+		if (devices_tmp == NULL)
+			return FALSE;
+		devices_total += g_get_monotonic_time () - start;
+	}
+	fu_util_load_test_print ("get-devices", 100, devices_total);
+
+	/* GetUpgrades, which is expected to fail with no metadata */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		g_autoptr(GPtrArray) rels = NULL;
+		g_autoptr(GError) error_local = NULL;
+		start = g_get_monotonic_time ();
+		rels = fu_engine_get_upgrades (priv->engine,
+					       fu_device_get_id (device),
+					       &error_local);
+		upgrades_total += g_get_monotonic_time () - start;
+		upgrades_cnt++;
+	}
+	fu_util_load_test_print ("get-upgrades", upgrades_cnt, upgrades_total);
+
+	/* hotplug */
+	if (churn > 0 && seconds > 0) {
+		memset (load, 0x0, sizeof (*load));
+		g_timeout_add_seconds (seconds, fu_util_load_test_timeout_cb, priv);
+		g_main_loop_run (priv->loop);
+		fu_util_load_test_print ("hotplug-device-added", load->added, load->added_latency);
+		fu_util_load_test_print ("hotplug-device-removed", load->removed, load->removed_latency);
+		g_print ("%-40s %8s %10.3fms\n", "hotplug-max", "",
+			 (gdouble) load->max_latency / 1000.f);
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_util_load_test (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	guint depth = 1;
+	guint guids = 1;
+	guint churn = 0;
+	guint seconds = 10;
+	gboolean ret;
+	FuUtilLoadTest load = { 0 };
+	g_autofree gchar *env = NULL;
+
+	/* parse arguments */
+	if (g_strv_length (values) < 1 || g_strv_length (values) > 5) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_ARGS,
+				     "Invalid arguments, expected DEVICES [GUIDS] [DEPTH] [CHURN] [SECONDS]");
+		return FALSE;
+	}
+	if (g_strv_length (values) > 1)
+		guids = fu_common_strtoull (values[1]);
+	if (g_strv_length (values) > 2)
+		depth = fu_common_strtoull (values[2]);
+	if (g_strv_length (values) > 3)
+		churn = fu_common_strtoull (values[3]);
+	if (g_strv_length (values) > 4)
+		seconds = fu_common_strtoull (values[4]);
+
+	/* only use the synthetic devices */
+	env = g_strdup_printf ("devices=%u,guids=%u,depth=%u,churn=%u",
+			       (guint) fu_common_strtoull (values[0]),
+			       guids, depth, churn);
+	g_setenv ("FWUPD_PLUGIN_TEST", "load", TRUE);
+	g_setenv ("FWUPD_PLUGIN_TEST_LOAD", env, TRUE);
+	fu_engine_add_plugin_filter (priv->engine, "test");
+
+	/* do not stringify every device */
+	g_signal_handlers_disconnect_by_func (priv->engine,
+					      fu_main_engine_device_added_cb,
+					      priv);
+	g_signal_handlers_disconnect_by_func (priv->engine,
+					      fu_main_engine_device_removed_cb,
+					      priv);
+	g_signal_connect (priv->engine, "device-added",
+			  G_CALLBACK (fu_util_load_test_device_added_cb), &load);
+	g_signal_connect (priv->engine, "device-removed",
+			  G_CALLBACK (fu_util_load_test_device_removed_cb), &load);
+	ret = fu_util_load_test_run (priv, &load, churn, seconds, error);
+
+	/* not valid after this function returns */
+	g_signal_handlers_disconnect_by_data (priv->engine, &load);
+	return ret;
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -1981,12 +2404,16 @@ main (int argc, char *argv[])
 	gboolean ret;
 	gboolean version = FALSE;
 	gboolean interactive = isatty (fileno (stdout)) != 0;
+	gint64 start;
 	g_auto(GStrv) plugin_glob = NULL;
 	g_autoptr(FuUtilPrivate) priv = g_new0 (FuUtilPrivate, 1);
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GPtrArray) cmd_array = fu_util_cmd_array_new ();
 	g_autofree gchar *cmd_descriptions = NULL;
 	g_autofree gchar *filter = NULL;
+	g_autofree gchar *record = NULL;
+	g_autofree gchar *replay = NULL;
+	g_autofree gchar *profile = NULL;
 	const GOptionEntry options[] = {
 		{ "version", '\0', 0, G_OPTION_ARG_NONE, &version,
 			/* TRANSLATORS: command line option */
@@ -2028,6 +2455,15 @@ main (int argc, char *argv[])
 			/* TRANSLATORS: command line option */
 			_("Filter with a set of device flags using a ~ prefix to "
 			  "exclude, e.g. 'internal,~needs-reboot'"), NULL },
+		{ "record", '\0', 0, G_OPTION_ARG_FILENAME, &record,
+			/* TRANSLATORS: command line option */
+			_("Save the device transfers into a file"), NULL },
+		{ "replay", '\0', 0, G_OPTION_ARG_FILENAME, &replay,
+			/* TRANSLATORS: command line option */
+			_("Use the device transfers from a file rather than the hardware"), NULL },
+		{ "profile", '\0', 0, G_OPTION_ARG_FILENAME, &profile,
+			/* TRANSLATORS: command line option */
+			_("Save a timeline of the command as a Chrome trace file"), NULL },
 		{ NULL}
 	};
 
@@ -2187,6 +2623,12 @@ main (int argc, char *argv[])
 		     /* TRANSLATORS: command description */
 		     _("Convert a firmware file"),
 		     fu_util_firmware_convert);
+	fu_util_cmd_array_add (cmd_array,
+		     "firmware-convert-dir",
+		     "DIRECTORY-SRC DIRECTORY-DST FIRMWARE-TYPE-SRC FIRMWARE-TYPE-DST",
+		     /* TRANSLATORS: command description */
+		     _("Convert all the firmware files in a directory"),
+		     fu_util_firmware_convert_dir);
 	fu_util_cmd_array_add (cmd_array,
 		     "firmware-parse",
 		     "FILENAME [FIRMWARE-TYPE]",
@@ -2217,6 +2659,24 @@ main (int argc, char *argv[])
 		     /* TRANSLATORS: command description */
 		     _("Gets the host security attributes."),
 		     fu_util_security);
+	fu_util_cmd_array_add (cmd_array,
+		     "profile-startup",
+		     NULL,
+		     /* TRANSLATORS: command description */
+		     _("Show the time taken by each part of the daemon startup"),
+		     fu_util_profile_startup);
+	fu_util_cmd_array_add (cmd_array,
+		     "get-memory-usage",
+		     NULL,
+		     /* TRANSLATORS: command description */
+		     _("Show the memory used by the engine before and after dropping caches"),
+		     fu_util_get_memory_usage);
+	fu_util_cmd_array_add (cmd_array,
+		     "load-test",
+		     "DEVICES [GUIDS] [DEPTH] [CHURN] [SECONDS]",
+		     /* TRANSLATORS: command description */
+		     _("Measure the engine latency using synthetic devices"),
+		     fu_util_load_test);
 
 	/* do stuff on ctrl+c */
 	priv->cancellable = g_cancellable_new ();
@@ -2315,8 +2775,36 @@ main (int argc, char *argv[])
 	for (guint i = 0; plugin_glob != NULL && plugin_glob[i] != NULL; i++)
 		fu_engine_add_plugin_filter (priv->engine, plugin_glob[i]);
 
+	/* emulate the hardware */
+	if (record != NULL && replay != NULL) {
+		/* TRANSLATORS: the user didn't read the man page */
+		g_printerr ("%s\n", _("Cannot use --record and --replay together"));
+		return EXIT_FAILURE;
+	}
+	if (record != NULL)
+		fu_emulation_record_start ();
+	if (replay != NULL) {
+		if (!fu_emulation_load (replay, &error)) {
+			g_printerr ("%s\n", error->message);
+			return EXIT_FAILURE;
+		}
+	}
+
 	/* run the specified command */
+	if (profile != NULL)
+		fu_timeline_start ();
+	start = fu_timeline_begin ();
 	ret = fu_util_cmd_array_run (cmd_array, priv, argv[1], (gchar**) &argv[2], &error);
+	fu_timeline_add ("fwupdtool", argv[1], NULL, start);
+	if (ret && record != NULL)
+		ret = fu_emulation_save (record, &error);
+
+	/* also useful when the command failed */
+	if (profile != NULL) {
+		g_autoptr(GError) error_profile = NULL;
+		if (!fu_timeline_save (profile, &error_profile))
+			g_printerr ("%s\n", error_profile->message);
+	}
 	if (!ret) {
 		g_printerr ("%s\n", error->message);
 		if (g_error_matches (error, FWUPD_ERROR, FWUPD_ERROR_INVALID_ARGS)) {
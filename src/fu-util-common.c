@@ -9,9 +9,9 @@
 #include <config.h>
 
 #include <stdio.h>
+#include <string.h>
 #include <glib/gi18n.h>
 #include <gusb.h>
-#include <xmlb.h>
 
 #include "fu-common.h"
 #include "fu-util-common.h"
@@ -219,6 +219,65 @@ fu_util_print_tree (GNode *n, gpointer data)
 			 fu_util_traverse_tree, data);
 }
 
+static void
+fu_util_build_device_tree_node (GNode *node,
+				GHashTable *children,
+				FwupdDevice *dev,
+				FuUtilDeviceTreeFunc func,
+				gpointer user_data)
+{
+	GPtrArray *devs = g_hash_table_lookup (children, dev);
+	if (devs == NULL)
+		return;
+	for (guint i = 0; i < devs->len; i++) {
+		FwupdDevice *dev_tmp = g_ptr_array_index (devs, i);
+		GNode *child = func (node, dev_tmp, user_data);
+		if (child != NULL)
+			fu_util_build_device_tree_node (child, children, dev_tmp, func, user_data);
+	}
+}
+
+/**
+ * fu_util_build_device_tree:
+ * @root: A #GNode
+ * @devs: (element-type FwupdDevice): devices
+ * @parent_func: (nullable): gets the parent, or %NULL for fwupd_device_get_parent()
+ * @func: adds the device below the parent node, returning %NULL to hide
+ *  the device and all of its children
+ * @user_data: data for @func
+ *
+ * Adds the devices to the tree in the same order as @devs. The children of
+ * each device are found in one pass, so this is linear in the number of
+ * devices, and @func is only called for nodes that can be shown.
+ **/
+void
+fu_util_build_device_tree (GNode *root,
+			   GPtrArray *devs,
+			   FuUtilDeviceParentFunc parent_func,
+			   FuUtilDeviceTreeFunc func,
+			   gpointer user_data)
+{
+	g_autoptr(GHashTable) children = NULL;
+
+	/* parent:GPtrArray of children, where the parent can be NULL */
+	children = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+					  NULL, (GDestroyNotify) g_ptr_array_unref);
+	for (guint i = 0; i < devs->len; i++) {
+		FwupdDevice *dev = g_ptr_array_index (devs, i);
+		FwupdDevice *parent;
+		GPtrArray *siblings;
+
+		parent = parent_func != NULL ? parent_func (dev) : fwupd_device_get_parent (dev);
+		siblings = g_hash_table_lookup (children, parent);
+		if (siblings == NULL) {
+			siblings = g_ptr_array_new ();
+			g_hash_table_insert (children, parent, siblings);
+		}
+		g_ptr_array_add (siblings, dev);
+	}
+	fu_util_build_device_tree_node (root, children, NULL, func, user_data);
+}
+
 static gboolean
 fu_util_is_interesting_child (FwupdDevice *dev)
 {
@@ -854,51 +913,139 @@ fu_util_parse_filter_flags (const gchar *filter, FwupdDeviceFlags *include,
 	return TRUE;
 }
 
-gchar *
-fu_util_convert_description (const gchar *xml, GError **error)
+typedef struct {
+	GString		*str;
+	guint		 depth;
+	gchar		*element;	/* the current top-level element */
+	gchar		*text;		/* of the top-level element */
+	gchar		*li_text;
+	gboolean	 has_child;
+	gboolean	 li_has_child;
+	guint		 child_idx;	/* of the current top-level element */
+	gboolean	 in_li;
+} FuUtilDescriptionHelper;
+
+/* collapse the indenting the same way as the xmlb builder */
+static gchar *
+fu_util_convert_description_text (const gchar *text, gsize text_len)
 {
 	g_autoptr(GString) str = g_string_new (NULL);
-	g_autoptr(XbNode) n = NULL;
-	g_autoptr(XbSilo) silo = NULL;
+	g_auto(GStrv) lines = NULL;
+	g_autofree gchar *tmp = g_strndup (text, text_len);
 
-	/* parse XML */
-	silo = xb_silo_new_from_xml (xml, error);
-	if (silo == NULL)
+	lines = g_strsplit (tmp, "\n", -1);
+	for (guint i = 0; lines[i] != NULL; i++) {
+		g_strstrip (lines[i]);
+		if (lines[i][0] == '\0')
+			continue;
+		if (str->len > 0)
+			g_string_append_c (str, ' ');
+		g_string_append (str, lines[i]);
+	}
+	if (str->len == 0)
 		return NULL;
+	return g_string_free (g_steal_pointer (&str), FALSE);
+}
 
-	n = xb_silo_get_root (silo);
-	while (n != NULL) {
-		g_autoptr(XbNode) n2 = NULL;
-
-		/* support <p>, <ul>, <ol> and <li>, ignore all else */
-		if (g_strcmp0 (xb_node_get_element (n), "p") == 0) {
-			g_string_append_printf (str, "%s\n\n", xb_node_get_text (n));
-		} else if (g_strcmp0 (xb_node_get_element (n), "ul") == 0) {
-			g_autoptr(GPtrArray) children = xb_node_get_children (n);
-			for (guint i = 0; i < children->len; i++) {
-				XbNode *nc = g_ptr_array_index (children, i);
-				if (g_strcmp0 (xb_node_get_element (nc), "li") == 0) {
-					g_string_append_printf (str, " • %s\n",
-								xb_node_get_text (nc));
-				}
-			}
-			g_string_append (str, "\n");
-		} else if (g_strcmp0 (xb_node_get_element (n), "ol") == 0) {
-			g_autoptr(GPtrArray) children = xb_node_get_children (n);
-			for (guint i = 0; i < children->len; i++) {
-				XbNode *nc = g_ptr_array_index (children, i);
-				if (g_strcmp0 (xb_node_get_element (nc), "li") == 0) {
-					g_string_append_printf (str, " %u. %s\n",
-								i + 1,
-								xb_node_get_text (nc));
-				}
-			}
-			g_string_append (str, "\n");
-		}
+static void
+fu_util_convert_description_start_cb (GMarkupParseContext *context,
+				      const gchar *element_name,
+				      const gchar **attribute_names,
+				      const gchar **attribute_values,
+				      gpointer user_data,
+				      GError **error)
+{
+	FuUtilDescriptionHelper *helper = (FuUtilDescriptionHelper *) user_data;
+
+	helper->depth++;
+	if (helper->depth == 1) {
+		g_free (helper->element);
+		helper->element = g_strdup (element_name);
+		helper->has_child = FALSE;
+		helper->child_idx = 0;
+	} else if (helper->depth == 2) {
+		helper->has_child = TRUE;
+		helper->child_idx++;
+		helper->in_li = g_strcmp0 (element_name, "li") == 0;
+		helper->li_has_child = FALSE;
+	} else if (helper->depth == 3) {
+		helper->li_has_child = TRUE;
+	}
+}
 
-		n2 = xb_node_get_next (n);
-		g_set_object (&n, n2);
+static void
+fu_util_convert_description_text_cb (GMarkupParseContext *context,
+				     const gchar *text,
+				     gsize text_len,
+				     gpointer user_data,
+				     GError **error)
+{
+	FuUtilDescriptionHelper *helper = (FuUtilDescriptionHelper *) user_data;
+
+	/* only the text before any child element is used */
+	if (helper->depth == 1 && !helper->has_child && helper->text == NULL)
+		helper->text = fu_util_convert_description_text (text, text_len);
+	else if (helper->depth == 2 && helper->in_li &&
+		 !helper->li_has_child && helper->li_text == NULL)
+		helper->li_text = fu_util_convert_description_text (text, text_len);
+}
+
+static void
+fu_util_convert_description_end_cb (GMarkupParseContext *context,
+				    const gchar *element_name,
+				    gpointer user_data,
+				    GError **error)
+{
+	FuUtilDescriptionHelper *helper = (FuUtilDescriptionHelper *) user_data;
+
+	/* support <p>, <ul>, <ol> and <li>, ignore all else */
+	if (helper->depth == 1) {
+		if (g_strcmp0 (helper->element, "p") == 0) {
+			g_string_append_printf (helper->str, "%s\n\n", helper->text);
+		} else if (g_strcmp0 (helper->element, "ul") == 0 ||
+			   g_strcmp0 (helper->element, "ol") == 0) {
+			g_string_append (helper->str, "\n");
+		}
+		g_clear_pointer (&helper->text, g_free);
+	} else if (helper->depth == 2 && helper->in_li) {
+		if (g_strcmp0 (helper->element, "ul") == 0) {
+			g_string_append_printf (helper->str, " • %s\n", helper->li_text);
+		} else if (g_strcmp0 (helper->element, "ol") == 0) {
+			g_string_append_printf (helper->str, " %u. %s\n",
+						helper->child_idx, helper->li_text);
+		}
+		g_clear_pointer (&helper->li_text, g_free);
+		helper->in_li = FALSE;
 	}
+	helper->depth--;
+}
+
+/* parsed as a stream, as compiling a silo for each description is slow */
+gchar *
+fu_util_convert_description (const gchar *xml, GError **error)
+{
+	const GMarkupParser parser = {
+		fu_util_convert_description_start_cb,
+		fu_util_convert_description_end_cb,
+		fu_util_convert_description_text_cb,
+		NULL,
+		NULL };
+	FuUtilDescriptionHelper helper = { NULL };
+	gboolean ret;
+	g_autoptr(GMarkupParseContext) ctx = NULL;
+	g_autoptr(GString) str = g_string_new (NULL);
+
+	/* parse XML */
+	helper.str = str;
+	ctx = g_markup_parse_context_new (&parser, G_MARKUP_PREFIX_ERROR_POSITION,
+					  &helper, NULL);
+	ret = g_markup_parse_context_parse (ctx, xml, -1, error) &&
+	      g_markup_parse_context_end_parse (ctx, error);
+	g_free (helper.element);
+	g_free (helper.text);
+	g_free (helper.li_text);
+	if (!ret)
+		return NULL;
 
 	/* success */
 	return fu_common_strstrip (str->str);
@@ -1096,6 +1243,10 @@ fu_util_device_flag_to_string (guint64 device_flag)
 		/* skip */
 		return NULL;
 	}
+	if (device_flag == FWUPD_DEVICE_FLAG_SETUP_ON_DEMAND) {
+		/* skip */
+		return NULL;
+	}
 	if (device_flag == FWUPD_DEVICE_FLAG_UNKNOWN) {
 		return NULL;
 	}
@@ -1639,3 +1790,80 @@ fu_util_security_attrs_to_string (GPtrArray *attrs)
 
 	return g_string_free (str, FALSE);
 }
+
+/* a delta is the "FWDL" magic followed by a list of commands, where
+ * 'C' copies uint32le:size bytes from uint32le:offset in the base and
+ * 'I' inserts the uint32le:size bytes that follow the command */
+GBytes *
+fu_util_delta_apply (GBytes *base, GBytes *delta, GError **error)
+{
+	gsize base_sz = 0;
+	gsize delta_sz = 0;
+	gsize offset = 4;
+	const guint8 *base_buf = g_bytes_get_data (base, &base_sz);
+	const guint8 *delta_buf = g_bytes_get_data (delta, &delta_sz);
+	g_autoptr(GByteArray) buf = g_byte_array_new ();
+
+	if (delta_sz < 4 || memcmp (delta_buf, "FWDL", 4) != 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "delta has invalid magic");
+		return NULL;
+	}
+	while (offset < delta_sz) {
+		guint8 cmd = delta_buf[offset++];
+		if (cmd == 'C') {
+			guint32 src;
+			guint32 len;
+			if (delta_sz - offset < 8) {
+				g_set_error_literal (error,
+						     FWUPD_ERROR,
+						     FWUPD_ERROR_INVALID_FILE,
+						     "delta copy command truncated");
+				return NULL;
+			}
+			src = fu_common_read_uint32 (delta_buf + offset, G_LITTLE_ENDIAN);
+			len = fu_common_read_uint32 (delta_buf + offset + 4, G_LITTLE_ENDIAN);
+			offset += 8;
+			if (src > base_sz || len > base_sz - src) {
+				g_set_error (error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_INVALID_FILE,
+					     "delta copy 0x%x@0x%x outside base of 0x%x",
+					     len, src, (guint) base_sz);
+				return NULL;
+			}
+			g_byte_array_append (buf, base_buf + src, len);
+		} else if (cmd == 'I') {
+			guint32 len;
+			if (delta_sz - offset < 4) {
+				g_set_error_literal (error,
+						     FWUPD_ERROR,
+						     FWUPD_ERROR_INVALID_FILE,
+						     "delta insert command truncated");
+				return NULL;
+			}
+			len = fu_common_read_uint32 (delta_buf + offset, G_LITTLE_ENDIAN);
+			offset += 4;
+			if (len > delta_sz - offset) {
+				g_set_error (error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_INVALID_FILE,
+					     "delta insert of 0x%x truncated",
+					     len);
+				return NULL;
+			}
+			g_byte_array_append (buf, delta_buf + offset, len);
+			offset += len;
+		} else {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "delta command 0x%02x unknown",
+				     cmd);
+			return NULL;
+		}
+	}
+	return g_byte_array_free_to_bytes (g_steal_pointer (&buf));
+}
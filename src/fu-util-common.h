@@ -29,7 +29,17 @@ void		 fu_util_print_data		(const gchar	*title,
 guint		 fu_util_prompt_for_number	(guint		 maxnum);
 gboolean	 fu_util_prompt_for_boolean	(gboolean	 def);
 
+typedef FwupdDevice *(*FuUtilDeviceParentFunc)	(FwupdDevice	*dev);
+typedef GNode	*(*FuUtilDeviceTreeFunc)	(GNode		*parent,
+						 FwupdDevice	*dev,
+						 gpointer	 user_data);
+
 void		 fu_util_print_tree		(GNode *n,	gpointer data);
+void		 fu_util_build_device_tree	(GNode		*root,
+						 GPtrArray	*devs,
+						 FuUtilDeviceParentFunc parent_func,
+						 FuUtilDeviceTreeFunc func,
+						 gpointer	 user_data);
 gboolean	 fu_util_is_interesting_device	(FwupdDevice	*dev);
 gchar		*fu_util_get_user_cache_path	(const gchar	*fn);
 SoupSession	*fu_util_setup_networking	(GError		**error);
@@ -78,3 +88,6 @@ gchar		*fu_util_release_to_string	(FwupdRelease	*rel,
 gchar		*fu_util_remote_to_string	(FwupdRemote *remote,
 						 guint		 idt);
 gchar		*fu_util_security_attrs_to_string (GPtrArray	*attrs);
+GBytes		*fu_util_delta_apply		(GBytes		*base,
+						 GBytes		*delta,
+						 GError		**error);
@@ -68,6 +68,7 @@ struct FuUtilPrivate {
 	gboolean		 assume_yes;
 	gboolean		 sign;
 	gboolean		 show_all_devices;
+	gboolean		 verify_all;
 	gboolean		 disable_ssl_strict;
 	/* only valid in update and downgrade */
 	FuUtilOperation		 current_operation;
@@ -505,24 +506,23 @@ fu_util_modify_remote (FuUtilPrivate *priv,
 					   NULL, error);
 }
 
-static void
-fu_util_build_device_tree (FuUtilPrivate *priv, GNode *root, GPtrArray *devs, FwupdDevice *dev)
+static GNode *
+fu_util_add_device_tree_cb (GNode *parent, FwupdDevice *dev, gpointer user_data)
 {
-	for (guint i = 0; i < devs->len; i++) {
-		FwupdDevice *dev_tmp = g_ptr_array_index (devs, i);
-		if (!fu_util_filter_device (priv, dev_tmp))
-			continue;
-		if (!priv->show_all_devices &&
-		    !fu_util_is_interesting_device (dev_tmp))
-			continue;
-		if (fwupd_device_get_parent (dev_tmp) == dev) {
-			FwupdRelease *rel = fwupd_device_get_release_default (dev_tmp);
-			GNode *child = g_node_append_data (root, dev_tmp);
-			if (rel != NULL)
-				g_node_append_data (child, rel);
-			fu_util_build_device_tree (priv, child, devs, dev_tmp);
-		}
-	}
+	FuUtilPrivate *priv = (FuUtilPrivate *) user_data;
+	FwupdRelease *rel;
+	GNode *child;
+
+	if (!fu_util_filter_device (priv, dev))
+		return NULL;
+	if (!priv->show_all_devices &&
+	    !fu_util_is_interesting_device (dev))
+		return NULL;
+	child = g_node_append_data (parent, dev);
+	rel = fwupd_device_get_release_default (dev);
+	if (rel != NULL)
+		g_node_append_data (child, rel);
+	return child;
 }
 
 static gchar *
@@ -549,7 +549,7 @@ fu_util_get_devices (FuUtilPrivate *priv, gchar **values, GError **error)
 		g_print ("%s\n", _("No hardware detected with firmware update capability"));
 		return TRUE;
 	}
-	fu_util_build_device_tree (priv, root, devs, NULL);
+	fu_util_build_device_tree (root, devs, NULL, fu_util_add_device_tree_cb, priv);
 	fu_util_print_tree (root, title);
 
 	/* nag? */
@@ -659,7 +659,7 @@ fu_util_get_details (FuUtilPrivate *priv, gchar **values, GError **error)
 	array = fwupd_client_get_details (priv->client, values[0], NULL, error);
 	if (array == NULL)
 		return FALSE;
-	fu_util_build_device_tree (priv, root, array, NULL);
+	fu_util_build_device_tree (root, array, NULL, fu_util_add_device_tree_cb, priv);
 	fu_util_print_tree (root, title);
 
 	return TRUE;
@@ -672,58 +672,26 @@ fu_util_clear_history (FuUtilPrivate *priv, gchar **values, GError **error)
 	return fu_history_remove_all (history, error);
 }
 
+#define FU_UTIL_REPORT_RETRIES		3
+
+/* @retryable is set if the server or network was unavailable, rather
+ * than the server rejecting the report */
 static gboolean
-fu_util_report_history_for_remote (FuUtilPrivate *priv,
-				const gchar *remote_id,
-				GPtrArray *devices,
-				GError **error)
+fu_util_report_post (FuUtilPrivate *priv,
+		     const gchar *report_uri,
+		     const gchar *data,
+		     const gchar *sig,
+		     gboolean *retryable,
+		     GError **error)
 {
 	JsonNode *json_root;
 	JsonObject *json_object;
 	const gchar *server_msg = NULL;
-	guint status_code;
-	const gchar *report_uri;
-	g_autofree gchar *data = NULL;
-	g_autofree gchar *sig = NULL;
+	guint status_code = SOUP_STATUS_NONE;
 	g_autoptr(JsonParser) json_parser = NULL;
 	g_autoptr(SoupMessage) msg = NULL;
-	g_autoptr(FwupdRemote) remote = NULL;
 
-	/* convert to JSON */
-	data = fwupd_build_history_report_json (devices, error);
-	if (data == NULL)
-		return FALSE;
-
-	/* self sign data */
-	if (priv->sign) {
-		sig = fwupd_client_self_sign (priv->client, data,
-					      FWUPD_SELF_SIGN_FLAG_ADD_TIMESTAMP,
-					      priv->cancellable, error);
-		if (sig == NULL)
-			return FALSE;
-	}
-
-	remote = fwupd_client_get_remote_by_id (priv->client, remote_id,
-						NULL, error);
-	if (remote == NULL)
-		return FALSE;
-	report_uri = fwupd_remote_get_report_uri (remote);
-
-	/* ask for permission */
-	if (!priv->assume_yes && !fwupd_remote_get_automatic_reports (remote)) {
-		fu_util_print_data (_("Target"), report_uri);
-		fu_util_print_data (_("Payload"), data);
-		if (sig != NULL)
-			fu_util_print_data (_("Signature"), sig);
-		g_print ("%s [Y|n]: ", _("Proceed with upload?"));
-		if (!fu_util_prompt_for_boolean (TRUE)) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_PERMISSION_DENIED,
-					     "User declined action");
-			return FALSE;
-		}
-	}
+	*retryable = FALSE;
 
 	/* POST request */
 	if (sig != NULL) {
@@ -737,8 +705,19 @@ fu_util_report_history_for_remote (FuUtilPrivate *priv,
 		soup_message_set_request (msg, "application/json; charset=utf-8",
 					  SOUP_MEMORY_COPY, data, strlen (data));
 	}
-	status_code = soup_session_send_message (priv->soup_session, msg);
-	g_debug ("server returned: %s", msg->response_body->data);
+	for (guint i = 0; i < FU_UTIL_REPORT_RETRIES; i++) {
+		if (i > 0) {
+			g_debug ("retrying upload in %us", i);
+			g_usleep (i * G_USEC_PER_SEC);
+		}
+		status_code = soup_session_send_message (priv->soup_session, msg);
+		g_debug ("server returned: %s", msg->response_body->data);
+		*retryable = SOUP_STATUS_IS_TRANSPORT_ERROR (status_code) ||
+			     SOUP_STATUS_IS_SERVER_ERROR (status_code) ||
+			     status_code == 429;
+		if (!*retryable)
+			break;
+	}
 
 	/* server returned nothing, and probably exploded in a ball of flames */
 	if (msg->response_body->length == 0) {
@@ -820,12 +799,156 @@ fu_util_report_history_for_remote (FuUtilPrivate *priv,
 		return FALSE;
 	}
 
+	*retryable = FALSE;
+	return TRUE;
+}
+
+/* reports that could not be uploaded are saved until the next time */
+static gchar *
+fu_util_report_get_spool_dir (void)
+{
+	return fu_util_get_user_cache_path ("reports");
+}
+
+static gboolean
+fu_util_report_spool (const gchar *report_uri,
+		      const gchar *data,
+		      const gchar *sig,
+		      GError **error)
+{
+	g_autofree gchar *basename = NULL;
+	g_autofree gchar *fn = NULL;
+	g_autofree gchar *spooldir = fu_util_report_get_spool_dir ();
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+
+	basename = g_strdup_printf ("%" G_GINT64_FORMAT ".report", g_get_real_time ());
+	fn = g_build_filename (spooldir, basename, NULL);
+	if (!fu_common_mkdir_parent (fn, error))
+		return FALSE;
+	g_key_file_set_string (kf, "Report", "Uri", report_uri);
+	g_key_file_set_string (kf, "Report", "Payload", data);
+	if (sig != NULL)
+		g_key_file_set_string (kf, "Report", "Signature", sig);
+	return g_key_file_save_to_file (kf, fn, error);
+}
+
+/* upload all the saved reports, keeping any that still cannot be sent */
+static guint
+fu_util_report_flush_spool (FuUtilPrivate *priv)
+{
+	const gchar *fn;
+	guint cnt = 0;
+	g_autofree gchar *spooldir = fu_util_report_get_spool_dir ();
+	g_autoptr(GDir) dir = NULL;
+
+	dir = g_dir_open (spooldir, 0, NULL);
+	if (dir == NULL)
+		return 0;
+	while ((fn = g_dir_read_name (dir)) != NULL) {
+		gboolean retryable = FALSE;
+		g_autofree gchar *data = NULL;
+		g_autofree gchar *filename = g_build_filename (spooldir, fn, NULL);
+		g_autofree gchar *report_uri = NULL;
+		g_autofree gchar *sig = NULL;
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GKeyFile) kf = g_key_file_new ();
+
+		if (!g_str_has_suffix (fn, ".report"))
+			continue;
+		if (!g_key_file_load_from_file (kf, filename, G_KEY_FILE_NONE, &error_local)) {
+			g_warning ("failed to load %s: %s", filename, error_local->message);
+			continue;
+		}
+		report_uri = g_key_file_get_string (kf, "Report", "Uri", NULL);
+		data = g_key_file_get_string (kf, "Report", "Payload", NULL);
+		sig = g_key_file_get_string (kf, "Report", "Signature", NULL);
+		if (report_uri == NULL || data == NULL) {
+			g_warning ("ignoring invalid report %s", filename);
+			continue;
+		}
+		if (!fu_util_report_post (priv, report_uri, data, sig,
+					  &retryable, &error_local)) {
+			if (retryable) {
+				g_debug ("keeping %s: %s", filename, error_local->message);
+				continue;
+			}
+			g_warning ("dropping report %s: %s", filename, error_local->message);
+		} else {
+			cnt++;
+		}
+		g_unlink (filename);
+	}
+	return cnt;
+}
+
+static gboolean
+fu_util_report_history_for_remote (FuUtilPrivate *priv,
+				const gchar *remote_id,
+				GPtrArray *devices,
+				GError **error)
+{
+	const gchar *report_uri;
+	gboolean retryable = FALSE;
+	g_autofree gchar *data = NULL;
+	g_autofree gchar *sig = NULL;
+	g_autoptr(FwupdRemote) remote = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	/* convert to JSON */
+	data = fwupd_build_history_report_json (devices, error);
+	if (data == NULL)
+		return FALSE;
+
+	/* self sign data */
+	if (priv->sign) {
+		sig = fwupd_client_self_sign (priv->client, data,
+					      FWUPD_SELF_SIGN_FLAG_ADD_TIMESTAMP,
+					      priv->cancellable, error);
+		if (sig == NULL)
+			return FALSE;
+	}
+
+	remote = fwupd_client_get_remote_by_id (priv->client, remote_id,
+						NULL, error);
+	if (remote == NULL)
+		return FALSE;
+	report_uri = fwupd_remote_get_report_uri (remote);
+
+	/* ask for permission */
+	if (!priv->assume_yes && !fwupd_remote_get_automatic_reports (remote)) {
+		fu_util_print_data (_("Target"), report_uri);
+		fu_util_print_data (_("Payload"), data);
+		if (sig != NULL)
+			fu_util_print_data (_("Signature"), sig);
+		g_print ("%s [Y|n]: ", _("Proceed with upload?"));
+		if (!fu_util_prompt_for_boolean (TRUE)) {
+			g_set_error_literal (error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_PERMISSION_DENIED,
+					     "User declined action");
+			return FALSE;
+		}
+	}
+
+	/* try to upload now, saving it for later if the server is unavailable */
+	if (!fu_util_report_post (priv, report_uri, data, sig, &retryable, &error_local)) {
+		if (!retryable) {
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			return FALSE;
+		}
+		g_debug ("failed to upload: %s", error_local->message);
+		if (!fu_util_report_spool (report_uri, data, sig, error))
+			return FALSE;
+		/* TRANSLATORS: the report will be uploaded the next time */
+		g_print ("%s\n", _("The server could not be reached, the report will be uploaded later"));
+	}
 	return TRUE;
 }
 
 static gboolean
 fu_util_report_history (FuUtilPrivate *priv, gchar **values, GError **error)
 {
+	guint spooled_cnt;
 	g_autoptr(GHashTable) remote_id_uri_map = NULL;
 	g_autoptr(GHashTable) report_map = NULL;
 	g_autoptr(GList) ids = NULL;
@@ -840,6 +963,15 @@ fu_util_report_history (FuUtilPrivate *priv, gchar **values, GError **error)
 			return FALSE;
 	}
 
+	/* send anything that failed to upload last time */
+	spooled_cnt = fu_util_report_flush_spool (priv);
+	if (spooled_cnt > 0) {
+		/* TRANSLATORS: reports saved when the server was unavailable */
+		g_print (ngettext ("Uploaded %u saved report\n",
+				   "Uploaded %u saved reports\n",
+				   spooled_cnt), spooled_cnt);
+	}
+
 	/* create a map of RemoteID to RemoteURI */
 	remotes = fwupd_client_get_remotes (priv->client, NULL, error);
 	if (remotes == NULL)
@@ -915,6 +1047,8 @@ fu_util_report_history (FuUtilPrivate *priv, gchar **values, GError **error)
 
 	/* nothing to report */
 	if (g_hash_table_size (report_map) == 0) {
+		if (spooled_cnt > 0)
+			return TRUE;
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_NOT_SUPPORTED,
@@ -1164,12 +1298,57 @@ fu_util_download_chunk_cb (SoupMessage *msg, SoupBuffer *chunk, gpointer user_da
 	fu_progressbar_update (priv->progressbar, FWUPD_STATUS_DOWNLOADING, percentage);
 }
 
+/* the ETag and Last-Modified of a download are saved in $FN.http */
+static void
+fu_util_download_add_conditional_headers (SoupMessage *msg, const gchar *fn)
+{
+	g_autofree gchar *fn_http = g_strdup_printf ("%s.http", fn);
+	g_autofree gchar *etag = NULL;
+	g_autofree gchar *last_modified = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+
+	if (!g_file_test (fn, G_FILE_TEST_EXISTS))
+		return;
+	if (!g_key_file_load_from_file (kf, fn_http, G_KEY_FILE_NONE, NULL))
+		return;
+	etag = g_key_file_get_string (kf, "Cache", "ETag", NULL);
+	if (etag != NULL)
+		soup_message_headers_append (msg->request_headers, "If-None-Match", etag);
+	last_modified = g_key_file_get_string (kf, "Cache", "LastModified", NULL);
+	if (last_modified != NULL)
+		soup_message_headers_append (msg->request_headers, "If-Modified-Since", last_modified);
+}
+
+static void
+fu_util_download_save_conditional_headers (SoupMessage *msg, const gchar *fn)
+{
+	const gchar *etag = soup_message_headers_get_one (msg->response_headers, "ETag");
+	const gchar *last_modified = soup_message_headers_get_one (msg->response_headers, "Last-Modified");
+	g_autofree gchar *fn_http = g_strdup_printf ("%s.http", fn);
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+
+	if (etag == NULL && last_modified == NULL) {
+		g_unlink (fn_http);
+		return;
+	}
+	if (etag != NULL)
+		g_key_file_set_string (kf, "Cache", "ETag", etag);
+	if (last_modified != NULL)
+		g_key_file_set_string (kf, "Cache", "LastModified", last_modified);
+	if (!g_key_file_save_to_file (kf, fn_http, &error_local))
+		g_debug ("failed to save HTTP cache headers: %s", error_local->message);
+}
+
+/* if @not_modified is set then a conditional request is made, and a
+ * 304 response leaves the existing file in place */
 static gboolean
-fu_util_download_file (FuUtilPrivate *priv,
-		       SoupURI *uri,
-		       const gchar *fn,
-		       const gchar *checksum_expected,
-		       GError **error)
+fu_util_download_file_full (FuUtilPrivate *priv,
+			    SoupURI *uri,
+			    const gchar *fn,
+			    const gchar *checksum_expected,
+			    gboolean *not_modified,
+			    GError **error)
 {
 	GChecksumType checksum_type;
 	guint status_code;
@@ -1203,6 +1382,10 @@ fu_util_download_file (FuUtilPrivate *priv,
 			     "Failed to parse URI %s", uri_str);
 		return FALSE;
 	}
+	if (not_modified != NULL) {
+		*not_modified = FALSE;
+		fu_util_download_add_conditional_headers (msg, fn);
+	}
 	if (g_str_has_suffix (uri_str, ".jcat") ||
 	    g_str_has_suffix (uri_str, ".asc") ||
 	    g_str_has_suffix (uri_str, ".p7b") ||
@@ -1223,6 +1406,11 @@ fu_util_download_file (FuUtilPrivate *priv,
 			  G_CALLBACK (fu_util_download_chunk_cb), priv);
 	status_code = soup_session_send_message (priv->soup_session, msg);
 	g_print ("\n");
+	if (not_modified != NULL && status_code == SOUP_STATUS_NOT_MODIFIED) {
+		g_debug ("%s not modified", uri_str);
+		*not_modified = TRUE;
+		return TRUE;
+	}
 	if (status_code == 429) {
 		g_autofree gchar *str = g_strndup (msg->response_body->data,
 						   msg->response_body->length);
@@ -1276,16 +1464,134 @@ fu_util_download_file (FuUtilPrivate *priv,
 			     error_local->message);
 		return FALSE;
 	}
+	if (not_modified != NULL)
+		fu_util_download_save_conditional_headers (msg, fn);
 	return TRUE;
 }
 
+static gboolean
+fu_util_download_file (FuUtilPrivate *priv,
+		       SoupURI *uri,
+		       const gchar *fn,
+		       const gchar *checksum_expected,
+		       GError **error)
+{
+	return fu_util_download_file_full (priv, uri, fn, checksum_expected, NULL, error);
+}
+
+/* the firmware cache is content-addressed, so any host can serve its cache
+ * directory to the others, e.g. FWUPD_DOWNLOAD_PEERS=http://a:8000;http://b:8000 */
+static gboolean
+fu_util_download_file_from_peers (FuUtilPrivate *priv,
+				  const gchar *checksum,
+				  const gchar *fn)
+{
+	const gchar *peers_str = g_getenv ("FWUPD_DOWNLOAD_PEERS");
+	GChecksumType checksum_type = fwupd_checksum_guess_kind (checksum);
+	g_auto(GStrv) peers = NULL;
+
+	if (fu_util_file_exists_with_checksum (fn, checksum, checksum_type))
+		return TRUE;
+	if (peers_str == NULL)
+		return FALSE;
+	peers = g_strsplit (peers_str, ";", -1);
+	for (guint i = 0; peers[i] != NULL; i++) {
+		g_autofree gchar *basename = g_path_get_basename (fn);
+		g_autofree gchar *uri_str = NULL;
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(SoupURI) uri = NULL;
+		if (peers[i][0] == '\0')
+			continue;
+		uri_str = g_build_filename (peers[i], basename, NULL);
+		uri = soup_uri_new (uri_str);
+		if (uri == NULL) {
+			g_debug ("ignoring invalid peer %s", peers[i]);
+			continue;
+		}
+		if (fu_util_download_file (priv, uri, fn, checksum, &error_local))
+			return TRUE;
+		g_debug ("failed to download from peer %s: %s",
+			 peers[i], error_local->message);
+	}
+	return FALSE;
+}
+
+static gchar *
+fu_util_get_remote_cache_sig_path (FwupdRemote *remote)
+{
+	g_autofree gchar *basename_asc = NULL;
+	g_autofree gchar *basename_id_asc = NULL;
+	basename_asc = g_path_get_basename (fwupd_remote_get_filename_cache_sig (remote));
+	basename_id_asc = g_strdup_printf ("%s-%s", fwupd_remote_get_id (remote), basename_asc);
+	return fu_util_get_user_cache_path (basename_id_asc);
+}
+
+/* patch the cached metadata up to the version in the signature */
+static gboolean
+fu_util_download_metadata_delta (FuUtilPrivate *priv,
+				 FwupdRemote *remote,
+				 const gchar *filename,
+				 GError **error)
+{
+	const gchar *checksum_new = fwupd_remote_get_metadata_checksum (remote);
+	const gchar *delta_uri;
+	g_autofree gchar *checksum_old = NULL;
+	g_autofree gchar *checksum_patched = NULL;
+	g_autofree gchar *filename_delta = NULL;
+	g_autoptr(GBytes) blob_delta = NULL;
+	g_autoptr(GBytes) blob_old = NULL;
+	g_autoptr(GBytes) blob_patched = NULL;
+	g_autoptr(SoupURI) uri = NULL;
+
+	/* nothing to patch */
+	blob_old = fu_common_get_contents_bytes (filename, error);
+	if (blob_old == NULL)
+		return FALSE;
+	checksum_old = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob_old);
+	if (g_strcmp0 (checksum_old, checksum_new) == 0)
+		return TRUE;
+	delta_uri = fwupd_remote_get_metadata_delta_uri (remote, checksum_old);
+	if (delta_uri == NULL) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_FOUND,
+			     "no delta from %s", checksum_old);
+		return FALSE;
+	}
+
+	/* download and apply */
+	filename_delta = g_strdup_printf ("%s.delta", filename);
+	uri = soup_uri_new (delta_uri);
+	if (!fu_util_download_file (priv, uri, filename_delta, NULL, error))
+		return FALSE;
+	blob_delta = fu_common_get_contents_bytes (filename_delta, error);
+	g_unlink (filename_delta);
+	if (blob_delta == NULL)
+		return FALSE;
+	blob_patched = fu_util_delta_apply (blob_old, blob_delta, error);
+	if (blob_patched == NULL)
+		return FALSE;
+
+	/* the result has to match the signed metadata exactly */
+	checksum_patched = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob_patched);
+	if (g_strcmp0 (checksum_patched, checksum_new) != 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "patched checksum invalid, expected %s got %s",
+			     checksum_new, checksum_patched);
+		return FALSE;
+	}
+	return fu_common_set_contents_bytes (filename, blob_patched, error);
+}
+
 static gboolean
 fu_util_download_metadata_for_remote (FuUtilPrivate *priv,
 				      FwupdRemote *remote,
 				      GError **error)
 {
-	g_autofree gchar *basename_asc = NULL;
-	g_autofree gchar *basename_id_asc = NULL;
+	const gchar *checksum;
+	gboolean not_modified = FALSE;
 	g_autofree gchar *basename_id = NULL;
 	g_autofree gchar *basename = NULL;
 	g_autofree gchar *filename = NULL;
@@ -1293,26 +1599,42 @@ fu_util_download_metadata_for_remote (FuUtilPrivate *priv,
 	g_autoptr(SoupURI) uri = NULL;
 	g_autoptr(SoupURI) uri_sig = NULL;
 
-	/* download the signature */
-	basename_asc = g_path_get_basename (fwupd_remote_get_filename_cache_sig (remote));
-	basename_id_asc = g_strdup_printf ("%s-%s", fwupd_remote_get_id (remote), basename_asc);
-	filename_asc = fu_util_get_user_cache_path (basename_id_asc);
+	/* download the signature, only if it changed since the last refresh */
+	basename = g_path_get_basename (fwupd_remote_get_filename_cache (remote));
+	basename_id = g_strdup_printf ("%s-%s", fwupd_remote_get_id (remote), basename);
+	filename = fu_util_get_user_cache_path (basename_id);
+	filename_asc = fu_util_get_remote_cache_sig_path (remote);
 	if (!fu_common_mkdir_parent (filename_asc, error))
 		return FALSE;
 	uri_sig = soup_uri_new (fwupd_remote_get_metadata_uri_sig (remote));
-	if (!fu_util_download_file (priv, uri_sig, filename_asc, NULL, error))
+	if (!fu_util_download_file_full (priv, uri_sig, filename_asc, NULL,
+					 (priv->flags & FWUPD_INSTALL_FLAG_FORCE) == 0 &&
+					 g_file_test (filename, G_FILE_TEST_EXISTS) ?
+					 &not_modified : NULL,
+					 error))
 		return FALSE;
 
+	/* the daemon already has this metadata, so just record the check */
+	if (not_modified) {
+		g_debug ("metadata for %s unchanged", fwupd_remote_get_id (remote));
+		if (g_utime (filename_asc, NULL) != 0)
+			g_debug ("failed to update %s timestamp", filename_asc);
+		return TRUE;
+	}
+
 	/* find the download URI of the metadata from the JCat file */
 	if (!fwupd_remote_load_signature (remote, filename_asc, error))
 		return FALSE;
 
 	/* download the metadata */
-	basename = g_path_get_basename (fwupd_remote_get_filename_cache (remote));
-	basename_id = g_strdup_printf ("%s-%s", fwupd_remote_get_id (remote), basename);
-	filename = fu_util_get_user_cache_path (basename_id);
+	checksum = fwupd_remote_get_metadata_checksum (remote);
+	if (checksum != NULL && g_file_test (filename, G_FILE_TEST_EXISTS)) {
+		g_autoptr(GError) error_delta = NULL;
+		if (!fu_util_download_metadata_delta (priv, remote, filename, &error_delta))
+			g_debug ("using full download: %s", error_delta->message);
+	}
 	uri = soup_uri_new (fwupd_remote_get_metadata_uri (remote));
-	if (!fu_util_download_file (priv, uri, filename, NULL, error))
+	if (!fu_util_download_file (priv, uri, filename, checksum, error))
 		return FALSE;
 
 	/* send all this to fwupd */
@@ -1359,12 +1681,29 @@ fu_util_check_oldest_remote (FuUtilPrivate *priv, guint64 *age_oldest, GError **
 		return FALSE;
 	for (guint i = 0; i < remotes->len; i++) {
 		FwupdRemote *remote = g_ptr_array_index (remotes, i);
+		guint64 age;
+		g_autofree gchar *filename_asc = NULL;
+		g_autoptr(GFile) file_asc = NULL;
+		g_autoptr(GFileInfo) info = NULL;
 		if (!fwupd_remote_get_enabled (remote))
 			continue;
 		if (fwupd_remote_get_kind (remote) != FWUPD_REMOTE_KIND_DOWNLOAD)
 			continue;
-		if (fwupd_remote_get_age (remote) > *age_oldest)
-			*age_oldest = fwupd_remote_get_age (remote);
+		age = fwupd_remote_get_age (remote);
+
+		/* a 304 response only updates the local signature timestamp */
+		filename_asc = fu_util_get_remote_cache_sig_path (remote);
+		file_asc = g_file_new_for_path (filename_asc);
+		info = g_file_query_info (file_asc, G_FILE_ATTRIBUTE_TIME_MODIFIED,
+					  G_FILE_QUERY_INFO_NONE, NULL, NULL);
+		if (info != NULL) {
+			guint64 now = (guint64) g_get_real_time () / G_USEC_PER_SEC;
+			guint64 mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+			if (mtime <= now)
+				age = MIN (age, now - mtime);
+		}
+		if (age > *age_oldest)
+			*age_oldest = age;
 	}
 	return TRUE;
 }
@@ -1584,11 +1923,54 @@ fu_util_prompt_for_release (FuUtilPrivate *priv, GPtrArray *rels, GError **error
 	return g_object_ref (rel);
 }
 
+static gboolean
+fu_util_verify_all (FuUtilPrivate *priv, GError **error)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	guint failures = 0;
+	g_autoptr(GHashTable) results = NULL;
+
+	results = fwupd_client_verify_all (priv->client, NULL, error);
+	if (results == NULL)
+		return FALSE;
+	g_hash_table_iter_init (&iter, results);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		const gchar *device_id = (const gchar *) key;
+		const gchar *message = (const gchar *) value;
+		const gchar *name = device_id;
+		g_autoptr(FwupdDevice) dev = NULL;
+
+		dev = fwupd_client_get_device_by_id (priv->client, device_id, NULL, NULL);
+		if (dev != NULL)
+			name = fwupd_device_get_name (dev);
+		if (message[0] != '\0') {
+			g_print ("%s: %s\n", name, message);
+			failures++;
+			continue;
+		}
+		/* TRANSLATORS: success message when user verified device checksums */
+		g_print ("%s: %s\n", name, _("Successfully verified device checksums"));
+	}
+	if (failures > 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "failed to verify %u of %u devices",
+			     failures, g_hash_table_size (results));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_util_verify (FuUtilPrivate *priv, gchar **values, GError **error)
 {
 	g_autoptr(FwupdDevice) dev = NULL;
 
+	if (priv->verify_all)
+		return fu_util_verify_all (priv, error);
+
 	priv->filter_include |= FWUPD_DEVICE_FLAG_CAN_VERIFY;
 	dev = fu_util_get_device_or_prompt (priv, values, error);
 	if (dev == NULL)
@@ -1671,6 +2053,7 @@ fu_util_get_updates (FuUtilPrivate *priv, gchar **values, GError **error)
 {
 	g_autoptr(GPtrArray) devices = NULL;
 	gboolean supported = FALSE;
+	g_autoptr(GHashTable) upgrades = NULL;
 	g_autoptr(GNode) root = g_node_new (NULL);
 	g_autofree gchar *title = fu_util_get_tree_title (priv);
 
@@ -1682,13 +2065,17 @@ fu_util_get_updates (FuUtilPrivate *priv, gchar **values, GError **error)
 	devices = fwupd_client_get_devices (priv->client, NULL, error);
 	if (devices == NULL)
 		return FALSE;
+
+	/* get the upgrades for all devices in one round-trip */
+	upgrades = fwupd_client_get_all_upgrades (priv->client, NULL, error);
+	if (upgrades == NULL)
+		return FALSE;
 	for (guint i = 0; i < devices->len; i++) {
 		FwupdDevice *dev = g_ptr_array_index (devices, i);
-		g_autoptr(GPtrArray) rels = NULL;
-		g_autoptr(GError) error_local = NULL;
+		GPtrArray *rels;
 		GNode *child;
 
-		/* not going to have results, so save a D-Bus round-trip */
+		/* not going to have results */
 		if (!fwupd_device_has_flag (dev, FWUPD_DEVICE_FLAG_UPDATABLE))
 			continue;
 		if (!fwupd_device_has_flag (dev, FWUPD_DEVICE_FLAG_SUPPORTED)) {
@@ -1703,18 +2090,14 @@ fu_util_get_updates (FuUtilPrivate *priv, gchar **values, GError **error)
 			continue;
 		supported = TRUE;
 
-		/* get the releases for this device and filter for validity */
-		rels = fwupd_client_get_upgrades (priv->client,
-						  fwupd_device_get_id (dev),
-						  NULL, &error_local);
+		/* the daemon already filtered these for validity */
+		rels = g_hash_table_lookup (upgrades, fwupd_device_get_id (dev));
 		if (rels == NULL) {
 			/* TRANSLATORS: message letting the user know no device upgrade available
 			* %1 is the device name */
 			g_autofree gchar *tmp = g_strdup_printf (_("• %s has the latest available firmware version"),
 								 fwupd_device_get_name (dev));
 			g_printerr ("%s\n", tmp);
-			/* discard the actual reason from user, but leave for debugging */
-			g_debug ("%s", error_local->message);
 			continue;
 		}
 		child = g_node_append_data (root, dev);
@@ -1772,26 +2155,22 @@ fu_util_get_remotes (FuUtilPrivate *priv, gchar **values, GError **error)
 	return TRUE;
 }
 
-static gboolean
-fu_util_update_device_with_release (FuUtilPrivate *priv,
-				    FwupdDevice *dev,
-				    FwupdRelease *rel,
-				    GError **error)
+/* returns the local filename of the release archive, downloading it into
+ * the content-addressed cache if required */
+static gchar *
+fu_util_download_release (FuUtilPrivate *priv,
+			  FwupdDevice *dev,
+			  FwupdRelease *rel,
+			  GError **error)
 {
 	GPtrArray *checksums;
+	const gchar *checksum;
 	const gchar *remote_id;
 	const gchar *uri_tmp;
 	g_autofree gchar *fn = NULL;
 	g_autofree gchar *uri_str = NULL;
 	g_autoptr(SoupURI) uri = NULL;
 
-	if (!priv->no_safety_check && !priv->assume_yes) {
-		if (!fu_util_prompt_warning (dev,
-					     fu_util_get_tree_title (priv),
-					     error))
-			return FALSE;
-	}
-
 	/* work out what remote-specific URI fields this should use */
 	uri_tmp = fwupd_release_get_uri (rel);
 	remote_id = fwupd_release_get_remote_id (rel);
@@ -1802,27 +2181,20 @@ fu_util_update_device_with_release (FuUtilPrivate *priv,
 							NULL,
 							error);
 		if (remote == NULL)
-			return FALSE;
+			return NULL;
 
 		/* local and directory remotes have the firmware already */
 		if (fwupd_remote_get_kind (remote) == FWUPD_REMOTE_KIND_LOCAL) {
 			const gchar *fn_cache = fwupd_remote_get_filename_cache (remote);
 			g_autofree gchar *path = g_path_get_dirname (fn_cache);
-
-			fn = g_build_filename (path, uri_tmp, NULL);
-		} else if (fwupd_remote_get_kind (remote) == FWUPD_REMOTE_KIND_DIRECTORY) {
-			fn = g_strdup (uri_tmp + 7);
-		}
-		/* install with flags chosen by the user */
-		if (fn != NULL) {
-			return fwupd_client_install (priv->client,
-						     fwupd_device_get_id (dev),
-						     fn, priv->flags, NULL, error);
+			return g_build_filename (path, uri_tmp, NULL);
 		}
+		if (fwupd_remote_get_kind (remote) == FWUPD_REMOTE_KIND_DIRECTORY)
+			return g_strdup (uri_tmp + 7);
 
 		uri_str = fwupd_remote_build_firmware_uri (remote, uri_tmp, error);
 		if (uri_str == NULL)
-			return FALSE;
+			return NULL;
 	} else {
 		uri_str = g_strdup (uri_tmp);
 	}
@@ -1831,15 +2203,44 @@ fu_util_update_device_with_release (FuUtilPrivate *priv,
 	g_print ("Downloading %s for %s...\n",
 		 fwupd_release_get_version (rel),
 		 fwupd_device_get_name (dev));
-	fn = fu_util_get_user_cache_path (uri_str);
-	if (!fu_common_mkdir_parent (fn, error))
-		return FALSE;
 	checksums = fwupd_release_get_checksums (rel);
-	uri = soup_uri_new (uri_str);
-	if (!fu_util_download_file (priv, uri, fn,
-				    fwupd_checksum_get_best (checksums),
-				    error))
+	checksum = fwupd_checksum_get_best (checksums);
+	if (checksum != NULL) {
+		g_autofree gchar *basename = g_strdup_printf ("%s.cab", checksum);
+		fn = fu_util_get_user_cache_path (basename);
+	} else {
+		fn = fu_util_get_user_cache_path (uri_str);
+	}
+	if (!fu_common_mkdir_parent (fn, error))
+		return NULL;
+	if (checksum == NULL || !fu_util_download_file_from_peers (priv, checksum, fn)) {
+		uri = soup_uri_new (uri_str);
+		if (!fu_util_download_file (priv, uri, fn, checksum, error))
+			return NULL;
+	}
+	return g_steal_pointer (&fn);
+}
+
+static gboolean
+fu_util_update_device_with_release (FuUtilPrivate *priv,
+				    FwupdDevice *dev,
+				    FwupdRelease *rel,
+				    GError **error)
+{
+	g_autofree gchar *fn = NULL;
+
+	if (!priv->no_safety_check && !priv->assume_yes) {
+		if (!fu_util_prompt_warning (dev,
+					     fu_util_get_tree_title (priv),
+					     error))
+			return FALSE;
+	}
+
+	/* install with flags chosen by the user */
+	fn = fu_util_download_release (priv, dev, rel, error);
+	if (fn == NULL)
 		return FALSE;
+
 	/* if the device specifies ONLY_OFFLINE automatically set this flag */
 	if (fwupd_device_has_flag (dev, FWUPD_DEVICE_FLAG_ONLY_OFFLINE))
 		priv->flags |= FWUPD_INSTALL_FLAG_OFFLINE;
@@ -2036,6 +2437,85 @@ fu_util_update (FuUtilPrivate *priv, gchar **values, GError **error)
 	return FALSE;
 }
 
+/* download and verify every pending upgrade so that a later update only
+ * has to flash, as the archives are then found in the cache */
+static gboolean
+fu_util_stage (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	guint staged_cnt = 0;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	if (g_strv_length (values) > 1) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_ARGS,
+				     "Invalid arguments");
+		return FALSE;
+	}
+	if (g_strv_length (values) == 1) {
+		FwupdDevice *dev = fu_util_get_device_by_id (priv, values[0], error);
+		if (dev == NULL)
+			return FALSE;
+		devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+		g_ptr_array_add (devices, dev);
+	} else {
+		devices = fwupd_client_get_devices (priv->client, NULL, error);
+		if (devices == NULL)
+			return FALSE;
+	}
+	for (guint i = 0; i < devices->len; i++) {
+		FwupdDevice *dev = g_ptr_array_index (devices, i);
+		FwupdRelease *rel;
+		g_autofree gchar *fn = NULL;
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GPtrArray) details = NULL;
+		g_autoptr(GPtrArray) rels = NULL;
+
+		if (!fwupd_device_has_flag (dev, FWUPD_DEVICE_FLAG_UPDATABLE))
+			continue;
+		if (!fwupd_device_has_flag (dev, FWUPD_DEVICE_FLAG_SUPPORTED))
+			continue;
+		if (!fu_util_filter_device (priv, dev))
+			continue;
+		rels = fwupd_client_get_upgrades (priv->client,
+						  fwupd_device_get_id (dev),
+						  NULL, &error_local);
+		if (rels == NULL) {
+			g_debug ("nothing to stage for %s: %s",
+				 fwupd_device_get_name (dev),
+				 error_local->message);
+			continue;
+		}
+		rel = g_ptr_array_index (rels, 0);
+		fn = fu_util_download_release (priv, dev, rel, error);
+		if (fn == NULL)
+			return FALSE;
+
+		/* the daemon parses the archive and checks the signatures now,
+		 * and keeps the result for when it is installed */
+		details = fwupd_client_get_details (priv->client, fn, NULL, error);
+		if (details == NULL) {
+			g_prefix_error (error, "failed to verify %s: ", fn);
+			return FALSE;
+		}
+		/* TRANSLATORS: the firmware was downloaded and verified ahead
+		 * of time, %1 is a version string and %2 is the device name */
+		g_print (_("Staged %s for %s"), fwupd_release_get_version (rel),
+			 fwupd_device_get_name (dev));
+		g_print ("\n");
+		staged_cnt++;
+	}
+	if (staged_cnt == 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOTHING_TO_DO,
+				     /* TRANSLATORS: there are no upgrades to download */
+				     _("No updates to stage"));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_util_remote_modify (FuUtilPrivate *priv, gchar **values, GError **error)
 {
@@ -2333,6 +2813,57 @@ fu_util_get_approved_firmware (FuUtilPrivate *priv, gchar **values, GError **err
 	return TRUE;
 }
 
+static gboolean
+fu_util_get_statistics (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	g_autoptr(GHashTable) statistics = NULL;
+	g_autoptr(GList) methods = NULL;
+
+	/* check args */
+	if (g_strv_length (values) != 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_ARGS,
+				     "Invalid arguments: none expected");
+		return FALSE;
+	}
+
+	/* call into daemon */
+	statistics = fwupd_client_get_statistics (priv->client,
+						  priv->cancellable,
+						  error);
+	if (statistics == NULL)
+		return FALSE;
+
+	/* TRANSLATORS: the time taken by the daemon to reply, where polkit
+	 * is the time waiting for the user to authenticate */
+	g_print ("%-24s %8s %8s %12s %12s %12s\n",
+		 _("Method"), _("Count"), _("Queued"),
+		 _("Polkit/ms"), _("Engine/ms"), _("Max/ms"));
+	methods = g_hash_table_get_keys (statistics);
+	methods = g_list_sort (methods, (GCompareFunc) g_strcmp0);
+	for (GList *l = methods; l != NULL; l = l->next) {
+		const gchar *method_name = l->data;
+		GVariant *dict = g_hash_table_lookup (statistics, method_name);
+		guint32 count = 0;
+		guint32 in_flight = 0;
+		guint64 total = 0;
+		guint64 auth = 0;
+		guint64 max = 0;
+		g_variant_lookup (dict, "Count", "u", &count);
+		g_variant_lookup (dict, "InFlight", "u", &in_flight);
+		g_variant_lookup (dict, "DurationTotal", "t", &total);
+		g_variant_lookup (dict, "DurationAuth", "t", &auth);
+		g_variant_lookup (dict, "DurationMax", "t", &max);
+		g_print ("%-24s %8u %8u %12.1f %12.1f %12.1f\n",
+			 method_name, count, in_flight,
+			 (gdouble) auth / 1000.f,
+			 (gdouble) (total - MIN (auth, total)) / 1000.f,
+			 (gdouble) max / 1000.f);
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_util_modify_config (FuUtilPrivate *priv, gchar **values, GError **error)
 {
@@ -2530,6 +3061,9 @@ main (int argc, char *argv[])
 		{ "show-all-devices", '\0', 0, G_OPTION_ARG_NONE, &priv->show_all_devices,
 			/* TRANSLATORS: command line option */
 			_("Show devices that are not updatable"), NULL },
+		{ "all", '\0', 0, G_OPTION_ARG_NONE, &priv->verify_all,
+			/* TRANSLATORS: command line option */
+			_("Verify all devices that support it"), NULL },
 		{ "disable-ssl-strict", '\0', 0, G_OPTION_ARG_NONE, &priv->disable_ssl_strict,
 			/* TRANSLATORS: command line option */
 			_("Ignore SSL strict checks when downloading files"), NULL },
@@ -2602,6 +3136,12 @@ main (int argc, char *argv[])
 		     /* TRANSLATORS: command description */
 		     _("Updates all firmware to latest versions available"),
 		     fu_util_update);
+	fu_util_cmd_array_add (cmd_array,
+		     "stage",
+		     "[DEVICE-ID|GUID]",
+		     /* TRANSLATORS: command description */
+		     _("Downloads and verifies the latest firmware ahead of an update"),
+		     fu_util_stage);
 	fu_util_cmd_array_add (cmd_array,
 		     "verify",
 		     "[DEVICE-ID|GUID]",
@@ -2698,6 +3238,12 @@ main (int argc, char *argv[])
 		     /* TRANSLATORS: firmware approved by the admin */
 		     _("Sets the list of approved firmware."),
 		     fu_util_set_approved_firmware);
+	fu_util_cmd_array_add (cmd_array,
+		     "get-statistics",
+		     NULL,
+		     /* TRANSLATORS: command description */
+		     _("Gets how long the daemon takes to reply to each request"),
+		     fu_util_get_statistics);
 	fu_util_cmd_array_add (cmd_array,
 		     "modify-config",
 		     "KEY,VALUE",